@@ -0,0 +1,1236 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * asm_check: bit-exactness and speed check of the conv kernels against plain C
+ *
+ * For each kernel in 'kernel_checks' below, random cases (shapes, strides, paddings,
+ * row pitches, output offsets) are generated; the plain C reference in this file and the
+ * kernel are run on the same inputs, and the whole output buffers -- including the
+ * slack around the expected output, which is pre-filled with a fill pattern -- are
+ * compared. Both sides are timed; a table of cases / mismatches / time / speedup is
+ * printed, and the first mismatch of each kernel is reported with its case number,
+ * which can be repeated with -c.
+ *
+ * The references are written from the asm descriptions, not from any implementation.
+ *
+ * Host (links the asm_ref host versions; gvconv2dbbb_d32_v60_h.c is the intrinsic form of
+ * gvconv2dbbb_d32_v60_host.c, so leave it out):
+ *   A=hexagon/asm_ref
+ *   gcc -O2 -mavx2 -DUSE_OS_LINUX -Ihexagon/hvx_emul -Ihexagon/include -Iinterface \
+ *       $A/asm_check.c $A/gvconv2dbbb_d32_v60_host.c $A/gvint_h.c $A/gvsuma_h.c $A/gsum_h.c \
+ *       $A/inconv2dbbb_d32_v60_h.c $A/dwconv2dbbb_c.c $A/gvconv2db2b2b2_d32_v60_host.c \
+ *       $A/inconv2db2b2b2_d32_v60_h.c $A/gvint16_h.c $A/gvsuma_16b_h.c $A/vrmaxmin_h.c \
+ *       $A/vmemset_short_h.c -o asm_check
+ * Simulator (links the asm):
+ *   S=hexagon/asm_src
+ *   hexagon-clang -O2 -mv66 -mhvx -mhvx-length=128B -Ihexagon/include -Iinterface \
+ *       hexagon/asm_ref/asm_check.c $S/gvconv2dbbb_d32_v60_h.S $S/gvint_h.S $S/gvsuma_h.S \
+ *       $S/gsum_h.S $S/inconv2dbbb_d32_v60_h.S $S/dwconv2dbbb_s1_3xN_h.S $S/dwconv2dbbb_s1_5xN_h.S \
+ *       $S/dwconv2dbbb_s1_7xN_h.S $S/dwconv2dbbb_s2_3xN_h.S $S/dwconv2dbbb_s2_5xN_h.S \
+ *       $S/dwconv2dbbb_s2_7xN_h.S $S/gvconv2db2b2b2_d32_h_v60.S $S/inconv2db2b2b2_d32_v60_h.S \
+ *       $S/gvint16_h.S $S/gvsuma_16b_h.S $S/vrmaxmin_h.S $S/vmemset_short_h.S \
+ *       hexagon/src/integral_control.c -o asm_check
+ *
+ * Usage: asm_check [-n cases] [-s seed] [-c case] [-k kernel-name-prefix]
+ *
+ * To add a kernel: write a case struct starting with 'struct kcase', a make/run/release
+ * trio and an entry in kernel_checks[].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "nn_asm_ops.h"
+#if defined(__hexagon__)
+#include <hexagon_sim_timer.h>
+#endif
+
+#define ALIGN_UP(X,A) (((X)+(A)-1) & ~(size_t)((A)-1))
+#define FILL_BYTE 0xA5
+#define SLACK 256
+
+// every case struct starts with this; out[0] is written by the reference, out[1] by the kernel
+struct kcase {
+	uint8_t *out[2];
+	size_t out_bytes;
+	char desc[96];
+};
+
+struct kernel_check {
+	const char *name;
+	struct kcase *(*make)(uint32_t *seed);
+	void (*run)(struct kcase *c, int use_kernel);
+	void (*release)(struct kcase *c);
+};
+
+static uint32_t rand_u32(uint32_t *seed)
+{
+	uint32_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return (*seed = x);
+}
+
+static int rand_range(uint32_t *seed, int lo, int hi)
+{
+	return lo + (int)(rand_u32(seed) % (uint32_t)(hi - lo + 1));
+}
+
+static void *alloc_vec(size_t bytes)
+{
+	void *p = NULL;
+	if (posix_memalign(&p, 128, ALIGN_UP(bytes + SLACK, 128)) != 0) return NULL;
+	return p;
+}
+
+static void *alloc_rand(size_t bytes, uint32_t *seed)
+{
+	uint8_t *p = alloc_vec(bytes);
+	if (p == NULL) return NULL;
+	for (size_t i = 0; i < bytes + SLACK; i++) p[i] = rand_u32(seed) >> 24;
+	return p;
+}
+
+static int alloc_outputs(struct kcase *c, size_t bytes)
+{
+	c->out_bytes = ALIGN_UP(bytes + SLACK, 128);
+	for (int i = 0; i < 2; i++) {
+		if ((c->out[i] = alloc_vec(c->out_bytes)) == NULL) return -1;
+		memset(c->out[i], FILL_BYTE, c->out_bytes);
+	}
+	return 0;
+}
+
+static void free_outputs(struct kcase *c)
+{
+	free(c->out[0]);
+	free(c->out[1]);
+}
+
+static uint64_t now_ticks()
+{
+#if defined(__hexagon__)
+	return hexagon_sim_read_pcycles();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// vmpye(s, r.uh) + vmpyo(s, r.h):<<1:rnd:sat:shift
+static int32_t mpy_s1_rnd_sat(int32_t s, int32_t r)
+{
+	int64_t p = (((int64_t)s * (uint16_t)r) >> 16) + (int64_t)s * (r >> 16);
+	p = (p * 2 + 0x8000) >> 16;
+	return (p > INT32_MAX) ? INT32_MAX : (p < INT32_MIN) ? INT32_MIN : (int32_t)p;
+}
+
+// minmax vectors (max in [0..31], min in [32..63]) at the start of both outputs
+static void minmax_init(struct kcase *hdr)
+{
+	for (int i = 0; i < 2; i++) {
+		int32_t *mm = (int32_t *)hdr->out[i];
+		for (int j = 0; j < 32; j++) {
+			mm[j] = -0x7fffffff;
+			mm[32 + j] = 0x7fffffff;
+		}
+	}
+}
+
+/*
+ * gvconv2dbbb_v60_asm
+ */
+struct conv_case {
+	struct kcase hdr;
+	uint8_t *input, *weights;
+	int32_t *bias, *suma, *recip;
+	int32_t in_width, out_next_row, out_width, stride_h, stride_w, in_depth;
+	int32_t filt_width, filt_height, num_lines, next_suma, zshift;
+};
+
+static struct kcase *conv_make(uint32_t *seed)
+{
+	struct conv_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->filt_width = rand_range(seed, 1, 5);
+	c->filt_height = rand_range(seed, 1, 5);
+	c->in_depth = 32 * rand_range(seed, 1, 4);
+	c->stride_w = rand_range(seed, 1, 2);
+	c->stride_h = rand_range(seed, 1, 2);
+	c->out_width = rand_range(seed, 1, 24);
+	c->num_lines = rand_range(seed, 1, 6);
+	c->zshift = rand_range(seed, -1, 4) & 3;
+	c->in_width = ALIGN_UP((c->out_width + 3) / 4 * 4 * c->stride_w + c->filt_width, 4) + 4 * rand_range(seed, 0, 2);
+	c->out_next_row = 128 * ((c->out_width + 3) / 4 + rand_range(seed, 0, 2));
+	c->next_suma = 4 * (c->in_width + 32 * rand_range(seed, 0, 1));
+
+	int32_t in_rows = (c->num_lines - 1) * c->stride_h + c->filt_height;
+	int32_t filt_bytes = c->filt_height * c->in_depth / 32 * c->filt_width * 4 * 256;
+	c->input = alloc_rand((size_t)in_rows * c->in_width * c->in_depth, seed);
+	c->weights = alloc_rand(filt_bytes, seed);
+	c->bias = alloc_rand(128, seed);
+	c->recip = alloc_rand(128, seed);
+	c->suma = alloc_rand((size_t)c->num_lines * c->next_suma, seed);
+	if (c->input == NULL || c->weights == NULL || c->bias == NULL || c->recip == NULL || c->suma == NULL
+	 || alloc_outputs(&c->hdr, 256 + (size_t)c->num_lines * c->out_next_row) != 0) {
+		return &c->hdr;		// run() is skipped by the caller when out[] is missing
+	}
+	// keep a useful fraction of the outputs away from saturation
+	int recip_shift = rand_range(seed, 4, 16);
+	for (int i = 0; i < 32; i++) {
+		c->bias[i] >>= rand_range(seed, 6, 12);
+		c->recip[i] = (int32_t)(rand_u32(seed) & 0x7FFFFFFF) >> recip_shift;
+		if (rand_range(seed, 0, 7) == 0) c->recip[i] = -c->recip[i];
+	}
+	for (int i = 0; i < c->num_lines * c->next_suma / 4; i++) c->suma[i] >>= 12;
+	minmax_init(&c->hdr);
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "%dx%d d%d s%dx%d w%d lines%d iw%d zshift%d",
+		c->filt_height, c->filt_width, c->in_depth, c->stride_h, c->stride_w,
+		c->out_width, c->num_lines, c->in_width, c->zshift);
+	return &c->hdr;
+}
+
+static void conv_ref(struct conv_case *c, int32_t *minmax, uint8_t *out)
+{
+	int32_t maxv[32], minv[32];
+	int32_t row_bytes = c->in_width * c->in_depth;
+	int32_t nd32 = c->in_depth / 32;
+	int32_t cols = (c->out_width + 3) & ~3;
+
+	for (int o = 0; o < 32; o++) {
+		maxv[o] = -0x7fffffff;
+		minv[o] = 0x7fffffff;
+	}
+	for (int r = 0; r < c->num_lines; r++) {
+		const int32_t *suma = (const int32_t *)((const uint8_t *)c->suma + r * c->next_suma);
+		for (int x = 0; x < cols; x++) {
+			for (int o = 0; o < 32; o++) {
+				uint32_t sum = (uint32_t)c->bias[o] + (uint32_t)suma[x * c->stride_w];
+				for (int fy = 0; fy < c->filt_height; fy++) {
+					for (int fx = 0; fx < c->filt_width; fx++) {
+						for (int d = 0; d < c->in_depth; d++) {
+							int32_t in_idx = (r * c->stride_h + fy) * row_bytes + (d / 32) * c->in_width * 32
+								+ (x * c->stride_w + fx) * 32 + d % 32;
+							int32_t frow = fy * nd32 + d / 32;
+							int32_t j = fx * 4 + (d % 32) / 8;
+							int32_t k = d % 8;
+							int32_t w_idx = (frow * c->filt_width * 4 + j) * 256 + 128 * (k / 4) + 4 * o + k % 4;
+							sum += (uint32_t)c->input[in_idx] * c->weights[w_idx];
+						}
+					}
+				}
+				int32_t v = (c->zshift > 0) ? (int32_t)(sum << c->zshift) : (int32_t)sum;
+				if (x < c->out_width) {
+					if (v > maxv[o]) maxv[o] = v;
+					if (v < minv[o]) minv[o] = v;
+				}
+				int32_t y = mpy_s1_rnd_sat(v, c->recip[o]);
+				y = (y > 32767) ? 32767 : (y < -32768) ? -32768 : y;
+				out[r * c->out_next_row + x * 32 + o] = (y > 255) ? 255 : (y < 0) ? 0 : y;
+			}
+		}
+	}
+	for (int o = 0; o < 32; o++) {
+		int32_t ymax = mpy_s1_rnd_sat(maxv[o], c->recip[o]);
+		int32_t ymin = mpy_s1_rnd_sat(minv[o], c->recip[o]);
+		if (ymax > minmax[o]) minmax[o] = ymax;
+		if (ymin < minmax[32 + o]) minmax[32 + o] = ymin;
+	}
+}
+
+static void conv_run(struct kcase *hdr, int use_kernel)
+{
+	struct conv_case *c = (struct conv_case *)hdr;
+	int32_t *minmax = (int32_t *)hdr->out[use_kernel];
+	uint8_t *out = hdr->out[use_kernel] + 256;
+	if (!use_kernel) {
+		conv_ref(c, minmax, out);
+		return;
+	}
+	gvconv2dbbb_v60_asm(c->input, c->weights, out, c->in_width, c->out_next_row, c->out_width,
+		(c->stride_h << 16) | c->stride_w, c->in_depth, c->filt_width, c->filt_height, c->num_lines,
+		c->bias, c->suma, c->next_suma, minmax, (uint32_t const *)c->recip, c->zshift);
+}
+
+static void conv_release(struct kcase *hdr)
+{
+	struct conv_case *c = (struct conv_case *)hdr;
+	free(c->input);
+	free(c->weights);
+	free(c->bias);
+	free(c->recip);
+	free(c->suma);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * gvint_asm
+ */
+struct gvint_case {
+	struct kcase hdr;
+	uint8_t *input;
+	int32_t *scratch;
+	int32_t in_width, in_depth, integral_width, out_height, filt_offset;
+};
+
+static struct kcase *gvint_make(uint32_t *seed)
+{
+	struct gvint_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->in_depth = 32 * rand_range(seed, 1, 4);
+	c->integral_width = 32 * rand_range(seed, 1, 6);
+	c->in_width = c->integral_width - 8 + 4 * rand_range(seed, 0, 4);
+	c->out_height = rand_range(seed, 1, 12);
+	c->filt_offset = rand_range(seed, 0, 255);
+	c->input = alloc_rand((size_t)c->out_height * c->in_width * c->in_depth, seed);
+	c->scratch = alloc_vec(16 * c->integral_width);
+	if (c->input == NULL || c->scratch == NULL
+	 || alloc_outputs(&c->hdr, (size_t)4 * c->integral_width * c->out_height) != 0) {
+		return &c->hdr;
+	}
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "iw%d d%d intw%d h%d zoff%d",
+		c->in_width, c->in_depth, c->integral_width, c->out_height, c->filt_offset);
+	return &c->hdr;
+}
+
+static void gvint_run(struct kcase *hdr, int use_kernel)
+{
+	struct gvint_case *c = (struct gvint_case *)hdr;
+	int32_t *out = (int32_t *)hdr->out[use_kernel];
+	if (use_kernel) {
+		gvint_asm(c->input, out, 32 * c->in_width, c->in_width * c->in_depth, c->integral_width,
+			c->in_depth, c->out_height, c->scratch, c->filt_offset);
+		return;
+	}
+	// integral[r][x] = sum over rows <= r and pixels <= x-8 of filt_offset * sum(depth)
+	uint32_t *pix = (uint32_t *)c->scratch;		// one row of pixel sums at a time
+	for (int r = 0; r < c->out_height; r++) {
+		for (int p = 0; p < c->integral_width - 8; p++) {
+			uint32_t sum = 0;
+			for (int d = 0; d < c->in_depth; d++) {
+				sum += c->input[r * c->in_width * c->in_depth + (d / 32) * c->in_width * 32 + p * 32 + d % 32];
+			}
+			pix[p] = sum * (uint32_t)c->filt_offset;
+		}
+		for (int x = 0; x < c->integral_width; x++) {
+			uint32_t sum = (r > 0) ? (uint32_t)out[(r - 1) * c->integral_width + x] : 0;
+			for (int p = 0; p <= x - 8; p++) sum += pix[p];
+			out[r * c->integral_width + x] = (int32_t)sum;
+		}
+	}
+}
+
+static void gvint_release(struct kcase *hdr)
+{
+	struct gvint_case *c = (struct gvint_case *)hdr;
+	free(c->input);
+	free(c->scratch);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * gvsuma_asm
+ */
+struct gvsuma_case {
+	struct kcase hdr;
+	int32_t *integral;
+	int32_t integral_width, pitch, stride_h, filt_width, filt_height, out_height, offset;
+};
+
+static struct kcase *gvsuma_make(uint32_t *seed)
+{
+	struct gvsuma_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->integral_width = 32 * rand_range(seed, 1, 6);
+	c->pitch = 4 * (c->integral_width + 32 * rand_range(seed, 0, 1));
+	c->stride_h = rand_range(seed, 1, 3);
+	c->filt_width = rand_range(seed, 1, 7);
+	c->filt_height = rand_range(seed, 1, 7);
+	c->out_height = rand_range(seed, 1, 8);
+	c->offset = (int32_t)rand_u32(seed);
+	int32_t rows = (c->out_height - 1) * c->stride_h + c->filt_height + 1;
+	c->integral = alloc_rand((size_t)rows * c->pitch + 128, seed);
+	if (c->integral == NULL || alloc_outputs(&c->hdr, (size_t)c->out_height * c->pitch) != 0) {
+		return &c->hdr;
+	}
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "intw%d pitch%d sh%d f%dx%d h%d",
+		c->integral_width, c->pitch, c->stride_h, c->filt_height, c->filt_width, c->out_height);
+	return &c->hdr;
+}
+
+static void gvsuma_run(struct kcase *hdr, int use_kernel)
+{
+	struct gvsuma_case *c = (struct gvsuma_case *)hdr;
+	int32_t *out = (int32_t *)hdr->out[use_kernel];
+	if (use_kernel) {
+		gvsuma_asm(c->integral, out, c->integral_width, c->pitch, c->stride_h,
+			c->filt_width, c->filt_height, c->out_height, c->offset);
+		return;
+	}
+	int32_t pw = c->pitch / 4;
+	for (int r = 0; r < c->out_height; r++) {
+		const uint32_t *top = (const uint32_t *)c->integral + r * c->stride_h * pw;
+		const uint32_t *bot = top + c->filt_height * pw;
+		for (int x = 0; x < c->integral_width; x++) {
+			uint32_t box = bot[x + c->filt_width] - top[x + c->filt_width] - bot[x] + top[x];
+			out[r * pw + x] = (int32_t)((uint32_t)c->offset - box);
+		}
+	}
+}
+
+static void gvsuma_release(struct kcase *hdr)
+{
+	struct gvsuma_case *c = (struct gvsuma_case *)hdr;
+	free(c->integral);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * gsum_asm
+ */
+struct gsum_case {
+	struct kcase hdr;
+	uint8_t *input;
+	int32_t in_width, in_depth, out_height, stride_v, filt_offset, out_offset;
+};
+
+static struct kcase *gsum_make(uint32_t *seed)
+{
+	struct gsum_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->in_width = 4 * rand_range(seed, 1, 24);
+	c->in_depth = 32 * rand_range(seed, 1, 4);
+	c->out_height = rand_range(seed, 1, 8);
+	c->stride_v = rand_range(seed, 1, 2);
+	c->filt_offset = rand_range(seed, 0, 255);
+	c->out_offset = 4 * rand_range(seed, 0, 31);		// output need not be vector aligned
+	c->input = alloc_rand((size_t)((c->out_height - 1) * c->stride_v + 1) * c->in_width * c->in_depth, seed);
+	if (c->input == NULL
+	 || alloc_outputs(&c->hdr, c->out_offset + (size_t)4 * c->in_width * c->out_height) != 0) {
+		return &c->hdr;
+	}
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "w%d d%d h%d sv%d zoff%d +%d",
+		c->in_width, c->in_depth, c->out_height, c->stride_v, c->filt_offset, c->out_offset);
+	return &c->hdr;
+}
+
+static void gsum_run(struct kcase *hdr, int use_kernel)
+{
+	struct gsum_case *c = (struct gsum_case *)hdr;
+	int32_t *out = (int32_t *)(hdr->out[use_kernel] + c->out_offset);
+	if (use_kernel) {
+		gsum_asm(c->input, out, c->in_width, c->in_depth, c->out_height, c->stride_v, c->filt_offset);
+		return;
+	}
+	for (int j = 0; j < c->out_height; j++) {
+		for (int i = 0; i < c->in_width; i++) {
+			uint32_t sum = 0;
+			for (int d = 0; d < c->in_depth; d++) {
+				sum += c->input[c->in_depth * c->in_width * c->stride_v * j + 32 * c->in_width * (d / 32) + 32 * i + d % 32];
+			}
+			*out++ = (int32_t)(0u - sum * (uint32_t)c->filt_offset);
+		}
+	}
+}
+
+static void gsum_release(struct kcase *hdr)
+{
+	struct gsum_case *c = (struct gsum_case *)hdr;
+	free(c->input);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * inconv2dbbb_v60_asm: 4 channels per pixel, even horizontal stride
+ */
+struct inconv_case {
+	struct kcase hdr;
+	uint8_t *input, *weights;
+	int32_t *bias, *suma;
+	int32_t in_width, next_out_width, out_width, stride_h, stride_w;
+	int32_t filt_width, filt_height, out_height, next_suma, recip, recip_shamt;
+};
+
+static struct kcase *inconv_make(uint32_t *seed)
+{
+	struct inconv_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->filt_width = rand_range(seed, 1, 7);
+	c->filt_height = rand_range(seed, 1, 7);
+	c->stride_h = rand_range(seed, 1, 3);
+	c->stride_w = 2 * rand_range(seed, 1, 2);
+	c->out_width = rand_range(seed, 1, 40);
+	c->out_height = rand_range(seed, 1, 5);
+	// even filter widths read one pixel pair past the filter
+	c->in_width = ALIGN_UP((c->out_width + 3) / 4 * 4 * c->stride_w + c->filt_width + 2, 4) + 4 * rand_range(seed, 0, 2);
+	c->next_out_width = 128 * ((c->out_width + 3) / 4 + rand_range(seed, 0, 2));
+	c->next_suma = 4 * (c->in_width + 32 * rand_range(seed, 0, 1));
+
+	int32_t in_rows = (c->out_height - 1) * c->stride_h + c->filt_height;
+	c->input = alloc_rand((size_t)in_rows * c->in_width * 4, seed);
+	c->weights = alloc_rand(c->filt_height * c->filt_width * 128, seed);
+	c->bias = alloc_rand(128, seed);
+	c->suma = alloc_rand((size_t)c->out_height * c->next_suma, seed);
+	if (c->input == NULL || c->weights == NULL || c->bias == NULL || c->suma == NULL
+	 || alloc_outputs(&c->hdr, 256 + (size_t)c->out_height * c->next_out_width) != 0) {
+		return &c->hdr;
+	}
+	c->recip_shamt = rand_range(seed, -2, 6) & 7;
+	c->recip = (int32_t)(rand_u32(seed) & 0x7FFFFFFF) >> rand_range(seed, 6, 14);
+	if (rand_range(seed, 0, 7) == 0) c->recip = -c->recip;
+	for (int i = 0; i < 32; i++) c->bias[i] >>= rand_range(seed, 6, 14);
+	for (int i = 0; i < c->out_height * c->next_suma / 4; i++) c->suma[i] >>= 12;
+	minmax_init(&c->hdr);
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "%dx%d s%dx%d w%d h%d iw%d shamt%d",
+		c->filt_height, c->filt_width, c->stride_h, c->stride_w, c->out_width, c->out_height,
+		c->in_width, c->recip_shamt);
+	return &c->hdr;
+}
+
+static void inconv_run(struct kcase *hdr, int use_kernel)
+{
+	struct inconv_case *c = (struct inconv_case *)hdr;
+	int32_t *minmax = (int32_t *)hdr->out[use_kernel];
+	uint8_t *out = hdr->out[use_kernel] + 256;
+	if (use_kernel) {
+		inconv2dbbb_v60_asm(c->input, c->weights, out, c->in_width, c->next_out_width, c->out_width,
+			4, c->filt_width, c->filt_height, c->out_height, minmax, c->recip, c->bias, c->suma,
+			c->next_suma, (c->stride_h << 16) | c->stride_w, c->recip_shamt);
+		return;
+	}
+	// min/max are per depth and cover the padding columns; with recip_shamt = 0 the
+	// asm leaves the third column of each group out of the max.
+	int32_t maxv[32], minv[32];
+	for (int o = 0; o < 32; o++) {
+		maxv[o] = INT32_MIN;
+		minv[o] = INT32_MAX;
+	}
+	for (int r = 0; r < c->out_height; r++) {
+		const int32_t *suma = (const int32_t *)((const uint8_t *)c->suma + r * c->next_suma);
+		for (int x = 0; x < ((c->out_width + 3) & ~3); x++) {
+			for (int o = 0; o < 32; o++) {
+				uint32_t sum = (uint32_t)c->bias[o] + (uint32_t)suma[x * c->stride_w];
+				for (int fy = 0; fy < c->filt_height; fy++) {
+					for (int fx = 0; fx < c->filt_width; fx++) {
+						const uint8_t *w = c->weights + (fy * c->filt_width + fx) * 128 + 4 * o;
+						int32_t in_idx = ((r * c->stride_h + fy) * c->in_width + x * c->stride_w + fx) * 4;
+						for (int k = 0; k < 4; k++) sum += (uint32_t)c->input[in_idx + k] * w[k];
+					}
+				}
+				int32_t v = (int32_t)(sum << c->recip_shamt);
+				if (v < minv[o]) minv[o] = v;
+				if (v > maxv[o] && (c->recip_shamt != 0 || x % 4 != 2)) maxv[o] = v;
+				int32_t y = mpy_s1_rnd_sat(v, c->recip);
+				y = (y > 32767) ? 32767 : (y < -32768) ? -32768 : y;
+				out[r * c->next_out_width + x * 32 + o] = (y > 255) ? 255 : (y < 0) ? 0 : y;
+			}
+		}
+	}
+	for (int o = 0; o < 32; o++) {
+		int32_t ymax = mpy_s1_rnd_sat(maxv[o], c->recip);
+		int32_t ymin = mpy_s1_rnd_sat(minv[o], c->recip);
+		if (ymax > minmax[o]) minmax[o] = ymax;
+		if (ymin < minmax[32 + o]) minmax[32 + o] = ymin;
+	}
+}
+
+static void inconv_release(struct kcase *hdr)
+{
+	struct inconv_case *c = (struct inconv_case *)hdr;
+	free(c->input);
+	free(c->weights);
+	free(c->bias);
+	free(c->suma);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * dwconv2dbbb_s{1,2}_{3,5,7}xN_asm: depthwise, d32 in and out. The filter rows are padded
+ * to 4 (3 wide) or 8 taps, with zero weights in the padding taps.
+ */
+struct dwconv_case {
+	struct kcase hdr;
+	uint8_t *input, *weights;
+	int32_t *bias;
+	uint32_t *recip;
+	HVX_Vector *scratch;
+	int32_t next_in_width, next_in_width_32, next_out_width_32, depth, out_width, out_height;
+	int32_t filt_height, filt_zero, recip_shift, stride_h;
+};
+
+static struct kcase *dwconv_make(uint32_t *seed, int filt_width, int stride_w)
+{
+	struct dwconv_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	int o_filt_width = (filt_width + 3) & ~3;
+	c->depth = 32 * rand_range(seed, 1, 3);
+	c->filt_height = rand_range(seed, 2, 7);
+	c->stride_h = rand_range(seed, 1, 2);
+	c->out_width = rand_range(seed, 1, 24);
+	c->out_height = rand_range(seed, 1, 4);
+	c->filt_zero = rand_range(seed, 0, 255);
+	c->recip_shift = rand_range(seed, 0, 4);
+	// the asm loads whole vectors past the last filter tap
+	int32_t in_width = ALIGN_UP((c->out_width + 3) / 4 * 4 * stride_w + o_filt_width + 8, 4) + 4 * rand_range(seed, 0, 2);
+	c->next_in_width_32 = 32 * in_width;
+	c->next_in_width = c->depth / 32 * c->next_in_width_32 + 128 * rand_range(seed, 0, 2);
+	c->next_out_width_32 = 128 * ((c->out_width + 3) / 4 + rand_range(seed, 0, 2));
+
+	int32_t in_rows = (c->out_height - 1) * c->stride_h + c->filt_height;
+	size_t filt_bytes = (size_t)c->depth * c->filt_height * o_filt_width;
+	c->input = alloc_rand((size_t)in_rows * c->next_in_width, seed);
+	c->weights = alloc_rand(filt_bytes, seed);
+	c->bias = alloc_rand(4 * c->depth, seed);
+	c->recip = alloc_rand(4 * c->depth, seed);
+	c->scratch = alloc_vec(128 * (c->filt_height + 1));
+	if (c->input == NULL || c->weights == NULL || c->bias == NULL || c->recip == NULL || c->scratch == NULL
+	 || alloc_outputs(&c->hdr, 256 + (size_t)c->out_height * c->depth / 32 * c->next_out_width_32) != 0) {
+		return &c->hdr;
+	}
+	for (size_t i = 0; i < filt_bytes; i++) {
+		if (i % 4 >= filt_width - 4 * (i / 128 % (o_filt_width / 4))) c->weights[i] = 0;
+	}
+	for (int i = 0; i < c->depth; i++) {
+		c->bias[i] >>= rand_range(seed, 8, 16);
+		c->recip[i] = (rand_u32(seed) & 0x7FFFFFFF) >> rand_range(seed, 6, 14);
+	}
+	minmax_init(&c->hdr);
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "%dx%d d%d s%dx%d w%d h%d fz%d rsh%d",
+		c->filt_height, filt_width, c->depth, c->stride_h, stride_w, c->out_width, c->out_height,
+		c->filt_zero, c->recip_shift);
+	return &c->hdr;
+}
+
+static void dwconv_ref(struct dwconv_case *c, int filt_width, int stride_w, int32_t *minmax, uint8_t *out)
+{
+	int32_t nd32 = c->depth / 32;
+	int32_t o_filt_width = (filt_width + 3) & ~3;
+	for (int r = 0; r < c->out_height; r++) {
+		for (int d = 0; d < nd32; d++) {
+			for (int x0 = 0; x0 < c->out_width; x0 += 4) {
+				for (int o = 0; o < 32; o++) {
+					int32_t y[4];
+					for (int j = 0; j < 4; j++) {
+						int32_t x = x0 + j;
+						if (x >= c->out_width) {	// padding columns repeat the group's first
+							y[j] = y[0];
+							continue;
+						}
+						uint32_t sum = (uint32_t)c->bias[32 * d + o];
+						for (int fy = 0; fy < c->filt_height; fy++) {
+							for (int fx = 0; fx < filt_width; fx++) {
+								uint32_t in = c->input[(r * c->stride_h + fy) * c->next_in_width + d * c->next_in_width_32
+									+ (x * stride_w + fx) * 32 + o];
+								uint32_t w = c->weights[((d * c->filt_height + fy) * o_filt_width / 4 + fx / 4) * 128
+									+ 4 * o + fx % 4];
+								sum += in * w - in * (uint32_t)c->filt_zero;
+							}
+						}
+						y[j] = mpy_s1_rnd_sat((int32_t)(sum << c->recip_shift), (int32_t)c->recip[32 * d + o]);
+					}
+					for (int j = 0; j < 4; j++) {
+						if (y[j] > minmax[o]) minmax[o] = y[j];
+						if (y[j] < minmax[32 + o]) minmax[32 + o] = y[j];
+						int32_t v = (y[j] > 32767) ? 32767 : (y[j] < -32768) ? -32768 : y[j];
+						out[(r * nd32 + d) * c->next_out_width_32 + (x0 + j) * 32 + o] = (v > 255) ? 255 : (v < 0) ? 0 : v;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void dwconv_release(struct kcase *hdr)
+{
+	struct dwconv_case *c = (struct dwconv_case *)hdr;
+	free(c->input);
+	free(c->weights);
+	free(c->bias);
+	free(c->recip);
+	free(c->scratch);
+	free_outputs(hdr);
+	free(c);
+}
+
+#define DWCONV_CHECK(NAME, FILT_WIDTH, STRIDE_W) \
+static struct kcase *NAME##_make(uint32_t *seed) \
+{ \
+	return dwconv_make(seed, FILT_WIDTH, STRIDE_W); \
+} \
+static void NAME##_run(struct kcase *hdr, int use_kernel) \
+{ \
+	struct dwconv_case *c = (struct dwconv_case *)hdr; \
+	int32_t *minmax = (int32_t *)hdr->out[use_kernel]; \
+	uint8_t *out = hdr->out[use_kernel] + 256; \
+	if (!use_kernel) { \
+		dwconv_ref(c, FILT_WIDTH, STRIDE_W, minmax, out); \
+		return; \
+	} \
+	dwconv2dbbb_##NAME##_asm(c->input, c->weights, out, c->next_in_width, c->depth / 32 * c->next_out_width_32, \
+		c->next_in_width_32, c->next_out_width_32, c->depth, c->out_width, c->out_height, c->filt_height, \
+		c->filt_zero, c->bias, minmax, c->recip, c->recip_shift, c->stride_h, c->scratch, 0); \
+}
+
+DWCONV_CHECK(s1_3xN, 3, 1)
+DWCONV_CHECK(s1_5xN, 5, 1)
+DWCONV_CHECK(s1_7xN, 7, 1)
+DWCONV_CHECK(s2_3xN, 3, 2)
+DWCONV_CHECK(s2_5xN, 5, 2)
+DWCONV_CHECK(s2_7xN, 7, 2)
+
+/*
+ * 16-bit kernels (declared in ops/src/op_supernode_16b.c). The activations and weights
+ * are 16 bit, held as a low byte plane and a high byte plane.
+ */
+void gvint_16b(const uint8_t *in_bufe, const uint8_t *in_bufo, int32_t *integral_out,
+	int32_t next_d32_row, int32_t next_input, int32_t integral_width, int32_t in_depth,
+	int32_t out_height, int32_t *scratch_128xW);
+void gvsuma_16b(const int32_t *integral, int32_t *suma_out, int32_t in_width,
+	int32_t next_output_width, int32_t stride_height, int32_t filt_width, int32_t filt_height,
+	int32_t out_height, int32_t filt_offset);
+void gvconv2db2b2b2u_d32_asm(const uint8_t *in_bufe, const uint8_t *in_bufo,
+	uint8_t *out_bufe, uint8_t *out_bufo, const uint8_t *weights, int next_in_width,
+	int next_out_width, int out_width, int stride_h_w, int in_depth, int filt_width,
+	int filt_height, int out_height, const int32_t *bias_add, const int32_t *suma,
+	int32_t next_suma_row, int32_t *ptr_minmax, int32_t recip, int recip_shift,
+	int out_align, int skip_col);
+void inconv2db2b2b2_v60_asm(const uint8_t *in_bufe, const uint8_t *in_bufo,
+	const uint8_t *weights, uint16_t *out_bufe, int next_in_width, int next_out_width,
+	int out_width, int stride_h_w, int in_depth, int filt_width, int filt_height,
+	int out_height, const int32_t *bias_add, const int32_t *suma, int32_t next_suma_row,
+	int32_t *ptr_minmax, int32_t recip, int recip_shift);
+
+static uint16_t sat_u16(int32_t y)
+{
+	return (y > 65535) ? 65535 : (y < 0) ? 0 : y;
+}
+
+/*
+ * gvconv2db2b2b2u_d32_asm
+ */
+struct conv16_case {
+	struct kcase hdr;
+	uint8_t *in_e, *in_o, *weights;
+	int32_t *bias, *suma;
+	int32_t in_width, next_out_width, out_width, stride_h, stride_w, in_depth;
+	int32_t filt_width, filt_height, out_height, next_suma, recip, recip_shift;
+};
+
+static struct kcase *conv16_make(uint32_t *seed)
+{
+	struct conv16_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->filt_width = rand_range(seed, 1, 4);
+	c->filt_height = rand_range(seed, 1, 4);
+	c->in_depth = 32 * rand_range(seed, 1, 3);
+	c->stride_w = rand_range(seed, 1, 2);
+	c->stride_h = rand_range(seed, 1, 2);
+	c->out_width = rand_range(seed, 1, 20);
+	c->out_height = rand_range(seed, 1, 5);
+	c->in_width = ALIGN_UP((c->out_width + 3) / 4 * 4 * c->stride_w + c->filt_width, 4) + 4 * rand_range(seed, 0, 2);
+	c->next_out_width = 128 * ((c->out_width + 3) / 4 + rand_range(seed, 0, 2));
+	c->next_suma = 4 * (c->in_width + 32 * rand_range(seed, 0, 1));
+
+	int32_t in_rows = (c->out_height - 1) * c->stride_h + c->filt_height;
+	size_t in_bytes = (size_t)in_rows * c->in_width * c->in_depth;
+	int32_t filt_bytes = c->filt_height * c->in_depth / 32 * c->filt_width * 4 * 256;
+	c->in_e = alloc_rand(in_bytes, seed);
+	c->in_o = alloc_rand(in_bytes, seed);
+	c->weights = alloc_rand(2 * filt_bytes, seed);
+	c->bias = alloc_rand(128, seed);
+	c->suma = alloc_rand((size_t)c->out_height * c->next_suma, seed);
+	if (c->in_e == NULL || c->in_o == NULL || c->weights == NULL || c->bias == NULL || c->suma == NULL
+	 || alloc_outputs(&c->hdr, 256 + (size_t)c->out_height * 2 * c->next_out_width) != 0) {
+		return &c->hdr;
+	}
+	// recip_shift stays in the range where the asm's two ways of applying it agree
+	c->recip_shift = rand_range(seed, 0, 8);
+	c->recip = (int32_t)(rand_u32(seed) >> rand_range(seed, 9, 18));
+	if (rand_range(seed, 0, 7) == 0) c->recip = -c->recip;
+	for (int i = 0; i < 32; i++) c->bias[i] >>= rand_range(seed, 2, 10);
+	for (int i = 0; i < c->out_height * c->next_suma / 4; i++) c->suma[i] >>= 6;
+	minmax_init(&c->hdr);
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "%dx%d d%d s%dx%d w%d h%d iw%d rsh%d",
+		c->filt_height, c->filt_width, c->in_depth, c->stride_h, c->stride_w,
+		c->out_width, c->out_height, c->in_width, c->recip_shift);
+	return &c->hdr;
+}
+
+static void conv16_ref(struct conv16_case *c, int32_t *minmax, uint16_t *out)
+{
+	int32_t row_bytes = c->in_width * c->in_depth;
+	int32_t nd32 = c->in_depth / 32;
+	int32_t cols = (c->out_width + 3) & ~3;
+	const uint8_t *wl = c->weights;
+	const uint8_t *wh = c->weights + c->filt_height * nd32 * c->filt_width * 4 * 256;
+
+	for (int r = 0; r < c->out_height; r++) {
+		const int32_t *suma = (const int32_t *)((const uint8_t *)c->suma + r * c->next_suma);
+		for (int x = 0; x < cols; x++) {
+			for (int o = 0; o < 32; o++) {
+				// the 16x16 product in byte parts: lo*lo, lo*hi + hi*lo, hi*hi
+				uint32_t ll = 0, lh = 0x80;
+				uint32_t hh = (uint32_t)c->bias[o] + (uint32_t)suma[x * c->stride_w];
+				for (int fy = 0; fy < c->filt_height; fy++) {
+					for (int fx = 0; fx < c->filt_width; fx++) {
+						for (int d = 0; d < c->in_depth; d++) {
+							int32_t in_idx = (r * c->stride_h + fy) * row_bytes + (d / 32) * c->in_width * 32
+								+ (x * c->stride_w + fx) * 32 + d % 32;
+							int32_t frow = fy * nd32 + d / 32;
+							int32_t j = fx * 4 + (d % 32) / 8;
+							int32_t k = d % 8;
+							int32_t w_idx = (frow * c->filt_width * 4 + j) * 256 + 128 * (k / 4) + 4 * o + k % 4;
+							ll += (uint32_t)c->in_e[in_idx] * wl[w_idx];
+							lh += (uint32_t)c->in_e[in_idx] * wh[w_idx] + (uint32_t)c->in_o[in_idx] * wl[w_idx];
+							hh += (uint32_t)c->in_o[in_idx] * wh[w_idx];
+						}
+					}
+				}
+				lh += (uint32_t)((int32_t)ll >> 8);
+				int32_t v = (int32_t)(hh + (uint32_t)((int32_t)lh >> 8));
+				if (x < c->out_width) {
+					if (v > minmax[o]) minmax[o] = v;
+					if (v < minmax[32 + o]) minmax[32 + o] = v;
+				}
+				int32_t y = mpy_s1_rnd_sat((int32_t)((uint32_t)v << c->recip_shift), c->recip);
+				out[r * c->next_out_width + x * 32 + o] = sat_u16(y);
+			}
+		}
+	}
+}
+
+static void conv16_run(struct kcase *hdr, int use_kernel)
+{
+	struct conv16_case *c = (struct conv16_case *)hdr;
+	int32_t *minmax = (int32_t *)hdr->out[use_kernel];
+	uint8_t *out = hdr->out[use_kernel] + 256;
+	if (!use_kernel) {
+		conv16_ref(c, minmax, (uint16_t *)out);
+		return;
+	}
+	gvconv2db2b2b2u_d32_asm(c->in_e, c->in_o, out, NULL, c->weights, c->in_width, c->next_out_width,
+		c->out_width, (c->stride_h << 16) | c->stride_w, c->in_depth, c->filt_width, c->filt_height,
+		c->out_height, c->bias, c->suma, c->next_suma, minmax, c->recip, c->recip_shift, 0, 0);
+}
+
+static void conv16_release(struct kcase *hdr)
+{
+	struct conv16_case *c = (struct conv16_case *)hdr;
+	free(c->in_e);
+	free(c->in_o);
+	free(c->weights);
+	free(c->bias);
+	free(c->suma);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * inconv2db2b2b2_v60_asm: 4 channels per pixel
+ */
+struct inconv16_case {
+	struct kcase hdr;
+	uint8_t *in_e, *in_o, *weights;
+	int32_t *bias, *suma;
+	int32_t in_width, next_out_width, out_width, stride_h;
+	int32_t filt_width, filt_height, out_height, next_suma, recip, recip_shift;
+};
+
+static struct kcase *inconv16_make(uint32_t *seed)
+{
+	struct inconv16_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->filt_width = rand_range(seed, 1, 7);
+	c->filt_height = rand_range(seed, 1, 7);
+	c->stride_h = rand_range(seed, 1, 2);
+	c->out_width = rand_range(seed, 1, 40);
+	c->out_height = rand_range(seed, 1, 5);
+	c->in_width = ALIGN_UP((c->out_width + 3) / 4 * 4 + c->filt_width, 4) + 4 * rand_range(seed, 0, 2);
+	c->next_out_width = 128 * ((c->out_width + 3) / 4 + rand_range(seed, 0, 2));
+	c->next_suma = 4 * (c->in_width + 32 * rand_range(seed, 0, 1));
+
+	int32_t in_rows = (c->out_height - 1) * c->stride_h + c->filt_height;
+	size_t in_bytes = (size_t)in_rows * c->in_width * 4;
+	c->in_e = alloc_rand(in_bytes, seed);
+	c->in_o = alloc_rand(in_bytes, seed);
+	c->weights = alloc_rand(c->filt_height * c->filt_width * 256, seed);
+	c->bias = alloc_rand(128, seed);
+	c->suma = alloc_rand((size_t)c->out_height * c->next_suma, seed);
+	if (c->in_e == NULL || c->in_o == NULL || c->weights == NULL || c->bias == NULL || c->suma == NULL
+	 || alloc_outputs(&c->hdr, 256 + (size_t)c->out_height * 2 * c->next_out_width) != 0) {
+		return &c->hdr;
+	}
+	c->recip_shift = rand_range(seed, 0, 12);
+	c->recip = (int32_t)(rand_u32(seed) >> rand_range(seed, 7, 16));
+	if (rand_range(seed, 0, 7) == 0) c->recip = -c->recip;
+	for (int i = 0; i < 32; i++) c->bias[i] >>= rand_range(seed, 6, 14);
+	for (int i = 0; i < c->out_height * c->next_suma / 4; i++) c->suma[i] >>= 10;
+	minmax_init(&c->hdr);
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "%dx%d sh%d w%d h%d iw%d rsh%d",
+		c->filt_height, c->filt_width, c->stride_h, c->out_width, c->out_height, c->in_width, c->recip_shift);
+	return &c->hdr;
+}
+
+static void inconv16_run(struct kcase *hdr, int use_kernel)
+{
+	struct inconv16_case *c = (struct inconv16_case *)hdr;
+	int32_t *minmax = (int32_t *)hdr->out[use_kernel];
+	uint16_t *out = (uint16_t *)(hdr->out[use_kernel] + 256);
+	if (use_kernel) {
+		inconv2db2b2b2_v60_asm(c->in_e, c->in_o, c->weights, out, c->in_width, c->next_out_width,
+			c->out_width, (c->stride_h << 16) | 1, 4, c->filt_width, c->filt_height, c->out_height,
+			c->bias, c->suma, c->next_suma, minmax, c->recip, c->recip_shift);
+		return;
+	}
+	// lo*lo is not computed; lo*hi + hi*lo is carried in at >> 8. min/max cover the
+	// padding columns too, and are reduced over all 32 depths.
+	int32_t mx = minmax[0], mn = minmax[32];
+	for (int i = 0; i < 32; i++) {
+		if (minmax[i] > mx) mx = minmax[i];
+		if (minmax[32 + i] < mn) mn = minmax[32 + i];
+	}
+	for (int r = 0; r < c->out_height; r++) {
+		const int32_t *suma = (const int32_t *)((const uint8_t *)c->suma + r * c->next_suma);
+		for (int x = 0; x < ((c->out_width + 3) & ~3); x++) {
+			for (int o = 0; o < 32; o++) {
+				uint32_t lh = 0x80;
+				uint32_t hh = (uint32_t)c->bias[o] + (uint32_t)suma[x];
+				for (int fy = 0; fy < c->filt_height; fy++) {
+					for (int fx = 0; fx < c->filt_width; fx++) {
+						const uint8_t *w = c->weights + (fy * c->filt_width + fx) * 256 + 4 * o;
+						int32_t in_idx = ((r * c->stride_h + fy) * c->in_width + x + fx) * 4;
+						for (int k = 0; k < 4; k++) {
+							lh += (uint32_t)c->in_e[in_idx + k] * w[128 + k] + (uint32_t)c->in_o[in_idx + k] * w[k];
+							hh += (uint32_t)c->in_o[in_idx + k] * w[128 + k];
+						}
+					}
+				}
+				int32_t v = (int32_t)(hh + (uint32_t)((int32_t)lh >> 8));
+				if (v > mx) mx = v;
+				if (v < mn) mn = v;
+				int32_t y = mpy_s1_rnd_sat((int32_t)((uint32_t)v << c->recip_shift), c->recip);
+				out[r * c->next_out_width + x * 32 + o] = sat_u16(y);
+			}
+		}
+	}
+	for (int i = 0; i < 32; i++) {
+		minmax[i] = mx;
+		minmax[32 + i] = mn;
+	}
+}
+
+static void inconv16_release(struct kcase *hdr)
+{
+	struct inconv16_case *c = (struct inconv16_case *)hdr;
+	free(c->in_e);
+	free(c->in_o);
+	free(c->weights);
+	free(c->bias);
+	free(c->suma);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * gvint_16b
+ */
+struct gvint16_case {
+	struct kcase hdr;
+	uint8_t *in_e, *in_o;
+	int32_t *scratch;
+	int32_t in_width, in_depth, integral_width, out_height;
+};
+
+static struct kcase *gvint16_make(uint32_t *seed)
+{
+	struct gvint16_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->in_depth = 32 * rand_range(seed, 1, 4);
+	c->integral_width = 32 * rand_range(seed, 1, 6);
+	c->in_width = c->integral_width - 8 + 4 * rand_range(seed, 0, 4);
+	c->out_height = rand_range(seed, 1, 12);
+	size_t in_bytes = (size_t)c->out_height * c->in_width * c->in_depth;
+	c->in_e = alloc_rand(in_bytes, seed);
+	c->in_o = alloc_rand(in_bytes, seed);
+	c->scratch = alloc_vec(16 * c->integral_width);
+	if (c->in_e == NULL || c->in_o == NULL || c->scratch == NULL
+	 || alloc_outputs(&c->hdr, (size_t)4 * c->integral_width * c->out_height) != 0) {
+		return &c->hdr;
+	}
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "iw%d d%d intw%d h%d",
+		c->in_width, c->in_depth, c->integral_width, c->out_height);
+	return &c->hdr;
+}
+
+static void gvint16_run(struct kcase *hdr, int use_kernel)
+{
+	struct gvint16_case *c = (struct gvint16_case *)hdr;
+	int32_t *out = (int32_t *)hdr->out[use_kernel];
+	if (use_kernel) {
+		gvint_16b(c->in_e, c->in_o, out, 32 * c->in_width, c->in_width * c->in_depth,
+			c->integral_width, c->in_depth, c->out_height, c->scratch);
+		return;
+	}
+	// integral[r][x] = sum over rows <= r and pixels <= x-8 of the 16-bit depth sum
+	uint32_t *pix = (uint32_t *)c->scratch;
+	for (int r = 0; r < c->out_height; r++) {
+		for (int p = 0; p < c->integral_width - 8; p++) {
+			uint32_t sum = 0;
+			for (int d = 0; d < c->in_depth; d++) {
+				int32_t idx = r * c->in_width * c->in_depth + (d / 32) * c->in_width * 32 + p * 32 + d % 32;
+				sum += c->in_e[idx] + 256u * c->in_o[idx];
+			}
+			pix[p] = sum;
+		}
+		for (int x = 0; x < c->integral_width; x++) {
+			uint32_t sum = (r > 0) ? (uint32_t)out[(r - 1) * c->integral_width + x] : 0;
+			for (int p = 0; p <= x - 8; p++) sum += pix[p];
+			out[r * c->integral_width + x] = (int32_t)sum;
+		}
+	}
+}
+
+static void gvint16_release(struct kcase *hdr)
+{
+	struct gvint16_case *c = (struct gvint16_case *)hdr;
+	free(c->in_e);
+	free(c->in_o);
+	free(c->scratch);
+	free_outputs(hdr);
+	free(c);
+}
+
+/*
+ * gvsuma_16b (same cases as gvsuma_asm)
+ */
+static void gvsuma16_run(struct kcase *hdr, int use_kernel)
+{
+	struct gvsuma_case *c = (struct gvsuma_case *)hdr;
+	int32_t *out = (int32_t *)hdr->out[use_kernel];
+	if (use_kernel) {
+		gvsuma_16b(c->integral, out, c->integral_width, c->pitch, c->stride_h,
+			c->filt_width, c->filt_height, c->out_height, c->offset);
+		return;
+	}
+	int32_t pw = c->pitch / 4;
+	for (int r = 0; r < c->out_height; r++) {
+		const uint32_t *top = (const uint32_t *)c->integral + r * c->stride_h * pw;
+		const uint32_t *bot = top + c->filt_height * pw;
+		for (int x = 0; x < c->integral_width; x++) {
+			int32_t box = (int32_t)(bot[x + c->filt_width] - top[x + c->filt_width] - bot[x] + top[x]);
+			// vmpye: 32 x u16 (low half of offset), >> 16
+			out[r * pw + x] = (int32_t)(((int64_t)-box * (c->offset & 0xFFFF)) >> 16);
+		}
+	}
+}
+
+/*
+ * gvrmaxmin
+ */
+static struct kcase *rmaxmin_make(uint32_t *seed)
+{
+	struct kcase *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	if (alloc_outputs(c, 256) != 0) return c;
+	for (int j = 0; j < 64; j++) {
+		int32_t v = (int32_t)rand_u32(seed);
+		((int32_t *)c->out[0])[j] = v;
+		((int32_t *)c->out[1])[j] = v;
+	}
+	snprintf(c->desc, sizeof(c->desc), "random");
+	return c;
+}
+
+static void rmaxmin_run(struct kcase *c, int use_kernel)
+{
+	int32_t *mm = (int32_t *)c->out[use_kernel];
+	if (use_kernel) {
+		gvrmaxmin(mm);
+		return;
+	}
+	int32_t mx = INT32_MIN, mn = INT32_MAX;
+	for (int j = 0; j < 32; j++) {
+		if (mm[j] > mx) mx = mm[j];
+		if (mm[32 + j] < mn) mn = mm[32 + j];
+	}
+	for (int j = 0; j < 32; j++) {
+		mm[j] = mx;
+		mm[32 + j] = mn;
+	}
+}
+
+static void rmaxmin_release(struct kcase *c)
+{
+	free_outputs(c);
+	free(c);
+}
+
+/*
+ * vmemset_short_asm (halfword aligned destinations)
+ */
+struct memset16_case {
+	struct kcase hdr;
+	int32_t offset, len, val;
+};
+
+static struct kcase *memset16_make(uint32_t *seed)
+{
+	struct memset16_case *c = calloc(1, sizeof(*c));
+	if (c == NULL) return NULL;
+	c->offset = 2 * rand_range(seed, 0, 127);
+	c->len = rand_range(seed, 1, 700);
+	c->val = (int32_t)rand_u32(seed);
+	if (alloc_outputs(&c->hdr, c->offset + 2 * c->len) != 0) return &c->hdr;
+	snprintf(c->hdr.desc, sizeof(c->hdr.desc), "+%d len%d", c->offset, c->len);
+	return &c->hdr;
+}
+
+static void memset16_run(struct kcase *hdr, int use_kernel)
+{
+	struct memset16_case *c = (struct memset16_case *)hdr;
+	uint16_t *dst = (uint16_t *)(hdr->out[use_kernel] + c->offset);
+	if (use_kernel) {
+		vmemset_short_asm(dst, c->val, c->len);
+		return;
+	}
+	for (int i = 0; i < c->len; i++) dst[i] = (uint16_t)c->val;
+}
+
+static void memset16_release(struct kcase *hdr)
+{
+	free_outputs(hdr);
+	free(hdr);
+}
+
+static const struct kernel_check kernel_checks[] = {
+	{ "gvconv2dbbb_v60_asm", conv_make, conv_run, conv_release },
+	{ "gvint_asm", gvint_make, gvint_run, gvint_release },
+	{ "gvsuma_asm", gvsuma_make, gvsuma_run, gvsuma_release },
+	{ "gsum_asm", gsum_make, gsum_run, gsum_release },
+	{ "inconv2dbbb_v60_asm", inconv_make, inconv_run, inconv_release },
+	{ "dwconv2dbbb_s1_3xN_asm", s1_3xN_make, s1_3xN_run, dwconv_release },
+	{ "dwconv2dbbb_s1_5xN_asm", s1_5xN_make, s1_5xN_run, dwconv_release },
+	{ "dwconv2dbbb_s1_7xN_asm", s1_7xN_make, s1_7xN_run, dwconv_release },
+	{ "dwconv2dbbb_s2_3xN_asm", s2_3xN_make, s2_3xN_run, dwconv_release },
+	{ "dwconv2dbbb_s2_5xN_asm", s2_5xN_make, s2_5xN_run, dwconv_release },
+	{ "dwconv2dbbb_s2_7xN_asm", s2_7xN_make, s2_7xN_run, dwconv_release },
+	{ "gvconv2db2b2b2u_d32_asm", conv16_make, conv16_run, conv16_release },
+	{ "inconv2db2b2b2_v60_asm", inconv16_make, inconv16_run, inconv16_release },
+	{ "gvint_16b", gvint16_make, gvint16_run, gvint16_release },
+	{ "gvsuma_16b", gvsuma_make, gvsuma16_run, gvsuma_release },
+	{ "gvrmaxmin", rmaxmin_make, rmaxmin_run, rmaxmin_release },
+	{ "vmemset_short_asm", memset16_make, memset16_run, memset16_release },
+};
+
+static uint32_t case_seed(uint32_t seed, int icase)
+{
+	return (seed ^ 0x9E3779B9u) * 2654435761u + (uint32_t)icase * 40503u + 1;
+}
+
+int main(int argc, char **argv)
+{
+	int ncases = 200;
+	int only_case = -1;
+	uint32_t seed = 1;
+	const char *only_kernel = NULL;
+	int total_bad = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 < argc && strcmp(argv[i], "-n") == 0) ncases = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) seed = strtoul(argv[++i], NULL, 0);
+		else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) only_case = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-k") == 0) only_kernel = argv[++i];
+		else {
+			fprintf(stderr, "usage: %s [-n cases] [-s seed] [-c case] [-k kernel]\n", argv[0]);
+			return 2;
+		}
+	}
+	printf("%-24s %6s %6s %14s %14s %8s\n", "kernel", "cases", "bad",
+#if defined(__hexagon__)
+		"ref pcycles", "kernel pcycles",
+#else
+		"ref ns", "kernel ns",
+#endif
+		"speedup");
+	for (size_t k = 0; k < sizeof(kernel_checks) / sizeof(kernel_checks[0]); k++) {
+		const struct kernel_check *kc = &kernel_checks[k];
+		uint64_t t_ref = 0, t_kernel = 0;
+		int ran = 0, bad = 0;
+		if (only_kernel != NULL && strncmp(kc->name, only_kernel, strlen(only_kernel)) != 0) continue;
+		for (int icase = 0; icase < ncases; icase++) {
+			if (only_case >= 0 && icase != only_case) continue;
+			uint32_t s = case_seed(seed, icase);
+			struct kcase *c = kc->make(&s);
+			if (c == NULL || c->out[0] == NULL || c->out[1] == NULL) {
+				printf("%s: case %d: out of memory\n", kc->name, icase);
+				if (c != NULL) kc->release(c);
+				bad++;
+				continue;
+			}
+			uint64_t t0 = now_ticks();
+			kc->run(c, 0);
+			uint64_t t1 = now_ticks();
+			kc->run(c, 1);
+			uint64_t t2 = now_ticks();
+			t_ref += t1 - t0;
+			t_kernel += t2 - t1;
+			ran++;
+			if (memcmp(c->out[0], c->out[1], c->out_bytes) != 0) {
+				if (bad++ == 0 || only_case >= 0) {
+					size_t at = 0;
+					while (c->out[0][at] == c->out[1][at]) at++;
+					printf("%s: case %d (%s): first difference at byte %zu: ref 0x%02x kernel 0x%02x\n",
+						kc->name, icase, c->desc, at, c->out[0][at], c->out[1][at]);
+				}
+			}
+			kc->release(c);
+		}
+		printf("%-24s %6d %6d %14llu %14llu %7.1fx\n", kc->name, ran, bad,
+			(unsigned long long)t_ref, (unsigned long long)t_kernel,
+			t_kernel ? (double)t_ref / (double)t_kernel : 0.0);
+		total_bad += bad;
+	}
+	return total_bad != 0;
+}
@@ -201,3 +201,129 @@ void dwconv2dbbb_MxN_cn(
     }//out_y
     return;
 }
+
+/*
+ *  FUNCTIONS      : dwconv2dbbb_s{1,2}_{3,5,7}xN_asm (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacements for asm_src/dwconv2dbbb_s{1,2}_{3,5,7}xN_h.S. These follow the
+ *    asm where it differs from dwconv2dbbb_MxN_cn above:
+ *    - recip_level holds one vector of 32 per-channel recips for each d32 slice;
+ *    - the sum is shifted per lane by recip_shift (vasl by vector), then scaled with
+ *      vmpye / vmpyo:<<1:rnd:sat and packed to bytes with saturation via 16 bits;
+ *    - max (ptr_max[0..31]) and min (ptr_max[32..63]) are per lane, of the scaled
+ *      values, updated in place;
+ *    - row r of slice d is stored at out_buf + (r*depth/32 + d)*next_out_width_32;
+ *      next_out_width is not used.
+ *    Columns past out_width, up to the next multiple of 4, repeat column 0 of their
+ *    group. The padding taps of filt (3 -> 4, 5 and 7 -> 8) must be zero: the asm
+ *    applies them to some columns only. scratch_buf and left_skip are not used.
+ */
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+
+// vasl(Vw, Vw): sign-extended 6-bit amount, negative shifts right
+static inline int32_t dw_vasl(int32_t s, int32_t shamt)
+{
+	int n = (int32_t)((uint32_t)shamt << 26) >> 26;
+	if (n >= 0) return (int32_t)((uint32_t)s << n);
+	return s >> ((n == -32) ? 31 : -n);
+}
+
+// vmpye(s, r.uh) followed by vmpyo(s, r.h):<<1:rnd:sat:shift accumulate
+static inline int32_t dw_mpy_rnd_sat(int32_t s, int32_t r)
+{
+	int64_t p = (((int64_t)s * (uint16_t)r) >> 16) + (int64_t)s * (r >> 16);
+	p = (p * 2 + 0x8000) >> 16;
+	return (p > INT32_MAX) ? INT32_MAX : (p < INT32_MIN) ? INT32_MIN : (int32_t)p;
+}
+
+static void dwconv2dbbb_xN_h(
+   const uint8_t *in_buf,
+   const uint8_t  *filt,
+   uint8_t  *out_buf,
+   int32_t next_in_width,
+   int32_t next_in_width_32,
+   int32_t next_out_width_32,
+   int32_t depth,
+   int32_t out_width,
+   int32_t out_height,
+   int32_t filt_width,
+   int32_t filt_height,
+   int32_t filt_zero,
+   const int32_t *bias_sum,
+   int32_t *max,
+   const uint32_t *recip_level,
+   int32_t recip_shift,
+   int32_t stride_width,
+   int32_t stride_height)
+{
+   int out_width_pad = (out_width+3)&(~3);
+   int o_filt_width = (filt_width+3)&(~3);
+   int nd32 = depth/32;
+   int out_y, d, out_x, out_z, ur, filt_y, filt_x;
+   int32_t s[4];
+
+    for (out_y = 0; out_y < out_height; out_y++) {
+        for(d = 0; d < nd32; d++) {
+            const uint8_t *in_d = in_buf + out_y*stride_height*next_in_width + d*next_in_width_32;
+            const uint8_t *filt_d = filt + 32*d*filt_height*o_filt_width;
+            uint8_t *out_d = out_buf + (out_y*nd32 + d)*next_out_width_32;
+            for (out_x = 0; out_x < out_width_pad; out_x += 4) {
+                for (out_z = 0; out_z < 32; out_z++) {
+                    for (ur = 0; ur < 4; ur++) {
+                        uint32_t sum = bias_sum[32*d+out_z];
+                        if (out_x + ur >= out_width) {
+                            s[ur] = s[0];
+                            continue;
+                        }
+                        for (filt_y = 0; filt_y < filt_height; filt_y++) {
+                            const uint8_t *in_row = in_d + filt_y*next_in_width
+                                                  + (out_x+ur)*stride_width*32 + out_z;
+                            const uint8_t *w_row = filt_d + filt_y*o_filt_width*32 + out_z*4;
+                            for (filt_x = 0; filt_x < filt_width; filt_x++) {
+                                uint32_t in_val = in_row[filt_x*32];
+                                sum += in_val*w_row[128*(filt_x/4) + (filt_x%4)];
+                                sum -= in_val*(uint32_t)filt_zero;
+                            }
+                        }
+                        s[ur] = dw_mpy_rnd_sat(dw_vasl((int32_t)sum, recip_shift),
+                                               recip_level[32*d+out_z]);
+                    }
+                    for (ur = 0; ur < 4; ur++) {
+                        int32_t v = s[ur];
+                        max[out_z]    = (v > max[out_z]) ? v : max[out_z];
+                        max[out_z+32] = (v < max[out_z+32]) ? v : max[out_z+32];
+                        v = (v > 32767) ? 32767 : (v < -32768) ? -32768 : v;
+                        out_d[32*(out_x+ur) + out_z] = (v > 255) ? 255 : (v < 0) ? 0 : v;
+                    }
+                }
+            }
+        }
+    }
+}
+
+#define DWCONV2DBBB_XN_HOST(NAME, FILT_WIDTH, STRIDE_WIDTH)                          \
+void HVX_INTRINSIC_REFFUNC(NAME)(                                                     \
+   const uint8_t *in_buf, const uint8_t *filt, uint8_t *out_buf,                      \
+   int32_t next_in_width, int32_t next_out_width,                                     \
+   int32_t next_in_width_32, int32_t next_out_width_32,                               \
+   int32_t depth, int32_t out_width, int32_t out_height,                              \
+   int32_t filt_height, int32_t filt_zero, const int32_t *bias_sum, int32_t *max,     \
+   const uint32_t *recip_level, int32_t recip_shift, int32_t stride_height,           \
+   HVX_Vector *scratch_buf, int32_t left_skip)                                        \
+{                                                                                     \
+   dwconv2dbbb_xN_h(in_buf, filt, out_buf, next_in_width, next_in_width_32,           \
+                    next_out_width_32, depth, out_width, out_height,                  \
+                    FILT_WIDTH, filt_height, filt_zero, bias_sum, max,                \
+                    recip_level, recip_shift, STRIDE_WIDTH, stride_height);           \
+}
+
+DWCONV2DBBB_XN_HOST(dwconv2dbbb_s1_3xN_asm, 3, 1)
+DWCONV2DBBB_XN_HOST(dwconv2dbbb_s1_5xN_asm, 5, 1)
+DWCONV2DBBB_XN_HOST(dwconv2dbbb_s1_7xN_asm, 7, 1)
+DWCONV2DBBB_XN_HOST(dwconv2dbbb_s2_3xN_asm, 3, 2)
+DWCONV2DBBB_XN_HOST(dwconv2dbbb_s2_5xN_asm, 5, 2)
+DWCONV2DBBB_XN_HOST(dwconv2dbbb_s2_7xN_asm, 7, 2)
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+/*
+ *  FUNCTIONS      : gsum_asm (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacement for asm_src/gsum_h.S (1x1 filter suma). Each d32 pixel is
+ *    collapsed to -filt_offset * sum(depth), filt_offset used as a byte; output is
+ *    in_width*out_height contiguous ints, input rows are stride_v rows apart.
+ */
+
+void HVX_INTRINSIC_REFFUNC(gsum_asm)(
+	const uint8_t *xi,
+	int32_t *zi,
+	int in_width,
+	int in_depth,
+	int out_height,
+	int stride_v,
+	int filt_offset)
+{
+	uint32_t zoff = (uint8_t)filt_offset;
+	int32_t next_d32 = 32 * in_width;
+	int32_t nd32 = in_depth >> 5;
+
+	for (int j = 0; j < out_height; j++) {
+		const uint8_t *in_row = xi + in_depth * in_width * stride_v * j;
+		for (int i = 0; i < in_width; i++) {
+			const uint8_t *px = in_row + 32 * i;
+			uint32_t sum = 0;
+			for (int l = 0; l < nd32; l++) {
+				for (int k = 0; k < 32; k++) sum += px[k];
+				px += next_d32;
+			}
+			*zi++ = (int32_t)(0u - sum * zoff);
+		}
+	}
+}
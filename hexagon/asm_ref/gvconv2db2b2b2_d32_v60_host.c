@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include "gvconv_d32_acc_host.h"
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+/*
+ *  FUNCTIONS      : gvconv2db2b2b2u_d32_asm (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacement for asm_src/gvconv2db2b2b2_d32_h_v60.S, bit-exact with the asm.
+ *    16-bit activations and weights are held as separate low (in_bufe, first half of
+ *    the weights) and high (in_bufo, second half) byte planes. Per output the asm keeps
+ *      sll = wl*xl,  shl = 0x80 + wh*xl + wl*xh,  shh = bias + suma + wh*xh
+ *    and folds them as shl += sll >> 8, shh += shl >> 8 (arithmetic shifts); the wl*xl
+ *    term only contributes through that carry. min/max are taken on shh; columns 0,1 are
+ *    scaled by vmpyi with the halfword (1 << recip_shift), columns 2,3 by vasl, then
+ *    requantized with recip and saturated to u16. All four columns of the last group are
+ *    stored; out_bufo, out_align and skip_col are not used (SPLIT_OUTPUT is off).
+ */
+
+// halfword of the scalar asl(1, recip_shift): the shift is the low 7 bits, signed
+static inline int32_t scale_halfword(int recip_shift)
+{
+	int32_t amt = ((recip_shift & 0x7f) ^ 0x40) - 0x40;
+	uint32_t v = (amt >= 0 && amt < 32) ? (1u << amt) : 0;
+	return (int16_t)v;
+}
+
+void HVX_INTRINSIC_REFFUNC(gvconv2db2b2b2u_d32_asm)(
+		const uint8_t *in_bufe,
+		const uint8_t *in_bufo,
+		uint8_t *out_bufe,
+		uint8_t *out_bufo,
+		const uint8_t *weights,
+		int next_in_width,				// in d32 units
+		int next_out_width,
+		int out_width,					// >= 1
+		int stride_h_w,
+		int in_depth,
+		int filt_width,
+		int filt_height,
+		int out_height,
+		const int32_t *bias_add,
+		const int32_t *suma,
+		int32_t next_suma_row,
+		int32_t *ptr_minmax,
+		int32_t recip,
+		int recip_shift,
+		int out_align,
+		int skip_col)
+{
+	int32_t stride_w = (uint16_t)stride_h_w;
+	int32_t stride_h = (uint32_t)stride_h_w >> 16;
+	int32_t filt_ht = filt_height * (in_depth >> 5);		// must be >= 1
+	int32_t filt_wid = filt_width * 4;
+	int32_t in_width_32 = next_in_width * 32;
+	int32_t in_width_stride_depth = next_in_width * in_depth * stride_h;
+	const uint8_t *wl = weights;
+	const uint8_t *wh = weights + 32 * filt_width * filt_height * in_depth;
+	int32_t sc01 = scale_halfword(recip_shift);
+	int32_t maxe[32], mine[32];
+
+	(void)out_bufo;
+	(void)out_align;
+	(void)skip_col;
+	for (int o = 0; o < 32; o++) {
+		maxe[o] = ptr_minmax[o];
+		mine[o] = ptr_minmax[32 + o];
+	}
+	for (int irow = 0; irow < out_height; irow++) {
+		const uint8_t *rowe = in_bufe + irow * in_width_stride_depth;
+		const uint8_t *rowo = in_bufo + irow * in_width_stride_depth;
+		const int32_t *sumabuf = (const int32_t *)((const char *)suma + irow * next_suma_row);
+		uint16_t *ptr_z = (uint16_t *)(out_bufe + irow * 2 * next_out_width);
+
+		for (int col = 0; col < out_width; col += 4, ptr_z += 128) {
+			uint32_t sll[4][32], shl[4][32], shh[4][32];
+			const uint8_t *xl[4], *xh[4];
+			int ncols = (out_width - col < 4) ? (out_width - col) : 4;
+
+			for (int s = 0; s < 4; s++) {
+				int32_t sum = sumabuf[(col + s) * stride_w];
+				xl[s] = rowe + (col + s) * stride_w * 32;
+				xh[s] = rowo + (col + s) * stride_w * 32;
+				for (int o = 0; o < 32; o++) {
+					sll[s][o] = 0;
+					shl[s][o] = 0x80;
+					shh[s][o] = (uint32_t)bias_add[o] + (uint32_t)sum;
+				}
+			}
+			for (int d0 = 0; d0 < 32; d0 += 8) {
+				conv_d32_acc8(sll, d0, wl, xl, filt_ht, in_width_32, filt_wid);
+				conv_d32_acc8(shl, d0, wh, xl, filt_ht, in_width_32, filt_wid);
+				conv_d32_acc8(shl, d0, wl, xh, filt_ht, in_width_32, filt_wid);
+				conv_d32_acc8(shh, d0, wh, xh, filt_ht, in_width_32, filt_wid);
+			}
+			for (int s = 0; s < 4; s++) {
+				for (int o = 0; o < 32; o++) {
+					uint32_t hl = shl[s][o] + (uint32_t)((int32_t)sll[s][o] >> 8);
+					int32_t v = (int32_t)(shh[s][o] + (uint32_t)((int32_t)hl >> 8));
+					if (s < ncols) {
+						maxe[o] = (v > maxe[o]) ? v : maxe[o];
+						mine[o] = (v < mine[o]) ? v : mine[o];
+					}
+					int32_t sv = (s < 2) ? (int32_t)((uint32_t)v * (uint32_t)sc01)
+						: (int32_t)((uint32_t)v << (recip_shift & 31));
+					int32_t y = mpy_s1_rnd_sat(sv, recip);
+					ptr_z[32 * s + o] = (y > 65535) ? 65535 : (y < 0) ? 0 : y;
+				}
+			}
+		}
+	}
+	for (int o = 0; o < 32; o++) {
+		ptr_minmax[o] = maxe[o];
+		ptr_minmax[32 + o] = mine[o];
+	}
+}
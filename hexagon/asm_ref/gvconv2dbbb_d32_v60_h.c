@@ -86,7 +86,7 @@ void HVX_INTRINSIC_REFFUNC(gvconv2dbbb_v60_asm)(
 	int out_width_stride_depth = out_next_row;
 
 	int filt_ht = filt_height * in_depth >> 5;			// must be >= 1
-	int filt_wid = filt_width*4-1;				// inner loop count
+	int filt_wid = filt_width*4;				// inner loop count: the asm's loop0 of 4*filt_width-1, plus its pipelined first and last pair
 
 	int in_width_4 = in_width *4;
 
@@ -142,7 +142,7 @@ void HVX_INTRINSIC_REFFUNC(gvconv2dbbb_v60_asm)(
 
 			// loop over filter height
 
-			for(int i = 0; i < filt_ht-1; i++ ){
+			for(int i = 0; i < filt_ht; i++ ){
 				const uint64_t * ptr_x1 = ptr_x0;
 				ptr_x0 += in_width_4;		  // move down rows ...
 				x27x24_x23x20 = ptr_x1[stride_w4*2];
@@ -173,28 +173,18 @@ void HVX_INTRINSIC_REFFUNC(gvconv2dbbb_v60_asm)(
 					x27x24_x23x20 = ptr_x1[stride_w4*2];
 					x37x34_x33x30 = ptr_x1[stride_w4*3];
 				}
-			}
-			{
-				// this below is a simple unpeel of last loop iteration; other than the preload
-				// from ptr_x1 ( which is more intricate in the asm) it could be done
-				// by 1 more iteration of the iloop
-				const uint64_t * ptr_x1 = ptr_x0;
-				ptr_x0 += in_width_4;
-				for(int j = 0; j< filt_wid;j++){
-					w0 = *ptr_w++;
-					w1 = *ptr_w++;
-					x17x14_x13x10 = ptr_x1[stride_w4];
-					x07x04_x03x00 = ptr_x1[0];
-					s0 = q6op_Vuw_vrmpyacc_VuwVubVubPub( s0, w1, w0, x07x04_x03x00);
-					s1 = q6op_Vuw_vrmpyacc_VuwVubVubPub( s1, w1, w0, x17x14_x13x10);
-					s2 = q6op_Vuw_vrmpyacc_VuwVubVubPub( s2, w1, w0, x27x24_x23x20);
-					s3 = q6op_Vuw_vrmpyacc_VuwVubVubPub( s3, w1, w0, x37x34_x33x30);
-				}
 			} //endloop1
 
 			// correct for advance of ptr_x0 down rows; and move right by 4*stride_w*32 bytes
 			ptr_x0 -= next_outputs;
 
+			// the asm does the << at .L_do_zshift, before the min/max
+			if(zshift>0){
+				s0 = Q6_Vw_vasl_VwR( s0, zshift);
+				s1 = Q6_Vw_vasl_VwR( s1, zshift);
+				s2 = Q6_Vw_vasl_VwR( s2, zshift);
+				s3 = Q6_Vw_vasl_VwR( s3, zshift);
+			}
 			// find min/max (excluding right-hand columns in the padding margin)
 			min_val = Q6_Vw_vmin_VwVw( min_val, s0);
 			max_val = Q6_Vw_vmax_VwVw( max_val, s0);
@@ -213,21 +203,14 @@ void HVX_INTRINSIC_REFFUNC(gvconv2dbbb_v60_asm)(
 
 			// scale and reduce to 128 bytes
 			HVX_Vector y0,y1,y2,y3, y0123;
-			if(zshift>0){
-				s0 = Q6_Vw_vasl_VwR( s0, zshift);
-				s1 = Q6_Vw_vasl_VwR( s1, zshift);
-				s2 = Q6_Vw_vasl_VwR( s2, zshift);
-				s3 = Q6_Vw_vasl_VwR( s3, zshift);
-			}
-
 
 			y0 = q6op_Vw_vmpy_VwVw_s1_rnd_sat( s0, recipvec);
 			y1 = q6op_Vw_vmpy_VwVw_s1_rnd_sat( s1, recipvec);
 			y2 = q6op_Vw_vmpy_VwVw_s1_rnd_sat( s2, recipvec);
 			y3 = q6op_Vw_vmpy_VwVw_s1_rnd_sat( s3, recipvec);
 
-			y3 = Q6_Vh_vpacke_VwVw( y3, y2);	// take upper 16 bits.
-			y1 = Q6_Vh_vpacke_VwVw( y1, y0);
+			y3 = Q6_Vh_vpack_VwVw_sat( y3, y2);	// sat to 16 bits (vpack(y3.w,y2.w):sat in the asm)
+			y1 = Q6_Vh_vpack_VwVw_sat( y1, y0);
 			y0123 = Q6_Vub_vpack_VhVh_sat( y3, y1);	// sat to u8
 
 			/// store result
@@ -239,16 +222,12 @@ void HVX_INTRINSIC_REFFUNC(gvconv2dbbb_v60_asm)(
 	}// for irow
 
 	// scale the min/max according to scales
-	min_val = Q6_Vw_vasl_VwR( min_val, zshift);
-	max_val = Q6_Vw_vasl_VwR( max_val, zshift);
+	// (no << by zshift here; they were reduced from the values taken after the <<)
 	min_val = q6op_Vw_vmpy_VwVw_s1_rnd_sat( min_val, recipvec);
 	max_val = q6op_Vw_vmpy_VwVw_s1_rnd_sat( max_val, recipvec);
-	// to accomodate -ve scales:
-	HVX_Vector vmin = Q6_Vw_vmin_VwVw( min_val, max_val);
-	HVX_Vector vmax = Q6_Vw_vmax_VwVw( min_val, max_val);
 	// combine with previous min/max
-	min_val = Q6_Vw_vmin_VwVw(vmin, ((HVX_Vector *)minmax_buf)[1]);
-	max_val = Q6_Vw_vmax_VwVw(vmax, ((HVX_Vector *)minmax_buf)[0]);
+	min_val = Q6_Vw_vmin_VwVw(min_val, ((HVX_Vector *)minmax_buf)[1]);
+	max_val = Q6_Vw_vmax_VwVw(max_val, ((HVX_Vector *)minmax_buf)[0]);
 
 
 	((HVX_Vector *)minmax_buf)[0] = max_val;
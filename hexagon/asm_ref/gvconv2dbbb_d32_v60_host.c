@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include "gvconv_d32_acc_host.h"
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+/*
+ *  FUNCTIONS      : gvconv2dbbb_v60_asm (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacement for asm_src/gvconv2dbbb_d32_v60_h.S, bit-exact with the asm.
+ *    u8 x u8 products are summed in 32 bits (mod 2^32, as vrmpy does) and
+ *    requantized with the same vmpye/vmpyo <<1:rnd:sat sequence, then saturated
+ *    to 16 and 8 bits; min/max are taken on the sums after the << by zshift.
+ *
+ *    The inner product (AVX2, NEON udot or plain C) is in gvconv_d32_acc_host.h.
+ *
+ *    asm_ref/gvconv2dbbb_d32_v60_h.c is the intrinsic form of the same kernel; build one or
+ *    the other.
+ */
+
+static inline uint8_t sat_h_ub(int32_t y)
+{
+	int32_t h = (y > 32767) ? 32767 : (y < -32768) ? -32768 : y;
+	return (h > 255) ? 255 : (h < 0) ? 0 : h;
+}
+
+void HVX_INTRINSIC_REFFUNC(gvconv2dbbb_v60_asm)(
+		const uint8_t *input,
+		const uint8_t *weights,
+		uint8_t *output,
+		int32_t in_width,
+		int32_t out_next_row,
+		int32_t out_width,				// >= 1
+		int32_t stride_height_width,
+		int32_t in_depth,
+		int32_t filt_width,
+		int32_t filt_height,
+		int32_t num_lines,
+		const int32_t *biasbuf,
+		const int32_t *suma,
+		int32_t next_suma,
+		int32_t *minmax_buf,
+		uint32_t const *recip_vals,		// points to 32 scales.
+		int32_t zshift)
+{
+	int32_t stride_w = (uint16_t)stride_height_width;
+	int32_t stride_h = (uint32_t)stride_height_width >> 16;
+	int32_t filt_ht = filt_height * in_depth >> 5;			// must be >= 1
+	int32_t filt_wid = filt_width * 4;
+	int32_t in_width_32 = in_width * 32;
+	int32_t in_width_stride_depth = in_width * in_depth * stride_h;
+	int32_t maxe[32], mine[32];
+
+	for (int o = 0; o < 32; o++) {
+		maxe[o] = -0x7fffffff;
+		mine[o] = 0x7fffffff;
+	}
+	for (int irow = 0; irow < num_lines; irow++) {
+		const uint8_t *in_row = input + irow * in_width_stride_depth;
+		const int32_t *sumabuf = (const int32_t *)((const char *)suma + irow * next_suma);
+		uint8_t *ptr_z = output + irow * out_next_row;
+
+		for (int col = 0; col < out_width; col += 4, ptr_z += 128) {
+			uint32_t acc[4][32];
+			const uint8_t *xs[4];
+			int ncols = (out_width - col < 4) ? (out_width - col) : 4;
+
+			for (int s = 0; s < 4; s++) {
+				int32_t sum = sumabuf[(col + s) * stride_w];
+				xs[s] = in_row + (col + s) * stride_w * 32;
+				for (int o = 0; o < 32; o++) acc[s][o] = (uint32_t)biasbuf[o] + (uint32_t)sum;
+			}
+			for (int d0 = 0; d0 < 32; d0 += 8) {
+				conv_d32_acc8(acc, d0, weights, xs, filt_ht, in_width_32, filt_wid);
+			}
+			for (int s = 0; s < 4; s++) {
+				for (int o = 0; o < 32; o++) {
+					int32_t v = (int32_t)acc[s][o];
+					if (zshift > 0) v = (int32_t)((uint32_t)v << (zshift & 31));
+					if (s < ncols) {
+						maxe[o] = (v > maxe[o]) ? v : maxe[o];
+						mine[o] = (v < mine[o]) ? v : mine[o];
+					}
+					ptr_z[32 * s + o] = sat_h_ub(mpy_s1_rnd_sat(v, (int32_t)recip_vals[o]));
+				}
+			}
+		}
+	}
+	for (int o = 0; o < 32; o++) {
+		int32_t ymax = mpy_s1_rnd_sat(maxe[o], (int32_t)recip_vals[o]);
+		int32_t ymin = mpy_s1_rnd_sat(mine[o], (int32_t)recip_vals[o]);
+		minmax_buf[o] = (ymax > minmax_buf[o]) ? ymax : minmax_buf[o];
+		minmax_buf[32 + o] = (ymin < minmax_buf[32 + o]) ? ymin : minmax_buf[32 + o];
+	}
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Shared by the host versions of the d32 conv kernels.
+ *
+ * conv_d32_acc8: u8 weights x u8 activations, 8 output depths x 4 output columns at a time,
+ * summed mod 2^32 as vrmpy does.
+ *   AVX2:         weights split into even/odd bytes as 16-bit lanes, vpmaddwd against
+ *                 the broadcast activations (exact; vpmaddubsw / VNNI vpdpbusd would
+ *                 treat the u8 weights as signed).
+ *   NEON dotprod: udot, which is vrmpy with a 4-byte scalar operand.
+ *   otherwise:    plain C.
+ * mpy_s1_rnd_sat: the requantize multiply.
+ */
+#ifndef GVCONV_D32_ACC_HOST_H
+#define GVCONV_D32_ACC_HOST_H 1
+
+#include <stdint.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__ARM_FEATURE_DOTPROD)
+#include <arm_neon.h>
+#endif
+
+// accumulate output depths d0..d0+7 of the four columns at xs[0..3] into acc[0..3][d0..d0+7]
+static inline void conv_d32_acc8(
+		uint32_t acc[4][32],
+		int d0,
+		const uint8_t *wp,
+		const uint8_t * const xs[4],
+		int32_t filt_ht,
+		int32_t in_width_32,
+		int32_t filt_wid)
+{
+	wp += 4 * d0;
+#if defined(__AVX2__)
+	const __m256i m00ff = _mm256_set1_epi16(0xFF);
+	const __m256i sel_e0 = _mm256_set1_epi32(0x80028000);
+	const __m256i sel_o0 = _mm256_set1_epi32(0x80038001);
+	const __m256i sel_e1 = _mm256_set1_epi32(0x80068004);
+	const __m256i sel_o1 = _mm256_set1_epi32(0x80078005);
+	__m256i a[4];
+	for (int s = 0; s < 4; s++) a[s] = _mm256_loadu_si256((__m256i const *)&acc[s][d0]);
+	for (int i = 0; i < filt_ht; i++) {
+		int32_t roff = i * in_width_32;
+		for (int j = 0; j < filt_wid; j++, wp += 256) {
+			__m256i w0 = _mm256_loadu_si256((__m256i const *)wp);
+			__m256i w1 = _mm256_loadu_si256((__m256i const *)(wp + 128));
+			__m256i w0e = _mm256_and_si256(w0, m00ff);
+			__m256i w0o = _mm256_srli_epi16(w0, 8);
+			__m256i w1e = _mm256_and_si256(w1, m00ff);
+			__m256i w1o = _mm256_srli_epi16(w1, 8);
+			for (int s = 0; s < 4; s++) {
+				int64_t x8;
+				memcpy(&x8, xs[s] + roff + 8 * j, 8);
+				__m256i bx = _mm256_set1_epi64x(x8);
+				__m256i p0 = _mm256_add_epi32(
+					_mm256_madd_epi16(w0e, _mm256_shuffle_epi8(bx, sel_e0)),
+					_mm256_madd_epi16(w0o, _mm256_shuffle_epi8(bx, sel_o0)));
+				__m256i p1 = _mm256_add_epi32(
+					_mm256_madd_epi16(w1e, _mm256_shuffle_epi8(bx, sel_e1)),
+					_mm256_madd_epi16(w1o, _mm256_shuffle_epi8(bx, sel_o1)));
+				a[s] = _mm256_add_epi32(a[s], _mm256_add_epi32(p0, p1));
+			}
+		}
+	}
+	for (int s = 0; s < 4; s++) _mm256_storeu_si256((__m256i *)&acc[s][d0], a[s]);
+#elif defined(__ARM_NEON) && defined(__ARM_FEATURE_DOTPROD)
+	uint32x4_t a[4][2];
+	for (int s = 0; s < 4; s++) {
+		a[s][0] = vld1q_u32(&acc[s][d0]);
+		a[s][1] = vld1q_u32(&acc[s][d0 + 4]);
+	}
+	for (int i = 0; i < filt_ht; i++) {
+		int32_t roff = i * in_width_32;
+		for (int j = 0; j < filt_wid; j++, wp += 256) {
+			uint8x16_t w0a = vld1q_u8(wp), w0b = vld1q_u8(wp + 16);
+			uint8x16_t w1a = vld1q_u8(wp + 128), w1b = vld1q_u8(wp + 144);
+			for (int s = 0; s < 4; s++) {
+				uint32_t x4[2];
+				memcpy(x4, xs[s] + roff + 8 * j, 8);
+				uint8x16_t xlo = vreinterpretq_u8_u32(vdupq_n_u32(x4[0]));
+				uint8x16_t xhi = vreinterpretq_u8_u32(vdupq_n_u32(x4[1]));
+				a[s][0] = vdotq_u32(vdotq_u32(a[s][0], w0a, xlo), w1a, xhi);
+				a[s][1] = vdotq_u32(vdotq_u32(a[s][1], w0b, xlo), w1b, xhi);
+			}
+		}
+	}
+	for (int s = 0; s < 4; s++) {
+		vst1q_u32(&acc[s][d0], a[s][0]);
+		vst1q_u32(&acc[s][d0 + 4], a[s][1]);
+	}
+#else
+	for (int i = 0; i < filt_ht; i++) {
+		int32_t roff = i * in_width_32;
+		for (int j = 0; j < filt_wid; j++, wp += 256) {
+			for (int s = 0; s < 4; s++) {
+				const uint8_t *x = xs[s] + roff + 8 * j;
+				for (int o = 0; o < 8; o++) {
+					const uint8_t *w0 = wp + 4 * o;
+					const uint8_t *w1 = wp + 128 + 4 * o;
+					acc[s][d0 + o] += (uint32_t)(w0[0] * x[0] + w0[1] * x[1] + w0[2] * x[2] + w0[3] * x[3])
+						+ (uint32_t)(w1[0] * x[4] + w1[1] * x[5] + w1[2] * x[6] + w1[3] * x[7]);
+				}
+			}
+		}
+	}
+#endif
+}
+
+// vmpye(s, r.uh) followed by vmpyo(s, r.h):<<1:rnd:sat:shift accumulate
+static inline int32_t mpy_s1_rnd_sat(int32_t s, int32_t r)
+{
+	int64_t p = (((int64_t)s * (uint16_t)r) >> 16) + (int64_t)s * (r >> 16);
+	p = (p * 2 + 0x8000) >> 16;
+	return (p > INT32_MAX) ? INT32_MAX : (p < INT32_MIN) ? INT32_MIN : (int32_t)p;
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+/*
+ *  FUNCTIONS      : gvint_asm (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacement for asm_src/gvint_h.S. Each d32 pixel is collapsed to
+ *    filt_offset * sum(depth) (filt_offset is used as a byte, as vsplatb does), 8 zero
+ *    columns are prepended, and the row is integrated horizontally and added to the
+ *    previous integral row (zero for the first row). 32*(integral_width/32) ints are
+ *    written per row, rows are integral_width ints apart. The first row of
+ *    scratch_128xW holds the collapsed row.
+ */
+
+void HVX_INTRINSIC_REFFUNC(gvint_asm)(
+	const uint8_t *in_data_d32,
+	int32_t *integral_out,
+	int32_t next_d32,
+	int32_t next_row,
+	int32_t integral_width,
+	int32_t in_depth,
+	int32_t out_height,
+	int32_t *scratch_128xW,
+	int32_t filt_offset)
+{
+	uint32_t zoff = (uint8_t)filt_offset;
+	int32_t nout = integral_width & ~31;
+	int32_t nd32 = in_depth >> 5;
+	uint32_t *rowsum = (uint32_t *)scratch_128xW;
+	uint32_t *out = (uint32_t *)integral_out;
+	const uint32_t *prev = NULL;
+
+	for (int r = 0; r < out_height; r++) {
+		const uint8_t *in_row = in_data_d32 + r * next_row;
+		for (int x = 0; x < 8 && x < nout; x++) rowsum[x] = 0;
+		for (int x = 8; x < nout; x++) {
+			const uint8_t *px = in_row + 32 * (x - 8);
+			uint32_t sum = 0;
+			for (int c = 0; c < nd32; c++) {
+				for (int k = 0; k < 32; k++) sum += px[k];
+				px += next_d32;
+			}
+			rowsum[x] = sum * zoff;
+		}
+		uint32_t run = 0;
+		if (prev == NULL) {
+			for (int x = 0; x < nout; x++) out[x] = (run += rowsum[x]);
+		} else {
+			for (int x = 0; x < nout; x++) out[x] = (run += rowsum[x]) + prev[x];
+		}
+		prev = out;
+		out += integral_width;
+	}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+/*
+ *  FUNCTIONS      : gvsuma_16b (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacement for asm_src/gvsuma_16b_h.S. Box sums of filt_width x filt_height
+ *    from the integral buffer, negated and scaled by the low halfword of filt_offset
+ *    with vmpye (>> 16):
+ *      suma[x] = ((D[x] - D[x+filt_width]) * (uint16_t)filt_offset) >> 16,
+ *      D = integral[bottom] - integral[top]
+ *    next_output_width (bytes) is the row pitch of both the integral and the output;
+ *    32*(in_width/32) values per output row, as the asm does (filt_width < 32).
+ */
+
+void HVX_INTRINSIC_REFFUNC(gvsuma_16b)(
+	const int32_t *integral,
+	int32_t *suma_out,
+	int32_t in_width,
+	int32_t next_output_width,
+	int32_t stride_height,
+	int32_t filt_width,
+	int32_t filt_height,
+	int32_t out_height,
+	int32_t filt_offset)
+{
+	int32_t pitch = next_output_width / (int32_t)sizeof(int32_t);
+	int32_t nout = in_width & ~31;
+	int64_t scale = (uint16_t)filt_offset;
+
+	for (int r = 0; r < out_height; r++) {
+		const uint32_t *top = (const uint32_t *)integral + r * stride_height * pitch;
+		const uint32_t *bot = top + filt_height * pitch;
+		int32_t *out = suma_out + r * pitch;
+		for (int x = 0; x < nout; x++) {
+			uint32_t left = bot[x] - top[x];
+			uint32_t right = bot[x + filt_width] - top[x + filt_width];
+			out[x] = (int32_t)(((int64_t)(int32_t)(left - right) * scale) >> 16);
+		}
+	}
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HVX_INTRINSIC_REFFUNC
+#define HVX_INTRINSIC_REFFUNC(f) f
+#endif
+/*
+ *  FUNCTIONS      : inconv2db2b2b2_v60_asm (host build)
+ *
+ *  DESCRIPTION
+ *    Host replacement for asm_src/inconv2db2b2b2_d32_v60_h.S, the 16-bit conv for
+ *    shallow inputs (4 bytes per pixel in each of the low/high byte planes). Per output
+ *      shl = 0x80 + wh*xl + wl*xh,  shh = bias + suma + wh*xh,  shh += shl >> 8
+ *    (the wl*xl term is dropped). Within a group of 4 outputs the columns are one pixel
+ *    apart; groups are 4*stride_w pixels apart. min/max are taken on shh of all four
+ *    columns of each group, combined with ptr_minmax, reduced across lanes and written
+ *    to all 32 lanes. Outputs are shh << recip_shift, requantized with recip and
+ *    saturated to u16; rows are 2*next_out_width bytes apart.
+ */
+
+// vmpye(s, r.uh) followed by vmpyo(s, r.h):<<1:rnd:sat:shift accumulate
+static inline int32_t mpy_s1_rnd_sat(int32_t s, int32_t r)
+{
+	int64_t p = (((int64_t)s * (uint16_t)r) >> 16) + (int64_t)s * (r >> 16);
+	p = (p * 2 + 0x8000) >> 16;
+	return (p > INT32_MAX) ? INT32_MAX : (p < INT32_MIN) ? INT32_MIN : (int32_t)p;
+}
+
+// vrmpy lane o: the 4 weight bytes of output depth o times 4 activation bytes
+static inline uint32_t vrmpy_lane(const uint8_t *w, int o, const uint8_t *x)
+{
+	w += 4 * o;
+	return (uint32_t)(w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3]);
+}
+
+void HVX_INTRINSIC_REFFUNC(inconv2db2b2b2_v60_asm)(
+	const uint8_t *in_bufe,
+	const uint8_t *in_bufo,
+	const uint8_t *weights,
+	uint16_t *out_bufe,
+	int next_in_width,
+	int next_out_width,
+	int out_width,
+	int stride_h_w,
+	int in_depth,
+	int filt_width,
+	int filt_height,
+	int out_height,
+	const int32_t *bias_add,
+	const int32_t *suma,
+	int32_t next_suma_row,
+	int32_t *ptr_minmax,
+	int32_t recip,
+	int recip_shift)
+{
+	int32_t stride_w = (uint16_t)stride_h_w;
+	int32_t stride_h = (int16_t)((uint32_t)stride_h_w >> 16);
+	int32_t row_bytes = next_in_width * in_depth;
+	int32_t maxv = -0x7fffffff, minv = 0x7fffffff;
+
+	for (int r = 0; r < out_height; r++) {
+		const uint8_t *rowe = in_bufe + r * row_bytes * stride_h;
+		const uint8_t *rowo = in_bufo + r * row_bytes * stride_h;
+		const int32_t *sumabuf = (const int32_t *)((const char *)suma + r * next_suma_row);
+		uint16_t *ptr_z = (uint16_t *)((uint8_t *)out_bufe + r * 2 * next_out_width);
+
+		for (int col = 0; col < out_width; col += 4, ptr_z += 128) {
+			for (int s = 0; s < 4; s++) {
+				int32_t xoff = col * stride_w * 4 + 4 * s;
+				uint32_t sum = (uint32_t)sumabuf[(col + s) * stride_w];
+				for (int o = 0; o < 32; o++) {
+					const uint8_t *w = weights;
+					uint32_t shl = 0x80;
+					uint32_t shh = (uint32_t)bias_add[o] + sum;
+					for (int fy = 0; fy < filt_height; fy++) {
+						const uint8_t *xl = rowe + fy * row_bytes + xoff;
+						const uint8_t *xh = rowo + fy * row_bytes + xoff;
+						for (int fx = 0; fx < filt_width; fx++, w += 256) {
+							shl += vrmpy_lane(w + 128, o, xl + 4 * fx) + vrmpy_lane(w, o, xh + 4 * fx);
+							shh += vrmpy_lane(w + 128, o, xh + 4 * fx);
+						}
+					}
+					int32_t v = (int32_t)(shh + (uint32_t)((int32_t)shl >> 8));
+					maxv = (v > maxv) ? v : maxv;
+					minv = (v < minv) ? v : minv;
+					int32_t y = mpy_s1_rnd_sat((int32_t)((uint32_t)v << (recip_shift & 31)), recip);
+					ptr_z[32 * s + o] = (y > 65535) ? 65535 : (y < 0) ? 0 : y;
+				}
+			}
+		}
+	}
+	for (int i = 0; i < 32; i++) {
+		maxv = (ptr_minmax[i] > maxv) ? ptr_minmax[i] : maxv;
+		minv = (ptr_minmax[32 + i] < minv) ? ptr_minmax[32 + i] : minv;
+	}
+	for (int i = 0; i < 32; i++) {
+		ptr_minmax[i] = maxv;
+		ptr_minmax[32 + i] = minv;
+	}
+}
@@ -67,8 +67,10 @@ q6op_Vuw_vrmpyacc_VuwVubVubPub( HVX_Vector vx, HVX_Vector vu1, HVX_Vector vu0, i
 //
 // output: num_out_lines x out_width * 32 of u8 (vector aligned).
 //
-// minmax_buf[0..31]: store the max value (32 copies in a vector)
-// minmax_buf[32..63]: store the min value (32 copies in a vector)
+// minmax_buf[0..31]: max of the sums, per output depth, scaled by recip_level and
+//                    combined with the previous contents
+// minmax_buf[32..63]: min, likewise
+// (the caller reduces them across depths with gvrmaxmin)
 //
 //** @@@ note: the reads of 'ptr_suma' are not compensated for vertical
 // stride; so next_suma would need to be, by caller
@@ -89,7 +91,8 @@ void HVX_INTRINSIC_REFFUNC(inconv2dbbb_v60_asm)(
 	const int32_t *biasbuf,
 	const int32_t *ptr_suma,
 	int next_suma,
-	int stride_height_width)	// v stride in upper 16; h stride in lower (h stride must be even)
+	int stride_height_width,	// v stride in upper 16; h stride in lower (h stride must be even)
+	int recip_shamt)			// sums are << recip_shamt before scaling, if > 0
 {
 	/*printf("strides = %X; in_depth = %d; in_width= %d, out_width = %d; next_suma =%d\n",
 			stride_height_width, in_depth, in_width_pad, out_width, next_suma);*/
@@ -110,7 +113,7 @@ void HVX_INTRINSIC_REFFUNC(inconv2dbbb_v60_asm)(
 	HVX_Vector recipvec = Q6_V_vsplat_R( recip_level );
 
 	HVX_Vector min_val = Q6_V_vsplat_R( 0x7FFFFFFF);
-	HVX_Vector max_val = Q6_Vw_vsub_VwVw(  Q6_V_vzero(), min_val);
+	HVX_Vector max_val = Q6_V_vnot_V( min_val);
 
 	HVX_Vector wsum = *(HVX_Vector const *)biasbuf;
 
@@ -177,10 +180,19 @@ void HVX_INTRINSIC_REFFUNC(inconv2dbbb_v60_asm)(
 
 			ptr_x0 = PTR_OFFSET( ptr_x0, int64_t const *,  -next_outputs);
 
+			if( recip_shamt != 0){
+				s0 = Q6_Vw_vasl_VwR( s0, recip_shamt);
+				s1 = Q6_Vw_vasl_VwR( s1, recip_shamt);
+				s2 = Q6_Vw_vasl_VwR( s2, recip_shamt);
+				s3 = Q6_Vw_vasl_VwR( s3, recip_shamt);
+			}
 			min_val = Q6_Vw_vmin_VwVw( min_val,
 					Q6_Vw_vmin_VwVw(Q6_Vw_vmin_VwVw(s0,s1),Q6_Vw_vmin_VwVw(s2,s3)));
+			// as the asm: when recip_shamt = 0 it takes max(maxe, s3) where max(maxo, s3)
+			// was meant, so s2 is left out of the max.
 			max_val = Q6_Vw_vmax_VwVw( max_val,
-					Q6_Vw_vmax_VwVw(Q6_Vw_vmax_VwVw(s0,s1),Q6_Vw_vmax_VwVw(s2,s3)));
+					Q6_Vw_vmax_VwVw(Q6_Vw_vmax_VwVw(s0,s1),
+						(recip_shamt != 0) ? Q6_Vw_vmax_VwVw(s2,s3) : s3));
 
 			HVX_Vector y0,y1,y2,y3;
 
@@ -189,23 +201,17 @@ void HVX_INTRINSIC_REFFUNC(inconv2dbbb_v60_asm)(
 			y2 = q6op_Vw_vmpy_VwVw_s1_rnd_sat( s2, recipvec);
 			y3 = q6op_Vw_vmpy_VwVw_s1_rnd_sat( s3, recipvec);
 
-			y3 = Q6_Vh_vpacke_VwVw( y3, y2);	// take upper 16 bits.
-			y1 = Q6_Vh_vpacke_VwVw( y1, y0);
+			y3 = Q6_Vh_vpack_VwVw_sat( y3, y2);	// sat to 16 bits
+			y1 = Q6_Vh_vpack_VwVw_sat( y1, y0);
 			*ptr_z ++ = Q6_Vub_vpack_VhVh_sat( y3, y1);	// sat to u8
 		} // for icol
 	} // for irow
-	// h. reduce the min/max values
+	// scale the min/max values and fold them into minmax_buf
 	//
-	int r= 4;
-	for( int i = 0; i < 5; i++){
-		HVX_VectorPair shuf = Q6_W_vshuff_VVR( min_val, min_val, r);
-		min_val = Q6_Vw_vmin_VwVw( Q6_V_hi_W(shuf), Q6_V_lo_W(shuf));
-		shuf =  Q6_W_vshuff_VVR( max_val, max_val, r);
-		max_val = Q6_Vw_vmax_VwVw( Q6_V_hi_W(shuf), Q6_V_lo_W(shuf));
-		r <<= 1;
-	}
-	((HVX_Vector *)minmax_buf)[0] = max_val;
-	((HVX_Vector *)minmax_buf)[1] = min_val;
+	max_val = q6op_Vw_vmpy_VwVw_s1_rnd_sat( max_val, recipvec);
+	min_val = q6op_Vw_vmpy_VwVw_s1_rnd_sat( min_val, recipvec);
+	((HVX_Vector *)minmax_buf)[0] = Q6_Vw_vmax_VwVw( ((HVX_Vector *)minmax_buf)[0], max_val);
+	((HVX_Vector *)minmax_buf)[1] = Q6_Vw_vmin_VwVw( ((HVX_Vector *)minmax_buf)[1], min_val);
 
 }
 
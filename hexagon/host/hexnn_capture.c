@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hexnn_capture.h"
+
+#ifndef __hexagon__
+#include <pthread.h>
+static pthread_mutex_t capture_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define capture_mutex_lock() pthread_mutex_lock(&capture_mutex)
+#define capture_mutex_unlock() pthread_mutex_unlock(&capture_mutex)
+#else
+// graph_app on the simulator is single-threaded
+#define capture_mutex_lock() /* NOTHING */
+#define capture_mutex_unlock() /* NOTHING */
+#endif
+
+static FILE *capture_file;
+static uint64_t capture_t0;
+static int capture_env_checked;
+
+static uint64_t capture_usecs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static int put_u32(uint32_t val)
+{
+	uint8_t b[4] = { val, val >> 8, val >> 16, val >> 24 };
+	return fwrite(b,1,4,capture_file) == 4 ? 0 : -1;
+}
+
+static int put_padded(const void *data, uint32_t len)
+{
+	static const uint8_t zeros[4];
+	if (len && fwrite(data,1,len,capture_file) != len) return -1;
+	if ((len & 3) && fwrite(zeros,1,4-(len&3),capture_file) != 4-(len&3)) return -1;
+	return 0;
+}
+
+static int put_record_header(uint32_t type, uint32_t graph_id, uint32_t payload_len)
+{
+	uint64_t t = capture_usecs() - capture_t0;
+	if (put_u32(type)) return -1;
+	if (put_u32(graph_id)) return -1;
+	if (put_u32((uint32_t)t)) return -1;
+	if (put_u32((uint32_t)(t >> 32))) return -1;
+	return put_u32(payload_len);
+}
+
+static inline uint32_t padded_len(uint32_t len) { return (len + 3) & ~3u; }
+
+static int capture_open_locked(const char *filename)
+{
+	if (capture_file) fclose(capture_file);
+	if ((capture_file = fopen(filename,"wb")) == NULL) {
+		printf("hexnn_capture: can't open %s\n",filename);
+		return -1;
+	}
+	capture_t0 = capture_usecs();
+	if (put_u32(HEXNN_CAPTURE_MAGIC) || put_u32(HEXNN_CAPTURE_VERSION)) {
+		fclose(capture_file);
+		capture_file = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+// lock, and open the file named by HEXAGON_NN_CAPTURE on first use. Returns with the lock held.
+static void capture_lock()
+{
+	const char *fn;
+	capture_mutex_lock();
+	if (!capture_env_checked) {
+		capture_env_checked = 1;
+		if (capture_file == NULL && (fn = getenv("HEXAGON_NN_CAPTURE")) != NULL && fn[0]) {
+			capture_open_locked(fn);
+		}
+	}
+}
+
+int hexnn_capture_open(const char *filename)
+{
+	int ret;
+	capture_mutex_lock();
+	capture_env_checked = 1;
+	ret = capture_open_locked(filename);
+	capture_mutex_unlock();
+	return ret;
+}
+
+void hexnn_capture_close(void)
+{
+	capture_mutex_lock();
+	if (capture_file) fclose(capture_file);
+	capture_file = NULL;
+	capture_mutex_unlock();
+}
+
+void hexnn_capture_option(hexagon_nn_nn_id id, const char *name, int value)
+{
+	uint32_t namelen = strlen(name) + 1;
+	capture_lock();
+	if (capture_file) {
+		if (put_record_header(HEXNN_CAPTURE_OPTION,id,4 + padded_len(namelen))
+		 || put_u32(value)
+		 || put_padded(name,namelen)) {
+			printf("hexnn_capture: write failed, capture stopped\n");
+			fclose(capture_file);
+			capture_file = NULL;
+		}
+	}
+	capture_mutex_unlock();
+}
+
+void hexnn_capture_execute(hexagon_nn_nn_id id,
+	const hexagon_nn_tensordef *inputs, int n_inputs,
+	const hexagon_nn_tensordef *outputs, int n_outputs)
+{
+	uint32_t payload_len = 8 + n_outputs * 20;
+	int err = 0;
+	int i;
+	capture_lock();
+	if (capture_file == NULL) goto done;
+	for (i = 0; i < n_inputs; i++) payload_len += 20 + padded_len(inputs[i].data_valid_len);
+	err |= put_record_header(HEXNN_CAPTURE_EXECUTE,id,payload_len);
+	err |= put_u32(n_inputs);
+	err |= put_u32(n_outputs);
+	for (i = 0; i < n_outputs; i++) {
+		err |= put_u32(outputs[i].batches);
+		err |= put_u32(outputs[i].height);
+		err |= put_u32(outputs[i].width);
+		err |= put_u32(outputs[i].depth);
+		err |= put_u32(outputs[i].dataLen);
+	}
+	for (i = 0; i < n_inputs; i++) {
+		err |= put_u32(inputs[i].batches);
+		err |= put_u32(inputs[i].height);
+		err |= put_u32(inputs[i].width);
+		err |= put_u32(inputs[i].depth);
+		err |= put_u32(inputs[i].data_valid_len);
+		err |= put_padded(inputs[i].data,inputs[i].data_valid_len);
+	}
+	if (err) {
+		printf("hexnn_capture: write failed, capture stopped\n");
+		fclose(capture_file);
+		capture_file = NULL;
+	}
+done:
+	capture_mutex_unlock();
+}
+
+void hexnn_capture_execute_flat(hexagon_nn_nn_id id,
+	unsigned int batches, unsigned int height, unsigned int width, unsigned int depth,
+	const unsigned char *data_in, int data_inLen, int data_outLen)
+{
+	hexagon_nn_tensordef in;
+	hexagon_nn_tensordef out;
+	int active;
+	capture_lock();
+	active = capture_file != NULL;
+	capture_mutex_unlock();
+	if (!active) return;
+	memset(&in,0,sizeof(in));
+	memset(&out,0,sizeof(out));
+	in.batches = batches;
+	in.height = height;
+	in.width = width;
+	in.depth = depth;
+	in.data = (unsigned char *)data_in;
+	in.dataLen = data_inLen;
+	in.data_valid_len = data_inLen;
+	out.dataLen = data_outLen;
+	hexnn_capture_execute(id,&in,1,&out,1);
+}
+
+/*
+ * Reader
+ */
+
+static uint32_t get_u32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+FILE *hexnn_capture_reader_open(const char *filename)
+{
+	uint8_t hdr[8];
+	FILE *f;
+	if ((f = fopen(filename,"rb")) == NULL) return NULL;
+	if (fread(hdr,1,8,f) != 8
+	 || get_u32(hdr) != HEXNN_CAPTURE_MAGIC
+	 || get_u32(hdr+4) != HEXNN_CAPTURE_VERSION) {
+		fclose(f);
+		return NULL;
+	}
+	return f;
+}
+
+int hexnn_capture_read(FILE *f, struct hexnn_capture_record *rec)
+{
+	uint8_t hdr[20];
+	uint32_t len;
+	uint32_t pos;
+	const uint8_t *p;
+	int i;
+	size_t got;
+
+	if ((got = fread(hdr,1,20,f)) == 0) return 0;
+	if (got != 20) return -1;
+	rec->type = get_u32(hdr);
+	rec->graph_id = get_u32(hdr+4);
+	rec->t_usec = get_u32(hdr+8) | ((uint64_t)get_u32(hdr+12) << 32);
+	len = get_u32(hdr+16);
+	if (len > rec->payload_alloc) {
+		uint8_t *np;
+		if ((np = realloc(rec->payload,len)) == NULL) return -1;
+		rec->payload = np;
+		rec->payload_alloc = len;
+	}
+	if (fread(rec->payload,1,len,f) != len) return -1;
+	p = rec->payload;
+	switch (rec->type) {
+	case HEXNN_CAPTURE_OPTION:
+		if (len < 5 || p[len-1] != 0) return -1;
+		rec->option_value = (int32_t)get_u32(p);
+		rec->option_name = (const char *)p + 4;
+		return 1;
+	case HEXNN_CAPTURE_EXECUTE:
+		if (len < 8) return -1;
+		rec->n_inputs = get_u32(p);
+		rec->n_outputs = get_u32(p+4);
+		if (rec->n_inputs > HEXNN_CAPTURE_MAX_TENSORS || rec->n_outputs > HEXNN_CAPTURE_MAX_TENSORS) return -1;
+		pos = 8;
+		for (i = 0; i < rec->n_outputs; i++) {
+			if (len - pos < 20) return -1;
+			memset(&rec->outputs[i],0,sizeof(rec->outputs[i]));
+			rec->outputs[i].batches = get_u32(p+pos);
+			rec->outputs[i].height = get_u32(p+pos+4);
+			rec->outputs[i].width = get_u32(p+pos+8);
+			rec->outputs[i].depth = get_u32(p+pos+12);
+			rec->outputs[i].dataLen = get_u32(p+pos+16);
+			pos += 20;
+		}
+		for (i = 0; i < rec->n_inputs; i++) {
+			uint32_t dlen;
+			if (len - pos < 20) return -1;
+			memset(&rec->inputs[i],0,sizeof(rec->inputs[i]));
+			rec->inputs[i].batches = get_u32(p+pos);
+			rec->inputs[i].height = get_u32(p+pos+4);
+			rec->inputs[i].width = get_u32(p+pos+8);
+			rec->inputs[i].depth = get_u32(p+pos+12);
+			dlen = get_u32(p+pos+16);
+			pos += 20;
+			// pos <= len here; compare against what's left, so a huge dlen can't wrap
+			if (dlen > len - pos || padded_len(dlen) > len - pos) return -1;
+			rec->inputs[i].data = rec->payload + pos;
+			rec->inputs[i].dataLen = dlen;
+			rec->inputs[i].data_valid_len = dlen;
+			pos += padded_len(dlen);
+		}
+		return 1;
+	default:
+		return 1;	// unknown record type; skipped by the caller
+	}
+}
+
+void hexnn_capture_record_free(struct hexnn_capture_record *rec)
+{
+	free(rec->payload);
+	rec->payload = NULL;
+	rec->payload_alloc = 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef HEXAGON_NN_HEXNN_CAPTURE_H
+#define HEXAGON_NN_HEXNN_CAPTURE_H
+
+/*
+ * Capture of execute requests, for replay with graph_app --replay.
+ *
+ * Setting HEXAGON_NN_CAPTURE=<file> in the environment makes the host API
+ * wrappers append every hexagon_nn_set_graph_option() and
+ * hexagon_nn_execute_new() / hexagon_nn_execute_with_info() call to <file>;
+ * applications can also call hexnn_capture_open() themselves.
+ *
+ * File format (all fields little-endian uint32 unless noted):
+ *   header:  magic HEXNN_CAPTURE_MAGIC, version HEXNN_CAPTURE_VERSION
+ *   records: type, graph_id, t_usec (uint64, since the capture was opened), payload_len, payload
+ *   OPTION payload:  value (int32), name (NUL-terminated, padded to 4 bytes)
+ *   EXECUTE payload: n_inputs, n_outputs,
+ *                    n_outputs x { batches, height, width, depth, dataLen },
+ *                    n_inputs x { batches, height, width, depth, data_valid_len, data (padded to 4 bytes) }
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "hexagon_nn.h"
+
+#define HEXNN_CAPTURE_MAGIC 0x434e4e48	// "HNNC"
+#define HEXNN_CAPTURE_VERSION 1
+
+enum hexnn_capture_type {
+	HEXNN_CAPTURE_OPTION = 1,
+	HEXNN_CAPTURE_EXECUTE = 2,
+};
+
+int hexnn_capture_open(const char *filename);
+void hexnn_capture_close(void);
+void hexnn_capture_option(hexagon_nn_nn_id id, const char *name, int value);
+void hexnn_capture_execute(hexagon_nn_nn_id id,
+	const hexagon_nn_tensordef *inputs, int n_inputs,
+	const hexagon_nn_tensordef *outputs, int n_outputs);
+// for hexagon_nn_execute(): recorded as one input and one output
+void hexnn_capture_execute_flat(hexagon_nn_nn_id id,
+	unsigned int batches, unsigned int height, unsigned int width, unsigned int depth,
+	const unsigned char *data_in, int data_inLen, int data_outLen);
+
+//
+// reading a capture
+//
+#define HEXNN_CAPTURE_MAX_TENSORS 64
+
+struct hexnn_capture_record {
+	uint32_t type;
+	uint32_t graph_id;
+	uint64_t t_usec;
+	// OPTION
+	int32_t option_value;
+	const char *option_name;
+	// EXECUTE; input data points into payload
+	uint32_t n_inputs;
+	uint32_t n_outputs;
+	hexagon_nn_tensordef inputs[HEXNN_CAPTURE_MAX_TENSORS];
+	hexagon_nn_tensordef outputs[HEXNN_CAPTURE_MAX_TENSORS];	// data is NULL
+	uint8_t *payload;
+	uint32_t payload_alloc;
+};
+
+// returns the file positioned at the first record, or NULL
+FILE *hexnn_capture_reader_open(const char *filename);
+// 1 = got a record, 0 = end of file, -1 = error. rec->payload is reused across calls.
+int hexnn_capture_read(FILE *f, struct hexnn_capture_record *rec);
+void hexnn_capture_record_free(struct hexnn_capture_record *rec);
+
+#endif // HEXAGON_NN_HEXNN_CAPTURE_H
@@ -34,6 +34,7 @@
  *
  */
 #include "hexnn_dsp_api.h"
+#include "hexnn_capture.h"
 
 
 __QAIC_STUB_EXPORT int hexagon_nn_config(void)
@@ -116,6 +117,7 @@ __QAIC_STUB_EXPORT int hexagon_nn_execute(hexagon_nn_nn_id id,
         unsigned int* height_out, unsigned int* width_out, unsigned int* depth_out, unsigned char* data_out,
         int data_outLen, unsigned int* data_len_out)
 {    
+    hexnn_capture_execute_flat(id, batches_in, height_in, width_in, depth_in, data_in, data_inLen, data_outLen);
     return hexagon_nn_execute_impl(id, batches_in, height_in, width_in, depth_in, data_in, data_inLen,
         batches_out, height_out, width_out, depth_out, data_out, data_outLen, data_len_out);
 }
@@ -161,6 +163,26 @@ __QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo(hexagon_nn_nn_id id, hexagon_nn_p
     return hexagon_nn_get_perfinfo_impl(id, info_out, info_outLen, n_items);
 }
 
+__QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo_traffic(hexagon_nn_nn_id id, hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items)
+{
+    return hexagon_nn_get_perfinfo_traffic_impl(id, info_out, info_outLen, n_items);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_get_trace(hexagon_nn_nn_id id, hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events)
+{
+    return hexagon_nn_get_trace_impl(id, events_out, events_outLen, n_events);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_get_tuning_db(hexagon_nn_nn_id id, hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records)
+{
+    return hexagon_nn_get_tuning_db_impl(id, records_out, records_outLen, n_records);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_set_tuning_db(hexagon_nn_nn_id id, const hexagon_nn_tuning_record* records, int recordsLen)
+{
+    return hexagon_nn_set_tuning_db_impl(id, records, recordsLen);
+}
+
 __QAIC_STUB_EXPORT int hexagon_nn_reset_perfinfo(hexagon_nn_nn_id id, unsigned int event)
 {
     return hexagon_nn_reset_perfinfo_impl(id, event);
@@ -209,12 +231,14 @@ __QAIC_STUB_EXPORT int hexagon_nn_PrintLog(const unsigned char* buf, int bufLen)
 __QAIC_STUB_EXPORT int hexagon_nn_execute_new(hexagon_nn_nn_id id,
         const hexagon_nn_tensordef* inputs, int inputsLen, hexagon_nn_tensordef* outputs, int outputsLen)
 {
+    hexnn_capture_execute(id, inputs, inputsLen, outputs, outputsLen);
     return hexagon_nn_execute_new_impl(id, inputs, inputsLen, outputs, outputsLen);
 }
 
 __QAIC_STUB_EXPORT int hexagon_nn_execute_with_info(hexagon_nn_nn_id id,
         const hexagon_nn_tensordef* inputs, int inputsLen, hexagon_nn_tensordef* outputs, int outputsLen, hexagon_nn_execute_info* execute_info)
 {
+    hexnn_capture_execute(id, inputs, inputsLen, outputs, outputsLen);
     return hexagon_nn_execute_with_info_impl(id, inputs, inputsLen, outputs, outputsLen, execute_info);
 }
 
@@ -240,5 +264,6 @@ __QAIC_STUB_EXPORT int hexagon_nn_get_power(int type)
 
 __QAIC_STUB_EXPORT int hexagon_nn_set_graph_option(hexagon_nn_nn_id id, const char* name, int value)
 {
+    hexnn_capture_option(id, name, value);
     return hexagon_nn_set_graph_option_impl(id, name, value);
 }
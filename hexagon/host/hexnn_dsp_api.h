@@ -84,6 +84,10 @@ __QAIC_STUB_EXPORT int hexagon_nn_variable_write_flat_impl(hexagon_nn_nn_id id,
 __QAIC_STUB_EXPORT int hexagon_nn_set_powersave_level_impl(unsigned int level);
 __QAIC_STUB_EXPORT int hexagon_nn_set_powersave_details_impl(hexagon_nn_corner_type corner, hexagon_nn_dcvs_type dcvs, unsigned int latency);
 __QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo_impl(hexagon_nn_nn_id id, hexagon_nn_perfinfo* info_out, int info_outLen, unsigned int* n_items);
+__QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo_traffic_impl(hexagon_nn_nn_id id, hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items);
+__QAIC_STUB_EXPORT int hexagon_nn_get_trace_impl(hexagon_nn_nn_id id, hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events);
+__QAIC_STUB_EXPORT int hexagon_nn_get_tuning_db_impl(hexagon_nn_nn_id id, hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records);
+__QAIC_STUB_EXPORT int hexagon_nn_set_tuning_db_impl(hexagon_nn_nn_id id, const hexagon_nn_tuning_record* records, int recordsLen);
 __QAIC_STUB_EXPORT int hexagon_nn_reset_perfinfo_impl(hexagon_nn_nn_id id, unsigned int event);
 __QAIC_STUB_EXPORT int hexagon_nn_last_execution_cycles_impl(hexagon_nn_nn_id id, unsigned int* cycles_lo, unsigned int* cycles_hi);
 __QAIC_STUB_EXPORT int hexagon_nn_version_impl(int* ver);
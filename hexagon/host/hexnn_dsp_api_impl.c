@@ -239,6 +239,26 @@ __QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo_impl(hexagon_nn_nn_id id, hexagon
     return(stub_hexagon_nn_get_perfinfo(id, info_out, info_outLen, n_items));
 }
 
+__QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo_traffic_impl(hexagon_nn_nn_id id, hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items)
+{
+    return(stub_hexagon_nn_get_perfinfo_traffic(id, info_out, info_outLen, n_items));
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_get_trace_impl(hexagon_nn_nn_id id, hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events)
+{
+    return(stub_hexagon_nn_get_trace(id, events_out, events_outLen, n_events));
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_get_tuning_db_impl(hexagon_nn_nn_id id, hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records)
+{
+    return(stub_hexagon_nn_get_tuning_db(id, records_out, records_outLen, n_records));
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_set_tuning_db_impl(hexagon_nn_nn_id id, const hexagon_nn_tuning_record* records, int recordsLen)
+{
+    return(stub_hexagon_nn_set_tuning_db(id, records, recordsLen));
+}
+
 __QAIC_STUB_EXPORT int hexagon_nn_reset_perfinfo_impl(hexagon_nn_nn_id id, unsigned int event)
 {
     return(stub_hexagon_nn_reset_perfinfo(id, event));
@@ -34,6 +34,7 @@
  *
  */
 #include "hexnn_dsp_domains_api.h"
+#include "hexnn_capture.h"
 
 __QAIC_STUB_EXPORT int hexagon_nn_domains_open(const char* uri, remote_handle64* h)
 {
@@ -124,6 +125,7 @@ __QAIC_STUB_EXPORT int hexagon_nn_domains_execute(remote_handle64 _h, hexagon_nn
         unsigned int* batches_out, unsigned int* height_out, unsigned int* width_out, unsigned int* depth_out,
         unsigned char* data_out, int data_outLen, unsigned int* data_len_out)
 {
+    hexnn_capture_execute_flat(id, batches_in, height_in, width_in, depth_in, data_in, data_inLen, data_outLen);
     return hexagon_nn_domains_execute_impl(_h, id, batches_in, height_in, width_in, depth_in, data_in, data_inLen,
             batches_out, height_out, width_out, depth_out, data_out, data_outLen, data_len_out);
 }
@@ -172,6 +174,30 @@ __QAIC_STUB_EXPORT int hexagon_nn_domains_get_perfinfo(remote_handle64 _h, hexag
     return hexagon_nn_domains_get_perfinfo_impl(_h, id, info_out, info_outLen, n_items);
 }
 
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_perfinfo_traffic(remote_handle64 _h, hexagon_nn_nn_id id,
+        hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items)
+{
+    return hexagon_nn_domains_get_perfinfo_traffic_impl(_h, id, info_out, info_outLen, n_items);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_trace(remote_handle64 _h, hexagon_nn_nn_id id,
+        hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events)
+{
+    return hexagon_nn_domains_get_trace_impl(_h, id, events_out, events_outLen, n_events);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_tuning_db(remote_handle64 _h, hexagon_nn_nn_id id,
+        hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records)
+{
+    return hexagon_nn_domains_get_tuning_db_impl(_h, id, records_out, records_outLen, n_records);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_set_tuning_db(remote_handle64 _h, hexagon_nn_nn_id id,
+        const hexagon_nn_tuning_record* records, int recordsLen)
+{
+    return hexagon_nn_domains_set_tuning_db_impl(_h, id, records, recordsLen);
+}
+
 __QAIC_STUB_EXPORT int hexagon_nn_domains_reset_perfinfo(remote_handle64 _h, hexagon_nn_nn_id id, unsigned int event)
 {
     return hexagon_nn_domains_reset_perfinfo_impl(_h, id, event);
@@ -221,12 +247,14 @@ __QAIC_STUB_EXPORT int hexagon_nn_domains_PrintLog(remote_handle64 _h, const uns
 __QAIC_STUB_EXPORT int hexagon_nn_domains_execute_new(remote_handle64 _h, hexagon_nn_nn_id id,
         const hexagon_nn_tensordef* inputs, int inputsLen, hexagon_nn_tensordef* outputs, int outputsLen)
 {
+    hexnn_capture_execute(id, inputs, inputsLen, outputs, outputsLen);
     return hexagon_nn_domains_execute_new_impl(_h, id, inputs, inputsLen, outputs, outputsLen);
 }
 
 __QAIC_STUB_EXPORT int hexagon_nn_domains_execute_with_info(remote_handle64 _h, hexagon_nn_nn_id id,
         const hexagon_nn_tensordef* inputs, int inputsLen, hexagon_nn_tensordef* outputs, int outputsLen, hexagon_nn_execute_info* execute_info)
 {
+    hexnn_capture_execute(id, inputs, inputsLen, outputs, outputsLen);
     return hexagon_nn_domains_execute_with_info_impl(_h, id, inputs, inputsLen, outputs, outputsLen, execute_info);
 }
 
@@ -252,5 +280,6 @@ __QAIC_STUB_EXPORT int hexagon_nn_domains_get_power(remote_handle64 _h, int type
 
 __QAIC_STUB_EXPORT int hexagon_nn_domains_set_graph_option(remote_handle64 _h, hexagon_nn_nn_id id, const char* name, int value)
 {
+    hexnn_capture_option(id, name, value);
     return hexagon_nn_domains_set_graph_option_impl(_h, id, name, value);
 }
@@ -246,6 +246,30 @@ __QAIC_STUB_EXPORT int hexagon_nn_domains_get_perfinfo_impl(remote_handle64 _h,
     return(stub_hexagon_nn_domains_get_perfinfo(_h, id, info_out, info_outLen, n_items));
 }
 
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_perfinfo_traffic_impl(remote_handle64 _h, hexagon_nn_nn_id id,
+        hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items)
+{
+    return(stub_hexagon_nn_domains_get_perfinfo_traffic(_h, id, info_out, info_outLen, n_items));
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_trace_impl(remote_handle64 _h, hexagon_nn_nn_id id,
+        hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events)
+{
+    return(stub_hexagon_nn_domains_get_trace(_h, id, events_out, events_outLen, n_events));
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_tuning_db_impl(remote_handle64 _h, hexagon_nn_nn_id id,
+        hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records)
+{
+    return(stub_hexagon_nn_domains_get_tuning_db(_h, id, records_out, records_outLen, n_records));
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_set_tuning_db_impl(remote_handle64 _h, hexagon_nn_nn_id id,
+        const hexagon_nn_tuning_record* records, int recordsLen)
+{
+    return(stub_hexagon_nn_domains_set_tuning_db(_h, id, records, recordsLen));
+}
+
 __QAIC_STUB_EXPORT int hexagon_nn_domains_reset_perfinfo_impl(remote_handle64 _h, hexagon_nn_nn_id id, unsigned int event)
 {
     return(stub_hexagon_nn_domains_reset_perfinfo(_h, id, event));
@@ -40,6 +40,7 @@
 #include "stdio.h"
 
 #include "hexnn_dsp_smart_wrapper_api.h"
+#include "hexnn_capture.h"
 
 #define select_stub_fn(domains_stub_fnptr, non_domains_stub_fnptr, h, ...) \
     (domains) ? (*domains_stub_fnptr)(h, ##__VA_ARGS__) : \
@@ -207,6 +208,7 @@ __QAIC_STUB_EXPORT int hexagon_nn_prepare(hexagon_nn_nn_id id)
 __QAIC_STUB_EXPORT int hexagon_nn_execute(hexagon_nn_nn_id id, unsigned int batches_in, unsigned int height_in, unsigned int width_in, unsigned int depth_in, const unsigned char* data_in, int data_inLen, unsigned int* batches_out, unsigned int* height_out, unsigned int* width_out, unsigned int* depth_out, unsigned char* data_out, int data_outLen, unsigned int* data_len_out)
 {
     CHECK_DOMAINS_AND_OPEN_HANDLE
+    hexnn_capture_execute_flat(id, batches_in, height_in, width_in, depth_in, data_in, data_inLen, data_outLen);
     return select_stub_fn(hexagon_nn_domains_execute_fnptr, hexagon_nn_execute_fnptr, h, id, batches_in, height_in, width_in, depth_in, data_in, data_inLen, batches_out, height_out, width_out, depth_out, data_out, data_outLen, data_len_out);
 }
 
@@ -252,6 +254,30 @@ __QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo(hexagon_nn_nn_id id, hexagon_nn_p
     return select_stub_fn(hexagon_nn_domains_get_perfinfo_fnptr, hexagon_nn_get_perfinfo_fnptr, h, id, info_out, info_outLen, n_items);
 }
 
+__QAIC_STUB_EXPORT int hexagon_nn_get_perfinfo_traffic(hexagon_nn_nn_id id, hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items)
+{
+    CHECK_DOMAINS_AND_OPEN_HANDLE
+    return select_stub_fn(hexagon_nn_domains_get_perfinfo_traffic_fnptr, hexagon_nn_get_perfinfo_traffic_fnptr, h, id, info_out, info_outLen, n_items);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_get_trace(hexagon_nn_nn_id id, hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events)
+{
+    CHECK_DOMAINS_AND_OPEN_HANDLE
+    return select_stub_fn(hexagon_nn_domains_get_trace_fnptr, hexagon_nn_get_trace_fnptr, h, id, events_out, events_outLen, n_events);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_get_tuning_db(hexagon_nn_nn_id id, hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records)
+{
+    CHECK_DOMAINS_AND_OPEN_HANDLE
+    return select_stub_fn(hexagon_nn_domains_get_tuning_db_fnptr, hexagon_nn_get_tuning_db_fnptr, h, id, records_out, records_outLen, n_records);
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_set_tuning_db(hexagon_nn_nn_id id, const hexagon_nn_tuning_record* records, int recordsLen)
+{
+    CHECK_DOMAINS_AND_OPEN_HANDLE
+    return select_stub_fn(hexagon_nn_domains_set_tuning_db_fnptr, hexagon_nn_set_tuning_db_fnptr, h, id, records, recordsLen);
+}
+
 __QAIC_STUB_EXPORT int hexagon_nn_reset_perfinfo(hexagon_nn_nn_id id, unsigned int event)
 {
     CHECK_DOMAINS_AND_OPEN_HANDLE
@@ -309,12 +335,14 @@ __QAIC_STUB_EXPORT int hexagon_nn_PrintLog(const unsigned char* buf, int bufLen)
 __QAIC_STUB_EXPORT int hexagon_nn_execute_new(hexagon_nn_nn_id id, const hexagon_nn_tensordef* inputs, int inputsLen, hexagon_nn_tensordef* outputs, int outputsLen)
 {
     CHECK_DOMAINS_AND_OPEN_HANDLE
+    hexnn_capture_execute(id, inputs, inputsLen, outputs, outputsLen);
     return select_stub_fn(hexagon_nn_domains_execute_new_fnptr, hexagon_nn_execute_new_fnptr, h, id, inputs, inputsLen, outputs, outputsLen);
 }
 
 __QAIC_STUB_EXPORT int hexagon_nn_execute_with_info(hexagon_nn_nn_id id, const hexagon_nn_tensordef* inputs, int inputsLen, hexagon_nn_tensordef* outputs, int outputsLen, hexagon_nn_execute_info* execute_info)
 {
     CHECK_DOMAINS_AND_OPEN_HANDLE
+    hexnn_capture_execute(id, inputs, inputsLen, outputs, outputsLen);
     return select_stub_fn(hexagon_nn_domains_execute_with_info_fnptr, hexagon_nn_execute_with_info_fnptr, h, id, inputs, inputsLen, outputs, outputsLen, execute_info);
 }
 
@@ -345,6 +373,7 @@ __QAIC_STUB_EXPORT int hexagon_nn_get_power(int type)
 __QAIC_STUB_EXPORT int hexagon_nn_set_graph_option(hexagon_nn_nn_id id, const char* name, int value)
 {
     CHECK_DOMAINS_AND_OPEN_HANDLE
+    hexnn_capture_option(id, name, value);
     return select_stub_fn(hexagon_nn_domains_set_graph_option_fnptr, hexagon_nn_set_graph_option_fnptr, h, id, name, value);
 }
 
@@ -453,6 +482,26 @@ __QAIC_STUB_EXPORT int hexagon_nn_domains_get_perfinfo(remote_handle64 _h, hexag
     return -1;
 }
 
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_perfinfo_traffic(remote_handle64 _h, hexagon_nn_nn_id id, hexagon_nn_perfinfo_traffic* info_out, int info_outLen, unsigned int* n_items)
+{
+    return -1;
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_trace(remote_handle64 _h, hexagon_nn_nn_id id, hexagon_nn_trace_event* events_out, int events_outLen, unsigned int* n_events)
+{
+    return -1;
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_get_tuning_db(remote_handle64 _h, hexagon_nn_nn_id id, hexagon_nn_tuning_record* records_out, int records_outLen, unsigned int* n_records)
+{
+    return -1;
+}
+
+__QAIC_STUB_EXPORT int hexagon_nn_domains_set_tuning_db(remote_handle64 _h, hexagon_nn_nn_id id, const hexagon_nn_tuning_record* records, int recordsLen)
+{
+    return -1;
+}
+
 __QAIC_STUB_EXPORT int hexagon_nn_domains_reset_perfinfo(remote_handle64 _h, hexagon_nn_nn_id id, unsigned int event)
 {
     return -1;
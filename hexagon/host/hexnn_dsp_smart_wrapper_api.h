@@ -67,6 +67,10 @@ __QAIC_STUB_EXPORT int (*hexagon_nn_variable_write_flat_fnptr)(hexagon_nn_nn_id,
 __QAIC_STUB_EXPORT int (*hexagon_nn_set_powersave_level_fnptr)(unsigned int) = &hexagon_nn_set_powersave_level_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_set_powersave_details_fnptr)(hexagon_nn_corner_type, hexagon_nn_dcvs_type, unsigned int) = &hexagon_nn_set_powersave_details_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_get_perfinfo_fnptr)(hexagon_nn_nn_id, hexagon_nn_perfinfo*, int, unsigned int*) = &hexagon_nn_get_perfinfo_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_get_perfinfo_traffic_fnptr)(hexagon_nn_nn_id, hexagon_nn_perfinfo_traffic*, int, unsigned int*) = &hexagon_nn_get_perfinfo_traffic_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_get_trace_fnptr)(hexagon_nn_nn_id, hexagon_nn_trace_event*, int, unsigned int*) = &hexagon_nn_get_trace_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_get_tuning_db_fnptr)(hexagon_nn_nn_id, hexagon_nn_tuning_record*, int, unsigned int*) = &hexagon_nn_get_tuning_db_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_set_tuning_db_fnptr)(hexagon_nn_nn_id, const hexagon_nn_tuning_record*, int) = &hexagon_nn_set_tuning_db_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_reset_perfinfo_fnptr)(hexagon_nn_nn_id, unsigned int) = &hexagon_nn_reset_perfinfo_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_last_execution_cycles_fnptr)(hexagon_nn_nn_id, unsigned int*, unsigned int*) = &hexagon_nn_last_execution_cycles_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_version_fnptr)(int*) = &hexagon_nn_version_impl;
@@ -105,6 +109,10 @@ __QAIC_STUB_EXPORT int (*hexagon_nn_domains_variable_write_flat_fnptr)(remote_ha
 __QAIC_STUB_EXPORT int (*hexagon_nn_domains_set_powersave_level_fnptr)(remote_handle64, unsigned int) = &hexagon_nn_domains_set_powersave_level_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_domains_set_powersave_details_fnptr)(remote_handle64, hexagon_nn_corner_type, hexagon_nn_dcvs_type, unsigned int) = &hexagon_nn_domains_set_powersave_details_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_domains_get_perfinfo_fnptr)(remote_handle64, hexagon_nn_nn_id, hexagon_nn_perfinfo*, int, unsigned int*) = &hexagon_nn_domains_get_perfinfo_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_domains_get_perfinfo_traffic_fnptr)(remote_handle64, hexagon_nn_nn_id, hexagon_nn_perfinfo_traffic*, int, unsigned int*) = &hexagon_nn_domains_get_perfinfo_traffic_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_domains_get_trace_fnptr)(remote_handle64, hexagon_nn_nn_id, hexagon_nn_trace_event*, int, unsigned int*) = &hexagon_nn_domains_get_trace_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_domains_get_tuning_db_fnptr)(remote_handle64, hexagon_nn_nn_id, hexagon_nn_tuning_record*, int, unsigned int*) = &hexagon_nn_domains_get_tuning_db_impl;
+__QAIC_STUB_EXPORT int (*hexagon_nn_domains_set_tuning_db_fnptr)(remote_handle64, hexagon_nn_nn_id, const hexagon_nn_tuning_record*, int) = &hexagon_nn_domains_set_tuning_db_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_domains_reset_perfinfo_fnptr)(remote_handle64, hexagon_nn_nn_id, unsigned int) = &hexagon_nn_domains_reset_perfinfo_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_domains_last_execution_cycles_fnptr)(remote_handle64, hexagon_nn_nn_id, unsigned int*, unsigned int*) = &hexagon_nn_domains_last_execution_cycles_impl;
 __QAIC_STUB_EXPORT int (*hexagon_nn_domains_version_fnptr)(remote_handle64, int*) = &hexagon_nn_domains_version_impl;
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * Host emulation of the scalar Hexagon intrinsics (Q6_R_*, Q6_P_*) used in the tree.
+ * See hvx_emul.h.
+ */
+
+#ifndef HVX_EMUL_HEXAGON_PROTOS_H
+#define HVX_EMUL_HEXAGON_PROTOS_H 1
+
+#include <math.h>
+#include "hvx_emul.h"
+
+////////////////////////////////////////////////////////
+// 32-bit
+////////////////////////////////////////////////////////
+
+static inline Word32 Q6_R_add_RR_sat(Word32 Rs, Word32 Rt) { return hvxe_sat32((int64_t)Rs + Rt); }
+
+// shift left by sxt7(Rt); negative is a right shift
+static inline Word32 Q6_R_asl_RR_sat(Word32 Rs, Word32 Rt)
+{
+	int32_t sh = hvxe_sxt(Rt, 7);
+	if (sh < 0) return (Word32)hvxe_asr64(Rs, -sh);
+	if (Rs == 0) return 0;
+	if (sh >= 32) return (Rs < 0) ? INT32_MIN : INT32_MAX;
+	return hvxe_sat32((int64_t)Rs << sh);
+}
+
+static inline Word32 Q6_R_asrh_R(Word32 Rs) { return Rs >> 16; }
+
+static inline Word32 Q6_R_asrrnd_RI(Word32 Rs, int u5)
+{
+	if (u5 == 0) return Rs;
+	return (Word32)((((int64_t)Rs >> (u5 - 1)) + 1) >> 1);
+}
+
+static inline Word32 Q6_R_cl0_R(Word32 Rs) { return hvxe_cl0_32(Rs); }
+static inline Word32 Q6_R_clb_R(Word32 Rs) { return hvxe_cl0_32((Rs < 0) ? ~(uint32_t)Rs : (uint32_t)Rs); }
+static inline Word32 Q6_R_ct0_R(Word32 Rs)
+{
+	uint32_t x = Rs;
+	int n = 0;
+	if (x == 0) return 32;
+	while (!(x & 1)) { x >>= 1; n++; }
+	return n;
+}
+static inline Word32 Q6_R_normamt_R(Word32 Rs) { return hvxe_normamt32(Rs); }
+
+static inline Word32 Q6_R_combine_RhRh(Word32 Rt, Word32 Rs) { return (Word32)(((uint32_t)Rt & 0xFFFF0000u) | ((uint32_t)Rs >> 16)); }
+static inline Word32 Q6_R_combine_RlRh(Word32 Rt, Word32 Rs) { return (Word32)(((uint32_t)Rt << 16) | ((uint32_t)Rs >> 16)); }
+static inline Word32 Q6_R_combine_RlRl(Word32 Rt, Word32 Rs) { return (Word32)(((uint32_t)Rt << 16) | ((uint32_t)Rs & 0xFFFFu)); }
+
+// round to nearest (even), saturating; NaN gives -1
+static inline Word32 Q6_R_convert_sf2w_R(float Rs)
+{
+	if (isnan(Rs)) return -1;
+	float r = nearbyintf(Rs);
+	if (r >= 2147483648.0f) return INT32_MAX;
+	if (r < -2147483648.0f) return INT32_MIN;
+	return (Word32)r;
+}
+
+// truncate, saturating to 0..0xFFFFFFFF; NaN gives 0xFFFFFFFF
+static inline UWord32 Q6_R_convert_sf2uw_R_chop(float Rs)
+{
+	if (isnan(Rs)) return UINT32_MAX;
+	if (Rs <= 0.0f) return 0;
+	if (Rs >= 4294967296.0f) return UINT32_MAX;
+	return (UWord32)Rs;
+}
+
+static inline Word32 Q6_R_max_RR(Word32 Rs, Word32 Rt) { return (Rs > Rt) ? Rs : Rt; }
+static inline Word32 Q6_R_min_RR(Word32 Rt, Word32 Rs) { return (Rt < Rs) ? Rt : Rs; }
+static inline UWord32 Q6_R_maxu_RR(UWord32 Rs, UWord32 Rt) { return (Rs > Rt) ? Rs : Rt; }
+static inline UWord32 Q6_R_minu_RR(UWord32 Rt, UWord32 Rs) { return (Rt < Rs) ? Rt : Rs; }
+
+static inline Word32 Q6_R_mpy_RlRl_s1_rnd_sat(Word32 Rs, Word32 Rt)
+{
+	return hvxe_sat32((((int64_t)(int16_t)Rs * (int16_t)Rt) << 1) + 0x8000);
+}
+static inline Word32 Q6_R_mpy_RlRl_sat(Word32 Rs, Word32 Rt) { return hvxe_sat32((int64_t)(int16_t)Rs * (int16_t)Rt); }
+static inline UWord32 Q6_R_mpyu_RR(UWord32 Rs, UWord32 Rt) { return (UWord32)(((uint64_t)Rs * Rt) >> 32); }
+static inline UWord32 Q6_R_mpyu_RhRl(UWord32 Rs, UWord32 Rt) { return (Rs >> 16) * (Rt & 0xFFFFu); }
+static inline UWord32 Q6_R_mpyuacc_RlRl(UWord32 Rx, UWord32 Rs, UWord32 Rt) { return Rx + (Rs & 0xFFFFu) * (Rt & 0xFFFFu); }
+
+static inline Word32 Q6_R_sath_R(Word32 Rs) { return hvxe_sat16(Rs); }
+static inline Word32 Q6_R_satub_R(Word32 Rs) { return hvxe_usat8(Rs); }
+static inline Word32 Q6_R_satuh_R(Word32 Rs) { return hvxe_usat16(Rs); }
+
+static inline float Q6_R_sfmpyacc_RR(float Rx, float Rs, float Rt) { return fmaf(Rs, Rt, Rx); }
+
+static inline Word32 Q6_R_swiz_R(Word32 Rs)
+{
+	uint32_t x = Rs;
+	return (Word32)((x >> 24) | ((x >> 8) & 0xFF00u) | ((x << 8) & 0xFF0000u) | (x << 24));
+}
+
+static inline Word32 Q6_R_vsplatb_R(Word32 Rs) { return (Word32)(((uint32_t)Rs & 0xFFu) * 0x01010101u); }
+static inline Word32 Q6_R_zxth_R(Word32 Rs) { return Rs & 0xFFFF; }
+
+// two halfwords
+#define HVXE_R_H2(NAME, EXPR) \
+static inline Word32 NAME(Word32 Rs, Word32 Rt) \
+{ \
+	uint32_t d = 0; \
+	for (int i = 0; i < 2; i++) { \
+		int32_t a = (int16_t)(Rs >> (16 * i)); \
+		int32_t b = (int16_t)(Rt >> (16 * i)); \
+		d |= ((uint32_t)(EXPR) & 0xFFFFu) << (16 * i); \
+	} \
+	return (Word32)d; \
+}
+HVXE_R_H2(Q6_R_vaddh_RR, a + b)
+HVXE_R_H2(Q6_R_vaddh_RR_sat, hvxe_sat16(a + b))
+HVXE_R_H2(Q6_R_vavgh_RR_rnd, (a + b + 1) >> 1)
+HVXE_R_H2(Q6_R_vnavgh_RR, (a - b) >> 1)
+HVXE_R_H2(Q6_R_vmpyh_RR_s1_rnd_sat, hvxe_sat16((((int64_t)a * b << 1) + 0x8000) >> 16))
+#undef HVXE_R_H2
+
+////////////////////////////////////////////////////////
+// 64-bit to 32-bit
+////////////////////////////////////////////////////////
+
+static inline Word32 Q6_R_popcount_P(Word64 Rss)
+{
+	uint64_t x = Rss;
+	int n = 0;
+	while (x) { x &= x - 1; n++; }
+	return n;
+}
+
+static inline Word32 Q6_R_sat_P(Word64 Rss) { return hvxe_sat32(Rss); }
+
+static inline Word32 Q6_R_vasrhub_PI_rnd_sat(Word64 Rss, int u4)
+{
+	uint32_t d = 0;
+	for (int i = 0; i < 4; i++) {
+		int32_t h = (int16_t)(Rss >> (16 * i));
+		int32_t v = (u4 == 0) ? h : (((h >> (u4 - 1)) + 1) >> 1);
+		d |= (uint32_t)hvxe_usat8(v) << (8 * i);
+	}
+	return (Word32)d;
+}
+
+static inline Word32 Q6_R_vrndwh_P_sat(Word64 Rss)
+{
+	uint32_t d = 0;
+	for (int i = 0; i < 2; i++) {
+		int32_t w = (int32_t)(Rss >> (32 * i));
+		d |= ((uint32_t)hvxe_sat32((int64_t)w + 0x8000) >> 16) << (16 * i);
+	}
+	return (Word32)d;
+}
+
+static inline Word32 Q6_R_vsathub_P(Word64 Rss)
+{
+	uint32_t d = 0;
+	for (int i = 0; i < 4; i++) d |= (uint32_t)hvxe_usat8((int16_t)(Rss >> (16 * i))) << (8 * i);
+	return (Word32)d;
+}
+
+static inline Word32 Q6_R_vsatwh_P(Word64 Rss)
+{
+	uint32_t d = 0;
+	for (int i = 0; i < 2; i++) d |= ((uint32_t)hvxe_sat16((int32_t)(Rss >> (32 * i))) & 0xFFFFu) << (16 * i);
+	return (Word32)d;
+}
+
+static inline Word32 Q6_R_vtrunohb_P(Word64 Rss)
+{
+	uint32_t d = 0;
+	for (int i = 0; i < 4; i++) d |= (uint32_t)(uint8_t)(Rss >> (16 * i + 8)) << (8 * i);
+	return (Word32)d;
+}
+
+////////////////////////////////////////////////////////
+// 64-bit
+////////////////////////////////////////////////////////
+
+static inline Word64 Q6_P_combine_RR(Word32 Rs, Word32 Rt) { return (Word64)(((uint64_t)(uint32_t)Rs << 32) | (uint32_t)Rt); }
+
+static inline Word64 Q6_P_asrrnd_PI(Word64 Rss, int u6)
+{
+	if (u6 == 0) return Rss;
+	return ((Rss >> (u6 - 1)) + 1) >> 1;
+}
+
+// round to nearest (even), saturating; NaN gives -1
+static inline Word64 Q6_P_convert_sf2d_R(float Rs)
+{
+	if (isnan(Rs)) return -1;
+	float r = nearbyintf(Rs);
+	if (r >= 9223372036854775808.0f) return INT64_MAX;
+	if (r < -9223372036854775808.0f) return INT64_MIN;
+	return (Word64)r;
+}
+
+// linear feedback shift: shift right by one, parity of (Rss & Rtt) in at the top
+static inline Word64 Q6_P_lfs_PP(Word64 Rss, Word64 Rtt)
+{
+	uint64_t par = (uint64_t)Q6_R_popcount_P(Rss & Rtt) & 1;
+	return (Word64)(((uint64_t)Rss >> 1) | (par << 63));
+}
+
+static inline Word64 Q6_P_max_PP(Word64 Rss, Word64 Rtt) { return (Rss > Rtt) ? Rss : Rtt; }
+static inline Word64 Q6_P_min_PP(Word64 Rtt, Word64 Rss) { return (Rtt < Rss) ? Rtt : Rss; }
+static inline UWord64 Q6_P_maxu_PP(UWord64 Rss, UWord64 Rtt) { return (Rss > Rtt) ? Rss : Rtt; }
+static inline UWord64 Q6_P_minu_PP(UWord64 Rtt, UWord64 Rss) { return (Rtt < Rss) ? Rtt : Rss; }
+
+static inline Word64 Q6_P_mpy_RR(Word32 Rs, Word32 Rt) { return (Word64)Rs * Rt; }
+
+// {Rss:Rtt} >> (8*Pu), low 64 bits
+static inline Word64 Q6_P_valignb_PPp(Word64 Rtt, Word64 Rss, int Pu)
+{
+	int sh = (Pu & 7) * 8;
+	if (sh == 0) return Rtt;
+	return (Word64)(((uint64_t)Rtt >> sh) | ((uint64_t)Rss << (64 - sh)));
+}
+
+static inline Word64 Q6_P_vmux_pPP(int Pu, Word64 Rss, Word64 Rtt)
+{
+	uint64_t m = 0;
+	for (int i = 0; i < 8; i++) if (Pu & (1 << i)) m |= (uint64_t)0xFF << (8 * i);
+	return (Word64)(((uint64_t)Rss & m) | ((uint64_t)Rtt & ~m));
+}
+
+// lane-wise on 64-bit registers
+#define HVXE_P_LANES(NAME, BITS, STYPE, EXPR) \
+static inline Word64 NAME(Word64 Rss, Word64 Rtt) \
+{ \
+	uint64_t d = 0; \
+	const uint64_t lmask = (BITS == 64) ? ~(uint64_t)0 : (((uint64_t)1 << BITS) - 1); \
+	for (int i = 0; i < 64 / BITS; i++) { \
+		int64_t a = (STYPE)(Rss >> (BITS * i)); \
+		int64_t b = (STYPE)(Rtt >> (BITS * i)); \
+		d |= ((uint64_t)(EXPR) & lmask) << (BITS * i); \
+	} \
+	return (Word64)d; \
+}
+HVXE_P_LANES(Q6_P_vaddh_PP_sat, 16, int16_t, hvxe_sat16(a + b))
+HVXE_P_LANES(Q6_P_vaddw_PP, 32, int32_t, a + b)
+HVXE_P_LANES(Q6_P_vaddw_PP_sat, 32, int32_t, hvxe_sat32(a + b))
+HVXE_P_LANES(Q6_P_vsubh_PP, 16, int16_t, a - b)
+HVXE_P_LANES(Q6_P_vavgub_PP, 8, uint8_t, (a + b) >> 1)
+HVXE_P_LANES(Q6_P_vavgub_PP_rnd, 8, uint8_t, (a + b + 1) >> 1)
+HVXE_P_LANES(Q6_P_vmaxub_PP, 8, uint8_t, (a > b) ? a : b)
+HVXE_P_LANES(Q6_P_vminub_PP, 8, uint8_t, (a < b) ? a : b)
+HVXE_P_LANES(Q6_P_vmaxw_PP, 32, int32_t, (a > b) ? a : b)
+#undef HVXE_P_LANES
+
+// shuffle even/odd bytes: result halfword i is { Rtt.h[i].b[n], Rss.h[i].b[n] }
+static inline Word64 Q6_P_shuffeb_PP(Word64 Rss, Word64 Rtt)
+{
+	uint64_t m = 0x00FF00FF00FF00FFull;
+	return (Word64)(((uint64_t)Rtt & m) | (((uint64_t)Rss & m) << 8));
+}
+static inline Word64 Q6_P_shuffob_PP(Word64 Rss, Word64 Rtt)
+{
+	uint64_t m = 0xFF00FF00FF00FF00ull;
+	return (Word64)(((uint64_t)Rss & m) | (((uint64_t)Rtt & m) >> 8));
+}
+
+static inline Word64 Q6_P_vasrh_PI_rnd(Word64 Rss, int u4)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 4; i++) {
+		int32_t h = (int16_t)(Rss >> (16 * i));
+		int32_t v = (u4 == 0) ? h : (((h >> (u4 - 1)) + 1) >> 1);
+		d |= ((uint64_t)v & 0xFFFFu) << (16 * i);
+	}
+	return (Word64)d;
+}
+
+static inline Word64 Q6_P_vasrw_PI(Word64 Rss, int u5)
+{
+	uint64_t lo = (uint32_t)((int32_t)Rss >> u5);
+	uint64_t hi = (uint32_t)((int32_t)(Rss >> 32) >> u5);
+	return (Word64)(lo | (hi << 32));
+}
+
+static inline Word64 Q6_P_vlsrh_PI(Word64 Rss, int u4)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 4; i++) d |= (uint64_t)(((uint16_t)(Rss >> (16 * i))) >> u4) << (16 * i);
+	return (Word64)d;
+}
+
+// Rxx.h[i] += Rs.b[i] * Rt.ub[i]
+static inline Word64 Q6_P_vmpybsuacc_RR(Word64 Rxx, Word32 Rs, Word32 Rt)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 4; i++) {
+		int32_t p = (int16_t)(Rxx >> (16 * i)) + (int8_t)(Rs >> (8 * i)) * (int32_t)(uint8_t)(Rt >> (8 * i));
+		d |= ((uint64_t)p & 0xFFFFu) << (16 * i);
+	}
+	return (Word64)d;
+}
+
+static inline Word64 Q6_P_vmpybu_RR(Word32 Rs, Word32 Rt)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 4; i++) d |= (uint64_t)((uint8_t)(Rs >> (8 * i)) * (uint8_t)(Rt >> (8 * i))) << (16 * i);
+	return (Word64)d;
+}
+
+static inline Word64 Q6_P_vmpyh_RR_sat(Word32 Rs, Word32 Rt)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 2; i++) {
+		int64_t p = (int64_t)(int16_t)(Rs >> (16 * i)) * (int16_t)(Rt >> (16 * i));
+		d |= (uint64_t)(uint32_t)hvxe_sat32(p) << (32 * i);
+	}
+	return (Word64)d;
+}
+
+static inline Word64 Q6_P_vmpyhacc_RR_sat(Word64 Rxx, Word32 Rs, Word32 Rt)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 2; i++) {
+		int64_t p = (int64_t)(int32_t)(Rxx >> (32 * i)) + (int64_t)(int16_t)(Rs >> (16 * i)) * (int16_t)(Rt >> (16 * i));
+		d |= (uint64_t)(uint32_t)hvxe_sat32(p) << (32 * i);
+	}
+	return (Word64)d;
+}
+
+static inline Word64 Q6_P_vmpyhsu_RR_sat(Word32 Rs, Word32 Rt)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 2; i++) {
+		int64_t p = (int64_t)(int16_t)(Rs >> (16 * i)) * (uint16_t)(Rt >> (16 * i));
+		d |= (uint64_t)(uint32_t)hvxe_sat32(p) << (32 * i);
+	}
+	return (Word64)d;
+}
+
+// Rxx.w[j] += sum of bytes 4j..4j+3 of Rss and of Rtt
+static inline Word64 Q6_P_vraddubacc_PP(Word64 Rxx, Word64 Rss, Word64 Rtt)
+{
+	uint32_t s[2];
+	for (int j = 0; j < 2; j++) {
+		s[j] = (uint32_t)(Rxx >> (32 * j));
+		for (int i = 4 * j; i < 4 * j + 4; i++) s[j] += (uint8_t)(Rss >> (8 * i)) + (uint8_t)(Rtt >> (8 * i));
+	}
+	return (Word64)((uint64_t)s[0] | ((uint64_t)s[1] << 32));
+}
+
+static inline Word64 Q6_P_vsxthw_R(Word32 Rs)
+{
+	return (Word64)(((uint64_t)(uint32_t)(int32_t)(int16_t)Rs) | ((uint64_t)(uint32_t)(Rs >> 16) << 32));
+}
+
+static inline Word64 Q6_P_vzxtbh_R(Word32 Rs)
+{
+	uint64_t d = 0;
+	for (int i = 0; i < 4; i++) d |= (uint64_t)(uint8_t)(Rs >> (8 * i)) << (16 * i);
+	return (Word64)d;
+}
+
+// cache hints do nothing here
+static inline void Q6_dcfetch_A(const void *A) { (void)A; }
+
+#endif // HVX_EMUL_HEXAGON_PROTOS_H
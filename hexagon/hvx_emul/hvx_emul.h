@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * Host emulation of HVX (128-byte mode): the vector types, and helpers shared by the
+ * intrinsic implementations in hvx_hexagon_protos.h.
+ *
+ * This directory stands in for the Hexagon tools' intrinsic headers when building off-target;
+ * put it on the include path ahead of hexagon/include, e.g.
+ *
+ *    gcc -O2 -mavx2 -Ihexagon/hvx_emul -Ihexagon/include ...
+ *
+ * and the existing sources (hvx_inlines.h, the d32 ops, ...) compile unchanged.
+ * Every intrinsic has a plain C implementation which follows the instruction description
+ * lane by lane. Some of the commonly used ones also have an AVX2 or NEON version, which is
+ * used when the compiler targets those (define HVX_EMUL_NO_SIMD to always use the C code);
+ * the two give identical results.
+ *
+ * Vectors are plain structs, so copies, unaligned loads (vmemu) and unions with arrays all
+ * work as they do on target. A predicate is kept as one byte (0 or 1) per vector byte.
+ * Since the headers are C, the vector types have no operators (v1 ^ v2 etc. are target only).
+ */
+
+#ifndef HVX_EMUL_H
+#define HVX_EMUL_H 1
+
+#if defined(__hexagon__)
+#error "hvx_emul is for host builds only"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(HVX_EMUL_NO_SIMD)
+#if defined(__AVX2__)
+#define HVX_EMUL_AVX2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define HVX_EMUL_NEON 1
+#endif
+#endif
+
+// nn_graph_builtin.h defines __attribute__ away for host builds; the SIMD headers need it.
+#if defined(HVX_EMUL_AVX2) || defined(HVX_EMUL_NEON)
+#pragma push_macro("__attribute__")
+#undef __attribute__
+#if defined(HVX_EMUL_AVX2)
+#include <immintrin.h>
+#else
+#include <arm_neon.h>
+#endif
+#pragma pop_macro("__attribute__")
+#endif
+
+#define HVX_EMUL_VBYTES 128
+
+typedef union {
+	uint8_t ub[128];
+	int8_t b[128];
+	uint16_t uh[64];
+	int16_t h[64];
+	uint32_t uw[32];
+	int32_t w[32];
+} HVX_Vector;
+
+typedef HVX_Vector HVX_UVector;
+
+typedef struct {
+	HVX_Vector v[2];	// v[0] is the 'lo' vector
+} HVX_VectorPair;
+
+// As with the Hexagon tools, a predicate has the same type as a vector (so code which
+// keeps predicates in HVX_Vector variables compiles); it holds 0 or 1 in each byte lane.
+typedef HVX_Vector HVX_VectorPred;
+
+// Unaligned vector access. The ops define these themselves for __hexagon__ (as vector types
+// with 4-byte alignment); the emulated vector has no alignment requirement beyond its lanes.
+typedef HVX_Vector HVX_Vect_UN;
+typedef HVX_Vector HEXAGON_Vect_UN;
+#define vmemu(A) *((HVX_Vect_UN*)(A))
+
+#ifndef HEXAGON_TYPES_WORD_DEFINED
+#define HEXAGON_TYPES_WORD_DEFINED 1
+typedef int8_t Byte;
+typedef uint8_t UByte;
+typedef int16_t Word16;
+typedef uint16_t UWord16;
+typedef int32_t Word32;
+typedef uint32_t UWord32;
+typedef int64_t Word64;
+typedef uint64_t UWord64;
+typedef void *Address;
+#endif
+
+////////////////////////////////////////////////////////
+// saturation and lane helpers
+////////////////////////////////////////////////////////
+
+static inline int32_t hvxe_sat8(int64_t x) { return (x < -128) ? -128 : (x > 127) ? 127 : (int32_t)x; }
+static inline int32_t hvxe_usat8(int64_t x) { return (x < 0) ? 0 : (x > 255) ? 255 : (int32_t)x; }
+static inline int32_t hvxe_sat16(int64_t x) { return (x < -32768) ? -32768 : (x > 32767) ? 32767 : (int32_t)x; }
+static inline int32_t hvxe_usat16(int64_t x) { return (x < 0) ? 0 : (x > 65535) ? 65535 : (int32_t)x; }
+static inline int32_t hvxe_sat32(int64_t x)
+{
+	return (x < INT32_MIN) ? INT32_MIN : (x > INT32_MAX) ? INT32_MAX : (int32_t)x;
+}
+static inline uint32_t hvxe_usat32(int64_t x) { return (x < 0) ? 0 : (x > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)x; }
+
+// arithmetic shift right of a 64-bit value; 'n' may be >= 64
+static inline int64_t hvxe_asr64(int64_t x, int n) { return (n >= 64) ? (x >> 63) : (x >> n); }
+
+// signed value of the low 'bits' bits of x
+static inline int32_t hvxe_sxt(uint32_t x, int bits)
+{
+	uint32_t m = 1u << (bits - 1);
+	x &= (m << 1) - 1;
+	return (int32_t)(x ^ m) - (int32_t)m;
+}
+
+// the byte of a scalar register used for vector byte lane i (registers are replicated across the vector)
+static inline uint8_t hvxe_rbyte(uint32_t r, int i) { return (uint8_t)(r >> (8 * (i & 3))); }
+static inline uint16_t hvxe_rhalf(uint32_t r, int i) { return (uint16_t)(r >> (16 * (i & 1))); }
+
+static inline int hvxe_cl0_32(uint32_t x)
+{
+	int n = 0;
+	if (x == 0) return 32;
+	while (!(x & 0x80000000u)) { x <<= 1; n++; }
+	return n;
+}
+
+static inline int hvxe_cl0_16(uint16_t x) { return (x == 0) ? 16 : hvxe_cl0_32(x) - 16; }
+
+// normalization amount: number of redundant sign bits (0 for 0)
+static inline int hvxe_normamt32(int32_t x)
+{
+	if (x == 0) return 0;
+	uint32_t u = (x < 0) ? ~(uint32_t)x : (uint32_t)x;
+	return hvxe_cl0_32(u) - 1;
+}
+
+static inline int hvxe_normamt16(int16_t x)
+{
+	if (x == 0) return 0;
+	uint32_t u = (x < 0) ? (uint16_t)~x : (uint16_t)x;
+	return hvxe_cl0_32(u) - 17;
+}
+
+#endif // HVX_EMUL_H
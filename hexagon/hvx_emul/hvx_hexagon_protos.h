@@ -0,0 +1,1402 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * Host emulation of the HVX intrinsics (128-byte mode) used in the tree; see hvx_emul.h.
+ *
+ * Conventions, as in the instruction descriptions:
+ *  - For (Vu, Vv) operations producing interleaved results (vasr, vround, vsat, vshuffe/o),
+ *    the even lanes come from Vv and the odd lanes from Vu.
+ *  - vpack puts Vv in the low half of the result and Vu in the high half.
+ *  - Widening operations put the even source lanes in the lo vector of the pair, odd in hi;
+ *    except vunpack, which puts the low half of the source in lo.
+ *  - A scalar Rt used per vector lane is replicated: byte lane i uses Rt.b[i%4], halfword
+ *    lane i uses Rt.h[i%2].
+ */
+
+#ifndef HVX_EMUL_HVX_HEXAGON_PROTOS_H
+#define HVX_EMUL_HVX_HEXAGON_PROTOS_H 1
+
+#include "hvx_emul.h"
+#include "hexagon_protos.h"
+
+////////////////////////////////////////////////////////
+// generators for the lane-wise operations
+////////////////////////////////////////////////////////
+
+// Vd.M[i] = EXPR(a = Vu.M[i], b = Vv.M[i])
+#define HVXE_VV(NAME, M, N, EXPR) \
+static inline HVX_Vector NAME(HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_Vector d; \
+	for (int i = 0; i < N; i++) { \
+		int64_t a = Vu.M[i]; \
+		int64_t b = Vv.M[i]; \
+		d.M[i] = (EXPR); \
+	} \
+	return d; \
+}
+
+// Vd.M[i] = EXPR(a = Vu.M[i])
+#define HVXE_V(NAME, M, N, EXPR) \
+static inline HVX_Vector NAME(HVX_Vector Vu) \
+{ \
+	HVX_Vector d; \
+	for (int i = 0; i < N; i++) { \
+		int64_t a = Vu.M[i]; \
+		d.M[i] = (EXPR); \
+	} \
+	return d; \
+}
+
+// Vd.M[i] = EXPR(a = Vu.M[i], r = Rt)
+#define HVXE_VR(NAME, M, N, EXPR) \
+static inline HVX_Vector NAME(HVX_Vector Vu, Word32 Rt) \
+{ \
+	HVX_Vector d; \
+	uint32_t r = (uint32_t)Rt; \
+	for (int i = 0; i < N; i++) { \
+		int64_t a = Vu.M[i]; \
+		d.M[i] = (EXPR); \
+	} \
+	return d; \
+}
+
+// Vdd.v[k].M[i] = EXPR(a = Vuu.v[k].M[i], b = Vvv.v[k].M[i])
+#define HVXE_WW(NAME, M, N, EXPR) \
+static inline HVX_VectorPair NAME(HVX_VectorPair Vuu, HVX_VectorPair Vvv) \
+{ \
+	HVX_VectorPair d; \
+	for (int k = 0; k < 2; k++) { \
+		for (int i = 0; i < N; i++) { \
+			int64_t a = Vuu.v[k].M[i]; \
+			int64_t b = Vvv.v[k].M[i]; \
+			d.v[k].M[i] = (EXPR); \
+		} \
+	} \
+	return d; \
+}
+
+// Q[lanes of element i] = EXPR(a = Vu.M[i], b = Vv.M[i]), elements of BYTES bytes
+#define HVXE_QVV(NAME, M, BYTES, EXPR) \
+static inline HVX_VectorPred NAME(HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_VectorPred q; \
+	for (int i = 0; i < 128 / BYTES; i++) { \
+		int64_t a = Vu.M[i]; \
+		int64_t b = Vv.M[i]; \
+		uint8_t t = (EXPR) ? 1 : 0; \
+		for (int j = 0; j < BYTES; j++) q.ub[i * BYTES + j] = t; \
+	} \
+	return q; \
+}
+
+// as HVXE_QVV, combined with an existing predicate: Qd = Qx OP EXPR
+#define HVXE_QQVV(NAME, M, BYTES, OP, EXPR) \
+static inline HVX_VectorPred NAME(HVX_VectorPred Qx, HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_VectorPred q; \
+	for (int i = 0; i < 128 / BYTES; i++) { \
+		int64_t a = Vu.M[i]; \
+		int64_t b = Vv.M[i]; \
+		uint8_t t = (EXPR) ? 1 : 0; \
+		for (int j = 0; j < BYTES; j++) q.ub[i * BYTES + j] = Qx.ub[i * BYTES + j] OP t; \
+	} \
+	return q; \
+}
+
+// Interleaved narrowing of two vectors: Vd.DM[2i] = EXPR(a = Vv.SM[i]), Vd.DM[2i+1] = EXPR(a = Vu.SM[i])
+#define HVXE_NARROW(NAME, SM, DM, N, EXPR) \
+static inline HVX_Vector NAME(HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_Vector d; \
+	for (int i = 0; i < N; i++) { \
+		int64_t a = Vv.SM[i]; \
+		d.DM[2 * i] = (EXPR); \
+		a = Vu.SM[i]; \
+		d.DM[2 * i + 1] = (EXPR); \
+	} \
+	return d; \
+}
+
+// As HVXE_NARROW, with a shift amount 'sh' from Rt
+#define HVXE_NARROW_R(NAME, SM, DM, N, SHMASK, EXPR) \
+static inline HVX_Vector NAME(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) \
+{ \
+	HVX_Vector d; \
+	int sh = Rt & SHMASK; \
+	int64_t rnd = (sh == 0) ? 0 : ((int64_t)1 << (sh - 1)); \
+	(void)rnd; \
+	for (int i = 0; i < N; i++) { \
+		int64_t a = Vv.SM[i]; \
+		d.DM[2 * i] = (EXPR); \
+		a = Vu.SM[i]; \
+		d.DM[2 * i + 1] = (EXPR); \
+	} \
+	return d; \
+}
+
+// Block narrowing: Vd.DM[i] = EXPR(a = Vv.SM[i]), Vd.DM[i+N] = EXPR(a = Vu.SM[i])
+#define HVXE_PACK(NAME, SM, DM, N, EXPR) \
+static inline HVX_Vector NAME(HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_Vector d; \
+	for (int i = 0; i < N; i++) { \
+		int64_t a = Vv.SM[i]; \
+		d.DM[i] = (EXPR); \
+		a = Vu.SM[i]; \
+		d.DM[i + N] = (EXPR); \
+	} \
+	return d; \
+}
+
+// Widening, even/odd: Vdd.v[0].DM[i] = EXPR(a = Vu.SM[2i], b = Vv.SM[2i], j = 2i), v[1] with 2i+1
+#define HVXE_WIDEN(NAME, SM, DM, N, EXPR) \
+static inline HVX_VectorPair NAME(HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_VectorPair d; \
+	for (int i = 0; i < N; i++) { \
+		for (int k = 0; k < 2; k++) { \
+			int j = 2 * i + k; \
+			int64_t a = Vu.SM[j]; \
+			int64_t b = Vv.SM[j]; \
+			(void)j; \
+			d.v[k].DM[i] = (EXPR); \
+		} \
+	} \
+	return d; \
+}
+
+// as HVXE_WIDEN, with accumulator x = Vxx.v[k].DM[i]
+#define HVXE_WIDEN_ACC(NAME, SM, DM, N, EXPR) \
+static inline HVX_VectorPair NAME(HVX_VectorPair Vxx, HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_VectorPair d; \
+	for (int i = 0; i < N; i++) { \
+		for (int k = 0; k < 2; k++) { \
+			int j = 2 * i + k; \
+			int64_t x = Vxx.v[k].DM[i]; \
+			int64_t a = Vu.SM[j]; \
+			int64_t b = Vv.SM[j]; \
+			(void)j; \
+			d.v[k].DM[i] = (EXPR); \
+		} \
+	} \
+	return d; \
+}
+
+// Widening by scalar: as HVXE_WIDEN, with r = Rt instead of b
+#define HVXE_WIDEN_R(NAME, SM, DM, N, EXPR) \
+static inline HVX_VectorPair NAME(HVX_Vector Vu, Word32 Rt) \
+{ \
+	HVX_VectorPair d; \
+	uint32_t r = (uint32_t)Rt; \
+	for (int i = 0; i < N; i++) { \
+		for (int k = 0; k < 2; k++) { \
+			int j = 2 * i + k; \
+			int64_t a = Vu.SM[j]; \
+			(void)j; \
+			d.v[k].DM[i] = (EXPR); \
+		} \
+	} \
+	return d; \
+}
+
+// as HVXE_WIDEN_R, with accumulator x = Vxx.v[k].DM[i]
+#define HVXE_WIDEN_RACC(NAME, SM, DM, N, EXPR) \
+static inline HVX_VectorPair NAME(HVX_VectorPair Vxx, HVX_Vector Vu, Word32 Rt) \
+{ \
+	HVX_VectorPair d; \
+	uint32_t r = (uint32_t)Rt; \
+	for (int i = 0; i < N; i++) { \
+		for (int k = 0; k < 2; k++) { \
+			int j = 2 * i + k; \
+			int64_t x = Vxx.v[k].DM[i]; \
+			int64_t a = Vu.SM[j]; \
+			(void)j; \
+			d.v[k].DM[i] = (EXPR); \
+		} \
+	} \
+	return d; \
+}
+
+////////////////////////////////////////////////////////
+// SIMD backends for some of the operations.
+// HVXE_SIMD_VV(NAME, REF, AVX2_FN, NEON_FN) defines NAME using a 32-byte (AVX2) or
+// 16-byte (NEON) function of the same meaning, or else REF.
+////////////////////////////////////////////////////////
+
+#if defined(HVX_EMUL_AVX2)
+typedef __m256i hvxe_simd_t;
+#define HVXE_SIMD_BYTES 32
+#define hvxe_simd_ld(p) _mm256_loadu_si256((const __m256i *)(p))
+#define hvxe_simd_st(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#elif defined(HVX_EMUL_NEON)
+typedef uint8x16_t hvxe_simd_t;
+#define HVXE_SIMD_BYTES 16
+#define hvxe_simd_ld(p) vld1q_u8((const uint8_t *)(p))
+#define hvxe_simd_st(p, v) vst1q_u8((uint8_t *)(p), (v))
+#endif
+
+#if defined(HVX_EMUL_AVX2) || defined(HVX_EMUL_NEON)
+#if defined(HVX_EMUL_AVX2)
+#define HVXE_SIMD_PICK(AVX2_FN, NEON_FN) AVX2_FN
+#else
+#define HVXE_SIMD_PICK(AVX2_FN, NEON_FN) NEON_FN
+#endif
+#define HVXE_SIMD_VV(NAME, REF, AVX2_FN, NEON_FN) \
+static inline HVX_Vector NAME(HVX_Vector Vu, HVX_Vector Vv) \
+{ \
+	HVX_Vector d; \
+	for (int k = 0; k < 128; k += HVXE_SIMD_BYTES) { \
+		hvxe_simd_st(&d.ub[k], HVXE_SIMD_PICK(AVX2_FN, NEON_FN)(hvxe_simd_ld(&Vu.ub[k]), hvxe_simd_ld(&Vv.ub[k]))); \
+	} \
+	return d; \
+}
+#else
+#define HVXE_SIMD_VV(NAME, REF, AVX2_FN, NEON_FN) \
+static inline HVX_Vector NAME(HVX_Vector Vu, HVX_Vector Vv) { return REF(Vu, Vv); }
+#endif
+
+#if defined(HVX_EMUL_AVX2)
+// 32-bit add/sub with saturation
+static inline __m256i hvxe_avx2_adds_epi32(__m256i a, __m256i b)
+{
+	__m256i s = _mm256_add_epi32(a, b);
+	__m256i ovf = _mm256_and_si256(_mm256_xor_si256(a, s), _mm256_xor_si256(b, s));
+	__m256i satv = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(INT32_MAX));
+	return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s), _mm256_castsi256_ps(satv), _mm256_castsi256_ps(ovf)));
+}
+static inline __m256i hvxe_avx2_subs_epi32(__m256i a, __m256i b)
+{
+	__m256i s = _mm256_sub_epi32(a, b);
+	__m256i ovf = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, s));
+	__m256i satv = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(INT32_MAX));
+	return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s), _mm256_castsi256_ps(satv), _mm256_castsi256_ps(ovf)));
+}
+// sat16((2*a*b + 0x8000) >> 16); mulhrs only differs for -32768 * -32768
+static inline __m256i hvxe_avx2_mpy_s1_rnd_sat_epi16(__m256i a, __m256i b)
+{
+	__m256i p = _mm256_mulhrs_epi16(a, b);
+	__m256i m = _mm256_set1_epi16(INT16_MIN);
+	__m256i both = _mm256_and_si256(_mm256_cmpeq_epi16(a, m), _mm256_cmpeq_epi16(b, m));
+	return _mm256_xor_si256(p, both);	// 0x8000 -> 0x7FFF
+}
+#endif
+
+#if defined(HVX_EMUL_NEON)
+#define HVXE_NEON_OP(NAME, T, SUF, OP) \
+static inline uint8x16_t NAME(uint8x16_t a, uint8x16_t b) \
+{ \
+	return vreinterpretq_u8_##SUF(OP(vreinterpretq_##SUF##_u8(a), vreinterpretq_##SUF##_u8(b))); \
+}
+HVXE_NEON_OP(hvxe_neon_add_b, int8x16_t, s8, vaddq_s8)
+HVXE_NEON_OP(hvxe_neon_add_h, int16x8_t, s16, vaddq_s16)
+HVXE_NEON_OP(hvxe_neon_add_w, int32x4_t, s32, vaddq_s32)
+HVXE_NEON_OP(hvxe_neon_adds_h, int16x8_t, s16, vqaddq_s16)
+HVXE_NEON_OP(hvxe_neon_adds_w, int32x4_t, s32, vqaddq_s32)
+HVXE_NEON_OP(hvxe_neon_adds_uh, uint16x8_t, u16, vqaddq_u16)
+HVXE_NEON_OP(hvxe_neon_sub_b, int8x16_t, s8, vsubq_s8)
+HVXE_NEON_OP(hvxe_neon_sub_h, int16x8_t, s16, vsubq_s16)
+HVXE_NEON_OP(hvxe_neon_sub_w, int32x4_t, s32, vsubq_s32)
+HVXE_NEON_OP(hvxe_neon_subs_h, int16x8_t, s16, vqsubq_s16)
+HVXE_NEON_OP(hvxe_neon_subs_w, int32x4_t, s32, vqsubq_s32)
+HVXE_NEON_OP(hvxe_neon_subs_ub, uint8x16_t, u8, vqsubq_u8)
+HVXE_NEON_OP(hvxe_neon_max_ub, uint8x16_t, u8, vmaxq_u8)
+HVXE_NEON_OP(hvxe_neon_min_ub, uint8x16_t, u8, vminq_u8)
+HVXE_NEON_OP(hvxe_neon_max_h, int16x8_t, s16, vmaxq_s16)
+HVXE_NEON_OP(hvxe_neon_min_h, int16x8_t, s16, vminq_s16)
+HVXE_NEON_OP(hvxe_neon_max_w, int32x4_t, s32, vmaxq_s32)
+HVXE_NEON_OP(hvxe_neon_min_w, int32x4_t, s32, vminq_s32)
+// sat16((2*a*b + 0x8000) >> 16)
+HVXE_NEON_OP(hvxe_neon_mpy_s1_rnd_sat_h, int16x8_t, s16, vqrdmulhq_s16)
+#undef HVXE_NEON_OP
+#endif
+
+////////////////////////////////////////////////////////
+// whole vectors, pairs
+////////////////////////////////////////////////////////
+
+static inline HVX_Vector Q6_V_vzero(void)
+{
+	HVX_Vector d;
+	memset(&d, 0, sizeof(d));
+	return d;
+}
+
+static inline HVX_Vector Q6_V_vsplat_R(Word32 Rt)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 32; i++) d.w[i] = Rt;
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vsplat_R(Word32 Rt)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 64; i++) d.h[i] = (int16_t)Rt;
+	return d;
+}
+static inline HVX_Vector Q6_Vb_vsplat_R(Word32 Rt)
+{
+	HVX_Vector d;
+	memset(&d, Rt & 0xFF, sizeof(d));
+	return d;
+}
+
+HVXE_VV(Q6_V_vand_VV, uw, 32, a & b)
+HVXE_VV(Q6_V_vor_VV, uw, 32, a | b)
+HVXE_VV(Q6_V_vxor_VV, uw, 32, a ^ b)
+HVXE_V(Q6_V_vnot_V, uw, 32, ~a)
+
+static inline HVX_Vector Q6_V_lo_W(HVX_VectorPair Vss) { return Vss.v[0]; }
+static inline HVX_Vector Q6_V_hi_W(HVX_VectorPair Vss) { return Vss.v[1]; }
+
+static inline HVX_VectorPair Q6_W_vcombine_VV(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_VectorPair d;
+	d.v[0] = Vv;
+	d.v[1] = Vu;
+	return d;
+}
+
+// {Vu:Vv} >> 8*(Rt & 127)
+static inline HVX_Vector Q6_V_valign_VVR(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt)
+{
+	HVX_Vector d;
+	int sh = Rt & 127;
+	for (int i = 0; i < 128; i++) d.ub[i] = (i + sh >= 128) ? Vu.ub[i + sh - 128] : Vv.ub[i + sh];
+	return d;
+}
+static inline HVX_Vector Q6_V_valign_VVI(HVX_Vector Vu, HVX_Vector Vv, int Iu3) { return Q6_V_valign_VVR(Vu, Vv, Iu3 & 7); }
+
+// {Vu:Vv} << 8*(Rt & 127), upper vector
+static inline HVX_Vector Q6_V_vlalign_VVR(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt)
+{
+	HVX_Vector d;
+	int sh = Rt & 127;
+	for (int i = 0; i < 128; i++) d.ub[i] = (i < sh) ? Vv.ub[128 - sh + i] : Vu.ub[i - sh];
+	return d;
+}
+static inline HVX_Vector Q6_V_vlalign_VVI(HVX_Vector Vu, HVX_Vector Vv, int Iu3) { return Q6_V_vlalign_VVR(Vu, Vv, Iu3 & 7); }
+
+static inline HVX_Vector Q6_V_vror_VR(HVX_Vector Vu, Word32 Rt)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 128; i++) d.ub[i] = Vu.ub[(i + Rt) & 127];
+	return d;
+}
+
+////////////////////////////////////////////////////////
+// vdelta / vrdelta: the 7-stage butterfly network; at the stage for 'offset',
+// byte k takes byte k^offset when (Vv.ub[k] & offset) is set.
+// vdelta does the stages from offset 64 down to 1, vrdelta from 1 up to 64.
+////////////////////////////////////////////////////////
+
+static inline HVX_Vector hvxe_c_delta(HVX_Vector Vu, HVX_Vector Vv, int reverse)
+{
+	for (int s = 0; s < 7; s++) {
+		int offset = reverse ? (1 << s) : (64 >> s);
+		HVX_Vector d;
+		for (int k = 0; k < 128; k++) d.ub[k] = (Vv.ub[k] & offset) ? Vu.ub[k ^ offset] : Vu.ub[k];
+		Vu = d;
+	}
+	return Vu;
+}
+
+#if defined(HVX_EMUL_AVX2)
+// one stage: the four 32-byte chunks c[]; ctl[] the controls
+static inline void hvxe_avx2_delta_stage(__m256i *c, const __m256i *ctl, int offset)
+{
+	__m256i sw[4];
+	__m256i bit = _mm256_set1_epi8((char)offset);
+	if (offset >= 32) {
+		int cs = offset / 32;
+		for (int j = 0; j < 4; j++) sw[j] = c[j ^ cs];
+	} else if (offset == 16) {
+		for (int j = 0; j < 4; j++) sw[j] = _mm256_permute2x128_si256(c[j], c[j], 0x01);
+	} else {
+		uint8_t perm[32];
+		for (int k = 0; k < 32; k++) perm[k] = (uint8_t)((k ^ offset) & 15);
+		__m256i pv = _mm256_loadu_si256((const __m256i *)perm);
+		for (int j = 0; j < 4; j++) sw[j] = _mm256_shuffle_epi8(c[j], pv);
+	}
+	for (int j = 0; j < 4; j++) {
+		__m256i sel = _mm256_cmpeq_epi8(_mm256_and_si256(ctl[j], bit), bit);
+		c[j] = _mm256_blendv_epi8(c[j], sw[j], sel);
+	}
+}
+
+static inline HVX_Vector hvxe_delta(HVX_Vector Vu, HVX_Vector Vv, int reverse)
+{
+	__m256i c[4], ctl[4];
+	HVX_Vector d;
+	for (int j = 0; j < 4; j++) {
+		c[j] = hvxe_simd_ld(&Vu.ub[32 * j]);
+		ctl[j] = hvxe_simd_ld(&Vv.ub[32 * j]);
+	}
+	for (int s = 0; s < 7; s++) hvxe_avx2_delta_stage(c, ctl, reverse ? (1 << s) : (64 >> s));
+	for (int j = 0; j < 4; j++) hvxe_simd_st(&d.ub[32 * j], c[j]);
+	return d;
+}
+#else
+#define hvxe_delta hvxe_c_delta
+#endif
+
+static inline HVX_Vector Q6_V_vdelta_VV(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_delta(Vu, Vv, 0); }
+static inline HVX_Vector Q6_V_vrdelta_VV(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_delta(Vu, Vv, 1); }
+
+////////////////////////////////////////////////////////
+// shuffles and deals
+////////////////////////////////////////////////////////
+
+// Vdd = {Vu:Vv}, then for each set bit 'offset' of Rt (ascending for vshuff, descending
+// for vdeal), swap hi.ub[k] and lo.ub[k+offset] for all k with (k & offset) == 0
+static inline HVX_VectorPair hvxe_shuffdeal(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int deal)
+{
+	HVX_VectorPair d;
+	d.v[0] = Vv;
+	d.v[1] = Vu;
+	for (int s = 0; s < 7; s++) {
+		int offset = deal ? (64 >> s) : (1 << s);
+		if (!(Rt & offset)) continue;
+		for (int k = 0; k < 128; k++) {
+			if (!(k & offset)) {
+				uint8_t t = d.v[1].ub[k];
+				d.v[1].ub[k] = d.v[0].ub[k + offset];
+				d.v[0].ub[k + offset] = t;
+			}
+		}
+	}
+	return d;
+}
+static inline HVX_VectorPair Q6_W_vshuff_VVR(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_shuffdeal(Vu, Vv, Rt, 0); }
+static inline HVX_VectorPair Q6_W_vdeal_VVR(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_shuffdeal(Vu, Vv, Rt, 1); }
+
+static inline HVX_Vector Q6_Vb_vshuff_Vb(HVX_Vector Vu)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 64; i++) {
+		d.ub[2 * i] = Vu.ub[i];
+		d.ub[2 * i + 1] = Vu.ub[i + 64];
+	}
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vshuff_Vh(HVX_Vector Vu)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 32; i++) {
+		d.uh[2 * i] = Vu.uh[i];
+		d.uh[2 * i + 1] = Vu.uh[i + 32];
+	}
+	return d;
+}
+static inline HVX_Vector Q6_Vb_vdeal_Vb(HVX_Vector Vu)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 64; i++) {
+		d.ub[i] = Vu.ub[2 * i];
+		d.ub[i + 64] = Vu.ub[2 * i + 1];
+	}
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vdeal_Vh(HVX_Vector Vu)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 32; i++) {
+		d.uh[i] = Vu.uh[2 * i];
+		d.uh[i + 32] = Vu.uh[2 * i + 1];
+	}
+	return d;
+}
+
+HVXE_NARROW(hvxe_vshuffe_b, uh, ub, 64, a & 0xFF)
+HVXE_NARROW(hvxe_vshuffo_b, uh, ub, 64, a >> 8)
+HVXE_NARROW(hvxe_vshuffe_h, uw, uh, 32, a & 0xFFFF)
+HVXE_NARROW(hvxe_vshuffo_h, uw, uh, 32, a >> 16)
+static inline HVX_Vector Q6_Vb_vshuffe_VbVb(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_vshuffe_b(Vu, Vv); }
+static inline HVX_Vector Q6_Vb_vshuffo_VbVb(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_vshuffo_b(Vu, Vv); }
+static inline HVX_Vector Q6_Vh_vshuffe_VhVh(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_vshuffe_h(Vu, Vv); }
+static inline HVX_Vector Q6_Vh_vshuffo_VhVh(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_vshuffo_h(Vu, Vv); }
+
+static inline HVX_VectorPair Q6_Wb_vshuffoe_VbVb(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_VectorPair d;
+	d.v[0] = hvxe_vshuffe_b(Vu, Vv);
+	d.v[1] = hvxe_vshuffo_b(Vu, Vv);
+	return d;
+}
+static inline HVX_VectorPair Q6_Wh_vshuffoe_VhVh(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_VectorPair d;
+	d.v[0] = hvxe_vshuffe_h(Vu, Vv);
+	d.v[1] = hvxe_vshuffo_h(Vu, Vv);
+	return d;
+}
+
+HVXE_PACK(Q6_Vb_vpacke_VhVh, uh, ub, 64, a & 0xFF)
+HVXE_PACK(Q6_Vb_vpacko_VhVh, uh, ub, 64, a >> 8)
+HVXE_PACK(Q6_Vh_vpacke_VwVw, uw, uh, 32, a & 0xFFFF)
+HVXE_PACK(Q6_Vh_vpacko_VwVw, uw, uh, 32, a >> 16)
+HVXE_PACK(Q6_Vub_vpack_VhVh_sat, h, ub, 64, hvxe_usat8(a))
+HVXE_PACK(Q6_Vb_vpack_VhVh_sat, h, b, 64, hvxe_sat8(a))
+HVXE_PACK(Q6_Vh_vpack_VwVw_sat, w, h, 32, hvxe_sat16(a))
+HVXE_PACK(Q6_Vuh_vpack_VwVw_sat, w, uh, 32, hvxe_usat16(a))
+
+// zero/sign extension, even lanes to lo
+static inline HVX_VectorPair Q6_Wuh_vzxt_Vub(HVX_Vector Vu)
+{
+	HVX_VectorPair d;
+	for (int i = 0; i < 64; i++) {
+		d.v[0].uh[i] = Vu.ub[2 * i];
+		d.v[1].uh[i] = Vu.ub[2 * i + 1];
+	}
+	return d;
+}
+static inline HVX_VectorPair Q6_Ww_vsxt_Vh(HVX_Vector Vu)
+{
+	HVX_VectorPair d;
+	for (int i = 0; i < 32; i++) {
+		d.v[0].w[i] = Vu.h[2 * i];
+		d.v[1].w[i] = Vu.h[2 * i + 1];
+	}
+	return d;
+}
+// unpack: low half of the source to lo
+static inline HVX_VectorPair Q6_Wuh_vunpack_Vub(HVX_Vector Vu)
+{
+	HVX_VectorPair d;
+	for (int i = 0; i < 64; i++) {
+		d.v[0].uh[i] = Vu.ub[i];
+		d.v[1].uh[i] = Vu.ub[i + 64];
+	}
+	return d;
+}
+static inline HVX_VectorPair Q6_Wuw_vunpack_Vuh(HVX_Vector Vu)
+{
+	HVX_VectorPair d;
+	for (int i = 0; i < 32; i++) {
+		d.v[0].uw[i] = Vu.uh[i];
+		d.v[1].uw[i] = Vu.uh[i + 32];
+	}
+	return d;
+}
+static inline HVX_VectorPair Q6_Ww_vunpack_Vh(HVX_Vector Vu)
+{
+	HVX_VectorPair d;
+	for (int i = 0; i < 32; i++) {
+		d.v[0].w[i] = Vu.h[i];
+		d.v[1].w[i] = Vu.h[i + 32];
+	}
+	return d;
+}
+
+////////////////////////////////////////////////////////
+// add, subtract, average, min/max, abs
+////////////////////////////////////////////////////////
+
+HVXE_VV(hvxe_c_Vb_vadd_VbVb, b, 128, a + b)
+HVXE_VV(hvxe_c_Vh_vadd_VhVh, h, 64, a + b)
+HVXE_VV(hvxe_c_Vw_vadd_VwVw, w, 32, a + b)
+HVXE_VV(hvxe_c_Vh_vadd_VhVh_sat, h, 64, hvxe_sat16(a + b))
+HVXE_VV(hvxe_c_Vw_vadd_VwVw_sat, w, 32, hvxe_sat32(a + b))
+HVXE_VV(hvxe_c_Vuh_vadd_VuhVuh_sat, uh, 64, hvxe_usat16(a + b))
+HVXE_VV(hvxe_c_Vb_vsub_VbVb, b, 128, a - b)
+HVXE_VV(hvxe_c_Vh_vsub_VhVh, h, 64, a - b)
+HVXE_VV(hvxe_c_Vw_vsub_VwVw, w, 32, a - b)
+HVXE_VV(hvxe_c_Vh_vsub_VhVh_sat, h, 64, hvxe_sat16(a - b))
+HVXE_VV(hvxe_c_Vw_vsub_VwVw_sat, w, 32, hvxe_sat32(a - b))
+HVXE_VV(hvxe_c_Vub_vsub_VubVub_sat, ub, 128, hvxe_usat8(a - b))
+HVXE_VV(hvxe_c_Vub_vmax_VubVub, ub, 128, (a > b) ? a : b)
+HVXE_VV(hvxe_c_Vub_vmin_VubVub, ub, 128, (a < b) ? a : b)
+HVXE_VV(hvxe_c_Vh_vmax_VhVh, h, 64, (a > b) ? a : b)
+HVXE_VV(hvxe_c_Vh_vmin_VhVh, h, 64, (a < b) ? a : b)
+HVXE_VV(hvxe_c_Vw_vmax_VwVw, w, 32, (a > b) ? a : b)
+HVXE_VV(hvxe_c_Vw_vmin_VwVw, w, 32, (a < b) ? a : b)
+
+HVXE_SIMD_VV(Q6_Vb_vadd_VbVb, hvxe_c_Vb_vadd_VbVb, _mm256_add_epi8, hvxe_neon_add_b)
+HVXE_SIMD_VV(Q6_Vh_vadd_VhVh, hvxe_c_Vh_vadd_VhVh, _mm256_add_epi16, hvxe_neon_add_h)
+HVXE_SIMD_VV(Q6_Vw_vadd_VwVw, hvxe_c_Vw_vadd_VwVw, _mm256_add_epi32, hvxe_neon_add_w)
+HVXE_SIMD_VV(Q6_Vh_vadd_VhVh_sat, hvxe_c_Vh_vadd_VhVh_sat, _mm256_adds_epi16, hvxe_neon_adds_h)
+HVXE_SIMD_VV(Q6_Vw_vadd_VwVw_sat, hvxe_c_Vw_vadd_VwVw_sat, hvxe_avx2_adds_epi32, hvxe_neon_adds_w)
+HVXE_SIMD_VV(Q6_Vuh_vadd_VuhVuh_sat, hvxe_c_Vuh_vadd_VuhVuh_sat, _mm256_adds_epu16, hvxe_neon_adds_uh)
+HVXE_SIMD_VV(Q6_Vb_vsub_VbVb, hvxe_c_Vb_vsub_VbVb, _mm256_sub_epi8, hvxe_neon_sub_b)
+HVXE_SIMD_VV(Q6_Vh_vsub_VhVh, hvxe_c_Vh_vsub_VhVh, _mm256_sub_epi16, hvxe_neon_sub_h)
+HVXE_SIMD_VV(Q6_Vw_vsub_VwVw, hvxe_c_Vw_vsub_VwVw, _mm256_sub_epi32, hvxe_neon_sub_w)
+HVXE_SIMD_VV(Q6_Vh_vsub_VhVh_sat, hvxe_c_Vh_vsub_VhVh_sat, _mm256_subs_epi16, hvxe_neon_subs_h)
+HVXE_SIMD_VV(Q6_Vw_vsub_VwVw_sat, hvxe_c_Vw_vsub_VwVw_sat, hvxe_avx2_subs_epi32, hvxe_neon_subs_w)
+HVXE_SIMD_VV(Q6_Vub_vsub_VubVub_sat, hvxe_c_Vub_vsub_VubVub_sat, _mm256_subs_epu8, hvxe_neon_subs_ub)
+HVXE_SIMD_VV(Q6_Vub_vmax_VubVub, hvxe_c_Vub_vmax_VubVub, _mm256_max_epu8, hvxe_neon_max_ub)
+HVXE_SIMD_VV(Q6_Vub_vmin_VubVub, hvxe_c_Vub_vmin_VubVub, _mm256_min_epu8, hvxe_neon_min_ub)
+HVXE_SIMD_VV(Q6_Vh_vmax_VhVh, hvxe_c_Vh_vmax_VhVh, _mm256_max_epi16, hvxe_neon_max_h)
+HVXE_SIMD_VV(Q6_Vh_vmin_VhVh, hvxe_c_Vh_vmin_VhVh, _mm256_min_epi16, hvxe_neon_min_h)
+HVXE_SIMD_VV(Q6_Vw_vmax_VwVw, hvxe_c_Vw_vmax_VwVw, _mm256_max_epi32, hvxe_neon_max_w)
+HVXE_SIMD_VV(Q6_Vw_vmin_VwVw, hvxe_c_Vw_vmin_VwVw, _mm256_min_epi32, hvxe_neon_min_w)
+
+HVXE_VV(Q6_Vub_vadd_VubVb_sat, ub, 128, hvxe_usat8(a + (int8_t)b))
+HVXE_VV(Q6_Vub_vsub_VubVb_sat, ub, 128, hvxe_usat8(a - (int8_t)b))
+HVXE_VV(Q6_Vuh_vsub_VuhVuh_sat, uh, 64, hvxe_usat16(a - b))
+HVXE_VV(Q6_Vuh_vmax_VuhVuh, uh, 64, (a > b) ? a : b)
+HVXE_VV(Q6_Vuh_vmin_VuhVuh, uh, 64, (a < b) ? a : b)
+
+HVXE_VV(Q6_Vh_vavg_VhVh, h, 64, (a + b) >> 1)
+HVXE_VV(Q6_Vh_vavg_VhVh_rnd, h, 64, (a + b + 1) >> 1)
+HVXE_VV(Q6_Vuh_vavg_VuhVuh, uh, 64, (a + b) >> 1)
+HVXE_VV(Q6_Vub_vavg_VubVub_rnd, ub, 128, (a + b + 1) >> 1)
+HVXE_VV(Q6_Vw_vavg_VwVw, w, 32, (a + b) >> 1)
+HVXE_VV(Q6_Vuw_vavg_VuwVuw, uw, 32, (a + b) >> 1)
+HVXE_VV(Q6_Vh_vnavg_VhVh, h, 64, (a - b) >> 1)
+HVXE_VV(Q6_Vb_vnavg_VubVub, ub, 128, (a - b) >> 1)
+
+HVXE_VV(Q6_Vub_vabsdiff_VubVub, ub, 128, (a > b) ? a - b : b - a)
+HVXE_VV(Q6_Vuh_vabsdiff_VhVh, h, 64, (a > b) ? a - b : b - a)
+HVXE_V(Q6_Vh_vabs_Vh, h, 64, (a < 0) ? -a : a)
+HVXE_V(Q6_Vw_vabs_Vw, w, 32, (a < 0) ? -a : a)
+HVXE_V(Q6_Vw_vabs_Vw_sat, w, 32, hvxe_sat32((a < 0) ? -a : a))
+
+// Vd.h[i] = Vu.h[i] + Vv.h[i], lanes with even source index in lo
+HVXE_WIDEN(Q6_Wh_vadd_VubVub, ub, h, 64, a + b)
+HVXE_WIDEN(Q6_Wh_vsub_VubVub, ub, h, 64, a - b)
+HVXE_WIDEN(Q6_Ww_vadd_VuhVuh, uh, w, 32, a + b)
+
+HVXE_WW(Q6_Wh_vadd_WhWh, h, 64, a + b)
+HVXE_WW(Q6_Wh_vadd_WhWh_sat, h, 64, hvxe_sat16(a + b))
+HVXE_WW(Q6_Wuh_vadd_WuhWuh_sat, uh, 64, hvxe_usat16(a + b))
+HVXE_WW(Q6_Wh_vsub_WhWh, h, 64, a - b)
+HVXE_WW(Q6_Ww_vadd_WwWw, w, 32, a + b)
+HVXE_WW(Q6_Ww_vsub_WwWw, w, 32, a - b)
+
+////////////////////////////////////////////////////////
+// shifts, bit counts
+////////////////////////////////////////////////////////
+
+HVXE_VR(hvxe_c_Vw_vasr_VwR, w, 32, a >> (r & 31))
+HVXE_VR(hvxe_c_Vh_vasr_VhR, h, 64, a >> (r & 15))
+HVXE_VR(hvxe_c_Vw_vasl_VwR, w, 32, a << (r & 31))
+HVXE_VR(Q6_Vh_vasl_VhR, h, 64, a << (r & 15))
+HVXE_VR(Q6_Vuw_vlsr_VuwR, uw, 32, a >> (r & 31))
+HVXE_VR(Q6_Vuh_vlsr_VuhR, uh, 64, a >> (r & 15))
+HVXE_VR(Q6_Vub_vlsr_VubR, ub, 128, a >> (r & 7))
+
+#if defined(HVX_EMUL_AVX2)
+#define HVXE_AVX2_SHIFT(NAME, FN, MASK) \
+static inline HVX_Vector NAME(HVX_Vector Vu, Word32 Rt) \
+{ \
+	HVX_Vector d; \
+	__m128i sh = _mm_cvtsi32_si128(Rt & MASK); \
+	for (int k = 0; k < 128; k += 32) hvxe_simd_st(&d.ub[k], FN(hvxe_simd_ld(&Vu.ub[k]), sh)); \
+	return d; \
+}
+HVXE_AVX2_SHIFT(Q6_Vw_vasr_VwR, _mm256_sra_epi32, 31)
+HVXE_AVX2_SHIFT(Q6_Vh_vasr_VhR, _mm256_sra_epi16, 15)
+HVXE_AVX2_SHIFT(Q6_Vw_vasl_VwR, _mm256_sll_epi32, 31)
+#undef HVXE_AVX2_SHIFT
+#else
+static inline HVX_Vector Q6_Vw_vasr_VwR(HVX_Vector Vu, Word32 Rt) { return hvxe_c_Vw_vasr_VwR(Vu, Rt); }
+static inline HVX_Vector Q6_Vh_vasr_VhR(HVX_Vector Vu, Word32 Rt) { return hvxe_c_Vh_vasr_VhR(Vu, Rt); }
+static inline HVX_Vector Q6_Vw_vasl_VwR(HVX_Vector Vu, Word32 Rt) { return hvxe_c_Vw_vasl_VwR(Vu, Rt); }
+#endif
+
+static inline HVX_Vector Q6_Vw_vaslacc_VwVwR(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vw_vadd_VwVw(Vx, Q6_Vw_vasl_VwR(Vu, Rt));
+}
+static inline HVX_Vector Q6_Vw_vasracc_VwVwR(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vw_vadd_VwVw(Vx, Q6_Vw_vasr_VwR(Vu, Rt));
+}
+
+// shift by signed per-lane amounts: the low log2(bits)+1 bits of Vv, sign extended;
+// 'left' shifts left for positive amounts (and right for negative), else the reverse
+static inline int64_t hvxe_vshift(int64_t a, int64_t amt, int bits, int left, int logical)
+{
+	int n = hvxe_sxt((uint32_t)amt, (bits == 32) ? 6 : 5);
+	uint64_t m = (bits == 32) ? 0xFFFFFFFFull : 0xFFFFull;
+	if (!left) n = -n;
+	if (n >= 0) return (n >= bits) ? 0 : (int64_t)(((uint64_t)a << n) & m);
+	n = -n;
+	if (logical) return (n >= bits) ? 0 : (int64_t)(((uint64_t)a & m) >> n);
+	return a >> ((n >= bits) ? bits - 1 : n);
+}
+HVXE_VV(Q6_Vw_vasl_VwVw, w, 32, hvxe_vshift(a, b, 32, 1, 0))
+HVXE_VV(Q6_Vw_vasr_VwVw, w, 32, hvxe_vshift(a, b, 32, 0, 0))
+HVXE_VV(Q6_Vw_vlsr_VwVw, w, 32, hvxe_vshift(a, b, 32, 0, 1))
+HVXE_VV(Q6_Vh_vasl_VhVh, h, 64, hvxe_vshift(a, b, 16, 1, 0))
+HVXE_VV(Q6_Vh_vasr_VhVh, h, 64, hvxe_vshift(a, b, 16, 0, 0))
+
+HVXE_V(Q6_Vh_vnormamt_Vh, h, 64, hvxe_normamt16((int16_t)a))
+HVXE_V(Q6_Vw_vnormamt_Vw, w, 32, hvxe_normamt32((int32_t)a))
+HVXE_V(Q6_Vuh_vcl0_Vuh, uh, 64, hvxe_cl0_16((uint16_t)a))
+HVXE_V(Q6_Vuw_vcl0_Vuw, uw, 32, hvxe_cl0_32((uint32_t)a))
+
+////////////////////////////////////////////////////////
+// narrowing: vasr, vround, vsat
+////////////////////////////////////////////////////////
+
+// (a + rnd) >> sh without overflow concerns
+#define HVXE_RSH(a) (((a) + rnd) >> sh)
+HVXE_NARROW_R(hvxe_c_Vh_vasr_VwVwR_rnd_sat, w, h, 32, 15, hvxe_sat16(HVXE_RSH(a)))
+HVXE_NARROW_R(hvxe_c_Vh_vasr_VwVwR_sat, w, h, 32, 15, hvxe_sat16(a >> sh))
+HVXE_NARROW_R(Q6_Vh_vasr_VwVwR, w, h, 32, 15, a >> sh)
+HVXE_NARROW_R(Q6_Vuh_vasr_VwVwR_rnd_sat, w, uh, 32, 15, hvxe_usat16(HVXE_RSH(a)))
+HVXE_NARROW_R(Q6_Vuh_vasr_VwVwR_sat, w, uh, 32, 15, hvxe_usat16(a >> sh))
+HVXE_NARROW_R(hvxe_c_Vub_vasr_VhVhR_rnd_sat, h, ub, 64, 7, hvxe_usat8(HVXE_RSH(a)))
+HVXE_NARROW_R(hvxe_c_Vub_vasr_VhVhR_sat, h, ub, 64, 7, hvxe_usat8(a >> sh))
+HVXE_NARROW_R(Q6_Vb_vasr_VhVhR_rnd_sat, h, b, 64, 7, hvxe_sat8(HVXE_RSH(a)))
+HVXE_NARROW_R(Q6_Vb_vasr_VhVhR_sat, h, b, 64, 7, hvxe_sat8(a >> sh))
+#undef HVXE_RSH
+
+#if defined(HVX_EMUL_AVX2)
+// AVX2: shift each source, clamp in the source width, then interleave by shift/or
+static inline __m256i hvxe_avx2_rsh_epi32(__m256i a, int sh, int rnd)
+{
+	__m256i r = _mm256_sra_epi32(a, _mm_cvtsi32_si128(sh));
+	if (rnd && sh > 0) r = _mm256_add_epi32(r, _mm256_and_si256(_mm256_sra_epi32(a, _mm_cvtsi32_si128(sh - 1)), _mm256_set1_epi32(1)));
+	return r;
+}
+static inline __m256i hvxe_avx2_rsh_epi16(__m256i a, int sh, int rnd)
+{
+	__m256i r = _mm256_sra_epi16(a, _mm_cvtsi32_si128(sh));
+	if (rnd && sh > 0) r = _mm256_add_epi16(r, _mm256_and_si256(_mm256_sra_epi16(a, _mm_cvtsi32_si128(sh - 1)), _mm256_set1_epi16(1)));
+	return r;
+}
+static inline HVX_Vector hvxe_avx2_vasr_wh(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int rnd)
+{
+	HVX_Vector d;
+	int sh = Rt & 15;
+	__m256i lo = _mm256_set1_epi32(-32768), hi = _mm256_set1_epi32(32767);
+	for (int k = 0; k < 128; k += 32) {
+		__m256i e = hvxe_avx2_rsh_epi32(hvxe_simd_ld(&Vv.ub[k]), sh, rnd);
+		__m256i o = hvxe_avx2_rsh_epi32(hvxe_simd_ld(&Vu.ub[k]), sh, rnd);
+		e = _mm256_min_epi32(_mm256_max_epi32(e, lo), hi);
+		o = _mm256_min_epi32(_mm256_max_epi32(o, lo), hi);
+		e = _mm256_and_si256(e, _mm256_set1_epi32(0xFFFF));
+		hvxe_simd_st(&d.ub[k], _mm256_or_si256(e, _mm256_slli_epi32(o, 16)));
+	}
+	return d;
+}
+static inline HVX_Vector hvxe_avx2_vasr_hub(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int rnd)
+{
+	HVX_Vector d;
+	int sh = Rt & 7;
+	__m256i lo = _mm256_setzero_si256(), hi = _mm256_set1_epi16(255);
+	for (int k = 0; k < 128; k += 32) {
+		__m256i e = hvxe_avx2_rsh_epi16(hvxe_simd_ld(&Vv.ub[k]), sh, rnd);
+		__m256i o = hvxe_avx2_rsh_epi16(hvxe_simd_ld(&Vu.ub[k]), sh, rnd);
+		e = _mm256_min_epi16(_mm256_max_epi16(e, lo), hi);
+		o = _mm256_min_epi16(_mm256_max_epi16(o, lo), hi);
+		hvxe_simd_st(&d.ub[k], _mm256_or_si256(e, _mm256_slli_epi16(o, 8)));
+	}
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vasr_VwVwR_rnd_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_avx2_vasr_wh(Vu, Vv, Rt, 1); }
+static inline HVX_Vector Q6_Vh_vasr_VwVwR_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_avx2_vasr_wh(Vu, Vv, Rt, 0); }
+static inline HVX_Vector Q6_Vub_vasr_VhVhR_rnd_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_avx2_vasr_hub(Vu, Vv, Rt, 1); }
+static inline HVX_Vector Q6_Vub_vasr_VhVhR_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_avx2_vasr_hub(Vu, Vv, Rt, 0); }
+#elif defined(HVX_EMUL_NEON)
+// NEON: rounding shifts are exact; narrow with saturation, then interleave
+static inline HVX_Vector hvxe_neon_vasr_wh(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int rnd)
+{
+	HVX_Vector d;
+	int32x4_t sh = vdupq_n_s32(-(Rt & 15));
+	for (int k = 0; k < 128; k += 16) {
+		int32x4_t e = vld1q_s32(&Vv.w[k / 4]), o = vld1q_s32(&Vu.w[k / 4]);
+		e = rnd ? vrshlq_s32(e, sh) : vshlq_s32(e, sh);
+		o = rnd ? vrshlq_s32(o, sh) : vshlq_s32(o, sh);
+		int16x4x2_t z = vzip_s16(vqmovn_s32(e), vqmovn_s32(o));
+		vst1q_s16(&d.h[k / 2], vcombine_s16(z.val[0], z.val[1]));
+	}
+	return d;
+}
+static inline HVX_Vector hvxe_neon_vasr_hub(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int rnd)
+{
+	HVX_Vector d;
+	int16x8_t sh = vdupq_n_s16(-(Rt & 7));
+	for (int k = 0; k < 128; k += 16) {
+		int16x8_t e = vld1q_s16(&Vv.h[k / 2]), o = vld1q_s16(&Vu.h[k / 2]);
+		e = rnd ? vrshlq_s16(e, sh) : vshlq_s16(e, sh);
+		o = rnd ? vrshlq_s16(o, sh) : vshlq_s16(o, sh);
+		uint8x8x2_t z = vzip_u8(vqmovun_s16(e), vqmovun_s16(o));
+		vst1q_u8(&d.ub[k], vcombine_u8(z.val[0], z.val[1]));
+	}
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vasr_VwVwR_rnd_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_neon_vasr_wh(Vu, Vv, Rt, 1); }
+static inline HVX_Vector Q6_Vh_vasr_VwVwR_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_neon_vasr_wh(Vu, Vv, Rt, 0); }
+static inline HVX_Vector Q6_Vub_vasr_VhVhR_rnd_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_neon_vasr_hub(Vu, Vv, Rt, 1); }
+static inline HVX_Vector Q6_Vub_vasr_VhVhR_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_neon_vasr_hub(Vu, Vv, Rt, 0); }
+#else
+static inline HVX_Vector Q6_Vh_vasr_VwVwR_rnd_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_c_Vh_vasr_VwVwR_rnd_sat(Vu, Vv, Rt); }
+static inline HVX_Vector Q6_Vh_vasr_VwVwR_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_c_Vh_vasr_VwVwR_sat(Vu, Vv, Rt); }
+static inline HVX_Vector Q6_Vub_vasr_VhVhR_rnd_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_c_Vub_vasr_VhVhR_rnd_sat(Vu, Vv, Rt); }
+static inline HVX_Vector Q6_Vub_vasr_VhVhR_sat(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_c_Vub_vasr_VhVhR_sat(Vu, Vv, Rt); }
+#endif
+
+HVXE_NARROW(Q6_Vub_vround_VhVh_sat, h, ub, 64, hvxe_usat8((a + 0x80) >> 8))
+HVXE_NARROW(Q6_Vb_vround_VhVh_sat, h, b, 64, hvxe_sat8((a + 0x80) >> 8))
+HVXE_NARROW(Q6_Vub_vround_VuhVuh_sat, uh, ub, 64, hvxe_usat8((a + 0x80) >> 8))
+HVXE_NARROW(Q6_Vh_vround_VwVw_sat, w, h, 32, hvxe_sat16((a + 0x8000) >> 16))
+HVXE_NARROW(Q6_Vuh_vround_VwVw_sat, w, uh, 32, hvxe_usat16((a + 0x8000) >> 16))
+HVXE_NARROW(Q6_Vuh_vround_VuwVuw_sat, uw, uh, 32, hvxe_usat16((a + 0x8000) >> 16))
+HVXE_NARROW(Q6_Vh_vsat_VwVw, w, h, 32, hvxe_sat16(a))
+
+////////////////////////////////////////////////////////
+// multiplies
+////////////////////////////////////////////////////////
+
+#define HVXE_RB(j) ((int8_t)hvxe_rbyte(r, (j)))
+#define HVXE_RUB(j) (hvxe_rbyte(r, (j)))
+#define HVXE_RH(j) ((int16_t)hvxe_rhalf(r, (j)))
+#define HVXE_RUH(j) (hvxe_rhalf(r, (j)))
+
+HVXE_VV(hvxe_c_Vh_vmpy_VhVh_s1_rnd_sat, h, 64, hvxe_sat16(((a * b << 1) + 0x8000) >> 16))
+HVXE_SIMD_VV(Q6_Vh_vmpy_VhVh_s1_rnd_sat, hvxe_c_Vh_vmpy_VhVh_s1_rnd_sat, hvxe_avx2_mpy_s1_rnd_sat_epi16, hvxe_neon_mpy_s1_rnd_sat_h)
+static inline HVX_Vector Q6_Vh_vmpy_VhRh_s1_rnd_sat(HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vh_vmpy_VhVh_s1_rnd_sat(Vu, Q6_V_vsplat_R(Rt));
+}
+HVXE_VV(Q6_Vh_vmpyi_VhVh, h, 64, a * b)
+
+static inline HVX_Vector Q6_Vh_vmpyiacc_VhVhRb(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	uint32_t r = (uint32_t)Rt;
+	for (int i = 0; i < 64; i++) Vx.h[i] = (int16_t)(Vx.h[i] + Vu.h[i] * HVXE_RB(i));
+	return Vx;
+}
+HVXE_VR(Q6_Vw_vmpyi_VwRh, w, 32, (int64_t)((uint64_t)a * (uint64_t)(int64_t)HVXE_RH(i)))
+
+// 32x16 products: Vv supplies the even (vmpye) or odd (vmpyo) halfword of each word
+HVXE_VV(Q6_Vw_vmpye_VwVuh, w, 32, (a * (uint16_t)b) >> 16)
+HVXE_VV(Q6_Vw_vmpyie_VwVuh, w, 32, (int64_t)((uint64_t)a * (uint16_t)b))
+HVXE_VV(Q6_Vw_vmpyio_VwVh, w, 32, (int64_t)((uint64_t)a * (uint64_t)(int64_t)(b >> 16)))
+HVXE_VV(Q6_Vw_vmpyo_VwVh_s1_sat, w, 32, hvxe_sat32((a * (b >> 16)) >> 15))
+HVXE_VV(Q6_Vw_vmpyo_VwVh_s1_rnd_sat, w, 32, hvxe_sat32(((a * (b >> 16) << 1) + 0x8000) >> 16))
+
+static inline HVX_Vector Q6_Vw_vmpyoacc_VwVwVh_s1_sat_shift(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv)
+{
+	for (int i = 0; i < 32; i++) {
+		int64_t p = (int64_t)Vx.w[i] + (int64_t)Vu.w[i] * (Vv.w[i] >> 16);
+		Vx.w[i] = hvxe_sat32((p << 1) >> 16);
+	}
+	return Vx;
+}
+static inline HVX_Vector Q6_Vw_vmpyoacc_VwVwVh_s1_rnd_sat_shift(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv)
+{
+	for (int i = 0; i < 32; i++) {
+		int64_t p = (int64_t)Vx.w[i] + (int64_t)Vu.w[i] * (Vv.w[i] >> 16);
+		Vx.w[i] = hvxe_sat32(((p << 1) + 0x8000) >> 16);
+	}
+	return Vx;
+}
+
+// widening multiplies; even source lanes go to lo, odd to hi
+HVXE_WIDEN(hvxe_c_Ww_vmpy_VhVh, h, w, 32, a * b)
+HVXE_WIDEN(Q6_Ww_vmpy_VhVuh, h, w, 32, a * (uint16_t)b)
+HVXE_WIDEN(Q6_Wuw_vmpy_VuhVuh, uh, uw, 32, a * b)
+HVXE_WIDEN(Q6_Wuh_vmpy_VubVub, ub, uh, 64, a * b)
+HVXE_WIDEN_ACC(Q6_Ww_vmpyacc_WwVhVh, h, w, 32, x + a * b)
+HVXE_WIDEN_ACC(Q6_Wuw_vmpyacc_WuwVuhVuh, uh, uw, 32, x + a * b)
+HVXE_WIDEN_ACC(Q6_Wuh_vmpyacc_WuhVubVub, ub, uh, 64, x + a * b)
+HVXE_WIDEN_R(Q6_Ww_vmpy_VhRh, h, w, 32, a * HVXE_RH(j))
+HVXE_WIDEN_R(Q6_Wuw_vmpy_VuhRuh, uh, uw, 32, a * HVXE_RUH(j))
+HVXE_WIDEN_R(Q6_Wuh_vmpy_VubRub, ub, uh, 64, a * HVXE_RUB(j))
+HVXE_WIDEN_RACC(Q6_Ww_vmpyacc_WwVhRh, h, w, 32, x + a * HVXE_RH(j))
+HVXE_WIDEN_RACC(Q6_Ww_vmpyacc_WwVhRh_sat, h, w, 32, hvxe_sat32(x + a * HVXE_RH(j)))
+HVXE_WIDEN_RACC(Q6_Wuw_vmpyacc_WuwVuhRuh, uh, uw, 32, x + a * HVXE_RUH(j))
+HVXE_WIDEN_RACC(Q6_Wuh_vmpyacc_WuhVubRub, ub, uh, 64, x + a * HVXE_RUB(j))
+HVXE_WIDEN_RACC(Q6_Wh_vmpyacc_WhVubRb, ub, h, 64, x + a * HVXE_RB(j))
+
+#if defined(HVX_EMUL_AVX2)
+// even (odd) products via madd, with the odd (even) halfword of Vu masked to zero
+static inline HVX_VectorPair Q6_Ww_vmpy_VhVh(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_VectorPair d;
+	__m256i me = _mm256_set1_epi32(0xFFFF), mo = _mm256_set1_epi32((int)0xFFFF0000u);
+	for (int k = 0; k < 128; k += 32) {
+		__m256i a = hvxe_simd_ld(&Vu.ub[k]), b = hvxe_simd_ld(&Vv.ub[k]);
+		hvxe_simd_st(&d.v[0].ub[k], _mm256_madd_epi16(_mm256_and_si256(a, me), b));
+		hvxe_simd_st(&d.v[1].ub[k], _mm256_madd_epi16(_mm256_and_si256(a, mo), b));
+	}
+	return d;
+}
+#else
+static inline HVX_VectorPair Q6_Ww_vmpy_VhVh(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_c_Ww_vmpy_VhVh(Vu, Vv); }
+#endif
+
+// vmpa: Vdd.v[0] pairs the even lanes of Vuu.v[0] and Vuu.v[1], Vdd.v[1] the odd lanes
+static inline HVX_VectorPair Q6_Wh_vmpa_WubRb(HVX_VectorPair Vuu, Word32 Rt)
+{
+	HVX_VectorPair d;
+	uint32_t r = (uint32_t)Rt;
+	for (int i = 0; i < 64; i++) {
+		d.v[0].h[i] = (int16_t)(Vuu.v[0].ub[2 * i] * HVXE_RB(0) + Vuu.v[1].ub[2 * i] * HVXE_RB(1));
+		d.v[1].h[i] = (int16_t)(Vuu.v[0].ub[2 * i + 1] * HVXE_RB(2) + Vuu.v[1].ub[2 * i + 1] * HVXE_RB(3));
+	}
+	return d;
+}
+static inline HVX_VectorPair Q6_Wh_vmpa_WubRub(HVX_VectorPair Vuu, Word32 Rt)
+{
+	HVX_VectorPair d;
+	uint32_t r = (uint32_t)Rt;
+	for (int i = 0; i < 64; i++) {
+		d.v[0].uh[i] = (uint16_t)(Vuu.v[0].ub[2 * i] * HVXE_RUB(0) + Vuu.v[1].ub[2 * i] * HVXE_RUB(1));
+		d.v[1].uh[i] = (uint16_t)(Vuu.v[0].ub[2 * i + 1] * HVXE_RUB(2) + Vuu.v[1].ub[2 * i + 1] * HVXE_RUB(3));
+	}
+	return d;
+}
+static inline HVX_VectorPair Q6_Wh_vmpaacc_WhWubRb(HVX_VectorPair Vxx, HVX_VectorPair Vuu, Word32 Rt)
+{
+	HVX_VectorPair p = Q6_Wh_vmpa_WubRb(Vuu, Rt);
+	return Q6_Wh_vadd_WhWh(Vxx, p);
+}
+static inline HVX_VectorPair Q6_Wh_vmpa_WubWb(HVX_VectorPair Vuu, HVX_VectorPair Vvv)
+{
+	HVX_VectorPair d;
+	for (int k = 0; k < 2; k++) {
+		for (int i = 0; i < 64; i++) {
+			int j = 2 * i + k;
+			d.v[k].h[i] = (int16_t)(Vuu.v[0].ub[j] * Vvv.v[0].b[j] + Vuu.v[1].ub[j] * Vvv.v[1].b[j]);
+		}
+	}
+	return d;
+}
+
+// vdmpy: sum of adjacent pairs; vrmpy: sum of groups of four
+static inline HVX_Vector Q6_Vh_vdmpy_VubRb(HVX_Vector Vu, Word32 Rt)
+{
+	HVX_Vector d;
+	uint32_t r = (uint32_t)Rt;
+	for (int i = 0; i < 64; i++) d.h[i] = (int16_t)(Vu.ub[2 * i] * HVXE_RB(2 * i) + Vu.ub[2 * i + 1] * HVXE_RB(2 * i + 1));
+	return d;
+}
+static inline HVX_Vector Q6_Vw_vdmpy_VhRb(HVX_Vector Vu, Word32 Rt)
+{
+	HVX_Vector d;
+	uint32_t r = (uint32_t)Rt;
+	for (int i = 0; i < 32; i++) d.w[i] = Vu.h[2 * i] * HVXE_RB(2 * i) + Vu.h[2 * i + 1] * HVXE_RB(2 * i + 1);
+	return d;
+}
+static inline HVX_Vector Q6_Vw_vdmpy_VhVh_sat(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 32; i++) {
+		d.w[i] = hvxe_sat32((int64_t)Vu.h[2 * i] * Vv.h[2 * i] + (int64_t)Vu.h[2 * i + 1] * Vv.h[2 * i + 1]);
+	}
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vdmpyacc_VhVubRb(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vh_vadd_VhVh(Vx, Q6_Vh_vdmpy_VubRb(Vu, Rt));
+}
+static inline HVX_Vector Q6_Vw_vdmpyacc_VwVhRb(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vw_vadd_VwVw(Vx, Q6_Vw_vdmpy_VhRb(Vu, Rt));
+}
+
+static inline HVX_Vector hvxe_c_vrmpy_ubr(HVX_Vector Vu, Word32 Rt, int rsigned)
+{
+	HVX_Vector d;
+	uint32_t r = (uint32_t)Rt;
+	for (int i = 0; i < 32; i++) {
+		int32_t s = 0;
+		for (int k = 0; k < 4; k++) s += Vu.ub[4 * i + k] * (rsigned ? HVXE_RB(k) : HVXE_RUB(k));
+		d.w[i] = s;
+	}
+	return d;
+}
+static inline HVX_Vector hvxe_c_vrmpy_bb(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 32; i++) {
+		int32_t s = 0;
+		for (int k = 0; k < 4; k++) s += Vu.b[4 * i + k] * Vv.b[4 * i + k];
+		d.w[i] = s;
+	}
+	return d;
+}
+#if defined(HVX_EMUL_AVX2)
+// bytes split into even/odd 16-bit lanes, then madd: 2 products per madd, 2 madds per word
+static inline HVX_Vector hvxe_vrmpy_ubr(HVX_Vector Vu, Word32 Rt, int rsigned)
+{
+	HVX_Vector d;
+	uint32_t r = (uint32_t)Rt;
+	int32_t w0 = rsigned ? HVXE_RB(0) : HVXE_RUB(0), w1 = rsigned ? HVXE_RB(1) : HVXE_RUB(1);
+	int32_t w2 = rsigned ? HVXE_RB(2) : HVXE_RUB(2), w3 = rsigned ? HVXE_RB(3) : HVXE_RUB(3);
+	__m256i we = _mm256_set1_epi32((w0 & 0xFFFF) | (w2 << 16));
+	__m256i wo = _mm256_set1_epi32((w1 & 0xFFFF) | (w3 << 16));
+	__m256i m = _mm256_set1_epi16(0xFF);
+	for (int k = 0; k < 128; k += 32) {
+		__m256i a = hvxe_simd_ld(&Vu.ub[k]);
+		__m256i s = _mm256_madd_epi16(_mm256_and_si256(a, m), we);
+		s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_srli_epi16(a, 8), wo));
+		hvxe_simd_st(&d.ub[k], s);
+	}
+	return d;
+}
+static inline HVX_Vector hvxe_vrmpy_bb(HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_Vector d;
+	for (int k = 0; k < 128; k += 32) {
+		__m256i a = hvxe_simd_ld(&Vu.ub[k]), b = hvxe_simd_ld(&Vv.ub[k]);
+		__m256i ae = _mm256_srai_epi16(_mm256_slli_epi16(a, 8), 8), be = _mm256_srai_epi16(_mm256_slli_epi16(b, 8), 8);
+		__m256i s = _mm256_madd_epi16(ae, be);
+		s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_srai_epi16(a, 8), _mm256_srai_epi16(b, 8)));
+		hvxe_simd_st(&d.ub[k], s);
+	}
+	return d;
+}
+#else
+static inline HVX_Vector hvxe_vrmpy_ubr(HVX_Vector Vu, Word32 Rt, int rsigned) { return hvxe_c_vrmpy_ubr(Vu, Rt, rsigned); }
+static inline HVX_Vector hvxe_vrmpy_bb(HVX_Vector Vu, HVX_Vector Vv) { return hvxe_c_vrmpy_bb(Vu, Vv); }
+#endif
+static inline HVX_Vector Q6_Vuw_vrmpy_VubRub(HVX_Vector Vu, Word32 Rt) { return hvxe_vrmpy_ubr(Vu, Rt, 0); }
+static inline HVX_Vector Q6_Vw_vrmpy_VubRb(HVX_Vector Vu, Word32 Rt) { return hvxe_vrmpy_ubr(Vu, Rt, 1); }
+static inline HVX_Vector Q6_Vuw_vrmpyacc_VuwVubRub(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vw_vadd_VwVw(Vx, hvxe_vrmpy_ubr(Vu, Rt, 0));
+}
+static inline HVX_Vector Q6_Vw_vrmpyacc_VwVubRb(HVX_Vector Vx, HVX_Vector Vu, Word32 Rt)
+{
+	return Q6_Vw_vadd_VwVw(Vx, hvxe_vrmpy_ubr(Vu, Rt, 1));
+}
+static inline HVX_Vector Q6_Vw_vrmpyacc_VwVbVb(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv)
+{
+	return Q6_Vw_vadd_VwVw(Vx, hvxe_vrmpy_bb(Vu, Vv));
+}
+
+// v65 polynomial helpers: the top two bits of Vu.uh select a coefficient from Rtt
+static inline HVX_Vector Q6_Vh_vlut4_VuhPh(HVX_Vector Vu, Word64 Rtt)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 64; i++) d.h[i] = (int16_t)(Rtt >> (16 * (Vu.uh[i] >> 14)));
+	return d;
+}
+static inline HVX_Vector Q6_Vh_vmpa_VhVhVuhPuh_sat(HVX_Vector Vx, HVX_Vector Vu, Word64 Rtt)
+{
+	for (int i = 0; i < 64; i++) {
+		int64_t c = (uint16_t)(Rtt >> (16 * (Vu.uh[i] >> 14)));
+		Vx.h[i] = (int16_t)hvxe_sat16(((int64_t)Vx.h[i] * Vu.uh[i] + (c << 15)) >> 16);
+	}
+	return Vx;
+}
+static inline HVX_Vector Q6_Vh_vmps_VhVhVuhPuh_sat(HVX_Vector Vx, HVX_Vector Vu, Word64 Rtt)
+{
+	for (int i = 0; i < 64; i++) {
+		int64_t c = (uint16_t)(Rtt >> (16 * (Vu.uh[i] >> 14)));
+		Vx.h[i] = (int16_t)hvxe_sat16(((int64_t)Vx.h[i] * Vu.uh[i] - (c << 15)) >> 16);
+	}
+	return Vx;
+}
+#undef HVXE_RB
+#undef HVXE_RUB
+#undef HVXE_RH
+#undef HVXE_RUH
+
+////////////////////////////////////////////////////////
+// table lookups
+// vlut32: byte lanes of Vu index the 64 halfwords of Vv; Rt selects which 32-entry
+// segment matches (Rt & 7, against index bits 7:5) and which byte of the halfword to take.
+// vlut16: as vlut32, with 16-entry segments of 32-bit table entries, giving halfwords.
+////////////////////////////////////////////////////////
+
+static inline HVX_Vector hvxe_c_vlut32(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int acc)
+{
+	int match = (Rt & 7) << 5;
+	int oddhalf = (Rt >> 1) & 1;
+	for (int i = 0; i < 128; i++) {
+		int idx = Vu.ub[i];
+		uint8_t t = ((idx & 0xE0) == match) ? Vv.ub[2 * (idx % 64) + oddhalf] : 0;
+		Vx.ub[i] = acc ? (Vx.ub[i] | t) : t;
+	}
+	return Vx;
+}
+#if defined(HVX_EMUL_AVX2)
+// the 64 selected table bytes as four 16-byte pshufb tables, chosen by index bits 5:4
+static inline HVX_Vector hvxe_vlut32(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int acc)
+{
+	uint8_t tb[64];
+	__m256i t[4];
+	int oddhalf = (Rt >> 1) & 1;
+	for (int k = 0; k < 64; k++) tb[k] = Vv.ub[2 * k + oddhalf];
+	for (int s = 0; s < 4; s++) t[s] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&tb[16 * s]));
+	__m256i match = _mm256_set1_epi8((char)((Rt & 7) << 5));
+	__m256i lo4 = _mm256_set1_epi8(0x0F), seg = _mm256_set1_epi8(0x30), hi3 = _mm256_set1_epi8((char)0xE0);
+	for (int k = 0; k < 128; k += 32) {
+		__m256i idx = hvxe_simd_ld(&Vu.ub[k]);
+		__m256i lo = _mm256_and_si256(idx, lo4);
+		__m256i sg = _mm256_and_si256(idx, seg);
+		__m256i r = _mm256_setzero_si256();
+		for (int s = 0; s < 4; s++) {
+			__m256i sel = _mm256_cmpeq_epi8(sg, _mm256_set1_epi8((char)(s << 4)));
+			r = _mm256_or_si256(r, _mm256_and_si256(sel, _mm256_shuffle_epi8(t[s], lo)));
+		}
+		r = _mm256_and_si256(r, _mm256_cmpeq_epi8(_mm256_and_si256(idx, hi3), match));
+		if (acc) r = _mm256_or_si256(r, hvxe_simd_ld(&Vx.ub[k]));
+		hvxe_simd_st(&Vx.ub[k], r);
+	}
+	return Vx;
+}
+#elif defined(HVX_EMUL_NEON)
+// the 64 selected table bytes as a 4-register vqtbl4q table; out-of-range indices give 0
+static inline HVX_Vector hvxe_vlut32(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int acc)
+{
+	uint8_t tb[64];
+	int oddhalf = (Rt >> 1) & 1;
+	for (int k = 0; k < 64; k++) tb[k] = Vv.ub[2 * k + oddhalf];
+	uint8x16x4_t t = vld1q_u8_x4(tb);
+	uint8x16_t match = vdupq_n_u8((uint8_t)((Rt & 7) << 5));
+	for (int k = 0; k < 128; k += 16) {
+		uint8x16_t idx = vld1q_u8(&Vu.ub[k]);
+		uint8x16_t r = vqtbl4q_u8(t, vandq_u8(idx, vdupq_n_u8(0x3F)));
+		r = vandq_u8(r, vceqq_u8(vandq_u8(idx, vdupq_n_u8(0xE0)), match));
+		if (acc) r = vorrq_u8(r, vld1q_u8(&Vx.ub[k]));
+		vst1q_u8(&Vx.ub[k], r);
+	}
+	return Vx;
+}
+#else
+static inline HVX_Vector hvxe_vlut32(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int acc)
+{
+	return hvxe_c_vlut32(Vx, Vu, Vv, Rt, acc);
+}
+#endif
+static inline HVX_Vector Q6_Vb_vlut32_VbVbR(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_vlut32(Vu, Vu, Vv, Rt, 0); }
+static inline HVX_Vector Q6_Vb_vlut32_VbVbI(HVX_Vector Vu, HVX_Vector Vv, int Iu3) { return hvxe_vlut32(Vu, Vu, Vv, Iu3 & 7, 0); }
+static inline HVX_Vector Q6_Vb_vlut32or_VbVbVbR(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_vlut32(Vx, Vu, Vv, Rt, 1); }
+static inline HVX_Vector Q6_Vb_vlut32or_VbVbVbI(HVX_Vector Vx, HVX_Vector Vu, HVX_Vector Vv, int Iu3) { return hvxe_vlut32(Vx, Vu, Vv, Iu3 & 7, 1); }
+
+// even index bytes produce the lo vector, odd index bytes the hi vector
+static inline HVX_VectorPair hvxe_vlut16(HVX_VectorPair Vxx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt, int acc, int nomatch)
+{
+	int match = (Rt & 0xF) << 4;
+	int oddhalf = (Rt >> 1) & 1;
+	for (int i = 0; i < 64; i++) {
+		for (int k = 0; k < 2; k++) {
+			int idx = Vu.ub[2 * i + k];
+			if (nomatch) idx = (idx & 0xF) | match;
+			uint16_t t = ((idx & 0xF0) == match) ? Vv.uh[2 * (idx % 32) + oddhalf] : 0;
+			Vxx.v[k].uh[i] = acc ? (Vxx.v[k].uh[i] | t) : t;
+		}
+	}
+	return Vxx;
+}
+static inline HVX_VectorPair Q6_Wh_vlut16_VbVhR(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt)
+{
+	HVX_VectorPair z = Q6_W_vcombine_VV(Vu, Vu);
+	return hvxe_vlut16(z, Vu, Vv, Rt, 0, 0);
+}
+static inline HVX_VectorPair Q6_Wh_vlut16_VbVhI(HVX_Vector Vu, HVX_Vector Vv, int Iu3) { return Q6_Wh_vlut16_VbVhR(Vu, Vv, Iu3 & 7); }
+static inline HVX_VectorPair Q6_Wh_vlut16_VbVhR_nomatch(HVX_Vector Vu, HVX_Vector Vv, Word32 Rt)
+{
+	HVX_VectorPair z = Q6_W_vcombine_VV(Vu, Vu);
+	return hvxe_vlut16(z, Vu, Vv, Rt, 0, 1);
+}
+static inline HVX_VectorPair Q6_Wh_vlut16or_WhVbVhR(HVX_VectorPair Vxx, HVX_Vector Vu, HVX_Vector Vv, Word32 Rt) { return hvxe_vlut16(Vxx, Vu, Vv, Rt, 1, 0); }
+static inline HVX_VectorPair Q6_Wh_vlut16or_WhVbVhI(HVX_VectorPair Vxx, HVX_Vector Vu, HVX_Vector Vv, int Iu3) { return hvxe_vlut16(Vxx, Vu, Vv, Iu3 & 7, 1, 0); }
+
+////////////////////////////////////////////////////////
+// predicates
+// A predicate holds one flag per byte; an operation on elements of N bytes sets or
+// tests all N flags of the element (tests use the lowest).
+////////////////////////////////////////////////////////
+
+HVXE_QVV(Q6_Q_vcmp_eq_VbVb, b, 1, a == b)
+HVXE_QVV(Q6_Q_vcmp_eq_VhVh, h, 2, a == b)
+HVXE_QVV(Q6_Q_vcmp_eq_VwVw, w, 4, a == b)
+HVXE_QVV(Q6_Q_vcmp_gt_VbVb, b, 1, a > b)
+HVXE_QVV(Q6_Q_vcmp_gt_VubVub, ub, 1, a > b)
+HVXE_QVV(Q6_Q_vcmp_gt_VhVh, h, 2, a > b)
+HVXE_QVV(Q6_Q_vcmp_gt_VuhVuh, uh, 2, a > b)
+HVXE_QVV(Q6_Q_vcmp_gt_VwVw, w, 4, a > b)
+HVXE_QVV(Q6_Q_vcmp_gt_VuwVuw, uw, 4, a > b)
+HVXE_QQVV(Q6_Q_vcmp_eqor_QVbVb, b, 1, |, a == b)
+HVXE_QQVV(Q6_Q_vcmp_gtor_QVbVb, b, 1, |, a > b)
+HVXE_QQVV(Q6_Q_vcmp_gtor_QVubVub, ub, 1, |, a > b)
+HVXE_QQVV(Q6_Q_vcmp_gtand_QVbVb, b, 1, &, a > b)
+
+#define HVXE_QQ(NAME, EXPR) \
+static inline HVX_VectorPred NAME(HVX_VectorPred Qs, HVX_VectorPred Qt) \
+{ \
+	HVX_VectorPred q; \
+	for (int i = 0; i < 128; i++) { \
+		int s = Qs.ub[i], t = Qt.ub[i]; \
+		(void)s; (void)t; \
+		q.ub[i] = (EXPR) & 1; \
+	} \
+	return q; \
+}
+HVXE_QQ(Q6_Q_and_QQ, s & t)
+HVXE_QQ(Q6_Q_or_QQ, s | t)
+HVXE_QQ(Q6_Q_xor_QQ, s ^ t)
+HVXE_QQ(Q6_Q_and_QQn, s & !t)
+HVXE_QQ(Q6_Q_or_QQn, s | !t)
+HVXE_QQ(Q6_Qb_vshuffe_QhQh, (i & 1) ? Qs.ub[i - 1] : Qt.ub[i])
+HVXE_QQ(Q6_Qh_vshuffe_QwQw, (i & 2) ? Qs.ub[i - 2] : Qt.ub[i])
+#undef HVXE_QQ
+
+static inline HVX_VectorPred Q6_Q_not_Q(HVX_VectorPred Qs)
+{
+	for (int i = 0; i < 128; i++) Qs.ub[i] ^= 1;
+	return Qs;
+}
+static inline HVX_VectorPred Q6_Q_vsetq_R(Word32 Rt)
+{
+	HVX_VectorPred q;
+	int n = Rt & 127;
+	for (int i = 0; i < 128; i++) q.ub[i] = (i < n);
+	return q;
+}
+static inline HVX_VectorPred Q6_Q_vsetq2_R(Word32 Rt)
+{
+	HVX_VectorPred q;
+	int n = (Rt - 1) & 127;
+	for (int i = 0; i < 128; i++) q.ub[i] = (i <= n);
+	return q;
+}
+static inline HVX_VectorPred Q6_Q_vandor_QVR(HVX_VectorPred Qx, HVX_Vector Vu, Word32 Rt)
+{
+	for (int i = 0; i < 128; i++) Qx.ub[i] |= ((Vu.ub[i] & hvxe_rbyte(Rt, i)) != 0);
+	return Qx;
+}
+static inline HVX_VectorPred Q6_Q_vand_VR(HVX_Vector Vu, Word32 Rt)
+{
+	HVX_VectorPred q;
+	memset(&q, 0, sizeof(q));
+	return Q6_Q_vandor_QVR(q, Vu, Rt);
+}
+static inline HVX_Vector Q6_V_vandor_VQR(HVX_Vector Vx, HVX_VectorPred Qu, Word32 Rt)
+{
+	for (int i = 0; i < 128; i++) Vx.ub[i] |= Qu.ub[i] ? hvxe_rbyte(Rt, i) : 0;
+	return Vx;
+}
+static inline HVX_Vector Q6_V_vand_QR(HVX_VectorPred Qu, Word32 Rt) { return Q6_V_vandor_VQR(Q6_V_vzero(), Qu, Rt); }
+static inline HVX_Vector Q6_V_vand_QnR(HVX_VectorPred Qu, Word32 Rt) { return Q6_V_vandor_VQR(Q6_V_vzero(), Q6_Q_not_Q(Qu), Rt); }
+
+static inline HVX_Vector Q6_V_vmux_QVV(HVX_VectorPred Qt, HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_Vector d;
+	for (int i = 0; i < 128; i++) d.ub[i] = Qt.ub[i] ? Vu.ub[i] : Vv.ub[i];
+	return d;
+}
+static inline HVX_Vector Q6_V_vand_QV(HVX_VectorPred Qv, HVX_Vector Vu) { return Q6_V_vmux_QVV(Qv, Vu, Q6_V_vzero()); }
+static inline HVX_Vector Q6_V_vand_QnV(HVX_VectorPred Qv, HVX_Vector Vu) { return Q6_V_vmux_QVV(Qv, Q6_V_vzero(), Vu); }
+static inline HVX_VectorPair Q6_W_vswap_QVV(HVX_VectorPred Qt, HVX_Vector Vu, HVX_Vector Vv)
+{
+	HVX_VectorPair d;
+	d.v[0] = Q6_V_vmux_QVV(Qt, Vu, Vv);
+	d.v[1] = Q6_V_vmux_QVV(Qt, Vv, Vu);
+	return d;
+}
+
+// inclusive running count of the set predicate bytes, at the last byte of each element
+static inline HVX_Vector Q6_Vb_prefixsum_Q(HVX_VectorPred Qv)
+{
+	HVX_Vector d;
+	int s = 0;
+	for (int i = 0; i < 128; i++) d.ub[i] = (uint8_t)(s += Qv.ub[i]);
+	return d;
+}
+static inline HVX_Vector Q6_Vw_prefixsum_Q(HVX_VectorPred Qv)
+{
+	HVX_Vector d;
+	int s = 0;
+	for (int i = 0; i < 128; i++) {
+		s += Qv.ub[i];
+		if ((i & 3) == 3) d.w[i / 4] = s;
+	}
+	return d;
+}
+
+// conditional accumulate: Vx += Vu (or -=) in the elements where Q (or !Q) is set
+static inline HVX_Vector Q6_Vw_condacc_QVwVw(HVX_VectorPred Qv, HVX_Vector Vx, HVX_Vector Vu)
+{
+	for (int i = 0; i < 32; i++) if (Qv.ub[4 * i]) Vx.w[i] = (int32_t)((uint32_t)Vx.w[i] + (uint32_t)Vu.w[i]);
+	return Vx;
+}
+static inline HVX_Vector Q6_Vw_condacc_QnVwVw(HVX_VectorPred Qv, HVX_Vector Vx, HVX_Vector Vu)
+{
+	return Q6_Vw_condacc_QVwVw(Q6_Q_not_Q(Qv), Vx, Vu);
+}
+static inline HVX_Vector Q6_Vw_condnac_QnVwVw(HVX_VectorPred Qv, HVX_Vector Vx, HVX_Vector Vu)
+{
+	for (int i = 0; i < 32; i++) if (!Qv.ub[4 * i]) Vx.w[i] = (int32_t)((uint32_t)Vx.w[i] - (uint32_t)Vu.w[i]);
+	return Vx;
+}
+static inline HVX_Vector Q6_Vb_condnac_QVbVb(HVX_VectorPred Qv, HVX_Vector Vx, HVX_Vector Vu)
+{
+	for (int i = 0; i < 128; i++) if (Qv.ub[i]) Vx.ub[i] = (uint8_t)(Vx.ub[i] - Vu.ub[i]);
+	return Vx;
+}
+
+////////////////////////////////////////////////////////
+// masked stores (the address is aligned down to a vector boundary) and scatter.
+// The non-temporal forms are the same as the plain ones here.
+////////////////////////////////////////////////////////
+
+static inline void hvxe_maskedstore(HVX_VectorPred Qv, void *A, HVX_Vector Vs, int want)
+{
+	uint8_t *p = (uint8_t *)((size_t)A & ~(size_t)127);
+	for (int i = 0; i < 128; i++) if (Qv.ub[i] == want) p[i] = Vs.ub[i];
+}
+static inline void Q6_vmaskedstoreq_QAV(HVX_VectorPred Qv, HVX_Vector *A, HVX_Vector Vs) { hvxe_maskedstore(Qv, A, Vs, 1); }
+static inline void Q6_vmaskedstorenq_QAV(HVX_VectorPred Qv, HVX_Vector *A, HVX_Vector Vs) { hvxe_maskedstore(Qv, A, Vs, 0); }
+static inline void Q6_vmaskedstorentq_QAV(HVX_VectorPred Qv, HVX_Vector *A, HVX_Vector Vs) { hvxe_maskedstore(Qv, A, Vs, 1); }
+static inline void Q6_vmaskedstorentnq_QAV(HVX_VectorPred Qv, HVX_Vector *A, HVX_Vector Vs) { hvxe_maskedstore(Qv, A, Vs, 0); }
+// defined as macros too, as by the tools that provide them (hvx_inlines.h tests for these)
+#define Q6_vmaskedstoreq_QAV Q6_vmaskedstoreq_QAV
+#define Q6_vmaskedstorenq_QAV Q6_vmaskedstorenq_QAV
+#define Q6_vmaskedstorentq_QAV Q6_vmaskedstorentq_QAV
+#define Q6_vmaskedstorentnq_QAV Q6_vmaskedstorentnq_QAV
+
+// Each element of Vw is stored at Rb + (offset in Vv, aligned to the element size) when its
+// predicate is set and the offset is within Mu. On hardware Rb is a 32-bit VTCM address; the
+// callers cast a pointer to it, so host builds are only meaningful with a 32-bit address space.
+static inline void Q6_vscatter_QRMVwV(HVX_VectorPred Qs, size_t Rb, Word32 Mu, HVX_Vector Vv, HVX_Vector Vw)
+{
+	for (int i = 0; i < 32; i++) {
+		uint32_t off = Vv.uw[i];
+		if (Qs.ub[4 * i] && off <= (uint32_t)Mu) memcpy((uint8_t *)(Rb + (off & ~3u)), &Vw.w[i], 4);
+	}
+}
+static inline void Q6_vscatter_QRMVhV(HVX_VectorPred Qs, size_t Rb, Word32 Mu, HVX_Vector Vv, HVX_Vector Vw)
+{
+	for (int i = 0; i < 64; i++) {
+		uint32_t off = Vv.uh[i];
+		if (Qs.ub[2 * i] && off <= (uint32_t)Mu) memcpy((uint8_t *)(Rb + (off & ~1u)), &Vw.h[i], 2);
+	}
+}
+
+#endif // HVX_EMUL_HVX_HEXAGON_PROTOS_H
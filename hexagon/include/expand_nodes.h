@@ -41,5 +41,7 @@
 int expand_transpose_conv_nodes(struct nn_graph *nn, struct nn_node **transpose_conv_node_p);
 int expand_grouped_conv_nodes(struct nn_graph *nn, struct nn_node **grouped_conv_node_p);
 int expand_dilated_conv_nodes(struct nn_graph *nn, struct nn_node **grouped_conv_node_p);
+int fuse_elementwise_chain_nodes(struct nn_graph *nn, struct nn_node **nodep);
+int fuse_image_preprocess_nodes(struct nn_graph *nn, struct nn_node **nodep);
 
 #endif //NN_GRAPH_EXPAND_NODES_H
@@ -37,6 +37,10 @@
 #ifndef NN_GRAPH_FLOAT_MATHOPS_H
 #define NN_GRAPH_FLOAT_MATHOPS_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
 //Implementation of Schraudolph's algorithm for exp(x) with a cubic correction for the mantissa
 //This saves a floating point division
 //max rel. error [-87.33654, 88.72283] = 8.34e-5
@@ -52,6 +56,65 @@ static inline __attribute__((unused,always_inline)) float fast_exp (float x) {
     return u.f;
 }
 
+//exp(x) via range reduction x = n*ln(2) + r, |r| <= ln(2)/2, and a degree-6 (Cephes) polynomial for exp(r)
+//ln(2) is split in two parts so that n*ln2_hi is exact
+//max rel. error [-87.33654, 88.0] < 2e-7; x is clamped to that range
+//No branches or table lookups, so loops calling this can be vectorized by the compiler
+static inline __attribute__((unused,always_inline)) float fast_expf_poly (float x) {
+    union { float f; int32_t i; } u;
+    x = fminf(fmaxf(x, -87.33654f), 88.0f);
+    float n = floorf(x * 1.44269504f + 0.5f);
+    float r = x - n * 0.693359375f;
+    r = r + n * 2.12194440e-4f;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.0f;
+    u.i = ((int32_t)n + 127) << 23;
+    return p * u.f;
+}
+
+//max over n (>=1) floats; 4 independent accumulators to break the dependency chain
+static inline __attribute__((unused)) float float_row_max(const float *in, int n) {
+    float m0 = in[0], m1 = in[0], m2 = in[0], m3 = in[0];
+    int i;
+    for (i = 0; i + 4 <= n; i += 4) {
+        m0 = fmaxf(m0, in[i + 0]);
+        m1 = fmaxf(m1, in[i + 1]);
+        m2 = fmaxf(m2, in[i + 2]);
+        m3 = fmaxf(m3, in[i + 3]);
+    }
+    for (; i < n; i++) m0 = fmaxf(m0, in[i]);
+    return fmaxf(fmaxf(m0, m1), fmaxf(m2, m3));
+}
+
+//sum of exp(beta*(in[i]-maxval)); the exp values are also stored to out[] when out != NULL
+static inline __attribute__((unused)) float float_row_sum_exp(const float *in, float *out, int n, float beta, float maxval) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    int i;
+    if (out != NULL) {
+        for (i = 0; i + 4 <= n; i += 4) {
+            s0 += (out[i + 0] = fast_expf_poly(beta * (in[i + 0] - maxval)));
+            s1 += (out[i + 1] = fast_expf_poly(beta * (in[i + 1] - maxval)));
+            s2 += (out[i + 2] = fast_expf_poly(beta * (in[i + 2] - maxval)));
+            s3 += (out[i + 3] = fast_expf_poly(beta * (in[i + 3] - maxval)));
+        }
+        for (; i < n; i++) s0 += (out[i] = fast_expf_poly(beta * (in[i] - maxval)));
+    } else {
+        for (i = 0; i + 4 <= n; i += 4) {
+            s0 += fast_expf_poly(beta * (in[i + 0] - maxval));
+            s1 += fast_expf_poly(beta * (in[i + 1] - maxval));
+            s2 += fast_expf_poly(beta * (in[i + 2] - maxval));
+            s3 += fast_expf_poly(beta * (in[i + 3] - maxval));
+        }
+        for (; i < n; i++) s0 += fast_expf_poly(beta * (in[i] - maxval));
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
 static inline float linear_interpolate(float s, float e, float t){
 	return s+(e-s)*t;//equivalent to (1-t)*s + t*e
 }
@@ -40,6 +40,9 @@
 typedef struct input hexagon_nn_input;
 typedef struct output hexagon_nn_output;
 typedef struct perfinfo hexagon_nn_perfinfo;
+typedef struct perfinfo_traffic hexagon_nn_perfinfo_traffic;
+typedef struct trace_event hexagon_nn_trace_event;
+typedef struct tuning_record hexagon_nn_tuning_record;
 typedef struct initinfo hexagon_nn_initinfo;
 
 typedef int32_t hexagon_nn_nn_id;
@@ -378,8 +378,9 @@ HVX_VectorPred q6op_Q_vsetq2_R( int rval)
 //   void q6op_vstcc_[n]QAV[_nt] ( cond, addr, vec );
 // These do *not* work in HVXDBL on 7.4.01 (compiler will abort with getRegForInlineAsmConstraint Unhandled data type)
 // occurs if these are used (it's ok to just have them in the header though). Seem to be ok with 8.0.05
+// (host builds using hvx_emul get these via Q6_vmaskedstore*)
 //
-#if defined(__hexagon__)
+#if defined(__hexagon__) || defined(Q6_vmaskedstoreq_QAV)
 static HVX_INLINE_ALWAYS void q6op_vstcc_QAV(  HVX_VectorPred cond, HVX_Vector *addr, HVX_Vector v )
 {
 #ifdef Q6_vmaskedstoreq_QAV
@@ -98,8 +98,8 @@ void quantize_asm(
 void vmemcpy_asm(void *dst, const void *src, int len);
 void vmemset_asm(void *dst, int val, int len);
 void vmemset_nt_asm(void *dst, int val, int len);
-void vmemset_short_asm(void *dst, int val, int len);
 #endif
+void vmemset_short_asm(void *dst, int val, int len);
 
 // 2d vector memcpy with src_pitch, dst_pitch being multiples of  vector
 void vmemcpy_2d_asm(
@@ -222,6 +222,8 @@ int nn_check_prepare_hvx_opt(
 		const uint8_t *a_data,
 		const uint8_t *b_data,
 		struct hvx_info *opt_info);
+// scratch_hint for the ops which use it
+int nn_check_prepare_hvx_opt_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes);
 
 static inline int __attribute__((always_inline))
 check_prepare_hvx_opt(
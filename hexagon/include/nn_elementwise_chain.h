@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef NN_ELEMENTWISE_CHAIN_H
+#define NN_ELEMENTWISE_CHAIN_H 1
+/*
+ * ElementwiseChain_f is a chain of float elementwise ops (Add_f, Sub_f, Mul_f,
+ * Minimum_f, Maximum_f, Relu_f, ReluX_f, Clamp_f, Neg_f, Abs_f) fused into one
+ * node by the prepare pass fuse_elementwise_chain_nodes.
+ *
+ * Input 0 is an int32 'program' of ELTWC_STEP_WORDS words per step:
+ *     { opcode, operand, imm }
+ * and each step updates a running value 'acc'; e.g. ELTWC_SUB does acc = acc - x,
+ * where x is input #operand (>= 1), or acc itself (ELTWC_OPND_ACC), or the float
+ * whose bits are in imm (ELTWC_OPND_IMM). The first step is always ELTWC_LOAD.
+ *
+ * The other inputs are broadcast to the output shape, as for Add_f (each
+ * dimension is the same as the output's, or 1). Since the ops are all
+ * elementwise, the result is the same as that of the original chain.
+ */
+
+enum eltwc_opcode {
+	ELTWC_LOAD,		// acc = x
+	ELTWC_ADD,		// acc = acc + x
+	ELTWC_SUB,		// acc = acc - x
+	ELTWC_RSUB,		// acc = x - acc
+	ELTWC_MUL,		// acc = acc * x
+	ELTWC_MIN,		// acc = fminf(acc,x)
+	ELTWC_MAX,		// acc = fmaxf(acc,x)
+	ELTWC_NEG,		// acc = -acc
+	ELTWC_ABS,		// acc = fabsf(acc)
+	ELTWC_N_OPCODES
+};
+
+#define ELTWC_OPND_ACC (-1)
+#define ELTWC_OPND_IMM (-2)
+
+#define ELTWC_STEP_WORDS 3
+#define ELTWC_MAX_STEPS 16
+#define ELTWC_MAX_INPUTS 9		// the program, and up to 8 operands
+
+#endif
@@ -54,6 +54,7 @@
 #include <platform.h>
 #include <stdio.h>
 #include <nn_graph_earlywork.h>
+#include <nn_graph_copyeng.h>
 
 #include "nn_graph_looping.h"
 
@@ -84,6 +85,8 @@ struct nn_node {
 	uint32_t refs;			// time op was referenced by any output
 	uint64_t perfcounter;		// performance counter
 	uint64_t iter_cycles;		// cycles consumed in last execution
+	struct nn_prefetch prefetch;	// prefetch for the next node, issued before this one runs
+	struct nn_batchpar_segment *batchpar;	// if not NULL, run this node and the rest of the segment batch-parallel
         struct udo_node_info udo_info;  // udo function and data pointers
 };
 
@@ -91,6 +94,7 @@ enum nn_node_flags {			// 'flags' field
 	NN_NODE_FLAG_RETAIN = (1<<0),		// don't remove this node in prepare, even if it has no consumers (set in ctor)
 										// RETAIN is set if n_outputs==0, also for things like Variable and Assign.
 	NN_NODE_FLAG_NO_CONVERT_D32 = (1<<1), // don't convert to d32. Used for nodes generated e.g. by metanodes.
+	NN_NODE_FLAG_SCRATCH_PLANNED = (1<<2), // the node's scratch_hint was planned for (set by nn_scratch_plan_graph)
 };
 
 enum nn_graph_state {
@@ -105,6 +109,13 @@ enum {
 	NN_GRAPH_PERFEVENT_USER1 = 2,
 	NN_GRAPH_PERFEVENT_HWPMU = 3,
 	NN_GRAPH_PERFEVENT_UTIME = 5,
+	// Host (non-hexagon) Linux builds only; counted with perf_event_open over all
+	// threads of the process. NN_GRAPH_PERFEVENT_CYCLES maps to cpu cycles there.
+	NN_GRAPH_PERFEVENT_HOST_INSTRUCTIONS = 0x200,
+	NN_GRAPH_PERFEVENT_HOST_CACHE_REFERENCES = 0x201,
+	NN_GRAPH_PERFEVENT_HOST_CACHE_MISSES = 0x202,
+	NN_GRAPH_PERFEVENT_HOST_BRANCH_MISSES = 0x203,
+	NN_GRAPH_PERFEVENT_HOST_L1D_READ_MISSES = 0x204,
 };
 ////////////////////////// Batch Sequence data structures ////////////////
 
@@ -191,6 +202,9 @@ struct udo_node {
         struct udo_node* next;
 };
 
+// called by do_execute after each node has executed (see nn_graph.node_observer)
+typedef void (*nn_node_observer_fn)(struct nn_graph *nn, struct nn_node *node, void *opaque);
+
 struct nn_graph {
 	struct nn_node *head;		// First node in graph list
 	struct nn_node *tail;		// 'weak' tail pointer
@@ -251,6 +265,19 @@ struct nn_graph {
         uint32_t num_udos;
         struct udo_node* udo_list_start;
         struct udo_node* udo_list_end;
+
+	// If set, called after every node execution (node->iter_cycles is valid).
+	// Only for tools linked directly with the library (e.g. test/layer_sweep.c);
+	// there is no way to set it over RPC.
+	nn_node_observer_fn node_observer;
+	void *node_observer_opaque;
+
+	struct nn_trace *trace;		// execution trace rings, when trace_events option != 0
+	struct nn_tuning_db *tuning;	// tuning database (see nn_graph_tuning.h), NULL if empty
+	struct nn_copyeng copyeng;	// copy engine (see nn_graph_copyeng.h)
+	struct nn_batchpar_segment *batchpar_segs;	// batch-parallel segments (see nn_graph_batchpar.h)
+	struct nn_batchpar_worker *batchpar_worker;	// only set in a batch-parallel worker's copy of the graph
+	int scratch_planned;		// the node executing has NN_NODE_FLAG_SCRATCH_PLANNED (set by do_execute)
 };
 
 // this sets the noderefhash field on a node. Call after changing src_id
@@ -279,49 +306,30 @@ noderefhash_mask( uint32_t node_id ){
 //  .. and then finally 
 //  nn_mcmanager_wait( nn, &mcman );
 //  ... which waits until all are done. This *must* done before mcman goes
-//  out of scope.
+//  out of scope. A node which only copies can instead end with
+//  nn_mcmanager_defer( nn, &mcman, self ), and return while the copies finish
+//  (see nn_copyeng_defer).
 //  You can now let mcman go out of scope, or start with more copies.
 //
 //  The various memcpy/memset operations done before 'wait' may be done in parallel
-//  threads and may be deeply reordered. No more than NN_MEMCPY_MANAGER_MAX_THREADS
-//  will be outstanding at any time.
+//  threads and may be deeply reordered. They are queued on the graph's copy engine
+//  (nn_graph_copyeng.h), so up to NN_COPYENG_RING may be outstanding, and a node can
+//  use the engine directly (with fences) to start compute before all the copies are done.
 // Note: the API is not itself thread-safe; the init, copy requests, and wait must
 // all be done in the same thread.
 //
 // regarding nn_mcmanager_vmemset32: the 'value' is 32 bits, but the 'len' is in
 // bytes; and the len can be any number, start pointer any alignment.
 //
-#define NN_MEMCPY_MANAGER_MAX_THREADS 2		// max # of pending ops.
-#define NN_MEMCPY_MANAGER_SLOTS 4			// of slots in struct (>= MAX_THREADS+2)
-
-// this encodes one of 3 operations:
-//  if src != NULL, rows = 0:
-//          vmemcpy( dst,src, len )
-//  if src != NULL, rows >=2:
-//      2-d memcpy rows x len; src_stride = val; dst_stride = dst_stride
-//  if src = NULL:
-//      2-d memset32 @ dst with dst_stride, max(1,rows) x len.
-struct nn_memcpy_manager_op {
-	void *dst;
-	void const *src;
-	unsigned len;
-	unsigned val;
-	unsigned rows;
-	unsigned dst_stride;
-};
 struct nn_memcpy_manager
 {
-	nn_sem_t done_sem;			// issued after each completion
-	int pending;				// # of wait(done_sem) pending
-	unsigned avglen;			// rough 'running average' of operation lengths.
-	volatile unsigned avail_set;			// bit set of available operation slots
-	volatile unsigned ready_set;			// slots ready but not picked up by run thread
-	struct nn_memcpy_manager_op ops[NN_MEMCPY_MANAGER_SLOTS];
+	nn_copy_fence_t fence;		// fence of the last operation queued (0 if none)
 };
 void nn_mcmanager_init(struct nn_graph *nn, struct nn_memcpy_manager * );
 void nn_mcmanager_vmemcpy_or_set(struct nn_graph *nn, struct nn_memcpy_manager *,
 	void *dst, void const * src, unsigned len, unsigned fillval );
 void nn_mcmanager_wait(struct nn_graph *nn, struct nn_memcpy_manager *);
+void nn_mcmanager_defer(struct nn_graph *nn, struct nn_memcpy_manager *, struct nn_node *self);
 
 static inline void nn_mcmanager_vmemcpy(struct nn_graph *nn, struct nn_memcpy_manager *mcm,
 	void *dst, void const * src, unsigned len )
@@ -362,6 +370,30 @@ static inline void nn_mcmanager_vmemset32_2d(struct nn_graph *nn, struct nn_memc
 		nn_manager_vmemcpy_or_set_2d( width, height, dst, NULL, dst_stride, fillval, nn, mcm );
 }
 
+// 3D operations: 'depth' planes of the 2d operation, each at plane_stride from the previous.
+// ** this is an internal function, to implement the 3d memcpy and fill.
+void
+nn_manager_vmemcpy_or_set_3d( int width, int height, int depth, void* dst, void const * src,
+	unsigned dst_stride, unsigned src_stride_or_fillval, int dst_plane_stride, int src_plane_stride,
+	struct nn_graph *nn, struct nn_memcpy_manager *mcm);
+
+static inline void nn_mcmanager_vmemcpy_3d(struct nn_graph *nn, struct nn_memcpy_manager *mcm,
+		int width, int height, int depth,
+		void * dst, unsigned dst_stride, int dst_plane_stride,
+		void const * src, unsigned src_stride, int src_plane_stride)
+{
+	if( src != NULL)
+		nn_manager_vmemcpy_or_set_3d( width, height, depth, dst, src, dst_stride, src_stride,
+			dst_plane_stride, src_plane_stride, nn, mcm );
+}
+
+static inline void nn_mcmanager_vmemset32_3d(struct nn_graph *nn, struct nn_memcpy_manager *mcm,
+		 void * dst, unsigned fillval, int width, int height, int depth, unsigned dst_stride, int dst_plane_stride)
+{
+	nn_manager_vmemcpy_or_set_3d( width, height, depth, dst, NULL, dst_stride, fillval,
+			dst_plane_stride, 0, nn, mcm );
+}
+
 //////////////////////////////////////////////
 
 // Within an execution function,
@@ -374,6 +406,8 @@ static inline void nn_scratch_reset(struct nn_graph *nn) { nn->scratch_nextalloc
 
 // nn_scratch_alloc is safe to call in multiple threads (but not thread_safe
 // with respect to any of the other nn_scratch functions).
+// A batch-parallel worker's graph copy is only ever used by one thread, so
+// its arena is handed out with a plain bump.
 //
 
 static inline void *nn_scratch_alloc(struct nn_graph *nn, size_t bytes)
@@ -386,6 +420,13 @@ static inline void *nn_scratch_alloc(struct nn_graph *nn, size_t bytes)
 	// Even for smaller requests, it may help to keep each one cache aligned.
 	bytes = (bytes+127)&~(size_t)127;
 
+	if (nn->batchpar_worker != NULL) {
+		oldoff = nn->scratch_nextalloc;
+		newoff = oldoff + bytes;
+		if (newoff > total) return NULL;
+		nn->scratch_nextalloc = newoff;
+		return scratch_base + oldoff;
+	}
 	volatile int32_t * nextalloc_p = & nn->scratch_nextalloc;
 	oldoff = *nextalloc_p;
 	do{
@@ -411,6 +452,23 @@ static inline void * nn_scratch_nextaddr( struct nn_graph const *nn){
 
 int nn_scratch_grow(struct nn_graph *nn, size_t bytes);
 
+//
+// Prepare-time scratch sizing.
+// nn_node_ops.scratch_hint( self, nn, &bytes) returns 0 with 'bytes' set to the most scratch
+// the node's execute can ask for (nn_scratch_grow, plus what it nn_scratch_allocs), given the
+// shapes the graph is prepared for; or nonzero if it can't tell.
+// After allocation, nn_scratch_plan_graph makes the scratch arena big enough for every node
+// which has a hint; and the arenas of batch-parallel workers are sized from the hints of
+// their segment's nodes.
+// Once the graph is prepared, nn_scratch_grow doesn't reallocate a batch-parallel worker's
+// arena. The graph's own is grown (and the growth logged) only for nodes without a hint;
+// a node whose hint turned out too small fails, unless the 'scratch_strict' option is 0.
+//
+int nn_scratch_plan_graph(struct nn_graph *nn);
+int nn_scratch_node_needs(struct nn_graph *nn, struct nn_node *node, uint32_t *bytes);
+// scratch_hint for ops which don't use scratch
+int nn_scratch_hint_none(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes);
+
 
 static inline uint32_t nn_graph_new_internal_node_id(struct nn_graph *nn)
 {
@@ -490,6 +548,34 @@ struct nn_node_io_range {
 // or in a ctor "subclass". The 'default' is equivalent to NN_IOCOUNT_GE(0)
 //
 
+//
+// Storage aliasing hints, used by the allocation planner (allocate.c).
+// nn_node_ops.alias_hint( self, nn, out_idx, &hint) is called for each output before allocation;
+// it returns 0 with hint->kind set, if the output can share storage with input hint->in_idx:
+//
+//   NN_ALIAS_INPLACE  the op may write the output over the input (same size and shape; each output
+//                     element is written only after the input elements it depends on are read).
+//                     This is only done when no other node reads the input's storage afterwards.
+//   NN_ALIAS_VIEW     the output is the input's data, starting hint->offset bytes in; when the data
+//                     pointers show this at execute, the op must not write the output at all.
+//                     The offset must not depend on the shapes seen at execute.
+//
+// An op with NN_NODE_FLAG_CLS_SUPPORTS_ALIAS and no alias_hint is taken to be INPLACE, input 0 -> output 0.
+// The planner skips inputs whose storage can move at execute (INPUT, Variable outputs).
+//
+enum nn_alias_kind {
+	NN_ALIAS_NONE = 0,
+	NN_ALIAS_INPLACE,
+	NN_ALIAS_VIEW,
+};
+struct nn_alias_hint {
+	int16_t kind;		// nn_alias_kind
+	int16_t in_idx;		// input whose storage is used
+	uint32_t offset;	// (VIEW only) byte offset into the input
+};
+// alias_hint function for ops whose output 0 is always a view of all of input 0 (e.g. reshape)
+int nn_alias_hint_view_input0(struct nn_node *self, struct nn_graph *nn, int out_idx, struct nn_alias_hint *hint);
+
 struct nn_node_ops {
 	int (*execute)(struct nn_node *self, struct nn_graph *nn);
 	int (*check)(struct nn_node *self, struct nn_graph *nn);
@@ -509,6 +595,8 @@ struct nn_node_ops {
 	int (*earlywork_register)(struct nn_node *self, struct nn_graph *nn, struct nn_early_work *work);
 	struct nn_node_io_range n_inputs;		// this defines allowed range of # inputs
 	struct nn_node_io_range n_outputs;		// this defines allowed range of # outputs
+	int (*alias_hint)(struct nn_node *self, struct nn_graph *nn, int out_idx, struct nn_alias_hint *hint);
+	int (*scratch_hint)(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes);	// see nn_scratch_plan_graph
 };
 extern struct nn_node_ops *optab[];
 
@@ -598,6 +686,7 @@ int do_variable_write_flat(
 
 int do_perfinfo_reset(struct nn_graph *nn, uint32_t event);
 int do_perfinfo_get(struct nn_graph *nn, struct perfinfo *info, uint32_t info_len);
+int do_perfinfo_traffic_get(struct nn_graph *nn, struct perfinfo_traffic *info, uint32_t info_len);
 
 
 // Convert an nn_id_t to a pointer to struct nn_graph
@@ -748,5 +837,8 @@ static inline int check_graph( struct nn_graph *nn, int options){ return 0; }
 #include <nn_graph_allocator.h>
 #include <nn_graph_find_node.h>
 #include <nn_graph_memcpy.h>
+#include <nn_graph_trace.h>
+#include <nn_graph_tuning.h>
+#include <nn_graph_batchpar.h>
 
 #endif
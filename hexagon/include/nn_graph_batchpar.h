@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NN_GRAPH_BATCHPAR_H
+#define NN_GRAPH_BATCHPAR_H 1
+/*
+ * Batch-parallel execution of graph segments.
+ *
+ * Most ops split their work within one batch (rows, depth slices), and run the
+ * batches one after another; for small layers that leaves threads idle. When the
+ * 'batch_parallel' option is N >= 2, nn_batchpar_plan_graph (run after allocation)
+ * finds runs of consecutive flat ops which treat each batch independently (the
+ * table in batchpar.c) and marks the first node of each run with a segment.
+ *
+ * do_execute hands a marked node to nn_batchpar_execute, which splits the batches
+ * of the segment's inputs (nn->batchseq.batchn per iteration, under batch sequencing;
+ * in units of batchseq.batch_quant where that divides them) over up to N vector threads. Each
+ * worker runs all of the segment's nodes on its own slice, using copies of the
+ * nodes whose tensors are views of the slice, and a copy of the graph with its
+ * own scratch arena (sized from the nodes' scratch hints, see nn_scratch_plan_graph); work
+ * the ops hand to nn_os_work_for_vector is then run inline,
+ * on the worker's thread.
+ *
+ * Each batched output (output 0, and any others the table marks, e.g. the top-k
+ * indices of Softmax_f) is laid out with a fixed per-batch stride (from output_defs)
+ * while the workers run, and is packed afterwards; other outputs (e.g. min/max) go
+ * to per-worker buffers, and must come out the same in all workers. If the inputs
+ * don't allow a split, or anything comes out unexpectedly, the segment is run in
+ * the usual way, one node after another (the planner makes sure nothing the
+ * segment reads is written by it, so this is always possible).
+ *
+ * Trace events, the node observer and output reporting (debug_show_output_tensors)
+ * are per node; while any of them is on, do_execute ignores the segments and runs
+ * each node itself (nn_batchpar_enabled). Otherwise the perf counts and cycles of
+ * a segment are split evenly over its nodes (nn_batchpar_account).
+ */
+
+struct nn_graph;
+struct nn_node;
+struct nn_batchpar_worker;
+
+enum nn_batchpar_kind {
+	NN_BATCHPAR_EXT_SHARED,		// made outside the segment, read as is by all workers
+	NN_BATCHPAR_EXT_BATCHED,	// made outside, each worker reads its batches (or all, if batches = 1)
+	NN_BATCHPAR_OUT_BATCHED,	// node output with the batch dim (e.g. output 0); each worker writes its batches
+	NN_BATCHPAR_OUT_REPLICATED,	// other node outputs; each worker has its own copy
+};
+
+struct nn_batchpar_tensor {
+	struct tensor *real;
+	uint8_t kind;			// nn_batchpar_kind
+	uint8_t shared_storage;		// (OUT_BATCHED) storage is reused by another tensor in the segment
+	uint32_t stride;		// (OUT_BATCHED) bytes per batch while the workers run
+	uint32_t max_batches;		// (OUT_BATCHED)
+	uint32_t repl_offset;		// (OUT_REPLICATED) offset in each worker's buffer
+};
+
+struct nn_batchpar_segment {
+	struct nn_batchpar_segment *next;	// list of all segments in the graph
+	struct nn_node *first;
+	struct nn_node *last;
+	int n_nodes;
+	int n_tensors;
+	int n_workers;
+	struct nn_batchpar_tensor *tensors;
+	struct nn_batchpar_worker *workers;
+};
+
+int nn_batchpar_plan_graph(struct nn_graph *nn);
+int nn_batchpar_execute(struct nn_graph *nn, struct nn_batchpar_segment *seg);
+int nn_batchpar_enabled(struct nn_graph *nn);
+void nn_batchpar_account(struct nn_batchpar_segment *seg, uint64_t perf, uint64_t cycles);
+void nn_batchpar_free(struct nn_graph *nn);
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NN_GRAPH_COPYENG_H
+#define NN_GRAPH_COPYENG_H 1
+/*
+ * Copy engine.
+ *
+ * Each graph has a ring of copy/fill descriptors, which are executed by the
+ * vector worker threads; each submitted descriptor posts one work item, which
+ * runs the oldest descriptor not yet started. Descriptors are submitted by the
+ * thread running the node's execute function (not from vector work); it only
+ * blocks when the ring is full.
+ *
+ * Submitting returns a fence: nn_copyeng_wait(nn,fence) returns once that
+ * descriptor and all earlier ones are complete. Vector work waits with
+ * nn_copyeng_wait_vector instead, which runs unstarted descriptors itself
+ * while it waits; so compute work can be queued right behind the copies it
+ * needs and start as soon as those are done. A descriptor can also depend on
+ * an earlier fence ('after'), e.g. to copy data another descriptor writes.
+ *
+ * A node which only moves data (Assign, Pad, Concat) can return with its copies
+ * still running, with nn_copyeng_defer. Before each later node, the executor
+ * (nn_copyeng_sync_node) waits only for deferred copies whose node's tensors
+ * overlap that node's: the tensors it reads, and the ones it writes (the copies'
+ * sources may be reused by then). Everything deferred is waited for at the end
+ * of the graph, and a defer waits at once when the executor hasn't allowed it
+ * (batch-parallel segments, node observers, output dumps).
+ *
+ * A descriptor moves (or fills) depth x height rows of width bytes:
+ *   row r of plane p starts at dst + p*dst_plane_stride + r*dst_row_stride
+ *   (likewise for src). If src is NULL, the rows are filled with the 32-bit
+ *   pattern 'fillval' (as vmemset_32_2d_general_asm; width need not be a
+ *   multiple of 4).
+ */
+#define NN_COPYENG_RING 64		// must be a power of 2
+
+typedef uint32_t nn_copy_fence_t;	// 0 is a fence that is always complete
+
+struct nn_copy_desc {
+	void *dst;
+	void const *src;		// NULL to fill
+	uint32_t width;			// bytes per row
+	uint32_t height;		// rows per plane (0 counts as 1)
+	uint32_t depth;			// planes (0 counts as 1)
+	int32_t dst_row_stride;
+	int32_t src_row_stride;
+	int32_t dst_plane_stride;
+	int32_t src_plane_stride;
+	uint32_t fillval;
+	nn_copy_fence_t after;		// don't start until this fence is complete (0 = no dependency)
+};
+
+#define NN_COPYENG_MAX_DEFERRED 8
+
+struct nn_node;
+struct nn_copyeng_deferred {
+	struct nn_node *node;		// node whose copies these are
+	nn_copy_fence_t fence;		// ... up to this fence
+};
+
+struct nn_copyeng {
+	volatile uint32_t submitted;	// # of descriptors ever submitted
+	volatile uint32_t started;	// # taken by a thread to run
+	volatile uint32_t completed;	// all descriptors before this one are complete
+	volatile int32_t n_waiters;	// threads blocked on wake_sem
+	nn_sem_t wake_sem;		// posted (once per waiter) when 'completed' advances
+	volatile uint32_t done_seq[NN_COPYENG_RING];	// seq # of the last completed descriptor in each slot
+	struct nn_copy_desc ring[NN_COPYENG_RING];
+	int defer_ok;			// set by the executor while a node may defer its copies
+	int n_deferred;
+	struct nn_copyeng_deferred deferred[NN_COPYENG_MAX_DEFERRED];	// oldest first
+};
+
+struct nn_graph;
+void nn_copyeng_init(struct nn_graph *nn);
+// queue a descriptor; returns its fence
+nn_copy_fence_t nn_copyeng_submit(struct nn_graph *nn, const struct nn_copy_desc *desc);
+// the fence of everything submitted so far
+nn_copy_fence_t nn_copyeng_fence(struct nn_graph *nn);
+int nn_copyeng_is_done(struct nn_graph *nn, nn_copy_fence_t fence);
+// wait in the execute thread
+void nn_copyeng_wait(struct nn_graph *nn, nn_copy_fence_t fence);
+// wait in a vector thread
+void nn_copyeng_wait_vector(struct nn_graph *nn, nn_copy_fence_t fence);
+// let 'self' return before its copies up to 'fence' are done (or wait now, if not allowed)
+void nn_copyeng_defer(struct nn_graph *nn, struct nn_node *self, nn_copy_fence_t fence);
+// executor: wait for the deferred copies 'node' depends on; or for all of them
+void nn_copyeng_sync_node(struct nn_graph *nn, struct nn_node *node);
+void nn_copyeng_sync_all(struct nn_graph *nn);
+
+static inline nn_copy_fence_t nn_copyeng_memcpy(struct nn_graph *nn, void *dst, void const *src, uint32_t len)
+{
+	struct nn_copy_desc desc = { .dst = dst, .src = src, .width = len };
+	return nn_copyeng_submit(nn,&desc);
+}
+static inline nn_copy_fence_t nn_copyeng_memcpy_2d(struct nn_graph *nn,
+	void *dst, int32_t dst_stride, void const *src, int32_t src_stride, uint32_t width, uint32_t height)
+{
+	struct nn_copy_desc desc = { .dst = dst, .src = src, .width = width, .height = height,
+		.dst_row_stride = dst_stride, .src_row_stride = src_stride };
+	return nn_copyeng_submit(nn,&desc);
+}
+static inline nn_copy_fence_t nn_copyeng_memset32_2d(struct nn_graph *nn,
+	void *dst, int32_t dst_stride, uint32_t fillval, uint32_t width, uint32_t height)
+{
+	struct nn_copy_desc desc = { .dst = dst, .width = width, .height = height,
+		.dst_row_stride = dst_stride, .fillval = fillval };
+	return nn_copyeng_submit(nn,&desc);
+}
+
+#endif
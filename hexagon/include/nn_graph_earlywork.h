@@ -47,6 +47,35 @@ struct nn_early_work {
 	int valid;
 };
 
+/*
+ * Look-ahead prefetch, for nodes without earlywork of their own.
+ *
+ * After allocation, nn_prefetch_plan_graph walks the nodes in execution order
+ * and, for each node, picks the largest input of the *next* node which is
+ * probably not in L2 any more: a const, or an activation not touched within the
+ * last NN_PREFETCH_L2_BYTES of node footprints (inputs + outputs). The current
+ * node's own footprint is taken from the L2 budget first, so that the prefetch
+ * does not evict what it is working on; if what's left is less than
+ * NN_PREFETCH_MIN_BYTES, nothing is planned.
+ *
+ * At execute, the main thread issues one l2fetch for the planned range just before
+ * the node's execute is called, and it runs in the background while the node runs.
+ * (An l2fetch issued later by the same thread replaces it; that's fine, it is only
+ * a hint).
+ */
+#define NN_PREFETCH_L2_BYTES (512*1024)
+#define NN_PREFETCH_MIN_BYTES (16*1024)
+
+struct nn_prefetch {
+	const struct tensor *tensor;	// input of the next node to prefetch (NULL if none)
+	uint32_t bytes;			// prefetch at most this much, from the start
+};
+
+struct nn_graph;
+struct nn_node;
+int nn_prefetch_plan_graph(struct nn_graph *nn);
+void nn_prefetch_issue(struct nn_graph *nn, struct nn_node *node);
+
 
 
 #endif
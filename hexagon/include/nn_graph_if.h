@@ -76,6 +76,69 @@ struct perfinfo {
 	};
 };
 
+// estimated memory traffic and MACs of one execution of a node
+struct perfinfo_traffic {
+	uint32_t node_id;
+	uint32_t executions;
+	union {
+		uint64_t bytes_read;
+		struct {
+			uint32_t bytes_read_lo;
+			uint32_t bytes_read_hi;
+		};
+	};
+	union {
+		uint64_t bytes_written;
+		struct {
+			uint32_t bytes_written_lo;
+			uint32_t bytes_written_hi;
+		};
+	};
+	union {
+		uint64_t macs;
+		struct {
+			uint32_t macs_lo;
+			uint32_t macs_hi;
+		};
+	};
+};
+
+// one event from the execution trace (see nn_graph_trace.h)
+struct trace_event {
+	union {
+		uint64_t ts;		// pcycles
+		struct {
+			uint32_t ts_lo;
+			uint32_t ts_hi;
+		};
+	};
+	uint32_t id;
+	uint32_t aux;
+	uint16_t kind;
+	uint16_t thread;
+	uint32_t unused;
+};
+
+// one entry of the tuning database (see nn_tuning.h): a shape key
+// and the tiling chosen for it
+struct tuning_record {
+	uint32_t kind;			// NN_TUNING_KIND_xx
+	uint32_t batches;		// input shape
+	uint32_t height;
+	uint32_t width;
+	uint32_t depth;
+	uint32_t filt_height;
+	uint32_t filt_width;
+	uint32_t out_depth;
+	uint32_t stride_height;
+	uint32_t stride_width;
+	uint32_t padding;		// padding type
+	uint32_t inner_batches;		// chosen tiling
+	uint32_t inner_rows;
+	uint32_t inner_weight_chunks;
+	uint32_t cycles;		// measured cycles of the chosen tiling (0 if not measured)
+};
+
 struct initinfo {
 	int32_t priority;
 };
@@ -242,6 +305,21 @@ int hexagon_nn_get_perfinfo(nn_id_t id,
 	struct perfinfo *info_out, 
 	unsigned int info_out_len,
 	unsigned int *n_items_out);
+int hexagon_nn_get_perfinfo_traffic(nn_id_t id,
+	struct perfinfo_traffic *info_out,
+	unsigned int info_out_len,
+	unsigned int *n_items_out);
+int hexagon_nn_get_trace(nn_id_t id,
+	struct trace_event *events_out,
+	unsigned int events_out_len,
+	unsigned int *n_events_out);
+int hexagon_nn_get_tuning_db(nn_id_t id,
+	struct tuning_record *records_out,
+	unsigned int records_out_len,
+	unsigned int *n_records_out);
+int hexagon_nn_set_tuning_db(nn_id_t id,
+	const struct tuning_record *records,
+	unsigned int n_records);
 
 int hexagon_nn_get_nodetype(nn_id_t graph_id,
 			    nn_id_t node_id, 
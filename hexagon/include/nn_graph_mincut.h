@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef NN_GRAPH_MINCUT_H
+#define NN_GRAPH_MINCUT_H 1
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains a small s-t minimum cut solver (Dinic's max-flow), used in prepare
+ * for decisions that can be posed as a 2-way labelling of the nodes with pairwise costs
+ * (e.g. d32 vs. flat layout).
+ *
+ * Vertex NN_MINCUT_SOURCE (0) and NN_MINCUT_SINK (1) are the terminals; the others are
+ * numbered 2 .. nvert-1.
+ * An edge a->b of capacity c adds cost c when 'a' ends up on the source side and 'b' on the sink side.
+ * Capacities >= NN_MINCUT_INF are never cut (as long as there is any finite cut).
+ *
+ *   nn_mincut_init( nn, &mc, nvert, max_edges);
+ *   nn_mincut_add_edge( &mc, a, b, cap );   ...
+ *   nn_mincut_solve( nn, &mc);    -> mc.source_side[v] = 1 if v is on the source side.
+ *                                   (nonzero if every cut has an infinite edge)
+ *   nn_mincut_free( &mc);
+ */
+#include <stdint.h>
+
+#define NN_MINCUT_SOURCE 0
+#define NN_MINCUT_SINK 1
+#define NN_MINCUT_INF ((int64_t)1<<50)
+
+struct nn_mincut_edge {
+	int32_t to;
+	int32_t next;		// next edge from the same vertex, or -1
+	int64_t cap;		// residual capacity
+};
+
+struct nn_mincut {
+	int nvert;
+	int nedges;		// (always even; edge e^1 is the reverse of e)
+	int max_edges;
+	struct nn_mincut_edge *edges;
+	int32_t *first;		// [nvert] first edge from each vertex
+	int32_t *level;		// [nvert]
+	int32_t *iter;		// [nvert]
+	int32_t *queue;		// [nvert]
+	int32_t *path;		// [nvert] edges of the current augmenting path
+	uint8_t *source_side;	// [nvert] result
+	int64_t cut_value;	// result
+};
+
+struct nn_graph;
+int nn_mincut_init(struct nn_graph *nn, struct nn_mincut *mc, int nvert, int max_edges);
+int nn_mincut_add_edge(struct nn_mincut *mc, int a, int b, int64_t cap);
+int nn_mincut_solve(struct nn_graph *nn, struct nn_mincut *mc);
+void nn_mincut_free(struct nn_mincut *mc);
+
+#endif //NN_GRAPH_MINCUT_H
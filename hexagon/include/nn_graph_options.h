@@ -61,6 +61,9 @@ struct nn_graph;
 //
 #define NN_OPTIONDESCS\
 		NN_OPTIONS_BOOLDESC(test_no_d32conv ,           "no d32 conversions (for e.g. unit tests)") \
+		NN_OPTIONS_BOOLDESC(test_no_d32_layout,         "convert every node with a d32 version (no cost-based d32 layout)") \
+		NN_OPTIONS_BOOLDESC(test_no_alias,              "don't let tensors share storage (in-place ops, views) in allocation") \
+		NN_OPTIONS_BOOLDESC(imgpre_fold_resample,       "image preprocess fusion may fold ImageTransform_f + ResizeBilinear_f into one resample (not bit-exact)") \
 		NN_OPTIONS_BOOLDESC(test_force_graph_check,     "force graph_check even when debug=0") \
 		NN_OPTIONS_BOOLDESC(debug_show_output_tensors,  "log output tensor shapes after execute [1]")\
 		NN_OPTIONS_BOOLDESC(debug_dump_to_binary,        "dump output tensors to binary [1]")\
@@ -71,6 +74,11 @@ struct nn_graph;
 		NN_OPTIONS_BOOLDESC(dev_feature_C,               "generic feature switch C [2]")\
 		NN_OPTIONS_BOOLDESC(dev_feature_D,               "generic feature switch D [2]")\
 		NN_OPTIONS_INTDESC(debug_max_show_checksum,-1,    "don't log output checksums on tensors > this (<0 to disable)")\
+		NN_OPTIONS_INTDESC(trace_events,0,               "per-thread execution trace ring size, in events (0 = no trace)")\
+		NN_OPTIONS_INTDESC(autotune,0,                   "time tilings of shapes not in the tuning db; value = timed runs per candidate (0 = off)")\
+		NN_OPTIONS_INTDESC(prefetch_limit_kb,-1,         "look-ahead prefetch of the next node's inputs, at most this many KB (0 = off, <0 = L2 budget only)")\
+		NN_OPTIONS_INTDESC(batch_parallel,0,             "split the batches of batch-independent flat ops over up to this many vector threads (< 2 = off)")\
+		NN_OPTIONS_INTDESC(scratch_strict,1,             "fail a node which needs more scratch at execute than its scratch_hint planned, instead of growing it (0 = grow)")\
 
 //////////////////////////////////////////////////////
 
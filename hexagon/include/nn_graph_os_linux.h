@@ -131,14 +131,28 @@ static inline uint64_t nn_os_get_cycles(struct nn_graph *nn)
 	return ts.tv_nsec;
 }
 #endif
+#if defined(__hexagon__)
 static inline uint64_t nn_os_get_cycles(struct nn_graph *nn)
 {
 	uint64_t ret;
 	asm volatile ( " %0 = c15:14 // READ UPCYCLES \n" : "=r"(ret));
 	return ret;
 }
+#else
+// host build: nsecs stand in for pcycles
+static inline uint64_t nn_os_get_cycles(struct nn_graph *nn)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
 
 unsigned long long int nn_os_get_perfcount(struct nn_graph *nn);
+#if !defined(__hexagon__)
+// host build: select the perf_event_open counter read by nn_os_get_perfcount
+int nn_os_perf_event_select(struct nn_graph *nn, uint32_t event);
+#endif
 
 int nn_os_workers_spawn(struct nn_graph *nn);
 void nn_os_workers_kill(struct nn_graph *nn);
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NN_GRAPH_TRACE_H
+#define NN_GRAPH_TRACE_H 1
+/*
+ * Execution trace recorder.
+ *
+ * When the 'trace_events' graph option is nonzero, each thread of the graph
+ * (0 = the thread running do_execute, 1..Total_Threads = the workers) records
+ * begin/end events into its own ring of 'trace_events' entries (rounded up to
+ * a power of 2). Each ring has exactly one writer, so recording is a cycle
+ * counter read and a few stores, with no locks or atomics; when a ring wraps,
+ * the oldest events are overwritten.
+ *
+ * Events are read (and the rings emptied) with hexagon_nn_get_trace, between
+ * executions.
+ */
+
+enum nn_trace_kind {
+	NN_TRACE_EXEC_BEGIN = 1,	// id = graph id
+	NN_TRACE_EXEC_END,
+	NN_TRACE_NODE_BEGIN,		// id = node id, aux = node type
+	NN_TRACE_NODE_END,
+	NN_TRACE_WORK_BEGIN,		// id = work function address, aux = node id running on thread 0
+	NN_TRACE_WORK_END,
+};
+
+struct nn_trace_ring {
+	uint32_t head;			// # of events ever written; only the owning thread writes it
+	struct trace_event *events;
+};
+
+struct nn_trace {
+	uint32_t ring_mask;		// ring size - 1
+	uint32_t n_rings;
+	volatile uint32_t cur_node;	// node currently executing on thread 0
+	struct nn_trace_ring rings[];
+};
+
+// (re)allocate or free the rings to match the trace_events option; called by do_execute
+int nn_trace_setup(struct nn_graph *nn);
+void nn_trace_free(struct nn_graph *nn);
+// copy out up to max_events events, oldest first per thread, and empty the rings.
+// Returns the # of events copied.
+uint32_t do_trace_get(struct nn_graph *nn, struct trace_event *events, uint32_t max_events);
+
+static inline void nn_trace_record(struct nn_graph *nn, unsigned thread, unsigned kind, uint32_t id, uint32_t aux)
+{
+	struct nn_trace *tr = nn->trace;
+	if (likely(tr == NULL) || thread >= tr->n_rings) return;
+	struct nn_trace_ring *ring = &tr->rings[thread];
+	uint32_t head = ring->head;
+	struct trace_event *ev = &ring->events[head & tr->ring_mask];
+	ev->ts = nn_os_get_cycles(nn);
+	ev->id = id;
+	ev->aux = aux;
+	ev->kind = kind;
+	ev->thread = thread;
+	ring->head = head + 1;
+}
+
+static inline void nn_trace_node(struct nn_graph *nn, unsigned kind, struct nn_node const *node)
+{
+	struct nn_trace *tr = nn->trace;
+	if (likely(tr == NULL)) return;
+	tr->cur_node = (kind == NN_TRACE_NODE_BEGIN) ? node->node_id : 0;
+	nn_trace_record(nn,0,kind,node->node_id,node->node_type);
+}
+
+static inline void nn_trace_work(struct nn_graph *nn, unsigned thread, unsigned kind, void (*f)(struct nn_graph *, void *))
+{
+	struct nn_trace *tr = nn->trace;
+	if (likely(tr == NULL)) return;
+	nn_trace_record(nn,thread,kind,(uint32_t)(size_t)f,tr->cur_node);
+}
+
+#endif
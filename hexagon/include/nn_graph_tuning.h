@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NN_GRAPH_TUNING_H
+#define NN_GRAPH_TUNING_H 1
+/*
+ * Tuning database.
+ *
+ * Ops that choose a tiling by heuristic (currently supernode) can, when the
+ * 'autotune' graph option is nonzero, time a few candidate tilings the first
+ * time they see a shape, and record the fastest in the graph's tuning
+ * database, keyed by kind, input shape, filter shape and stride. Later
+ * strategy calculations for the same key use the recorded tiling without
+ * timing anything, whether or not 'autotune' is set.
+ *
+ * The database lives with the graph; to persist it, the host reads it out
+ * with hexagon_nn_get_tuning_db and loads it into later graphs with
+ * hexagon_nn_set_tuning_db, before their first execute.
+ */
+
+enum nn_tuning_kind {
+	NN_TUNING_KIND_SUPERNODE = 0x534e3630,		// 'SN60' supernode_recalculate_strategy
+	NN_TUNING_KIND_SUPERNODE_V66 = 0x534e3636,	// 'SN66' supernode_recalculate_strategy_v66
+};
+
+// the key is all fields before inner_batches
+#define NN_TUNING_KEY_SIZE offsetof(struct tuning_record,inner_batches)
+
+struct nn_tuning_db {
+	uint32_t n_records;
+	uint32_t max_records;
+	struct tuning_record *records;
+};
+
+// find the record whose key matches that of *key; NULL if none.
+const struct tuning_record *nn_tuning_lookup(struct nn_graph *nn, const struct tuning_record *key);
+// add *rec, or replace the record with the same key
+int nn_tuning_store(struct nn_graph *nn, const struct tuning_record *rec);
+void nn_tuning_free(struct nn_graph *nn);
+// copy out up to max_records records; returns the # copied.
+uint32_t do_tuning_db_get(struct nn_graph *nn, struct tuning_record *records, uint32_t max_records);
+// replace the database with the given records
+int do_tuning_db_set(struct nn_graph *nn, const struct tuning_record *records, uint32_t n_records);
+
+#endif
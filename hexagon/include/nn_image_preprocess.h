@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef NN_IMAGE_PREPROCESS_H
+#define NN_IMAGE_PREPROCESS_H 1
+/*
+ * ImagePreprocess_8 does, in one pass over the image:
+ *     color conversion -> dequantize -> [ warp ] -> [ resize ] -> normalize -> quantize
+ * which is what a chain like
+ *     Nv21ToRgb_8 -> Dequantize -> ImageTransform_f -> ResizeBilinear_f -> Sub_f -> Mul_f -> Quantize
+ * does. It's made by the prepare pass fuse_image_preprocess_nodes from such chains.
+ *
+ * Inputs:
+ *   0  image (uint8), in the format given by input 1:
+ *        IMGPRE_FMT_RGB:   depth 3
+ *        IMGPRE_FMT_NV21:  w*h of Y, then (w/2)*(h/2) pairs of V,U (as Nv21ToRgb_8)
+ *        IMGPRE_FMT_RGBA, IMGPRE_FMT_ARGB: depth 4 (as RgbaToRgb_8, Argb32ToRgb_8)
+ *   1  format (int32)
+ *   2  isBGR (int32): for NV21, RGBA, ARGB, as in the conversion ops
+ *   3,4  min, max of the (converted) image; the NV21 conversion is always 0..255
+ *   5  transform (float): 8 per batch, a0 a1 a2 b0 b1 b2 c0 c1, as ImageTransform_f
+ *   6  newdims (int32): h_out, w_out, as ResizeBilinear_f
+ *   7  flags (int32): IMGPRE_FLAG_*
+ *   8,9  mean, scale (float, 1 or 3 values): x = (x-mean[c])*scale[c]
+ *   10,11  output min, max (as Quantize)
+ * Outputs: the qu8 result (depth 3), min, max.
+ *
+ * With only one of IMGPRE_FLAG_WARP, IMGPRE_FLAG_RESIZE, the result matches the
+ * original chain. With both, one bilinear sample is taken at the composed position
+ * (output -> resize grid -> warp), rather than resampling twice; that's close, but not
+ * the same, so prepare only does it if option 'imgpre_fold_resample' is set.
+ */
+
+enum imgpre_format {
+	IMGPRE_FMT_RGB,
+	IMGPRE_FMT_NV21,
+	IMGPRE_FMT_RGBA,
+	IMGPRE_FMT_ARGB,
+	IMGPRE_N_FORMATS
+};
+
+#define IMGPRE_FLAG_WARP 1		// use the transform (input 5)
+#define IMGPRE_FLAG_RESIZE 2		// use newdims (input 6); otherwise output size = input size
+#define IMGPRE_FLAG_ALIGN_CORNERS 4	// as ResizeBilinear_f 'align_corners'
+
+enum imgpre_input {
+	IMGPRE_IN_DATA,
+	IMGPRE_IN_FORMAT,
+	IMGPRE_IN_ISBGR,
+	IMGPRE_IN_MIN,
+	IMGPRE_IN_MAX,
+	IMGPRE_IN_TRANSFORM,
+	IMGPRE_IN_NEWDIMS,
+	IMGPRE_IN_FLAGS,
+	IMGPRE_IN_MEAN,
+	IMGPRE_IN_SCALE,
+	IMGPRE_IN_OUT_MIN,
+	IMGPRE_IN_OUT_MAX,
+	IMGPRE_N_INPUTS
+};
+
+#endif
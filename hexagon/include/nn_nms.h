@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * Greedy non-max suppression shared by the detection post-processing ops.
+ *
+ * - Candidates (score, box index) are visited in descending score order, but only sorted
+ *   as far as they are consumed: quickselect pulls out the next chunk of the best
+ *   remaining candidates, and only that chunk is sorted.
+ * - Each candidate is tested against the boxes kept so far (not against all the later
+ *   candidates), so the work is O(candidates consumed * boxes kept), and stops as soon
+ *   as the keep limit is reached.
+ * - The kept boxes are stored as separate coordinate arrays, so the overlap test of one
+ *   candidate against all of them is a straight loop the compiler can vectorize.
+ *
+ * Candidate order is by score descending, then by box index ascending, so results are
+ * deterministic when scores tie.
+ */
+
+#ifndef NN_NMS_H
+#define NN_NMS_H
+
+#include <stdint.h>
+
+struct nn_nms_cand {
+	float score;
+	int32_t idx;		// box index
+};
+
+// Box i has corners coords[i*stride + 0..3] = (x1,y1,x2,y2), and area area[i*stride].
+// (y1,x1,y2,x2) order works just as well; the overlap is symmetric in the two axes.
+struct nn_nms_boxes {
+	const float *coords;
+	const float *area;
+	int stride;
+};
+
+// The IoU conventions differ between the ops; these select them.
+struct nn_nms_params {
+	float iou_threshold;
+	float coord_offset;		// added to (x2-x1), (y2-y1) of the intersection: 1.0 for 'pixel' boxes, else 0
+	int suppress_at_equal;		// suppress when iou >= threshold (else when iou > threshold)
+	int disjoint_is_zero;		// boxes strictly apart have no intersection, regardless of coord_offset
+};
+
+// the boxes kept so far, one array per coordinate
+struct nn_nms_keepset {
+	float *x1, *y1, *x2, *y2, *area;
+	int n;
+	int cap;
+};
+
+// Candidates in descending order, sorting a chunk at a time
+struct nn_nms_iter {
+	struct nn_nms_cand *cands;
+	int n;
+	int pos;		// next one to return
+	int sorted_end;		// cands[pos..sorted_end-1] are sorted
+	int chunk;
+};
+
+// memory needed by nn_nms_keepset_init for 'cap' boxes
+static inline int nn_nms_keepset_bytes(int cap) { return 5 * cap * sizeof(float); }
+
+// 'mem' must have room for nn_nms_keepset_bytes(cap)
+static inline void nn_nms_keepset_init(struct nn_nms_keepset *ks, float *mem, int cap)
+{
+	ks->x1 = mem;
+	ks->y1 = mem + cap;
+	ks->x2 = mem + 2 * cap;
+	ks->y2 = mem + 3 * cap;
+	ks->area = mem + 4 * cap;
+	ks->n = 0;
+	ks->cap = cap;
+}
+
+// returns -1 if full
+static inline int nn_nms_keepset_add(struct nn_nms_keepset *ks, float x1, float y1, float x2, float y2, float area)
+{
+	int n = ks->n;
+	if (n >= ks->cap) return -1;
+	ks->x1[n] = x1;
+	ks->y1[n] = y1;
+	ks->x2[n] = x2;
+	ks->y2[n] = y2;
+	ks->area[n] = area;
+	ks->n = n + 1;
+	return 0;
+}
+
+// Rearrange cands[0..n-1] so that the best min(k,n) are at the front (in no particular order).
+// Returns min(k,n).
+int nn_nms_select(struct nn_nms_cand *cands, int n, int k);
+
+// Put the best min(k,n) candidates at the front, in order. Returns min(k,n).
+int nn_nms_top_k(struct nn_nms_cand *cands, int n, int k);
+
+// 'chunk' is how many to sort at once; <= 0 sorts everything on the first call.
+void nn_nms_iter_init(struct nn_nms_iter *it, struct nn_nms_cand *cands, int n, int chunk);
+
+// returns the next best candidate, or NULL when all have been returned.
+static inline struct nn_nms_cand *nn_nms_iter_next(struct nn_nms_iter *it)
+{
+	if (it->pos >= it->sorted_end) {
+		if (it->pos >= it->n) return NULL;
+		it->sorted_end = it->pos + nn_nms_top_k(it->cands + it->pos, it->n - it->pos, it->chunk);
+	}
+	return &it->cands[it->pos++];
+}
+
+// Does box (x1,y1,x2,y2) with the given area overlap any kept box by more than 'threshold'
+// (or by at least 'threshold', with suppress_at_equal)? The threshold is passed separately
+// from params, for callers which adapt it as boxes are kept.
+int nn_nms_keepset_overlaps(const struct nn_nms_keepset *ks, const struct nn_nms_params *p, float threshold,
+	float x1, float y1, float x2, float y2, float area);
+
+// Greedy NMS: visits cands[0..n-1] in descending order, keeping each one which does not
+// overlap a previously kept one, until max_keep (if > 0) are kept or the keepset is full.
+// The kept candidates are returned, in order, in cands[0..result-1]. ks is reset first.
+int nn_nms_greedy(struct nn_nms_cand *cands, int n, const struct nn_nms_boxes *boxes,
+	const struct nn_nms_params *p, int max_keep, struct nn_nms_keepset *ks);
+
+#endif // NN_NMS_H
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NN_QUANTIZE_VEC_H
+#define NN_QUANTIZE_VEC_H 1
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the 'qvec' library: elementwise quantize / dequantize / requantize
+ * loops for the non-HVX paths. Each function has a plain C definition (below, and in
+ * quantize_vec.c) which is the reference; on x86 (SSE4.1, AVX2) and aarch64 (NEON) hosts,
+ * vector versions are used, which are bit-exact with it.
+ * The backend is picked at first use, according to what the cpu supports.
+ *
+ * None of these have any alignment requirements, and exactly n outputs are written.
+ */
+#include <stdint.h>
+
+//  out[i] = saturate_u8( add_sat( (in[i]*gain + (1<<30)) >> 31, offset ))
+//  gain must be >= 0 (this is scalar_requantize_i32_to_qu8 in quantize.c)
+void nn_qvec_i32_to_u8_q31(uint8_t *outp, int32_t const *inp, int n, int32_t gain, int32_t offset);
+
+//  out[i] = saturate_u8( (int)( (float)in[i]*gain + offset ))
+//  'offset' is presumed to contain a +0.5 rounding bias.
+void nn_qvec_i32_to_u8_flt(uint8_t *outp, int32_t const *inp, int n, float gain, float offset);
+
+//  i32->i16 with gain/2^(31+rsh), rsh in -24..15, gain > 0 (as scale_32_to_16 in op_requantize.c):
+//   rsh >= 0:   out[i] = sat_i16( rndshift( sat32((in[i]*gain + (1<<30))>>31), rsh))
+//   rsh < 0:    in[i] is clipped so that it can be << (4-rsh), then as above with a shift of 4.
+void nn_qvec_i32_to_i16_q31(int16_t *outp, int32_t const *inp, int n, int32_t gain, int rsh);
+
+// u8->u8 requantize: out = gain * (in - in_offset) + out_offset, done the same way as
+// nn_requantize_qu8_to_qu8_hvx (in 16 bits, with 15 fractional bits of gain).
+void nn_qvec_u8_to_u8(uint8_t *outp, uint8_t const *inp, int n, float gain, int32_t in_offset, int32_t out_offset);
+// same on d32 rows of 'rowbytes', for h_count x nd32 rows.
+void nn_qvec_u8_to_u8_d32(uint8_t *outp, uint8_t const *inp, int h_count, int nd32, int rowbytes,
+		int height_stride, int d32_stride, float gain, int32_t in_offset, int32_t out_offset);
+
+//  out[i] = saturate_u8( roundf_i32( (in[i]-minval) * recip_stepsize))
+void nn_qvec_f32_to_u8(uint8_t *outp, float const *inp, int n, float minval, float recip_stepsize);
+//  out[i] = (float)(in[i]-qzero) * qstep
+void nn_qvec_u8_to_f32(float *outp, uint8_t const *inp, int n, int qzero, float qstep);
+
+//  out[i] = saturate_i16( roundf_i32( in[i]*scale) + offset ) ^ xorval
+void nn_qvec_f32_to_x16(int16_t *outp, float const *inp, int n, float scale, int offset, int xorval);
+//  out[i] = scale * (float)( (uint16_t)(in[i] ^ xorval) - zero )
+void nn_qvec_x16_to_f32(float *outp, uint16_t const *inp, int n, int xorval, int zero, float scale);
+
+// name of the backend in use ("c", "sse4.1", "avx2", "neon")
+char const *nn_qvec_backend_name(void);
+// use the named backend from now on (for testing; not thread-safe against calls in flight).
+// NULL goes back to the default choice. Returns -1 if that backend isn't built, or the cpu
+// doesn't support it.
+int nn_qvec_set_backend(char const *name);
+
+#endif //NN_QUANTIZE_VEC_H
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NN_ROIALIGN_H
+#define NN_ROIALIGN_H
+
+/*
+ * Sampling setup shared by the RoiAlign family of ops.
+ *
+ * The bilinear sample positions of RoiAlign are separable: the y coordinate of a sample
+ * depends only on (ph,iy) and the x coordinate only on (pw,ix). So for each ROI we build one
+ * table per axis (pooled_h*grid_h + pooled_w*grid_w entries) instead of redoing the
+ * floor/clamp/weight setup for every one of the pooled_h*pooled_w*grid_h*grid_w samples;
+ * the 4 corners and weights of a sample are then formed from one y entry and one x entry.
+ *
+ * The position and clamping arithmetic is kept exactly as in the original per-sample code,
+ * so results are unchanged.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+// one sample position along an axis
+struct roialign_axis_sample {
+	int32_t lo;		// lower row (or column) index
+	int32_t hi;		// upper row (or column) index; == lo at the edge
+	float frac;		// position - lo; the weight of 'hi'
+	int32_t valid;		// 0 if the position is outside the feature map (sample contributes 0)
+};
+
+// bin geometry of one ROI, in feature-map coordinates
+struct roialign_bins {
+	float start_h, start_w;
+	float cell_h, cell_w;	// size of each of the pooled_h x pooled_w cells
+	int grid_h, grid_w;	// samples per cell in each direction
+};
+
+// ROI is (start_w,start_h,end_w,end_h), already scaled to the feature map.
+// sampling_{h,w} <= 0 means 'adaptive': ceil(roi_size/pooled_size) samples.
+static inline __attribute__((unused)) void roialign_bins_setup(
+	struct roialign_bins *bins,
+	float start_w, float start_h, float end_w, float end_h,
+	int pooled_h, int pooled_w,
+	int sampling_h, int sampling_w)
+{
+	float roi_height = (end_h - start_h > 1.0f) ? (end_h - start_h) : 1.0f;
+	float roi_width = (end_w - start_w > 1.0f) ? (end_w - start_w) : 1.0f;
+	bins->start_h = start_h;
+	bins->start_w = start_w;
+	bins->cell_h = roi_height / (float)pooled_h;
+	bins->cell_w = roi_width / (float)pooled_w;
+	bins->grid_h = (sampling_h > 0) ? sampling_h : (int)ceilf(roi_height / pooled_h);
+	bins->grid_w = (sampling_w > 0) ? sampling_w : (int)ceilf(roi_width / pooled_w);
+}
+
+// Fill tab[p*grid + i] (p < pooled, i < grid) for one axis, with samples at
+// start + p*cell + (i+0.5)*cell/grid. 'size' is the feature map extent along the axis.
+// Positions in [-1,0] clamp to 0; positions past size-1 clamp to the last row/column.
+static inline __attribute__((unused)) void roialign_axis_table(
+	struct roialign_axis_sample *tab,
+	int size, int pooled, int grid,
+	float start, float cell)
+{
+	for (int p = 0; p < pooled; p++) {
+		for (int i = 0; i < grid; i++) {
+			float v = start + p * cell + ((float)i + 0.5f) * cell / (float)grid;
+			struct roialign_axis_sample s;
+			if (v < -1.0f || v > size) {
+				s.lo = s.hi = 0;
+				s.frac = 0.0f;
+				s.valid = 0;
+			} else {
+				if (v <= 0) v = 0;
+				s.lo = (int)v;
+				if (s.lo >= size - 1) {
+					s.hi = s.lo = size - 1;
+					v = (float)s.lo;
+				} else {
+					s.hi = s.lo + 1;
+				}
+				s.frac = v - s.lo;
+				s.valid = 1;
+			}
+			*tab++ = s;
+		}
+	}
+}
+
+// Variant for the 'V2' (NNAPI style) sampling: within each cell, samples are at
+// start + cell/(2*grid) + k*cell/grid, found by stepping while inside the cell;
+// no validity test, and indices are clamped as unsigned (so negative positions go to the edge).
+// Samples for cell p are tab[first[p] .. first[p+1]-1]; at most max_per_cell are recorded
+// per cell. Returns the total number of entries.
+static inline __attribute__((unused)) int roialign_axis_table_stepped(
+	struct roialign_axis_sample *tab,
+	int *first,
+	int size, int pooled, int grid, int max_per_cell,
+	float start, float cell)
+{
+	float step = cell / grid;
+	int n = 0;
+	for (int p = 0; p < pooled; p++) {
+		float cstart = cell * p + start;
+		float cend = cell * (p + 1) + start;
+		int k = 0;
+		first[p] = n;
+		for (float v = cstart + step / 2; v < cend && k < max_per_cell; v += step, k++) {
+			uint32_t lo = floorf(v);
+			uint32_t hi = lo + 1;
+			float frac = v - lo;
+			if (lo >= size - 1) {
+				lo = hi = size - 1;
+				frac = 0;
+			}
+			tab[n].lo = lo;
+			tab[n].hi = hi;
+			tab[n].frac = frac;
+			tab[n].valid = 1;
+			n++;
+		}
+	}
+	first[pooled] = n;
+	return n;
+}
+
+#endif //NN_ROIALIGN_H
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * Row-wise top-k selection, shared by TopK_f and TopK_8.
+ *
+ * Each row is reduced to its k largest elements, output in descending order; equal values
+ * are ordered by index descending (the larger index comes first).
+ *
+ * float rows:
+ * - small k (relative to the row): a threshold filter. Elements are appended to a buffer of
+ *   a few times k only if they are >= the current k'th best; when the buffer fills, it is
+ *   cut back to the best k with quickselect and the threshold is raised. Most elements of
+ *   a long row then cost one compare.
+ * - otherwise: quickselect over the whole row, then sort the k selected.
+ *
+ * 8-bit rows: a 256-bin histogram gives the smallest value that makes the cut, and how many
+ * of that value are needed; one more pass (from the end of the row, so larger indices come
+ * first) scatters the selected elements straight to their output positions.
+ */
+
+#ifndef NN_TOPK_H
+#define NN_TOPK_H
+
+#include <stdint.h>
+
+struct nn_topk_elem {
+	float value;
+	int32_t idx;
+};
+
+// rows at least this long, with k at most 1/TOPK_FILTER_RATIO of them, use the threshold filter
+#define TOPK_FILTER_MIN_N 256
+#define TOPK_FILTER_RATIO 8
+
+static inline int nn_topk_f_use_filter(int n, int k)
+{
+	return n >= TOPK_FILTER_MIN_N && k * TOPK_FILTER_RATIO <= n;
+}
+
+// size of the threshold filter's buffer
+static inline int nn_topk_f_filter_cap(int k)
+{
+	return (4 * k > 64) ? 4 * k : 64;
+}
+
+// elements of work space needed by nn_topk_f_row
+static inline int nn_topk_f_work_elems(int n, int k)
+{
+	return nn_topk_f_use_filter(n, k) ? nn_topk_f_filter_cap(k) : n;
+}
+
+// Find the top k (1 <= k <= n) of in[0..n-1]; 'work' has room for nn_topk_f_work_elems(n,k).
+void nn_topk_f_row(const float *in, int n, int k, float *out_val, int32_t *out_idx, struct nn_topk_elem *work);
+
+// Find the top k (0 <= k <= n) of in[0..n-1].
+// 'hist' is the 256-bin histogram of the row if the caller has it (e.g. from histogram_flat_asm,
+// which is exact for n <= 65535), or NULL to have it counted here.
+void nn_topk_u8_row(const uint8_t *in, int n, int k, const uint16_t *hist, uint8_t *out_val, int32_t *out_idx);
+
+#endif // NN_TOPK_H
@@ -44,7 +44,7 @@
 
 #include <stdint.h>
 #include <math.h>
-#ifdef __hexagon__
+#if defined(__hexagon__) || defined(HVX_EMUL_H)
 #include "hexagon_protos.h"
 #include "hvx_inlines.h"
 #endif
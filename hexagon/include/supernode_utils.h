@@ -133,6 +133,16 @@ struct weight_slice_info {
 	uint32_t wakeup_items;
 };
 
+/*
+ * The tiling chosen by slice_for_cache / slice_for_cache_v66, which the
+ * autotuner varies (see supernode_autotune)
+ */
+struct supernode_tiling {
+	int32_t inner_act_batches;	// batches per inner loop
+	int32_t inner_act_rows;		// output rows per conv work item
+	int32_t inner_weight_chunks;	// 32-deep weight slices per outer weight iteration
+};
+
 /*
  * Pointers and values that are common to everything in the node
  * Also values that are constant across all work items
@@ -252,6 +262,10 @@ struct supernode_info_new {
 	const struct nn_node *earlywork_pred;	// A node before this one that might be able to take early work
 	struct nn_early_work my_earlywork;	// Information about early work
 	struct nn_early_work *next_earlywork;	// Work requested by future node
+	struct supernode_tiling tiling_heuristic;	// what the heuristic chose in the last strategy calculation
+	struct supernode_tiling tiling_override;	// used instead, when tiling_override_valid
+	uint8_t tiling_override_valid;
+	int32_t tiling_max_chunks;	// most inner_weight_chunks the last strategy could have used
 };
 
 //
@@ -118,7 +118,8 @@ TEST_C_SRCS = test/graph_app.c \
 test/graphmain.c \
 test/graphinfo.c \
 test/options.c \
-test/imagenet_info.c
+test/imagenet_info.c \
+hexagon/host/hexnn_capture.c
 
 #CFLAGS = -DSNPE_TEST
 
@@ -132,9 +133,9 @@ HEXAGON_NN_OBJS = $(HEXAGON_NN_C_SRCS:.c=.o) $(HEXAGON_NN_ASM_SRCS:.S=.o)
 DEPS = $(C_OBJS:.o=.d)
 
 ifeq (linux,$(OS))
-CFLAGS += -DAPP_LOOPS=$(APP_LOOPS) -Wall -DUSE_OS_LINUX -Ihexagon/include -Iinterface -O2 $(INCPATH)
+CFLAGS += -DAPP_LOOPS=$(APP_LOOPS) -Wall -DUSE_OS_LINUX -Ihexagon/include -Ihexagon/host -Iinterface -O2 $(INCPATH)
 else
-CFLAGS += -m$(Q6VERSION) -Wall -Werror -DAPP_LOOPS=$(APP_LOOPS) -DUSE_OS_H2 -Ihexagon/include -Iinterface -O3 $(INCPATH)
+CFLAGS += -m$(Q6VERSION) -Wall -Werror -DAPP_LOOPS=$(APP_LOOPS) -DUSE_OS_H2 -Ihexagon/include -Ihexagon/host -Iinterface -O3 $(INCPATH)
 ASFLAGS += -m$(Q6VERSION)
 endif
 
@@ -204,6 +205,33 @@ objs/%.o: apps/%.c
 %.elf: $(ALL_OBJS) objs/%.o
 	$(CC) $(LDFLAGS) -o $@ $^
 
+# layer-by-layer accuracy/cycles of apps/X.c against its float version apps/X_float.c;
+# e.g. make inceptionv3.sweep (the float graph's init_graph is renamed to init_graph_ref)
+objs/%.ref.o: apps/%.c
+	$(CC) -c $(CPPFLAGS) $(CFLAGS) -Dinit_graph=init_graph_ref -o $@ $^
+
+%.sweep.elf: $(HEXAGON_NN_OBJS) test/layer_sweep.o test/graphinfo.o objs/%.o objs/%_float.ref.o
+	$(CC) $(LDFLAGS) -o $@ $^
+
+%.sweep: %.sweep.elf $(TESTFILE)
+	archsim --magic_angel --quiet $(SIM_OPTIONS) $(BOOTER) $< --elementsize 1 --width 299 --height 299 --depth 3 $(TESTFILE) | tee $@
+
+# per-op microbenchmark; e.g. make op_bench.sim OP_BENCH_OPTIONS="--op QuantizedAdd_8p8to8"
+op_bench.elf: $(HEXAGON_NN_OBJS) test/op_bench.o
+	$(CC) $(LDFLAGS) -o $@ $^
+
+OP_BENCH_OPTIONS ?= --op QuantizedAdd_8p8to8 --shapes 1x32x32x32,1x64x64x64
+
+op_bench.sim: op_bench.elf
+	archsim --magic_angel --quiet $(SIM_OPTIONS) $(BOOTER) $< $(OP_BENCH_OPTIONS) | tee $@
+
+# batch-parallel segments against the sequential run; make batchpar_check.sim
+batchpar_check.elf: $(HEXAGON_NN_OBJS) test/batchpar_check.o
+	$(CC) $(LDFLAGS) -o $@ $^
+
+batchpar_check.sim: batchpar_check.elf
+	archsim --magic_angel --quiet $(SIM_OPTIONS) $(BOOTER) $< | tee $@
+
 .S.o:
 	$(CC) $(ASFLAGS) -c -o $@ $<
 
@@ -288,7 +316,7 @@ SNPE_MINI_TARGETS := $(shell cpp -P -D "TEST(name)=name.snpelog" snpetest/tests.
 snpetest_minis: $(SNPE_MINI_TARGETS)
 	echo SUCCESS
 
-.PRECIOUS: %.elf objs/%.o
+.PRECIOUS: %.elf objs/%.o objs/%.ref.o
 
 sim: $(DEFAULT_BASE).sim
 slurm: $(DEFAULT_BASE).slurm
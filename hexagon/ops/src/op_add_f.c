@@ -91,6 +91,7 @@ struct nn_node_ops nn_ops_for_Add_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 struct nn_node_ops nn_ops_for_Add_int32 = {
 	.execute = add_int32_execute,
@@ -99,4 +100,5 @@ struct nn_node_ops nn_ops_for_Add_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
@@ -1153,6 +1153,7 @@ struct nn_node_ops nn_ops_for_QuantizedAdd_16 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(8),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedSub_16 = {
@@ -1162,6 +1163,7 @@ struct nn_node_ops nn_ops_for_QuantizedSub_16 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(8),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 struct nn_node_ops nn_ops_for_QuantizedMul_16 = {
 	.execute = mul_16_execute,
@@ -1170,6 +1172,7 @@ struct nn_node_ops nn_ops_for_QuantizedMul_16 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(8),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedAdd_u16 = {
@@ -1179,6 +1182,7 @@ struct nn_node_ops nn_ops_for_QuantizedAdd_u16 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(8),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedSub_u16 = {
@@ -1188,6 +1192,7 @@ struct nn_node_ops nn_ops_for_QuantizedSub_u16 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(8),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 struct nn_node_ops nn_ops_for_QuantizedMul_u16 = {
 	.execute = mul_16_execute,
@@ -1196,5 +1201,6 @@ struct nn_node_ops nn_ops_for_QuantizedMul_u16 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(8),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
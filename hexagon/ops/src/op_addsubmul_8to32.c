@@ -610,6 +610,7 @@ struct nn_node_ops nn_ops_for_QuantizedAdd_8p8to32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedSub_8p8to32 = {
@@ -619,6 +620,7 @@ struct nn_node_ops nn_ops_for_QuantizedSub_8p8to32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedAdd_8p8to32_ref= {
@@ -628,6 +630,7 @@ struct nn_node_ops nn_ops_for_QuantizedAdd_8p8to32_ref= {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedSub_8p8to32_ref= {
@@ -637,6 +640,7 @@ struct nn_node_ops nn_ops_for_QuantizedSub_8p8to32_ref= {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 
@@ -648,6 +652,7 @@ struct nn_node_ops nn_ops_for_QuantizedMul_8x8to32 = {
     .flags = NN_NODE_FLAG_CLS_QUANTMUL8TO32,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedMul_8x8to32_ref= {
@@ -657,4 +662,5 @@ struct nn_node_ops nn_ops_for_QuantizedMul_8x8to32_ref= {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
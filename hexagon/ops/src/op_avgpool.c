@@ -375,6 +375,7 @@ struct nn_node_ops nn_ops_for_QuantizedAvgPool_8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedAvgPool_8_ref = {
@@ -1556,6 +1556,30 @@ static void avgpool_process_slice_special( struct avgpool_runstate const *rstp,
 
 
 
+//
+// Scratch for the largest output the output defs allow: either the per-thread
+// integral buffers (sized as if unrolled, over an input bounded by what the window
+// and stride could reduce to that output), or the 1x1 reduce result vectors.
+//
+static int avgpool_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *window_tensor = self->inputs[3];
+	const struct tensor *stride_tensor = self->inputs[4];
+	struct output const *od0 = &self->output_defs[0];
+	uint64_t win_ht = window_tensor->shape.height;
+	uint64_t win_wid = window_tensor->shape.width;
+	uint64_t in_ht = (uint64_t)od0->max_sizes[1] * stride_tensor->shape.height + win_ht;
+	uint64_t in_wid = (uint64_t)od0->max_sizes[2] * stride_tensor->shape.width + win_wid;
+	uint64_t ibuf_pad = max_i32( 3, win_wid);
+	uint64_t ibuf_bytes = 128*(2*ibuf_pad + 1 + in_wid) * (in_ht + 2*win_ht + 1);
+	uint64_t nd32 = (od0->max_sizes[3] + 62)/32u + 1;
+	uint64_t reduce_bytes = 128*((od0->max_sizes[0]*nd32 + 1) & ~1);
+	uint64_t total = max_u64( ibuf_bytes*AVGPOOL_MAX_THREADS, reduce_bytes);
+	if( total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 static int avgpool_check(struct nn_node *self, struct nn_graph *nn)
 {
 	const struct tensor *window_tensor = self->inputs[3];
@@ -1606,6 +1630,7 @@ struct nn_node_ops nn_ops_for_QuantizedAvgPool_8_d32 = {
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT | NN_NODE_FLAG_OUTPUT_ACCEPTS_PREPARATION,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = avgpool_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedAvgPool_8_d32_ref = {
@@ -1616,5 +1641,6 @@ struct nn_node_ops nn_ops_for_QuantizedAvgPool_8_d32_ref = {
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT | NN_NODE_FLAG_OUTPUT_ACCEPTS_PREPARATION,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = avgpool_scratch_hint,
 };
 
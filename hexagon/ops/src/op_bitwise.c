@@ -169,6 +169,7 @@ struct nn_node_ops nn_ops_for_BitwiseAnd_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_BitwiseOr_int32 = {
@@ -178,6 +179,7 @@ struct nn_node_ops nn_ops_for_BitwiseOr_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_BitwiseXor_int32 = {
@@ -187,6 +189,7 @@ struct nn_node_ops nn_ops_for_BitwiseXor_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_BitwiseNot_int32 = {
@@ -196,4 +199,5 @@ struct nn_node_ops nn_ops_for_BitwiseNot_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(1),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
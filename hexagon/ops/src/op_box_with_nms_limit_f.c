@@ -38,6 +38,9 @@
 #include <math.h>
 #include <stdlib.h>
 #include "2d_geometry.h"
+#include <quantize.h>
+#include "nn_bufferpool.h"
+#include "nn_nms.h"
 #ifndef __hexagon__
 #include <malloc.h>
 #include <2d_geometry.h>
@@ -51,6 +54,15 @@
  * This contains a box with nms limit op.
  */
 
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+// upright boxes for the shared nms: x1,y1,x2,y2,area per box
+#define UPRIGHT_BOX_STRIDE 5
+
 
 static void load_upright_boxes(float* boxes, int total_boxes, int total_classes, rectangle** result){
 
@@ -74,6 +86,24 @@ static void load_rotated_boxes(float* boxes, int total_boxes, int total_classes,
 	}
 }
 
+// Packed boxes for the shared nms, with the same bounds and areas the rectangle code would use
+static void load_upright_boxes_packed(float* boxes, int total_boxes, int total_classes, float** result){
+
+	for(int i = 0; i < total_classes; i++){
+		float* boxes_i = nn_malloc(total_boxes*UPRIGHT_BOX_STRIDE*sizeof(float));
+		for(int j = 0; j < total_boxes; j++){
+			const float *d = boxes + 4*i + j*4*total_classes;
+			float *o = boxes_i + j*UPRIGHT_BOX_STRIDE;
+			o[0] = fminf(d[0], d[2]);
+			o[1] = fminf(d[1], d[3]);
+			o[2] = fmaxf(d[0], d[2]);
+			o[3] = fmaxf(d[1], d[3]);
+			o[4] = ((d[3] - d[1]) + 1.f) * ((d[2] - d[0]) + 1.f);
+		}
+		result[i] = boxes_i;
+	}
+}
+
 static void load_scores(float* scores, int total_boxes, int total_classes, float** result){
 
 	for(int i = 0; i < total_classes; i++){
@@ -285,6 +315,88 @@ int compare_keep_index(const void *a, const void *b){
 	return ( index_b.score - index_a.score > 0.0 ? 1 : -1 );
 }
 
+// the classes of one batch are done in parallel, one class per job
+struct box_nms_runstate {
+	int offset;			// first box of the batch
+	int num_boxes;
+	int num_classes;
+	float score_threshold;
+	float nms_threshold;
+	int keep_max;			// per class; -1 for no limit
+	int soft_nms_enabled;
+	unsigned int soft_nms_method;
+	float soft_nms_sigma;
+	float soft_nms_min_score_threshold;
+	int rotated;
+	rectangle **boxes;		// per class; for soft nms and rotated boxes only
+	float **upright;		// per class, UPRIGHT_BOX_STRIDE per box; for hard nms on upright boxes
+	float **scores;
+	int **keeps;
+	int *total_keep_per_class;
+	struct buffer_pool bufs;	// per thread: indices, nms candidates, nms keepset
+	volatile int next_job;
+	nn_sem_t done_sem;
+};
+
+static void box_nms_class(struct box_nms_runstate *rstp, int i, void *buf)
+{
+	int num_boxes = rstp->num_boxes;
+	int *indices = buf;
+	struct nn_nms_cand *cands = (struct nn_nms_cand *)(indices + num_boxes);
+	float *keepset_mem = (float *)(cands + num_boxes);
+	int ind_size, result_size = 0;
+
+	get_indices_gt(rstp->scores[i], rstp->offset, rstp->offset + num_boxes, rstp->score_threshold, indices, &ind_size);
+
+	if (rstp->soft_nms_enabled){
+		soft_nms(rstp->boxes[i], rstp->scores[i], indices, ind_size, rstp->nms_threshold, rstp->soft_nms_min_score_threshold,
+			rstp->soft_nms_sigma, rstp->soft_nms_method, rstp->keeps[i], &result_size);
+	}
+	else if (rstp->rotated){
+		sort_indices(indices, ind_size, rstp->scores[i]);
+		nms(rstp->boxes[i], indices, ind_size, rstp->nms_threshold, rstp->keep_max, rstp->keeps[i], &result_size);
+	}
+	else{
+		struct nn_nms_boxes boxes = {
+			.coords = rstp->upright[i],
+			.area = rstp->upright[i] + 4,
+			.stride = UPRIGHT_BOX_STRIDE,
+		};
+		struct nn_nms_params params = {
+			.iou_threshold = rstp->nms_threshold,
+			.coord_offset = 1.0f,
+			.suppress_at_equal = 0,
+			.disjoint_is_zero = 1,
+		};
+		struct nn_nms_keepset keepset;
+		nn_nms_keepset_init(&keepset, keepset_mem, num_boxes);
+		for (int j = 0; j < ind_size; j++){
+			cands[j].score = rstp->scores[i][indices[j]];
+			cands[j].idx = indices[j];
+		}
+		result_size = nn_nms_greedy(cands, ind_size, &boxes, &params, rstp->keep_max, &keepset);
+		for (int j = 0; j < result_size; j++){
+			rstp->keeps[i][j] = cands[j].idx;
+		}
+	}
+	rstp->total_keep_per_class[i] = result_size;
+}
+
+static void box_nms_work(struct nn_graph *nn, void *vinfo)
+{
+	struct box_nms_runstate *rstp = vinfo;
+	int bufind, job;
+	void *buf = bufpool_take(&rstp->bufs, &bufind);
+	if (buf != NULL){
+		// class 0 is the background
+		while (job = __sync_fetch_and_add(&rstp->next_job, 1), job < rstp->num_classes - 1){
+			box_nms_class(rstp, job + 1, buf);
+		}
+		bufpool_release(&rstp->bufs, bufind);
+	}
+	nn_sem_post(&rstp->done_sem);
+}
+
 static int box_with_nms_limit_execute(struct nn_node *self, struct nn_graph *nn)
 {
 	logmsg(nn,2,"box_with_nms_limit_execute execute. self=%p ",self);
@@ -350,11 +462,20 @@ static int box_with_nms_limit_execute(struct nn_node *self, struct nn_graph *nn)
 	
 	int *total_keep_per_class = nn_malloc(num_classes * sizeof(int*));
 
-	rectangle **boxes = nn_malloc(num_classes*sizeof(rectangle*));
-	if(rotated)
-		load_rotated_boxes(boxes_input, total_boxes, num_classes, boxes);
-	else
-		load_upright_boxes(boxes_input, total_boxes, num_classes, boxes);
+	// the rectangles are only needed for soft nms and rotated boxes; the shared nms takes packed upright boxes
+	rectangle **boxes = NULL;
+	float **upright = NULL;
+	if(rotated || soft_nms_enabled){
+		boxes = nn_malloc(num_classes*sizeof(rectangle*));
+		if(rotated)
+			load_rotated_boxes(boxes_input, total_boxes, num_classes, boxes);
+		else
+			load_upright_boxes(boxes_input, total_boxes, num_classes, boxes);
+	}
+	else{
+		upright = nn_malloc(num_classes*sizeof(float*));
+		load_upright_boxes_packed(boxes_input, total_boxes, num_classes, upright);
+	}
 	
 	float **scores = nn_malloc(num_classes*sizeof(float*));
 	load_scores(scores_input, total_boxes, num_classes, scores);
@@ -377,39 +498,64 @@ static int box_with_nms_limit_execute(struct nn_node *self, struct nn_graph *nn)
 		memset(keeps_output, 0, max_keep*4);
 	}
 
+	struct box_nms_runstate rst = {
+		.num_classes = num_classes,
+		.score_threshold = score_threshold,
+		.nms_threshold = nms_threshold,
+		.keep_max = detections_per_image > 0 ? detections_per_image : -1,
+		.soft_nms_enabled = soft_nms_enabled,
+		.soft_nms_method = soft_nms_method,
+		.soft_nms_sigma = soft_nms_sigma,
+		.soft_nms_min_score_threshold = soft_nms_min_score_threshold,
+		.rotated = rotated,
+		.boxes = boxes,
+		.upright = upright,
+		.scores = scores,
+		.keeps = keeps,
+		.total_keep_per_class = total_keep_per_class,
+	};
+	int max_num_boxes = 0;
+	for (int b = 0; b < batch_size; ++b){
+		max_num_boxes = max_i32(max_num_boxes, (int)batch_splits_data[b]);
+	}
+	int n_threads = min_i32(NUM_THREADS, num_classes - 1);
+	uint32_t thread_buf_size = max_num_boxes * (sizeof(int) + sizeof(struct nn_nms_cand)) + nn_nms_keepset_bytes(max_num_boxes);
+	void *thread_bufs = NULL;
+	int err = 0;
+	if (n_threads > 0){
+		if ((thread_bufs = nn_malloc(n_threads * thread_buf_size)) == NULL) {
+			err = errlog(nn, "can't alloc nms buffers");
+			goto free_all;
+		}
+		bufpool_init(&rst.bufs, n_threads, thread_bufs, thread_buf_size);
+	}
+
 	int keep_idx = 0;
     int offset = 0;
 	for (int b = 0; b < batch_size; ++b){
 		int total_keep = 0;
 		int num_boxes = batch_splits_data[b];
-		int* indices = nn_malloc(num_boxes*sizeof(int));
 
 		batch_splits_output[b] = 0;
 
 		for (int i = 1; i < num_classes; i++){
-
-			int ind_size, result_size = 0;
 			total_keep_per_class[i] = 0;
 			keeps[i] = nn_malloc(num_boxes*sizeof(int));
+		}
 
-			get_indices_gt(scores[i], offset, offset + num_boxes, score_threshold, indices, &ind_size);
-
-			if (soft_nms_enabled){
-				soft_nms(boxes[i], scores[i], indices, ind_size, nms_threshold, soft_nms_min_score_threshold, soft_nms_sigma, soft_nms_method, keeps[i], &result_size);
-			}
-			else{
-				int keep_max = detections_per_image > 0 ? detections_per_image : -1;
-				sort_indices(indices, ind_size, scores[i]);
-				nms(boxes[i], indices, ind_size, nms_threshold, keep_max, keeps[i], &result_size);
-			}
+		rst.offset = offset;
+		rst.num_boxes = num_boxes;
+		rst.next_job = 0;
+		nn_sem_init(&rst.done_sem, 0);
+		for (int i = 0; i < n_threads; i++)
+			nn_os_work_for_vector(nn, box_nms_work, &rst);
+		nn_sem_wait_n_times(&rst.done_sem, n_threads);
 
-			total_keep_per_class[i] += result_size;
-			batch_splits_output[b] += result_size;
-			total_keep += result_size;
+		for (int i = 1; i < num_classes; i++){
+			batch_splits_output[b] += total_keep_per_class[i];
+			total_keep += total_keep_per_class[i];
 		}
 
-		nn_free(indices);
-
         if (detections_per_image > 0 && total_keep > detections_per_image) {
             keep_index* all_scores = nn_malloc(total_keep * sizeof(keep_index));
             int idx = 0;
@@ -461,17 +607,21 @@ static int box_with_nms_limit_execute(struct nn_node *self, struct nn_graph *nn)
         offset += num_boxes;
 	}
 
+free_all:
 	for(int i = 0; i < num_classes; i++){
-		nn_free(boxes[i]);
+		if (boxes) nn_free(boxes[i]);
+		if (upright) nn_free(upright[i]);
 		nn_free(scores[i]);
 	}
-	nn_free(boxes);
+	if (boxes) nn_free(boxes);
+	if (upright) nn_free(upright);
 	nn_free(scores);
+	if (thread_bufs) nn_free(thread_bufs);
 
 	nn_free(keeps);
     nn_free(total_keep_per_class);
 
-	return 0;
+	return err;
 }
 
 
@@ -628,6 +628,7 @@ struct nn_node_ops nn_ops_for_QuantizedEqual_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT(6),
     .n_outputs = NN_IOCOUNT(1),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_QuantizedNotEqual_8 = {
     .execute = not_equal_q8_execute,
@@ -636,6 +637,7 @@ struct nn_node_ops nn_ops_for_QuantizedNotEqual_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT(6),
     .n_outputs = NN_IOCOUNT(1),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_QuantizedLess_8 = {
     .execute = less_q8_execute,
@@ -644,6 +646,7 @@ struct nn_node_ops nn_ops_for_QuantizedLess_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT(6),
     .n_outputs = NN_IOCOUNT(1),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_QuantizedLessEqual_8 = {
     .execute = less_equal_q8_execute,
@@ -652,6 +655,7 @@ struct nn_node_ops nn_ops_for_QuantizedLessEqual_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT(6),
     .n_outputs = NN_IOCOUNT(1),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_QuantizedGreater_8 = {
     .execute = greater_q8_execute,
@@ -660,6 +664,7 @@ struct nn_node_ops nn_ops_for_QuantizedGreater_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT(6),
     .n_outputs = NN_IOCOUNT(1),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_QuantizedGreaterEqual_8 = {
     .execute = greater_equal_q8_execute,
@@ -668,4 +673,5 @@ struct nn_node_ops nn_ops_for_QuantizedGreaterEqual_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT(6),
     .n_outputs = NN_IOCOUNT(1),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
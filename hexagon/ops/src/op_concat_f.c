@@ -147,7 +147,9 @@ static int concat_do_execute(
 		//}
 		out_data += copylen;
 	}
-	nn_mcmanager_wait( nn, &mcman);
+	// leave the copies running; the executor waits for them before anything which
+	// reads the output or overwrites an input.
+	nn_mcmanager_defer( nn, &mcman, self);
 
 	logmsg(nn,2,"concat %p done",self);
 	return 0;
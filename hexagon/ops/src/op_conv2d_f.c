@@ -157,6 +157,7 @@ struct nn_node_ops nn_ops_for_Conv2d_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 
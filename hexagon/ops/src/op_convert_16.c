@@ -36,6 +36,7 @@
 #include <string.h>
 #include <math.h>
 #include <quantize.h>
+#include <nn_quantize_vec.h>
 #include "nn_oper16.h"
 //
 // This contains conversions to/from 'i16 flat tensors'.
@@ -61,27 +62,17 @@ static int dequant_16_execute(struct nn_node *self, struct nn_graph *nn)
 	float maxval = tensor_get_float( self->inputs[2], 0 );
 	float scale = (maxval-minval) * (float)( 1.0/65536.);
 	int zero = 0x8000;
-	uint32_t xor = 0x80008000;
+	int xor = 0x8000;
 	if( is_u16){
 		xor = 0;
 		zero = saturate_u16( 0.5f + -minval/scale);
 	}
 	
 	float * outp = (float*) out_tensor->data;
-	int32_t const *inp = (int32_t const*)in_tensor->data;		// read in pairs
+	uint16_t const *inp = (uint16_t const*)in_tensor->data;
 	int count = tensor_element_count( in_tensor);
 	
-	int npair =count>>1;
-	for( int i =0; i < npair; i++ ){
-		uint32_t xin = *inp++ ^ xor;
-		outp[0] = scale * (float)((uint16_t)xin - zero);
-		outp[1] = scale * (float)((uint16_t)(xin>>16) - zero);
-		outp += 2;
-	}
-	if( count & 1 ){
-		uint32_t xin = *inp ^ xor;
-		outp[0] = scale * (float)((uint16_t)xin - zero);
-	}
+	nn_qvec_x16_to_f32( outp, inp, count, xor, zero, scale);
 	return 0;
 }
 
@@ -160,10 +151,8 @@ static int quant_x16_execute(struct nn_node *self, struct nn_graph *nn)
 	int16_t *outp = (int16_t *)out_tensor->data;
 	int count = tensor_element_count( in_tensor);
 	
-	for( int i = 0; i < count; i++ ){
-		int ival = roundf_i32( out_scale * inp[i]) + out_offset;
-		outp[i] =  saturate_i16(ival) ^ xor_val;
-	}
+	// outp[i] = saturate_i16( roundf_i32( out_scale * inp[i]) + out_offset) ^ xor_val
+	nn_qvec_f32_to_x16( outp, inp, count, out_scale, out_offset, xor_val);
 	return 0;
 }
 
@@ -1431,6 +1431,19 @@ packzilla_run_func(struct conv_from_d32_info const *info, uint8_t *outp, uint8_t
 //
 // output : d32 u8 tensor
 
+// Scratch for the largest output the output def allows: the general loop's temp
+// buffer, for each of 2 threads, is one row or about TBUF_TARGET_SIZE, whichever is more.
+static int convert_from_d32_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct output const *od0 = &self->output_defs[0];
+	uint64_t width_padded = (od0->max_sizes[2] + MAX_PADDING_WIDTH + 3) & ~3;
+	uint64_t depth_padded = (od0->max_sizes[3] + 127) & ~127;
+	uint64_t total = 2 * max_u64( width_padded*depth_padded, TBUF_TARGET_SIZE);
+	if( total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 static int convert_from_d32_check(struct nn_node *self, struct nn_graph *nn)
 {
 	if( self->opaque != NULL) nn_free( self->opaque);
@@ -1449,6 +1462,7 @@ struct nn_node_ops nn_ops_for_Convert_from_d32 = {
 	.flags = NN_NODE_FLAG_D32_INPUT,
 	.n_inputs = NN_IOCOUNT(1),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = convert_from_d32_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_Convert_to_d32 = {
@@ -1459,6 +1473,7 @@ struct nn_node_ops nn_ops_for_Convert_to_d32 = {
 	.flags = NN_NODE_FLAG_D32_OUTPUT,
 	.n_inputs = NN_IOCOUNT_RANGE(1,5),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 
@@ -2067,6 +2067,26 @@ space2x_d32_dtor(struct nn_node *self, struct nn_graph *nn )
 	return node_free_common( self, nn);
 }
 
+// Scratch for the largest output the output defs allow. Only DepthToSpace with
+// blocksize_w = 8 uses any: an intermediate buffer for each thread, of up to
+// out_height * nd32 rows, each (discard_w + width*elbytes) rounded up to 32, x 32
+// (discard_w < 4*bsW).
+static int depthspace_d32_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct tensor const *blocksize_tensor = self->inputs[1];
+	struct output const *od0 = &self->output_defs[0];
+	int elbytes = ( self->node_type == OP_DepthToSpace_16_d32 )? 2:1;
+	int32_t bsW = tensor_get_int32( blocksize_tensor, (blocksize_tensor->shape.depth > 1)? 1: 0);
+	*bytes = 0;
+	if( bsW != 8) return 0;
+	uint64_t stride = (((uint64_t)od0->max_sizes[2]*elbytes + 4*bsW-1 + 4*bsW-1) & -(4*bsW)) * 32;
+	uint64_t nd32 = (od0->max_sizes[3] + 62)/32u + 1;
+	uint64_t total = DEPTHTOSPACE_MAX_THREADS * stride * od0->max_sizes[1] * nd32;
+	if( total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 static int depthspace_d32_check(struct nn_node *self, struct nn_graph *nn)
 {
 	logmsg(nn,2,"Checking depth2space_d32 node %p",self);
@@ -2104,6 +2124,7 @@ struct nn_node_ops nn_ops_for_DepthToSpace_8_d32 = {
 	.n_inputs = NN_IOCOUNT_RANGE(4,5),
 	.n_outputs = NN_IOCOUNT(3),
 	.flags = NN_NODE_FLAG_CLS_CHANSHUFFLE | NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = depthspace_d32_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_BatchToSpaceND_8_d32 = {
 	.execute = batchspace_d32_execute,
@@ -2113,6 +2134,7 @@ struct nn_node_ops nn_ops_for_BatchToSpaceND_8_d32 = {
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
 	.flags = NN_NODE_FLAG_CLS_CHANSHUFFLE | NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = nn_scratch_hint_none,
 };
 struct nn_node_ops nn_ops_for_SpaceToBatchND_8_d32 = {
 	.execute = spacebatch_d32_execute,
@@ -2122,6 +2144,7 @@ struct nn_node_ops nn_ops_for_SpaceToBatchND_8_d32 = {
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
 	.flags = NN_NODE_FLAG_CLS_CHANSHUFFLE | NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 
@@ -2135,4 +2158,5 @@ struct nn_node_ops nn_ops_for_DepthToSpace_16_d32 = {
 	.n_inputs = NN_IOCOUNT_RANGE(4,5),
 	.n_outputs = NN_IOCOUNT(3),
 	.flags = NN_NODE_FLAG_CLS_CHANSHUFFLE | NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = depthspace_d32_scratch_hint,
 };
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <nn_graph.h>
+#include <string.h>
+#include <math.h>
+#include <quantize.h>
+#include <nn_elementwise_chain.h>
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains ElementwiseChain_f: a chain of float elementwise ops, fused
+ * by prepare (see nn_elementwise_chain.h). The output is made in blocks of
+ * ELTWC_BLOCK elements; the whole program is run on each block while it's in
+ * registers/L1, so each input is read once and the output written once.
+ */
+
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+#define ELTWC_BLOCK 64
+// work is handed out to the threads in chunks of about this many elements
+#define ELTWC_JOB_ELEMENTS 8192
+
+struct eltwc_operand {
+	const float *data;
+	uint32_t stride[4];		// in elements, for b,h,w,d; 0 where broadcast
+};
+
+struct eltwc_runstate {
+	const int32_t *prog;
+	int n_steps;
+	int n_opnds;			// # of inputs, including the program
+	struct eltwc_operand opnd[ELTWC_MAX_INPUTS];
+	float *out;
+	uint32_t dims[4];
+	uint32_t rows;			// b*h*w; or 1 if all operands are full-size or scalar
+	uint32_t row_len;		// d; or all the elements, if rows = 1
+	uint32_t span;			// elements per job, within a row
+	uint32_t jobs_per_row;		// if > 1, each job is part of one row
+	uint32_t rows_per_job;		// .. otherwise each job is this many whole rows
+	int jobs;
+	volatile int next_job;
+	nn_sem_t done_sem;
+};
+
+#define ELTWC_STEP(EXPR) \
+	if (xp != NULL) { for (i = 0; i < k; i++) { float a = acc[i]; float x = xp[i]; acc[i] = (EXPR); } } \
+	else { for (i = 0; i < k; i++) { float a = acc[i]; float x = xv; acc[i] = (EXPR); } }
+
+// run the program on n elements of a row; 'offs' are the offsets of the operands
+// (in elements) at the start.
+static void eltwc_run_span(struct eltwc_runstate *rstp, const uint32_t *offs, float *out, uint32_t n)
+{
+	float acc[ELTWC_BLOCK];
+	const int32_t *prog = rstp->prog;
+	uint32_t base;
+	int s, i;
+	for (base = 0; base < n; base += ELTWC_BLOCK) {
+		int k = min_u32(ELTWC_BLOCK, n - base);
+		for (s = 0; s < rstp->n_steps; s++) {
+			int opcode = prog[s*ELTWC_STEP_WORDS];
+			int opnd = prog[s*ELTWC_STEP_WORDS+1];
+			const float *xp = NULL;
+			float xv = 0.0f;
+			if (opnd == ELTWC_OPND_ACC) {
+				xp = acc;
+			} else if (opnd == ELTWC_OPND_IMM) {
+				union { int32_t i; float f; } u = { prog[s*ELTWC_STEP_WORDS+2] };
+				xv = u.f;
+			} else {
+				const struct eltwc_operand *op = &rstp->opnd[opnd];
+				if (op->stride[3] != 0) xp = op->data + offs[opnd] + base;
+				else xv = op->data[offs[opnd]];
+			}
+			switch (opcode) {
+			case ELTWC_LOAD:
+				if (xp != NULL) memcpy(acc, xp, k * sizeof(float));
+				else for (i = 0; i < k; i++) acc[i] = xv;
+				break;
+			case ELTWC_ADD: ELTWC_STEP(a + x); break;
+			case ELTWC_SUB: ELTWC_STEP(a - x); break;
+			case ELTWC_RSUB: ELTWC_STEP(x - a); break;
+			case ELTWC_MUL: ELTWC_STEP(a * x); break;
+			case ELTWC_MIN: ELTWC_STEP(fminf(a,x)); break;
+			case ELTWC_MAX: ELTWC_STEP(fmaxf(a,x)); break;
+			case ELTWC_NEG: for (i = 0; i < k; i++) acc[i] = -acc[i]; break;
+			case ELTWC_ABS: for (i = 0; i < k; i++) acc[i] = fabsf(acc[i]); break;
+			}
+		}
+		memcpy(out + base, acc, k * sizeof(float));
+	}
+}
+
+static void eltwc_run_rows(struct eltwc_runstate *rstp, uint32_t row, uint32_t nrows, uint32_t e0, uint32_t n)
+{
+	uint32_t offs[ELTWC_MAX_INPUTS];
+	uint32_t hw = rstp->dims[1] * rstp->dims[2];
+	int j;
+	for (; nrows > 0; nrows--, row++) {
+		uint32_t b = row / hw;
+		uint32_t h = (row - b * hw) / rstp->dims[2];
+		uint32_t w = row - b * hw - h * rstp->dims[2];
+		for (j = 1; j < rstp->n_opnds; j++) {
+			const uint32_t *st = rstp->opnd[j].stride;
+			offs[j] = b * st[0] + h * st[1] + w * st[2] + e0 * st[3];
+		}
+		eltwc_run_span(rstp, offs, rstp->out + (size_t)row * rstp->row_len + e0, n);
+	}
+}
+
+static void eltwc_work(struct nn_graph *nn, void *vrstp)
+{
+	struct eltwc_runstate *rstp = vrstp;
+	int job;
+	while ((job = __sync_fetch_and_add(&rstp->next_job, 1)) < rstp->jobs) {
+		if (rstp->jobs_per_row > 1) {
+			uint32_t e0 = (job % rstp->jobs_per_row) * rstp->span;
+			eltwc_run_rows(rstp, job / rstp->jobs_per_row, 1, e0, min_u32(rstp->span, rstp->row_len - e0));
+		} else {
+			uint32_t row = job * rstp->rows_per_job;
+			eltwc_run_rows(rstp, row, min_u32(rstp->rows_per_job, rstp->rows - row), 0, rstp->row_len);
+		}
+	}
+	nn_sem_post(&rstp->done_sem);
+}
+
+static int eltwc_execute(struct nn_node *self, struct nn_graph *nn)
+{
+	struct tensor *out_tensor = self->outputs[0];
+	struct eltwc_runstate rst;
+	int n_opnds = self->n_inputs;
+	int flat = 1;
+	int i, j;
+
+	rst.prog = self->inputs[0]->data;
+	rst.n_steps = self->inputs[0]->data_size / (ELTWC_STEP_WORDS * sizeof(int32_t));
+	rst.n_opnds = n_opnds;
+	// output shape is the broadcast of all the operands
+	for (j = 0; j < 4; j++) rst.dims[j] = 1;
+	for (i = 1; i < n_opnds; i++) {
+		const struct tensor *t = self->inputs[i];
+		for (j = 0; j < 4; j++) {
+			uint32_t d = t->shape.dimension[j];
+			if (d == rst.dims[j] || d == 1) continue;
+			if (rst.dims[j] != 1) return errlog(nn,"elementwise chain: can't broadcast input %d dim %d (%d vs %d)",
+				i, j, (int)d, (int)rst.dims[j]);
+			rst.dims[j] = d;
+		}
+	}
+	if (tensor_out_prepare_normal(out_tensor, rst.dims[0], rst.dims[1], rst.dims[2], rst.dims[3], NN_TYPE_FLOAT) != 0) {
+		return errlog(nn,"elementwise chain: output too small");
+	}
+	uint32_t total = rst.dims[0] * rst.dims[1] * rst.dims[2] * rst.dims[3];
+	if (total == 0) return 0;
+	for (i = 1; i < n_opnds; i++) {
+		const struct tensor *t = self->inputs[i];
+		uint32_t stride = 1;
+		int full = 1;
+		int scalar = 1;
+		rst.opnd[i].data = t->data;
+		for (j = 3; j >= 0; j--) {
+			uint32_t d = t->shape.dimension[j];
+			rst.opnd[i].stride[j] = (d == 1) ? 0 : stride;
+			stride *= d;
+			if (d != rst.dims[j]) full = 0;
+			if (d != 1) scalar = 0;
+		}
+		if (!full && !scalar) flat = 0;
+		if (!full && t->data == out_tensor->data && t->data_size > 0) {
+			// the output was placed over this input (see eltwc_alias_hint), but it's broadcast
+			// at this point, so it would be overwritten before it's all read; use a copy.
+			float *copy = nn_scratch_alloc(nn, t->data_size);
+			if (copy == NULL) return errlog(nn,"elementwise chain: no scratch for %d bytes", (int)t->data_size);
+			memcpy(copy, t->data, t->data_size);
+			rst.opnd[i].data = copy;
+		}
+	}
+	rst.out = out_tensor->data;
+	if (flat) {
+		// all full-size or scalar: treat it as one long row
+		for (i = 1; i < n_opnds; i++) {
+			if (rst.opnd[i].stride[0] | rst.opnd[i].stride[1] | rst.opnd[i].stride[2] | rst.opnd[i].stride[3]) {
+				rst.opnd[i].stride[3] = 1;
+			}
+			rst.opnd[i].stride[0] = rst.opnd[i].stride[1] = rst.opnd[i].stride[2] = 0;
+		}
+		rst.dims[0] = rst.dims[1] = rst.dims[2] = 1;
+		rst.dims[3] = total;
+	}
+	rst.rows = rst.dims[0] * rst.dims[1] * rst.dims[2];
+	rst.row_len = rst.dims[3];
+	if (rst.row_len > ELTWC_JOB_ELEMENTS) {
+		rst.span = ELTWC_JOB_ELEMENTS;
+		rst.jobs_per_row = (rst.row_len + ELTWC_JOB_ELEMENTS - 1) / ELTWC_JOB_ELEMENTS;
+		rst.rows_per_job = 1;
+		rst.jobs = rst.rows * rst.jobs_per_row;
+	} else {
+		rst.span = rst.row_len;
+		rst.jobs_per_row = 1;
+		rst.rows_per_job = max_u32(1, ELTWC_JOB_ELEMENTS / rst.row_len);
+		rst.jobs = (rst.rows + rst.rows_per_job - 1) / rst.rows_per_job;
+	}
+	rst.next_job = 0;
+	nn_sem_init(&rst.done_sem, 0);
+	int nthreads = min_i32(NUM_THREADS, rst.jobs);
+	for (i = 0; i < nthreads; i++) nn_os_work_for_vector(nn, eltwc_work, &rst);
+	nn_sem_wait_n_times(&rst.done_sem, nthreads);
+	return 0;
+}
+
+static int eltwc_check(struct nn_node *self, struct nn_graph *nn)
+{
+	const struct tensor *prog_tensor = self->inputs[0];
+	const int32_t *prog = prog_tensor->data;
+	int n_steps = prog_tensor->data_size / (ELTWC_STEP_WORDS * sizeof(int32_t));
+	int s;
+	if (self->n_inputs > ELTWC_MAX_INPUTS) return errlog(nn,"elementwise chain: too many inputs");
+	if (n_steps < 1 || n_steps > ELTWC_MAX_STEPS
+	    || prog_tensor->data_size != n_steps * ELTWC_STEP_WORDS * sizeof(int32_t)) {
+		return errlog(nn,"elementwise chain: bad program size %d", (int)prog_tensor->data_size);
+	}
+	if (prog[0] != ELTWC_LOAD) return errlog(nn,"elementwise chain: program must start with LOAD");
+	for (s = 0; s < n_steps; s++) {
+		int opcode = prog[s*ELTWC_STEP_WORDS];
+		int opnd = prog[s*ELTWC_STEP_WORDS+1];
+		if (opcode < 0 || opcode >= ELTWC_N_OPCODES) return errlog(nn,"elementwise chain: bad opcode %d", opcode);
+		if (opnd == ELTWC_OPND_IMM) continue;
+		if (opnd == ELTWC_OPND_ACC && s > 0) continue;
+		if (opnd < 1 || opnd >= self->n_inputs) return errlog(nn,"elementwise chain: bad operand %d", opnd);
+	}
+	return 0;
+}
+
+// The output can go over an operand which has the same shape as the output, and
+// which isn't read after this node: each block of the output is written after
+// all the operands are read for it.
+static int eltwc_alias_hint(struct nn_node *self, struct nn_graph *nn, int out_idx, struct nn_alias_hint *hint)
+{
+	struct output const *od = &self->output_defs[0];
+	int i, j;
+	if (out_idx != 0) return -1;
+	for (i = 1; i < self->n_inputs; i++) {
+		struct nn_node *src = find_node(nn, self->input_refs[i].src_id);
+		if (src == NULL || self->inputs[i]->last_consumer != self) continue;
+		struct output const *sd = &src->output_defs[self->input_refs[i].output_idx];
+		if (sd->elementsize != sizeof(float)) continue;
+		for (j = 0; j < 4; j++) {
+			if (sd->max_sizes[j] != od->max_sizes[j]) break;
+		}
+		if (j < 4) continue;
+		hint->kind = NN_ALIAS_INPLACE;
+		hint->in_idx = i;
+		return 0;
+	}
+	return -1;
+}
+
+// Scratch is only used for a copy of an operand which the output was placed over,
+// when that operand turns out to be broadcast; it's no bigger than the output.
+static int eltwc_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct tensor const *out_tensor = self->outputs[0];
+	int i;
+	*bytes = 0;
+	for (i = 1; i < self->n_inputs; i++) {
+		if (self->inputs[i]->data == out_tensor->data) *bytes = out_tensor->max_size;
+	}
+	return 0;
+}
+
+struct nn_node_ops nn_ops_for_ElementwiseChain_f = {
+	.execute = eltwc_execute,
+	.check = eltwc_check,
+	.ctor = node_alloc_common,
+	.dtor = node_free_common,
+	.n_inputs = NN_IOCOUNT_RANGE(2,ELTWC_MAX_INPUTS),
+	.n_outputs = NN_IOCOUNT(1),
+	.alias_hint = eltwc_alias_hint,
+	.scratch_hint = eltwc_scratch_hint,
+};
@@ -125,6 +125,7 @@ struct nn_node_ops nn_ops_for_Flatten = {
 	.ctor = node_alloc_common,
 	.dtor = node_free_common,
 	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.alias_hint = nn_alias_hint_view_input0,
 	.n_inputs = NN_IOCOUNT_RANGE(1,2),
 	.n_outputs = NN_IOCOUNT(1),
 };
@@ -135,6 +136,7 @@ struct nn_node_ops nn_ops_for_QuantizedFlatten = {
 	.ctor = node_alloc_common,
 	.dtor = node_free_common,
 	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.alias_hint = nn_alias_hint_view_input0,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(3),
 };
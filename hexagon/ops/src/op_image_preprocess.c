@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <nn_graph.h>
+#include <string.h>
+#include <math.h>
+#include <quantize.h>
+#include "float_mathops.h"
+#include "nn_bufferpool.h"
+#include "nn_quantize_vec.h"
+#include "nn_image_preprocess.h"
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains ImagePreprocess_8 (see nn_image_preprocess.h): color conversion,
+ * warp, resize, normalization and quantization in one pass.
+ *
+ * Nothing full-size is made except the output: the work is split into bands of
+ * output rows, and each output row is built in a float row buffer, then normalized
+ * and quantized into the output.
+ *  - no warp: each source row needed is converted to float (color conversion and
+ *    dequantize) and then, for resize, interpolated along the width, using tables
+ *    as in op_resizebilinear.c; consecutive output rows mostly share source rows.
+ *  - warp: each output pixel has a precomputed source position; the four source
+ *    pixels are converted as they are read.
+ * The coordinate tables depend only on the shapes and the transform; they are
+ * cached on the node and rebuilt when those change.
+ * The float math is done in the same order as in the ops it replaces.
+ */
+
+#define NUM_THREADS 2
+
+#define IMGPRE_NOSAMPLE INT32_MIN		// x0 for an output pixel which is all zero
+
+struct imgpre_sample {
+	int32_t x0, y0;			// top left source pixel (may be -1)
+	float xfrac, yfrac;
+};
+
+struct imgpre_tables {
+	int32_t batches;
+	int32_t in_height, in_width;
+	int32_t out_height, out_width;
+	int32_t flags;
+	// resize without warp (as struct bilin_tables in op_resizebilinear.c):
+	int32_t *yidx;			// [out_height][2]
+	float *yfrac;			// [out_height]
+	int32_t *xoff;			// [out_width][2]: element offsets (x*3)
+	float *xfrac;			// [out_width]
+	// warp:
+	float *coeffs;			// [batches][8]: the transform the samples are for
+	struct imgpre_sample *samples;	// [batches][out_height][out_width]
+};
+
+// what's kept in self->opaque
+struct imgpre_info {
+	struct imgpre_tables *tables;	// or NULL
+};
+
+struct imgpre_src {
+	const uint8_t *data;
+	int32_t format;
+	int32_t is_bgr;
+	int32_t height, width;
+	uint32_t batch_stride;		// bytes per image
+	int32_t swiz, rsh;		// for RGBA, ARGB
+	int32_t qzero;			// dequantize, as Dequantize
+	float qstep;
+};
+
+struct imgpre_runstate {
+	struct imgpre_src src;
+	const struct imgpre_tables *tp;
+	uint8_t *out;
+	float mean[3];
+	float scale[3];
+	int norm_identity;		// mean = 0, scale = 1
+	float out_min;
+	float out_recip;
+	int32_t rows_per_job;
+	int32_t inner_count;		// jobs per batch
+	struct buffer_pool rowbufs;
+	nn_sem_t done_sem;
+	int32_t jobs;
+	volatile int32_t next_job;
+};
+
+static void imgpre_scales(int32_t h_in, int32_t w_in, int32_t h_out, int32_t w_out, int32_t flags,
+	float *xscale, float *yscale)
+{
+	if (!(flags & IMGPRE_FLAG_RESIZE)) {
+		*xscale = 1.0f;
+		*yscale = 1.0f;
+	} else if (!(flags & IMGPRE_FLAG_ALIGN_CORNERS)) {
+		*xscale = (float)w_in / w_out;
+		*yscale = (float)h_in / h_out;
+	} else {
+		*xscale = (float)(w_in - 1) / (w_out - 1);
+		*yscale = (float)(h_in - 1) / (h_out - 1);
+	}
+}
+
+static void imgpre_make_resize_tables(struct imgpre_tables *tp)
+{
+	int32_t h_in = tp->in_height, w_in = tp->in_width;
+	float xscale, yscale;
+	imgpre_scales(h_in, w_in, tp->out_height, tp->out_width, tp->flags, &xscale, &yscale);
+	for (int32_t h = 0; h < tp->out_height; h++) {
+		float yfloat = h * yscale;
+		float yfrac = yfloat - floorf(yfloat);
+		int32_t yint = yfloat - yfrac;
+		tp->yidx[2 * h + 0] = min_i32(h_in - 1, yint);
+		tp->yidx[2 * h + 1] = min_i32(h_in - 1, yint + 1);
+		tp->yfrac[h] = yfrac;
+	}
+	for (int32_t w = 0; w < tp->out_width; w++) {
+		float xfloat = w * xscale;
+		float xfrac = xfloat - floorf(xfloat);
+		int32_t xint = xfloat - xfrac;
+		tp->xoff[2 * w + 0] = min_i32(w_in - 1, xint) * 3;
+		tp->xoff[2 * w + 1] = min_i32(w_in - 1, xint + 1) * 3;
+		tp->xfrac[w] = xfrac;
+	}
+}
+
+// source position of each output pixel, as in ImageTransform_f; with resize, the
+// transform is applied at the resize grid position.
+static void imgpre_make_warp_tables(struct imgpre_tables *tp)
+{
+	int32_t h_in = tp->in_height, w_in = tp->in_width;
+	int32_t resize = (tp->flags & IMGPRE_FLAG_RESIZE) != 0;
+	struct imgpre_sample *sp = tp->samples;
+	float xscale, yscale;
+	imgpre_scales(h_in, w_in, tp->out_height, tp->out_width, tp->flags, &xscale, &yscale);
+	for (int32_t b = 0; b < tp->batches; b++) {
+		const float *c = tp->coeffs + 8 * b;
+		float a0 = c[0], a1 = c[1], a2 = c[2];
+		float b0 = c[3], b1 = c[4], b2 = c[5];
+		float c0 = c[6], c1 = c[7];
+		for (int32_t y = 0; y < tp->out_height; y++) {
+			float yp = resize ? y * yscale : (float)y;
+			for (int32_t x = 0; x < tp->out_width; x++, sp++) {
+				float xp = resize ? x * xscale : (float)x;
+				float k = c0 * xp + c1 * yp + 1.f;
+				sp->x0 = IMGPRE_NOSAMPLE;
+				if (k == 0.0f) continue;
+				float xin = (a0 * xp + a1 * yp + a2) / k;
+				float yin = (b0 * xp + b1 * yp + b2) / k;
+				// at least one of the 4 source pixels must be inside
+				if (!(xin >= -1.0f && xin < (float)w_in && yin >= -1.0f && yin < (float)h_in)) continue;
+				sp->x0 = floorf(xin);
+				sp->y0 = floorf(yin);
+				sp->xfrac = xin - (float)sp->x0;
+				sp->yfrac = yin - (float)sp->y0;
+			}
+		}
+	}
+}
+
+static struct imgpre_tables *
+imgpre_tables_get(
+	struct imgpre_info *info,
+	int32_t b, int32_t h_in, int32_t w_in, int32_t h_out, int32_t w_out, int32_t flags,
+	const float *coeffs)
+{
+	struct imgpre_tables *tp = info->tables;
+	int32_t warp = (flags & IMGPRE_FLAG_WARP) != 0;
+	if (!warp) b = 0;		// tables don't depend on batches
+	if (tp != NULL) {
+		if (tp->batches == b && tp->in_height == h_in && tp->in_width == w_in
+			&& tp->out_height == h_out && tp->out_width == w_out && tp->flags == flags
+			&& (!warp || memcmp(tp->coeffs, coeffs, 8 * b * sizeof(float)) == 0)) {
+			return tp;
+		}
+		nn_free(tp);
+		info->tables = NULL;
+	}
+	size_t size = sizeof(struct imgpre_tables);
+	if (warp) {
+		size += (size_t)b * 8 * sizeof(float) + (size_t)b * h_out * w_out * sizeof(struct imgpre_sample);
+	} else {
+		size += (size_t)h_out * 3 * sizeof(int32_t) + (size_t)w_out * 3 * sizeof(int32_t);
+	}
+	if ((tp = nn_malloc(size)) == NULL) return NULL;
+	memset(tp, 0, sizeof(struct imgpre_tables));
+	tp->batches = b;
+	tp->in_height = h_in;
+	tp->in_width = w_in;
+	tp->out_height = h_out;
+	tp->out_width = w_out;
+	tp->flags = flags;
+	if (warp) {
+		tp->coeffs = (float *)(tp + 1);
+		tp->samples = (struct imgpre_sample *)(tp->coeffs + 8 * b);
+		memcpy(tp->coeffs, coeffs, 8 * b * sizeof(float));
+		imgpre_make_warp_tables(tp);
+	} else {
+		tp->yidx = (int32_t *)(tp + 1);
+		tp->yfrac = (float *)(tp->yidx + 2 * h_out);
+		tp->xoff = (int32_t *)(tp->yfrac + h_out);
+		tp->xfrac = (float *)(tp->xoff + 2 * w_out);
+		imgpre_make_resize_tables(tp);
+	}
+	info->tables = tp;
+	return tp;
+}
+
+//
+// color conversion. These are the same as in op_nv21torgb.c and op_rgbatorgb.c
+//
+static inline void imgpre_yuv_to_rgb(int32_t y, int32_t u, int32_t v, int32_t is_bgr, uint8_t *rgb)
+{
+	int32_t C = y;
+	int32_t D = u - 128;
+	int32_t E = v - 128;
+	int32_t r = min_i32(max_i32(256 * C + 359 * E + 128, 0), 65535) >> 8;
+	int32_t g = min_i32(max_i32(256 * C - 88 * D - 183 * E + 128, 0), 65535) >> 8;
+	int32_t b = min_i32(max_i32(256 * C + 454 * D + 128, 0), 65535) >> 8;
+	rgb[0] = is_bgr ? b : r;
+	rgb[1] = g;
+	rgb[2] = is_bgr ? r : b;
+}
+
+static inline void imgpre_get_u8(const struct imgpre_src *sp, const uint8_t *img, int32_t x, int32_t y, uint8_t *rgb)
+{
+	int32_t pos = y * sp->width + x;
+	if (sp->format == IMGPRE_FMT_RGB) {
+		const uint8_t *p = img + 3 * pos;
+		rgb[0] = p[0];
+		rgb[1] = p[1];
+		rgb[2] = p[2];
+	} else if (sp->format == IMGPRE_FMT_NV21) {
+		const uint8_t *vu = img + sp->width * sp->height + (y >> 1) * sp->width + (x & ~1);
+		imgpre_yuv_to_rgb(img[pos], vu[1], vu[0], sp->is_bgr, rgb);
+	} else {
+		uint32_t val = *(uint32_t const *)(img + 4 * pos);
+		if (sp->swiz) val = byteswap_u32(val);
+		val >>= sp->rsh;
+		rgb[0] = (uint8_t)val;
+		rgb[1] = (uint8_t)(val >> 8);
+		rgb[2] = (uint8_t)(val >> 16);
+	}
+}
+
+static inline void imgpre_dequant3(const struct imgpre_src *sp, const uint8_t *q, float *out)
+{
+	out[0] = (float)(q[0] - sp->qzero) * sp->qstep;
+	out[1] = (float)(q[1] - sp->qzero) * sp->qstep;
+	out[2] = (float)(q[2] - sp->qzero) * sp->qstep;
+}
+
+// convert source row y to float (width*3)
+static void imgpre_convert_row(const struct imgpre_src *sp, const uint8_t *img, int32_t y, float *out)
+{
+	int32_t width = sp->width;
+	uint8_t rgb[3];
+	if (sp->format == IMGPRE_FMT_RGB) {
+		nn_qvec_u8_to_f32(out, img + (size_t)y * width * 3, width * 3, sp->qzero, sp->qstep);
+		return;
+	}
+	for (int32_t x = 0; x < width; x++) {
+		imgpre_get_u8(sp, img, x, y, rgb);
+		imgpre_dequant3(sp, rgb, out + 3 * x);
+	}
+}
+
+// a source pixel for the warp, zero outside the image
+static inline void imgpre_get_pixel(const struct imgpre_src *sp, const uint8_t *img, int32_t x, int32_t y, float *out)
+{
+	uint8_t rgb[3];
+	if (x < 0 || x >= sp->width || y < 0 || y >= sp->height) {
+		out[0] = out[1] = out[2] = 0.0f;
+		return;
+	}
+	imgpre_get_u8(sp, img, x, y, rgb);
+	imgpre_dequant3(sp, rgb, out);
+}
+
+static void imgpre_warp_row(const struct imgpre_src *sp, const uint8_t *img,
+	const struct imgpre_sample *samples, float *out, int32_t w_out)
+{
+	float p00[3], p01[3], p10[3], p11[3];
+	for (int32_t x = 0; x < w_out; x++, out += 3) {
+		const struct imgpre_sample *s = &samples[x];
+		if (s->x0 == IMGPRE_NOSAMPLE) {
+			out[0] = out[1] = out[2] = 0.0f;
+			continue;
+		}
+		imgpre_get_pixel(sp, img, s->x0, s->y0, p00);
+		imgpre_get_pixel(sp, img, s->x0 + 1, s->y0, p01);
+		imgpre_get_pixel(sp, img, s->x0, s->y0 + 1, p10);
+		imgpre_get_pixel(sp, img, s->x0 + 1, s->y0 + 1, p11);
+		for (int c = 0; c < 3; c++) {
+			out[c] = bilinear_interpolate(p00[c], p01[c], p10[c], p11[c], s->xfrac, s->yfrac);
+		}
+	}
+}
+
+// convert source row y, and interpolate it along the width into 'out' (out_width*3)
+static void imgpre_hpass(const struct imgpre_src *sp, const uint8_t *img, int32_t y,
+	float *srcrow, float *out, const struct imgpre_tables *tp)
+{
+	imgpre_convert_row(sp, img, y, srcrow);
+	for (int32_t w = 0; w < tp->out_width; w++) {
+		const float *p0 = srcrow + tp->xoff[2 * w + 0];
+		const float *p1 = srcrow + tp->xoff[2 * w + 1];
+		float xfrac = tp->xfrac[w];
+		out[0] = linear_interpolate(p0[0], p1[0], xfrac);
+		out[1] = linear_interpolate(p0[1], p1[1], xfrac);
+		out[2] = linear_interpolate(p0[2], p1[2], xfrac);
+		out += 3;
+	}
+}
+
+static void imgpre_finish_row(const struct imgpre_runstate *rstp, float *row, uint8_t *out, int32_t w_out)
+{
+	if (!rstp->norm_identity) {
+		for (int32_t i = 0; i < w_out * 3; i += 3) {
+			row[i + 0] = (row[i + 0] - rstp->mean[0]) * rstp->scale[0];
+			row[i + 1] = (row[i + 1] - rstp->mean[1]) * rstp->scale[1];
+			row[i + 2] = (row[i + 2] - rstp->mean[2]) * rstp->scale[2];
+		}
+	}
+	nn_qvec_f32_to_u8(out, row, w_out * 3, rstp->out_min, rstp->out_recip);
+}
+
+static void imgpre_work(struct nn_graph *nn, void *vinfo)
+{
+	struct imgpre_runstate *rstp = (struct imgpre_runstate *)vinfo;
+	const struct imgpre_tables *tp = rstp->tp;
+	const struct imgpre_src *sp = &rstp->src;
+	int32_t flags = tp->flags;
+	int32_t h_out = tp->out_height;
+	int32_t w_out = tp->out_width;
+	int32_t out_hstride = w_out * 3;
+	int32_t job_idx;
+	int bufind;
+	float *outrow = bufpool_take(&rstp->rowbufs, &bufind);
+	float *rowa = outrow + out_hstride;
+	float *rowb = rowa + out_hstride;
+	float *srcrow = rowb + out_hstride;
+
+	batchslice_decode bsdecode;
+	batchslice_decode_init(&bsdecode, rstp->inner_count);
+
+	while (job_idx = __sync_fetch_and_add(&rstp->next_job, 1), job_idx < rstp->jobs) {
+		int32_t hid = batchslice_decode_update(&bsdecode, job_idx);
+		int32_t b = bsdecode.ibatch;
+		int32_t h0 = hid * rstp->rows_per_job;
+		int32_t h1 = min_i32(h0 + rstp->rows_per_job, h_out);
+		const uint8_t *img = sp->data + (size_t)b * sp->batch_stride;
+		uint8_t *bout = rstp->out + (size_t)b * h_out * out_hstride;
+		int32_t rowa_y = -1, rowb_y = -1;		// source row currently in each buffer
+
+		for (int32_t h = h0; h < h1; h++) {
+			if (flags & IMGPRE_FLAG_WARP) {
+				imgpre_warp_row(sp, img, tp->samples + ((size_t)b * h_out + h) * w_out, outrow, w_out);
+			} else if (!(flags & IMGPRE_FLAG_RESIZE)) {
+				imgpre_convert_row(sp, img, h, outrow);
+			} else {
+				// as resizebilinear_sep_work
+				int32_t y0 = tp->yidx[2 * h + 0];
+				int32_t y1 = tp->yidx[2 * h + 1];
+				if (rowa_y != y0) {
+					if (rowb_y == y0) {
+						float *t = rowa; rowa = rowb; rowb = t;
+						rowa_y = y0;
+						rowb_y = -1;
+					} else {
+						imgpre_hpass(sp, img, y0, srcrow, rowa, tp);
+						rowa_y = y0;
+					}
+				}
+				if (rowb_y != y1) {
+					if (y1 == y0) {
+						memcpy(rowb, rowa, out_hstride * sizeof(float));
+					} else {
+						imgpre_hpass(sp, img, y1, srcrow, rowb, tp);
+					}
+					rowb_y = y1;
+				}
+				float yfrac = tp->yfrac[h];
+				for (int32_t i = 0; i < out_hstride; i++) {
+					outrow[i] = linear_interpolate(rowa[i], rowb[i], yfrac);
+				}
+			}
+			imgpre_finish_row(rstp, outrow, bout + (size_t)h * out_hstride, w_out);
+		}
+	}
+	bufpool_release(&rstp->rowbufs, bufind);
+	nn_sem_post(&rstp->done_sem);
+}
+
+// get 1 or 3 per-channel floats
+static int imgpre_get_channel_parms(struct nn_graph *nn, const struct tensor *t, float *vals, const char *what)
+{
+	uint32_t n = t->data_size / sizeof(float);
+	if (n == 1) {
+		vals[0] = vals[1] = vals[2] = tensor_get_float(t, 0);
+	} else if (n == 3) {
+		vals[0] = tensor_get_float(t, 0);
+		vals[1] = tensor_get_float(t, 1);
+		vals[2] = tensor_get_float(t, 2);
+	} else {
+		return errlog(nn, "image preprocess: %s must have 1 or 3 values, not %d", what, (int)n);
+	}
+	return 0;
+}
+
+// each thread needs an output row, two resize rows and a source row, all float.
+static inline unsigned imgpre_rowbuf_size(int32_t w_in, int32_t w_out)
+{
+	return (((unsigned)w_out * 3 * 3 + (unsigned)w_in * 3) * sizeof(float) + 127) & ~127u;
+}
+
+static int imgpre_execute(struct nn_node *self, struct nn_graph *nn)
+{
+	const struct tensor *in_tensor = self->inputs[IMGPRE_IN_DATA];
+	const struct tensor *transform_tensor = self->inputs[IMGPRE_IN_TRANSFORM];
+	const struct tensor *newdims_tensor = self->inputs[IMGPRE_IN_NEWDIMS];
+	struct tensor *out_tensor = self->outputs[0];
+	struct tensor *out_min_tensor = self->outputs[1];
+	struct tensor *out_max_tensor = self->outputs[2];
+	struct imgpre_info *info = (struct imgpre_info *)self->opaque;
+	struct imgpre_runstate rst;
+	struct imgpre_src *sp = &rst.src;
+
+	int32_t format = tensor_get_int32(self->inputs[IMGPRE_IN_FORMAT], 0);
+	int32_t flags = tensor_get_int32(self->inputs[IMGPRE_IN_FLAGS], 0);
+	int32_t b_in = in_tensor->shape.batches;
+	int32_t h_in = in_tensor->shape.height;
+	int32_t w_in = in_tensor->shape.width;
+	int32_t d_in = in_tensor->shape.depth;
+	int32_t h_out = h_in;
+	int32_t w_out = w_in;
+
+	sp->data = in_tensor->data;
+	sp->format = format;
+	sp->is_bgr = tensor_get_int32(self->inputs[IMGPRE_IN_ISBGR], 0) != 0;
+	sp->height = h_in;
+	sp->width = w_in;
+	sp->swiz = 0;
+	sp->rsh = 0;
+	switch (format) {
+	case IMGPRE_FMT_RGB:
+		if (d_in != 3) return errlog(nn, "image preprocess: RGB input depth must be 3, not %d", d_in);
+		sp->batch_stride = h_in * w_in * 3;
+		break;
+	case IMGPRE_FMT_NV21:
+		if ((h_in | w_in) & 1) return errlog(nn, "image preprocess: NV21 input must be even size, not %dx%d", h_in, w_in);
+		sp->batch_stride = (h_in * w_in * 3) / 2;
+		break;
+	case IMGPRE_FMT_RGBA:
+	case IMGPRE_FMT_ARGB:
+		if (d_in != 4) return errlog(nn, "image preprocess: RGBA/ARGB input depth must be 4, not %d", d_in);
+		sp->batch_stride = h_in * w_in * 4;
+		// see rgba_to_rgb_execute
+		sp->swiz = sp->is_bgr;
+		if (format == IMGPRE_FMT_RGBA) sp->rsh = sp->is_bgr ? 8 : 0;
+		else sp->rsh = sp->is_bgr ? 0 : 8;
+		break;
+	default:
+		return errlog(nn, "image preprocess: bad format %d", (int)format);
+	}
+
+	if (flags & IMGPRE_FLAG_RESIZE) {
+		if (newdims_tensor->data_size < 2 * sizeof(int32_t)) return errlog(nn, "image preprocess: need 2 newdims");
+		h_out = tensor_get_int32(newdims_tensor, 0);
+		w_out = tensor_get_int32(newdims_tensor, 1);
+		if ((flags & IMGPRE_FLAG_ALIGN_CORNERS) && (w_out <= 1 || h_out <= 1)) {
+			return errlog(nn, "aligned_corners flag is no good with out width/height of 1 or less");
+		}
+	}
+	if (h_out <= 0 || w_out <= 0) return errlog(nn, "image preprocess: bad output size %dx%d", h_out, w_out);
+	if ((flags & IMGPRE_FLAG_WARP) && transform_tensor->data_size < 8 * b_in * sizeof(float)) {
+		return errlog(nn, "image preprocess: transform needs 8 values per batch");
+	}
+
+	// dequantize, as dequantize_execute
+	float in_min = tensor_get_float(self->inputs[IMGPRE_IN_MIN], 0);
+	float in_max = tensor_get_float(self->inputs[IMGPRE_IN_MAX], 0);
+	float in_step = flt_div_255(fmaxf(1e-18f, in_max - in_min));
+	if (in_step < 0.f || in_step >= 0x2.0p120) {
+		return errlog(nn, "infeasible quantization step: %.6g", in_step);
+	}
+	sp->qzero = saturate_u8(roundf_i32(-in_min / in_step));
+	sp->qstep = (in_step < 0x1.0p-126) ? 0.0f : in_step;
+
+	if (imgpre_get_channel_parms(nn, self->inputs[IMGPRE_IN_MEAN], rst.mean, "mean") != 0
+		|| imgpre_get_channel_parms(nn, self->inputs[IMGPRE_IN_SCALE], rst.scale, "scale") != 0) return -1;
+	rst.norm_identity = 1;
+	for (int i = 0; i < 3; i++) {
+		if (rst.mean[i] != 0.0f || rst.scale[i] != 1.0f) rst.norm_identity = 0;
+	}
+
+	// quantize, as quantize_execute_ref
+	float out_min, out_max, out_step;
+	if (quantize_adjust_range_and_check(&out_min, &out_max, &out_step, &rst.out_recip,
+		tensor_get_float(self->inputs[IMGPRE_IN_OUT_MIN], 0),
+		tensor_get_float(self->inputs[IMGPRE_IN_OUT_MAX], 0)) != 0) {
+		return errlog(nn, "invalid range for quantize");
+	}
+	rst.out_min = out_min;
+
+	if (tensor_out_prepare_normal(out_tensor, b_in, h_out, w_out, 3, NN_TYPE_QUINT8) != 0) {
+		return errlog(nn, "out too small");
+	}
+	tensor_set_single_float(out_min_tensor, out_min);
+	tensor_set_single_float(out_max_tensor, out_max);
+	if (b_in <= 0) return 0;
+	logmsg(nn, 2, "image preprocess: fmt %d flags %d, %dx%dx%d --> %dx%dx3",
+		(int)format, (int)flags, h_in, w_in, d_in, h_out, w_out);
+
+	rst.tp = imgpre_tables_get(info, b_in, h_in, w_in, h_out, w_out, flags,
+		(const float *)transform_tensor->data);
+	if (rst.tp == NULL) return errlog(nn, "can't alloc image preprocess tables");
+	rst.out = out_tensor->data;
+	// a few bands per thread for balance, but not so small that source rows aren't reused.
+	rst.inner_count = min_i32(h_out, 2 * NUM_THREADS);
+	rst.rows_per_job = (h_out + rst.inner_count - 1) / rst.inner_count;
+	rst.inner_count = (h_out + rst.rows_per_job - 1) / rst.rows_per_job;
+	rst.jobs = b_in * rst.inner_count;
+	rst.next_job = 0;
+
+	int32_t n_threads = min_i32(NUM_THREADS, rst.jobs);
+	unsigned rowbuf_size = imgpre_rowbuf_size(w_in, w_out);
+	nn_scratch_reset(nn);
+	if (nn_scratch_grow(nn, rowbuf_size * n_threads + 128)) {
+		return errlog(nn, "can't get scratch for %d row buffers", n_threads);
+	}
+	void *mem = nn_scratch_alloc(nn, rowbuf_size * n_threads);
+	if (mem == NULL) return errlog(nn, "didn't get temp mem");
+	bufpool_init(&rst.rowbufs, n_threads, mem, rowbuf_size);
+
+	nn_sem_init(&rst.done_sem, 0);
+	for (int32_t i = 0; i < n_threads; i++)
+		nn_os_work_for_vector(nn, imgpre_work, &rst);
+	nn_sem_wait_n_times(&rst.done_sem, n_threads);
+	return 0;
+}
+
+static int imgpre_check(struct nn_node *self, struct nn_graph *nn)
+{
+	int32_t format = tensor_get_int32(self->inputs[IMGPRE_IN_FORMAT], 0);
+	int32_t flags = tensor_get_int32(self->inputs[IMGPRE_IN_FLAGS], 0);
+	if (format < 0 || format >= IMGPRE_N_FORMATS) return errlog(nn, "image preprocess: bad format %d", (int)format);
+	if (flags & ~(IMGPRE_FLAG_WARP | IMGPRE_FLAG_RESIZE | IMGPRE_FLAG_ALIGN_CORNERS)) {
+		return errlog(nn, "image preprocess: bad flags 0x%x", (unsigned)flags);
+	}
+	return 0;
+}
+
+// the widths aren't known until execute; size for the largest the output defs allow.
+static int imgpre_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct nn_node *src = find_node(nn, self->input_refs[IMGPRE_IN_DATA].src_id);
+	if (src == NULL) return -1;
+	int32_t w_in = src->output_defs[self->input_refs[IMGPRE_IN_DATA].output_idx].max_sizes[2];
+	int32_t w_out = self->output_defs[0].max_sizes[2];
+	*bytes = imgpre_rowbuf_size(w_in, w_out) * NUM_THREADS + 128;
+	return 0;
+}
+
+static struct nn_node *imgpre_ctor(
+	struct nn_graph *nn,
+	uint32_t node_id,
+	op_type operation,
+	padding_type padding,
+	uint32_t num_inputs,
+	uint32_t num_outputs,
+	const struct input *inputs,
+	const struct output *outputs)
+{
+	struct nn_node *self = node_alloc_common(nn, node_id, operation, padding, num_inputs, num_outputs, inputs, outputs);
+	if (self == NULL) return NULL;
+	if ((self->opaque = nn_calloc(1, sizeof(struct imgpre_info))) == NULL) {
+		errlog(nn, "can't alloc image preprocess info");
+		node_free_common(self, nn);
+		return NULL;
+	}
+	return self;
+}
+
+static int imgpre_dtor(struct nn_node *self, struct nn_graph *nn)
+{
+	struct imgpre_info *info = (struct imgpre_info *)self->opaque;
+	if (info != NULL && info->tables != NULL) nn_free(info->tables);
+	return node_free_common_release_opaque(self, nn);
+}
+
+struct nn_node_ops nn_ops_for_ImagePreprocess_8 = {
+	.execute = imgpre_execute,
+	.check = imgpre_check,
+	.ctor = imgpre_ctor,
+	.dtor = imgpre_dtor,
+	.n_inputs = NN_IOCOUNT(IMGPRE_N_INPUTS),
+	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = imgpre_scratch_hint,
+};
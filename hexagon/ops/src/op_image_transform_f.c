@@ -354,6 +354,16 @@ static int image_transform_execute_f(struct nn_node *self, struct nn_graph *nn){
 	return 0;
 }
 
+// the interpolation tables for half the output rows, three times over (see above);
+// the output is the shape of the input, so size for the largest output.
+static int image_transform_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	uint32_t out_height = self->output_defs[0].max_sizes[1];
+	uint32_t out_width = self->output_defs[0].max_sizes[2];
+	*bytes = out_width*((out_height+1)/2)*sizeof(struct bilinear_interpolation_info)*3;
+	return 0;
+}
+
 
 struct nn_node_ops nn_ops_for_ImageTransform_f = {
 		.execute = image_transform_execute_f,
@@ -363,4 +373,5 @@ struct nn_node_ops nn_ops_for_ImageTransform_f = {
 		.n_inputs = NN_IOCOUNT(2),
 		.n_outputs = NN_IOCOUNT(1),
 		.flags = NN_NODE_FLAG_CLS_IMAGETRANSFORM,
+		.scratch_hint = image_transform_scratch_hint,
 };
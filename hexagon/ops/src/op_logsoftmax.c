@@ -36,42 +36,81 @@
 #include <nn_graph.h>
 #include <string.h>
 #include <math.h>
+#include <quantize.h>
+#include "float_mathops.h"
 
 
-static inline int logsoftmax_execute(struct nn_node *self, struct nn_graph *nn)
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+// rows are handed out to the threads in chunks of about this many elements
+#define LOGSOFTMAX_JOB_ELEMENTS 16384
+
+struct logsoftmax_runstate {
+	const float *in;
+	float *out;
+	int depth;
+	int rows;
+	int rows_per_job;
+	int jobs;
+	volatile int next_job;
+	nn_sem_t done_sem;
+};
+
+static void logsoftmax_work(struct nn_graph *nn, void *vrstp)
+{
+	struct logsoftmax_runstate *rstp = (struct logsoftmax_runstate *)vrstp;
+	int depth = rstp->depth;
+	int job;
+	while (job = __sync_fetch_and_add(&rstp->next_job, 1), job < rstp->jobs) {
+		int row0 = job * rstp->rows_per_job;
+		int row1 = min_i32(row0 + rstp->rows_per_job, rstp->rows);
+		const float *data = rstp->in + (size_t)row0 * depth;
+		float *out = rstp->out + (size_t)row0 * depth;
+		for (int r = row0; r < row1; r++) {
+			float maxval = float_row_max(data, depth);
+			float log_sum = logf(float_row_sum_exp(data, NULL, depth, 1.0f, maxval));
+			// (data[i] - maxval) is exact for the larger values; folding maxval into
+			// log_sum first would round it away when |maxval| is large.
+			for (int i = 0; i < depth; i++) {
+				out[i] = (data[i] - maxval) - log_sum;
+			}
+			out += depth;
+			data += depth;
+		}
+	}
+	nn_sem_post(&rstp->done_sem);
+}
+
+static int logsoftmax_execute(struct nn_node *self, struct nn_graph *nn)
 {
-	int i;
-	int j;
 	const struct tensor *in_tensor = self->inputs[0];
 	struct tensor *out_tensor = self->outputs[0];
 	int depth = in_tensor->shape.depth;
-	int batches = in_tensor->shape.batches;
-	int height = in_tensor->shape.height;
-	int width = in_tensor->shape.width;
-	const float *data = in_tensor->data;
-	float *out = out_tensor->data;
-	float maxval;
-	float sum_of_exps;
-	float log_sum_of_exps;
+	int rows = in_tensor->shape.batches * in_tensor->shape.height * in_tensor->shape.width;
+	struct logsoftmax_runstate rst;
 	if( tensor_out_prepare_normal_fromshape(out_tensor, &in_tensor->shape, NN_TYPE_FLOAT)!= 0){
 		return errlog(nn,"out too small");
 	}
-	for (j = 0; j < batches*height*width; j++) {
-		sum_of_exps = 0.0f;
-		maxval = data[0];
-		for (i = 0; i < depth; i++) {
-			if (data[i] > maxval) maxval = data[i];
-		}
-		for (i = 0; i < depth; i++) {
-			sum_of_exps += expf(data[i] - maxval);
-		}
-		log_sum_of_exps = logf(sum_of_exps);
-		for (i = 0; i < depth; i++) {
-			out[i] = data[i] - maxval - log_sum_of_exps;
-		}
-		out += depth;
-		data += depth;
+	if (rows == 0 || depth == 0) return 0;
+
+	rst.in = in_tensor->data;
+	rst.out = out_tensor->data;
+	rst.depth = depth;
+	rst.rows = rows;
+	rst.rows_per_job = max_i32(1, LOGSOFTMAX_JOB_ELEMENTS / depth);
+	rst.jobs = (rows + rst.rows_per_job - 1) / rst.rows_per_job;
+	rst.next_job = 0;
+
+	int nthreads = min_i32(NUM_THREADS, rst.jobs);
+	nn_sem_init(&rst.done_sem, 0);
+	for (int i = 0; i < nthreads; i++) {
+		nn_os_work_for_vector(nn, logsoftmax_work, &rst);
 	}
+	nn_sem_wait_n_times(&rst.done_sem, nthreads);
 	return 0;
 }
 
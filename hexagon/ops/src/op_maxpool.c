@@ -353,6 +353,7 @@ struct nn_node_ops nn_ops_for_QuantizedMaxPool_8 = {
 	.flags = NN_NODE_FLAG_OUTPUT_USES_INPUT_RANGE,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedMaxPool_8_ref = {
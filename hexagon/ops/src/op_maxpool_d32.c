@@ -838,6 +838,21 @@ int do_maxpool_out1x1_slice(
 }
 
 
+//
+// Scratch for the largest output the output defs allow: the rolling buffers (one
+// per thread), which are window_height+1 rows, or up to about 32K when that fits.
+//
+static int maxpool_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *window_tensor = self->inputs[3];
+	uint32_t row_bytes = 128 * ((self->output_defs[0].max_sizes[2] + 3) >> 2);
+	uint64_t rows_bytes = (uint64_t)(window_tensor->shape.height + 2) * row_bytes;
+	uint64_t total = max_u64( rows_bytes, 32*1024 + 2*row_bytes) * MAXPOOL_MAX_THREADS;
+	if( total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 static int maxpool_dtor(struct nn_node *self, struct nn_graph *nn)
 {
 	self->opaque = NULL;
@@ -859,6 +874,7 @@ struct nn_node_ops nn_ops_for_QuantizedMaxPool_8_d32 = {
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT | NN_NODE_FLAG_OUTPUT_ACCEPTS_PREPARATION | NN_NODE_FLAG_OUTPUT_USES_INPUT_RANGE,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = maxpool_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedMaxPool_8_d32_ref = {
@@ -869,5 +885,6 @@ struct nn_node_ops nn_ops_for_QuantizedMaxPool_8_d32_ref = {
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT | NN_NODE_FLAG_OUTPUT_ACCEPTS_PREPARATION | NN_NODE_FLAG_OUTPUT_USES_INPUT_RANGE,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
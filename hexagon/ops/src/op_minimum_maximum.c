@@ -385,6 +385,7 @@ struct nn_node_ops nn_ops_for_QuantizedMinimum_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT_RANGE(6, 8),
     .n_outputs = NN_IOCOUNT(3),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedMaximum_8 = {
@@ -394,4 +395,5 @@ struct nn_node_ops nn_ops_for_QuantizedMaximum_8 = {
     .dtor = node_free_common,
     .n_inputs = NN_IOCOUNT_RANGE(6, 8),
     .n_outputs = NN_IOCOUNT(3),
+    .scratch_hint = nn_check_prepare_hvx_opt_scratch_hint,
 };
@@ -136,6 +136,7 @@ struct nn_node_ops nn_ops_for_Minimum_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_Maximum_f = {
@@ -145,6 +146,7 @@ struct nn_node_ops nn_ops_for_Maximum_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 #define CREATE_REF_OP_MIN_MAX(NAME, OPNAME, OPERATOR)                                      \
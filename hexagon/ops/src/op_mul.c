@@ -471,22 +471,26 @@ static int mul_8x8to8_execute(struct nn_node *self, struct nn_graph *nn)
 	return 0;
 }
 
+// if 8x8to8 mul, we need scratch for 2x the max output
+static int mul_q8_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	// find max output size.
+	struct output const *od0 = &self->output_defs[0];
+	unsigned nmax = mulu32_x4_sat( od0->max_sizes[0], od0->max_sizes[1], od0->max_sizes[2], od0->max_sizes[3]);
+	if( nmax ==0 || nmax > (1u<<25)) return -1;
+	*bytes = nmax * sizeof(uint16_t);
+	return 0;
+}
+
 static int mul_q8_check(struct nn_node *self, struct nn_graph *nn)
 {
+	uint32_t bytes;
 	logmsg(nn,2,"mul node %p",self);
 
-	// if 8x8to8 mul, we need scratch for 2x the max output
-    ///if( self->node_type == OP_QuantizedMul_8x8to8 || self->node_type == OP_QuantizedMul_8x8to8_ref){
-	if(1){
-		// find max output size.
-		struct output const *od0 = &self->output_defs[0];
-		unsigned nmax = mulu32_x4_sat( od0->max_sizes[0], od0->max_sizes[1], od0->max_sizes[2], od0->max_sizes[3]);
-		if( nmax ==0 || nmax > (1u<<25))
-			return errlog(nn,"can't get plausible max output size for mul output");
-		if( nn_scratch_grow(nn, nmax * sizeof(uint16_t)) != 0 ){
-			return errlog(nn, "can't get %u*2 scratch", nmax);
-		}
-
+	if( mul_q8_scratch_hint(self, nn, &bytes) != 0)
+		return errlog(nn,"can't get plausible max output size for mul output");
+	if( nn_scratch_grow(nn, bytes) != 0 ){
+		return errlog(nn, "can't get %u scratch", bytes);
 	}
 	logmsg(nn,2,"mul %p check OK",self);
 	return 0;
@@ -499,6 +503,7 @@ struct nn_node_ops nn_ops_for_Mul_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 #if 0
@@ -529,6 +534,7 @@ struct nn_node_ops nn_ops_for_QuantizedMul_8x8to8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = mul_q8_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_QuantizedMul_8x8to8_ref = {
 	.execute = mul_8x8to8_execute,
@@ -537,4 +543,5 @@ struct nn_node_ops nn_ops_for_QuantizedMul_8x8to8_ref = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(6),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = mul_q8_scratch_hint,
 };
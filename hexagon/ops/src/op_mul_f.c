@@ -66,5 +66,6 @@ struct nn_node_ops nn_ops_for_Mul_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
@@ -36,6 +36,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <quantize.h>
+#include "nn_nms.h"
 
 /*
  * Mobilenet ssd multi-class non max supression
@@ -74,54 +76,7 @@ void new_box(struct Box* box_pointer, const float y1, const float x1, const floa
     box_pointer->area = (x2 - x1) * (y2 - y1);
 }
 
-struct BoxRecord {
-    float score;
-    uint32_t class;
-    uint32_t box;   //box index in input
-};
-
-void new_boxRecord(struct BoxRecord* boxrecord_pointer, const uint32_t box, const float score, const uint32_t class) {
-    boxrecord_pointer->box = box; //box index in input
-    boxrecord_pointer->score = score;
-    boxrecord_pointer->class = class;
-}
-
-struct BoxRecordRef {
-    float score;
-    size_t boxRecord_idx;
-};
-
-void new_boxRecordRef(struct BoxRecordRef* boxRecordIdx_pointer, const float score, const uint32_t idx) {
-    boxRecordIdx_pointer->score = score;
-    boxRecordIdx_pointer->boxRecord_idx = idx;
-}
-
-int compare_box_records(const void* br1,const void* br2) {
-
-    float diff = ((struct BoxRecord*)br1)->score - ((struct BoxRecord*)br2)->score;
-    if (diff > 0) {
-        return -1;
-    }
-    if (diff < 0) {
-        return 1;
-    }
-    return 0;
-}
-
-int compare_box_records_ref(const void* br1,const void* br2) {
-    float diff = ((struct BoxRecordRef*)br1)->score - ((struct BoxRecordRef*)br2)->score;
-    if (diff > 0) return -1;
-    if (diff < 0) return 1;
-    return 0;
-}
-
-float calculateIntersection(const struct Box b1, const struct Box b2) {
-    float intersect_width = fmaxf(0.0, fminf(b1.x2, b2.x2) - fmaxf(b1.x1, b2.x1));
-    float intersect_height = fmaxf(0.0, fminf(b1.y2, b2.y2) - fmaxf(b1.y1, b2.y1));
-    float intersection = intersect_width * intersect_height;
-    float areaUnion = b1.area + b2.area - intersection;
-    return intersection/areaUnion;
-}
+// A candidate (nn_nms_cand) index encodes box and class as box * num_classes + class
 
 static int multiclassnms_execute(struct nn_node *self, struct nn_graph *nn) {
 
@@ -176,46 +131,54 @@ static int multiclassnms_execute(struct nn_node *self, struct nn_graph *nn) {
     size_t output_boxes_tensor_offset = 0;
     size_t output_scores_tensor_offset = 0;
     size_t output_classes_tensor_offset = 0;
-    size_t hash_boxes_per_class_offset = 1 + max_detection_per_class;                            //Size of each node in the filtered boxes hash table; 1 represents the number of boxes per class
+
+    //Each class keeps at most max_detection_per_class boxes (no limit if < 0)
+    const int32_t keep_per_class = (max_detection_per_class >= 0) ? max_detection_per_class : input_boxes_count;
 
     //Array size is in byte
-    size_t boxes_array_size = batch_count * input_boxes_count * sizeof(struct Box);
-    size_t boxes_records_array_size = batch_count * input_boxes_count * input_scores_classes_count * sizeof(struct BoxRecord);
-    size_t boxes_records_ref_array_size = batch_count * input_boxes_count * input_scores_classes_count * sizeof(struct BoxRecordRef);
-    size_t filtered_boxes_hashtable_size = (1 + max_detection_per_class) * input_scores_classes_count * sizeof(uint32_t);  //(number of filtered boxes per class + max number of boxes per class)*max number of classes
-    size_t total_size = boxes_array_size + boxes_records_array_size + boxes_records_ref_array_size + filtered_boxes_hashtable_size;
+    size_t boxes_array_size = input_boxes_count * sizeof(struct Box);
+    size_t cands_array_size = input_boxes_count * input_scores_classes_count * sizeof(struct nn_nms_cand);
+    size_t keepsets_array_size = input_scores_classes_count * sizeof(struct nn_nms_keepset);
+    size_t keepsets_mem_size = input_scores_classes_count * nn_nms_keepset_bytes(keep_per_class);
+    size_t total_size = boxes_array_size + cands_array_size + keepsets_array_size + keepsets_mem_size + 4 * 128;
 
+    nn_scratch_reset(nn);
     if(nn_scratch_grow(nn,total_size)){
         return errlog(nn,"failed to get scratch \n");
     }
 
     //Assign memory
-    uint8_t *head_temp_mem = nn->scratch;
-    struct Box *boxes = (struct Box *)head_temp_mem;
-    struct BoxRecord *box_records = (struct BoxRecord *)((uint8_t *)boxes + boxes_array_size);
-    struct BoxRecordRef *box_records_ref = (struct BoxRecordRef *)((uint8_t *)box_records + boxes_records_array_size);
-    uint32_t *filtered_boxes_hashtable = (uint32_t*)((uint8_t *)box_records_ref + boxes_records_ref_array_size);
-
-    size_t box_idx = 0;                                                                          //box array tail index, pointing to the last element
-    size_t box_record_idx = 0;                                                                   //box record array tail index
-    size_t filtered_boxes_count = 0;
+    struct Box *boxes = nn_scratch_alloc(nn, boxes_array_size);
+    struct nn_nms_cand *cands = nn_scratch_alloc(nn, cands_array_size);
+    struct nn_nms_keepset *keepsets = nn_scratch_alloc(nn, keepsets_array_size);
+    float *keepsets_mem = nn_scratch_alloc(nn, keepsets_mem_size);
+    if (boxes == NULL || cands == NULL || keepsets == NULL || keepsets_mem == NULL){
+        return errlog(nn,"failed to get scratch \n");
+    }
+
+    // boxes are (y1,x1,y2,x2); the overlap doesn't care which axis is which
+    const struct nn_nms_params params = {
+        .iou_threshold = iou_threshold,
+        .coord_offset = 0.0f,
+        .suppress_at_equal = 0,
+        .disjoint_is_zero = 0,
+    };
+
     for (size_t batch = 0; batch < batch_count; ++batch) {
 
-        box_idx = 0;
-        box_record_idx = 0;
-        filtered_boxes_count = 0;
+        size_t num_cands = 0;
+        size_t filtered_boxes_count = 0;
         input_boxes_tensor_offset = batch * coordiates_per_batch;                                //Image index * memory chunk for one image in float*
+        input_boxes_tensor_batch = input_boxes_tensor_data + input_boxes_tensor_offset;
 
         //Validate boxes
         for (size_t i = 0; i < input_boxes_count; ++i) {
-            input_boxes_tensor_batch = input_boxes_tensor_data + input_boxes_tensor_offset;
             //keep the coordinates that are in the range of [0,1]
             float y1 = fminf(fmaxf(input_boxes_tensor_batch[i * NUM_COORD + 0], 0.0), 1.0);
             float x1 = fminf(fmaxf(input_boxes_tensor_batch[i * NUM_COORD + 1], 0.0), 1.0);
             float y2 = fminf(fmaxf(input_boxes_tensor_batch[i * NUM_COORD + 2], 0.0), 1.0);
             float x2 = fminf(fmaxf(input_boxes_tensor_batch[i * NUM_COORD + 3], 0.0), 1.0);
-            new_box(&boxes[box_idx], y1, x1, y2, x2);
-            ++box_idx;
+            new_box(&boxes[i], y1, x1, y2, x2);
         }//end traverse of boxes
 
         //Find valid scores
@@ -229,78 +192,56 @@ static int multiclassnms_execute(struct nn_node *self, struct nn_graph *nn) {
             for (int32_t j = 0; j < input_scores_classes_count; ++j) {                          //j: class index
                 if (box_scores_tensor[j] < score_threshold)
                     continue;
-
-                new_boxRecord(&box_records[box_record_idx], i, box_scores_tensor[j], (uint32_t)j);
-                new_boxRecordRef(&box_records_ref[box_record_idx],box_scores_tensor[j], box_record_idx);
-                ++box_record_idx;
+                cands[num_cands].score = box_scores_tensor[j];
+                cands[num_cands].idx = i * input_scores_classes_count + j;
+                ++num_cands;
             }//end traverse of scores of each box
         }//end traverse of boxes
 
-        //sort box records in descending order
-        qsort(box_records_ref,box_record_idx, sizeof(struct BoxRecordRef), compare_box_records_ref);
+        for (int32_t j = 0; j < input_scores_classes_count; ++j) {
+            nn_nms_keepset_init(&keepsets[j], keepsets_mem + j * 5 * keep_per_class, keep_per_class);
+        }
 
         //output
         output_boxes_tensor_offset = batch * output_max_coords_per_batch;
         output_scores_tensor_offset = batch * max_total_detections;
         output_classes_tensor_offset = batch * max_total_detections;
 
-        //temp variables
-        uint32_t current_class = 0;
-        struct Box *currentBox = NULL;
-        size_t hashtable_offset = 0;
-        size_t  num_boxes_current_class = 0;
-        float iou = 0.0;
-        size_t hashtable_length = 0;
-        bool should_keep = true;
-        int32_t temp_box_record_idx = 0;
-
-        memset(filtered_boxes_hashtable, 0, filtered_boxes_hashtable_size);                    //Reset the hash table
-
-        //Traverse the box record array. Keep the boxes that have little overlap area.
-        //Use a hash table. The key is the class, the values are the box indices in the class.
-        for(int32_t k = 0; k < box_record_idx; ++k) {
+        //Visit the candidates in descending score order (sorting only as many as are visited),
+        //and keep the boxes that have little overlap with the ones already kept in the same class.
+        struct nn_nms_iter iter;
+        struct nn_nms_cand *cand;
+        nn_nms_iter_init(&iter, cands, num_cands, max_i32(4 * max_total_detections, 64));
+        while ((cand = nn_nms_iter_next(&iter)) != NULL) {
 
             if(filtered_boxes_count == max_total_detections)
                 break;
 
-            temp_box_record_idx = box_records_ref[k].boxRecord_idx;
-            current_class = box_records[temp_box_record_idx].class;
-            hashtable_offset = current_class * hash_boxes_per_class_offset;
-            num_boxes_current_class = filtered_boxes_hashtable[hashtable_offset];
+            uint32_t current_class = cand->idx % input_scores_classes_count;
+            uint32_t current_box = cand->idx / input_scores_classes_count;
+            struct nn_nms_keepset *keepset = &keepsets[current_class];
 
-            if(num_boxes_current_class == max_detection_per_class)
+            if(keepset->n == keepset->cap)
                 continue;
 
-            currentBox = &boxes[box_records[temp_box_record_idx].box];
-            should_keep = true;
+            struct Box *currentBox = &boxes[current_box];
 
             //Check with the boxes in the same class, discard if the overlap is too big
-            for(int32_t  m = 0; m < num_boxes_current_class; ++m) {
-
-                iou = calculateIntersection(boxes[filtered_boxes_hashtable[hashtable_offset+1+m]], *currentBox);
-
-                if(iou > iou_threshold) {
-                    should_keep = false;
-                    break;
-                }
-            }//end traverse of boxes in the same class
-
-            if(should_keep){
+            if (nn_nms_keepset_overlaps(keepset, &params, iou_threshold,
+                                        currentBox->y1, currentBox->x1, currentBox->y2, currentBox->x2, currentBox->area))
+                continue;
 
-                filtered_boxes_hashtable[hashtable_offset + 1 + num_boxes_current_class] = box_records[temp_box_record_idx].box;     //Add box index at the back
-                filtered_boxes_hashtable[hashtable_offset]++;                                                                        //Increase the number of boxes in the class
+            nn_nms_keepset_add(keepset, currentBox->y1, currentBox->x1, currentBox->y2, currentBox->x2, currentBox->area);
 
-                output_boxes_tensor_data[output_boxes_tensor_offset + hashtable_length * NUM_COORD] = currentBox->y1;
-                output_boxes_tensor_data[output_boxes_tensor_offset + hashtable_length * NUM_COORD + 1] = currentBox->x1;
-                output_boxes_tensor_data[output_boxes_tensor_offset + hashtable_length * NUM_COORD + 2] = currentBox->y2;
-                output_boxes_tensor_data[output_boxes_tensor_offset + hashtable_length * NUM_COORD + 3] = currentBox->x2;
-                output_scores_tensor_data[output_scores_tensor_offset + hashtable_length] = box_records[temp_box_record_idx].score;
-                output_classes_tensor_data[output_classes_tensor_offset + hashtable_length] = (float)box_records[temp_box_record_idx].class;
+            output_boxes_tensor_data[output_boxes_tensor_offset + filtered_boxes_count * NUM_COORD] = currentBox->y1;
+            output_boxes_tensor_data[output_boxes_tensor_offset + filtered_boxes_count * NUM_COORD + 1] = currentBox->x1;
+            output_boxes_tensor_data[output_boxes_tensor_offset + filtered_boxes_count * NUM_COORD + 2] = currentBox->y2;
+            output_boxes_tensor_data[output_boxes_tensor_offset + filtered_boxes_count * NUM_COORD + 3] = currentBox->x2;
+            output_scores_tensor_data[output_scores_tensor_offset + filtered_boxes_count] = cand->score;
+            output_classes_tensor_data[output_classes_tensor_offset + filtered_boxes_count] = (float)current_class;
 
-                ++filtered_boxes_count;
-                ++hashtable_length;
-            }
-        }//end traverse of box records
+            ++filtered_boxes_count;
+        }//end traverse of candidates
 
         int32_t num_unused_units = max_total_detections - filtered_boxes_count;
 
@@ -319,6 +260,30 @@ static int multiclassnms_execute(struct nn_node *self, struct nn_graph *nn) {
 }
 
 
+// the same arrays as multiclassnms_execute, for the most boxes and classes the
+// inputs can have; max_detection_per_class must be Const.
+static int multiclassnms_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes) {
+    const struct input *boxes_ref = &self->input_refs[INPUT_BOXES_IDX];
+    const struct input *scores_ref = &self->input_refs[INPUT_CLASS_SCORES_IDX];
+    struct nn_node *boxes_src = find_node(nn, boxes_ref->src_id);
+    struct nn_node *scores_src = find_node(nn, scores_ref->src_id);
+    struct nn_node *per_class_src = find_node_must_be_Const_from_ref(nn, &self->input_refs[INPUT_MAX_DETECTION_PER_CLASS]);
+    if (boxes_src == NULL || scores_src == NULL || per_class_src == NULL) return -1;
+    if (per_class_src->outputs[0]->data_size < sizeof(int32_t)) return -1;
+
+    const uint32_t input_boxes_count = boxes_src->output_defs[boxes_ref->output_idx].max_sizes[2];
+    const uint32_t input_scores_classes_count = scores_src->output_defs[scores_ref->output_idx].max_sizes[3];
+    const int32_t max_detection_per_class = tensor_get_int32(per_class_src->outputs[0], 0);
+    const int32_t keep_per_class = (max_detection_per_class >= 0) ? max_detection_per_class : input_boxes_count;
+
+    size_t boxes_array_size = input_boxes_count * sizeof(struct Box);
+    size_t cands_array_size = input_boxes_count * input_scores_classes_count * sizeof(struct nn_nms_cand);
+    size_t keepsets_array_size = input_scores_classes_count * sizeof(struct nn_nms_keepset);
+    size_t keepsets_mem_size = input_scores_classes_count * nn_nms_keepset_bytes(keep_per_class);
+    *bytes = boxes_array_size + cands_array_size + keepsets_array_size + keepsets_mem_size + 4 * 128;
+    return 0;
+}
+
 struct nn_node_ops nn_ops_for_MultiClassNms_f = {
 	.execute = multiclassnms_execute,
 	.check = NULL,
@@ -326,5 +291,6 @@ struct nn_node_ops nn_ops_for_MultiClassNms_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(OP_MULTICLASSNMS_INPUT_NUM),
 	.n_outputs = NN_IOCOUNT(OP_MULTICLASSNMS_OUTPUT_NUM),
+	.scratch_hint = multiclassnms_scratch_hint,
 };
 
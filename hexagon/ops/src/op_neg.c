@@ -195,7 +195,8 @@ struct nn_node_ops nn_ops_for_Neg_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(1),
 	.n_outputs = NN_IOCOUNT(1),
-	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.scratch_hint = nn_scratch_hint_none,
 };
 struct nn_node_ops nn_ops_for_Neg_int32 = {
 	.execute = unary_op_execute,
@@ -213,7 +214,8 @@ struct nn_node_ops nn_ops_for_Abs_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(1),
 	.n_outputs = NN_IOCOUNT(1),
-	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.scratch_hint = nn_scratch_hint_none,
 };
 struct nn_node_ops nn_ops_for_Abs_int32 = {
 	.execute = unary_op_execute,
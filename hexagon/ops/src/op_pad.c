@@ -74,6 +74,7 @@ struct tdata_pad {
 	int    pad_d_after;
 	int    element_size;
 	int    padval;
+	struct nn_memcpy_manager *mcman;	// copies are queued here
 	nn_sem_t donesem;
 };
 struct tdata_pad_batch {
@@ -85,6 +86,7 @@ struct tdata_pad_batch {
 	int    pad_b_after;
 	int    padval;
 	int    element_size;
+	struct nn_memcpy_manager *mcman;	// fills are queued here
 	nn_sem_t donesem;
 };
 
@@ -101,18 +103,16 @@ static void do_pad_batch(struct nn_graph *nn, void *vinfo){
 	int32_t pad_before_size =  pad_b_before * non_batch_outsize;
 	int32_t pad_after_size =  pad_b_after * non_batch_outsize;
 
-	struct nn_memcpy_manager  mcman;
+	struct nn_memcpy_manager *mcman = tdb->mcman;
 	if( element_size==1) padval = Q6_R_vsplatb_R(padval);
 	else if ( element_size == 2) padval = Q6_R_combine_RlRl(padval,padval);
-	nn_mcmanager_init(nn, &mcman );
 	if(pad_b_before){
-		nn_mcmanager_vmemset32(nn, &mcman,  out, padval,pad_before_size);
+		nn_mcmanager_vmemset32(nn, mcman,  out, padval,pad_before_size);
 	}
 	if(pad_b_after){
 		out += pad_before_size+(b_in)*non_batch_outsize;
-		nn_mcmanager_vmemset32(nn, &mcman,  out, padval,pad_after_size);
+		nn_mcmanager_vmemset32(nn, mcman,  out, padval,pad_after_size);
 	}
-	nn_mcmanager_wait( nn, &mcman );
 
 }
 
@@ -170,13 +170,11 @@ static inline void do_pad_edge_hvx(
 	else if ( element_size == 2) padval = Q6_R_combine_RlRl(padval,padval);
 
 
-	struct nn_memcpy_manager  mcman;
-	nn_mcmanager_init(nn, &mcman );
-	// !! Do not return from this function without doing nn_mcmanager_wait( nn, &mcman ); !!
+	struct nn_memcpy_manager *mcman = td->mcman;	// the caller waits (or defers)
 
 	// top
 	if( pre_h_size > 0){
-		nn_mcmanager_vmemset32_2d(nn, &mcman,  out, padval, pre_h_size, 1, 0);	// 'single row' fill
+		nn_mcmanager_vmemset32_2d(nn, mcman,  out, padval, pre_h_size, 1, 0);	// 'single row' fill
 		out += pre_h_size;
 	}
 
@@ -213,18 +211,18 @@ static inline void do_pad_edge_hvx(
 		}
 		// 2d memset the left side
 		if( pre_wid> 0 ){
-			nn_mcmanager_vmemset32_2d(nn, &mcman,  out1, padval, pre_wid, rows, outstride );
+			nn_mcmanager_vmemset32_2d(nn, mcman,  out1, padval, pre_wid, rows, outstride );
 			out1 += pre_wid;
 		}
 		// 2d copy the middle
-		nn_mcmanager_vmemcpy_2d( nn, &mcman,
+		nn_mcmanager_vmemcpy_2d( nn, mcman,
 				copywid, rows,		// width, height
 				out1,   outstride,				// outp, out_stride
 				in, instride );						// inp, in_stride
 		out1 += copywid;
 
 		if( post_wid > 0){
-			nn_mcmanager_vmemset32_2d(nn, &mcman,  out1, padval, post_wid, rows, outstride );
+			nn_mcmanager_vmemset32_2d(nn, mcman,  out1, padval, post_wid, rows, outstride );
 		}
 
 	} else {
@@ -232,38 +230,34 @@ static inline void do_pad_edge_hvx(
 		int in_w_size =  in_d_size * w_in;
 		char * out1 = out;
 		if(pre_w_size){
-			nn_mcmanager_vmemset32_2d(nn, &mcman, out1, padval,pre_w_size, h_in, out_width_size );
+			nn_mcmanager_vmemset32_2d(nn, mcman, out1, padval,pre_w_size, h_in, out_width_size );
 			out1 += pre_w_size;
 		}
-		// loop over h, doing memsets for the depth padding
-		for( int h = 0; h < h_in; h++){
-			char * out2 = out1 + out_width_size * h;		// posn in row, after width padding
-			char const * in2 = in + in_w_size*h;
-			if( pre_d_size > 0){
-				nn_mcmanager_vmemset32_2d(nn, &mcman,  out2, padval, pre_d_size, w_in, out_depth_size);
-				out2 += pre_d_size;
-			}
-			// 2d copy the middle
-			nn_mcmanager_vmemcpy_2d( nn, &mcman,
-					in_d_size, w_in,		// width, height
-					out2,  out_depth_size,				// outp, out_stride
-					in2, in_d_size );						// inp, in_stride
-			out2 += in_d_size;
-			if( post_d_size >  0)
-				nn_mcmanager_vmemset32_2d(nn, &mcman,  out2, padval, post_d_size, w_in, out_depth_size);
+		// h_in planes of w_in rows, for the depth padding and the middle
+		char * out2 = out1;		// posn in row, after width padding
+		if( pre_d_size > 0){
+			nn_mcmanager_vmemset32_3d(nn, mcman,  out2, padval, pre_d_size, w_in, h_in, out_depth_size, out_width_size);
+			out2 += pre_d_size;
 		}
+		// 3d copy the middle
+		nn_mcmanager_vmemcpy_3d( nn, mcman,
+				in_d_size, w_in, h_in,		// width, height, depth
+				out2,  out_depth_size, out_width_size,		// outp, out_stride, out plane stride
+				in, in_d_size, in_w_size );				// inp, in_stride, in plane stride
+		out2 += in_d_size;
+		if( post_d_size >  0)
+			nn_mcmanager_vmemset32_3d(nn, mcman,  out2, padval, post_d_size, w_in, h_in, out_depth_size, out_width_size);
 		if(post_w_size){
 			out1 += out_depth_size*w_in;
-			nn_mcmanager_vmemset32_2d(nn, &mcman, out1, padval,post_w_size, h_in, out_width_size );
+			nn_mcmanager_vmemset32_2d(nn, mcman, out1, padval,post_w_size, h_in, out_width_size );
 		}
 	}
 	out += h_in * out_width_size;		// skip all the core rows
 
 	// bottom
 	if( post_h_size > 0){
-		nn_mcmanager_vmemset32_2d(nn, &mcman,  out, padval, post_h_size, 1, 0);	// 'single row' fill
+		nn_mcmanager_vmemset32_2d(nn, mcman,  out, padval, post_h_size, 1, 0);	// 'single row' fill
 	}
-	nn_mcmanager_wait( nn, &mcman );
 	//nn_sem_post(&td->donesem);
 
 }
@@ -361,6 +355,9 @@ static int pad_generic_execute(struct nn_node *self,
 
 	if(hvx_flag)
 	{
+		// the copies are left running when we return; see nn_copyeng_defer
+		struct nn_memcpy_manager mcman;
+		nn_mcmanager_init(nn, &mcman );
 		//pad batches
 		if (pad_b_before || pad_b_after){
 			struct tdata_pad_batch tdb;
@@ -372,6 +369,7 @@ static int pad_generic_execute(struct nn_node *self,
 			tdb.pad_b_after = pad_b_after;
 			tdb.padval = padval;
 			tdb.element_size = element_size;
+			tdb.mcman = &mcman;
 
 			do_pad_batch(nn,&tdb);
 		}
@@ -396,6 +394,7 @@ static int pad_generic_execute(struct nn_node *self,
 		    td.pad_d_after  = pad_d_after;
 		    td.padval       = padval;
 		    td.element_size = element_size;
+		    td.mcman = &mcman;
 
 
 		    if(bytes < 32*1024)
@@ -410,6 +409,7 @@ static int pad_generic_execute(struct nn_node *self,
 		    //nn_os_work_for_vector(nn,do_pad_edge_hvx, &td);
 		    //nn_sem_wait(&td.donesem);
 		}
+		nn_mcmanager_defer( nn, &mcman, self );
 	} else {
 		if (pad_b_before || pad_b_after) return errlog(nn,"can't pad batches in scalar");
 		do_pad( out_base,
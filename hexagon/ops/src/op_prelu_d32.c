@@ -48,6 +48,14 @@
 
 #define NEW_PRELU_D32
 
+// the scaled alphas go in scratch: two vectors per d32 slice
+static int prelu_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	int32_t alpha_depth_roundup = (self->inputs[3]->shape.depth + 31) & ~31;
+	*bytes = alpha_depth_roundup*4*2;
+	return 0;
+}
+
 #ifdef NEW_PRELU_D32		// new implementation
 #include "hvx_inlines.h"
 #define MAX_THREADS 2
@@ -456,7 +464,9 @@ static int prelu_check_opt(struct nn_node *self, struct nn_graph *nn)
 	} else {
 		alpha_frac_buf = nodeinfo->alphabuf;
 	}
-	if( nn_scratch_grow(nn,alpha_depth_roundup*4*2)){
+	uint32_t scratch_bytes;
+	prelu_scratch_hint(self,nn,&scratch_bytes);
+	if( nn_scratch_grow(nn,scratch_bytes)){
 		return errlog(nn,"scratch alloc");
 	}
 	/*
@@ -859,6 +869,7 @@ struct nn_node_ops nn_ops_for_QuantizedPRelu_8_d32 = {
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT,
 	.n_inputs = NN_IOCOUNT(4),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = prelu_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedPRelu_8_d32_ref = {
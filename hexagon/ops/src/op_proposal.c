@@ -39,87 +39,13 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "nn_nms.h"
 
-#define MIN(A,B) (A < B ? A : B)
 #define ALIGN_SIZE 128
 #define ROUNDUP(X) (((X) + ALIGN_SIZE - 1) & (~((ALIGN_SIZE)-1)))
 
-struct confidence_order_t{
-    float confidence;
-    int order;
-};
-
 #define DATA_PER_ROI 5
-int compare_confidence(const void* v1,const void* v2){
-    float c1 = ((struct confidence_order_t*) v1)->confidence;
-    float c2 = ((struct confidence_order_t*) v2)->confidence;
-    float diff = c1 - c2;
-    if (diff > 0) return -1;
-    if (diff < 0) return 1;
-    return 0;
-}
-
-static inline void
-non_max_suppression(float* output_boxes,float* output_scores,
-                    int32_t* num_output_boxes,
-                    float *pred_boxes,
-                    int32_t num_pred_boxes,
-                    int32_t num_roi,
-                    float threshold,
-                    struct confidence_order_t *ordered_idx,
-                    uint8_t *suppressed,
-                    float *bbox_area){
-    for (int32_t idx_i = 0; idx_i < num_pred_boxes; ++idx_i){
-        int32_t pred_idx = 4 * ordered_idx[idx_i].order;
-        bbox_area[idx_i] = (pred_boxes[pred_idx + 2] - pred_boxes[pred_idx] + 1.0f) *
-                            (pred_boxes[pred_idx + 3] - pred_boxes[pred_idx + 1] + 1.0f);
-    }
-
-    for (int32_t idx_i = 0; idx_i < num_pred_boxes; ++idx_i){
-        int32_t pred_idx = 4 * ordered_idx[idx_i].order;
-
-        if (suppressed[idx_i]){
-            continue;
-        }
-        *output_boxes=0;//batch id set to 0 to prevent garbage values;
-        memcpy(output_boxes+1, pred_boxes + (pred_idx), 4 * sizeof(float));
-        *output_scores = ordered_idx[idx_i].confidence;
-        (*num_output_boxes)++;
-        if (*num_output_boxes >= num_roi) {
-            return; // collected enough bboxes
-        }
-        output_boxes += DATA_PER_ROI; // depth dim: 5, i.e., [batch id (dont care), x1, y1, x2, y2]
-        output_scores++;
-
-        float s1 = bbox_area[idx_i];
-        float ix1 = pred_boxes[pred_idx];
-        float iy1 = pred_boxes[pred_idx + 1];
-        float ix2 = pred_boxes[pred_idx + 2];
-        float iy2 = pred_boxes[pred_idx + 3];
-        for (int32_t idx_j = idx_i + 1; idx_j < num_pred_boxes; ++idx_j){
-            int32_t pred_idx2 = 4 * ordered_idx[idx_j].order;
-
-            if (suppressed[idx_j]){
-                continue;
-            }
-
-            float s2 = bbox_area[idx_j];
-
-            float x1 = fmaxf(ix1, pred_boxes[pred_idx2]);
-            float y1 = fmaxf(iy1, pred_boxes[pred_idx2 + 1]);
-            float x2 = fminf(ix2, pred_boxes[pred_idx2 + 2]);
-            float y2 = fminf(iy2, pred_boxes[pred_idx2 + 3]);
-
-            float width = fmaxf(x2 - x1 + 1.0f, 0.0f);
-            float height = fmaxf(y2 - y1 + 1.0f, 0.0f);
-            float inter = width * height;
-            float IOU = inter / (s1 + s2 - inter);
-            if (IOU >= threshold){
-                suppressed[idx_j] = 1;
-            }
-        }
-    }
-}
+#define DATA_PER_PROPOSAL 5 // x1, y1, x2, y2, area
 
 #define CLS_IDX 0
 #define BBOX_IDX 1
@@ -199,22 +125,23 @@ static int proposal_execute_f(struct nn_node *self, struct nn_graph *nn){
         return errlog(nn,"number of channels in bbox does not match the number of anchors in each cell.");
     }
 
-    size_t proposals_size = anchor_num * cls_h * cls_w * 4 * sizeof(float);
-    size_t scores_size = anchor_num * cls_h * cls_w * sizeof(float);
-    size_t confidence_order_size = anchor_num * cls_h * cls_w   * sizeof(struct confidence_order_t);
-    size_t suppressed_size = max_num_proposals * sizeof(uint8_t);
-    size_t bbox_area_size = max_num_proposals * sizeof(float);
-    size_t total_size = proposals_size + scores_size + confidence_order_size + suppressed_size + bbox_area_size;
+    size_t num_anchors_total = anchor_num * cls_h * cls_w;
+    size_t proposals_size = num_anchors_total * DATA_PER_PROPOSAL * sizeof(float);
+    size_t cands_size = num_anchors_total * sizeof(struct nn_nms_cand);
+    size_t keepset_size = (max_num_roi > 0) ? nn_nms_keepset_bytes(max_num_roi) : 0;
+    size_t total_size = ROUNDUP(proposals_size) + ROUNDUP(cands_size) + ROUNDUP(keepset_size);
 
+    nn_scratch_reset(nn);
     if(nn_scratch_grow(nn,total_size)){
         return errlog(nn,"failed to get scratch");
     }
 
-    float *proposals = nn->scratch ;
-    float *scores = (float *) (proposals+ proposals_size);
-    struct confidence_order_t *confidence_order_ptr = (struct confidence_order_t *)(scores+ scores_size);
-    uint8_t *suppressed = (uint8_t *)(confidence_order_ptr+ confidence_order_size);
-    float *bbox_area = (float *) (suppressed+suppressed_size);
+    float *proposals = nn_scratch_alloc(nn, proposals_size);
+    struct nn_nms_cand *cands = nn_scratch_alloc(nn, cands_size);
+    float *keepset_mem = nn_scratch_alloc(nn, keepset_size);
+    if (proposals == NULL || cands == NULL || keepset_mem == NULL){
+        return errlog(nn,"failed to get scratch");
+    }
 
     float img_height = tensor_get_float(im_info_tensor,0);
     float img_width = tensor_get_float(im_info_tensor,1);
@@ -223,7 +150,6 @@ static int proposal_execute_f(struct nn_node *self, struct nn_graph *nn){
 
     float *bbox_deltas_ptr = bbox_deltas;
     float *proposals_ptr = proposals;
-    float *scores_ptr = scores;
     int32_t is_py_faster_rcnn = ((2*anchor_num) == (cls_d)) ? 1 : 0;
     const float* cls_score_foreground = cls_score + (is_py_faster_rcnn ? anchor_num : 0);
     int32_t num_proposals = 0; // keep track the number of proposals collected
@@ -277,8 +203,11 @@ static int proposal_execute_f(struct nn_node *self, struct nn_graph *nn){
                 float ws = proposals_ptr[2] - proposals_ptr[0] + 1.0f;
                 float hs = proposals_ptr[3] - proposals_ptr[1] + 1.0f;
                 if (ws >= scaled_min_size && hs >= scaled_min_size){
-                    *scores_ptr++ = cls_score_foreground[k];
-                    proposals_ptr += 4;
+                    proposals_ptr[4] = (proposals_ptr[2] - proposals_ptr[0] + 1.0f) *
+                                       (proposals_ptr[3] - proposals_ptr[1] + 1.0f);
+                    cands[num_proposals].score = cls_score_foreground[k];
+                    cands[num_proposals].idx = num_proposals;
+                    proposals_ptr += DATA_PER_PROPOSAL;
                     num_proposals++;
                 }
 
@@ -290,24 +219,32 @@ static int proposal_execute_f(struct nn_node *self, struct nn_graph *nn){
         }
     }
 
-    // sort the confidence from high to low and keep track of ordered index
-    for (int o = 0; o < num_proposals; o++){
-        confidence_order_ptr[o].confidence = scores[o];
-        confidence_order_ptr[o].order = o;
-    }
-    l2fetch(confidence_order_ptr,1,num_proposals * sizeof(struct confidence_order_t),1);
-    qsort(confidence_order_ptr,num_proposals, sizeof(struct confidence_order_t), compare_confidence);
+    // NMS over the max_num_proposals highest scoring; only as many are sorted as needed
+    // to collect max_num_roi boxes.
     int32_t num_output_boxes = 0;
-    memset(suppressed,0,suppressed_size);
-    non_max_suppression(sorted_roi_data, sorted_prob_data,
-                        &num_output_boxes,
-                        proposals,
-                        MIN(max_num_proposals, num_proposals),
-                        max_num_roi,
-                        nms_iou_threshold,
-                        confidence_order_ptr,
-                        suppressed,
-                        bbox_area);
+    if (max_num_roi > 0){
+        struct nn_nms_boxes boxes = {
+            .coords = proposals,
+            .area = proposals + 4,
+            .stride = DATA_PER_PROPOSAL,
+        };
+        struct nn_nms_params params = {
+            .iou_threshold = nms_iou_threshold,
+            .coord_offset = 1.0f,
+            .suppress_at_equal = 1,
+            .disjoint_is_zero = 0,
+        };
+        struct nn_nms_keepset keepset;
+        nn_nms_keepset_init(&keepset, keepset_mem, max_num_roi);
+        int32_t num_cands = nn_nms_select(cands, num_proposals, max_num_proposals);
+        num_output_boxes = nn_nms_greedy(cands, num_cands, &boxes, &params, max_num_roi, &keepset);
+        for (int i = 0; i < num_output_boxes; i++){
+            float *output_boxes = sorted_roi_data + i * DATA_PER_ROI;
+            output_boxes[0] = 0; //batch id set to 0 to prevent garbage values;
+            memcpy(output_boxes + 1, proposals + cands[i].idx * DATA_PER_PROPOSAL, 4 * sizeof(float));
+            sorted_prob_data[i] = cands[i].score;
+        }
+    }
 
     //setting remaining spaces to 0;
     for (int i = num_output_boxes; i < max_num_roi; i ++){
@@ -37,6 +37,7 @@
 #include <string.h>
 #include <math.h>
 #include <quantize.h>
+#include <nn_quantize_vec.h>
 #include <hvx_hexagon_protos.h>
 #if defined(__hexagon__)
 #include <hexagon_types.h>
@@ -122,9 +123,6 @@ static int quantize_execute_ref(struct nn_node *self, struct nn_graph *nn)
 	const float *in = in_tensor->data;
 	uint8_t *out = out_tensor->data;
 	int out_bytes = batches*height*width*depth;
-	float inval;
-	int i;
-	int ival;
 	logmsg(nn,2,"quantize execute. self=%p ",self);
 
 	if( tensor_out_prepare_normal( out_tensor, batches,height,width,depth, NN_TYPE_QUINT8)!= 0 ){
@@ -138,11 +136,7 @@ static int quantize_execute_ref(struct nn_node *self, struct nn_graph *nn)
 	if( k!= 0)
 		return errlog(nn,"invalid range for quantize: %f ... %f", min_in, max_in);
 
-	for (i = 0; i < batches*height*width*depth; i++) {
-		inval = in[i];
-		ival = roundf_i32((inval - min_out)*recip_stepsize);
-		out[i] = saturate_u8(ival);
-	}
+	nn_qvec_f32_to_u8(out, in, batches*height*width*depth, min_out, recip_stepsize);
 
 	tensor_set_single_float(out_min_tensor, min_out);
 	tensor_set_single_float(out_max_tensor, max_out);
@@ -706,9 +700,6 @@ static int autoquantize_execute(struct nn_node *self, struct nn_graph *nn)
 	const float *in = (const float *)in_tensor->data;
 	uint8_t *out = (uint8_t *)out_tensor->data;
 	int out_bytes = batches*height*width*depth;
-	float inval;
-	int i;
-	int ival;
 	logmsg(nn,2,"autoquantize execute. self=%p ",self);
 
 	if( tensor_out_prepare_normal( out_tensor,batches,height,width,depth, NN_TYPE_QUINT8)!=0 ){
@@ -729,11 +720,7 @@ static int autoquantize_execute(struct nn_node *self, struct nn_graph *nn)
 		&min_out,&max_out,
 		&stepsize,&recip_stepsize,
 		min_in,max_in);
-	for (i = 0; i < batches*height*width*depth; i++) {
-		inval = in[i];
-		ival = roundf_i32((inval - min_out)*recip_stepsize);
-		out[i] = saturate_u8(ival);
-	}
+	nn_qvec_f32_to_u8(out, in, batches*height*width*depth, min_out, recip_stepsize);
 	tensor_set_single_float(out_min_tensor,min_out);
 	tensor_set_single_float(out_max_tensor,max_out);
 	return 0;
@@ -1413,7 +1400,11 @@ dequantize_hvx_work_func( struct nn_graph *nn, void *rstpv)
 		float *outp = outp0 + pos;
 		unsigned numel = min_u32( chunk, all_numel-pos);
 		l2fetch( inp, 128,128, (numel+127)/128u);
+#if defined(__hexagon__)
 		hvx_do_dequantize( inp, outp, numel, rstp->qzero,rstp->qstep );
+#else
+		nn_qvec_u8_to_f32( outp, inp, numel, rstp->qzero,rstp->qstep );
+#endif
 	}
 	nn_sem_post( &rstp->done_sem);
 }
@@ -232,6 +232,7 @@ struct nn_node_ops nn_ops_for_QuantizedRelu_8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedReluX_8 = {
@@ -241,6 +242,7 @@ struct nn_node_ops nn_ops_for_QuantizedReluX_8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(4),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 
@@ -269,6 +271,7 @@ struct nn_node_ops nn_ops_for_QuantizedClamp_8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedClamp_8_ref = {
@@ -133,6 +133,7 @@ static int clamp_f_execute(struct nn_node *self, struct nn_graph *nn)
 	return res;
 }
 
+// these all work in-place (output element i depends only on input element i)
 
 struct nn_node_ops nn_ops_for_Relu_f = {
 	.execute = relu_execute,
@@ -141,6 +142,8 @@ struct nn_node_ops nn_ops_for_Relu_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(1),
 	.n_outputs = NN_IOCOUNT(1),
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_ReluX_f = {
@@ -150,6 +153,8 @@ struct nn_node_ops nn_ops_for_ReluX_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_Clamp_f = {
@@ -159,4 +164,6 @@ struct nn_node_ops nn_ops_for_Clamp_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(1),
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.scratch_hint = nn_scratch_hint_none,
 };
@@ -43,6 +43,7 @@
 #include <nn_graph.h>
 #include <string.h>
 #include <quantize.h>
+#include <nn_quantize_vec.h>
 #include "hvx_inlines.h"
 
 #ifdef HEXAGON_V66
@@ -695,6 +696,9 @@ static int do_requantize_16_execute(struct nn_node *self, struct nn_graph *nn)
 static void
 scale_32_to_16( int16_t * outp, int32_t const * inp, int num, int32_t gain, int rsh )
 {
+#ifndef __hexagon__
+	nn_qvec_i32_to_i16_q31( outp, inp, num, gain, rsh);	// same result, with host simd
+#else
 	HVX_Vector vgain = Q6_V_vsplat_R( gain );
 	int nv32 = (num+31)/32u;		// # of vecs to read
 	int nv64 = nv32>>1;		// # of full 2->1 operations
@@ -735,6 +739,7 @@ scale_32_to_16( int16_t * outp, int32_t const * inp, int num, int32_t gain, int
 			*voutp =Q6_Vh_vdeal_Vh( Q6_Vh_vasr_VwVwR_rnd_sat( v0,v0, 4));
 		}
 	}
+#endif
 }
 
 
@@ -983,6 +988,7 @@ struct nn_node_ops nn_ops_for_Requantize_32to8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 struct nn_node_ops nn_ops_for_Requantize_32to8_ref = {
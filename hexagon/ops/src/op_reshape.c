@@ -149,7 +149,8 @@ struct nn_node_ops nn_ops_for_Reshape = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
-	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.alias_hint = nn_alias_hint_view_input0,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedReshape = {
@@ -159,6 +160,7 @@ struct nn_node_ops nn_ops_for_QuantizedReshape = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(4),
 	.n_outputs = NN_IOCOUNT(3),
-	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS
+	.flags = NN_NODE_FLAG_CLS_SUPPORTS_ALIAS,
+	.alias_hint = nn_alias_hint_view_input0,
 };
 
@@ -798,50 +798,251 @@ void resizebilinear_hvx(
 }
 
 //==================================================================================
-void resizebilinear_general(
-	const uint8_t  *in,
-	uint8_t        *out,
-	int32_t         h_in,
-	int32_t         w_in,
-	int32_t         d_in,
-	int32_t         h_out,
-	int32_t         w_out,
-	int32_t         h_in_end,
-	struct bilin_runstate *rtsp
-)
+// Table-driven separable bilinear resize, used for float, and for the 8-bit
+// cases which don't have a special hvx path.
+//
+// The source rows/columns and weights depend only on the shapes; they are kept in
+// 'struct bilin_tables', cached on the node, and rebuilt only when a shape changes.
+// Each output row is then done in two passes:
+//   (1) horizontal: each of the two source rows is interpolated along the width
+//       into a float row buffer (w_out*depth); this is skipped when the source row
+//       is already in a buffer (consecutive output rows usually share source rows).
+//   (2) vertical: the two row buffers are blended into the output row; this is a
+//       contiguous loop over w_out*depth.
+// Computation order is the same as bilinear_interpolate(), so results match the
+// original per-element code.
+// The work is split into bands of output rows across threads; each thread gets its
+// row buffers from a buffer pool in scratch.
+//
+struct bilin_tables {
+	int32_t in_height, in_width;
+	int32_t out_height, out_width;
+	int32_t depth;
+	int32_t align_corners;
+	int32_t *yidx;		// [out_height][2]: the two source rows for each output row
+	float *yfrac;		// [out_height]
+	int32_t *xoff;		// [out_width][2]: element offsets (x*depth) of the two source columns
+	float *xfrac;		// [out_width]
+};
+
+// what's kept in self->opaque (for both the float and 8-bit op)
+struct resizebilinear_info {
+	void *hvxplan_mem;		// (unaligned) allocation for struct resizebilinear_plan, or NULL
+	struct bilin_tables *tables;	// or NULL
+};
+
+static struct bilin_tables *
+bilin_tables_get(
+	struct resizebilinear_info *info,
+	int32_t h_in, int32_t w_in, int32_t h_out, int32_t w_out, int32_t depth, int32_t align_corners)
 {
-	int b_in = 1;
+	struct bilin_tables *tp = info->tables;
+	if (tp != NULL) {
+		if (tp->in_height == h_in && tp->in_width == w_in && tp->out_height == h_out
+			&& tp->out_width == w_out && tp->depth == depth && tp->align_corners == align_corners) {
+			return tp;
+		}
+		nn_free(tp);
+		info->tables = NULL;
+	}
+	tp = nn_malloc(sizeof(struct bilin_tables) + (size_t)h_out * 3 * sizeof(int32_t) + (size_t)w_out * 3 * sizeof(int32_t));
+	if (tp == NULL) return NULL;
+	tp->in_height = h_in;
+	tp->in_width = w_in;
+	tp->out_height = h_out;
+	tp->out_width = w_out;
+	tp->depth = depth;
+	tp->align_corners = align_corners;
+	tp->yidx = (int32_t *)(tp + 1);
+	tp->yfrac = (float *)(tp->yidx + 2 * h_out);
+	tp->xoff = (int32_t *)(tp->yfrac + h_out);
+	tp->xfrac = (float *)(tp->xoff + 2 * w_out);
+
 	float xscale, yscale;
-	if (!rtsp->align_corners) {
+	if (!align_corners) {
 		xscale = (float)w_in / w_out;
 		yscale = (float)h_in / h_out;
+	} else {
+		xscale = (float)(w_in - 1) / (w_out - 1);
+		yscale = (float)(h_in - 1) / (h_out - 1);
 	}
-	else {
-		xscale = (float)(w_in-1) / (w_out-1);
-		yscale = (float)(h_in-1) / (h_out-1);
+	for (int32_t h = 0; h < h_out; h++) {
+		float yfloat = h * yscale;
+		float yfrac = yfloat - floorf(yfloat);
+		int32_t yint = yfloat - yfrac;
+		tp->yidx[2 * h + 0] = min_i32(h_in - 1, yint);
+		tp->yidx[2 * h + 1] = min_i32(h_in - 1, yint + 1);
+		tp->yfrac[h] = yfrac;
 	}
-	for (int32_t b = 0; b < b_in; b++) {
-		const uint8_t *bstart = in + b*h_in*w_in*d_in;
-		for (int32_t h = 0; h < h_out; h++) {
-			float yfloat = h*yscale;
-			float yfrac = yfloat - floorf(yfloat);
-			float yint = yfloat - yfrac;
-			for (int32_t w = 0; w < w_out; w++) {
-				float xfloat = w*xscale;
-				float xfrac = xfloat - floorf(xfloat);
-				float xint = xfloat - xfrac;
-				for (int32_t d = 0; d < d_in; d++) {
-					uint8_t f00 = bstart[(int32_t)(min_i32(h_in_end - 1, (yint + 0))*w_in*d_in + min_i32(w_in - 1, (xint + 0))*d_in) + d];
-					uint8_t f01 = bstart[(int32_t)(min_i32(h_in_end - 1, (yint + 0))*w_in*d_in + min_i32(w_in - 1, (xint + 1))*d_in) + d];
-					uint8_t f10 = bstart[(int32_t)(min_i32(h_in_end - 1, (yint + 1))*w_in*d_in + min_i32(w_in - 1, (xint + 0))*d_in) + d];
-					uint8_t f11 = bstart[(int32_t)(min_i32(h_in_end - 1, (yint + 1))*w_in*d_in + min_i32(w_in - 1, (xint + 1))*d_in) + d];
-					float outfloat = bilinear_interpolate(f00, f01, f10, f11, xfrac, yfrac);
-					out[d] = outfloat + 0.5f;
+	for (int32_t w = 0; w < w_out; w++) {
+		float xfloat = w * xscale;
+		float xfrac = xfloat - floorf(xfloat);
+		int32_t xint = xfloat - xfrac;
+		tp->xoff[2 * w + 0] = min_i32(w_in - 1, xint) * depth;
+		tp->xoff[2 * w + 1] = min_i32(w_in - 1, xint + 1) * depth;
+		tp->xfrac[w] = xfrac;
+	}
+	info->tables = tp;
+	return tp;
+}
+
+struct bilin_sep_runstate {
+	const void *tin;
+	void *tout;
+	int32_t elementsize;	// 4 for float, 1 for uint8
+	const struct bilin_tables *tp;
+	int32_t rows_per_job;
+	int32_t inner_count;	// jobs per batch
+	struct buffer_pool rowbufs;	// each holds 2 float rows of w_out*depth
+	nn_sem_t done_sem;
+	int32_t jobs;
+	volatile int32_t next_job;
+};
+
+static inline void
+bilin_hpass_f(const float *inrow, float *tmp, const struct bilin_tables *tp)
+{
+	int32_t depth = tp->depth;
+	for (int32_t w = 0; w < tp->out_width; w++) {
+		const float *p0 = inrow + tp->xoff[2 * w + 0];
+		const float *p1 = inrow + tp->xoff[2 * w + 1];
+		float xfrac = tp->xfrac[w];
+		for (int32_t d = 0; d < depth; d++) {
+			tmp[d] = linear_interpolate(p0[d], p1[d], xfrac);
+		}
+		tmp += depth;
+	}
+}
+
+static inline void
+bilin_hpass_u8(const uint8_t *inrow, float *tmp, const struct bilin_tables *tp)
+{
+	int32_t depth = tp->depth;
+	for (int32_t w = 0; w < tp->out_width; w++) {
+		const uint8_t *p0 = inrow + tp->xoff[2 * w + 0];
+		const uint8_t *p1 = inrow + tp->xoff[2 * w + 1];
+		float xfrac = tp->xfrac[w];
+		for (int32_t d = 0; d < depth; d++) {
+			tmp[d] = linear_interpolate(p0[d], p1[d], xfrac);
+		}
+		tmp += depth;
+	}
+}
+
+static void resizebilinear_sep_work(struct nn_graph *nn, void *vinfo)
+{
+	struct bilin_sep_runstate *rstp = (struct bilin_sep_runstate *)vinfo;
+	const struct bilin_tables *tp = rstp->tp;
+	int32_t elsize = rstp->elementsize;
+	int32_t in_hstride = tp->in_width * tp->depth;
+	int32_t out_hstride = tp->out_width * tp->depth;
+	int32_t job_idx;
+	int bufind;
+	float *rowbuf = bufpool_take(&rstp->rowbufs, &bufind);
+	float *rowa = rowbuf;
+	float *rowb = rowbuf + out_hstride;
+
+	batchslice_decode bsdecode;
+	batchslice_decode_init(&bsdecode, rstp->inner_count);
+
+	while (job_idx = __sync_fetch_and_add(&rstp->next_job, 1), job_idx < rstp->jobs) {
+		int32_t hid = batchslice_decode_update(&bsdecode, job_idx);
+		int32_t b = bsdecode.ibatch;
+		int32_t h0 = hid * rstp->rows_per_job;
+		int32_t h1 = min_i32(h0 + rstp->rows_per_job, tp->out_height);
+		const uint8_t *bin = (const uint8_t *)rstp->tin + (size_t)b * tp->in_height * in_hstride * elsize;
+		uint8_t *bout = (uint8_t *)rstp->tout + (size_t)b * tp->out_height * out_hstride * elsize;
+		int32_t rowa_y = -1, rowb_y = -1;		// source row currently in each buffer
+
+		for (int32_t h = h0; h < h1; h++) {
+			int32_t y0 = tp->yidx[2 * h + 0];
+			int32_t y1 = tp->yidx[2 * h + 1];
+			if (rowa_y != y0) {
+				if (rowb_y == y0) {		// moved down by one source row
+					float *t = rowa; rowa = rowb; rowb = t;
+					rowa_y = y0;
+					rowb_y = -1;
+				} else {
+					if (elsize == sizeof(float)) {
+						bilin_hpass_f((const float *)bin + (size_t)y0 * in_hstride, rowa, tp);
+					} else {
+						bilin_hpass_u8(bin + (size_t)y0 * in_hstride, rowa, tp);
+					}
+					rowa_y = y0;
+				}
+			}
+			if (rowb_y != y1) {
+				if (y1 == y0) {
+					memcpy(rowb, rowa, out_hstride * sizeof(float));
+				} else if (elsize == sizeof(float)) {
+					bilin_hpass_f((const float *)bin + (size_t)y1 * in_hstride, rowb, tp);
+				} else {
+					bilin_hpass_u8(bin + (size_t)y1 * in_hstride, rowb, tp);
+				}
+				rowb_y = y1;
+			}
+			float yfrac = tp->yfrac[h];
+			if (elsize == sizeof(float)) {
+				float *out = (float *)bout + (size_t)h * out_hstride;
+				for (int32_t i = 0; i < out_hstride; i++) {
+					out[i] = linear_interpolate(rowa[i], rowb[i], yfrac);
+				}
+			} else {
+				uint8_t *out = bout + (size_t)h * out_hstride;
+				for (int32_t i = 0; i < out_hstride; i++) {
+					out[i] = linear_interpolate(rowa[i], rowb[i], yfrac) + 0.5f;
 				}
-				out += d_in;
 			}
 		}
 	}
+	bufpool_release(&rstp->rowbufs, bufind);
+	nn_sem_post(&rstp->done_sem);
+}
+
+// each thread of the separable resize needs two float rows of the output width.
+static inline unsigned bilin_sep_rowbuf_size(int32_t w_out, int32_t d_in)
+{
+	return ((unsigned)w_out * d_in * 2 * sizeof(float) + 127) & ~127u;
+}
+
+// run the separable resize; the output shape must already be set.
+static int
+resizebilinear_sep_run(
+	struct nn_node *self, struct nn_graph *nn,
+	const void *in, void *out, int32_t elementsize,
+	int32_t b_in, int32_t h_in, int32_t w_in, int32_t d_in,
+	int32_t h_out, int32_t w_out, int32_t align_corners)
+{
+	struct bilin_sep_runstate rst;
+	struct resizebilinear_info *info = (struct resizebilinear_info *)self->opaque;
+	if (b_in <= 0 || h_out <= 0 || w_out <= 0 || d_in <= 0) return 0;
+	rst.tp = bilin_tables_get(info, h_in, w_in, h_out, w_out, d_in, align_corners);
+	if (rst.tp == NULL) return errlog(nn, "can't alloc resize tables");
+	rst.tin = in;
+	rst.tout = out;
+	rst.elementsize = elementsize;
+	// a few bands per thread for balance, but not so small that source rows aren't reused.
+	rst.inner_count = min_i32(h_out, 2 * NUM_THREADS);
+	rst.rows_per_job = (h_out + rst.inner_count - 1) / rst.inner_count;
+	rst.inner_count = (h_out + rst.rows_per_job - 1) / rst.rows_per_job;
+	rst.jobs = b_in * rst.inner_count;
+	rst.next_job = 0;
+
+	int32_t n_threads = min_i32(NUM_THREADS, rst.jobs);
+	unsigned rowbuf_size = bilin_sep_rowbuf_size(w_out, d_in);
+	nn_scratch_reset(nn);
+	if (nn_scratch_grow(nn, rowbuf_size * n_threads + 128)) {
+		return errlog(nn, "can't get scratch for %d row buffers", n_threads);
+	}
+	void *mem = nn_scratch_alloc(nn, rowbuf_size * n_threads);
+	if (mem == NULL) return errlog(nn, "didn't get temp mem");
+	bufpool_init(&rst.rowbufs, n_threads, mem, rowbuf_size);
+
+	nn_sem_init(&rst.done_sem, 0);
+	for (int32_t i = 0; i < n_threads; i++)
+		nn_os_work_for_vector(nn, resizebilinear_sep_work, &rst);
+	nn_sem_wait_n_times(&rst.done_sem, n_threads);
+	return 0;
 }
 
 //==================================================================================
@@ -920,26 +1121,14 @@ static int resizebilinear_f_execute(struct nn_node *self, struct nn_graph *nn)
 	const int32_t h_in = in_tensor->shape.height;
 	const int32_t w_in = in_tensor->shape.width;
 	const int32_t d_in = in_tensor->shape.depth;
-	float xscale = (float)w_in / w_out;
-	float yscale = (float)h_in / h_out;
-	uint32_t close_h;
-	uint32_t close_w;
-	int32_t b, h, w, d;
-	float *out = (float *)out_tensor->data;
-	const float *in = (const float *)in_tensor->data;
-	const float *bstart;
-	const float *hstart;
-	const float *wstart;
 	uint32_t depth_bytes = d_in * elementsize;
 	uint32_t total_bytes = b_in * h_out*w_out*depth_bytes;
 
 	int32_t align_corners = 0;
 	if (self->n_inputs == 3)
-		align_corners = *(int32_t *)(self->inputs[2]->data);
+		align_corners = *(int32_t *)(self->inputs[2]->data) != 0;
 	if (align_corners) {
 		if (w_out <= 1 || h_out <= 1) return errlog(nn, "aligned_corners flag is no good with out width/height of 1 or less");
-		xscale = (float)(w_in-1) / (w_out-1);
-		yscale = (float)(h_in-1) / (h_out-1);
 	}
 
 	if (total_bytes > out_tensor->max_size) return errlog(nn, "out too small");
@@ -947,32 +1136,8 @@ static int resizebilinear_f_execute(struct nn_node *self, struct nn_graph *nn)
 	tensor_set_shape(out_tensor, b_in, h_out, w_out, d_in);
 	out_tensor->data_size = total_bytes;
 
-	for (b = 0; b < b_in; b++) {
-		bstart = in + b * h_in*w_in*d_in;
-		for (h = 0; h < h_out; h++) {
-			float yfloat = h * yscale;
-			float yfrac = yfloat - floorf(yfloat);
-			float yint = yfloat - yfrac;
-			close_h = h * yscale;
-			hstart = bstart + close_h * w_in*d_in;
-			for (w = 0; w < w_out; w++) {
-				float xfloat = w * xscale;
-				float xfrac = xfloat - floorf(xfloat);
-				float xint = xfloat - xfrac;
-				close_w = w * xscale;
-				wstart = hstart + close_w * d_in;
-				for (d = 0; d < d_in; d++) {
-					float f00 = bstart[(int32_t)(min_i32(h_in - 1, (yint + 0))*w_in*d_in + min_i32(w_in - 1, (xint + 0))*d_in) + d];
-					float f01 = bstart[(int32_t)(min_i32(h_in - 1, (yint + 0))*w_in*d_in + min_i32(w_in - 1, (xint + 1))*d_in) + d];
-					float f10 = bstart[(int32_t)(min_i32(h_in - 1, (yint + 1))*w_in*d_in + min_i32(w_in - 1, (xint + 0))*d_in) + d];
-					float f11 = bstart[(int32_t)(min_i32(h_in - 1, (yint + 1))*w_in*d_in + min_i32(w_in - 1, (xint + 1))*d_in) + d];
-					out[d] = bilinear_interpolate(f00, f01, f10, f11, xfrac, yfrac);
-				}
-				out += d_in;
-			}
-		}
-	}
-	return 0;
+	return resizebilinear_sep_run(self, nn, in_tensor->data, out_tensor->data, elementsize,
+		b_in, h_in, w_in, d_in, h_out, w_out, align_corners);
 }
 
 //==================================================================================
@@ -990,23 +1155,24 @@ weight_generation(
 	if (ht_in < 1 || wid_in < 1 || ht_out < 1 || wid_out < 1) return -1;
 	if (depth < 1 || depth > 2) return -1;
 
-	struct resizebilinear_plan * planp = (struct resizebilinear_plan *)self->opaque;
-	if (planp != NULL) {
-		planp = (struct resizebilinear_plan*)(((size_t)planp + 0x7f)&-128);
+	struct resizebilinear_info *info = (struct resizebilinear_info *)self->opaque;
+	struct resizebilinear_plan * planp = NULL;
+	if (info->hvxplan_mem != NULL) {
+		planp = (struct resizebilinear_plan*)(((size_t)info->hvxplan_mem + 0x7f)&-128);
 		if (ht_in == planp->in_height && ht_out == planp->out_height
 			&&	wid_in == planp->in_width && wid_out == planp->out_width) {
 			rstp->planp = planp;	// reuse exising
 			return 0;
 		}
-		nn_free((void*)planp);
+		nn_free(info->hvxplan_mem);
 		planp = NULL;
-		self->opaque = NULL;
+		info->hvxplan_mem = NULL;
 	}
 	if (planp == NULL) {
 		planp = (struct resizebilinear_plan *) nn_malloc(
 			sizeof(struct resizebilinear_plan) + wxd_align *(sizeof(planp->xoff[0])*2+sizeof(planp->xfrac[0])) + (wxd_align >>7)*sizeof(planp->xload[0]) + 0x80);
 		if (planp == NULL) return -1;
-		self->opaque = (void*)planp;
+		info->hvxplan_mem = (void*)planp;
 		planp = (struct resizebilinear_plan*)(((size_t)planp + 0x7f)&-128);
 	}
 	rstp->planp = planp;
@@ -1127,9 +1293,12 @@ static int resizebilinear_qu8_execute(struct nn_node *self, struct nn_graph *nn)
 		runstate.resizebilinear_ptr = resizebilinear_hvx;
 	}
 	else {
-		runstate.inner_count = 1; //min_i32(h_in, NUM_THREADS); // partioned on height?
-		runstate.factor = -1;
-		runstate.resizebilinear_ptr = resizebilinear_general;
+		tensor_set_shape(out_tensor, b_in, h_out, w_out, d_in);
+		out_tensor->data_size = total_bytes;
+		tensor_copy(self->outputs[1], self->inputs[2]);
+		tensor_copy(self->outputs[2], self->inputs[3]);
+		return resizebilinear_sep_run(self, nn, in_tensor->data, out_tensor->data, sizeof(uint8_t),
+			b_in, h_in, w_in, d_in, h_out, w_out, runstate.align_corners);
 	}
 	runstate.tin = (const uint8_t *)in_tensor->data;
 	runstate.tout = (uint8_t *)out_tensor->data;
@@ -1180,21 +1349,66 @@ static int resizebilinear_qu8_execute(struct nn_node *self, struct nn_graph *nn)
 }
 
 
+//==================================================================================
+static struct nn_node *resizebilinear_ctor(
+	struct nn_graph *nn,
+	uint32_t node_id,
+	op_type operation,
+	padding_type padding,
+	uint32_t num_inputs,
+	uint32_t num_outputs,
+	const struct input *inputs,
+	const struct output *outputs)
+{
+	struct nn_node *self = node_alloc_common(nn, node_id, operation, padding, num_inputs, num_outputs, inputs, outputs);
+	if (self == NULL) return NULL;
+	if ((self->opaque = nn_calloc(1, sizeof(struct resizebilinear_info))) == NULL) {
+		errlog(nn, "can't alloc resize info");
+		node_free_common(self, nn);
+		return NULL;
+	}
+	return self;
+}
+
+static int resizebilinear_dtor(struct nn_node *self, struct nn_graph *nn)
+{
+	struct resizebilinear_info *info = (struct resizebilinear_info *)self->opaque;
+	if (info != NULL) {
+		if (info->hvxplan_mem != NULL) nn_free(info->hvxplan_mem);
+		if (info->tables != NULL) nn_free(info->tables);
+	}
+	return node_free_common_release_opaque(self, nn);
+}
+
+// Scratch is the separable resize's row buffers, or the hvx path's intermediate
+// rows (qu8 only); size for the largest output the output defs allow.
+static int resizebilinear_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	int32_t w_out = self->output_defs[0].max_sizes[2];
+	int32_t depth = self->output_defs[0].max_sizes[3];
+	uint32_t sep_bytes = bilin_sep_rowbuf_size(w_out, depth) * NUM_THREADS + 128;
+	uint32_t hvx_bytes = max_i32(8192, (w_out*depth*2 + 127) & -128) * NUM_THREADS;
+	*bytes = (sep_bytes > hvx_bytes) ? sep_bytes : hvx_bytes;
+	return 0;
+}
+
 //==================================================================================
 struct nn_node_ops nn_ops_for_ResizeBilinear_f = {
 	.execute = resizebilinear_f_execute,
 	.check = NULL,
-	.ctor = node_alloc_common,
-	.dtor = node_free_common,
+	.ctor = resizebilinear_ctor,
+	.dtor = resizebilinear_dtor,
 	.n_inputs = NN_IOCOUNT_RANGE(2,3),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = resizebilinear_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedResizeBilinear_8 = {
 	.execute = resizebilinear_qu8_execute,
 	.check = NULL,
-	.ctor = node_alloc_common,
-	.dtor = node_free_common_release_opaque,
+	.ctor = resizebilinear_ctor,
+	.dtor = resizebilinear_dtor,
 	.n_inputs = NN_IOCOUNT_RANGE(4,5),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = resizebilinear_scratch_hint,
 };
@@ -45,162 +45,153 @@
 #define NUM_THREADS 2
 #endif
 
-#define MIN(A,B) ( A < B ? A : B)
-#define MT
-#ifdef MT
-struct resize_8_t_data {
-	int whoami;
+//
+// The source row for each output row, and source column for each output column,
+// depend only on the shapes; they are kept in 'struct resizenear_tables', cached
+// in self->opaque and rebuilt only when a shape changes.
+// Output rows are split into bands across threads; an output row which has the same
+// source row as the previous one is just copied from it.
+//
+struct resizenear_tables {
+	int32_t in_height, in_width;
+	int32_t out_height, out_width;
+	int32_t depth;
+	int32_t elementsize;
+	int32_t align_corners;
+	int32_t *yidx;		// [out_height]: source row
+	int32_t *xoff;		// [out_width]: byte offset of source column within a row
+};
+
+struct resizenear_runstate {
 	const uint8_t *in_data;
-	uint32_t b, h_in, w_in, d_in;
 	uint8_t *out_data;
-	uint32_t newwidth;
-	uint32_t newheight;
-	nn_sem_t donesem;
-	uint32_t start_row;
-	uint32_t rows;
-	float xscale;
-	float yscale;
+	const struct resizenear_tables *tp;
+	int32_t rows_per_job;
+	int32_t inner_count;	// jobs per batch
+	int32_t jobs;
+	volatile int32_t next_job;
+	nn_sem_t done_sem;
 };
 
+static struct resizenear_tables *
+resizenear_tables_get(struct nn_node *self,
+	int32_t h_in, int32_t w_in, int32_t h_out, int32_t w_out, int32_t depth, int32_t elementsize, int32_t align_corners)
+{
+	struct resizenear_tables *tp = (struct resizenear_tables *)self->opaque;
+	if (tp != NULL) {
+		if (tp->in_height == h_in && tp->in_width == w_in && tp->out_height == h_out && tp->out_width == w_out
+			&& tp->depth == depth && tp->elementsize == elementsize && tp->align_corners == align_corners) {
+			return tp;
+		}
+		nn_free(tp);
+		self->opaque = NULL;
+	}
+	tp = nn_malloc(sizeof(struct resizenear_tables) + ((size_t)h_out + w_out) * sizeof(int32_t));
+	if (tp == NULL) return NULL;
+	tp->in_height = h_in;
+	tp->in_width = w_in;
+	tp->out_height = h_out;
+	tp->out_width = w_out;
+	tp->depth = depth;
+	tp->elementsize = elementsize;
+	tp->align_corners = align_corners;
+	tp->yidx = (int32_t *)(tp + 1);
+	tp->xoff = tp->yidx + h_out;
 
-// Specific method for align corners.  So that performance of non-aligned isn't impacted
-
-// TODO: Merge these without impacting non-aligned corners
-static void resize8_worker_thread_align_corners(struct nn_graph *nn, void *tdata) {
-	struct resize_8_t_data *td = tdata;
-	uint8_t *out = td->out_data;
-	uint8_t *hstart;
-	uint8_t *wstart;
-	uint8_t *bstart;
-	uint32_t close_h;
-	uint32_t close_w;
-	uint32_t depth_bytes = td->d_in * sizeof(uint8_t);
-	int b, h,w;
-
- 	for (b = 0; b < td->b; b++) {
- 		out = td->out_data + b * td->newwidth * td->newheight * td->d_in;
- 		out += td->start_row * td->newwidth * td->d_in;
- 		bstart = (uint8_t*)td->in_data + b*td->h_in*td->w_in*td->d_in;
- 		for (h = td->start_row; h < (td->start_row + td->rows); h++) {
-		 	close_h = MIN(round(h*td->yscale), td->h_in - 1);
- 			hstart = bstart + close_h*td->w_in*td->d_in;
- 			for (w = 0; w < td->newwidth; w++) {
- 				close_w = MIN(round(w*td->xscale), td->w_in -1);
- 				wstart = hstart + close_w*td->d_in;
- 				vmemcpy_asm(out,wstart,depth_bytes);
- 				out += depth_bytes;
- 			}
- 		}
- 	}
-	nn_sem_post(&td->donesem);
-}
-
-static void resize8_worker_thread(struct nn_graph *nn, void *tdata) {
-	struct resize_8_t_data *td = tdata;
-	uint8_t *out = td->out_data;
-	uint8_t *hstart;
-	uint8_t *wstart;
-	uint8_t *bstart;
-	uint32_t close_h;
-	uint32_t close_w;
-	uint32_t depth_bytes = td->d_in * sizeof(uint8_t);
-	int b, h,w;
-
- 	for (b = 0; b < td->b; b++) {
- 		out = td->out_data + b * td->newwidth * td->newheight * td->d_in;
- 		out += td->start_row * td->newwidth * td->d_in;
- 		bstart = (uint8_t*)td->in_data + b*td->h_in*td->w_in*td->d_in;
- 		for (h = td->start_row; h < (td->start_row + td->rows); h++) {
- 			close_h = h * td->yscale;
- 			hstart = bstart + close_h*td->w_in*td->d_in;
- 			for (w = 0; w < td->newwidth; w++) {
- 				close_w = w*td->xscale;
- 				wstart = hstart + close_w*td->d_in;
- 				vmemcpy_asm(out,wstart,depth_bytes);
- 				out += depth_bytes;
- 			}
- 		}
- 	}
-	nn_sem_post(&td->donesem);
+	float xscale, yscale;
+	if (align_corners && h_out > 1 && w_out > 1) {
+		xscale = (float)(w_in-1)/((float)w_out-1);
+		yscale = (float)(h_in-1)/((float)h_out-1);
+	} else {
+		xscale = (float)w_in/w_out;
+		yscale = (float)h_in/h_out;
+	}
+	for (int32_t h = 0; h < h_out; h++) {
+		uint32_t close_h = align_corners ? min_i32(roundf(h*yscale), h_in - 1) : (uint32_t)(h*yscale);
+		tp->yidx[h] = close_h;
+	}
+	for (int32_t w = 0; w < w_out; w++) {
+		uint32_t close_w = align_corners ? min_i32(roundf(w*xscale), w_in - 1) : (uint32_t)(w*xscale);
+		tp->xoff[w] = close_w * depth * elementsize;
+	}
+	self->opaque = tp;
+	return tp;
 }
 
-static int resizenear_8_execute(struct nn_node *self, struct nn_graph *nn)
+static inline void
+resizenear_row(uint8_t *out, const uint8_t *inrow, const int32_t *xoff, int32_t w_out, uint32_t nbytes)
 {
-	const struct tensor *in_tensor = self->inputs[0];
-	const struct tensor *newdim_tensor = self->inputs[1];
-	const struct tensor *in_min_tensor = self->inputs[2];
-	const struct tensor *in_max_tensor = self->inputs[3];
-	uint32_t align_corners = 0;
-	if (self->n_inputs == 5) {
-		const struct tensor *align_corners_tensor = self->inputs[4];
-		align_corners = tensor_get_int32(align_corners_tensor, 0);
+	int32_t w;
+	if (nbytes == 1) {
+		for (w = 0; w < w_out; w++) out[w] = inrow[xoff[w]];
+	} else if (nbytes == 4) {
+		for (w = 0; w < w_out; w++) memcpy(out + 4*w, inrow + xoff[w], 4);
+	} else {
+		for (w = 0; w < w_out; w++) {
+			memcpy(out, inrow + xoff[w], nbytes);
+			out += nbytes;
+		}
 	}
-	struct tensor *out_tensor = self->outputs[0];
-	struct tensor *out_min_tensor = self->outputs[1];
-	struct tensor *out_max_tensor = self->outputs[2];
-
-	const int32_t *newdims = newdim_tensor->data;
-	const int32_t newheight = newdims[0];
-	const int32_t newwidth = newdims[1];
-	const int32_t b_in = in_tensor->shape.batches;
-	const int32_t h_in = in_tensor->shape.height;
-	const int32_t w_in = in_tensor->shape.width;
-	const int32_t d_in = in_tensor->shape.depth;
-	float xscale;
-	float yscale;
-	uint8_t *out = out_tensor->data;
-	const uint8_t *in = in_tensor->data;
+}
 
-	if(  tensor_out_prepare_normal( out_tensor, b_in,newheight,newwidth,d_in, NN_TYPE_UINT8)!= 0 ){
-		return errlog(nn,"output prepare failed");
-	}
-	tensor_copy(out_min_tensor,in_min_tensor);
-	tensor_copy(out_max_tensor,in_max_tensor);
+static void resizenear_work(struct nn_graph *nn, void *vinfo)
+{
+	struct resizenear_runstate *rstp = (struct resizenear_runstate *)vinfo;
+	const struct resizenear_tables *tp = rstp->tp;
+	uint32_t nbytes = tp->depth * tp->elementsize;
+	uint32_t in_hstride = tp->in_width * nbytes;
+	uint32_t out_hstride = tp->out_width * nbytes;
+	int32_t job_idx;
 
-	struct resize_8_t_data tdata[NUM_THREADS];
-	uint32_t rows_per_thread = newheight / NUM_THREADS;
+	batchslice_decode bsdecode;
+	batchslice_decode_init(&bsdecode, rstp->inner_count);
 
-	if (align_corners && (newheight > 1) && (newwidth > 1)) {
-		xscale = (float)(w_in-1)/((float)newwidth-1);
-		yscale = (float)(h_in-1)/((float)newheight-1);
-	} else {
-		xscale = (float)w_in/newwidth;
-		yscale = (float)h_in/newheight;
+	while (job_idx = __sync_fetch_and_add(&rstp->next_job, 1), job_idx < rstp->jobs) {
+		int32_t hid = batchslice_decode_update(&bsdecode, job_idx);
+		int32_t b = bsdecode.ibatch;
+		int32_t h0 = hid * rstp->rows_per_job;
+		int32_t h1 = min_i32(h0 + rstp->rows_per_job, tp->out_height);
+		const uint8_t *bin = rstp->in_data + (size_t)b * tp->in_height * in_hstride;
+		uint8_t *out = rstp->out_data + ((size_t)b * tp->out_height + h0) * out_hstride;
+		for (int32_t h = h0; h < h1; h++) {
+			if (h > h0 && tp->yidx[h] == tp->yidx[h-1]) {
+				memcpy(out, out - out_hstride, out_hstride);
+			} else {
+				resizenear_row(out, bin + (size_t)tp->yidx[h] * in_hstride, tp->xoff, tp->out_width, nbytes);
+			}
+			out += out_hstride;
+		}
 	}
-	for (int tid = 0; tid < NUM_THREADS; tid++) {
-			tdata[tid].whoami = tid;
-			tdata[tid].in_data = in;
-			tdata[tid].b = b_in;
-			tdata[tid].h_in = h_in;
-			tdata[tid].w_in = w_in;
-			tdata[tid].d_in = d_in;
-			tdata[tid].out_data = out;
-			tdata[tid].newwidth = newwidth;
-			tdata[tid].newheight = newheight;
-			tdata[tid].xscale = xscale;
-			tdata[tid].yscale = yscale;
+	nn_sem_post(&rstp->done_sem);
+}
 
-			tdata[tid].start_row = rows_per_thread * tid;
-			tdata[tid].rows = rows_per_thread;
-			nn_sem_init(&tdata[tid].donesem, 0);
-		}
-	tdata[NUM_THREADS-1].rows += newheight % NUM_THREADS;
+// run the resize; the output shape must already be set.
+static int
+resizenear_run(struct nn_node *self, struct nn_graph *nn,
+	const void *in, void *out, int32_t elementsize,
+	int32_t b_in, int32_t h_in, int32_t w_in, int32_t d_in,
+	int32_t h_out, int32_t w_out, int32_t align_corners)
+{
+	struct resizenear_runstate rst;
+	if (b_in <= 0 || h_out <= 0 || w_out <= 0 || d_in <= 0) return 0;
+	rst.tp = resizenear_tables_get(self, h_in, w_in, h_out, w_out, d_in, elementsize, align_corners);
+	if (rst.tp == NULL) return errlog(nn, "can't alloc resize tables");
+	rst.in_data = in;
+	rst.out_data = out;
+	rst.inner_count = min_i32(h_out, 2 * NUM_THREADS);
+	rst.rows_per_job = (h_out + rst.inner_count - 1) / rst.inner_count;
+	rst.inner_count = (h_out + rst.rows_per_job - 1) / rst.rows_per_job;
+	rst.jobs = b_in * rst.inner_count;
+	rst.next_job = 0;
 
-	// Use a different method depending on align_corners.  This is to keep
-	// non-aligned corners fast.
-	for(int i = 0; i < NUM_THREADS; i++){
-		if (align_corners) {
-        	nn_os_work_for_vector(nn, resize8_worker_thread_align_corners, &tdata[i]);
-        } else {
-        	nn_os_work_for_vector(nn, resize8_worker_thread, &tdata[i]);
-        }
-    }
-    for (int i=0; i<NUM_THREADS; i++) {
-        nn_sem_wait(&tdata[i].donesem);
-    }
+	int32_t n_threads = min_i32(NUM_THREADS, rst.jobs);
+	nn_sem_init(&rst.done_sem, 0);
+	for (int32_t i = 0; i < n_threads; i++)
+		nn_os_work_for_vector(nn, resizenear_work, &rst);
+	nn_sem_wait_n_times(&rst.done_sem, n_threads);
 	return 0;
 }
-#else
+
 static int resizenear_8_execute(struct nn_node *self, struct nn_graph *nn)
 {
 	const struct tensor *in_tensor = self->inputs[0];
@@ -223,57 +214,17 @@ static int resizenear_8_execute(struct nn_node *self, struct nn_graph *nn)
 	const int32_t h_in = in_tensor->shape.height;
 	const int32_t w_in = in_tensor->shape.width;
 	const int32_t d_in = in_tensor->shape.depth;
-	float xscale;
-	float yscale;
-	uint32_t close_h;
-	uint32_t close_w;
-	int b,h,w;
-	char *out = out_tensor->data;
-	const uint8_t *in = in_tensor->data;
-	const uint8_t *bstart;
-	const uint8_t *hstart;
-	const uint8_t *wstart;
-	uint32_t depth_bytes = d_in * sizeof(uint8_t);
-	uint32_t total_bytes = b_in*newheight*newwidth*depth_bytes;
 
-	if (total_bytes > out_tensor->max_size) return errlog(nn,"out too small");
-	tensor_set_shape(out_tensor,b_in,newheight,newwidth,d_in);
-	out_tensor->data_size = total_bytes;
+	if(  tensor_out_prepare_normal( out_tensor, b_in,newheight,newwidth,d_in, NN_TYPE_UINT8)!= 0 ){
+		return errlog(nn,"output prepare failed");
+	}
 	tensor_copy(out_min_tensor,in_min_tensor);
 	tensor_copy(out_max_tensor,in_max_tensor);
 
-	if (align_corners && (newheight > 1) && (newwidth > 1)) {
-		xscale = (float)(w_in-1)/((float)newwidth-1);
-		yscale = (float)(h_in-1)/((float)newheight-1);
-	} else {
-		xscale = (float)w_in/newwidth;
-		yscale = (float)h_in/newheight;
-	}
-
-	for (b = 0; b < b_in; b++) {
-		bstart = in + b*h_in*w_in*d_in;
-		for (h = 0; h < newheight; h++) {
-			if (align_corners) {
-				close_h = MIN(round(h*yscale), h_in - 1);
-			} else {
-				close_h = h * yscale;
-			}
-			hstart = bstart + close_h*w_in*d_in;
-			for (w = 0; w < newwidth; w++) {
-				if (align_corners) {
-					close_w = MIN(round(w*xscale), w_in - 1);
-				} else {
-					close_w = w*xscale;
-				}
-				wstart = hstart + close_w*d_in;
-				vmemcpy_asm(out,wstart,depth_bytes);
-				out += depth_bytes;
-			}
-		}
-	}
-	return 0;
+	return resizenear_run(self, nn, in_tensor->data, out_tensor->data, sizeof(uint8_t),
+		b_in, h_in, w_in, d_in, newheight, newwidth, align_corners != 0);
 }
-#endif
+
 static int resizenear_f_execute(struct nn_node *self, struct nn_graph *nn)
 {
 	const struct tensor *in_tensor = self->inputs[0];
@@ -286,16 +237,6 @@ static int resizenear_f_execute(struct nn_node *self, struct nn_graph *nn)
 	const int32_t h_in = in_tensor->shape.height;
 	const int32_t w_in = in_tensor->shape.width;
 	const int32_t d_in = in_tensor->shape.depth;
-	const float xscale = (float)w_in/newwidth;
-	const float yscale = (float)h_in/newheight;
-	uint32_t close_h;
-	uint32_t close_w;
-	int b,h,w;
-	char *out = out_tensor->data;
-	const float *in = in_tensor->data;
-	const float *bstart;
-	const float *hstart;
-	const float *wstart;
 	uint32_t depth_bytes = d_in * sizeof(float);
 	uint32_t total_bytes = b_in*newheight*newwidth*depth_bytes;
 
@@ -303,20 +244,8 @@ static int resizenear_f_execute(struct nn_node *self, struct nn_graph *nn)
 	tensor_set_shape(out_tensor,b_in,newheight,newwidth,d_in);
 	out_tensor->data_size = total_bytes;
 
-	for (b = 0; b < b_in; b++) {
-		bstart = in + b*h_in*w_in*d_in;
-		for (h = 0; h < newheight; h++) {
-			close_h = h * yscale;
-			hstart = bstart + close_h*w_in*d_in;
-			for (w = 0; w < newwidth; w++) {
-				close_w = w*xscale;
-				wstart = hstart + close_w*d_in;
-				memcpy(out,wstart,depth_bytes);
-				out += depth_bytes;
-			}
-		}
-	}
-	return 0;
+	return resizenear_run(self, nn, in_tensor->data, out_tensor->data, sizeof(float),
+		b_in, h_in, w_in, d_in, newheight, newwidth, 0);
 }
 
 
@@ -325,7 +254,7 @@ struct nn_node_ops nn_ops_for_ResizeNearestNeighbor_f = {
 	.execute = resizenear_f_execute,
 	.check = NULL,
 	.ctor = node_alloc_common,
-	.dtor = node_free_common,
+	.dtor = node_free_common_release_opaque,
 	.n_inputs = NN_IOCOUNT(2),		// TODO support align corners input
 	.n_outputs = NN_IOCOUNT(1),
 };
@@ -337,7 +266,7 @@ struct nn_node_ops nn_ops_for_ResizeNearestNeighbor_8 = {
 	.execute = resizenear_8_execute,
 	.check = NULL,
 	.ctor = node_alloc_common,
-	.dtor = node_free_common,
+	.dtor = node_free_common_release_opaque,
 	.n_inputs = NN_IOCOUNT_RANGE(4,5),
 	.n_outputs = NN_IOCOUNT(3),
 };
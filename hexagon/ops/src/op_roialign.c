@@ -44,6 +44,8 @@
 #include <string.h>
 #include <math.h>
 #include <quantize.h>
+#include <nn_bufferpool.h>
+#include <nn_roialign.h>
 #if defined(__hexagon__)
 #include <hexagon_types.h>
 #endif
@@ -73,7 +75,11 @@
 #define BOTTOM_RIGHT_CORNER_IDX 3
 #define NUM_CORNERS 4
 #define NUM_DIMS 4
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
 #define NUM_THREADS 2
+#endif
 
 #define LOG_LEVEL 2 // 2 is default. Set to 0 if you just want to see everything
 
@@ -86,22 +92,24 @@ typedef long HVX_Vect_UN __attribute__((__vector_size__(128)))__attribute__((ali
 #endif
 
 // struct to communicate with nn_os_work_for_vector
+// Each thread takes one ROI at a time from next_job, and a buffer from 'bufs' which holds
+// its pooling_regions, axis tables, and (for hvx) the per-sample accumulators.
 struct tdata {
 	struct nn_node *self;
-	int whoami;
 	nn_sem_t donesem;
-	int start_batch;
-	int end_batch;
+	int n_rois;
+	volatile int next_job;
 	const struct tensor * feat_tensor;
 	const struct tensor * rois_tensor;
 	const struct tensor * out_tensor;
 	int32_t pooled_height;
 	int32_t pooled_width;
-	const float spatial_scale;
-	const int sampling_ratio;
-	struct pooling_region * pooling_regions;
-	int32_t * output_vals;
-	uint8_t * output_vals_q;
+	float spatial_scale;
+	int sampling_ratio;
+	struct buffer_pool bufs;
+	uint32_t output_vals_q_offs;	// offsets of each area within a buffer
+	uint32_t pooling_regions_offs;
+	uint32_t axis_tab_offs;
 };
 
 struct pooling_region {
@@ -110,85 +118,68 @@ struct pooling_region {
 };
 
 
-void pre_calc_for_bilinear_interpolate(
-		struct nn_graph *nn,
+// fill pooling_regions[] for one ROI, from the separable axis tables
+static void pre_calc_for_bilinear_interpolate(
 		const int height,
 		const int width,
 		const int pooled_height,
 		const int pooled_width,
-		float roi_start_h,
-		float roi_start_w,
-		float bin_size_h,
-		float bin_size_w,
-		int roi_bin_grid_h,
-		int roi_bin_grid_w,
+		const struct roialign_bins *bins,
+		struct roialign_axis_sample *ytab,
 		struct pooling_region * pooling_regions) {
 
+	const int roi_bin_grid_h = bins->grid_h;
+	const int roi_bin_grid_w = bins->grid_w;
+	struct roialign_axis_sample *xtab = ytab + pooled_height * roi_bin_grid_h;
+	roialign_axis_table(ytab, height, pooled_height, roi_bin_grid_h, bins->start_h, bins->cell_h);
+	roialign_axis_table(xtab, width, pooled_width, roi_bin_grid_w, bins->start_w, bins->cell_w);
+
 	int pooling_region_idx = 0;
 	for (int ph = 0; ph < pooled_height; ph++) {
 		for (int pw = 0; pw < pooled_width; pw++) {
 			for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-				const float yy = roi_start_h + ph * bin_size_h + ((float) iy + 0.5f) * bin_size_h / (float) roi_bin_grid_h;
+				const struct roialign_axis_sample ys = ytab[ph * roi_bin_grid_h + iy];
 				for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-					float x = roi_start_w + pw * bin_size_w + ((float) ix + 0.5f) * bin_size_w / (float) roi_bin_grid_w;
-					float y = yy;
+					const struct roialign_axis_sample xs = xtab[pw * roi_bin_grid_w + ix];
 					struct pooling_region pr;
-					if (y < -1.0 || y > height || x < -1.0 || x > width) {
+					if (!ys.valid || !xs.valid) {
 						memset(&pr, 0, sizeof(pr));
-						pooling_regions[pooling_region_idx] = pr;
-						pooling_region_idx++;
+						pooling_regions[pooling_region_idx++] = pr;
 						continue;
 					}
-					if (y<= 0) {
-						y = 0;
-					}
-					if(x <= 0){
-						x = 0;
-					}
-					int y_low =  (int) y;
-					int x_low = (int) x;
-					int y_high;
-					int x_high;
-					if (y_low >= height - 1) {
-						y_high = y_low = height - 1;
-						y = (float) y_low;
-					}
-					else {
-						y_high = y_low + 1;
-					}
-					if (x_low >= width - 1) {
-						x_high = x_low = width -1;
-						x = (float) x_low;
-					}
-					else{
-						x_high = x_low + 1;
-					}
-					float ly = y - y_low;
-					float lx = x - x_low;
+					float ly = ys.frac;
+					float lx = xs.frac;
 					float hy = 1 - ly;
 					float hx = 1 - lx;
-					uint8_t w1 = roundf(hy * hx * 255);
-					uint8_t w2 = roundf(hy * lx * 255);
-					uint8_t w3 = roundf(ly * hx * 255);
-					uint8_t w4 = roundf(ly * lx * 255);
-					pr.corners[TOP_LEFT_CORNER_IDX] = y_low * width + x_low;
-					pr.corners[TOP_RIGHT_CORNER_IDX] = y_low * width + x_high;
-					pr.corners[BOTTOM_LEFT_CORNER_IDX] = y_high * width + x_low;
-					pr.corners[BOTTOM_RIGHT_CORNER_IDX] = y_high * width + x_high;
-					pr.corner_weights[TOP_LEFT_CORNER_IDX] = w1;
-					pr.corner_weights[TOP_RIGHT_CORNER_IDX] = w2;
-					pr.corner_weights[BOTTOM_LEFT_CORNER_IDX] = w3;
-					pr.corner_weights[BOTTOM_RIGHT_CORNER_IDX] = w4;
-					pooling_regions[pooling_region_idx] = pr;
-
-					pooling_region_idx += 1;
-
+					pr.corners[TOP_LEFT_CORNER_IDX] = ys.lo * width + xs.lo;
+					pr.corners[TOP_RIGHT_CORNER_IDX] = ys.lo * width + xs.hi;
+					pr.corners[BOTTOM_LEFT_CORNER_IDX] = ys.hi * width + xs.lo;
+					pr.corners[BOTTOM_RIGHT_CORNER_IDX] = ys.hi * width + xs.hi;
+					pr.corner_weights[TOP_LEFT_CORNER_IDX] = roundf(hy * hx * 255);
+					pr.corner_weights[TOP_RIGHT_CORNER_IDX] = roundf(hy * lx * 255);
+					pr.corner_weights[BOTTOM_LEFT_CORNER_IDX] = roundf(ly * hx * 255);
+					pr.corner_weights[BOTTOM_RIGHT_CORNER_IDX] = roundf(ly * lx * 255);
+					pooling_regions[pooling_region_idx++] = pr;
 				}
 			}
 		}
 	}
 }
 
+// the bin geometry of ROI n
+static void roialign_get_bins(const struct tensor *rois_tensor, int n, float spatial_scale,
+                              int32_t pooled_height, int32_t pooled_width, int sampling_ratio,
+                              struct roialign_bins *bins)
+{
+	uint32_t offset = n * rois_tensor->shape.depth;
+	roialign_bins_setup(bins,
+		tensor_get_float(rois_tensor, offset + 1) * spatial_scale,
+		tensor_get_float(rois_tensor, offset + 2) * spatial_scale,
+		tensor_get_float(rois_tensor, offset + 3) * spatial_scale,
+		tensor_get_float(rois_tensor, offset + 4) * spatial_scale,
+		pooled_height, pooled_width, sampling_ratio, sampling_ratio);
+}
+
 static int check_roishape(struct nn_graph *nn, const struct tensor* tens, int logval) {
 	int res = 0;
 	if (tens->shape.batches != ROI_TENSOR_BATCHES) {
@@ -206,16 +197,17 @@ static int check_roishape(struct nn_graph *nn, const struct tensor* tens, int lo
 	return res;
 }
 
-static void doRoiAlignBatch_ref(struct nn_graph *nn, int start_batch,int end_batch,
-                                const struct tensor * feat_tensor,
-                                const struct tensor * rois_tensor,
-                                const struct tensor * out_tensor,
-                                int32_t pooled_height,
-                                int32_t pooled_width,
-                                const float spatial_scale,
-                                const int sampling_ratio,
-                                struct pooling_region * pooling_regions,
-                                int32_t * output_vals){
+static void doRoiAlign_ref(struct nn_graph *nn, int n,
+                           const struct tensor * feat_tensor,
+                           const struct tensor * rois_tensor,
+                           const struct tensor * out_tensor,
+                           int32_t pooled_height,
+                           int32_t pooled_width,
+                           const float spatial_scale,
+                           const int sampling_ratio,
+                           struct pooling_region * pooling_regions,
+                           struct roialign_axis_sample * axis_tab,
+                           int32_t * output_vals){
 	const int32_t feat_height = feat_tensor->shape.height;
 	const int32_t feat_width = feat_tensor->shape.width;
 	const int32_t feat_depth = feat_tensor->shape.depth;
@@ -225,93 +217,88 @@ static void doRoiAlignBatch_ref(struct nn_graph *nn, int start_batch,int end_bat
 	uint8_t * data2;
 	uint8_t * data3;
 	uint8_t * data4;
-	for (int n = start_batch; n < end_batch; n++) {
-		int index_n = n * pooled_size;
-		uint32_t offset = n * rois_tensor->shape.depth;
-		float roi_start_w = tensor_get_float(rois_tensor, offset +1) * spatial_scale;
-		float roi_start_h = tensor_get_float(rois_tensor, offset +2) * spatial_scale;
-		float roi_end_w = tensor_get_float(rois_tensor, offset + 3) * spatial_scale;
-		float roi_end_h = tensor_get_float(rois_tensor, offset + 4) * spatial_scale;
-		float roi_height = (roi_end_h - roi_start_h > 1.0) ? (roi_end_h - roi_start_h) : 1.0;
-		float roi_width = (roi_end_w - roi_start_w > 1.0) ? (roi_end_w - roi_start_w) : 1.0;
-
-		// Divide the ROI into (pooled_height) x (pooled_width) cells, each cell is of size: (cell_size_h) x (cell_size_w)
-		const float cell_size_h = (float) roi_height / (float) pooled_height;
-		const float cell_size_w = (float) roi_width / (float) pooled_width;
-		int roi_bin_grid_h = (sampling_ratio > 0) ? sampling_ratio : ceilf(roi_height / pooled_height);
-		int roi_bin_grid_w = (sampling_ratio > 0) ? sampling_ratio : ceilf(roi_width / pooled_width);
-		uint32_t count = roi_bin_grid_h * roi_bin_grid_w;
-		count = Q6_R_sath_R(0x8000/count);
-		pre_calc_for_bilinear_interpolate(
-				nn,
-				feat_height,
-				feat_width,
-				pooled_height,
-				pooled_width,
-				roi_start_h,
-				roi_start_w,
-				cell_size_h,
-				cell_size_w,
-				roi_bin_grid_h,
-				roi_bin_grid_w,
-				pooling_regions);
-		uint8_t *feat_data = feat_tensor->data;
-		uint8_t *dst = out_tensor->data;
-		int pooling_region_idx = 0;
-		for (int32_t ph = 0; ph < pooled_height; ++ph) {
-			for (int32_t pw = 0; pw < pooled_width; ++pw) {
-				int index_nhw = index_n + (ph * pooled_width + pw) * pooled_depth;
-				uint8_t * out = &dst[index_nhw];
-				memset(output_vals, 0, feat_depth*sizeof(int32_t));
-				for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-					for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-						struct pooling_region pr = pooling_regions[pooling_region_idx];
-						data1 = feat_data + feat_depth * pr.corners[TOP_LEFT_CORNER_IDX];
-						data2 = feat_data + feat_depth * pr.corners[TOP_RIGHT_CORNER_IDX];
-						data3 = feat_data + feat_depth * pr.corners[BOTTOM_LEFT_CORNER_IDX];
-						data4 = feat_data + feat_depth * pr.corners[BOTTOM_RIGHT_CORNER_IDX];
-						for (int i = 0; i < feat_depth; i++) {
-							output_vals[i] += (data1[i] * pr.corner_weights[TOP_LEFT_CORNER_IDX]
-							                   + data2[i] * pr.corner_weights[TOP_RIGHT_CORNER_IDX]
-							                   + data3[i] * pr.corner_weights[BOTTOM_LEFT_CORNER_IDX]
-							                   + data4[i] * pr.corner_weights[BOTTOM_RIGHT_CORNER_IDX]);
-						}
-						pooling_region_idx++;
-					}
-				}
-				if (count == 1) {
-					memcpy(out, output_vals, feat_depth);
-				}
-				else {
+	int index_n = n * pooled_size;
+	struct roialign_bins bins;
+	roialign_get_bins(rois_tensor, n, spatial_scale, pooled_height, pooled_width, sampling_ratio, &bins);
+	int roi_bin_grid_h = bins.grid_h;
+	int roi_bin_grid_w = bins.grid_w;
+	uint32_t count = roi_bin_grid_h * roi_bin_grid_w;
+	count = Q6_R_sath_R(0x8000/count);
+	pre_calc_for_bilinear_interpolate(
+			feat_height,
+			feat_width,
+			pooled_height,
+			pooled_width,
+			&bins,
+			axis_tab,
+			pooling_regions);
+	uint8_t *feat_data = feat_tensor->data;
+	uint8_t *dst = out_tensor->data;
+	int pooling_region_idx = 0;
+	for (int32_t ph = 0; ph < pooled_height; ++ph) {
+		for (int32_t pw = 0; pw < pooled_width; ++pw) {
+			int index_nhw = index_n + (ph * pooled_width + pw) * pooled_depth;
+			uint8_t * out = &dst[index_nhw];
+			memset(output_vals, 0, feat_depth*sizeof(int32_t));
+			for (int iy = 0; iy < roi_bin_grid_h; iy++) {
+				for (int ix = 0; ix < roi_bin_grid_w; ix++) {
+					struct pooling_region pr = pooling_regions[pooling_region_idx];
+					data1 = feat_data + feat_depth * pr.corners[TOP_LEFT_CORNER_IDX];
+					data2 = feat_data + feat_depth * pr.corners[TOP_RIGHT_CORNER_IDX];
+					data3 = feat_data + feat_depth * pr.corners[BOTTOM_LEFT_CORNER_IDX];
+					data4 = feat_data + feat_depth * pr.corners[BOTTOM_RIGHT_CORNER_IDX];
 					for (int i = 0; i < feat_depth; i++) {
-						out[i] = (output_vals[i] * count + 0x4000) >> 15;
+						output_vals[i] += (data1[i] * pr.corner_weights[TOP_LEFT_CORNER_IDX]
+						                   + data2[i] * pr.corner_weights[TOP_RIGHT_CORNER_IDX]
+						                   + data3[i] * pr.corner_weights[BOTTOM_LEFT_CORNER_IDX]
+						                   + data4[i] * pr.corner_weights[BOTTOM_RIGHT_CORNER_IDX]);
 					}
+					pooling_region_idx++;
 				}
-			} // loop pw (output w)
-		} // loop ph (output h)
-	}
+			}
+			if (count == 1) {
+				memcpy(out, output_vals, feat_depth);
+			}
+			else {
+				for (int i = 0; i < feat_depth; i++) {
+					out[i] = (output_vals[i] * count + 0x4000) >> 15;
+				}
+			}
+		} // loop pw (output w)
+	} // loop ph (output h)
 }
 
 static void roialign_execute_slice_ref(struct nn_graph *nn, void *vinfo)
 {
 	struct tdata *info = vinfo;
-	doRoiAlignBatch_ref(nn, info->start_batch,info->end_batch,info->feat_tensor,
-	                    info->rois_tensor,info->out_tensor,info->pooled_height,info->pooled_width,
-	                    info->spatial_scale,info->sampling_ratio,info->pooling_regions,info->output_vals);
+	int bufind, n;
+	uint8_t *buf = bufpool_take(&info->bufs, &bufind);
+	if (buf != NULL) {
+		while (n = __sync_fetch_and_add(&info->next_job, 1), n < info->n_rois) {
+			doRoiAlign_ref(nn, n, info->feat_tensor,
+			               info->rois_tensor, info->out_tensor, info->pooled_height, info->pooled_width,
+			               info->spatial_scale, info->sampling_ratio,
+			               (struct pooling_region *)(buf + info->pooling_regions_offs),
+			               (struct roialign_axis_sample *)(buf + info->axis_tab_offs),
+			               (int32_t *)buf);
+		}
+		bufpool_release(&info->bufs, bufind);
+	}
 	nn_sem_post(&info->donesem);
 }
 
-static void doRoiAlignBatch_hvx(struct nn_graph *nn, int start_batch,int end_batch,
-                                const struct tensor * feat_tensor,
-                                const struct tensor * rois_tensor,
-                                const struct tensor * out_tensor,
-                                int32_t pooled_height,
-                                int32_t pooled_width,
-                                const float spatial_scale,
-                                const int sampling_ratio,
-                                struct pooling_region * pooling_regions,
-                                int32_t * output_vals,
-                                uint8_t * output_vals_q) {
+static void doRoiAlign_hvx(struct nn_graph *nn, int n,
+                           const struct tensor * feat_tensor,
+                           const struct tensor * rois_tensor,
+                           const struct tensor * out_tensor,
+                           int32_t pooled_height,
+                           int32_t pooled_width,
+                           const float spatial_scale,
+                           const int sampling_ratio,
+                           struct pooling_region * pooling_regions,
+                           struct roialign_axis_sample * axis_tab,
+                           int32_t * output_vals,
+                           uint8_t * output_vals_q) {
 	const int32_t feat_height = feat_tensor->shape.height;
 	const int32_t feat_width = feat_tensor->shape.width;
 	const int32_t feat_depth = feat_tensor->shape.depth;
@@ -333,165 +320,178 @@ static void doRoiAlignBatch_hvx(struct nn_graph *nn, int start_batch,int end_bat
 			&stepsize,&recip_stepsize,
 			out_min_val,out_max_val);
 
-	for (int n = start_batch; n < end_batch; n++) {
-		int index_n = n * pooled_size;
-		uint32_t offset = n * rois_tensor->shape.depth;
-		float roi_start_w = tensor_get_float(rois_tensor, offset +1) * spatial_scale;
-		float roi_start_h = tensor_get_float(rois_tensor, offset +2) * spatial_scale;
-		float roi_end_w = tensor_get_float(rois_tensor, offset + 3) * spatial_scale;
-		float roi_end_h = tensor_get_float(rois_tensor, offset + 4) * spatial_scale;
-		float roi_height = (roi_end_h - roi_start_h > 1.0) ? (roi_end_h - roi_start_h) : 1.0;
-		float roi_width = (roi_end_w - roi_start_w > 1.0) ? (roi_end_w - roi_start_w) : 1.0;
-
-		// Divide the ROI into (pooled_height) x (pooled_width) cells, each cell is of size: (cell_size_h) x (cell_size_w)
-		const float cell_size_h = (float) roi_height / (float) pooled_height;
-		const float cell_size_w = (float) roi_width / (float) pooled_width;
-		int roi_bin_grid_h = (sampling_ratio > 0) ? sampling_ratio : ceilf(roi_height / pooled_height);
-		int roi_bin_grid_w = (sampling_ratio > 0) ? sampling_ratio : ceilf(roi_width / pooled_width);
-		uint32_t count = roi_bin_grid_h * roi_bin_grid_w;
-		count = Q6_R_sath_R(0x8000/count);
-		pre_calc_for_bilinear_interpolate(
-				nn,
-				feat_height,
-				feat_width,
-				pooled_height,
-				pooled_width,
-				roi_start_h,
-				roi_start_w,
-				cell_size_h,
-				cell_size_w,
-				roi_bin_grid_h,
-				roi_bin_grid_w,
-				pooling_regions);
-		uint8_t *feat_data = feat_tensor->data;
-		uint8_t *dst = out_tensor->data;
-		int pooling_region_idx = 0;
-		for (int32_t ph = 0; ph < pooled_height; ++ph) {
-			for (int32_t pw = 0; pw < pooled_width; ++pw) {
-				int index_nhw = index_n + (ph * pooled_width + pw) * pooled_depth;
-				uint8_t * out = &dst[index_nhw];
-				int32_t * cur_interpolation_bin = output_vals;
-				for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-					for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-						int32_t *inner_interpolation_bin = cur_interpolation_bin;
-						struct pooling_region pr = pooling_regions[pooling_region_idx];
-						data1 = feat_data + feat_depth * pr.corners[TOP_LEFT_CORNER_IDX];
-						data2 = feat_data + feat_depth * pr.corners[TOP_RIGHT_CORNER_IDX];
-						data3 = feat_data + feat_depth * pr.corners[BOTTOM_LEFT_CORNER_IDX];
-						data4 = feat_data + feat_depth * pr.corners[BOTTOM_RIGHT_CORNER_IDX];
-						l2fetch(data1, 1, PADDED_SIZE(feat_depth, 128), pr.corners[TOP_RIGHT_CORNER_IDX] - pr.corners[TOP_LEFT_CORNER_IDX]);
-						l2fetch(data3, 1, PADDED_SIZE(feat_depth, 128), pr.corners[BOTTOM_RIGHT_CORNER_IDX] - pr.corners[BOTTOM_LEFT_CORNER_IDX]);
-						for (int i = 0; i < feat_depth; i += 128) {
-							HVX_Vector data1_vec = vmemu((unsigned char *) (data1));
-							HVX_Vector data2_vec = vmemu((unsigned char *) (data2));
-							HVX_Vector data3_vec = vmemu((unsigned char *) (data3));
-							HVX_Vector data4_vec = vmemu((unsigned char *) (data4));
-
-							//In : b0,b1,b2...
-							//In : a0,a1,a2...
-							//Out (lo): b0a0,b2a2...
-							//Out (hi): b1a1,b3a3...
-							HVX_VectorPair ab = Q6_W_vshuff_VVR(data2_vec, data1_vec, 1);
-
-							//In : d0,d1,d2...
-							//In : c0,c1,c2...
-							//Out (lo): d0c0,d2c2...
-							//Out (hi): d1c1,d3c3...
-							HVX_VectorPair cd = Q6_W_vshuff_VVR(data4_vec, data3_vec, 1);
-
-							//In : d0c0,d2c2...
-							//In : b0a0,b2a2...
-							//Out: d0c0b0a0,d4c4b4a4...
-							//Out: d2c2b2a2,d6c6b6a6...
-							HVX_VectorPair abcd = Q6_W_vshuff_VVR(Q6_V_lo_W(cd), Q6_V_lo_W(ab), 2);
-
-							//In : d1c1,d3c3...
-							//In : b1a1,b3a3...
-							//Out : d1c1b1a1,d5c5b5a5...
-							//Out : d3c3b3a3,d7c7b7a7...
-							HVX_VectorPair abcd2 = Q6_W_vshuff_VVR(Q6_V_hi_W(cd), Q6_V_hi_W(ab), 2);
-
-							// In : [0, 4,  8 ... 124]
-							// In : [2, 6, 10 ... 126]
-							// Out : [ 0,  2,  4, ...  62]
-							// Out : [64, 66, 68, ... 126]
-							HVX_VectorPair abcd_even = Q6_W_vshuff_VVR(Q6_V_hi_W(abcd), Q6_V_lo_W(abcd), -4);
-
-							// In : [1, 5,  9 ... 125]
-							// In : [3, 7, 11 ... 127]
-							// Out : [ 1,  3,  5, ...  63]
-							// Out : [65, 67, 69, ... 127]
-							HVX_VectorPair abcd_odd = Q6_W_vshuff_VVR(Q6_V_hi_W(abcd2), Q6_V_lo_W(abcd2), -4);
-
-							// In : [ 0,  2,  4, ...  62]
-							// In : [ 1,  3,  5, ...  63]
-							// Out : [ 0,   1,  2, ...  31]
-							// Out : [32,  33, 34, ...  63]
-							HVX_VectorPair abcd_low = Q6_W_vshuff_VVR(Q6_V_lo_W(abcd_odd), Q6_V_lo_W(abcd_even), -4);
-
-							// In : [64, 66, 68, ... 126]
-							// In : [65, 67, 69, ... 127]
-							// Out : [64, 65, 66, ...  95]
-							// Output : [96, 97, 98, ... 127]
-							HVX_VectorPair abcd_high = Q6_W_vshuff_VVR(Q6_V_hi_W(abcd_odd), Q6_V_hi_W(abcd_even), -4);
-
-
-							// We've got the data all shuffled, now do 4 multiplies to process 128 depths
-							// If depth is >= 128, we will always move in such a way that what we're loading will be aligned, so we don't have to waste time doing unaligned loads
-							if (feat_depth >= 128){
-								HVX_Vector * depth_0_31 = (HVX_Vector *) inner_interpolation_bin;
-								HVX_Vector * depth_32_63 = (HVX_Vector *) (inner_interpolation_bin + 32);
-								HVX_Vector * depth_64_95 = (HVX_Vector *) (inner_interpolation_bin + 64);
-								HVX_Vector * depth_96_127 = (HVX_Vector *) (inner_interpolation_bin + 96);
-								*depth_0_31 = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_low), *(int32_t *) pr.corner_weights);
-
-								*depth_32_63 = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_low), *(int32_t *) pr.corner_weights);
-
-								*depth_64_95 = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_high), *(int32_t *) pr.corner_weights);
-
-								*depth_96_127 = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_high), *(int32_t *) pr.corner_weights);
-							}
-							else {
-								vmemu((int32_t *)inner_interpolation_bin) = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_low), *(int32_t *) pr.corner_weights);
-								vmemu((int32_t *)inner_interpolation_bin + 32) = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_low), *(int32_t *) pr.corner_weights);
-								vmemu((int32_t *)inner_interpolation_bin + 64) = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_high), *(int32_t *) pr.corner_weights);
-								vmemu((int32_t *)inner_interpolation_bin + 96) = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_high), *(int32_t *) pr.corner_weights);
-							}
-
-							data1 += 128;
-							data2 += 128;
-							data3 += 128;
-							data4 += 128;
-							inner_interpolation_bin += 128;
+	int index_n = n * pooled_size;
+	struct roialign_bins bins;
+	roialign_get_bins(rois_tensor, n, spatial_scale, pooled_height, pooled_width, sampling_ratio, &bins);
+	int roi_bin_grid_h = bins.grid_h;
+	int roi_bin_grid_w = bins.grid_w;
+	uint32_t count = roi_bin_grid_h * roi_bin_grid_w;
+	count = Q6_R_sath_R(0x8000/count);
+	pre_calc_for_bilinear_interpolate(
+			feat_height,
+			feat_width,
+			pooled_height,
+			pooled_width,
+			&bins,
+			axis_tab,
+			pooling_regions);
+	uint8_t *feat_data = feat_tensor->data;
+	uint8_t *dst = out_tensor->data;
+	int pooling_region_idx = 0;
+	for (int32_t ph = 0; ph < pooled_height; ++ph) {
+		for (int32_t pw = 0; pw < pooled_width; ++pw) {
+			int index_nhw = index_n + (ph * pooled_width + pw) * pooled_depth;
+			uint8_t * out = &dst[index_nhw];
+			int32_t * cur_interpolation_bin = output_vals;
+			for (int iy = 0; iy < roi_bin_grid_h; iy++) {
+				for (int ix = 0; ix < roi_bin_grid_w; ix++) {
+					int32_t *inner_interpolation_bin = cur_interpolation_bin;
+					struct pooling_region pr = pooling_regions[pooling_region_idx];
+					data1 = feat_data + feat_depth * pr.corners[TOP_LEFT_CORNER_IDX];
+					data2 = feat_data + feat_depth * pr.corners[TOP_RIGHT_CORNER_IDX];
+					data3 = feat_data + feat_depth * pr.corners[BOTTOM_LEFT_CORNER_IDX];
+					data4 = feat_data + feat_depth * pr.corners[BOTTOM_RIGHT_CORNER_IDX];
+					l2fetch(data1, 1, PADDED_SIZE(feat_depth, 128), pr.corners[TOP_RIGHT_CORNER_IDX] - pr.corners[TOP_LEFT_CORNER_IDX]);
+					l2fetch(data3, 1, PADDED_SIZE(feat_depth, 128), pr.corners[BOTTOM_RIGHT_CORNER_IDX] - pr.corners[BOTTOM_LEFT_CORNER_IDX]);
+					for (int i = 0; i < feat_depth; i += 128) {
+						HVX_Vector data1_vec = vmemu((unsigned char *) (data1));
+						HVX_Vector data2_vec = vmemu((unsigned char *) (data2));
+						HVX_Vector data3_vec = vmemu((unsigned char *) (data3));
+						HVX_Vector data4_vec = vmemu((unsigned char *) (data4));
+
+						//In : b0,b1,b2...
+						//In : a0,a1,a2...
+						//Out (lo): b0a0,b2a2...
+						//Out (hi): b1a1,b3a3...
+						HVX_VectorPair ab = Q6_W_vshuff_VVR(data2_vec, data1_vec, 1);
+
+						//In : d0,d1,d2...
+						//In : c0,c1,c2...
+						//Out (lo): d0c0,d2c2...
+						//Out (hi): d1c1,d3c3...
+						HVX_VectorPair cd = Q6_W_vshuff_VVR(data4_vec, data3_vec, 1);
+
+						//In : d0c0,d2c2...
+						//In : b0a0,b2a2...
+						//Out: d0c0b0a0,d4c4b4a4...
+						//Out: d2c2b2a2,d6c6b6a6...
+						HVX_VectorPair abcd = Q6_W_vshuff_VVR(Q6_V_lo_W(cd), Q6_V_lo_W(ab), 2);
+
+						//In : d1c1,d3c3...
+						//In : b1a1,b3a3...
+						//Out : d1c1b1a1,d5c5b5a5...
+						//Out : d3c3b3a3,d7c7b7a7...
+						HVX_VectorPair abcd2 = Q6_W_vshuff_VVR(Q6_V_hi_W(cd), Q6_V_hi_W(ab), 2);
+
+						// In : [0, 4,  8 ... 124]
+						// In : [2, 6, 10 ... 126]
+						// Out : [ 0,  2,  4, ...  62]
+						// Out : [64, 66, 68, ... 126]
+						HVX_VectorPair abcd_even = Q6_W_vshuff_VVR(Q6_V_hi_W(abcd), Q6_V_lo_W(abcd), -4);
+
+						// In : [1, 5,  9 ... 125]
+						// In : [3, 7, 11 ... 127]
+						// Out : [ 1,  3,  5, ...  63]
+						// Out : [65, 67, 69, ... 127]
+						HVX_VectorPair abcd_odd = Q6_W_vshuff_VVR(Q6_V_hi_W(abcd2), Q6_V_lo_W(abcd2), -4);
+
+						// In : [ 0,  2,  4, ...  62]
+						// In : [ 1,  3,  5, ...  63]
+						// Out : [ 0,   1,  2, ...  31]
+						// Out : [32,  33, 34, ...  63]
+						HVX_VectorPair abcd_low = Q6_W_vshuff_VVR(Q6_V_lo_W(abcd_odd), Q6_V_lo_W(abcd_even), -4);
+
+						// In : [64, 66, 68, ... 126]
+						// In : [65, 67, 69, ... 127]
+						// Out : [64, 65, 66, ...  95]
+						// Output : [96, 97, 98, ... 127]
+						HVX_VectorPair abcd_high = Q6_W_vshuff_VVR(Q6_V_hi_W(abcd_odd), Q6_V_hi_W(abcd_even), -4);
+
+
+						// We've got the data all shuffled, now do 4 multiplies to process 128 depths
+						// If depth is >= 128, we will always move in such a way that what we're loading will be aligned, so we don't have to waste time doing unaligned loads
+						if (feat_depth >= 128){
+							HVX_Vector * depth_0_31 = (HVX_Vector *) inner_interpolation_bin;
+							HVX_Vector * depth_32_63 = (HVX_Vector *) (inner_interpolation_bin + 32);
+							HVX_Vector * depth_64_95 = (HVX_Vector *) (inner_interpolation_bin + 64);
+							HVX_Vector * depth_96_127 = (HVX_Vector *) (inner_interpolation_bin + 96);
+							*depth_0_31 = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_low), *(int32_t *) pr.corner_weights);
+
+							*depth_32_63 = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_low), *(int32_t *) pr.corner_weights);
+
+							*depth_64_95 = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_high), *(int32_t *) pr.corner_weights);
+
+							*depth_96_127 = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_high), *(int32_t *) pr.corner_weights);
+						}
+						else {
+							vmemu((int32_t *)inner_interpolation_bin) = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_low), *(int32_t *) pr.corner_weights);
+							vmemu((int32_t *)inner_interpolation_bin + 32) = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_low), *(int32_t *) pr.corner_weights);
+							vmemu((int32_t *)inner_interpolation_bin + 64) = Q6_Vuw_vrmpy_VubRub(Q6_V_lo_W(abcd_high), *(int32_t *) pr.corner_weights);
+							vmemu((int32_t *)inner_interpolation_bin + 96) = Q6_Vuw_vrmpy_VubRub(Q6_V_hi_W(abcd_high), *(int32_t *) pr.corner_weights);
 						}
-						cur_interpolation_bin += feat_depth;
-						pooling_region_idx++;
+
+						data1 += 128;
+						data2 += 128;
+						data3 += 128;
+						data4 += 128;
+						inner_interpolation_bin += 128;
 					}
+					cur_interpolation_bin += feat_depth;
+					pooling_region_idx++;
 				}
-				nn_requantize_i32_to_qu8_hvx( output_vals_q, output_vals, feat_depth * roi_bin_grid_h * roi_bin_grid_w,
-						 in_level_size, out_min_val, out_max_val);
+			}
+			nn_requantize_i32_to_qu8_hvx( output_vals_q, output_vals, feat_depth * roi_bin_grid_h * roi_bin_grid_w,
+					 in_level_size, out_min_val, out_max_val);
 
 
-				l2fetch(output_vals_q,1,roi_bin_grid_w * roi_bin_grid_h * feat_depth,1);
-				if ((feat_depth % 128) == 0) {
-					avgpool_aligned_hvx(out, output_vals_q, feat_depth, roi_bin_grid_w, roi_bin_grid_h, roi_bin_grid_w, count);
-				} else {
-					avgpool_nonaligned_hvx(out, output_vals_q, feat_depth, roi_bin_grid_w, roi_bin_grid_h, roi_bin_grid_w, count);
-				}
-			} // loop pw (output w)
-		} // loop ph (output h)
-	}
+			l2fetch(output_vals_q,1,roi_bin_grid_w * roi_bin_grid_h * feat_depth,1);
+			if ((feat_depth % 128) == 0) {
+				avgpool_aligned_hvx(out, output_vals_q, feat_depth, roi_bin_grid_w, roi_bin_grid_h, roi_bin_grid_w, count);
+			} else {
+				avgpool_nonaligned_hvx(out, output_vals_q, feat_depth, roi_bin_grid_w, roi_bin_grid_h, roi_bin_grid_w, count);
+			}
+		} // loop pw (output w)
+	} // loop ph (output h)
 }
 
 static void roialign_execute_slice_hvx(struct nn_graph *nn, void *vinfo)
 {
 	struct tdata *info = vinfo;
-	doRoiAlignBatch_hvx(nn, info->start_batch,info->end_batch,info->feat_tensor,
-	                    info->rois_tensor,info->out_tensor,info->pooled_height,info->pooled_width,
-	                    info->spatial_scale,info->sampling_ratio,info->pooling_regions,info->output_vals,info->output_vals_q);
+	int bufind, n;
+	uint8_t *buf = bufpool_take(&info->bufs, &bufind);
+	if (buf != NULL) {
+		while (n = __sync_fetch_and_add(&info->next_job, 1), n < info->n_rois) {
+			doRoiAlign_hvx(nn, n, info->feat_tensor,
+			               info->rois_tensor, info->out_tensor, info->pooled_height, info->pooled_width,
+			               info->spatial_scale, info->sampling_ratio,
+			               (struct pooling_region *)(buf + info->pooling_regions_offs),
+			               (struct roialign_axis_sample *)(buf + info->axis_tab_offs),
+			               (int32_t *)buf, buf + info->output_vals_q_offs);
+		}
+		bufpool_release(&info->bufs, bufind);
+	}
 	nn_sem_post(&info->donesem);
 }
 
+// Per thread: the accumulators for every sample of one bin (the hvx version keeps them apart
+// until the averaging step; the reference only needs feat_depth), the requantized samples,
+// the pooling regions of one roi, and its axis tables. Returns the size of a thread's
+// buffer, and sets the offsets in 'info' if it's not NULL.
+static size_t roialign_buf_size(int32_t feat_depth, int32_t pooled_height, int32_t pooled_width,
+                                int max_sampling_points, int max_axis_tab, struct tdata *info)
+{
+	size_t output_vals_size_padded = PADDED_SIZE(feat_depth, ALIGN_SIZE) * max_sampling_points * sizeof(int32_t);
+	size_t output_vals_q_size_padded = PADDED_SIZE(feat_depth * max_sampling_points * sizeof(uint8_t), ALIGN_SIZE);
+	size_t pooling_regions_size_padded = PADDED_SIZE(max_sampling_points * pooled_height * pooled_width * sizeof(struct pooling_region), ALIGN_SIZE);
+	size_t axis_tab_size_padded = PADDED_SIZE(max_axis_tab * sizeof(struct roialign_axis_sample), ALIGN_SIZE);
+	if (info != NULL) {
+		info->output_vals_q_offs = output_vals_size_padded;
+		info->pooling_regions_offs = info->output_vals_q_offs + output_vals_q_size_padded;
+		info->axis_tab_offs = info->pooling_regions_offs + pooling_regions_size_padded;
+	}
+	return output_vals_size_padded + output_vals_q_size_padded + pooling_regions_size_padded + axis_tab_size_padded;
+}
+
 static int roialign_execute(struct nn_node *self, struct nn_graph *nn,
                             void (*roialign_execute_f)(struct nn_graph *self, void *vinfo)) {
 	const struct tensor *feat_tensor = self->inputs[OP_ROIALIGN_FEAT_DATA_IDX];
@@ -523,38 +523,13 @@ static int roialign_execute(struct nn_node *self, struct nn_graph *nn,
 	}
 	out_pre_implode_shape->data_size = NUM_DIMS*sizeof(float);
 
-	const int32_t feat_height = feat_tensor->shape.height;
-	const int32_t feat_width = feat_tensor->shape.width;
 	const int32_t feat_depth = feat_tensor->shape.depth;
-
 	const int32_t pooled_height = pool_tensor->shape.height;
 	const int32_t pooled_width = pool_tensor->shape.width;
-	const int32_t max_sampling_points = (sampling_ratio > 0) ? sampling_ratio * sampling_ratio : feat_height/pooled_height * feat_width/pooled_width;
-	struct pooling_region * pooling_regions;
-	int32_t * output_vals;
-	uint8_t * output_vals_q;
-	size_t output_vals_size_padded = PADDED_SIZE(feat_depth, ALIGN_SIZE) * max_sampling_points * sizeof(int32_t);
-	size_t pooling_regions_size_padded = PADDED_SIZE(max_sampling_points * pooled_height * pooled_width * sizeof(struct pooling_region), ALIGN_SIZE);
-	size_t output_vals_q_size_padded = PADDED_SIZE(feat_depth * max_sampling_points * sizeof(uint8_t), ALIGN_SIZE);
-	//Allocate space for each corner, summed pooling values, and the maximum number of points that could be sampled during bilinear interpolation
-	if(roialign_execute_f == roialign_execute_slice_ref) {
-		size_t total_data_size = NUM_THREADS * (output_vals_size_padded + pooling_regions_size_padded + output_vals_q_size_padded);
-		if (nn_scratch_grow(nn, total_data_size)) {
-			return errlog(nn, "Failed to get scratch");
-		}
-		output_vals = (int32_t *) nn->scratch;
-		pooling_regions = (struct pooling_region *) (output_vals + NUM_THREADS * feat_depth);
-	}
-	else{
-		size_t total_data_size = NUM_THREADS * (output_vals_size_padded + pooling_regions_size_padded + output_vals_q_size_padded);
-		if (nn_scratch_grow(nn, total_data_size)) {
-			return errlog(nn, "Failed to get scratch");
-		}
-		output_vals = (int32_t *)nn->scratch;
-		pooling_regions = (struct pooling_region *) (output_vals + NUM_THREADS * output_vals_size_padded);
-		output_vals_q = (uint8_t *) (pooling_regions + NUM_THREADS * pooling_regions_size_padded);
-	}
+
 	int num_valid_batches = 0;
+	int max_sampling_points = 1;	// most samples in one bin, over all the valid rois
+	int max_axis_tab = 0;
 	for (int i = 0; i < out_batch; i++) {
 		int offset = i * rois_tensor->shape.depth;
 		float roi_start_w = tensor_get_float(rois_tensor, offset + 1);
@@ -567,15 +542,17 @@ static int roialign_execute(struct nn_node *self, struct nn_graph *nn,
 		if(roi_width <= 0 || roi_height <= 0) {
 			break;
 		}
+		struct roialign_bins bins;
+		roialign_get_bins(rois_tensor, i, spatial_scale, pooled_height, pooled_width, sampling_ratio, &bins);
+		max_sampling_points = max_i32(max_sampling_points, bins.grid_h * bins.grid_w);
+		max_axis_tab = max_i32(max_axis_tab, pooled_height * bins.grid_h + pooled_width * bins.grid_w);
 		num_valid_batches++;
 	}
-	int num_batches_for_thread = num_valid_batches / NUM_THREADS;
 
-	struct tdata worker0_info = {
+	struct tdata info = {
 			.self = self,
-			.whoami = 0,
-			.start_batch = 0,
-			.end_batch = num_batches_for_thread,
+			.n_rois = num_valid_batches,
+			.next_job = 0,
 			.feat_tensor = feat_tensor,
 			.rois_tensor = rois_tensor,
 			.out_tensor = out_tensor,
@@ -583,33 +560,24 @@ static int roialign_execute(struct nn_node *self, struct nn_graph *nn,
 			.pooled_width = pooled_width,
 			.spatial_scale = spatial_scale,
 			.sampling_ratio = sampling_ratio,
-			.output_vals = output_vals,
-			.pooling_regions = pooling_regions,
-			.output_vals_q = output_vals_q
 	};
+	if (num_valid_batches > 0) {
+		size_t buf_size = roialign_buf_size(feat_depth, pooled_height, pooled_width, max_sampling_points, max_axis_tab, &info);
+		int n_threads = min_i32(NUM_THREADS, num_valid_batches);
 
-	struct tdata worker1_info = {
-			.self = self,
-			.whoami = 1,
-			.start_batch = num_batches_for_thread,
-			.end_batch = num_valid_batches,
-			.feat_tensor = feat_tensor,
-			.rois_tensor = rois_tensor,
-			.out_tensor = out_tensor,
-			.pooled_height = pooled_height,
-			.pooled_width = pooled_width,
-			.spatial_scale = spatial_scale,
-			.sampling_ratio = sampling_ratio,
-			.output_vals = (int32_t *)((uint8_t *)output_vals + output_vals_size_padded),
-			.pooling_regions = (struct pooling_region *) ((uint8_t*)pooling_regions + pooling_regions_size_padded),
-			.output_vals_q = output_vals_q + output_vals_q_size_padded
-	};
-	nn_sem_init(&worker0_info.donesem,0);
-	nn_sem_init(&worker1_info.donesem,0);
-	nn_os_work_for_vector(nn,roialign_execute_f,&worker0_info);
-	nn_os_work_for_vector(nn,roialign_execute_f,&worker1_info);
-	nn_sem_wait(&worker0_info.donesem);
-	nn_sem_wait(&worker1_info.donesem);
+		nn_scratch_reset(nn);
+		if (nn_scratch_grow(nn, n_threads * buf_size + ALIGN_SIZE)) {
+			return errlog(nn, "Failed to get scratch");
+		}
+		void *mem = nn_scratch_alloc(nn, n_threads * buf_size);
+		if (mem == NULL) return errlog(nn, "didn't get temp mem");
+		bufpool_init(&info.bufs, n_threads, mem, buf_size);
+
+		nn_sem_init(&info.donesem, 0);
+		for (int i = 0; i < n_threads; i++)
+			nn_os_work_for_vector(nn, roialign_execute_f, &info);
+		nn_sem_wait_n_times(&info.donesem, n_threads);
+	}
 	tensor_copy(out_min_tensor,feat_min_tensor);
 	tensor_copy(out_max_tensor,feat_max_tensor);
 	tensor_set_shape(out_pre_implode_shape, 1, 1, 1, NUM_DIMS);
@@ -621,6 +589,26 @@ static int roialign_execute(struct nn_node *self, struct nn_graph *nn,
 
 }
 
+// The buffers depend on the samples per bin, which are only known before execute
+// when sampling_ratio is a Const > 0 (otherwise they follow the size of each roi).
+static int roialign_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct nn_node *feat_src = find_node(nn, self->input_refs[OP_ROIALIGN_FEAT_DATA_IDX].src_id);
+	struct nn_node *pool_src = find_node_must_be_Const_from_ref(nn, &self->input_refs[OP_ROIALIGN_SIZE_DATA_IDX]);
+	struct nn_node *ratio_src = find_node_must_be_Const_from_ref(nn, &self->input_refs[OP_ROIALIGN_SAMPLING_RATIO_DATA_IDX]);
+	if (feat_src == NULL || pool_src == NULL || ratio_src == NULL) return -1;
+	if (ratio_src->outputs[0]->data_size < sizeof(int32_t)) return -1;
+	int sampling_ratio = tensor_get_int32(ratio_src->outputs[0], 0);
+	if (sampling_ratio <= 0) return -1;
+	int32_t feat_depth = feat_src->output_defs[self->input_refs[OP_ROIALIGN_FEAT_DATA_IDX].output_idx].max_sizes[3];
+	int32_t pooled_height = pool_src->outputs[0]->shape.height;
+	int32_t pooled_width = pool_src->outputs[0]->shape.width;
+	size_t buf_size = roialign_buf_size(feat_depth, pooled_height, pooled_width, sampling_ratio * sampling_ratio,
+		(pooled_height + pooled_width) * sampling_ratio, NULL);
+	*bytes = NUM_THREADS * buf_size + ALIGN_SIZE;
+	return 0;
+}
+
 static int roialign_execute_ref(struct nn_node *self, struct nn_graph *nn) {
 	return roialign_execute(self,nn,roialign_execute_slice_ref);
 }
@@ -636,6 +624,7 @@ struct nn_node_ops nn_ops_for_QuantizedRoiAlign_8 = {
 		.dtor = node_free_common,
 		.n_inputs = NN_IOCOUNT(OP_ROIALIGN_NUM_INPUTS),
 		.n_outputs = NN_IOCOUNT(OP_ROIALIGN_NUM_OUTPUTS),
+		.scratch_hint = roialign_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_QuantizedRoiAlign_8_ref = {
@@ -645,4 +634,5 @@ struct nn_node_ops nn_ops_for_QuantizedRoiAlign_8_ref = {
 		.dtor = node_free_common,
 		.n_inputs = NN_IOCOUNT(OP_ROIALIGN_NUM_INPUTS),
 		.n_outputs = NN_IOCOUNT(OP_ROIALIGN_NUM_OUTPUTS),
+		.scratch_hint = roialign_scratch_hint,
 };
@@ -43,6 +43,8 @@
 #include <string.h>
 #include <math.h>
 #include <quantize.h>
+#include <nn_bufferpool.h>
+#include <nn_roialign.h>
 #define ALIGN_SIZE 128
 // These constants must match those in DspRoiPoolingLayer.cpp from SNPE
 // No great way to share them yet.
@@ -70,93 +72,99 @@
 
 #define LOG_LEVEL 2 // 2 is default. Set to 0 if you just want to see everything
 
-// struct to communicate with nn_os_work_for_vector
-struct tdata {
-	struct nn_node *self;
-	nn_sem_t donesem;
-	int res;
-};
-struct pooling_region {
-	int corners[NUM_CORNERS];
-	float corner_weights[NUM_CORNERS];
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+struct roialign_f_runstate {
+	const float *feat;
+	float *out;
+	const struct tensor *rois_tensor;
+	int32_t feat_height, feat_width, depth;
+	int32_t pooled_height, pooled_width;
+	float spatial_scale;
+	int sampling_ratio;
+	int n_rois;			// one job per ROI
+	volatile int next_job;
+	struct buffer_pool tabbufs;	// per-thread axis tables
+	nn_sem_t done_sem;
 };
 
-//static int32_t max (int a, int32_t b) { return((a>b) ? a : b); }
-//static int32_t min (int32_t a, int32_t b) {return((a<b)?a:b);}
+static void roialign_f_roi(struct roialign_f_runstate *rstp, int n, struct roialign_axis_sample *ytab)
+{
+	const struct tensor *rois_tensor = rstp->rois_tensor;
+	const int32_t depth = rstp->depth;
+	const int32_t pooled_height = rstp->pooled_height;
+	const int32_t pooled_width = rstp->pooled_width;
+	const int32_t row_stride = rstp->feat_width * depth;
+	const float spatial_scale = rstp->spatial_scale;
+	struct roialign_bins bins;
 
-void pre_calc_for_bilinear_interpolate_f(
-		struct nn_graph *nn,
-		const int height,
-		const int width,
-		const int pooled_height,
-		const int pooled_width,
-		float roi_start_h,
-		float roi_start_w,
-		float bin_size_h,
-		float bin_size_w,
-		int roi_bin_grid_h,
-		int roi_bin_grid_w,
-		struct pooling_region * pooling_regions) {
+	uint32_t offset = n * rois_tensor->shape.depth;
+	roialign_bins_setup(&bins,
+		tensor_get_float(rois_tensor, offset + 1) * spatial_scale,
+		tensor_get_float(rois_tensor, offset + 2) * spatial_scale,
+		tensor_get_float(rois_tensor, offset + 3) * spatial_scale,
+		tensor_get_float(rois_tensor, offset + 4) * spatial_scale,
+		pooled_height, pooled_width, rstp->sampling_ratio, rstp->sampling_ratio);
+	const int grid_h = bins.grid_h;
+	const int grid_w = bins.grid_w;
+	const uint32_t count = grid_h * grid_w;
+	struct roialign_axis_sample *xtab = ytab + pooled_height * grid_h;
+	roialign_axis_table(ytab, rstp->feat_height, pooled_height, grid_h, bins.start_h, bins.cell_h);
+	roialign_axis_table(xtab, rstp->feat_width, pooled_width, grid_w, bins.start_w, bins.cell_w);
 
-	int pooling_region_idx = 0;
-	for (int ph = 0; ph< pooled_height; ph++) {
-		for (int pw = 0; pw< pooled_width; pw++) {
-			for (int iy = 0; iy<roi_bin_grid_h; iy++) {
-				const float yy = roi_start_h + ph * bin_size_h + ((float) iy + 0.5f) * bin_size_h / (float) roi_bin_grid_h;
-				for (int ix = 0; ix<roi_bin_grid_w; ix++) {
-					float x = roi_start_w + pw * bin_size_w + ((float) ix + 0.5f) * bin_size_w / (float) roi_bin_grid_w;
-					float y = yy;
-					struct pooling_region pr;
-					if (y < -1.0f || y > height || x < -1.0f || x > width) {
-						memset(&pr, 0, sizeof(pr));
-						pooling_regions[pooling_region_idx] = pr;
-						pooling_region_idx += 1;
-						continue;
-					}
-					if (y<= 0) {
-						y = 0;
-					}
-					if(x <= 0){
-						x = 0;
-					}
-					int y_low =  (int) y;
-					int x_low = (int) x;
-					int y_high;
-					int x_high;
-					if (y_low >= height -1) {
-						y_high = y_low = height -1;
-						y = (float) y_low;
-					}
-					else {
-						y_high = y_low + 1;
-					}
-					if (x_low >= width - 1) {
-						x_high = x_low = width -1;
-						x = (float) x_low;
+	const float *feat_data = rstp->feat;
+	float *dst = rstp->out + n * pooled_height * pooled_width * depth;
+	for (int32_t ph = 0; ph < pooled_height; ++ph) {
+		for (int32_t pw = 0; pw < pooled_width; ++pw) {
+			memset(dst, 0, depth * sizeof(float));
+			for (int iy = 0; iy < grid_h; iy++) {
+				const struct roialign_axis_sample ys = ytab[ph * grid_h + iy];
+				if (!ys.valid) continue;
+				const float *row_lo = feat_data + ys.lo * row_stride;
+				const float *row_hi = feat_data + ys.hi * row_stride;
+				for (int ix = 0; ix < grid_w; ix++) {
+					const struct roialign_axis_sample xs = xtab[pw * grid_w + ix];
+					if (!xs.valid) continue;
+					const float w1 = (1.0f - ys.frac) * (1.0f - xs.frac);
+					const float w2 = (1.0f - ys.frac) * xs.frac;
+					const float w3 = (1.0f - xs.frac) * ys.frac;
+					const float w4 = ys.frac * xs.frac;
+					const float *restrict d1 = row_lo + xs.lo * depth;
+					const float *restrict d2 = row_lo + xs.hi * depth;
+					const float *restrict d3 = row_hi + xs.lo * depth;
+					const float *restrict d4 = row_hi + xs.hi * depth;
+					float *restrict acc = dst;
+					// depth is innermost and contiguous in all 5 rows, so this vectorizes
+					for (int i = 0; i < depth; i++) {
+						acc[i] += d1[i] * w1 + d2[i] * w2 + d3[i] * w3 + d4[i] * w4;
 					}
-					else{
-						x_high = x_low + 1;
-					}
-					float w1 = (1.0f - (y - y_low)) * (1.0f - (x - x_low));
-					float w2 = (1.0f - (y - y_low)) * (x - x_low);
-					float w3 = (1.0f - (x - x_low)) * (y - y_low);
-					float w4 = (y - y_low) * (x - x_low);
-					pr.corners[TOP_LEFT_CORNER_IDX] = y_low * width + x_low;
-					pr.corners[TOP_RIGHT_CORNER_IDX] = y_low * width + x_high;
-					pr.corners[BOTTOM_LEFT_CORNER_IDX] = y_high * width + x_low;
-					pr.corners[BOTTOM_RIGHT_CORNER_IDX] = y_high * width + x_high;
-					pr.corner_weights[TOP_LEFT_CORNER_IDX] = w1;
-					pr.corner_weights[TOP_RIGHT_CORNER_IDX] = w2;
-					pr.corner_weights[BOTTOM_LEFT_CORNER_IDX] = w3;
-					pr.corner_weights[BOTTOM_RIGHT_CORNER_IDX] = w4;
-					pooling_regions[pooling_region_idx] = pr;
-
-					pooling_region_idx += 1;
-
 				}
 			}
+			for (int i = 0; i < depth; i++) {
+				dst[i] = dst[i] / count;
+			}
+			dst += depth;
+		} // loop pw (output w)
+	} // loop ph (output h)
+}
+
+static void roialign_f_work(struct nn_graph *nn, void *vinfo)
+{
+	struct roialign_f_runstate *rstp = (struct roialign_f_runstate *)vinfo;
+	int bufind;
+	int job;
+	struct roialign_axis_sample *tab = bufpool_take(&rstp->tabbufs, &bufind);
+	if (tab != NULL) {
+		while (job = __sync_fetch_and_add(&rstp->next_job, 1), job < rstp->n_rois) {
+			roialign_f_roi(rstp, job, tab);
 		}
+		bufpool_release(&rstp->tabbufs, bufind);
 	}
+	nn_sem_post(&rstp->done_sem);
 }
 
 static int check_roishape(struct nn_graph *nn, const struct tensor* tens, int logval) {
@@ -205,90 +213,51 @@ static int roialign_execute_f(struct nn_node *self, struct nn_graph *nn)
 		return errlog(nn, "roialign shape size too small");
 	}
 	out_pre_implode_shape->data_size = NUM_DIMS*sizeof(float);
-	const int32_t feat_height = feat_tensor->shape.height;
-	const int32_t feat_width = feat_tensor->shape.width;
-	const int32_t feat_depth = feat_tensor->shape.depth;
-
 	const int32_t pooled_height = pool_tensor->shape.height;
 	const int32_t pooled_width = pool_tensor->shape.width;
-	const int32_t pooled_depth = feat_depth;
-	// ** ceilf(int/int) has no effect **
-	const int32_t max_sampling_points = (sampling_ratio > 0) ? sampling_ratio * sampling_ratio : ceilf(feat_height/pooled_height) * ceilf(feat_width/pooled_width);
-	size_t data_size = feat_depth * sizeof(float);
-	//Allocate space for each corner, summed pooling values, and the maximum number of points that could be sampled during bilinear interpolation
-	size_t total_data_size = data_size * (NUM_CORNERS + feat_depth) + max_sampling_points * pooled_height * pooled_width * sizeof(struct pooling_region);
-	if(nn_scratch_grow(nn, total_data_size)) {
-		return errlog(nn, "Failed to get scratch");
-	}
-	int pooled_size = pooled_height * pooled_width * pooled_depth;
-	float *data1 = nn->scratch;
-	float *data2 = (float *) data1 + data_size;
-	float *data3 = (float *) data2 + data_size;
-	float *data4 = (float *) data3 + data_size;
-	float *output_vals= (float *) data4 + data_size;
-	struct pooling_region *pooling_regions = (struct pooling_region *)(output_vals + data_size);
-
-	for (int n = 0; n < out_batch; n++) {
-		int index_n = n * pooled_size;
-		uint32_t offset = n * rois_tensor->shape.depth;
-		float roi_start_w = tensor_get_float(rois_tensor, offset +1) * spatial_scale;
-		float roi_start_h = tensor_get_float(rois_tensor, offset +2) * spatial_scale;
-		float roi_end_w = tensor_get_float(rois_tensor, offset + 3) * spatial_scale;
-		float roi_end_h = tensor_get_float(rois_tensor, offset + 4) * spatial_scale;
-		float roi_height = (roi_end_h - roi_start_h > 1.0f) ? (roi_end_h - roi_start_h) : 1.0f;
-		float roi_width = (roi_end_w - roi_start_w > 1.0f) ? (roi_end_w - roi_start_w) : 1.0f;
-
-		// Divide the ROI into (pooled_height) x (pooled_width) cells, each cell is of size: (cell_size_h) x (cell_size_w)
-		const float cell_size_h = (float) roi_height / (float) pooled_height;
-		const float cell_size_w = (float) roi_width / (float) pooled_width;
-		int roi_bin_grid_h = (sampling_ratio > 0) ? sampling_ratio : ceilf(roi_height / pooled_height);
-		int roi_bin_grid_w = (sampling_ratio > 0) ? sampling_ratio : ceilf(roi_width / pooled_width);
-		const uint32_t count = roi_bin_grid_h * roi_bin_grid_w;
-		pre_calc_for_bilinear_interpolate_f(nn,
-				feat_height,
-				feat_width,
-				pooled_height,
-				pooled_width,
-				roi_start_h,
-				roi_start_w,
-				cell_size_h,
-				cell_size_w,
-				roi_bin_grid_h,
-				roi_bin_grid_w,
-				pooling_regions);
-		float *feat_data = feat_tensor->data;
-		float *dst = out_tensor->data;
-		int pooling_region_idx = 0;
-		for (int32_t ph = 0; ph < pooled_height; ++ph) {
-			for (int32_t pw = 0; pw < pooled_width; ++pw) {
-				memset(output_vals, 0, feat_depth * sizeof(float));
-				for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-					for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-						struct pooling_region pr = pooling_regions[pooling_region_idx];
-						memcpy(data1, feat_data + feat_depth * pr.corners[TOP_LEFT_CORNER_IDX], feat_depth * sizeof(float));
-						memcpy(data2, feat_data + feat_depth * pr.corners[TOP_RIGHT_CORNER_IDX], feat_depth * sizeof(float));
-						memcpy(data3, feat_data + feat_depth * pr.corners[BOTTOM_LEFT_CORNER_IDX], feat_depth * sizeof(float));
-						memcpy(data4, feat_data + feat_depth * pr.corners[BOTTOM_RIGHT_CORNER_IDX], feat_depth * sizeof(float));
 
-						for (int i = 0; i < feat_depth; i++) {
-
-							output_vals[i] += data1[i] * pr.corner_weights[TOP_LEFT_CORNER_IDX]
-											  + data2[i] * pr.corner_weights[TOP_RIGHT_CORNER_IDX]
-											  + data3[i] * pr.corner_weights[BOTTOM_LEFT_CORNER_IDX]
-											  + data4[i] * pr.corner_weights[BOTTOM_RIGHT_CORNER_IDX];
-						}
-						pooling_region_idx += 1;
-					}
-				}
-				for (int i = 0; i < feat_depth; i++) {
+	struct roialign_f_runstate rst;
+	rst.feat = (const float *)feat_tensor->data;
+	rst.out = (float *)out_tensor->data;
+	rst.rois_tensor = rois_tensor;
+	rst.feat_height = feat_tensor->shape.height;
+	rst.feat_width = feat_tensor->shape.width;
+	rst.depth = feat_tensor->shape.depth;
+	rst.pooled_height = pooled_height;
+	rst.pooled_width = pooled_width;
+	rst.spatial_scale = spatial_scale;
+	rst.sampling_ratio = sampling_ratio;
+	rst.n_rois = out_batch;
+	rst.next_job = 0;
 
-					output_vals[i] = output_vals[i] / count;
+	if (out_batch > 0 && pooled_height > 0 && pooled_width > 0 && rst.depth > 0) {
+		// size the axis tables for the ROI with the most samples
+		int max_tab = 0;
+		for (int n = 0; n < out_batch; n++) {
+			uint32_t offset = n * rois_tensor->shape.depth;
+			struct roialign_bins bins;
+			roialign_bins_setup(&bins,
+				tensor_get_float(rois_tensor, offset + 1) * spatial_scale,
+				tensor_get_float(rois_tensor, offset + 2) * spatial_scale,
+				tensor_get_float(rois_tensor, offset + 3) * spatial_scale,
+				tensor_get_float(rois_tensor, offset + 4) * spatial_scale,
+				pooled_height, pooled_width, sampling_ratio, sampling_ratio);
+			max_tab = max_i32(max_tab, pooled_height * bins.grid_h + pooled_width * bins.grid_w);
+		}
+		int n_threads = min_i32(NUM_THREADS, out_batch);
+		unsigned tab_size = ((unsigned)max_tab * sizeof(struct roialign_axis_sample) + 127) & ~127u;
+		nn_scratch_reset(nn);
+		if (nn_scratch_grow(nn, tab_size * n_threads + 128)) {
+			return errlog(nn, "Failed to get scratch");
+		}
+		void *mem = nn_scratch_alloc(nn, tab_size * n_threads);
+		if (mem == NULL) return errlog(nn, "didn't get temp mem");
+		bufpool_init(&rst.tabbufs, n_threads, mem, tab_size);
 
-				}
-				int index_nhw = index_n + (ph * pooled_width + pw) * pooled_depth;
-				memcpy(dst + index_nhw, output_vals, pooled_depth * sizeof(float));
-			} // loop pw (output w)
-		} // loop ph (output h)
+		nn_sem_init(&rst.done_sem, 0);
+		for (int i = 0; i < n_threads; i++)
+			nn_os_work_for_vector(nn, roialign_f_work, &rst);
+		nn_sem_wait_n_times(&rst.done_sem, n_threads);
 	}
 	tensor_set_shape(out_pre_implode_shape, 1, 1, 1, NUM_DIMS);
 	tensor_set_float(out_pre_implode_shape, 0, out_batch);
@@ -298,6 +267,22 @@ static int roialign_execute_f(struct nn_node *self, struct nn_graph *nn)
 	return 0;
 }
 
+// The axis tables, as roialign_execute_f; their size is only known before execute
+// when sampling_ratio is a Const > 0 (otherwise it follows the size of each roi).
+static int roialign_f_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct nn_node *pool_src = find_node_must_be_Const_from_ref(nn, &self->input_refs[OP_ROIALIGN_SIZE_DATA_IDX]);
+	struct nn_node *ratio_src = find_node_must_be_Const_from_ref(nn, &self->input_refs[OP_ROIALIGN_SAMPLING_RATIO_DATA_IDX]);
+	if (pool_src == NULL || ratio_src == NULL) return -1;
+	if (ratio_src->outputs[0]->data_size < sizeof(int32_t)) return -1;
+	int sampling_ratio = tensor_get_int32(ratio_src->outputs[0], 0);
+	if (sampling_ratio <= 0) return -1;
+	int max_tab = (pool_src->outputs[0]->shape.height + pool_src->outputs[0]->shape.width) * sampling_ratio;
+	unsigned tab_size = ((unsigned)max_tab * sizeof(struct roialign_axis_sample) + 127) & ~127u;
+	*bytes = tab_size * NUM_THREADS + 128;
+	return 0;
+}
+
 struct nn_node_ops nn_ops_for_RoiAlign_f = {
 		.execute = roialign_execute_f,
 		.check = NULL,
@@ -305,5 +290,6 @@ struct nn_node_ops nn_ops_for_RoiAlign_f = {
 		.dtor = node_free_common,
 		.n_inputs = NN_IOCOUNT(OP_ROIALIGN_NUM_INPUTS),
 		.n_outputs = NN_IOCOUNT(OP_ROIALIGN_NUM_OUTPUTS),
+		.scratch_hint = roialign_f_scratch_hint,
 };
 
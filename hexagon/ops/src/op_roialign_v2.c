@@ -45,6 +45,8 @@
 #include <math.h>
 #include <quantize.h>
 #include <hvx_inlines.h>
+#include <nn_bufferpool.h>
+#include <nn_roialign.h>
 #if defined(__hexagon__)
 #include <hexagon_types.h>
 #endif
@@ -94,8 +96,33 @@ struct tdata
 	const float spatial_w_scale;
 	const int sampling_h_ratio;
 	const int sampling_w_ratio;
+	struct buffer_pool tabbufs;	// per-thread axis tables, from roialign_v2_tabsize
 };
 
+// Each cell records at most grid+1 samples per axis (the stepping loop normally
+// gives exactly 'grid'; the extra one covers rounding in the loop compare).
+// A table buffer holds the y and x samples, then the y and x 'first' indices.
+static inline int roialign_v2_tabsize(const struct roialign_bins *bins, int pooled_h, int pooled_w, int *ntab)
+{
+	*ntab = pooled_h * (bins->grid_h + 1) + pooled_w * (bins->grid_w + 1);
+	return *ntab * sizeof(struct roialign_axis_sample) + (pooled_h + pooled_w + 2) * sizeof(int);
+}
+
+static inline void roialign_v2_get_bins(const struct tensor *rois_tensor, int n,
+                                        float spatial_h_scale, float spatial_w_scale,
+                                        int pooled_h, int pooled_w, int sampling_h_ratio, int sampling_w_ratio,
+                                        struct roialign_bins *bins)
+{
+	uint32_t offset = n * rois_tensor->shape.depth;
+	const uint16_t *rois = (const uint16_t *)rois_tensor->data + offset;
+	roialign_bins_setup(bins,
+		(float)rois[0] * spatial_w_scale * 0.125f,
+		(float)rois[1] * spatial_h_scale * 0.125f,
+		(float)rois[2] * spatial_w_scale * 0.125f,
+		(float)rois[3] * spatial_h_scale * 0.125f,
+		pooled_h, pooled_w, sampling_h_ratio, sampling_w_ratio);
+}
+
 static int check_roishape(struct nn_graph *nn, const struct tensor *tens, int logval)
 {
 	int res = 0;
@@ -131,7 +158,8 @@ static void doRoiAlignBatch_hvx(struct nn_graph *nn, const int n_rois, const int
 								float spatial_h_scale,
 								float spatial_w_scale,
 								int sampling_h_ratio,
-								int sampling_w_ratio)
+								int sampling_w_ratio,
+								void *tabbuf)
 {
 	uint8_t *out_data = out_tensor->data;
 	uint8_t *feat_data = feat_tensor->data;
@@ -166,18 +194,24 @@ static void doRoiAlignBatch_hvx(struct nn_graph *nn, const int n_rois, const int
 				return;
 			}
 
-			float roi_height = (roi_end_h - roi_start_h > 1.0) ? (roi_end_h - roi_start_h) : 1.0;
-			float roi_width = (roi_end_w - roi_start_w > 1.0) ? (roi_end_w - roi_start_w) : 1.0;
-
-			// Divide the ROI into (pooled_height) x (pooled_width) cells, each cell is of size: (cell_size_h) x (cell_size_w)
-			const float cell_size_h = (float)roi_height / ((float)pooled_height);
-			const float cell_size_w = (float)roi_width / ((float)pooled_width);
-			int roi_bin_grid_h = (sampling_h_ratio > 0) ? sampling_h_ratio : (int)ceilf(roi_height / pooled_height);
-			int roi_bin_grid_w = (sampling_w_ratio > 0) ? sampling_w_ratio : (int)ceilf(roi_width / pooled_width);
-
+			struct roialign_bins bins;
+			roialign_bins_setup(&bins, roi_start_w, roi_start_h, roi_end_w, roi_end_h,
+			                    pooled_height, pooled_width, sampling_h_ratio, sampling_w_ratio);
+			int roi_bin_grid_h = bins.grid_h;
+			int roi_bin_grid_w = bins.grid_w;
 			uint32_t count = roi_bin_grid_h * roi_bin_grid_w;
-			float wBinSize = cell_size_w / roi_bin_grid_w;
-			float hBinSize = cell_size_h / roi_bin_grid_h;
+
+			// sample positions along each axis; only their pairing is done per sample
+			int ntab;
+			roialign_v2_tabsize(&bins, pooled_height, pooled_width, &ntab);
+			struct roialign_axis_sample *ytab = (struct roialign_axis_sample *)tabbuf;
+			struct roialign_axis_sample *xtab = ytab + pooled_height * (roi_bin_grid_h + 1);
+			int *yfirst = (int *)(ytab + ntab);
+			int *xfirst = yfirst + pooled_height + 1;
+			roialign_axis_table_stepped(ytab, yfirst, feat_height, pooled_height, roi_bin_grid_h, roi_bin_grid_h + 1,
+			                            bins.start_h, bins.cell_h);
+			roialign_axis_table_stepped(xtab, xfirst, feat_width, pooled_width, roi_bin_grid_w, roi_bin_grid_w + 1,
+			                            bins.start_w, bins.cell_w);
 
 			float realMultiplier = fminf(0.99999, (feat_scale * wScale / out_scale / (float)count));
 			int32_t outputMultiplier = 0;
@@ -195,34 +229,19 @@ static void doRoiAlignBatch_hvx(struct nn_graph *nn, const int n_rois, const int
 			{
 				for (int pw = 0; pw < pooled_width; pw++)
 				{
-					float wStart = cell_size_w * pw + roi_start_w;
-					float wEnd = cell_size_w * (pw + 1) + roi_start_w;
-					float hStart = cell_size_h * ph + roi_start_h;
-					float hEnd = cell_size_h * (ph + 1) + roi_start_h;
 					int32_t outTemp[outTemp_size];
 					vmemset_asm(outTemp, 0, outTemp_size * sizeof(int32_t));
 
-					for (float y = hStart + hBinSize / 2; y < hEnd; y += hBinSize)
+					for (int iy = yfirst[ph]; iy < yfirst[ph + 1]; iy++)
 					{
-						for (float x = wStart + wBinSize / 2; x < wEnd; x += wBinSize)
+						for (int ix = xfirst[pw]; ix < xfirst[pw + 1]; ix++)
 						{
-
-							uint32_t x1 = floorf(x);
-							uint32_t y1 = floorf(y);
-							uint32_t x2 = x1 + 1;
-							uint32_t y2 = y1 + 1;
-							float dx1 = x - x1;
-							float dy1 = y - y1;
-							if (y1 >= feat_height - 1)
-							{
-								y1 = y2 = feat_height - 1;
-								dy1 = 0;
-							}
-							if (x1 >= feat_width - 1)
-							{
-								x1 = x2 = feat_width - 1;
-								dx1 = 0;
-							}
+							uint32_t y1 = ytab[iy].lo;
+							uint32_t y2 = ytab[iy].hi;
+							float dy1 = ytab[iy].frac;
+							uint32_t x1 = xtab[ix].lo;
+							uint32_t x2 = xtab[ix].hi;
+							float dx1 = xtab[ix].frac;
 							float dx2 = 1.0f - dx1;
 							float dy2 = 1.0f - dy1;
 
@@ -366,11 +385,18 @@ static void doRoiAlignBatch_hvx(struct nn_graph *nn, const int n_rois, const int
 static void roialign_execute_slice_hvx(struct nn_graph *nn, void *vinfo)
 {
 	struct tdata *info = vinfo;
+	int bufind;
+	void *tabbuf = bufpool_take(&info->tabbufs, &bufind);
+	if (tabbuf == NULL) {
+		nn_sem_post(&info->donesem);
+		return;
+	}
 	doRoiAlignBatch_hvx(nn, info->total_num_rois, info->total_num_jobs, info->rois_per_job, &(info->cur_unit),
 						info->feat_tensor, info->feat_offset, info->feat_scale,
 						info->rois_tensor, info->batch_indices_tensor, info->out_tensor, info->output_offset,
 						info->output_scale, info->pooled_height, info->pooled_width,
-						info->spatial_h_scale, info->spatial_w_scale, info->sampling_h_ratio, info->sampling_w_ratio);
+						info->spatial_h_scale, info->spatial_w_scale, info->sampling_h_ratio, info->sampling_w_ratio, tabbuf);
+	bufpool_release(&info->tabbufs, bufind);
 	nn_sem_post(&info->donesem);
 }
 
@@ -452,12 +478,33 @@ static int roialign_execute(struct nn_node *self, struct nn_graph *nn)
 		.sampling_w_ratio = sampling_w_ratio,
 	};
 
-	nn_sem_init(&worker0_info.donesem, 0);
-	for (int32_t tid = 0; tid < n_threads; tid++)
+	if (n_threads > 0)
 	{
-		nn_os_work_for_vector(nn, roialign_execute_slice_hvx, &worker0_info);
+		int max_tabsize = 0;
+		for (int n = 0; n < num_rois; n++)
+		{
+			struct roialign_bins bins;
+			int ntab;
+			roialign_v2_get_bins(rois_tensor, n, spatial_h_scale, spatial_w_scale,
+			                     pooled_h, pooled_w, sampling_h_ratio, sampling_w_ratio, &bins);
+			max_tabsize = max_i32(max_tabsize, roialign_v2_tabsize(&bins, pooled_h, pooled_w, &ntab));
+		}
+		unsigned tabbuf_size = (max_tabsize + 127) & ~127u;
+		nn_scratch_reset(nn);
+		if (nn_scratch_grow(nn, tabbuf_size * n_threads + 128))
+			return errlog(nn, "Failed to get scratch");
+		void *mem = nn_scratch_alloc(nn, tabbuf_size * n_threads);
+		if (mem == NULL)
+			return errlog(nn, "didn't get temp mem");
+		bufpool_init(&worker0_info.tabbufs, n_threads, mem, tabbuf_size);
+
+		nn_sem_init(&worker0_info.donesem, 0);
+		for (int32_t tid = 0; tid < n_threads; tid++)
+		{
+			nn_os_work_for_vector(nn, roialign_execute_slice_hvx, &worker0_info);
+		}
+		nn_sem_wait_n_times(&worker0_info.donesem, n_threads);
 	}
-	nn_sem_wait_n_times(&worker0_info.donesem, n_threads);
 
 	tensor_copy(out_min_tensor, output_exp_min_tensor);
 	tensor_copy(out_max_tensor, output_exp_max_tensor);
@@ -465,6 +512,31 @@ static int roialign_execute(struct nn_node *self, struct nn_graph *nn)
 	return 0;
 }
 
+// The table buffers, as roialign_execute, for the most samples per cell: the
+// sampling ratio if it's > 0, otherwise what the largest roi (16-bit coords) can give.
+// Inputs 5..10 (pooled sizes, scales, sampling ratios) must be Const.
+static int roialign_v2_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *parms[6];
+	for (int i = 0; i < 6; i++) {
+		struct nn_node *src = find_node_must_be_Const_from_ref(nn, &self->input_refs[5 + i]);
+		if (src == NULL || src->outputs[0]->data_size < sizeof(int32_t)) return -1;
+		parms[i] = src->outputs[0];
+	}
+	const int pooled_h = tensor_get_int32(parms[0], 0);
+	const int pooled_w = tensor_get_int32(parms[1], 0);
+	const float max_roi_h = 65535.0f * fabsf(tensor_get_float(parms[2], 0)) * 0.125f;
+	const float max_roi_w = 65535.0f * fabsf(tensor_get_float(parms[3], 0)) * 0.125f;
+	if (pooled_h <= 0 || pooled_w <= 0) return -1;
+	struct roialign_bins bins;
+	int ntab;
+	roialign_bins_setup(&bins, 0.0f, 0.0f, max_roi_w, max_roi_h, pooled_h, pooled_w,
+		tensor_get_int32(parms[4], 0), tensor_get_int32(parms[5], 0));
+	unsigned tabbuf_size = (roialign_v2_tabsize(&bins, pooled_h, pooled_w, &ntab) + 127) & ~127u;
+	*bytes = tabbuf_size * NUM_MAX_THREADS + 128;
+	return 0;
+}
+
 struct nn_node_ops nn_ops_for_QuantizedRoiAlignV2_8 = {
 	.execute = roialign_execute,
 	.check = NULL,
@@ -472,4 +544,5 @@ struct nn_node_ops nn_ops_for_QuantizedRoiAlignV2_8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(OP_ROIALIGN_NUM_INPUTS),
 	.n_outputs = NN_IOCOUNT(OP_ROIALIGN_NUM_OUTPUTS),
+	.scratch_hint = roialign_v2_scratch_hint,
 };
@@ -240,6 +240,13 @@ static int slice_prepare(struct nn_node *self, struct nn_graph *nn, int element_
 	b_size = layout[3].siz;
 	b_in_stride = layout[3].in_stride * element_size;
 
+	// the allocator may have made the output a view of the input (see slice_alias_hint);
+	// then it must be a prefix of it, and there's nothing to copy.
+	if( out == (char const*)input_tensor->data){
+		if( indata_offset != 0 || w_size*h_size*b_size != 1)
+			return errlog(nn,"slice output is placed over the input, but is not a prefix of it");
+	}
+
 	// w_size * d_size is handled by 2d-memcpy, so this is the
 	// # of 2d-memcpys we need.
 	//
@@ -366,6 +373,7 @@ static int slice_run(struct nn_node *self, struct nn_graph *nn) {
 	}
 	int num_threads = thrinfo[0].num_threads;
 	uint8_t const * in = self->inputs[0]->data;
+	if( (void*)in == self->outputs[0]->data) return 0;	// output is a view
 	for(int i = 0; i < num_threads; i++) {
 		nn_sem_init(&thrinfo[i].done_sem, 0);
 		thrinfo[i].input_tensor_base = in;
@@ -394,6 +402,7 @@ static int slice_run_f(struct nn_node *self, struct nn_graph *nn) {
 	}
 	int num_threads = thrinfo[0].num_threads;
 	uint8_t const * in = self->inputs[0]->data;
+	if( (void*)in == self->outputs[0]->data) return 0;	// output is a view
 	for(int i = 0; i < num_threads; i++) {
 		nn_sem_init(&thrinfo[i].done_sem, 0);
 		thrinfo[i].input_tensor_base = in;
@@ -406,6 +415,44 @@ static int slice_run_f(struct nn_node *self, struct nn_graph *nn) {
 	return 0;
 }
 
+//
+// If the slice starts at 0 in all dimensions, and takes all of each dimension inside the outermost
+// one it cuts (and 1 of those outside it), the output is the start of the input: it can be a view.
+// Sizes are checked against the input's max sizes; if they turn out not to be the actual ones,
+// slice_prepare will find that the slice doesn't fit (as it would anyway).
+//
+static int slice_alias_hint(struct nn_node *self, struct nn_graph *nn, int out_idx, struct nn_alias_hint *hint)
+{
+	if( out_idx != 0 ) return -1;
+	struct nn_node * src = find_node(nn, self->input_refs[0].src_id);
+	struct nn_node * start_node = find_node(nn, self->input_refs[1].src_id);
+	struct nn_node * size_node = find_node(nn, self->input_refs[2].src_id);
+	if( src == NULL || start_node == NULL || size_node == NULL
+		|| start_node->node_type != OP_Const || size_node->node_type != OP_Const) return -1;
+	const struct tensor *start_tensor = self->inputs[1];
+	const struct tensor *size_tensor = self->inputs[2];
+	int nspec = start_tensor->shape.depth;
+	if( nspec < 1 || nspec > 4 || !shape_matches( &start_tensor->shape, &size_tensor->shape)) return -1;
+	uint32_t const * in_dims = src->output_defs[self->input_refs[0].output_idx].max_sizes;
+
+	int cut = 0;		// set once we are outside the dimension which is cut
+	for( int j = 3; j >= 0; j--){
+		int k = j - (4-nspec);
+		int start = (k < 0)? 0: tensor_get_int32( start_tensor, k);
+		int size = (k < 0)? -1: tensor_get_int32( size_tensor, k);
+		if( start != 0 ) return -1;
+		if( !cut ){
+			if( size != -1 && size != (int)in_dims[j]) cut = 1;
+		}else{
+			if( size != 1 && !(size == -1 && in_dims[j] == 1)) return -1;
+		}
+	}
+	hint->kind = NN_ALIAS_VIEW;
+	hint->in_idx = 0;
+	hint->offset = 0;
+	return 0;
+}
+
 static int slice_dtor(struct nn_node *self, struct nn_graph *nn) {
 	if(self->opaque != NULL) {
 		nn_free(self->opaque);
@@ -441,6 +488,7 @@ struct nn_node_ops nn_ops_for_Slice_f = {
 	.dtor = slice_dtor,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(1),
+	.alias_hint = slice_alias_hint,
 	.earlywork_note_pred = prepare_work_f,
 };
 
@@ -451,6 +499,7 @@ struct nn_node_ops nn_ops_for_Slice_8 = {
 	.dtor = slice_dtor,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(1),
+	.alias_hint = slice_alias_hint,
 	.earlywork_note_pred = prepare_work_8,
 };
 
@@ -461,6 +510,7 @@ struct nn_node_ops nn_ops_for_Slice_int32 = {
 	.dtor = slice_dtor,
 	.n_inputs = NN_IOCOUNT(3),
 	.n_outputs = NN_IOCOUNT(1),
+	.alias_hint = slice_alias_hint,
 	.earlywork_note_pred = prepare_work_int32,
 };
 
@@ -471,6 +521,7 @@ struct nn_node_ops nn_ops_for_QuantizedSlice_8 = {
 	.dtor = slice_dtor,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.alias_hint = slice_alias_hint,
 	.earlywork_note_pred = prepare_work_q8,
 };
 
@@ -482,6 +533,7 @@ struct nn_node_ops nn_ops_for_QuantizedSlice_16 = {
 	.dtor = slice_dtor,
 	.n_inputs = NN_IOCOUNT(5),
 	.n_outputs = NN_IOCOUNT(3),
+	.alias_hint = slice_alias_hint,
 	.earlywork_note_pred = prepare_work_q16,
 };
 
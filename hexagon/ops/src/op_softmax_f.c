@@ -37,6 +37,9 @@
 #include <string.h>
 #include <math.h>
 #include <quantize.h>
+#include "float_mathops.h"
+#include "nn_bufferpool.h"
+#include "nn_topk.h"
 
 /*
  * 
@@ -46,45 +49,170 @@
  */
 
 
-static inline int softmax_execute(struct nn_node *self, struct nn_graph *nn)
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+// rows are handed out to the threads in chunks of about this many elements
+#define SOFTMAX_F_JOB_ELEMENTS 16384
+
+struct softmax_f_runstate {
+	const float *in;
+	float *out;
+	int32_t *out_idx;		// index output, for top-k mode only
+	int depth;
+	int k;				// # of outputs per row in top-k mode; 0 for full softmax
+	float beta;
+	int rows;
+	int rows_per_job;
+	int jobs;
+	volatile int next_job;
+	struct buffer_pool bufs;	// work space for nn_topk_f_row, in top-k mode
+	nn_sem_t done_sem;
+};
+
+// work space for one thread's nn_topk_f_row
+static inline unsigned softmax_f_topk_work_size(int depth, int k)
+{
+	return ((unsigned)nn_topk_f_work_elems(depth, k) * sizeof(struct nn_topk_elem) + 127) & ~127u;
+}
+
+static void softmax_f_row(const float *in, float *out, int depth, float beta)
+{
+	float maxval = float_row_max(in, depth);
+	float sum_recip = 1.0f / float_row_sum_exp(in, out, depth, beta, maxval);
+	for (int i = 0; i < depth; i++) {
+		out[i] *= sum_recip;
+	}
+}
+
+// Top-k of a softmax row: only the k largest values are written, in descending order,
+// along with their indices. With beta > 0 these are the top k of the input, which
+// nn_topk_f_row finds (so equal values are ordered by index descending, as TopK_f does).
+static void softmax_f_row_topk(const float *in, float *out, int32_t *out_idx, int depth, int k, float beta,
+	struct nn_topk_elem *work)
+{
+	float maxval = float_row_max(in, depth);
+	float sum_recip = 1.0f / float_row_sum_exp(in, NULL, depth, beta, maxval);
+	nn_topk_f_row(in, depth, k, out, out_idx, work);
+	for (int j = 0; j < k; j++) {
+		out[j] = fast_expf_poly(beta * (out[j] - maxval)) * sum_recip;
+	}
+}
+
+static void softmax_f_work(struct nn_graph *nn, void *vrstp)
+{
+	struct softmax_f_runstate *rstp = (struct softmax_f_runstate *)vrstp;
+	int depth = rstp->depth;
+	int k = rstp->k;
+	int bufind = -1;
+	int job;
+	struct nn_topk_elem *work = NULL;
+	if (k > 0 && (work = bufpool_take(&rstp->bufs, &bufind)) == NULL) {
+		nn_sem_post(&rstp->done_sem);
+		return;
+	}
+	while (job = __sync_fetch_and_add(&rstp->next_job, 1), job < rstp->jobs) {
+		int row0 = job * rstp->rows_per_job;
+		int row1 = min_i32(row0 + rstp->rows_per_job, rstp->rows);
+		const float *in = rstp->in + (size_t)row0 * depth;
+		if (k == 0) {
+			float *out = rstp->out + (size_t)row0 * depth;
+			for (int r = row0; r < row1; r++, in += depth, out += depth) {
+				softmax_f_row(in, out, depth, rstp->beta);
+			}
+		} else {
+			float *out = rstp->out + (size_t)row0 * k;
+			int32_t *out_idx = rstp->out_idx + (size_t)row0 * k;
+			for (int r = row0; r < row1; r++, in += depth, out += k, out_idx += k) {
+				softmax_f_row_topk(in, out, out_idx, depth, k, rstp->beta, work);
+			}
+		}
+	}
+	if (work != NULL) bufpool_release(&rstp->bufs, bufind);
+	nn_sem_post(&rstp->done_sem);
+}
+
+//
+// inputs: data, [beta], [k]
+// outputs: data, [indices]
+// When k is given and 0 < k < depth, only the k largest probabilities of each row
+// are output (in descending order), with their depth indices in the second output;
+// beta must then be > 0.
+// This avoids writing (and later scanning) the full output for very large depth.
+//
+static int softmax_execute(struct nn_node *self, struct nn_graph *nn)
 {
-	int i;
-	int j;
 	const struct tensor *in_tensor = self->inputs[0];
 	struct tensor *out_tensor = self->outputs[0];
+	struct shape outshape = in_tensor->shape;
 	int depth = in_tensor->shape.depth;
-	int batches = in_tensor->shape.batches;
-	int height = in_tensor->shape.height;
-	int width = in_tensor->shape.width;
+	int rows = in_tensor->shape.batches * in_tensor->shape.height * in_tensor->shape.width;
 	float beta = (self->n_inputs < 2) ? 1.0f : tensor_get_float(self->inputs[1],0);
-	const float *data = in_tensor->data;
-	float *out = out_tensor->data;
-	float maxval;
-	float sum;
-	float sum_recip;
+	int k = (self->n_inputs < 3) ? 0 : tensor_get_int32(self->inputs[2],0);
+	struct softmax_f_runstate rst;
 
-	if( tensor_out_prepare_normal_fromshape( out_tensor, &in_tensor->shape, NN_TYPE_FLOAT)!= 0){
+	if (k <= 0 || k >= depth) {
+		if (self->n_outputs > 1) return errlog(nn,"index output needs 0 < k < depth");
+		k = 0;
+	} else if (self->n_outputs < 2) {
+		return errlog(nn,"top-k softmax needs an index output");
+	} else if (!(beta > 0.0f)) {
+		return errlog(nn,"top-k softmax needs beta > 0");
+	}
+	if (k > 0) outshape.depth = k;
+	if( tensor_out_prepare_normal_fromshape( out_tensor, &outshape, NN_TYPE_FLOAT)!= 0){
 		return errlog(nn,"out too small");
 	}
-	for (j = 0; j < batches*height*width; j++) {
-		sum = 0.0f;
-		maxval = data[0];
-		for (i = 0; i < depth; i++) {
-			maxval = fmaxf(data[i],maxval);
-		}
-		for (i = 0; i < depth; i++) {
-			sum += (out[i] = expf(beta*(data[i] - maxval)));
-		}
-		sum_recip = 1.0f/sum;
-		for (i = 0; i < depth; i++) {
-			out[i] *= sum_recip;
+	if (k > 0 && tensor_out_prepare_normal_fromshape(self->outputs[1], &outshape, NN_TYPE_INT32) != 0) {
+		return errlog(nn,"index out too small");
+	}
+	if (rows == 0 || depth == 0) return 0;
+
+	rst.in = in_tensor->data;
+	rst.out = out_tensor->data;
+	rst.out_idx = (k > 0) ? self->outputs[1]->data : NULL;
+	rst.depth = depth;
+	rst.k = k;
+	rst.beta = beta;
+	rst.rows = rows;
+	rst.rows_per_job = max_i32(1, SOFTMAX_F_JOB_ELEMENTS / depth);
+	rst.jobs = (rows + rst.rows_per_job - 1) / rst.rows_per_job;
+	rst.next_job = 0;
+
+	int nthreads = min_i32(NUM_THREADS, rst.jobs);
+	if (k > 0) {
+		unsigned work_size = softmax_f_topk_work_size(depth, k);
+		nn_scratch_reset(nn);
+		if (nn_scratch_grow(nn, work_size * nthreads + 128)) {
+			return errlog(nn,"scratch too small");
 		}
-		out += depth;
-		data += depth;
+		void *mem = nn_scratch_alloc(nn, work_size * nthreads);
+		if (mem == NULL) return errlog(nn,"didn't get temp mem");
+		bufpool_init(&rst.bufs, nthreads, mem, work_size);
+	}
+	nn_sem_init(&rst.done_sem, 0);
+	for (int i = 0; i < nthreads; i++) {
+		nn_os_work_for_vector(nn, softmax_f_work, &rst);
 	}
+	nn_sem_wait_n_times(&rst.done_sem, nthreads);
 	return 0;
 }
 
+// Scratch is only used in top-k mode, which needs k at prepare to be sized.
+static int softmax_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	*bytes = 0;
+	if (self->n_inputs < 3) return 0;
+	struct nn_node *src = find_node(nn, self->input_refs[0].src_id);
+	if (src == NULL || self->inputs[2]->data_size < sizeof(int32_t)) return -1;
+	int depth = src->output_defs[self->input_refs[0].output_idx].max_sizes[3];
+	int k = tensor_get_int32(self->inputs[2],0);
+	if (k > 0 && k < depth) *bytes = softmax_f_topk_work_size(depth, k) * NUM_THREADS + 128;
+	return 0;
+}
 
 static inline int softmax_execute_uint8(struct nn_node *self, struct nn_graph *nn)
 {
@@ -176,8 +304,9 @@ struct nn_node_ops nn_ops_for_Softmax_f = {
 	.check = NULL,
 	.ctor = node_alloc_common,
 	.dtor = node_free_common,
-	.n_inputs = NN_IOCOUNT_RANGE(1,2),
-	.n_outputs = NN_IOCOUNT(1),
+	.n_inputs = NN_IOCOUNT_RANGE(1,3),
+	.n_outputs = NN_IOCOUNT_RANGE(1,2),
+	.scratch_hint = softmax_scratch_hint,
 };
 
 
@@ -41,6 +41,7 @@
 
 #include "float_mathops.h"
 #include "nn_pqueue.h"
+#include "nn_nms.h"
 #include "hvx_inlines.h"
 #if defined(__hexagon__)
 #include "hexagon_types.h"
@@ -143,6 +144,7 @@ struct nms_info
     uint32_t nms_top_k;
     uint8_t score_threshold;
     struct bbox_record_ref *filtered_indices;
+    struct nn_nms_keepset *keepsets;    // per thread; the boxes kept in the current class
     volatile unsigned current_class;
     volatile unsigned thr_id;
     nn_sem_t donesem;
@@ -267,28 +269,6 @@ static inline void __attribute__((always_inline)) decode_bbox_corner_size(struct
     decode_bbox->ymax = prior_box.ymax + prior_variances.c4 * bb.ymax * prior_height;
 }
 
-static inline float compute_jaccard_overlap(struct bbox b1, struct bbox b2)
-{
-    if (b2.xmin > b1.xmax || b2.xmax < b1.xmin ||
-        b2.ymin > b1.ymax || b2.ymax < b1.ymin)
-        return 0.0f;
-    else
-    {
-        float intersect_box_xmin = fmaxf(b1.xmin, b2.xmin);
-        float intersect_box_ymin = fmaxf(b1.ymin, b2.ymin);
-        float intersect_box_xmax = fminf(b1.xmax, b2.xmax);
-        float intersect_box_ymax = fminf(b1.ymax, b2.ymax);
-        float intersect_width = intersect_box_xmax - intersect_box_xmin;
-        float intersect_height = intersect_box_ymax - intersect_box_ymin;
-        if (intersect_height > 0 && intersect_width > 0)
-        {
-            float intersect_size = intersect_height * intersect_width;
-            return intersect_size / (b1.size + b2.size - intersect_size);
-        }
-        return 0.0f;
-    }
-}
-
 #if defined(HEXAGON_V65) || defined(HEXAGON_V66)
 static inline int __attribute__((unused, always_inline)) get_top_k_score_idx_hvx(struct nn_graph *nn, uint32_t *scores, struct nn_pqueue *pqueue, const uint32_t scores_size, const uint8_t score_threshold, void *vtcm_addr)
 {
@@ -360,71 +340,67 @@ static void apply_nms_fast(struct nn_graph *nn, void *nms_info)
     uint8_t score_threshold = info->score_threshold;
     uint8_t min_score = 255;
     struct bbox_record_ref *filtered_indices = info->filtered_indices;
-    unsigned chunk = num_classes / NUM_THREADS;
     unsigned thr_id = __sync_fetch_and_add(&info->thr_id, 1);
     struct nn_pqueue *score_pqueue = &info->score_pqueues[thr_id];
     struct nn_pqueue *output_pqueue = &info->output_pqueues[thr_id];
+    struct nn_nms_keepset *keepset = &info->keepsets[thr_id];
+    const struct nn_nms_params nms_params = {
+        .iou_threshold = nms_threshold,
+        .coord_offset = 0.0f,
+        .suppress_at_equal = 0,
+        .disjoint_is_zero = 0,
+    };
     //Hvx vtcm based score validation currently unsued
     void *thr_vtcm = (void *)((uint32_t)nn->vtcm_ptr + thr_id * THREAD_USED_VTCM_SIZE);
     (void) thr_vtcm;
-    unsigned class_cnt;
-    while ((class_cnt = __sync_fetch_and_add(&info->current_class, chunk)), class_cnt < num_classes)
+    unsigned c;
+    // one class per job
+    while ((c = __sync_fetch_and_add(&info->current_class, 1)), c < num_classes)
     {
-        for (uint32_t c = 0; c < min_i32(chunk, num_classes - class_cnt); c++)
+        struct bbox_record_ref *filtered_indices_ptr = &filtered_indices[c * output_pqueue->capacity];
+        if (c == background_label_id)
+            continue;
+        uint32_t box_offset = share_location ? 0 : c;
+        uint32_t *scores = bbox_records[num * num_classes + c].scores;
+        struct bbox *bb = bbox_records[num * num_classes + box_offset].bboxes;
+        int i = 0;
+        uint32_t num_valid_scores = 0;
+        // TODO Debug the hvx version
+        //#if defined(HEXAGON_V65) || defined(HEXAGON_V66)
+        //num_valid_scores = get_top_k_score_idx_hvx(nn, scores, score_pqueue, num_scores, score_threshold, thr_vtcm);
+        //#else
+        num_valid_scores = get_top_k_score_idx(nn, scores, score_pqueue, num_scores, score_threshold);
+        //#endif
+        float adaptive_threshold = nms_threshold;
+        keepset->n = 0;
+        for (int j = 0; j < num_valid_scores; j++)
         {
-            struct bbox_record_ref *filtered_indices_ptr = &filtered_indices[(class_cnt + c) * output_pqueue->capacity];
-            if (c + class_cnt == background_label_id)
+            uint32_t score_idx = *(uint32_t *)nn_pqueue_dequeue(nn, score_pqueue);
+            uint32_t idx = score_idx & 0xFFFFFF;
+            uint8_t score = score_idx >> 24;
+            if (output_pqueue->size >= output_pqueue->capacity && score < min_score)
                 continue;
-            uint32_t box_offset = share_location ? 0 : class_cnt + c;
-            uint32_t *scores = bbox_records[num * num_classes + class_cnt + c].scores;
-            struct bbox *bb = bbox_records[num * num_classes + box_offset].bboxes;
-            int i = 0;
-            uint32_t num_valid_scores = 0;
-            // TODO Debug the hvx version
-            //#if defined(HEXAGON_V65) || defined(HEXAGON_V66)
-            //num_valid_scores = get_top_k_score_idx_hvx(nn, scores, score_pqueue, num_scores, score_threshold, thr_vtcm);
-            //#else
-            num_valid_scores = get_top_k_score_idx(nn, scores, score_pqueue, num_scores, score_threshold);
-            //#endif
-            float adaptive_threshold = nms_threshold;
-            for (int j = 0; j < num_valid_scores; j++)
+            const struct bbox *cand = &bb[idx];
+            int keep = !nn_nms_keepset_overlaps(keepset, &nms_params, adaptive_threshold,
+                                                cand->xmin, cand->ymin, cand->xmax, cand->ymax, cand->size);
+            if (keep)
             {
-                int keep = 1;
-                uint32_t score_idx = *(uint32_t *)nn_pqueue_dequeue(nn, score_pqueue);
-                uint32_t idx = score_idx & 0xFFFFFF;
-                uint8_t score = score_idx >> 24;
-                if (output_pqueue->size >= output_pqueue->capacity && score < min_score)
-                    continue;
-                for (int k = 0; k < i; k++)
-                {
-                    if (keep)
-                    {
-                        const int kept_idx = filtered_indices_ptr[k].idx;
-                        float overlap = compute_jaccard_overlap(bb[idx], bb[kept_idx]);
-                        keep = overlap <= adaptive_threshold;
-                    }
-                    else
-                        break;
+                if(i < output_pqueue->capacity && nn_nms_keepset_add(keepset, cand->xmin, cand->ymin, cand->xmax, cand->ymax, cand->size) == 0) {
+                    filtered_indices_ptr[i].batch = num;
+                    filtered_indices_ptr[i].class = c;
+                    filtered_indices_ptr[i].idx = idx;
+                    filtered_indices_ptr[i].score = score;
+                    nn_pqueue_enqueue(nn, output_pqueue, (void *)&filtered_indices_ptr[i]);
+                    min_score = ((struct bbox_record_ref *)(output_pqueue->data[output_pqueue->size - 1]))->score;
+                    i++;
+                } else { /* reach the limit of keep_top_k */
+                    break;
                 }
-                if (keep)
-                {
-                    if(i < output_pqueue->capacity) {
-                        filtered_indices_ptr[i].batch = num;
-                        filtered_indices_ptr[i].class = class_cnt + c;
-                        filtered_indices_ptr[i].idx = idx;
-                        filtered_indices_ptr[i].score = score;
-                        nn_pqueue_enqueue(nn, output_pqueue, (void *)&filtered_indices_ptr[i]);
-                        min_score = ((struct bbox_record_ref *)(output_pqueue->data[output_pqueue->size - 1]))->score;
-                        i++;
-                    } else { /* reach the limit of keep_top_k */
-                        break;
-                    }
-                }
-                if (keep && eta < 1 && adaptive_threshold > 0.5)
-                    adaptive_threshold *= eta;
             }
-            nn_pqueue_vclear(nn, score_pqueue);
+            if (keep && eta < 1 && adaptive_threshold > 0.5)
+                adaptive_threshold *= eta;
         }
+        nn_pqueue_vclear(nn, score_pqueue);
     }
     nn_sem_post(&info->donesem);
 }
@@ -615,7 +591,10 @@ static int ssd_detection_out_execute(struct nn_node *self, struct nn_graph *nn)
     size_t filtered_indices_size = ALIGN128((size_t)num_classes * keep_top_k * sizeof(struct bbox_record_ref));
     size_t output_pqueue_size = ALIGN128((size_t)n_nms_threads * keep_top_k * sizeof(struct bbox_record_ref*));
     size_t final_output_size = ALIGN128((size_t)keep_top_k * sizeof(struct bbox_record_ref*));
-    size_t required_scratch =  dequatized_loc_size + bbox_record_size + filtered_scores_size + filtered_indices_size + output_pqueue_size + final_output_size;
+    // a class can't keep more than it has candidates
+    int keepset_cap = (keep_top_k >= 0 && keep_top_k < nms_top_k) ? keep_top_k : nms_top_k;
+    size_t keepsets_size = (size_t)n_nms_threads * ALIGN128(nn_nms_keepset_bytes(keepset_cap));
+    size_t required_scratch =  dequatized_loc_size + bbox_record_size + filtered_scores_size + filtered_indices_size + output_pqueue_size + final_output_size + keepsets_size;
     if (nn->scratch_size < required_scratch)
     {
         if (nn_scratch_grow(nn, required_scratch))
@@ -632,6 +611,9 @@ static int ssd_detection_out_execute(struct nn_node *self, struct nn_graph *nn)
     struct bbox_record_ref *filtered_indices = (struct bbox_record_ref *)nn_scratch_alloc(nn, num_classes * keep_top_k * sizeof(struct bbox_record_ref));
     struct bbox_record_ref* *output_pqueue_mem = (struct bbox_record_ref* *)nn_scratch_alloc(nn, n_nms_threads * keep_top_k * sizeof(struct bbox_record_ref*));
     struct bbox_record_ref* *final_output_pqueue = (struct bbox_record_ref* *)nn_scratch_alloc(nn, keep_top_k * sizeof(struct bbox_record_ref*));
+    struct nn_nms_keepset keepsets[n_nms_threads];
+    for (int i = 0; i < n_nms_threads; i++)
+        nn_nms_keepset_init(&keepsets[i], (float *)nn_scratch_alloc(nn, nn_nms_keepset_bytes(keepset_cap)), keepset_cap);
 
     //Dequantize deltas
     float *dequantized_locs = (float *)nn_scratch_alloc(nn, loc_data_size * sizeof(float));
@@ -694,13 +676,14 @@ static int ssd_detection_out_execute(struct nn_node *self, struct nn_graph *nn)
     ninfo.score_pqueues = score_pqueue;
     ninfo.output_pqueues = output_pqueue;
     ninfo.filtered_indices = filtered_indices;
-    ninfo.thr_id = 0;
+    ninfo.keepsets = keepsets;
     struct nn_pqueue final_queue;
     nn_pqueue_init(nn, &final_queue, compare_box_record_ref, keep_top_k, final_output_pqueue);
     for (int n = 0; n < num; n++) //traverse batches
     {
         ninfo.num = n;
         ninfo.current_class = 0;
+        ninfo.thr_id = 0;
         for (int i = 0; i < n_nms_threads; i++)
             nn_pqueue_clear(nn, &output_pqueue[i]);
         nn_sem_init(&ninfo.donesem, 0);
@@ -94,6 +94,7 @@ struct nn_node_ops nn_ops_for_Sub_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
 
@@ -104,4 +105,5 @@ struct nn_node_ops nn_ops_for_Sub_int32 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
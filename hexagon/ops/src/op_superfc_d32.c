@@ -1590,6 +1590,65 @@ int superfc_check_ref(struct nn_node *self, struct nn_graph *nn)
 // the strategy is to leave opaque pointing to the info
 // struct, and the dtor will free any of the non-null pointers there.
 
+// scratch for the most batches the output def allows; superfc_check reserves this
+static int superfc_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	int32_t filt_batches = filt_tensor->shape.filt_batches;
+	int32_t filt_batches_roundup = (filt_batches + 31) & ~31;  //out_depth
+	int32_t filt_depth = filt_tensor->shape.filt_height * filt_tensor->shape.filt_width  * filt_tensor->shape.filt_depth;
+	int32_t filt_depth_roundup = (filt_depth + 31) & ~31;      //in depth
+	int32_t weight_batch_size = filt_depth_roundup * 32;
+
+	// components are ( each rounded up to vector):
+	//
+	//   need_init_suma:  1 bytes * (batches + 1)
+	//   suma_buf:        4 bytes * (batches + 1)
+	//    per work unit:
+	//          pointers:  2 * (4bytes)*nbatches
+	//          suma:     	   (4bytes)*nbatches
+	//   If needed, output buffer: filt_depth_batches*batches
+	//
+
+	// find output max batches (respecting 'rank')
+	unsigned max_batches;
+	{
+		struct output const * odef = &self->output_defs[0];
+		int r = min_i32(4, odef->rank);
+		max_batches = 1;
+		for( int i = 0; i < r; i++){
+			max_batches = mulu32_sat( max_batches, odef->max_sizes[i]);
+			if( max_batches >= 0x80000000u) return -1;
+		}
+		max_batches /= filt_batches;
+	}
+
+	/// ** this is duplicated from the strategy calc
+	int out_depth_iters = filt_batches_roundup/32u;
+    int inner_weight_chunks = (384*1024 + weight_batch_size - 1)/ weight_batch_size;
+    if(inner_weight_chunks > out_depth_iters) inner_weight_chunks = out_depth_iters;
+    int32_t outer_weight_chunks = (out_depth_iters + inner_weight_chunks - 1) / inner_weight_chunks;
+
+	//
+	// find size summed across batches assuming they are cut in NUM_THREADS parts.
+    // this is a loose upper bound, hopefully.
+	unsigned scratch_vecs_per_ow = 3 * ( ( max_batches*4)/128u + NUM_THREADS *3);
+	unsigned need_scratch_vecs = outer_weight_chunks * scratch_vecs_per_ow;
+	// room for need_init_suma
+	need_scratch_vecs += ( max_batches + 1+127)/128u;
+	// room for suma
+	need_scratch_vecs +=  ( (max_batches + 1)*sizeof(int32_t)+127)/128u;
+
+	// space for output buffer
+	if( filt_batches_roundup != filt_batches ){
+		need_scratch_vecs += (max_batches*filt_batches_roundup+127)/128u;
+	}
+	logmsg(nn,3,"superfc needs %u * 128 bytes scratch based on owc=%d, max_batches=%u",
+			need_scratch_vecs,(int)outer_weight_chunks,max_batches);
+	*bytes = need_scratch_vecs*128;
+	return 0;
+}
+
 int superfc_check(struct nn_node *self, struct nn_graph *nn)
 {
 	struct superfc_info *info = self->opaque;
@@ -1735,53 +1794,10 @@ int superfc_check(struct nn_node *self, struct nn_graph *nn)
 	if(setup_initial_output_range( nn, info, specified_minval, specified_maxval, 0.0f, 0.5f)) return -1;
 
 	// figure out scratch requirements
-	// components are ( each rounded up to vector):
-	//
-	//   need_init_suma:  1 bytes * (batches + 1)
-	//   suma_buf:        4 bytes * (batches + 1)
-	//    per work unit:
-	//          pointers:  2 * (4bytes)*nbatches
-	//          suma:     	   (4bytes)*nbatches
-	//   If needed, output buffer: filt_depth_batches*batches
-	//
-
-	// find output max batches (respecting 'rank')
-	unsigned max_batches;
-	{
-		struct output const * odef = &self->output_defs[0];
-		int r = min_i32(4, odef->rank);
-		max_batches = 1;
-		for( int i = 0; i < r; i++){
-			max_batches = mulu32_sat( max_batches, odef->max_sizes[i]);
-			if( max_batches >= 0x80000000u) return errlog(nn,"bad output spec");
-		}
-		max_batches /= filt_batches;
-	}
-
-	/// ** this is duplicated from the strategy calc
-	int out_depth_iters = filt_batches_roundup/32u;
-    int inner_weight_chunks = (384*1024 + weight_batch_size - 1)/ weight_batch_size;
-    if(inner_weight_chunks > out_depth_iters) inner_weight_chunks = out_depth_iters;
-    int32_t outer_weight_chunks = (out_depth_iters + inner_weight_chunks - 1) / inner_weight_chunks;
-
-	//
-	// find size summed across batches assuming they are cut in NUM_THREADS parts.
-    // this is a loose upper bound, hopefully.
-	unsigned scratch_vecs_per_ow = 3 * ( ( max_batches*4)/128u + NUM_THREADS *3);
-	unsigned need_scratch_vecs = outer_weight_chunks * scratch_vecs_per_ow;
-	// room for need_init_suma
-	need_scratch_vecs += ( max_batches + 1+127)/128u;
-	// room for suma
-	need_scratch_vecs +=  ( (max_batches + 1)*sizeof(int32_t)+127)/128u;
-
-	// space for output buffer
-	if( filt_batches_roundup != filt_batches ){
-		need_scratch_vecs += (max_batches*filt_batches_roundup+127)/128u;
-	}
-	logmsg(nn,3,"superfc needs %u * 128 bytes scratch based on owc=%d, max_batches=%u",
-			need_scratch_vecs,(int)outer_weight_chunks,max_batches);
-	if( nn_scratch_grow( nn, need_scratch_vecs*128)!= 0 ){
-		return errlog(nn,"can't grow to %u bytes scratch for superfc",need_scratch_vecs*128 );
+	uint32_t need_scratch;
+	if( superfc_scratch_hint( self, nn, &need_scratch) != 0) return errlog(nn,"bad output spec");
+	if( nn_scratch_grow( nn, need_scratch)!= 0 ){
+		return errlog(nn,"can't grow to %u bytes scratch for superfc",(unsigned)need_scratch );
 	}
 	return 0;
 }
@@ -1888,6 +1904,7 @@ struct nn_node_ops nn_ops_for_SuperFC_8x8p32to8 = {
 	.n_inputs = NN_IOCOUNT(11),
 	.n_outputs = NN_IOCOUNT(3),
 	.flags = 0,
+	.scratch_hint = superfc_scratch_hint,
 };
 struct nn_node_ops nn_ops_for_SuperFC_8x8p32to8_d32 = {
 	.execute = superfc_execute_hvx,
@@ -1897,4 +1914,5 @@ struct nn_node_ops nn_ops_for_SuperFC_8x8p32to8_d32 = {
 	.n_inputs = NN_IOCOUNT(11),
 	.n_outputs = NN_IOCOUNT(3),
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = superfc_scratch_hint,
 };
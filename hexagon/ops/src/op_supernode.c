@@ -1289,6 +1289,44 @@ static int supernode_execute_hvx(struct nn_node *self, struct nn_graph *nn)
 	return 0;
 }
 
+/*
+ * Scratch for the largest output the output defs allow. The input is bounded by
+ * what the filter and stride could have reduced to that output; the hvx execute
+ * needs the bigger of its im2col layouts, the ref execute less than that.
+ */
+static int supernode_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	struct output const *od0 = &self->output_defs[0];
+	int elsize = (self->node_type == OP_Supernode_16x16p32to16) ? 2 : 1;
+	uint64_t filt_height = filt_tensor->shape.filt_height;
+	uint64_t filt_width = filt_tensor->shape.filt_width;
+	uint64_t filt_depth = filt_tensor->shape.filt_depth;
+	uint64_t out_depth = filt_tensor->shape.filt_batches;
+	uint64_t out_depth_pad = (out_depth + DPAD - 1) & ~(DPAD-1);
+	uint64_t out_height = od0->max_sizes[1];
+	uint64_t out_width = od0->max_sizes[2];
+	uint64_t in_height = out_height * stride_tensor->shape.height + filt_height;
+	uint64_t in_width = out_width * stride_tensor->shape.width + filt_width;
+	uint64_t in_depth_pad = (filt_depth + HPAD - 1) & ~(HPAD-1);
+	uint64_t filter_value_count_pad = (filt_width*filt_height*filt_depth + HPAD - 1) & ~(HPAD-1);
+	uint64_t patches_pad = (out_height*out_width + VPAD - 1) & ~(VPAD-1);
+	uint64_t tmp_out_size = (uint64_t)od0->max_sizes[0]*out_height*out_width*out_depth*sizeof(int32_t);
+	uint64_t im2col_bufsize = out_width * (out_height+2*filt_height+2) * filter_value_count_pad;
+	uint64_t im2col_alt = (in_width+filt_width) * (2*filt_height+in_height+2*filt_height) * in_depth_pad;
+	uint64_t total;
+	if (im2col_alt > im2col_bufsize) im2col_bufsize = im2col_alt;
+	total = ROUNDUP(out_depth*sizeof(int32_t)) + ROUNDUP(im2col_bufsize) + ROUNDUP(2*sizeof(int)*32)
+		+ ROUNDUP(patches_pad*sizeof(int)) + ROUNDUP(2*32*sizeof(int))
+		+ ROUNDUP(sizeof(int32_t)*patches_pad*out_depth_pad) + ROUNDUP(tmp_out_size);
+	// supernode_check_ref reserves room to rearrange the filter
+	if (total < filter_value_count_pad*out_depth_pad*elsize) total = filter_value_count_pad*out_depth_pad*elsize;
+	if (total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 static int supernode_check_ref(struct nn_node *self, struct nn_graph *nn)
 {
 	logmsg(nn,2,"Checking supernode node %p",self);
@@ -1389,6 +1427,7 @@ struct nn_node_ops nn_ops_for_Supernode_8x8p8to8 = {
 	.dtor = supernode_dtor,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_Supernode_8x8p8to8_ref = {
@@ -1398,6 +1437,7 @@ struct nn_node_ops nn_ops_for_Supernode_8x8p8to8_ref = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_Supernode_8x8p32to8 = {
@@ -1408,6 +1448,7 @@ struct nn_node_ops nn_ops_for_Supernode_8x8p32to8 = {
 	.dtor = supernode_dtor,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_Supernode_8x8p32to8_ref = {
@@ -1417,6 +1458,7 @@ struct nn_node_ops nn_ops_for_Supernode_8x8p32to8_ref = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_scratch_hint,
 };
 
 
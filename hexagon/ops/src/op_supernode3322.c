@@ -497,6 +497,17 @@ static void rearrange_weights_3wto4_get_sumb(
     }
 }
 
+// per-thread input slices for the widest input the output defs allow
+static int supernode3322_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+    const struct tensor *filt_tensor = self->inputs[1];
+    const struct tensor *stride_tensor = self->inputs[6];
+    int32_t out_width_max  = self->output_defs[0].max_sizes[2];
+    int32_t input_width  = (out_width_max +1) * stride_tensor->shape.width  + filt_tensor->shape.filt_width;
+    *bytes = NUM_THREADS*(roundup(input_width,64)*(MAX_SLICE_SIZE+2)*filt_tensor->shape.filt_depth + 128);
+    return 0;
+}
+
 int supernode3322_check(struct nn_node *self, struct nn_graph *nn)
 {
     struct supernode3322_info *info = self->opaque;
@@ -530,11 +541,9 @@ int supernode3322_check(struct nn_node *self, struct nn_graph *nn)
     if (filt_width!=3 || filt_height!=3 || filt_batches!=2 || filt_depth!=2) return errlog(nn,"filt not 3x3x2x2");
 
     // scratch
-	int32_t out_width_max  = self->output_defs[0].max_sizes[2];
-	int32_t input_width  = (out_width_max +1) * stride_width  + filt_width;
-
-    int32_t scratch_size = NUM_THREADS*(roundup(input_width,64)*(MAX_SLICE_SIZE+2)*filt_depth + 128);
-    logmsg(nn,3,"scratch_size = %ld", scratch_size);
+    uint32_t scratch_size;
+    supernode3322_scratch_hint(self,nn,&scratch_size);
+    logmsg(nn,3,"scratch_size = %ld", (long)scratch_size);
 
     nn_scratch_grow(nn, scratch_size);
 
@@ -669,6 +678,7 @@ struct nn_node_ops nn_ops_for_Supernode3322_8x8p8to8 = {
     .dtor = supernode_dtor,
     .n_inputs = NN_IOCOUNT_RANGE(12,13),
     .n_outputs = NN_IOCOUNT(3),
+    .scratch_hint = supernode3322_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_Supernode3322_8x8p32to8 = {
@@ -678,4 +688,5 @@ struct nn_node_ops nn_ops_for_Supernode3322_8x8p32to8 = {
     .dtor = supernode_dtor,
     .n_inputs = NN_IOCOUNT_RANGE(12,13),
     .n_outputs = NN_IOCOUNT(3),
+    .scratch_hint = supernode3322_scratch_hint,
 };
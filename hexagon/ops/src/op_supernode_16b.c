@@ -3649,6 +3649,49 @@ static int supernode_execute_16b_hvx(struct nn_node *self, struct nn_graph *nn)
 	return 0;
 }
 
+// circular buffers (per thread) for the v65 path; supernode_u16b_check reserves these
+static inline uint32_t supernode_u16b_circ_buf_estimate(struct nn_node *self)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	int32_t filt_height = filt_tensor->shape.filt_height;
+	int32_t filt_depth = filt_tensor->shape.filt_depth;
+	int32_t stride_width = stride_tensor->shape.width;
+	return 2 * (filt_height + stride_tensor->shape.height)*filt_depth*(self->output_defs[0].max_sizes[1] * stride_width + 8);
+}
+
+/*
+ * Scratch for the largest output the output defs allow: the circular buffers, the
+ * suma scratch and suma buffers, and (v65/v66) the per-thread input tiles, all sized
+ * as if one work item had all the output rows. The input row is bounded assuming
+ * no more than 32 elements of width padding and 32 of depth padding.
+ */
+static int supernode_u16b_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	struct output const *od0 = &self->output_defs[0];
+	uint64_t filt_height = filt_tensor->shape.filt_height;
+	uint64_t filt_width = filt_tensor->shape.filt_width;
+	uint64_t filt_depth_roundup = roundup(filt_tensor->shape.filt_depth, 32);
+	uint64_t stride_height = stride_tensor->shape.height;
+	uint64_t stride_width = stride_tensor->shape.width;
+	uint64_t out_height = od0->max_sizes[1];
+	uint64_t out_width = od0->max_sizes[2];
+	uint64_t in_rows = out_height*stride_height + filt_height + 1;
+	// 8 zeros, up to 3 unused left pad, required_w_total, rounded to 32 (all int32)
+	uint64_t suma_buf_rowstride = roundup(8 + 3 + filt_width + out_width*stride_width, 32);
+	uint64_t sumatmp_size = roundup((suma_buf_rowstride*(4 + in_rows) + 32)*sizeof(int32_t), 128);
+	uint64_t suma_buf_size = roundup(suma_buf_rowstride*out_height*od0->max_sizes[0]*sizeof(int32_t), 128);
+	uint64_t in_next_row = (out_width*stride_width + filt_width + 32) * (filt_depth_roundup + 32);
+	uint64_t input_split_size = roundup(in_rows*in_next_row*sizeof(uint16_t)*NUM_THREADS, 128);
+	uint64_t total = sumatmp_size*NUM_THREADS + suma_buf_size + input_split_size
+		+ (uint64_t)roundup(supernode_u16b_circ_buf_estimate(self), 128)*NUM_THREADS;
+	if (total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 int supernode_u16b_check(struct nn_node *self, struct nn_graph *nn) {
 	struct sn16b_info *info = self->opaque;
 	if (self->n_inputs != 12) return errlog(nn, "supernode wrong # inputs... now need min/max with inf for self-detecting");
@@ -3679,7 +3722,7 @@ int supernode_u16b_check(struct nn_node *self, struct nn_graph *nn) {
 	int i;
 	int use_v65_v66 = 0, use_combine_output = 1;
 
-	int circ_buf_est = 2 * (filt_height + stride_tensor->shape.height)*filt_depth*(self->output_defs[0].max_sizes[1] * stride_width + 8);
+	int circ_buf_est = supernode_u16b_circ_buf_estimate(self);
 	nn_scratch_grow(nn, circ_buf_est*NUM_THREADS);
 
 #if defined(V66)
@@ -3953,6 +3996,7 @@ struct nn_node_ops nn_ops_for_Supernode_u16x16p16to16_d32 = {
 	.dtor = supernode_16b_dtor,
 	.n_inputs = NN_IOCOUNT(12),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_u16b_scratch_hint,
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT
 };
 
@@ -3963,6 +4007,7 @@ struct nn_node_ops nn_ops_for_Supernode_u16x16p32to16_d32 = {
 	.dtor = supernode_16b_dtor,
 	.n_inputs = NN_IOCOUNT(12),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_u16b_scratch_hint,
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT
 };
 
@@ -4645,6 +4690,29 @@ static void shortin_filt_sumb(uint8_t * filt_trans, int out_depth, int filter_co
 	return;
 }
 
+// At check time we reserve what execute will carve out of scratch: a padded copy of
+// the largest input the output defs allow, the integral buffers, and the suma buffer.
+static int shortin_supernode_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	int32_t filt_height = filt_tensor->shape.filt_height;
+	int32_t filt_width = filt_tensor->shape.filt_width;
+	int32_t filt_depth_roundup = (filt_tensor->shape.filt_depth + 3) & ~3;
+	int32_t out_height_max = self->output_defs[0].max_sizes[1];
+	int32_t out_width_max = self->output_defs[0].max_sizes[2];
+	int32_t stride_height = stride_tensor->shape.height;
+	int32_t stride_width = stride_tensor->shape.height;
+	int32_t input_height = (out_height_max + 1) * stride_height + filt_height;
+	int32_t input_width = (out_width_max + 1) * stride_width + filt_width;
+	int32_t input_depth = filt_depth_roundup;
+	int32_t input_size = input_height * input_width*input_depth + 256;
+	logmsg(nn, 2, "estimating input %dx%dx%d, scratch %d", input_height, input_width, input_depth, input_size * 6);
+	//*bytes = input_size*6+input_height*input_width*4*SHORTIN_WORKITEMS;
+	*bytes = input_size * 6 + input_height * input_width * 4 * NUM_THREADS;
+	return 0;
+}
+
 static int shortin_supernode_check(struct nn_node *self, struct nn_graph *nn)
 {
 	struct sn16b_info *info = self->opaque;
@@ -4672,18 +4740,9 @@ static int shortin_supernode_check(struct nn_node *self, struct nn_graph *nn)
 	float filt_min_float = tensor_get_float(min_filt_tensor, 0);
 	int32_t filt_offset = quantize_uint16(0.0f, filt_min_float, filt_max_float);
 	float filt_level_size = (filt_max_float - filt_min_float) / 65536.0f;
-	int32_t out_height_max = self->output_defs[0].max_sizes[1];
-	int32_t out_width_max = self->output_defs[0].max_sizes[2];
-	const struct tensor *stride_tensor = self->inputs[6];
-	int32_t stride_height = stride_tensor->shape.height;
-	int32_t stride_width = stride_tensor->shape.height;
-	int32_t input_height = (out_height_max + 1) * stride_height + filt_height;
-	int32_t input_width = (out_width_max + 1) * stride_width + filt_width;
-	int32_t input_depth = filt_depth_roundup;
-	int32_t input_size = input_height * input_width*input_depth + 256;
-	logmsg(nn, 2, "estimating input %dx%dx%d, growing scratch to %d", input_height, input_width, input_depth, input_size * 6);
-	//nn_scratch_grow(nn,input_size*6+input_height*input_width*4*SHORTIN_WORKITEMS);
-	nn_scratch_grow(nn, input_size * 6 + input_height * input_width * 4 * NUM_THREADS);
+	uint32_t scratch_bytes;
+	shortin_supernode_scratch_hint(self, nn, &scratch_bytes);
+	nn_scratch_grow(nn, scratch_bytes);
 
 
 	/* At check time or ctor time, we need to allocate all the intermediate storage we will need */
@@ -4759,6 +4818,7 @@ struct nn_node_ops nn_ops_for_InputSupernode_16x16p16to16_outd32 = {
 	.ctor = node_alloc_common,
 	.dtor = shortin_supernode_dtor,
 	.flags = NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = shortin_supernode_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_InputSupernode_16x16p32to16_outd32 = {
@@ -4767,4 +4827,5 @@ struct nn_node_ops nn_ops_for_InputSupernode_16x16p32to16_outd32 = {
 	.ctor = node_alloc_common,
 	.dtor = shortin_supernode_dtor,
 	.flags = NN_NODE_FLAG_D32_OUTPUT,
+	.scratch_hint = shortin_supernode_scratch_hint,
 };
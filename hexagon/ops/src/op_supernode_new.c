@@ -2772,6 +2772,29 @@ static inline int32_t slice_for_cache(
 }
 #endif
 
+/*
+ * Remember the tiling slice_for_cache chose, and replace it with the override
+ * (from the tuning db or the autotuner) if there is one. The override is clamped
+ * to what the current strategy can support, so a stale record can't break it.
+ */
+static inline void supernode_tiling_select(
+	struct supernode_info_new *info,
+	int32_t batches,
+	int32_t max_chunks,
+	int32_t *inner_act_batches,
+	int32_t *inner_act_rows,
+	int32_t *inner_weight_chunks)
+{
+	info->tiling_heuristic.inner_act_batches = *inner_act_batches;
+	info->tiling_heuristic.inner_act_rows = *inner_act_rows;
+	info->tiling_heuristic.inner_weight_chunks = *inner_weight_chunks;
+	info->tiling_max_chunks = max_chunks = Q6_R_max_RR(max_chunks,1);
+	if (!info->tiling_override_valid) return;
+	*inner_act_batches = Q6_R_max_RR(Q6_R_min_RR(info->tiling_override.inner_act_batches,batches),1);
+	*inner_act_rows = Q6_R_max_RR(info->tiling_override.inner_act_rows,1);
+	*inner_weight_chunks = Q6_R_max_RR(Q6_R_min_RR(info->tiling_override.inner_weight_chunks,max_chunks),1);
+}
+
 void note_chunk_checkpoint_arrival(struct nn_graph *nn, struct nn_node *self, void *opaque)
 {
 	struct supernode_info_new *info = self->opaque;
@@ -3414,6 +3437,9 @@ int supernode_recalculate_strategy(struct nn_node *self, struct nn_graph *nn)
 		&inner_act_batches,
                 &inner_act_rows,
 		&inner_weight_chunks);
+	supernode_tiling_select(info,out_batches,
+		info->use_v65 ? Q6_R_min_RR((nn->vtcm_size - VTCM_CIRCBUF_SIZE)/weight_batch_size,num_out_slices) : num_out_slices,
+		&inner_act_batches,&inner_act_rows,&inner_weight_chunks);
 
 	work.num_lines = inner_act_rows;
 	inner_act_rows = (out_height+NUM_THREADS-1)/(NUM_THREADS);
@@ -4245,6 +4271,9 @@ int supernode_recalculate_strategy_v66(struct nn_node *self, struct nn_graph *nn
                 &inner_act_rows,
 		&inner_weight_chunks,
                 &burst_chunks);
+	supernode_tiling_select(info,out_batches,
+		Q6_R_min_RR(info->n_weight_batches,num_out_slices),
+		&inner_act_batches,&inner_act_rows,&inner_weight_chunks);
 	work.num_lines = inner_act_rows;
         work.vtcm_chunks = inner_weight_chunks;
 	inner_act_rows = (out_height+NUM_THREADS-1)/(NUM_THREADS);
@@ -4445,6 +4474,165 @@ int get_circ_buf_size(struct nn_node *self, struct nn_graph *nn)
 #endif
 
 
+static int supernode_recalculate(struct nn_node *self, struct nn_graph *nn)
+{
+	struct supernode_info_new *nodeinfo = self->opaque;
+	if(nodeinfo->use_v66 == 1) {
+		if (supernode_recalculate_strategy_v66(self,nn) != 0) {
+			return errlog(nn,"recalc strategy for v66 failed");
+		}
+	} else {
+		if (supernode_recalculate_strategy(self,nn) != 0) {
+			return errlog(nn,"recalc strategy failed");
+		}
+	}
+	return 0;
+}
+
+/*
+ * Autotuning (see nn_graph_tuning.h)
+ * The candidates are the heuristic tiling, and that tiling with each of
+ * rows, weight chunks and batches changed one step up or down.
+ */
+#define SUPERNODE_TUNE_MAX_CANDIDATES 8
+
+static inline int supernode_tune_add(struct supernode_tiling *cands, int n, struct supernode_tiling c)
+{
+	int i;
+	if ((c.inner_act_rows < 1) || (c.inner_weight_chunks < 1) || (n >= SUPERNODE_TUNE_MAX_CANDIDATES)) return n;
+	for (i = 0; i < n; i++) {
+		if (memcmp(&cands[i],&c,sizeof(c)) == 0) return n;
+	}
+	cands[n] = c;
+	return n+1;
+}
+
+static int supernode_tune_candidates(struct nn_node *self, struct supernode_info_new *info, struct supernode_tiling *cands)
+{
+	const struct supernode_tiling *h = &info->tiling_heuristic;
+	int32_t batches = self->inputs[0]->shape.batches;
+	int32_t max_rows = (info->out_height + NUM_THREADS - 1) / NUM_THREADS;
+	int32_t max_chunks = info->tiling_max_chunks;
+	struct supernode_tiling c;
+	int n = 0;
+
+	n = supernode_tune_add(cands,n,*h);
+	c = *h; c.inner_act_rows = h->inner_act_rows / 2;
+	n = supernode_tune_add(cands,n,c);
+	c = *h; c.inner_act_rows = Q6_R_min_RR(h->inner_act_rows * 2, max_rows);
+	n = supernode_tune_add(cands,n,c);
+	c = *h; c.inner_weight_chunks = h->inner_weight_chunks / 2;
+	n = supernode_tune_add(cands,n,c);
+	c = *h; c.inner_weight_chunks = Q6_R_min_RR(h->inner_weight_chunks * 2, max_chunks);
+	n = supernode_tune_add(cands,n,c);
+	c = *h; c.inner_weight_chunks = max_chunks;
+	n = supernode_tune_add(cands,n,c);
+	if (batches > 1) {
+		c = *h; c.inner_act_batches = (h->inner_act_batches == 1) ? batches : 1;
+		n = supernode_tune_add(cands,n,c);
+	}
+	return n;
+}
+
+static void supernode_tuning_key(struct nn_node *self, struct supernode_info_new *info, struct tuning_record *key)
+{
+	const struct shape *in = &self->inputs[0]->shape;
+	const struct shape *filt = &self->inputs[1]->shape;
+	const struct shape *stride = &self->inputs[6]->shape;
+	memset(key,0,sizeof(*key));
+	key->kind = (info->use_v66 == 1) ? NN_TUNING_KIND_SUPERNODE_V66 : NN_TUNING_KIND_SUPERNODE;
+	key->batches = in->batches;
+	key->height = in->height;
+	key->width = in->width;
+	key->depth = in->depth;
+	key->filt_height = filt->filt_height;
+	key->filt_width = filt->filt_width;
+	key->out_depth = filt->filt_batches;
+	key->stride_height = stride->height;
+	key->stride_width = stride->width;
+	key->padding = self->padding;
+}
+
+/*
+ * Time each candidate over 'runs' executions (keeping the fastest run), recalculate
+ * with the best and record it. The trial executions are real ones, so they can adjust
+ * the output range like any other; the caller executes again with the final strategy.
+ * Each candidate gets the scratch the heuristic strategy started with.
+ */
+static int supernode_autotune(struct nn_node *self, struct nn_graph *nn, struct tuning_record *rec, int runs)
+{
+	struct supernode_info_new *info = self->opaque;
+	struct supernode_tiling cands[SUPERNODE_TUNE_MAX_CANDIDATES];
+	int32_t scratch_mark = nn->scratch_nextalloc;
+	uint64_t best_cycles = ~0ULL;
+	uint64_t t0,t;
+	int n_cands = supernode_tune_candidates(self,info,cands);
+	int best = 0;
+	int i,r;
+
+	for (i = 0; i < n_cands; i++) {
+		uint64_t cand_cycles = ~0ULL;
+		nn->scratch_nextalloc = scratch_mark;
+		info->tiling_override = cands[i];
+		info->tiling_override_valid = 1;
+		if (supernode_recalculate(self,nn) != 0) {
+			logmsg(nn,1,"autotune id=%x: tiling %d,%d,%d not usable",self->node_id,
+				cands[i].inner_act_batches,cands[i].inner_act_rows,cands[i].inner_weight_chunks);
+			continue;
+		}
+		for (r = 0; r < runs; r++) {
+			t0 = nn_os_get_cycles(nn);
+			if (supernode_execute_strategy(self,nn) != 0) return errlog(nn,"autotune execute failed");
+			t = nn_os_get_cycles(nn) - t0;
+			if (t < cand_cycles) cand_cycles = t;
+		}
+		logmsg(nn,2,"autotune id=%x: tiling %d,%d,%d: %lld cycles",self->node_id,
+			cands[i].inner_act_batches,cands[i].inner_act_rows,cands[i].inner_weight_chunks,(long long)cand_cycles);
+		if (cand_cycles < best_cycles) {
+			best_cycles = cand_cycles;
+			best = i;
+		}
+	}
+	nn->scratch_nextalloc = scratch_mark;
+	info->tiling_override = cands[best];
+	info->tiling_override_valid = 1;
+	if (supernode_recalculate(self,nn) != 0) return -1;
+	logmsg(nn,1,"autotune id=%x: tiling %d,%d,%d (heuristic %d,%d,%d) %lld cycles",self->node_id,
+		cands[best].inner_act_batches,cands[best].inner_act_rows,cands[best].inner_weight_chunks,
+		cands[0].inner_act_batches,cands[0].inner_act_rows,cands[0].inner_weight_chunks,(long long)best_cycles);
+	rec->inner_batches = cands[best].inner_act_batches;
+	rec->inner_rows = cands[best].inner_act_rows;
+	rec->inner_weight_chunks = cands[best].inner_weight_chunks;
+	rec->cycles = (best_cycles > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)best_cycles;
+	return nn_tuning_store(nn,rec);
+}
+
+/*
+ * Recalculate the strategy, with the tiling from the tuning db if there's one
+ * for this shape; otherwise with the heuristic tiling, or the autotuned one
+ * when the 'autotune' option is set.
+ */
+static int supernode_recalculate_tuned(struct nn_node *self, struct nn_graph *nn)
+{
+	struct supernode_info_new *info = self->opaque;
+	struct tuning_record rec;
+	const struct tuning_record *found;
+	int runs = nn_option_get(nn,autotune);
+
+	supernode_tuning_key(self,info,&rec);
+	if ((found = nn_tuning_lookup(nn,&rec)) != NULL) {
+		info->tiling_override.inner_act_batches = found->inner_batches;
+		info->tiling_override.inner_act_rows = found->inner_rows;
+		info->tiling_override.inner_weight_chunks = found->inner_weight_chunks;
+		info->tiling_override_valid = 1;
+		return supernode_recalculate(self,nn);
+	}
+	info->tiling_override_valid = 0;
+	if (supernode_recalculate(self,nn) != 0) return -1;
+	if (runs <= 0) return 0;
+	return supernode_autotune(self,nn,&rec,runs);
+}
+
 static int supernode_execute_hvx(struct nn_node *self, struct nn_graph *nn)
 {
 	struct supernode_info_new *nodeinfo = self->opaque;
@@ -4493,15 +4681,9 @@ static int supernode_execute_hvx(struct nn_node *self, struct nn_graph *nn)
 			return errlog(nn,"execute strategy failed");
 		}
 	} else {
-                if(nodeinfo->use_v66 == 1) {
-			if (supernode_recalculate_strategy_v66(self,nn) != 0) {
-				return errlog(nn,"recalc strategy for v66 failed");
-			}
-                } else {
-			if (supernode_recalculate_strategy(self,nn) != 0) {
-				return errlog(nn,"recalc strategy failed");
-			}
-                }
+		if (supernode_recalculate_tuned(self,nn) != 0) {
+			return -1;
+		}
 		if (supernode_execute_strategy(self,nn) != 0) {
 			return errlog(nn,"execute strategy fail after recalc");
 		}
@@ -4530,6 +4712,45 @@ static int supernode_execute_hvx(struct nn_node *self, struct nn_graph *nn)
 	return 0;
 }
 
+// circular buffers (per thread) for the v65 path; supernode_check reserves these
+static inline uint32_t supernode_circ_buf_estimate(struct nn_node *self)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	int32_t filt_height = filt_tensor->shape.filt_height;
+	int32_t filt_depth = filt_tensor->shape.filt_depth;
+	int32_t stride_width = stride_tensor->shape.width;
+	return 2*(filt_height+stride_tensor->shape.height)*filt_depth*(self->output_defs[0].max_sizes[1]*stride_width+8);
+}
+
+/*
+ * Scratch for the largest output the output defs allow: the circular buffers, plus
+ * the suma scratch and suma buffers which supernode_recalculate_strategy allocates
+ * (sized here as if one work item had all the output rows).
+ */
+static int supernode_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	struct output const *od0 = &self->output_defs[0];
+	uint64_t filt_height = filt_tensor->shape.filt_height;
+	uint64_t filt_width = filt_tensor->shape.filt_width;
+	uint64_t stride_height = stride_tensor->shape.height;
+	uint64_t stride_width = stride_tensor->shape.width;
+	uint64_t out_height = od0->max_sizes[1];
+	uint64_t out_width = od0->max_sizes[2];
+	// 8 zeros, up to 3 unused left pad, required_w_total, rounded to 32 (all int32)
+	uint64_t suma_buf_rowstride = roundup(8 + 3 + filt_width + out_width*stride_width,32);
+	uint64_t scratch_rows = 4 + out_height*stride_height + filt_height + 1;
+	uint64_t sumatmp_size = roundup((suma_buf_rowstride*scratch_rows + 32)*sizeof(int32_t),128);
+	uint64_t suma_buf_size = roundup(suma_buf_rowstride*out_height*od0->max_sizes[0]*sizeof(int32_t),128);
+	uint64_t total = sumatmp_size*NUM_THREADS + suma_buf_size
+		+ (uint64_t)roundup(supernode_circ_buf_estimate(self),128)*NUM_THREADS;
+	if (total > INT32_MAX) return -1;
+	*bytes = total;
+	return 0;
+}
+
 int supernode_check(struct nn_node *self, struct nn_graph *nn)
 {
 	struct supernode_info_new *info = self->opaque;
@@ -4563,7 +4784,7 @@ int supernode_check(struct nn_node *self, struct nn_graph *nn)
 	int i;
 	int use_v66 = 0;
 
-	int circ_buf_est = 2*(filt_height+stride_tensor->shape.height)*filt_depth*(self->output_defs[0].max_sizes[1]*stride_width+8);
+	int circ_buf_est = supernode_circ_buf_estimate(self);
 	nn_scratch_grow(nn,circ_buf_est*NUM_THREADS);
 
 #ifdef HEXAGON_V66
@@ -4847,6 +5068,7 @@ struct nn_node_ops nn_ops_for_Supernode_8x8p8to8_d32 = {
 	.dtor = supernode_dtor,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_scratch_hint,
 
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT | NN_NODE_FLAG_OUTPUT_ACCEPTS_PREPARATION,
 	.earlywork_note_pred = supernode_earlywork_note_pred,
@@ -4860,6 +5082,7 @@ struct nn_node_ops nn_ops_for_Supernode_8x8p32to8_d32 = {
 	.dtor = supernode_dtor,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = supernode_scratch_hint,
 
 	.flags = NN_NODE_FLAG_D32_INPUT | NN_NODE_FLAG_D32_OUTPUT | NN_NODE_FLAG_OUTPUT_ACCEPTS_PREPARATION,
 	.earlywork_note_pred = supernode_earlywork_note_pred,
@@ -5665,6 +5888,29 @@ static void shortin_filt_sumb(uint8_t * filt_trans, int out_depth, int filter_co
     return;
 }
 
+// At check time we reserve what execute will carve out of scratch: a padded copy of
+// the largest input the output defs allow, the integral buffers, and the suma buffer.
+static int shortin_supernode_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	const struct tensor *filt_tensor = self->inputs[1];
+	const struct tensor *stride_tensor = self->inputs[6];
+	int32_t filt_height = filt_tensor->shape.filt_height;
+	int32_t filt_width = filt_tensor->shape.filt_width;
+	int32_t filt_depth_roundup = (filt_tensor->shape.filt_depth + 3) & ~3;
+	int32_t out_height_max = self->output_defs[0].max_sizes[1];
+	int32_t out_width_max = self->output_defs[0].max_sizes[2];
+	int32_t stride_height = stride_tensor->shape.height;
+	int32_t stride_width = stride_tensor->shape.height;
+	int32_t input_height = (out_height_max+1) * stride_height + filt_height;
+	int32_t input_width = (out_width_max+1) * stride_width + filt_width;
+	int32_t input_depth = filt_depth_roundup;
+	int32_t input_size = input_height*input_width*input_depth + 256;
+	logmsg(nn,2,"estimating input %dx%dx%d, scratch %d",input_height,input_width,input_depth,input_size*6);
+	//*bytes = input_size*6+input_height*input_width*4*SHORTIN_WORKITEMS;
+	*bytes = input_size*6+input_height*input_width*4*NUM_THREADS;
+	return 0;
+}
+
 static int shortin_supernode_check(struct nn_node *self, struct nn_graph *nn)
 {
 	struct supernode_info_new *info = self->opaque;
@@ -5696,18 +5942,9 @@ static int shortin_supernode_check(struct nn_node *self, struct nn_graph *nn)
         float filt_min_float = tensor_get_float(min_filt_tensor,0);
         float filt_level_size;
         int32_t filt_offset = get_qu8_level_size_zero(filt_min_float,filt_max_float, &filt_level_size);
-	int32_t out_height_max = self->output_defs[0].max_sizes[1];
-	int32_t out_width_max = self->output_defs[0].max_sizes[2];
-	const struct tensor *stride_tensor = self->inputs[6];
-	int32_t stride_height = stride_tensor->shape.height;
-	int32_t stride_width = stride_tensor->shape.height;
-	int32_t input_height = (out_height_max+1) * stride_height + filt_height;
-	int32_t input_width = (out_width_max+1) * stride_width + filt_width;
-	int32_t input_depth = filt_depth_roundup;
-	int32_t input_size = input_height*input_width*input_depth + 256;
-	logmsg(nn,2,"estimating input %dx%dx%d, growing scratch to %d",input_height,input_width,input_depth,input_size*6);
-	//nn_scratch_grow(nn,input_size*6+input_height*input_width*4*SHORTIN_WORKITEMS);
-	nn_scratch_grow(nn,input_size*6+input_height*input_width*4*NUM_THREADS);
+	uint32_t scratch_bytes;
+	shortin_supernode_scratch_hint(self,nn,&scratch_bytes);
+	nn_scratch_grow(nn,scratch_bytes);
 
 
 	/* At check time or ctor time, we need to allocate all the intermediate storage we will need */
@@ -5805,6 +6042,7 @@ struct nn_node_ops nn_ops_for_InputSupernode_8x8p8to8_outd32 = {
 	.flags = NN_NODE_FLAG_D32_OUTPUT,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = shortin_supernode_scratch_hint,
 };
 
 struct nn_node_ops nn_ops_for_InputSupernode_8x8p32to8_outd32 = {
@@ -5815,6 +6053,7 @@ struct nn_node_ops nn_ops_for_InputSupernode_8x8p32to8_outd32 = {
 	.flags = NN_NODE_FLAG_D32_OUTPUT,
 	.n_inputs = NN_IOCOUNT_RANGE(12,13),
 	.n_outputs = NN_IOCOUNT(3),
+	.scratch_hint = shortin_supernode_scratch_hint,
 };
 
 #endif
@@ -76,5 +76,6 @@ struct nn_node_ops nn_ops_for_Tanh_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(1),
 	.n_outputs = NN_IOCOUNT(1),
+	.scratch_hint = nn_scratch_hint_none,
 };
 
@@ -34,135 +34,69 @@
  */
 #include <nn_graph.h>
 #include <string.h>
+#include <quantize.h>
+#include "nn_bufferpool.h"
+#include "nn_topk.h"
 
-struct topk_f_element{
-    float value;
-    int32_t tensor_index;
-};
-
-#define PARENT_IDX(IDX) ((IDX-1)/2)
-#define LEFT_CHILD_IDX(IDX) (2*IDX+1)
-#define RIGHT_CHILD_IDX(IDX) (2*IDX+2)
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * TopK on float rows; the selection itself is in nn_topk.c.
+ * Rows are handed out to the threads in chunks.
+ */
 
-struct topk_f_heap
-{
-    struct topk_f_element* list; 
-    int32_t len;
-    int32_t k; 
-    int32_t capacity_size;
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+// rows are handed out to the threads in chunks of about this many elements
+#define TOPK_F_JOB_ELEMENTS 16384
+
+struct topk_f_runstate {
+	const float *in;
+	float *out_val;
+	int32_t *out_idx;
+	int row_size;
+	int k;
+	int rows;
+	int rows_per_job;
+	int jobs;
+	volatile int next_job;
+	struct buffer_pool bufs;	// work space for nn_topk_f_row
+	nn_sem_t done_sem;
 };
 
-static inline void  topk_f_swap_elements(struct topk_f_heap * heap,int i, int j){
-    struct topk_f_element* a = heap->list+i;
-    struct topk_f_element* b = heap->list+j;
-    struct topk_f_element t[1];
-    memcpy(t, a, sizeof(struct topk_f_element));
-    memcpy(a, b, sizeof(struct topk_f_element));
-    memcpy(b, t, sizeof(struct topk_f_element));
-}
-
-int static inline topk_f_less_than(struct topk_f_element *a, struct topk_f_element *b){
-	if (b->value > a->value){
-		return 1;
-	}
-	if (b->value < a->value){
-		return -1;
-	}
-	if (b->tensor_index > a->tensor_index){
-		return 1;
+static void topk_f_work(struct nn_graph *nn, void *vrstp)
+{
+	struct topk_f_runstate *rstp = (struct topk_f_runstate *)vrstp;
+	int row_size = rstp->row_size;
+	int k = rstp->k;
+	int bufind, job;
+	struct nn_topk_elem *work = bufpool_take(&rstp->bufs, &bufind);
+	if (work != NULL) {
+		while (job = __sync_fetch_and_add(&rstp->next_job, 1), job < rstp->jobs) {
+			int row0 = job * rstp->rows_per_job;
+			int row1 = min_i32(row0 + rstp->rows_per_job, rstp->rows);
+			const float *in = rstp->in + (size_t)row0 * row_size;
+			float *out_val = rstp->out_val + (size_t)row0 * k;
+			int32_t *out_idx = rstp->out_idx + (size_t)row0 * k;
+			for (int r = row0; r < row1; r++, in += row_size, out_val += k, out_idx += k) {
+				nn_topk_f_row(in, row_size, k, out_val, out_idx, work);
+			}
+		}
+		bufpool_release(&rstp->bufs, bufind);
 	}
-    if (b->tensor_index  < a->tensor_index){
-        return -1;
-    }
-    return 0;
-}
-
-void __attribute__((unused))printheap(struct nn_graph* nn, struct topk_f_heap * heap){
-    logmsg(nn,2,"printing heap of len %ld",heap->len);
-    for (int i = 0; i< heap->len;i++){
-       logmsg(nn,2,"[%d]=(value=%f,id=%ld)",i,heap->list[i].value,heap->list[i].tensor_index);
-       int inum=i+2;
-       if((inum&(inum-1))==0){
-        logmsg(nn,2,"");
-       }
-    }
-    logmsg(nn,2,"------------------");
-}
-
-static inline void topk_f_clear_heap(struct topk_f_heap * heap){
-	memset(heap->list,0,heap->capacity_size);
-    heap->len = 0;
-}
-
-static inline void topk_f_heapify(struct topk_f_heap * heap, int i){
-    int l = LEFT_CHILD_IDX(i);
-    int r = RIGHT_CHILD_IDX(i);
-    int smallest;
-    if (l < heap->len && topk_f_less_than(heap->list+l,heap->list+i)==1){
-        //left child value is smaller current value in min-heap
-        smallest = l;
-    } else{
-        smallest = i;
-    }
-    if (r < heap->len && topk_f_less_than(heap->list+r,heap->list+smallest)==1){
-        //right child value is smaller current value in min-heap
-        smallest = r;
-    }
-    if (smallest != i){
-        topk_f_swap_elements(heap, smallest, i);
-        topk_f_heapify(heap, smallest);
-    }
-}
-
-static inline void topk_f_remove_min_from_heap(struct topk_f_heap * heap){
-    heap->len--;
-    topk_f_swap_elements(heap,heap->len,0);
-    topk_f_heapify(heap,0);
-}
-
-static inline void topk_f_push_value_to_heap(struct topk_f_heap * heap,float value, int32_t index){
-    int i = heap->len;
-    heap->list[i].value = value;
-    heap->list[i].tensor_index = index;
-    heap->len++;
-    int p = PARENT_IDX(i);
-    while (i != 0 && topk_f_less_than(heap->list+i,heap->list+p)==1) {
-        //current value is smaller than parent value in min-heap
-        topk_f_swap_elements(heap,p,i);
-        i = p;
-        p = PARENT_IDX(i);
-   }
-}
-
-static inline void topk_f_add_value(struct topk_f_heap * heap,float value, int32_t index){
-    if(heap->len<=heap->k){
-        topk_f_push_value_to_heap(heap,value,index);
-    }
-    else if(heap->list[0].value < value){
-        topk_f_push_value_to_heap(heap,value,index);
-        topk_f_remove_min_from_heap(heap);
-    }
-}
-
-static inline void topk_sort_heap(struct topk_f_heap * heap){
-    while(heap->len!=0){
-        topk_f_remove_min_from_heap(heap);
-    }
-}
-
-static inline void topk_get_sorted_result(struct topk_f_heap* heap, float* data,int32_t* idx){
-    struct topk_f_element* copy_ptr = heap->list;
-    int32_t copy_num = heap->k;
-    topk_sort_heap(heap);
-    for (int i =0;i<copy_num;i++){
-        *data = copy_ptr->value;
-        *idx = copy_ptr->tensor_index;
-        data++;
-        idx++;
-        copy_ptr++;
-    }
+	nn_sem_post(&rstp->done_sem);
 }
 
+//
+// inputs: data, k
+// outputs: values, indices
+// The k largest of each row, in descending order; equal values are ordered by index descending.
+//
 static int topk_f_execute(struct nn_node *self, struct nn_graph *nn){
     logmsg(nn,2,"topkf execute. self=%p ",self);
 	const struct tensor *input_val_tensor = self->inputs[0];
@@ -170,11 +104,10 @@ static int topk_f_execute(struct nn_node *self, struct nn_graph *nn){
     int32_t given_k = tensor_get_int32(k_tensor,0);
     struct tensor *out_val_tensor = self->outputs[0];
     struct tensor *out_idx_tensor = self->outputs[1];
-    float * in_val = input_val_tensor->data;
     struct shape outshape = input_val_tensor->shape;
     int32_t row_size=outshape.depth;
     int32_t batch_size=outshape.batches*outshape.height*outshape.width;
-    int32_t cur_idx;
+    if (given_k < 0) return errlog(nn,"k must be >= 0");
     int32_t k = (row_size < given_k)?row_size:given_k;
     outshape.depth = k;
     if( tensor_out_prepare_normal_fromshape( out_val_tensor, &outshape, NN_TYPE_FLOAT)!=0 ){
@@ -183,30 +116,53 @@ static int topk_f_execute(struct nn_node *self, struct nn_graph *nn){
     if( tensor_out_prepare_normal_fromshape( out_idx_tensor, &outshape, NN_TYPE_INT32)!=0 ){
         return errlog(nn,"out too small");
     }
-    struct topk_f_heap heap;
-    heap.k = k;
-    heap.capacity_size = (k+2)*sizeof(struct topk_f_element);
-    if (nn_scratch_grow(nn,heap.capacity_size)){
+    if (k == 0 || batch_size == 0) return 0;
+
+    struct topk_f_runstate rst;
+    rst.in = input_val_tensor->data;
+    rst.out_val = out_val_tensor->data;
+    rst.out_idx = out_idx_tensor->data;
+    rst.row_size = row_size;
+    rst.k = k;
+    rst.rows = batch_size;
+    rst.rows_per_job = max_i32(1, TOPK_F_JOB_ELEMENTS / row_size);
+    rst.jobs = (batch_size + rst.rows_per_job - 1) / rst.rows_per_job;
+    rst.next_job = 0;
+
+    int n_threads = min_i32(NUM_THREADS, rst.jobs);
+    unsigned work_size = ((unsigned)nn_topk_f_work_elems(row_size, k) * sizeof(struct nn_topk_elem) + 127) & ~127u;
+    nn_scratch_reset(nn);
+    if (nn_scratch_grow(nn, work_size * n_threads + 128)) {
         return errlog(nn,"scratch too small");
     }
-    heap.list = nn->scratch;
-    float * out_val = out_val_tensor->data;
-    int32_t * out_idxs = out_idx_tensor->data;
-    for (int b =0; b<batch_size; b++){
-        topk_f_clear_heap(&heap);
-        for (int r =0; r < row_size; r++){
-            cur_idx = r;
-            //cur_idx = b*row_size +r;
-            topk_f_add_value(&heap,*in_val,cur_idx);
-            in_val++;
-        }
-        topk_get_sorted_result(&heap,out_val,out_idxs);
-        out_val+=k;
-        out_idxs+=k;
+    void *mem = nn_scratch_alloc(nn, work_size * n_threads);
+    if (mem == NULL) return errlog(nn,"didn't get temp mem");
+    bufpool_init(&rst.bufs, n_threads, mem, work_size);
+
+    nn_sem_init(&rst.done_sem, 0);
+    for (int i = 0; i < n_threads; i++) {
+        nn_os_work_for_vector(nn, topk_f_work, &rst);
     }
+    nn_sem_wait_n_times(&rst.done_sem, n_threads);
 	return 0;
 }
 
+// a work buffer per thread, as topk_f_execute. The input's row size comes from its
+// producer's output def, and k is at most the output's depth; nn_topk_f_work_elems
+// grows with k, so size for the largest k that fits.
+static int topk_f_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+    struct nn_node *src = find_node(nn, self->input_refs[0].src_id);
+    if (src == NULL) return -1;
+    int32_t row_size = src->output_defs[self->input_refs[0].output_idx].max_sizes[3];
+    int32_t k = min_i32(row_size, self->output_defs[0].max_sizes[3]);
+    *bytes = 0;
+    if (k <= 0) return 0;
+    unsigned work_size = ((unsigned)nn_topk_f_work_elems(row_size, k) * sizeof(struct nn_topk_elem) + 127) & ~127u;
+    *bytes = work_size * NUM_THREADS + 128;
+    return 0;
+}
+
 
 struct nn_node_ops nn_ops_for_TopK_f = {
 	.execute = topk_f_execute,
@@ -215,5 +171,5 @@ struct nn_node_ops nn_ops_for_TopK_f = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(2),
 	.n_outputs = NN_IOCOUNT(2),
+	.scratch_hint = topk_f_scratch_hint,
 };
-
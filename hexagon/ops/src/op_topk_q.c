@@ -35,15 +35,70 @@
  */
 #include <nn_graph.h>
 #include <string.h>
+#include <quantize.h>
+#include "nn_asm_ops.h"
+#include "nn_bufferpool.h"
+#include "nn_topk.h"
 
 #define NUM_VALUES_IN_BYTE 256
-#define MAX_BYTE_VALUE 255
 
-// finds topk with a histogram and a map
-// to find top k, we need the values of sorted in decreasing order, and use index value(in increasing order) to break ties
+// finds topk with a histogram
+// to find top k, we need the values sorted in decreasing order; ties are broken by index, larger first.
 // since there are only 256 values that can be represented in bytes (NUM_VALUES_IN_BYTE),
-// we can store the the first k values we see of each byte value in a map
-// and store how many values of a byte value we have seen in a histogram
+// a histogram of the row tells which values make the cut, and where each one goes in the output;
+// see nn_topk_u8_row. Rows are handed out to the threads in chunks.
+
+#ifdef HEXAGON_V66
+#define NUM_THREADS 4
+#else
+#define NUM_THREADS 2
+#endif
+
+// rows are handed out to the threads in chunks of about this many elements
+#define TOPK_8_JOB_ELEMENTS 32768
+// histogram_flat_asm counts in 16 bits
+#define TOPK_8_MAX_HVX_HISTO 65535
+// the per-thread histogram
+#define TOPK_8_HISTO_SIZE (NUM_VALUES_IN_BYTE * sizeof(uint16_t))
+
+struct topk_8_runstate {
+	const uint8_t *in;
+	uint8_t *out_val;
+	int32_t *out_idx;
+	int row_size;
+	int k;
+	int rows;
+	int rows_per_job;
+	int jobs;
+	volatile int next_job;
+	struct buffer_pool bufs;	// vector aligned histograms
+	nn_sem_t done_sem;
+};
+
+static void topk_8_work(struct nn_graph *nn, void *vrstp)
+{
+	struct topk_8_runstate *rstp = (struct topk_8_runstate *)vrstp;
+	int row_size = rstp->row_size;
+	int k = rstp->k;
+	int use_hvx = row_size <= TOPK_8_MAX_HVX_HISTO;
+	int bufind, job;
+	uint16_t *histo = bufpool_take(&rstp->bufs, &bufind);
+	if (histo != NULL) {
+		while (job = __sync_fetch_and_add(&rstp->next_job, 1), job < rstp->jobs) {
+			int row0 = job * rstp->rows_per_job;
+			int row1 = min_i32(row0 + rstp->rows_per_job, rstp->rows);
+			const uint8_t *in = rstp->in + (size_t)row0 * row_size;
+			uint8_t *out_val = rstp->out_val + (size_t)row0 * k;
+			int32_t *out_idx = rstp->out_idx + (size_t)row0 * k;
+			for (int r = row0; r < row1; r++, in += row_size, out_val += k, out_idx += k) {
+				if (use_hvx) histogram_flat_asm(histo, in, row_size, 1, row_size);
+				nn_topk_u8_row(in, row_size, k, use_hvx ? histo : NULL, out_val, out_idx);
+			}
+		}
+		bufpool_release(&rstp->bufs, bufind);
+	}
+	nn_sem_post(&rstp->done_sem);
+}
 
 static int topk_8_execute(struct nn_node *self, struct nn_graph *nn){
     logmsg(nn,2,"topkq execute. self=%p ",self);
@@ -58,16 +113,13 @@ static int topk_8_execute(struct nn_node *self, struct nn_graph *nn){
     struct tensor *output_min_tensor = self->outputs[2];
     struct tensor *output_max_tensor = self->outputs[3];
 
-    const uint8_t * in_val = input_val_tensor->data;
-    uint8_t * out_val = out_val_tensor->data;
-    int32_t * out_idxs = out_idx_tensor->data;
     int32_t given_k = tensor_get_int32(k_tensor,0);
 
     struct shape outshape = input_val_tensor->shape;
     int32_t row_size = outshape.depth;
     int32_t batch_size = outshape.batches*outshape.height*outshape.width;
-    int32_t cur_depth_idx;
 
+    if (given_k < 0) return errlog(nn,"k must be >= 0");
     //if depth is smaller than k, use depth instead of k. 
     int32_t k = (row_size < given_k)?row_size:given_k;
     outshape.depth = k;
@@ -83,73 +135,41 @@ static int topk_8_execute(struct nn_node *self, struct nn_graph *nn){
     if(tensor_set_single_float(output_max_tensor, tensor_get_float(input_max_tensor,0))){
         return errlog(nn,"max too small");
     }
-
-    int32_t byte_count_histogram[NUM_VALUES_IN_BYTE] = {0};
-    int32_t* byte_count_histogram_last_ptr = byte_count_histogram + MAX_BYTE_VALUE;
-    int32_t map_bucket_size = k*sizeof(int32_t);
-    int32_t map_size = map_bucket_size*NUM_VALUES_IN_BYTE;
-    if (nn_scratch_grow(nn,map_size)){
+    if (k == 0 || batch_size == 0) return 0;
+
+    struct topk_8_runstate rst;
+    rst.in = input_val_tensor->data;
+    rst.out_val = out_val_tensor->data;
+    rst.out_idx = out_idx_tensor->data;
+    rst.row_size = row_size;
+    rst.k = k;
+    rst.rows = batch_size;
+    rst.rows_per_job = max_i32(1, TOPK_8_JOB_ELEMENTS / row_size);
+    rst.jobs = (batch_size + rst.rows_per_job - 1) / rst.rows_per_job;
+    rst.next_job = 0;
+
+    int n_threads = min_i32(NUM_THREADS, rst.jobs);
+    unsigned histo_size = TOPK_8_HISTO_SIZE;
+    nn_scratch_reset(nn);
+    if (nn_scratch_grow(nn, histo_size * n_threads + 128)) {
         return errlog(nn,"scratch too small");
     }
-    int32_t* byte_index_map = nn->scratch;
-    for (int b=0; b<batch_size; b++, in_val+=row_size){
-        //start from the end of the row
-        const uint8_t * in_val_row = in_val+row_size-1;
-
-        //zero out the memory before traversing the row again
-        memset(byte_index_map,0,map_size);
-        memset(byte_count_histogram,0,sizeof(byte_count_histogram));
-
-        //read row front to back, to make larger indices appear first
-        for (int r = row_size -1; r >=0; r--, in_val_row--){
-            cur_depth_idx = r;
-            uint8_t histogram_byte_key = *in_val_row;
-            int32_t* byte_count_ptr = byte_count_histogram+histogram_byte_key;
-            int32_t byte_count = *byte_count_ptr;
-
-            if (byte_count<k){
-                int32_t* idx_in_map_ptr = byte_index_map+(k*histogram_byte_key)+byte_count;// the 
-                *idx_in_map_ptr=cur_depth_idx;
-                *byte_count_ptr=byte_count+1;
-            }else if(histogram_byte_key == MAX_BYTE_VALUE){// shortcutting if k 255s found
-                break;
-            }
-            
-        }
-
-        if(*byte_count_histogram_last_ptr==k) {//if shortcutted above
-            memset(out_val,MAX_BYTE_VALUE,k);
-            memcpy(out_idxs,byte_index_map+k*MAX_BYTE_VALUE,map_bucket_size);
-            out_val+=k;
-            out_idxs+=k;
-            continue;
-        }
-
-        int32_t remaining=k;
-        int32_t* byte_count_ptr = byte_count_histogram_last_ptr;
-        int32_t* idx_in_map_ptr = byte_index_map+k*MAX_BYTE_VALUE;
-        //traverse the histogram and map backwards, and write to the output while there's space to write
-        //start from 255, end at 0, while not all k values written to output
-        for (int byte = MAX_BYTE_VALUE; remaining > 0 && byte >= 0  ; byte--){
-            int32_t byte_count =*byte_count_ptr;
-            int32_t copy_len = (remaining > byte_count)? byte_count:remaining;
-            if(byte_count > 0){
-                remaining-=copy_len;
-
-                //since its the same byte value, just write it over and over again
-                memset(out_val,byte,copy_len);
-
-                //the indices are already in increasing order in the map, so just copy them
-                memcpy(out_idxs,idx_in_map_ptr,copy_len*sizeof(int32_t)); 
-
-                out_val+=copy_len;
-                out_idxs+=copy_len;
-            }
-            //traverse pointer backwards
-            byte_count_ptr--;
-            idx_in_map_ptr-=k;
-        }
+    void *mem = nn_scratch_alloc(nn, histo_size * n_threads);
+    if (mem == NULL) return errlog(nn,"didn't get temp mem");
+    bufpool_init(&rst.bufs, n_threads, mem, histo_size);
+
+    nn_sem_init(&rst.done_sem, 0);
+    for (int i = 0; i < n_threads; i++) {
+        nn_os_work_for_vector(nn, topk_8_work, &rst);
     }
+    nn_sem_wait_n_times(&rst.done_sem, n_threads);
+    return 0;
+}
+
+// a histogram per thread, as topk_8_execute
+static int topk_8_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+    *bytes = TOPK_8_HISTO_SIZE * NUM_THREADS + 128;
     return 0;
 }
 
@@ -161,5 +181,5 @@ struct nn_node_ops nn_ops_for_TopK_8 = {
 	.dtor = node_free_common,
 	.n_inputs = NN_IOCOUNT(4),
 	.n_outputs = NN_IOCOUNT(4),
+	.scratch_hint = topk_8_scratch_hint,
 };
-
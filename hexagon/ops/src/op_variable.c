@@ -365,13 +365,14 @@ static int assign_execute(struct nn_node *self, struct nn_graph *nn)
 		if( self->output_defs[i].elementsize > 0){
 			res = nn_mcmanager_tensor_copy(nn, &mcman, self->outputs[i],self->inputs[2*i+1] );
 			if( res != 0){
-				return errlog(nn,"can't copy to output %d",i);
+				res = errlog(nn,"can't copy to output %d",i);
 				goto finish;
 			}
 		}
 	}
  finish:
-	nn_mcmanager_wait( nn, &mcman);
+	// the copies may still be running when we return (see nn_copyeng_defer)
+	nn_mcmanager_defer( nn, &mcman, self);
 	return res;
 }
 
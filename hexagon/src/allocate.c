@@ -219,6 +219,205 @@ static int allocate_storage(struct nn_graph *nn)
 	return 0;
 }
 
+/*
+ * Aliasing planner.
+ *
+ * Before allocation, each output with an alias hint (see nn_graph.h) may be given the
+ * storage of one of its node's inputs instead of its own:
+ *  - INPLACE, when the node is the last one to read that storage (by last_consumer of
+ *    all the tensors sharing it);
+ *  - VIEW, always (nothing writes a view, so it can be read alongside the original).
+ * Tensors sharing storage form a group under the 'root' tensor which owns the allocation;
+ * the root's PreFree goes after the last consumer of any tensor in the group.
+ * (Canaries don't work for tensors which are not at the start of their storage, but
+ *  those are only marked in debug builds).
+ */
+struct alias_ptrmap {
+	const void *p;
+	int32_t idx;
+};
+
+struct alias_tensor {
+	struct tensor *t;
+	struct tensor *root;		// owner of the storage (t itself, if not aliased)
+	struct nn_node *producer;
+	uint32_t offset;		// byte offset of t's data in root's storage
+	int32_t last_pos;		// (roots) position of the last node which reads the storage
+	int32_t alias_pos;		// (roots) position of the last node which aliased into it
+};
+
+struct alias_plan {
+	int n_nodes;
+	int n_tensors;
+	struct nn_node **nodes;		// in execution order
+	struct alias_ptrmap *node_map;	// sorted by node pointer
+	struct alias_ptrmap *tensor_map;	// sorted by tensor pointer
+	struct alias_tensor *tensors;
+};
+
+static int alias_ptrcmp(const void *a, const void *b)
+{
+	size_t pa = (size_t)((const struct alias_ptrmap *)a)->p;
+	size_t pb = (size_t)((const struct alias_ptrmap *)b)->p;
+	return (pa > pb) - (pa < pb);
+}
+
+static int alias_find(const struct alias_ptrmap *map, int n, const void *p)
+{
+	struct alias_ptrmap key = { .p = p };
+	const struct alias_ptrmap *r;
+	if (map == NULL) return -1;
+	r = bsearch(&key, map, n, sizeof(key), alias_ptrcmp);
+	return (r == NULL) ? -1 : r->idx;
+}
+
+static inline struct alias_tensor *alias_lookup(struct alias_plan *plan, const struct tensor *t)
+{
+	int k = alias_find(plan->tensor_map, plan->n_tensors, t);
+	return (k < 0) ? NULL : &plan->tensors[k];
+}
+
+static void alias_plan_free(struct alias_plan *plan)
+{
+	if (plan->nodes) nn_free(plan->nodes);
+	if (plan->node_map) nn_free(plan->node_map);
+	if (plan->tensor_map) nn_free(plan->tensor_map);
+	if (plan->tensors) nn_free(plan->tensors);
+	memset(plan, 0, sizeof(*plan));
+}
+
+int nn_alias_hint_view_input0(struct nn_node *self, struct nn_graph *nn, int out_idx, struct nn_alias_hint *hint)
+{
+	if (out_idx != 0 || self->n_inputs < 1) return -1;
+	hint->kind = NN_ALIAS_VIEW;
+	hint->in_idx = 0;
+	hint->offset = 0;
+	return 0;
+}
+
+static int alias_get_hint(struct nn_graph *nn, struct nn_node *node, int out_idx, struct nn_alias_hint *hint)
+{
+	hint->kind = NN_ALIAS_NONE;
+	hint->in_idx = 0;
+	hint->offset = 0;
+	if (node->ops->alias_hint != NULL) {
+		if ((*node->ops->alias_hint)(node, nn, out_idx, hint) != 0) hint->kind = NN_ALIAS_NONE;
+	} else if (out_idx == 0 && (node->ops->flags & NN_NODE_FLAG_CLS_SUPPORTS_ALIAS) != 0) {
+		hint->kind = NN_ALIAS_INPLACE;
+	}
+	if (hint->in_idx < 0 || hint->in_idx >= node->n_inputs) hint->kind = NN_ALIAS_NONE;
+	return hint->kind;
+}
+
+// can 'out' (output of the node at pos) share storage with 'in', as described by the hint?
+static int alias_try(struct nn_graph *nn, struct alias_plan *plan, struct nn_node *node, int pos,
+	struct tensor *out, struct nn_alias_hint const *hint)
+{
+	struct alias_tensor *ro = alias_lookup(plan, out);
+	struct alias_tensor *ri = alias_lookup(plan, node->inputs[hint->in_idx]);
+	if (ro == NULL || ri == NULL || ro->root != out) return 0;
+	struct alias_tensor *rr = alias_lookup(plan, ri->root);
+	if (rr == NULL) return 0;
+	// storage which is moved at execute time can't be shared.
+	int ptype = rr->producer->node_type;
+	if (ptype == OP_INPUT || ptype == OP_Variable) return 0;
+	uint32_t offset = ri->offset + hint->offset;
+	if (offset + (uint64_t)out->max_size > rr->t->max_size) return 0;
+	if (hint->kind == NN_ALIAS_INPLACE) {
+		if (hint->offset != 0 || out->max_size > node->inputs[hint->in_idx]->max_size) return 0;
+		// nothing after this node may read the storage, and it can only be aliased once here.
+		if (rr->last_pos != pos || rr->alias_pos == pos) return 0;
+		// no other input of the node may be in the group
+		for (int i = 0; i < node->n_inputs; i++) {
+			if (i == hint->in_idx) continue;
+			struct alias_tensor *rx = alias_lookup(plan, node->inputs[i]);
+			if (rx != NULL && rx->root == rr->t) return 0;
+		}
+	} else if (hint->kind == NN_ALIAS_VIEW) {
+		if (rr->alias_pos == pos) return 0;	// (it may have been written in place)
+	} else {
+		return 0;
+	}
+	ro->root = rr->t;
+	ro->offset = offset;
+	if (ro->last_pos > rr->last_pos) rr->last_pos = ro->last_pos;
+	rr->alias_pos = pos;
+	logmsg(nn, 3, "alias: node %x output %p -> %p + %u (%s)", node->node_id, out, rr->t, offset,
+		(hint->kind == NN_ALIAS_INPLACE) ? "in place" : "view");
+	return 1;
+}
+
+static int alias_plan_build(struct nn_graph *nn, struct alias_plan *plan)
+{
+	struct nn_node *tmp;
+	struct tensor *t;
+	int i, pos, any_hint = 0;
+	int n_aliased = 0;
+	uint32_t bytes_saved = 0;
+	memset(plan, 0, sizeof(*plan));
+	if (nn_option_get(nn, test_no_alias)) return 0;
+	// graph loops run nodes out of list order, so last_consumer doesn't mean 'last'.
+	if ((nn->op_class_set & NN_NODE_FLAG_CLS_LOOP_CONTROL_NODE) != 0) return 0;
+
+	for (tmp = nn->head; tmp != NULL; tmp = tmp->next) {
+		plan->n_nodes++;
+		if (tmp->ops->alias_hint != NULL || (tmp->ops->flags & NN_NODE_FLAG_CLS_SUPPORTS_ALIAS) != 0) any_hint = 1;
+		for (i = 0; i < tmp->n_outputs; i++) {
+			t = tmp->outputs[i];
+			if ((t->max_size > 0) && (t->data == NULL)) plan->n_tensors++;
+		}
+	}
+	if (!any_hint || plan->n_tensors == 0) return 0;
+
+	plan->nodes = nn_malloc(plan->n_nodes * sizeof(*plan->nodes));
+	plan->node_map = nn_malloc(plan->n_nodes * sizeof(*plan->node_map));
+	plan->tensor_map = nn_malloc(plan->n_tensors * sizeof(*plan->tensor_map));
+	plan->tensors = nn_calloc(plan->n_tensors, sizeof(*plan->tensors));
+	if (plan->nodes == NULL || plan->node_map == NULL || plan->tensor_map == NULL || plan->tensors == NULL) {
+		alias_plan_free(plan);
+		return errlog(nn, "alias plan: alloc failed");
+	}
+	int n_tensors = 0;
+	for (tmp = nn->head, pos = 0; tmp != NULL; tmp = tmp->next, pos++) {
+		plan->nodes[pos] = tmp;
+		plan->node_map[pos].p = tmp;
+		plan->node_map[pos].idx = pos;
+		for (i = 0; i < tmp->n_outputs; i++) {
+			t = tmp->outputs[i];
+			if ((t->max_size == 0) || (t->data != NULL)) continue;
+			plan->tensors[n_tensors].t = t;
+			plan->tensors[n_tensors].root = t;
+			plan->tensors[n_tensors].producer = tmp;
+			plan->tensors[n_tensors].alias_pos = -1;
+			plan->tensor_map[n_tensors].p = t;
+			plan->tensor_map[n_tensors].idx = n_tensors;
+			n_tensors++;
+		}
+	}
+	qsort(plan->node_map, plan->n_nodes, sizeof(*plan->node_map), alias_ptrcmp);
+	qsort(plan->tensor_map, plan->n_tensors, sizeof(*plan->tensor_map), alias_ptrcmp);
+	for (i = 0; i < plan->n_tensors; i++) {
+		struct alias_tensor *rt = &plan->tensors[i];
+		int lp = alias_find(plan->node_map, plan->n_nodes, rt->t->last_consumer);
+		if (lp < 0) lp = alias_find(plan->node_map, plan->n_nodes, rt->producer);
+		rt->last_pos = lp;
+	}
+
+	for (pos = 0; pos < plan->n_nodes; pos++) {
+		tmp = plan->nodes[pos];
+		for (i = 0; i < tmp->n_outputs; i++) {
+			struct nn_alias_hint hint;
+			if (alias_get_hint(nn, tmp, i, &hint) == NN_ALIAS_NONE) continue;
+			if (alias_try(nn, plan, tmp, pos, tmp->outputs[i], &hint)) {
+				n_aliased++;
+				bytes_saved += tmp->outputs[i]->max_size;
+			}
+		}
+	}
+	logmsg(nn, 2, "alias plan: %d tensors share storage, %u bytes", n_aliased, bytes_saved);
+	return 0;
+}
+
 #if 1
 static void remove_freenodes(struct nn_graph *nn)
 {
@@ -263,10 +462,11 @@ static int append_freenode(
 	return 0;
 }
 
-static int add_freenodes(struct nn_graph *nn)
+static int add_freenodes(struct nn_graph *nn, struct alias_plan *plan)
 {
 	struct nn_node *tmp;
 	struct nn_node *dst;
+	struct alias_tensor *rt;
 	int i;
 	struct tensor *t;
 	/* Add free nodes */
@@ -275,6 +475,11 @@ static int add_freenodes(struct nn_graph *nn)
 			t = tmp->outputs[i];
 			if ((t->max_size > 0) && (t->data == NULL)) {
 				dst = t->last_consumer;
+				/* aliased storage is freed once, by its root, after the whole group is done */
+				if ((rt = alias_lookup(plan,t)) != NULL) {
+					if (rt->root != t) continue;
+					dst = plan->nodes[rt->last_pos];
+				}
 				if (append_freenode(nn,dst,tmp,i) != 0) {
 					return errlog(nn,"can't append");
 				}
@@ -285,10 +490,11 @@ static int add_freenodes(struct nn_graph *nn)
 }
 #endif
 
-static int allocate_and_free(struct nn_graph *nn)
+static int allocate_and_free(struct nn_graph *nn, struct alias_plan *plan)
 {
 	struct nn_node *tmp;
 	struct tensor *t;
+	struct alias_tensor *rt;
 	int i;
 	for (tmp = nn->head; tmp != NULL; tmp = tmp->next) {
 #if 1
@@ -310,6 +516,11 @@ static int allocate_and_free(struct nn_graph *nn)
 		for (i = 0; i < tmp->n_outputs; i++) {
 			t = tmp->outputs[i];
 			if ((t->max_size > 0) && (t->data == NULL)) {
+				if ((rt = alias_lookup(plan,t)) != NULL && rt->root != t) {
+					t->data = (uint8_t *)rt->root->data + rt->offset;
+					logmsg(nn,3,"alias %d bytes @ %p",t->max_size,t->data);
+					continue;
+				}
 				/* Pre-Allocate data */
 				if ((t->data = prealloc(nn,&nn->root,t->max_size))
 					== NULL) {
@@ -340,9 +551,10 @@ static int allocate_and_free(struct nn_graph *nn)
 	return 0;
 }
 
-static void reset_allocated_pointers(struct nn_graph *nn)
+static void reset_allocated_pointers(struct nn_graph *nn, struct alias_plan *plan)
 {
 	struct nn_node *tmp;
+	int i;
 	/* Go back and NULL out all the input pointers */
 	/* Since we point output0 to output tensors, this resets data pointers */
 	for (tmp = nn->head; tmp != NULL; tmp = tmp->next) {
@@ -350,31 +562,42 @@ static void reset_allocated_pointers(struct nn_graph *nn)
 			tmp->outputs[0]->data = NULL;
 		}
 	}
+	/* aliased tensors don't have PreFree nodes */
+	for (i = 0; i < plan->n_tensors; i++) {
+		if (plan->tensors[i].root != plan->tensors[i].t) plan->tensors[i].t->data = NULL;
+	}
 }
 
 int allocate_graph_storage(struct nn_graph *nn)
 {
+	struct alias_plan plan;
+	int err = -1;
 	/* initialize mm system */
 	set_last_consumers(nn);
+	/* Decide which outputs can share storage with an input */
+	if (alias_plan_build(nn,&plan) != 0) return errlog(nn,"alias plan");
 	alloc_init(nn);
 	/* Add the free nodes where they belong */
-	if (add_freenodes(nn) != 0) return errlog(nn,"add freenodes");
+	if (add_freenodes(nn,&plan) != 0) { errlog(nn,"add freenodes"); goto done; }
 	/* Instead of free nodes, mark last consumer in every tensor */
 	/* Go through and figure out storage requirements */
-	if (allocate_and_free(nn) != 0) return errlog(nn,"alloc/free");
+	if (allocate_and_free(nn,&plan) != 0) { errlog(nn,"alloc/free"); goto done; }
 	/* 
 	 * We didn't really want those values since storage 
 	 * hasn't been allocated yet... 
 	 */
-	reset_allocated_pointers(nn);
+	reset_allocated_pointers(nn,&plan);
 	/* Check results and actually allocate bulk storage */
-	if (check_allocations(nn) != 0) return errlog(nn,"bad alloc check");
-	if (allocate_storage(nn) != 0) return errlog(nn,"storage alloc");
+	if (check_allocations(nn) != 0) { errlog(nn,"bad alloc check"); goto done; }
+	if (allocate_storage(nn) != 0) { errlog(nn,"storage alloc"); goto done; }
 	/* Now reassign pointers */
-	if (allocate_and_free(nn) != 0) return errlog(nn,"real alloc/free");
+	if (allocate_and_free(nn,&plan) != 0) { errlog(nn,"real alloc/free"); goto done; }
 	/* Now we shouldn't need the freenodes any more */
 	remove_freenodes(nn);
-	return 0;
+	err = 0;
+done:
+	alias_plan_free(&plan);
+	return err;
 }
 
 static void freelist_teardown(struct nn_graph *nn)
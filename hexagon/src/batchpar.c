@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains batch-parallel execution of graph segments (see nn_graph_batchpar.h).
+ */
+#include <nn_graph.h>
+#include <string.h>
+#include "quantize.h"
+
+extern int Num_Vector_Threads;
+
+#define BATCHPAR_MAX_NODES 32
+#define BATCHPAR_MAX_TENSORS 256
+
+//
+// ops which can run on any subset of the batches, and give the same result
+// for those batches as when run on all of them. 'batched' has a bit set for
+// each input which has the batch dimension (its batches are split, or it's
+// broadcast if it has only one); the other inputs are read as is.
+// 'batched_out' likewise marks the outputs which have the batch dimension; the
+// others (e.g. output ranges) must come out the same from every worker.
+// None of these use VTCM, or change node->opaque at execute.
+//
+static const struct {
+	uint32_t node_type;
+	uint32_t batched;
+	uint32_t batched_out;
+} batchpar_types[] = {
+	{ OP_Add_f, 3, 1 },
+	{ OP_Sub_f, 3, 1 },
+	{ OP_Mul_f, 3, 1 },
+	{ OP_Minimum_f, 3, 1 },
+	{ OP_Maximum_f, 3, 1 },
+	{ OP_ElementwiseChain_f, ~1u, 1 },	// input 0 is the program
+	{ OP_Relu_f, 1, 1 },
+	{ OP_ReluX_f, 1, 1 },
+	{ OP_Clamp_f, 1, 1 },
+	{ OP_Neg_f, 1, 1 },
+	{ OP_Abs_f, 1, 1 },
+	{ OP_Sigmoid_f, 1, 1 },
+	{ OP_Tanh_f, 1, 1 },
+	{ OP_Softmax_f, 1, 3 },	// output 1 is the top-k indices
+	{ OP_MaxPool_f, 1, 1 },
+	{ OP_AvgPool_f, 1, 1 },
+	{ OP_Conv2d_f, 1, 1 },
+	{ OP_QuantizedRelu_8, 1, 1 },
+	{ OP_QuantizedReluX_8, 1, 1 },
+	{ OP_QuantizedClamp_8, 1, 1 },
+	{ OP_QuantizedMaxPool_8, 1, 1 },
+	{ OP_QuantizedAvgPool_8, 1, 1 },
+	{ OP_Requantize_32to8, 1, 1 },	// (output range is from inputs 3,4)
+};
+
+struct nn_batchpar_worker {
+	struct nn_graph *shadow;	// copy of the graph; shadow->batchpar_worker points back here
+	struct nn_batchpar_segment *seg;
+	struct nn_node *nodes;		// copies of the segment's nodes
+	struct tensor *tensors;		// views, one per seg->tensors[]
+	void **ioptrs;			// inputs[] and outputs[] arrays for the copied nodes
+	void *repl;			// OUT_REPLICATED buffers
+	uint32_t b0;			// first batch, and # of batches, for this run
+	uint32_t nb;
+	int err;
+	nn_sem_t *donesem;
+};
+
+static int batchpar_type_index(const struct nn_node *node)
+{
+	int i;
+	for (i = 0; i < sizeof(batchpar_types)/sizeof(batchpar_types[0]); i++) {
+		if (batchpar_types[i].node_type == node->node_type) return i;
+	}
+	return -1;
+}
+
+static int batchpar_find(const struct nn_batchpar_segment *seg, const struct tensor *t)
+{
+	int i;
+	for (i = 0; i < seg->n_tensors; i++) {
+		if (seg->tensors[i].real == t) return i;
+	}
+	return -1;
+}
+
+static int batchpar_overlap(const struct tensor *a, const struct tensor *b)
+{
+	const char *pa = a->data;
+	const char *pb = b->data;
+	if (pa == NULL || pb == NULL || a->max_size == 0 || b->max_size == 0) return 0;
+	return (pa < pb + b->max_size) && (pb < pa + a->max_size);
+}
+
+//
+// Can tensors a and b be in the same segment, given where they are stored?
+// Inputs from outside may share storage with each other (they're only read);
+// outputs may share storage only if they are laid out the same way, so that each
+// worker stays within its own batches of it. Nothing else may overlap.
+//
+static int batchpar_storage_ok(const struct nn_batchpar_tensor *a, const struct nn_batchpar_tensor *b)
+{
+	int a_ext = a->kind == NN_BATCHPAR_EXT_SHARED || a->kind == NN_BATCHPAR_EXT_BATCHED;
+	int b_ext = b->kind == NN_BATCHPAR_EXT_SHARED || b->kind == NN_BATCHPAR_EXT_BATCHED;
+	if (!batchpar_overlap(a->real,b->real)) return 1;
+	if (a_ext && b_ext) return 1;
+	return a->kind == NN_BATCHPAR_OUT_BATCHED && b->kind == NN_BATCHPAR_OUT_BATCHED
+		&& a->real->data == b->real->data && a->stride == b->stride;
+}
+
+static int batchpar_add_tensor(struct nn_batchpar_segment *seg, struct tensor *t, int kind)
+{
+	struct nn_batchpar_tensor *e;
+	if (seg->n_tensors >= BATCHPAR_MAX_TENSORS) return -1;
+	e = &seg->tensors[seg->n_tensors++];
+	memset(e,0,sizeof(*e));
+	e->real = t;
+	e->kind = kind;
+	return 0;
+}
+
+// per-batch layout of output 'idx' while the workers run; 0 if it has no batches to split.
+static int batchpar_out_layout(const struct nn_node *node, int idx, struct nn_batchpar_tensor *e)
+{
+	const struct output *od = &node->output_defs[idx];
+	uint32_t stride = od->elementsize;
+	int j;
+	if (od->rank != 4) return 0;
+	for (j = 1; j < 4; j++) stride = mulu32_sat(stride,od->max_sizes[j]);
+	if (stride == 0 || od->max_sizes[0] < 2) return 0;
+	if ((uint64_t)stride * od->max_sizes[0] > e->real->max_size) return 0;
+	e->stride = stride;
+	e->max_batches = od->max_sizes[0];
+	return 1;
+}
+
+//
+// add the node's tensors to the segment; if the node can't be in it,
+// leave the segment as it was, and return 0.
+//
+static int batchpar_try_add(struct nn_batchpar_segment *seg, struct nn_node *node)
+{
+	int type = batchpar_type_index(node);
+	uint32_t batched, batched_out;
+	int n0 = seg->n_tensors;
+	int i,j;
+
+	if (type < 0 || seg->n_nodes >= BATCHPAR_MAX_NODES || node->n_outputs < 1) return 0;
+	batched = batchpar_types[type].batched;
+	batched_out = batchpar_types[type].batched_out;
+	for (i = 0; i < node->n_inputs; i++) {
+		struct tensor *t = (struct tensor *)node->inputs[i];
+		int is_batched = (i < 32) && ((batched >> i) & 1);
+		int k = batchpar_find(seg,t);
+		if (k < 0) {
+			if (batchpar_add_tensor(seg,t,is_batched ? NN_BATCHPAR_EXT_BATCHED : NN_BATCHPAR_EXT_SHARED) != 0) goto fail;
+			continue;
+		}
+		switch (seg->tensors[k].kind) {
+		case NN_BATCHPAR_EXT_BATCHED:
+		case NN_BATCHPAR_OUT_BATCHED:
+			if (!is_batched) goto fail;
+			break;
+		default:
+			if (is_batched) goto fail;
+			break;
+		}
+	}
+	for (i = 0; i < node->n_outputs; i++) {
+		struct tensor *t = node->outputs[i];
+		int is_batched = (i < 32) && ((batched_out >> i) & 1);
+		if (batchpar_find(seg,t) >= 0) goto fail;
+		if (batchpar_add_tensor(seg,t,is_batched ? NN_BATCHPAR_OUT_BATCHED : NN_BATCHPAR_OUT_REPLICATED) != 0) goto fail;
+		if (is_batched && !batchpar_out_layout(node,i,&seg->tensors[seg->n_tensors-1])) goto fail;
+	}
+	for (i = n0; i < seg->n_tensors; i++) {
+		for (j = 0; j < i; j++) {
+			if (!batchpar_storage_ok(&seg->tensors[i],&seg->tensors[j])) goto fail;
+		}
+	}
+	for (i = n0; i < seg->n_tensors; i++) {
+		for (j = 0; j < i; j++) {
+			if (batchpar_overlap(seg->tensors[i].real,seg->tensors[j].real)
+				&& seg->tensors[i].kind == NN_BATCHPAR_OUT_BATCHED) {
+				seg->tensors[i].shared_storage = 1;
+				seg->tensors[j].shared_storage = 1;
+			}
+		}
+	}
+	if (seg->n_nodes == 0) seg->first = node;
+	seg->last = node;
+	seg->n_nodes++;
+	return 1;
+fail:
+	seg->n_tensors = n0;
+	return 0;
+}
+
+static int batchpar_worker_setup(struct nn_graph *nn, struct nn_batchpar_segment *seg, struct nn_batchpar_worker *w)
+{
+	struct nn_graph *shadow;
+	struct nn_node *node;
+	uint32_t repl_bytes = 0;
+	uint32_t scratch_bytes = 128;
+	uint32_t bytes;
+	int n_io = 0;
+	int i,j,k;
+
+	// the worker's arena is sized for the segment's nodes (see nn_scratch_plan_graph)
+	for (node = seg->first; ; node = node->next) {
+		n_io += node->n_inputs + node->n_outputs;
+		if (nn_scratch_node_needs(nn,node,&bytes) != 0) bytes = nn->scratch_size;
+		scratch_bytes = max_u32(scratch_bytes,bytes);
+		if (node == seg->last) break;
+	}
+	for (i = 0; i < seg->n_tensors; i++) {
+		struct nn_batchpar_tensor *e = &seg->tensors[i];
+		if (e->kind != NN_BATCHPAR_OUT_REPLICATED) continue;
+		e->repl_offset = repl_bytes;
+		repl_bytes += (e->real->max_size + 127) & ~127;
+	}
+	w->seg = seg;
+	if ((w->shadow = shadow = nn_malloc(sizeof(*shadow))) == NULL) return errlog(nn,"batchpar: can't alloc graph copy");
+	memcpy(shadow,nn,sizeof(*shadow));
+	// its own scratch, which can't grow; no trace, observer or prepare state. Its log messages
+	// are dropped on target (an error makes the segment run again on the real graph, which logs it).
+	shadow->state = NN_GRAPH_PREPARED;
+	nn_mutex_init(&shadow->scratch_mutex);
+	nn_mutex_init(&shadow->log_mutex);
+	shadow->logbuf_size = 0;
+	shadow->logbuf_pos = 0;
+	shadow->trace = NULL;
+	shadow->node_observer = NULL;
+	shadow->pstate = NULL;
+	shadow->batchpar_segs = NULL;
+	shadow->batchpar_worker = w;
+	shadow->scratch_nextalloc = 0;
+	shadow->scratch_size = scratch_bytes;
+	if ((shadow->scratch = nn_memalign(128,scratch_bytes)) == NULL) {
+		return errlog(nn,"batchpar: can't alloc %d bytes of scratch",(int)scratch_bytes);
+	}
+	if ((w->nodes = nn_calloc(seg->n_nodes,sizeof(struct nn_node))) == NULL
+		|| (w->tensors = nn_calloc(seg->n_tensors,sizeof(struct tensor))) == NULL
+		|| (w->ioptrs = nn_calloc(n_io,sizeof(void *))) == NULL
+		|| (repl_bytes > 0 && (w->repl = nn_memalign(128,repl_bytes)) == NULL)) {
+		return errlog(nn,"batchpar: can't alloc worker");
+	}
+	n_io = 0;
+	for (node = seg->first, k = 0; ; node = node->next, k++) {
+		struct nn_node *copy = &w->nodes[k];
+		*copy = *node;
+		copy->next = NULL;
+		copy->batchpar = NULL;
+		copy->prefetch.tensor = NULL;
+		copy->inputs = (const struct tensor **)&w->ioptrs[n_io];
+		for (j = 0; j < node->n_inputs; j++) {
+			i = batchpar_find(seg,node->inputs[j]);
+			if (seg->tensors[i].kind == NN_BATCHPAR_EXT_SHARED) copy->inputs[j] = node->inputs[j];
+			else copy->inputs[j] = &w->tensors[i];
+		}
+		n_io += node->n_inputs;
+		copy->outputs = (struct tensor **)&w->ioptrs[n_io];
+		for (j = 0; j < node->n_outputs; j++) {
+			copy->outputs[j] = &w->tensors[batchpar_find(seg,node->outputs[j])];
+		}
+		n_io += node->n_outputs;
+		if (node == seg->last) break;
+	}
+	return 0;
+}
+
+static void batchpar_worker_free(struct nn_batchpar_worker *w)
+{
+	if (w->shadow != NULL) {
+		if (w->shadow->scratch != NULL) nn_free(w->shadow->scratch);
+		nn_free(w->shadow);
+	}
+	if (w->nodes != NULL) nn_free(w->nodes);
+	if (w->tensors != NULL) nn_free(w->tensors);
+	if (w->ioptrs != NULL) nn_free(w->ioptrs);
+	if (w->repl != NULL) nn_free(w->repl);
+}
+
+static void batchpar_seg_free(struct nn_batchpar_segment *seg)
+{
+	int i;
+	if (seg->workers != NULL) {
+		for (i = 0; i < seg->n_workers; i++) batchpar_worker_free(&seg->workers[i]);
+		nn_free(seg->workers);
+	}
+	if (seg->tensors != NULL) nn_free(seg->tensors);
+	nn_free(seg);
+}
+
+static int batchpar_seg_setup(struct nn_graph *nn, struct nn_batchpar_segment *seg, int n_workers)
+{
+	struct nn_batchpar_tensor *tensors;
+	int i;
+	// trim the tensor table to size
+	if ((tensors = nn_malloc(seg->n_tensors * sizeof(*tensors))) == NULL) return errlog(nn,"batchpar: can't alloc");
+	memcpy(tensors,seg->tensors,seg->n_tensors * sizeof(*tensors));
+	seg->tensors = tensors;
+	if ((seg->workers = nn_calloc(n_workers,sizeof(*seg->workers))) == NULL) return errlog(nn,"batchpar: can't alloc");
+	seg->n_workers = n_workers;
+	for (i = 0; i < n_workers; i++) {
+		if (batchpar_worker_setup(nn,seg,&seg->workers[i]) != 0) return -1;
+	}
+	return 0;
+}
+
+int nn_batchpar_plan_graph(struct nn_graph *nn)
+{
+	struct nn_batchpar_segment scan;
+	struct nn_batchpar_segment *seg;
+	struct nn_node *node;
+	int n_workers = nn_option_get(nn,batch_parallel);
+	int n_segs = 0;
+
+	for (node = nn->head; node != NULL; node = node->next) node->batchpar = NULL;
+	if (n_workers > Num_Vector_Threads) n_workers = Num_Vector_Threads;
+	if (n_workers < 2) return 0;
+	if ((scan.tensors = nn_malloc(BATCHPAR_MAX_TENSORS * sizeof(*scan.tensors))) == NULL) {
+		return errlog(nn,"can't alloc batchpar plan");
+	}
+	for (node = nn->head; node != NULL; ) {
+		scan.n_nodes = 0;
+		scan.n_tensors = 0;
+		while (node != NULL && batchpar_try_add(&scan,node)) node = node->next;
+		if (scan.n_nodes == 0) {
+			node = node->next;
+			continue;
+		}
+		if ((seg = nn_calloc(1,sizeof(*seg))) == NULL) {
+			nn_free(scan.tensors);
+			return errlog(nn,"can't alloc batchpar segment");
+		}
+		seg->first = scan.first;
+		seg->last = scan.last;
+		seg->n_nodes = scan.n_nodes;
+		seg->n_tensors = scan.n_tensors;
+		seg->tensors = scan.tensors;
+		seg->next = nn->batchpar_segs;
+		nn->batchpar_segs = seg;
+		if (batchpar_seg_setup(nn,seg,n_workers) != 0) {
+			if (seg->tensors == scan.tensors) seg->tensors = NULL;
+			nn_free(scan.tensors);
+			return -1;
+		}
+		seg->first->batchpar = seg;
+		logmsg(nn,2,"batchpar: %d nodes from %x to %x",seg->n_nodes,seg->first->node_id,seg->last->node_id);
+		n_segs++;
+	}
+	nn_free(scan.tensors);
+	logmsg(nn,2,"batchpar: %d segments, %d workers",n_segs,n_workers);
+	return 0;
+}
+
+void nn_batchpar_free(struct nn_graph *nn)
+{
+	struct nn_batchpar_segment *seg;
+	while ((seg = nn->batchpar_segs) != NULL) {
+		nn->batchpar_segs = seg->next;
+		batchpar_seg_free(seg);
+	}
+}
+
+//
+// find the batches and split them over the workers, and set up the
+// workers' views; returns the # of workers to use (0 to run sequentially).
+//
+static int batchpar_split(struct nn_graph *nn, struct nn_batchpar_segment *seg)
+{
+	uint32_t batches = 0;
+	uint32_t quant = nn->batchseq.batch_quant;
+	uint32_t units;
+	int n_workers;
+	int i,w;
+
+	for (i = 0; i < seg->n_tensors; i++) {
+		struct nn_batchpar_tensor *e = &seg->tensors[i];
+		if (e->kind == NN_BATCHPAR_EXT_BATCHED) batches = max_u32(batches,e->real->shape.batches);
+	}
+	if (batches < 2) return 0;
+	for (i = 0; i < seg->n_tensors; i++) {
+		struct nn_batchpar_tensor *e = &seg->tensors[i];
+		const struct tensor *t = e->real;
+		if (e->kind == NN_BATCHPAR_EXT_BATCHED) {
+			if (t->shape.batches != 1 && (t->shape.batches != batches || t->data_size % batches != 0)) return 0;
+		} else if (e->kind == NN_BATCHPAR_OUT_BATCHED) {
+			if (batches > e->max_batches) return 0;
+		}
+	}
+	if (quant < 2 || batches % quant != 0 || batches / quant < 2) quant = 1;
+	units = batches / quant;
+	n_workers = min_i32(seg->n_workers,units);
+	for (w = 0; w < n_workers; w++) {
+		struct nn_batchpar_worker *wk = &seg->workers[w];
+		wk->b0 = (w * units / n_workers) * quant;
+		wk->nb = ((w+1) * units / n_workers) * quant - wk->b0;
+		for (i = 0; i < seg->n_tensors; i++) {
+			struct nn_batchpar_tensor *e = &seg->tensors[i];
+			struct tensor *v = &wk->tensors[i];
+			uint32_t per;
+			if (e->kind == NN_BATCHPAR_EXT_SHARED) continue;
+			*v = *e->real;
+			v->self = v;
+			switch (e->kind) {
+			case NN_BATCHPAR_EXT_BATCHED:
+				if (v->shape.batches == 1) break;
+				per = v->data_size / batches;
+				v->data = (char *)v->data + wk->b0 * per;
+				v->shape.batches = wk->nb;
+				v->data_size = v->max_size = wk->nb * per;
+				break;
+			case NN_BATCHPAR_OUT_BATCHED:
+				v->data = (char *)v->data + wk->b0 * e->stride;
+				v->max_size = wk->nb * e->stride;
+				break;
+			case NN_BATCHPAR_OUT_REPLICATED:
+				v->data = (char *)wk->repl + e->repl_offset;
+				break;
+			}
+		}
+	}
+	return n_workers;
+}
+
+static void batchpar_worker_run(struct nn_graph *nn_thread, void *vw)
+{
+	struct nn_batchpar_worker *w = vw;
+	struct nn_graph *nn = w->shadow;
+	int i;
+	w->err = 0;
+	for (i = 0; i < w->seg->n_nodes; i++) {
+		struct nn_node *node = &w->nodes[i];
+		nn_scratch_reset(nn);
+		if ((w->err = node->ops->execute(node,nn)) != 0) break;
+	}
+	nn_sem_post(w->donesem);
+}
+
+//
+// check what the workers made, and if it's all as expected, put it
+// together in the real outputs; otherwise return -1 (and change nothing
+// which the segment would not write anyway).
+//
+static int batchpar_gather(struct nn_graph *nn, struct nn_batchpar_segment *seg, int n_workers)
+{
+	struct nn_batchpar_worker *w0 = &seg->workers[0];
+	uint32_t batches = 0;
+	int i,w;
+
+	for (w = 0; w < n_workers; w++) {
+		if (seg->workers[w].err != 0) return -1;
+		batches += seg->workers[w].nb;
+	}
+	for (i = 0; i < seg->n_tensors; i++) {
+		struct nn_batchpar_tensor *e = &seg->tensors[i];
+		const struct tensor *v0 = &w0->tensors[i];
+		uint32_t per;
+		if (e->kind == NN_BATCHPAR_OUT_BATCHED) {
+			if (v0->shape.batches != w0->nb || v0->data_size % w0->nb != 0) return -1;
+			per = v0->data_size / w0->nb;
+			if (per > e->stride || (per != e->stride && e->shared_storage)) return -1;
+			for (w = 1; w < n_workers; w++) {
+				const struct tensor *v = &seg->workers[w].tensors[i];
+				if (v->shape.batches != seg->workers[w].nb || v->data_size != v->shape.batches * per
+					|| v->shape.height != v0->shape.height || v->shape.width != v0->shape.width
+					|| v->shape.depth != v0->shape.depth) return -1;
+			}
+		} else if (e->kind == NN_BATCHPAR_OUT_REPLICATED) {
+			if (v0->data_size > e->real->max_size) return -1;
+			for (w = 1; w < n_workers; w++) {
+				const struct tensor *v = &seg->workers[w].tensors[i];
+				if (memcmp(&v->shape,&v0->shape,sizeof(v->shape)) != 0 || v->data_size != v0->data_size
+					|| memcmp(v->data,v0->data,v0->data_size) != 0) return -1;
+			}
+		}
+	}
+	for (i = 0; i < seg->n_tensors; i++) {
+		struct nn_batchpar_tensor *e = &seg->tensors[i];
+		const struct tensor *v0 = &w0->tensors[i];
+		struct tensor *t = e->real;
+		uint32_t per;
+		if (e->kind == NN_BATCHPAR_OUT_BATCHED) {
+			per = v0->data_size / w0->nb;
+			t->shape = v0->shape;
+			t->shape.batches = batches;
+			t->data_size = batches * per;
+			t->format = v0->format;
+			if (per == e->stride) continue;
+			// pack the slices
+			for (w = 1; w < n_workers; w++) {
+				struct nn_batchpar_worker *wk = &seg->workers[w];
+				memmove((char *)t->data + wk->b0 * per, (char *)t->data + wk->b0 * e->stride, wk->nb * per);
+			}
+		} else if (e->kind == NN_BATCHPAR_OUT_REPLICATED) {
+			t->shape = v0->shape;
+			t->data_size = v0->data_size;
+			t->format = v0->format;
+			memcpy(t->data,v0->data,v0->data_size);
+		}
+	}
+	return 0;
+}
+
+static int batchpar_run_sequential(struct nn_graph *nn, struct nn_batchpar_segment *seg)
+{
+	struct nn_node *node;
+	int err;
+	for (node = seg->first; ; node = node->next) {
+		nn_scratch_reset(nn);
+		nn->scratch_planned = (node->flags & NN_NODE_FLAG_SCRATCH_PLANNED) != 0;
+		if ((err = node->ops->execute(node,nn)) != 0) {
+			errlog(nn,"execute() failed on node id=%x in batchpar segment",node->node_id);
+			return err;
+		}
+		if (node == seg->last) break;
+	}
+	return 0;
+}
+
+int nn_batchpar_execute(struct nn_graph *nn, struct nn_batchpar_segment *seg)
+{
+	nn_sem_t donesem;
+	int n_workers = batchpar_split(nn,seg);
+	int err = 0;
+	int i;
+
+	if (n_workers >= 2) {
+		nn_sem_init(&donesem,0);
+		for (i = 0; i < n_workers; i++) {
+			seg->workers[i].donesem = &donesem;
+			nn_os_work_for_vector(nn,batchpar_worker_run,&seg->workers[i]);
+		}
+		nn_sem_wait_n_times(&donesem,n_workers);
+		if (batchpar_gather(nn,seg,n_workers) != 0) {
+			logmsg(nn,2,"batchpar: segment at node %x didn't split; running it in sequence",seg->first->node_id);
+			n_workers = 0;
+		}
+	}
+	if (n_workers < 2) err = batchpar_run_sequential(nn,seg);
+	return err;
+}
+
+// Tracing, the node observer and output reporting all need do_execute to see each
+// node on its own; while any of them is on, segments are not used.
+int nn_batchpar_enabled(struct nn_graph *nn)
+{
+	if (nn->node_observer != NULL || nn->trace != NULL) return 0;
+	if (nn_option_get(nn,debug_show_output_tensors)) return 0;
+#if defined(V66)
+	if (nn->debug_level && nn->enable_tensor_print) return 0;
+#endif
+	return 1;
+}
+
+// The nodes of a segment run interleaved, on several threads, so there's no time
+// for each one; split what the segment took evenly over its nodes.
+void nn_batchpar_account(struct nn_batchpar_segment *seg, uint64_t perf, uint64_t cycles)
+{
+	struct nn_node *node;
+	uint64_t n = seg->n_nodes;
+	for (node = seg->first; ; node = node->next) {
+		node->perfcounter += perf / n;
+		node->executions += 1;
+		node->iter_cycles = cycles / n;
+		if (node == seg->last) break;
+	}
+	// the remainder goes to the first node, so the totals still add up
+	seg->first->perfcounter += perf % n;
+	seg->first->iter_cycles += cycles % n;
+}
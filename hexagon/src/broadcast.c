@@ -177,6 +177,17 @@ int nn_check_prepare_hvx_opt(
 
 	return opt_flag;
 }
+
+// scratch_hint for ops which use nn_check_prepare_hvx_opt: a broadcast operand is
+// expanded to the size of the other one, i.e. of the output.
+int nn_check_prepare_hvx_opt_scratch_hint(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	struct output const *od0 = &self->output_defs[0];
+	uint32_t elements = mulu32_x4_sat(od0->max_sizes[0],od0->max_sizes[1],od0->max_sizes[2],od0->max_sizes[3]);
+	if (elements == 0 || elements > (1u<<30)) return -1;
+	*bytes = ROUNDUP(elements+ALIGN_SIZE);
+	return 0;
+}
 #ifdef NEW_BROADCAST
 //
 // This handles elementwise operations, possibly with broadcast, on arbitrary type & operator.
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the copy engine (see nn_graph_copyeng.h).
+ *
+ * Descriptor n (counting from 0) lives in ring[n % NN_COPYENG_RING]; its fence is n+1.
+ * 'started' is advanced by whoever takes a descriptor to run (with CAS, so
+ * descriptors start in order), and done_seq[slot] is set to n when it finishes.
+ * 'completed' is then advanced past every slot whose done_seq matches, by
+ * whichever thread finishes the oldest incomplete descriptor. A slot is reused only
+ * after 'completed' has passed it, so done_seq can't be overwritten too early.
+ * Waiters count themselves in n_waiters before checking 'completed' again, and
+ * whoever advances 'completed' posts wake_sem once per waiter, so a wakeup can
+ * be spurious but not lost.
+ *
+ * Deferred copies are kept as (node, fence) in submission order; a later node
+ * conflicts with one if it reads what the node's copies write (its outputs; and
+ * for Assign, its even inputs), or writes what they read or write. Tensors are
+ * compared by their whole [data, data+max_size) range.
+ */
+#include <nn_graph.h>
+#include <quantize.h>
+#include <string.h>
+
+// The submitter prefetches the first this-many bytes of a 1-D copy; the rest is
+// prefetched by the thread which runs it.
+#define NN_COPYENG_L2FETCH0 1024
+
+void nn_copyeng_init(struct nn_graph *nn)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	int i;
+	nn_sem_init(&ce->wake_sem,0);
+	ce->submitted = 0;
+	ce->started = 0;
+	ce->completed = 0;
+	ce->n_waiters = 0;
+	ce->defer_ok = 0;
+	ce->n_deferred = 0;
+	// anything which is not the first seq # of the slot
+	for (i = 0; i < NN_COPYENG_RING; i++) ce->done_seq[i] = i+1;
+}
+
+int nn_copyeng_is_done(struct nn_graph *nn, nn_copy_fence_t fence)
+{
+	return (int32_t)(nn->copyeng.completed - fence) >= 0;
+}
+
+nn_copy_fence_t nn_copyeng_fence(struct nn_graph *nn)
+{
+	return nn->copyeng.submitted;
+}
+
+static void copyeng_run_desc(struct nn_graph *nn, const struct nn_copy_desc *d)
+{
+	uint32_t height = (d->height > 0) ? d->height : 1;
+	uint32_t depth = (d->depth > 0) ? d->depth : 1;
+	uint8_t *dst = (uint8_t *)d->dst;
+	const uint8_t *src = (const uint8_t *)d->src;
+	uint32_t p;
+
+	if (d->after != 0) nn_copyeng_wait_vector(nn,d->after);
+	for (p = 0; p < depth; p++) {
+		if (src == NULL) {
+			if (height == 1) vmemset_32_2d_asm(dst,d->fillval,d->width,1,0);
+			else vmemset_32_2d_general_asm(dst,d->fillval,d->width,height,d->dst_row_stride);
+		} else if (height == 1) {
+			// the submitter fetched the start of a single 1-D copy
+			uint32_t pre = (depth == 1) ? min_u32(d->width,NN_COPYENG_L2FETCH0) : 0;
+			if (d->width > pre) l2fetch(src+pre,128,128,(d->width-pre+127)>>7);
+			vmemcpy_asm(dst,src,d->width);
+		} else {
+			vmemcpy_2d_general_with_prefetch(d->width,height,dst,d->dst_row_stride,src,d->src_row_stride);
+		}
+		dst += d->dst_plane_stride;
+		if (src != NULL) src += d->src_plane_stride;
+	}
+}
+
+// mark descriptor 'seq' done, and advance 'completed' as far as possible.
+static void copyeng_retire(struct nn_graph *nn, struct nn_copyeng *ce, uint32_t seq)
+{
+	uint32_t c;
+	int advanced = 0;
+	int n_wake;
+	ce->done_seq[seq % NN_COPYENG_RING] = seq;
+	__sync_synchronize();
+	for (;;) {
+		c = ce->completed;
+		if (ce->done_seq[c % NN_COPYENG_RING] != c) break;
+		if (__sync_bool_compare_and_swap(&ce->completed,c,c+1)) advanced = 1;
+	}
+	if (!advanced) return;
+	n_wake = ce->n_waiters;
+	if (n_wake > 0) nn_sem_post_n_times(&ce->wake_sem,n_wake);
+}
+
+// take the oldest unstarted descriptor, if any, and run it. Returns 0 if there was none.
+static int copyeng_run_one(struct nn_graph *nn, struct nn_copyeng *ce)
+{
+	struct nn_copy_desc desc;
+	uint32_t seq;
+	do {
+		seq = ce->started;
+		if (seq == ce->submitted) return 0;
+		desc = ce->ring[seq % NN_COPYENG_RING];
+	} while (!__sync_bool_compare_and_swap(&ce->started,seq,seq+1));
+	copyeng_run_desc(nn,&desc);
+	copyeng_retire(nn,ce,seq);
+	return 1;
+}
+
+static void copyeng_work_func(struct nn_graph *nn, void *vce)
+{
+	copyeng_run_one(nn,(struct nn_copyeng *)vce);
+}
+
+// block until 'completed' advances (or might have)
+static void copyeng_block(struct nn_copyeng *ce, uint32_t completed)
+{
+	__sync_fetch_and_add(&ce->n_waiters,1);
+	if (ce->completed == completed) nn_sem_wait(&ce->wake_sem);
+	__sync_fetch_and_sub(&ce->n_waiters,1);
+}
+
+void nn_copyeng_wait(struct nn_graph *nn, nn_copy_fence_t fence)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	uint32_t c;
+	while ((int32_t)((c = ce->completed) - fence) < 0) copyeng_block(ce,c);
+}
+
+void nn_copyeng_wait_vector(struct nn_graph *nn, nn_copy_fence_t fence)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	uint32_t c;
+	while ((int32_t)((c = ce->completed) - fence) < 0) {
+		// the rest of the way is running in other threads if there's nothing left to start
+		if (!copyeng_run_one(nn,ce)) copyeng_block(ce,c);
+	}
+}
+
+nn_copy_fence_t nn_copyeng_submit(struct nn_graph *nn, const struct nn_copy_desc *desc)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	uint32_t seq = ce->submitted;
+	// if the ring is full, wait until the oldest slot is free
+	if (seq - ce->completed >= NN_COPYENG_RING) nn_copyeng_wait(nn,seq - NN_COPYENG_RING + 1);
+	if (desc->src != NULL && desc->height <= 1 && desc->depth <= 1) {
+		l2fetch(desc->src,128,128,min_u32((desc->width+127)>>7,NN_COPYENG_L2FETCH0/128));
+	}
+	ce->ring[seq % NN_COPYENG_RING] = *desc;
+	__sync_synchronize();
+	ce->submitted = seq + 1;
+	nn_os_work_for_vector(nn,copyeng_work_func,ce);
+	return seq + 1;
+}
+
+static inline int copyeng_overlap(const struct tensor *a, const struct tensor *b)
+{
+	const uint8_t *pa = a->data;
+	const uint8_t *pb = b->data;
+	if (pa == NULL || pb == NULL || a->max_size == 0 || b->max_size == 0) return 0;
+	return pa < pb + b->max_size && pb < pa + a->max_size;
+}
+
+// Assign writes its even inputs (the Variables)
+static inline int copyeng_writes_input(const struct nn_node *node, int i)
+{
+	return node->node_type == OP_Assign && (i & 1) == 0;
+}
+
+// does 'node' depend on the copies of 'dnode'?
+static int copyeng_conflict(const struct nn_node *node, const struct nn_node *dnode)
+{
+	int i,j;
+	for (i = 0; i < node->n_inputs; i++) {
+		int node_writes = copyeng_writes_input(node,i);
+		for (j = 0; j < dnode->n_inputs; j++) {
+			if ((node_writes || copyeng_writes_input(dnode,j)) && copyeng_overlap(node->inputs[i],dnode->inputs[j])) return 1;
+		}
+		for (j = 0; j < dnode->n_outputs; j++) {
+			if (copyeng_overlap(node->inputs[i],dnode->outputs[j])) return 1;
+		}
+	}
+	for (i = 0; i < node->n_outputs; i++) {
+		for (j = 0; j < dnode->n_inputs; j++) {
+			if (copyeng_overlap(node->outputs[i],dnode->inputs[j])) return 1;
+		}
+		for (j = 0; j < dnode->n_outputs; j++) {
+			if (copyeng_overlap(node->outputs[i],dnode->outputs[j])) return 1;
+		}
+	}
+	return 0;
+}
+
+// drop the deferred entries which are complete (they complete in order)
+static void copyeng_prune(struct nn_graph *nn, struct nn_copyeng *ce)
+{
+	int i,n;
+	for (n = 0; n < ce->n_deferred; n++) {
+		if (!nn_copyeng_is_done(nn,ce->deferred[n].fence)) break;
+	}
+	if (n == 0) return;
+	for (i = n; i < ce->n_deferred; i++) ce->deferred[i-n] = ce->deferred[i];
+	ce->n_deferred -= n;
+}
+
+void nn_copyeng_defer(struct nn_graph *nn, struct nn_node *self, nn_copy_fence_t fence)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	if (fence == 0) return;
+	if (!ce->defer_ok) {
+		nn_copyeng_wait(nn,fence);
+		return;
+	}
+	copyeng_prune(nn,ce);
+	if (ce->n_deferred == NN_COPYENG_MAX_DEFERRED) {
+		nn_copyeng_wait(nn,ce->deferred[0].fence);
+		copyeng_prune(nn,ce);
+	}
+	ce->deferred[ce->n_deferred].node = self;
+	ce->deferred[ce->n_deferred].fence = fence;
+	ce->n_deferred++;
+}
+
+void nn_copyeng_sync_node(struct nn_graph *nn, struct nn_node *node)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	int i;
+	copyeng_prune(nn,ce);
+	// waiting for one entry completes all the ones before it; so find the newest conflict
+	for (i = ce->n_deferred-1; i >= 0; i--) {
+		if (copyeng_conflict(node,ce->deferred[i].node)) {
+			nn_copyeng_wait(nn,ce->deferred[i].fence);
+			copyeng_prune(nn,ce);
+			return;
+		}
+	}
+}
+
+void nn_copyeng_sync_all(struct nn_graph *nn)
+{
+	struct nn_copyeng *ce = &nn->copyeng;
+	if (ce->n_deferred > 0) nn_copyeng_wait(nn,ce->deferred[ce->n_deferred-1].fence);
+	ce->n_deferred = 0;
+}
@@ -80,9 +80,22 @@ void execute_check_dst_canaries(struct nn_graph *nn, struct nn_node *node)
 	}
 }
 
+// true if anything looks at a node's outputs right after it executes
+// (in which case the node can't leave its copies running; see nn_copyeng_defer)
+static inline int execute_inspects_outputs(struct nn_graph *nn)
+{
+	if (unlikely(nn->node_observer != NULL)) return 1;
+	if (unlikely(nn_option_get(nn,debug_show_output_tensors))) return 1;
+#if defined(V66)
+	if (nn->debug_level && nn->enable_tensor_print) return 1;
+#endif
+	return 0;
+}
+
 int do_execute(struct nn_graph *nn, execute_basic_info* exe_info)
 {
 	struct nn_node *node;
+	struct nn_node *last;
 	int err = 0;
 	uint64_t perf_start;
 	uint64_t perf_stop;
@@ -109,7 +122,9 @@ int do_execute(struct nn_graph *nn, execute_basic_info* exe_info)
                 exe_info->result = NN_EXECUTE_VTCM_ACQUIRE_ERROR;
 		return errlog(nn,"vtcm acquire error");
 	}
+	nn_trace_setup(nn);	// failure just means no trace
 	nn_os_vector_workers_acquire(nn);
+	nn_trace_record(nn,0,NN_TRACE_EXEC_BEGIN,nn->id,0);
 	pcycle_start = nn_os_get_cycles(nn);
 	pcycle_overhead = nn_os_get_cycles(nn) - pcycle_start;
 	for (i = 0; i < ITERS; i++) {
@@ -124,12 +139,29 @@ int do_execute(struct nn_graph *nn, execute_basic_info* exe_info)
 		//execute_check_src_canaries(nn,node);
 		//execute_set_canaries(nn,node);
 		perf_start = nn_os_get_perfcount(nn);
+		nn_trace_node(nn,NN_TRACE_NODE_BEGIN,node);
 		pcycle_node = nn_os_get_cycles(nn);
 		nn_scratch_reset(nn);
+		nn->scratch_planned = (node->flags & NN_NODE_FLAG_SCRATCH_PLANNED) != 0;
+		// wait for any copies left running by earlier nodes that touch our tensors
+		nn_copyeng_sync_node(nn,node);
+		if (node->prefetch.tensor != NULL) nn_prefetch_issue(nn,node);
 		/* for (int j = 0; j < node->n_inputs; j++) {
 			print_tensor(node->inputs[j],"in");
 		}*/
-		if ((err = node->ops->execute(node,nn)) != 0) {
+		last = node;
+		if (node->batchpar != NULL && nn_batchpar_enabled(nn)) {
+			last = node->batchpar->last;
+			nn_copyeng_sync_all(nn);
+			err = nn_batchpar_execute(nn,node->batchpar);
+		} else {
+			// copies may only be left running when nothing looks at the outputs
+			// between here and the next node.
+			nn->copyeng.defer_ok = !execute_inspects_outputs(nn);
+			err = node->ops->execute(node,nn);
+			nn->copyeng.defer_ok = 0;
+		}
+		if (err != 0) {
                         exe_info->exe_failure_node_id = node->node_id;
                         exe_info->exe_failure_node_op_type = node->node_type;
                         if (node->node_type==NN_OPS_MAX) {
@@ -144,6 +176,7 @@ int do_execute(struct nn_graph *nn, execute_basic_info* exe_info)
 		}
 		pcycle_stop = nn_os_get_cycles(nn);
 		perf_stop = nn_os_get_perfcount(nn);
+		nn_trace_node(nn,NN_TRACE_NODE_END,node);
 
 		// Print the output tensors, if printing enabled
 #if defined(V66)
@@ -166,12 +199,20 @@ int do_execute(struct nn_graph *nn, execute_basic_info* exe_info)
 			nn_report_node_outputs( nn, 0, node);
 #endif
 		//execute_check_dst_canaries(nn,node);
-		node->perfcounter += (perf_stop - perf_start);
-		node->executions += 1;
-		node->iter_cycles = pcycle_stop - pcycle_node - pcycle_overhead;
+		if (last != node) {
+			nn_batchpar_account(node->batchpar,perf_stop - perf_start,pcycle_stop - pcycle_node - pcycle_overhead);
+		} else {
+			node->perfcounter += (perf_stop - perf_start);
+			node->executions += 1;
+			node->iter_cycles = pcycle_stop - pcycle_node - pcycle_overhead;
+		}
+		if (unlikely(nn->node_observer != NULL)) {
+			(*nn->node_observer)(nn,node,nn->node_observer_opaque);
+		}
 		//print_node_checksum(nn, node);
-		next_node = node->next;
+		next_node = last->next;
 		if(next_node == NULL){
+			nn_copyeng_sync_all(nn);
 			struct nn_loop_end_action endact = nn_loopstack_post_execute( nn, &nn->loopstack);
 			if( endact.errcode !=0){
                                 exe_info->result = NN_EXECUTE_LOOP_UPDATE_ERROR;
@@ -185,6 +226,9 @@ int do_execute(struct nn_graph *nn, execute_basic_info* exe_info)
 	} // for ITERS
         exe_info->result = NN_EXECUTE_SUCCESS;
   quit:
+	nn_copyeng_sync_all(nn);
+	nn->scratch_planned = 0;
+	nn_trace_record(nn,0,NN_TRACE_EXEC_END,nn->id,err);
 	nn_os_vector_workers_release(nn);
 	nn_os_vtcm_release(nn);
 	nn_os_hvx_power_off(nn); // THIS MUST BE CALLED WITHIN MUTEX LOCKED SECTION
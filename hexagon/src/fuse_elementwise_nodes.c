@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "expand_nodes.h"
+#include "nn_prepare.h"
+#include "nn_elementwise_chain.h"
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * Prepare pass: find chains of float elementwise ops, where each op's output
+ * is used only by the next, and replace each chain with one ElementwiseChain_f
+ * node (see nn_elementwise_chain.h).
+ *
+ * The new node goes where the first op of the chain was; so a side input of a later
+ * op is only accepted if it is a const, or made before the first op.
+ */
+
+static const int eltwc_fusible_types[] = {
+	OP_Add_f, OP_Sub_f, OP_Mul_f, OP_Minimum_f, OP_Maximum_f,
+	OP_Relu_f, OP_ReluX_f, OP_Clamp_f, OP_Neg_f, OP_Abs_f
+};
+#define ELTWC_N_FUSIBLE_TYPES ((int)(sizeof(eltwc_fusible_types)/sizeof(eltwc_fusible_types[0])))
+
+struct eltwc_build {
+	int n_steps;
+	int32_t prog[ELTWC_MAX_STEPS*ELTWC_STEP_WORDS];
+	int n_inputs;			// inputs[0] is the program
+	struct input inputs[ELTWC_MAX_INPUTS];
+};
+
+static int eltwc_fusible(int node_type)
+{
+	int i;
+	for (i = 0; i < ELTWC_N_FUSIBLE_TYPES; i++) {
+		if (eltwc_fusible_types[i] == node_type) return 1;
+	}
+	return 0;
+}
+
+static int eltwc_emit(struct eltwc_build *bp, int opcode, int opnd, float imm)
+{
+	union { float f; int32_t i; } u = { imm };
+	int32_t *step = &bp->prog[bp->n_steps*ELTWC_STEP_WORDS];
+	if (bp->n_steps >= ELTWC_MAX_STEPS) return -1;
+	step[0] = opcode;
+	step[1] = opnd;
+	step[2] = u.i;
+	bp->n_steps++;
+	return 0;
+}
+
+// find or add the operand for input 'ref' of chain[idx]; returns -1 if it can't be used.
+static int eltwc_operand(struct eltwc_build *bp, struct nn_node **chain, int idx, const struct input *ref)
+{
+	struct nn_node *node;
+	int i;
+	for (i = 1; i < bp->n_inputs; i++) {
+		if (bp->inputs[i].src_id == ref->src_id && bp->inputs[i].output_idx == ref->output_idx) return i;
+	}
+	if (bp->n_inputs >= ELTWC_MAX_INPUTS) return -1;
+	for (node = chain[0]->next; node != chain[idx]; node = node->next) {
+		if (node->node_id == ref->src_id && node->node_type != OP_Const) return -1;
+	}
+	bp->inputs[bp->n_inputs] = *ref;
+	return bp->n_inputs++;
+}
+
+static int eltwc_const_scalar(struct nn_graph *nn, const struct input *ref, float *val)
+{
+	struct nn_node *node = find_node_must_be_Const_from_ref(nn,ref);
+	if (node == NULL) return -1;
+	*val = tensor_get_float(node->outputs[0],0);
+	return 0;
+}
+
+//
+// add chain[idx] to the program. Returns -1 if it can't be added
+// (in which case *bp may have been changed).
+//
+static int eltwc_add_node(struct nn_graph *nn, struct eltwc_build *bp, struct nn_node **chain, int idx)
+{
+	struct nn_node *node = chain[idx];
+	const struct input *refs = node->input_refs;
+	const struct input *other;
+	uint32_t prev_id = (idx > 0) ? chain[idx-1]->node_id : 0;
+	float minval, maxval;
+	int opcode;
+	int opnd;
+#define ELTWC_IS_CHAIN(REF) (idx > 0 && (REF).src_id == prev_id && (REF).output_idx == 0)
+
+	switch (node->node_type) {
+	case OP_Add_f: opcode = ELTWC_ADD; break;
+	case OP_Sub_f: opcode = ELTWC_SUB; break;
+	case OP_Mul_f: opcode = ELTWC_MUL; break;
+	case OP_Minimum_f: opcode = ELTWC_MIN; break;
+	case OP_Maximum_f: opcode = ELTWC_MAX; break;
+	default: opcode = -1; break;
+	}
+	if (opcode >= 0) {
+		// binary op
+		if (idx == 0) {
+			if ((opnd = eltwc_operand(bp,chain,idx,&refs[0])) < 0) return -1;
+			if (eltwc_emit(bp,ELTWC_LOAD,opnd,0.0f) != 0) return -1;
+			other = &refs[1];
+		} else if (ELTWC_IS_CHAIN(refs[0])) {
+			other = &refs[1];
+		} else if (ELTWC_IS_CHAIN(refs[1])) {
+			other = &refs[0];
+			if (opcode == ELTWC_SUB) opcode = ELTWC_RSUB;
+		} else {
+			return -1;
+		}
+		if (ELTWC_IS_CHAIN(*other)) opnd = ELTWC_OPND_ACC;
+		else if ((opnd = eltwc_operand(bp,chain,idx,other)) < 0) return -1;
+		return eltwc_emit(bp,opcode,opnd,0.0f);
+	}
+	// unary op, on input 0
+	if (idx == 0) {
+		if ((opnd = eltwc_operand(bp,chain,idx,&refs[0])) < 0) return -1;
+		if (eltwc_emit(bp,ELTWC_LOAD,opnd,0.0f) != 0) return -1;
+	} else if (!ELTWC_IS_CHAIN(refs[0])) {
+		return -1;
+	}
+	switch (node->node_type) {
+	case OP_Relu_f:
+		return eltwc_emit(bp,ELTWC_MAX,ELTWC_OPND_IMM,0.0f);
+	case OP_ReluX_f:
+		if (eltwc_const_scalar(nn,&refs[1],&maxval) != 0 || !(maxval > 0.0f)) return -1;
+		if (eltwc_emit(bp,ELTWC_MAX,ELTWC_OPND_IMM,0.0f) != 0) return -1;
+		return eltwc_emit(bp,ELTWC_MIN,ELTWC_OPND_IMM,maxval);
+	case OP_Clamp_f:
+		if (eltwc_const_scalar(nn,&refs[1],&minval) != 0
+		 || eltwc_const_scalar(nn,&refs[2],&maxval) != 0 || !(maxval > minval)) return -1;
+		if (eltwc_emit(bp,ELTWC_MAX,ELTWC_OPND_IMM,minval) != 0) return -1;
+		return eltwc_emit(bp,ELTWC_MIN,ELTWC_OPND_IMM,maxval);
+	case OP_Neg_f:
+		return eltwc_emit(bp,ELTWC_NEG,ELTWC_OPND_IMM,0.0f);
+	case OP_Abs_f:
+		return eltwc_emit(bp,ELTWC_ABS,ELTWC_OPND_IMM,0.0f);
+	}
+	return -1;
+#undef ELTWC_IS_CHAIN
+}
+
+int fuse_elementwise_chain_nodes(struct nn_graph *nn, struct nn_node **nodep)
+{
+	struct nn_node *chain[ELTWC_MAX_STEPS];
+	struct nn_node *next;
+	struct nn_node *new_node;
+	struct eltwc_build build;
+	struct eltwc_build saved;
+	int n = 1;
+
+	if (!eltwc_fusible((*nodep)->node_type)) return 0;
+	build.n_steps = 0;
+	build.n_inputs = 1;
+	chain[0] = *nodep;
+	if (eltwc_add_node(nn,&build,chain,0) != 0) return 0;
+	while (n < ELTWC_MAX_STEPS) {
+		next = find_unique_consumer(nn,chain[n-1],ELTWC_N_FUSIBLE_TYPES,eltwc_fusible_types,CONSUMER_NOINCHECK);
+		if (next == NULL) break;
+		chain[n] = next;
+		saved = build;
+		if (eltwc_add_node(nn,&build,chain,n) != 0) {
+			build = saved;
+			break;
+		}
+		n++;
+	}
+	if (n < 2) return 0;
+
+	struct nn_node *tail = chain[n-1];
+	uint32_t tail_id = tail->node_id;
+	uint32_t prog_nid = nn_graph_new_internal_node_id(nn);
+	uint32_t prog_words = build.n_steps * ELTWC_STEP_WORDS;
+	if (do_prepend_const_node(nn,prog_nid,1,1,1,prog_words,
+			(const uint8_t *)build.prog,prog_words*sizeof(int32_t)) != 0) {
+		return errlog(nn,"can't make elementwise chain program");
+	}
+	build.inputs[0].src_id = prog_nid;
+	build.inputs[0].output_idx = 0;
+	if ((new_node = optab[OP_ElementwiseChain_f]->ctor(
+		nn,
+		tail_id,
+		OP_ElementwiseChain_f,
+		tail->padding,
+		build.n_inputs,
+		1,
+		build.inputs,
+		tail->output_defs)) == NULL) return errlog(nn,"ctor fail");
+	if (replace_node_sequence(nn,nodep,new_node,chain,n) != 0) {
+		return errlog(nn,"replace failed in fuse_elementwise_chain_nodes");
+	}
+	logmsg(nn,2,"fused %d elementwise ops (%d steps, %d inputs) into node %x",
+		n,build.n_steps,build.n_inputs,tail_id);
+	return 0;
+}
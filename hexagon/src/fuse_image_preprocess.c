@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <nn_graph.h>
+#include <string.h>
+#include "expand_nodes.h"
+#include "nn_prepare.h"
+#include "nn_image_preprocess.h"
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * Prepare pass: find image preprocessing chains
+ *
+ *   [Nv21ToRgb_8 | RgbaToRgb_8 | Argb32ToRgb_8] -> Dequantize -> [ImageTransform_f]
+ *         -> [ResizeBilinear_f] -> [Sub_f | Add_f (const)] -> [Mul_f (const)] -> Quantize
+ *
+ * where each node's output is used only by the next, and replace each with one
+ * ImagePreprocess_8 (see nn_image_preprocess.h). The chain must have the conversion,
+ * or the warp, or the resize; the normalization consts must have 1 or 3 values.
+ * A chain with both the warp and the resize is only fused if option
+ * 'imgpre_fold_resample' is set, since the result is slightly different.
+ *
+ * The new node goes where the first node of the chain was; so the non-const side inputs
+ * (transform, newdims, quantize range) must be made before that.
+ */
+
+#define IMGPRE_MAX_CHAIN 7
+
+// no node other than 'consumer' reads any output of 'producer'
+static int imgpre_only_consumer(struct nn_graph *nn, struct nn_node *producer, struct nn_node *consumer)
+{
+	struct nn_node *node;
+	int i;
+	for (node = producer->next; node != NULL; node = node->next) {
+		if (node == consumer) continue;
+		for (i = 0; i < node->n_inputs; i++) {
+			if (node->input_refs[i].src_id == producer->node_id) return 0;
+		}
+	}
+	return 1;
+}
+
+// 'ref' is usable as an input to a node which replaces head..tail
+static int imgpre_ref_ok(struct nn_node *head, struct nn_node *tail, const struct input *ref)
+{
+	struct nn_node *node;
+	for (node = head; node != NULL; node = node->next) {
+		if (node->node_id == ref->src_id && node->node_type != OP_Const) return 0;
+		if (node == tail) break;
+	}
+	return 1;
+}
+
+static int imgpre_is_chain(const struct input *ref, const struct nn_node *prev)
+{
+	return ref->src_id == prev->node_id && ref->output_idx == 0;
+}
+
+// get a per-channel const (1 or 3 floats)
+static int imgpre_const_channel_parms(struct nn_graph *nn, const struct input *ref, float *vals)
+{
+	struct nn_node *node = find_node_must_be_Const_from_ref(nn, ref);
+	const struct tensor *t;
+	if (node == NULL) return -1;
+	t = node->outputs[0];
+	if (t->shape.batches != 1 || t->shape.height != 1 || t->shape.width != 1) return -1;
+	if (t->shape.depth == 1 && t->data_size == sizeof(float)) {
+		vals[0] = vals[1] = vals[2] = tensor_get_float(t, 0);
+	} else if (t->shape.depth == 3 && t->data_size == 3 * sizeof(float)) {
+		vals[0] = tensor_get_float(t, 0);
+		vals[1] = tensor_get_float(t, 1);
+		vals[2] = tensor_get_float(t, 2);
+	} else {
+		return -1;
+	}
+	return 0;
+}
+
+static uint32_t imgpre_make_const3(struct nn_graph *nn, const float *vals)
+{
+	uint32_t nid = nn_graph_new_internal_node_id(nn);
+	if (do_prepend_const_node(nn, nid, 1, 1, 1, 3, (const uint8_t *)vals, 3 * sizeof(float)) != 0) return 0;
+	return nid;
+}
+
+static void imgpre_set_ref(struct input *ref, uint32_t src_id)
+{
+	ref->src_id = src_id;
+	ref->output_idx = 0;
+}
+
+int fuse_image_preprocess_nodes(struct nn_graph *nn, struct nn_node **nodep)
+{
+	struct nn_node *chain[IMGPRE_MAX_CHAIN];
+	struct nn_node *conv = NULL, *dequant, *warp = NULL, *resize = NULL, *quant = NULL;
+	struct nn_node *cur, *next;
+	struct input inputs[IMGPRE_N_INPUTS];
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	float scale[3] = { 1.0f, 1.0f, 1.0f };
+	int32_t format;
+	int32_t flags = 0;
+	int stage = 0;		// 1 = warp, 2 = resize, 3 = add/sub, 4 = mul: each may only follow lower ones
+	int n = 0;
+	int i;
+
+	switch ((*nodep)->node_type) {
+	case OP_Nv21ToRgb_8: format = IMGPRE_FMT_NV21; break;
+	case OP_RgbaToRgb_8: format = IMGPRE_FMT_RGBA; break;
+	case OP_Argb32ToRgb_8: format = IMGPRE_FMT_ARGB; break;
+	case OP_Dequantize: format = IMGPRE_FMT_RGB; break;
+	default: return 0;
+	}
+	if (format != IMGPRE_FMT_RGB) {
+		conv = *nodep;
+		chain[n++] = conv;
+		dequant = find_unique_consumer_mustbe(nn, conv, OP_Dequantize, CONSUMER_NOINCHECK);
+		if (dequant == NULL || !imgpre_only_consumer(nn, conv, dequant)) return 0;
+		for (i = 0; i < 3; i++) {
+			if (dequant->input_refs[i].src_id != conv->node_id || dequant->input_refs[i].output_idx != i) return 0;
+		}
+	} else {
+		// a plain qu8 image: must be known to have depth 3
+		dequant = *nodep;
+		if (dequant->output_defs[0].rank != 4 || dequant->output_defs[0].max_sizes[3] != 3) return 0;
+	}
+	chain[n++] = dequant;
+
+	for (cur = dequant; quant == NULL; cur = next) {
+		const struct input *refs;
+		next = find_unique_consumer_anytype(nn, cur, CONSUMER_NOINCHECK);
+		if (next == NULL || n >= IMGPRE_MAX_CHAIN || !imgpre_only_consumer(nn, cur, next)) return 0;
+		refs = next->input_refs;
+		switch (next->node_type) {
+		case OP_ImageTransform_f:
+			if (stage >= 1 || !imgpre_is_chain(&refs[0], cur)) return 0;
+			warp = next;
+			flags |= IMGPRE_FLAG_WARP;
+			stage = 1;
+			break;
+		case OP_ResizeBilinear_f:
+			if (stage >= 2 || !imgpre_is_chain(&refs[0], cur)) return 0;
+			if (next->n_inputs == 3) {
+				struct nn_node *ac = find_node_must_be_Const_from_ref(nn, &refs[2]);
+				if (ac == NULL) return 0;
+				if (tensor_get_int32(ac->outputs[0], 0) != 0) flags |= IMGPRE_FLAG_ALIGN_CORNERS;
+			}
+			resize = next;
+			flags |= IMGPRE_FLAG_RESIZE;
+			stage = 2;
+			break;
+		case OP_Sub_f:
+			if (stage >= 3 || !imgpre_is_chain(&refs[0], cur)) return 0;
+			if (imgpre_const_channel_parms(nn, &refs[1], mean) != 0) return 0;
+			stage = 3;
+			break;
+		case OP_Add_f:
+			// x + c is exactly x - (-c)
+			if (stage >= 3) return 0;
+			if (imgpre_const_channel_parms(nn, imgpre_is_chain(&refs[0], cur) ? &refs[1] : &refs[0], mean) != 0) return 0;
+			for (i = 0; i < 3; i++) mean[i] = -mean[i];
+			stage = 3;
+			break;
+		case OP_Mul_f:
+			if (stage >= 4) return 0;
+			if (imgpre_const_channel_parms(nn, imgpre_is_chain(&refs[0], cur) ? &refs[1] : &refs[0], scale) != 0) return 0;
+			stage = 4;
+			break;
+		case OP_Quantize:
+			if (!imgpre_is_chain(&refs[0], cur)) return 0;
+			quant = next;
+			break;
+		default:
+			return 0;
+		}
+		chain[n++] = next;
+	}
+	if (conv == NULL && warp == NULL && resize == NULL) return 0;
+	if (warp != NULL && resize != NULL && !nn_option_get(nn, imgpre_fold_resample)) return 0;
+
+	// side inputs
+	if ((warp != NULL && !imgpre_ref_ok(chain[0], quant, &warp->input_refs[1]))
+		|| (resize != NULL && !imgpre_ref_ok(chain[0], quant, &resize->input_refs[1]))
+		|| !imgpre_ref_ok(chain[0], quant, &quant->input_refs[1])
+		|| !imgpre_ref_ok(chain[0], quant, &quant->input_refs[2])) return 0;
+
+	inputs[IMGPRE_IN_DATA] = chain[0]->input_refs[0];
+	imgpre_set_ref(&inputs[IMGPRE_IN_FORMAT], create_const_int32_op(nn, format));
+	if (conv != NULL) {
+		inputs[IMGPRE_IN_ISBGR] = conv->input_refs[1];
+	} else {
+		imgpre_set_ref(&inputs[IMGPRE_IN_ISBGR], create_const_int32_op(nn, 0));
+	}
+	if (format == IMGPRE_FMT_NV21) {
+		imgpre_set_ref(&inputs[IMGPRE_IN_MIN], create_const_float_op(nn, 0.0f));
+		imgpre_set_ref(&inputs[IMGPRE_IN_MAX], create_const_float_op(nn, 255.0f));
+	} else if (conv != NULL) {
+		inputs[IMGPRE_IN_MIN] = conv->input_refs[2];
+		inputs[IMGPRE_IN_MAX] = conv->input_refs[3];
+	} else {
+		inputs[IMGPRE_IN_MIN] = dequant->input_refs[1];
+		inputs[IMGPRE_IN_MAX] = dequant->input_refs[2];
+	}
+	if (warp != NULL) {
+		inputs[IMGPRE_IN_TRANSFORM] = warp->input_refs[1];
+	} else {
+		imgpre_set_ref(&inputs[IMGPRE_IN_TRANSFORM], create_const_float_op(nn, 0.0f));
+	}
+	if (resize != NULL) {
+		inputs[IMGPRE_IN_NEWDIMS] = resize->input_refs[1];
+	} else {
+		imgpre_set_ref(&inputs[IMGPRE_IN_NEWDIMS], create_const_int32_op(nn, 0));
+	}
+	imgpre_set_ref(&inputs[IMGPRE_IN_FLAGS], create_const_int32_op(nn, flags));
+	imgpre_set_ref(&inputs[IMGPRE_IN_MEAN], imgpre_make_const3(nn, mean));
+	imgpre_set_ref(&inputs[IMGPRE_IN_SCALE], imgpre_make_const3(nn, scale));
+	inputs[IMGPRE_IN_OUT_MIN] = quant->input_refs[1];
+	inputs[IMGPRE_IN_OUT_MAX] = quant->input_refs[2];
+	for (i = 0; i < IMGPRE_N_INPUTS; i++) {
+		if (inputs[i].src_id == 0) return errlog(nn, "can't make consts for image preprocess");
+	}
+
+	struct nn_node *new_node;
+	uint32_t tail_id = quant->node_id;
+	if ((new_node = optab[OP_ImagePreprocess_8]->ctor(
+		nn,
+		tail_id,
+		OP_ImagePreprocess_8,
+		quant->padding,
+		IMGPRE_N_INPUTS,
+		3,
+		inputs,
+		quant->output_defs)) == NULL) return errlog(nn, "ctor fail");
+	if (replace_node_sequence(nn, nodep, new_node, chain, n) != 0) {
+		return errlog(nn, "replace failed in fuse_image_preprocess_nodes");
+	}
+	logmsg(nn, 2, "fused %d image preprocessing ops (format %d, flags %d) into node %x",
+		n, (int)format, (int)flags, tail_id);
+	return 0;
+}
@@ -714,6 +714,7 @@ int hexagon_nn_init_with_info(hexagon_nn_nn_id* g, const struct initinfo* info)
 
 	graph->state = NN_GRAPH_CONSTRUCTION;
 	nn_mutex_init(&graph->log_mutex);
+	nn_copyeng_init(graph);
 	if ((graph->scratch = nn_memalign(128,SCRATCH_SIZE)) == NULL) {
 		nn_free(graph);
 		return -1;
@@ -1389,6 +1390,102 @@ int hexagon_nn_domains_get_perfinfo(
 	return hexagon_nn_get_perfinfo(id, info_out, info_out_len, n_items_out);
 }
 
+int hexagon_nn_get_perfinfo_traffic(nn_id_t id,
+	struct perfinfo_traffic *info_out,
+	unsigned int info_out_len,
+	unsigned int *n_items_out)
+{
+	struct nn_graph *graph;
+	if ((graph = nn_id_to_graph(id)) == NULL) {
+		return errlog(NULL,"nn id %x not found",id);
+	}
+	if ((*n_items_out=do_perfinfo_traffic_get(graph,info_out,info_out_len))==~0U) {
+		return -1;
+	} else {
+		return 0;
+	}
+}
+
+int hexagon_nn_domains_get_perfinfo_traffic(
+	remote_handle64 h,
+	nn_id_t id,
+	struct perfinfo_traffic *info_out,
+	unsigned int info_out_len,
+	unsigned int *n_items_out)
+{
+	UNUSED_PARAM(h);
+	return hexagon_nn_get_perfinfo_traffic(id, info_out, info_out_len, n_items_out);
+}
+
+int hexagon_nn_get_trace(nn_id_t id,
+	struct trace_event *events_out,
+	unsigned int events_out_len,
+	unsigned int *n_events_out)
+{
+	struct nn_graph *graph;
+	if ((graph = nn_id_to_graph(id)) == NULL) {
+		return errlog(NULL,"nn id %x not found",id);
+	}
+	*n_events_out = do_trace_get(graph,events_out,events_out_len);
+	return 0;
+}
+
+int hexagon_nn_domains_get_trace(
+	remote_handle64 h,
+	nn_id_t id,
+	struct trace_event *events_out,
+	unsigned int events_out_len,
+	unsigned int *n_events_out)
+{
+	UNUSED_PARAM(h);
+	return hexagon_nn_get_trace(id, events_out, events_out_len, n_events_out);
+}
+
+int hexagon_nn_get_tuning_db(nn_id_t id,
+	struct tuning_record *records_out,
+	unsigned int records_out_len,
+	unsigned int *n_records_out)
+{
+	struct nn_graph *graph;
+	if ((graph = nn_id_to_graph(id)) == NULL) {
+		return errlog(NULL,"nn id %x not found",id);
+	}
+	*n_records_out = do_tuning_db_get(graph,records_out,records_out_len);
+	return 0;
+}
+
+int hexagon_nn_domains_get_tuning_db(
+	remote_handle64 h,
+	nn_id_t id,
+	struct tuning_record *records_out,
+	unsigned int records_out_len,
+	unsigned int *n_records_out)
+{
+	UNUSED_PARAM(h);
+	return hexagon_nn_get_tuning_db(id, records_out, records_out_len, n_records_out);
+}
+
+int hexagon_nn_set_tuning_db(nn_id_t id,
+	const struct tuning_record *records,
+	unsigned int n_records)
+{
+	struct nn_graph *graph;
+	if ((graph = nn_id_to_graph(id)) == NULL) {
+		return errlog(NULL,"nn id %x not found",id);
+	}
+	return do_tuning_db_set(graph,records,n_records);
+}
+
+int hexagon_nn_domains_set_tuning_db(
+	remote_handle64 h,
+	nn_id_t id,
+	const struct tuning_record *records,
+	unsigned int n_records)
+{
+	UNUSED_PARAM(h);
+	return hexagon_nn_set_tuning_db(id, records, n_records);
+}
+
 int hexagon_nn_reset_perfinfo(nn_id_t id, uint32_t event)
 {
 	struct nn_graph *graph;
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the s-t minimum cut solver (see nn_graph_mincut.h).
+ * It's Dinic's algorithm; the blocking-flow search is done without recursion,
+ * since the level graph can be as deep as the node list.
+ */
+#include <nn_graph.h>
+#include <nn_graph_mincut.h>
+
+int nn_mincut_init(struct nn_graph *nn, struct nn_mincut *mc, int nvert, int max_edges)
+{
+	memset(mc, 0, sizeof(*mc));
+	if (nvert < 2 || max_edges < 0) return errlog(nn, "bad mincut size %d,%d", nvert, max_edges);
+	mc->nvert = nvert;
+	mc->max_edges = 2 * max_edges;
+	mc->edges = nn_calloc(mc->max_edges + 2, sizeof(struct nn_mincut_edge));
+	mc->first = nn_malloc(5 * nvert * sizeof(int32_t));
+	mc->source_side = nn_calloc(nvert, 1);
+	if (mc->edges == NULL || mc->first == NULL || mc->source_side == NULL) {
+		nn_mincut_free(mc);
+		return errlog(nn, "can't alloc mincut for %d vertices, %d edges", nvert, max_edges);
+	}
+	mc->level = mc->first + nvert;
+	mc->iter = mc->level + nvert;
+	mc->queue = mc->iter + nvert;
+	mc->path = mc->queue + nvert;
+	for (int i = 0; i < nvert; i++) mc->first[i] = -1;
+	return 0;
+}
+
+void nn_mincut_free(struct nn_mincut *mc)
+{
+	if (mc->edges) nn_free(mc->edges);
+	if (mc->first) nn_free(mc->first);
+	if (mc->source_side) nn_free(mc->source_side);
+	mc->edges = NULL;
+	mc->first = NULL;
+	mc->source_side = NULL;
+}
+
+int nn_mincut_add_edge(struct nn_mincut *mc, int a, int b, int64_t cap)
+{
+	if (cap <= 0 || a == b) return 0;
+	if (a == NN_MINCUT_SINK || b == NN_MINCUT_SOURCE) return 0;	// can't be cut
+	if (mc->nedges + 2 > mc->max_edges) return -1;
+	if (cap > NN_MINCUT_INF) cap = NN_MINCUT_INF;
+	struct nn_mincut_edge *e = &mc->edges[mc->nedges];
+	e[0].to = b;
+	e[0].cap = cap;
+	e[0].next = mc->first[a];
+	mc->first[a] = mc->nedges;
+	e[1].to = a;
+	e[1].cap = 0;
+	e[1].next = mc->first[b];
+	mc->first[b] = mc->nedges + 1;
+	mc->nedges += 2;
+	return 0;
+}
+
+// build the level graph; returns 1 if the sink is reachable.
+static int mincut_bfs(struct nn_mincut *mc)
+{
+	int32_t *level = mc->level;
+	int32_t *queue = mc->queue;
+	int head = 0, tail = 0;
+	for (int i = 0; i < mc->nvert; i++) level[i] = -1;
+	level[NN_MINCUT_SOURCE] = 0;
+	queue[tail++] = NN_MINCUT_SOURCE;
+	while (head < tail) {
+		int v = queue[head++];
+		for (int e = mc->first[v]; e >= 0; e = mc->edges[e].next) {
+			int to = mc->edges[e].to;
+			if (mc->edges[e].cap > 0 && level[to] < 0) {
+				level[to] = level[v] + 1;
+				queue[tail++] = to;
+			}
+		}
+	}
+	return level[NN_MINCUT_SINK] >= 0;
+}
+
+// find augmenting paths in the level graph until it's blocked.
+static int64_t mincut_blocking_flow(struct nn_mincut *mc)
+{
+	struct nn_mincut_edge *edges = mc->edges;
+	int32_t *level = mc->level;
+	int32_t *iter = mc->iter;
+	int32_t *path = mc->path;
+	int64_t total = 0;
+	int depth = 0;
+	int v = NN_MINCUT_SOURCE;
+	memcpy(iter, mc->first, mc->nvert * sizeof(int32_t));
+
+	while (1) {
+		if (v == NN_MINCUT_SINK) {
+			int64_t f = NN_MINCUT_INF;
+			int i, back = 0;
+			for (i = 0; i < depth; i++) {
+				if (edges[path[i]].cap < f) {
+					f = edges[path[i]].cap;
+					back = i;
+				}
+			}
+			for (i = 0; i < depth; i++) {
+				edges[path[i]].cap -= f;
+				edges[path[i] ^ 1].cap += f;
+			}
+			total += f;
+			// resume from the tail of the (first) saturated edge
+			depth = back;
+			v = (depth == 0) ? NN_MINCUT_SOURCE : edges[path[depth - 1]].to;
+			continue;
+		}
+		int e;
+		for (e = iter[v]; e >= 0; e = edges[e].next) {
+			if (edges[e].cap > 0 && level[edges[e].to] == level[v] + 1) break;
+		}
+		iter[v] = e;
+		if (e >= 0) {
+			path[depth++] = e;
+			v = edges[e].to;
+			continue;
+		}
+		// dead end: drop v from the level graph, and back up.
+		level[v] = -1;
+		if (depth == 0) break;
+		depth--;
+		v = edges[path[depth] ^ 1].to;
+		iter[v] = edges[iter[v]].next;
+	}
+	return total;
+}
+
+int nn_mincut_solve(struct nn_graph *nn, struct nn_mincut *mc)
+{
+	int64_t flow = 0;
+	while (mincut_bfs(mc)) {
+		flow += mincut_blocking_flow(mc);
+	}
+	// the final bfs marked everything reachable from the source in the residual graph.
+	for (int i = 0; i < mc->nvert; i++) mc->source_side[i] = (mc->level[i] >= 0);
+	mc->cut_value = flow;
+	if (flow >= NN_MINCUT_INF) {
+		logmsg(nn, 1, "mincut: no finite cut");
+		return -1;
+	}
+	return 0;
+}
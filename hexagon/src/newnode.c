@@ -79,6 +79,9 @@ struct nn_node *alloc_node(uint32_t node_id,
         newnode->refs = 0;
         newnode->iter_cycles = 0;
         newnode->executions = 0;
+	newnode->prefetch.tensor = NULL;
+	newnode->prefetch.bytes = 0;
+	newnode->batchpar = NULL;
 
 	return newnode;
 }
@@ -173,6 +176,8 @@ struct nn_node* alloc_udo_node (struct nn_graph *nn, uint32_t node_id, uint32_t
         udo_ops->flags = ops_flag;
         udo_ops->earlywork_note_pred = NULL;
         udo_ops->earlywork_register = NULL;
+        udo_ops->alias_hint = NULL;
+        udo_ops->scratch_hint = NULL;
         (newnode->udo_info).udo_op_factory = NULL;
         (newnode->udo_info).udo_operation = NULL;
         (newnode->udo_info).udo_release_op = NULL;
@@ -186,6 +191,9 @@ struct nn_node* alloc_udo_node (struct nn_graph *nn, uint32_t node_id, uint32_t
         newnode->executions = 0;
         newnode->opaque = NULL;
         newnode->flags = 0;
+        newnode->prefetch.tensor = NULL;
+        newnode->prefetch.bytes = 0;
+        newnode->batchpar = NULL;
         udo_op_inf->node = newnode;
         udo_op_inf->graph = nn;
         (newnode->udo_info).udo_op_infra = udo_op_inf;
@@ -1083,6 +1091,8 @@ int do_teardown(struct nn_graph *nn)
         int udo_fail = 0;
         int dtor_fail = 0;
 	nn_os_workers_kill(nn);
+	nn_trace_free(nn);
+	nn_tuning_free(nn);
 	nn->state = NN_GRAPH_INVALID;
 
         if (nn->num_udos>0) {
@@ -1134,6 +1144,7 @@ int do_teardown(struct nn_graph *nn)
 
 	allocator_teardown(nn);
 	find_node_teardown(nn);
+	nn_batchpar_free(nn);
 	if (nn->fake_vtcm_ptr) nn_free(nn->fake_vtcm_ptr);
 	if (nn->inputs) nn_free((void *)nn->inputs);
 	if (nn->outputs) nn_free(nn->outputs);
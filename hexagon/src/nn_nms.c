@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * This contains the shared greedy NMS; see nn_nms.h
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "nn_nms.h"
+
+// kept boxes are tested in blocks of this many; within a block the loop has no exits
+#define NMS_BLOCK 32
+
+// the candidate order: by score descending, then by box index ascending
+static inline int cand_before(const struct nn_nms_cand *a, const struct nn_nms_cand *b)
+{
+	return a->score > b->score || (a->score == b->score && a->idx < b->idx);
+}
+
+static int compare_cands(const void *va, const void *vb)
+{
+	const struct nn_nms_cand *a = va;
+	const struct nn_nms_cand *b = vb;
+	if (cand_before(a, b)) return -1;
+	if (cand_before(b, a)) return 1;
+	return 0;
+}
+
+static inline void swap_cands(struct nn_nms_cand *a, struct nn_nms_cand *b)
+{
+	struct nn_nms_cand t = *a;
+	*a = *b;
+	*b = t;
+}
+
+// quickselect, with median-of-3 pivots
+int nn_nms_select(struct nn_nms_cand *cands, int n, int k)
+{
+	if (k >= n) return n;
+	if (k <= 0) return 0;
+	int target = k - 1;	// put the k'th best at cands[k-1]; everything before it is better
+	int lo = 0;
+	int hi = n - 1;
+	while (hi > lo) {
+		int mid = lo + (hi - lo) / 2;
+		if (cand_before(&cands[mid], &cands[lo])) swap_cands(&cands[mid], &cands[lo]);
+		if (cand_before(&cands[hi], &cands[lo])) swap_cands(&cands[hi], &cands[lo]);
+		if (cand_before(&cands[hi], &cands[mid])) swap_cands(&cands[hi], &cands[mid]);
+		// median now at mid; use it as pivot, parked at hi
+		swap_cands(&cands[mid], &cands[hi]);
+		struct nn_nms_cand pivot = cands[hi];
+		int store = lo;
+		for (int i = lo; i < hi; i++) {
+			if (cand_before(&cands[i], &pivot)) {
+				swap_cands(&cands[i], &cands[store]);
+				store++;
+			}
+		}
+		swap_cands(&cands[store], &cands[hi]);
+		if (store == target) break;
+		if (store < target) lo = store + 1;
+		else hi = store - 1;
+	}
+	return k;
+}
+
+int nn_nms_top_k(struct nn_nms_cand *cands, int n, int k)
+{
+	int m = nn_nms_select(cands, n, k);
+	qsort(cands, m, sizeof(struct nn_nms_cand), compare_cands);
+	return m;
+}
+
+void nn_nms_iter_init(struct nn_nms_iter *it, struct nn_nms_cand *cands, int n, int chunk)
+{
+	it->cands = cands;
+	it->n = n;
+	it->pos = 0;
+	it->sorted_end = 0;
+	it->chunk = (chunk > 0) ? chunk : n;
+}
+
+int nn_nms_keepset_overlaps(const struct nn_nms_keepset *ks, const struct nn_nms_params *p, float threshold,
+	float x1, float y1, float x2, float y2, float area)
+{
+	const float off = p->coord_offset;
+	const int at_equal = p->suppress_at_equal;
+	const int disjoint_is_zero = p->disjoint_is_zero;
+	const float *restrict kx1 = ks->x1;
+	const float *restrict ky1 = ks->y1;
+	const float *restrict kx2 = ks->x2;
+	const float *restrict ky2 = ks->y2;
+	const float *restrict karea = ks->area;
+	int n = ks->n;
+
+	for (int i0 = 0; i0 < n; i0 += NMS_BLOCK) {
+		int iend = (n - i0 > NMS_BLOCK) ? i0 + NMS_BLOCK : n;
+		int hit = 0;
+		for (int i = i0; i < iend; i++) {
+			float iw = fmaxf(fminf(kx2[i], x2) - fmaxf(kx1[i], x1) + off, 0.0f);
+			float ih = fmaxf(fminf(ky2[i], y2) - fmaxf(ky1[i], y1) + off, 0.0f);
+			float inter = iw * ih;
+			if (disjoint_is_zero) {
+				int apart = (kx2[i] < x1) | (kx1[i] > x2) | (ky2[i] < y1) | (ky1[i] > y2);
+				inter = apart ? 0.0f : inter;
+			}
+			float iou = inter / (karea[i] + area - inter);
+			hit |= at_equal ? (iou >= threshold) : (iou > threshold);
+		}
+		if (hit) return 1;
+	}
+	return 0;
+}
+
+int nn_nms_greedy(struct nn_nms_cand *cands, int n, const struct nn_nms_boxes *boxes,
+	const struct nn_nms_params *p, int max_keep, struct nn_nms_keepset *ks)
+{
+	struct nn_nms_iter it;
+	struct nn_nms_cand *cp;
+	int nkeep = 0;
+	// sort enough for the keep limit to be reached with some suppression, but not all of them
+	int chunk = 0;
+	if (max_keep > 0) chunk = (4 * max_keep > 64) ? 4 * max_keep : 64;
+	nn_nms_iter_init(&it, cands, n, chunk);
+	ks->n = 0;
+	while ((cp = nn_nms_iter_next(&it)) != NULL) {
+		const float *box = boxes->coords + cp->idx * boxes->stride;
+		float area = boxes->area[cp->idx * boxes->stride];
+		if (nn_nms_keepset_overlaps(ks, p, p->iou_threshold, box[0], box[1], box[2], box[3], area)) continue;
+		if (nn_nms_keepset_add(ks, box[0], box[1], box[2], box[3], area) != 0) break;
+		// cands[nkeep] has already been visited, so it can be overwritten
+		cands[nkeep++] = *cp;
+		if (nkeep == max_keep) break;
+	}
+	return nkeep;
+}
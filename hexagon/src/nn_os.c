@@ -62,6 +62,7 @@ struct tinfo {
 	struct nn_graph *nn;
 	nn_pipe_t *pipe;
 	nn_sem_t sem;
+	int idx;
 };
 
 struct nn_thread_info {
@@ -76,26 +77,44 @@ struct nn_thread_info {
 // and then post info->sem before reading the pipe;
 // *info is not readable after that.
 //
+static void worker_acquire(struct nn_graph *nn, void *vptr);
+static void worker_release(struct nn_graph *nn, void *vptr);
+
 static void *nn_os_worker(void *vinfo)
 {
 	volatile struct tinfo *info = vinfo;
 	struct nn_graph *nn = info->nn;
 	nn_pipe_t *pipe = info->pipe;
+	unsigned trace_thread = info->idx + 1;	// thread 0 in the trace is the one running do_execute
 	nn_os_workitem_t work;
 	nn_sem_post((nn_sem_t*)&info->sem);
 	while (1) {
 		work.raw = nn_pipe_recv(pipe);
 		//logmsg(nn,0,"nn_pipe_recv work.raw=%x", work.raw);
 		if (work.f == NULL) break;
+		// acquire/release just park the thread; don't trace them
+		if (unlikely(nn->trace != NULL) && work.f != worker_acquire && work.f != worker_release) {
+			nn_trace_work(nn,trace_thread,NN_TRACE_WORK_BEGIN,work.f);
+			work.f(nn,work.arg);
+			nn_trace_work(nn,trace_thread,NN_TRACE_WORK_END,work.f);
+			continue;
+		}
 		work.f(nn,work.arg);
 	}
 	//logmsg(nn,0,"worker exiting");
 	return NULL;
 }
 
+// In a batch-parallel worker (see nn_graph_batchpar.h), the work is done
+// right away, on the worker's thread.
+
 void nn_os_work_for_vector(struct nn_graph *nn, void (*f)(struct nn_graph *, void *),void *arg)
 {
 	nn_os_workitem_t msg;
+	if (unlikely(nn->batchpar_worker != NULL)) {
+		f(nn,arg);
+		return;
+	}
 	msg.f = f;
 	msg.arg = arg;
 	//logmsg(nn,0,"nn_pipe_send msg.raw=%x", msg.raw);
@@ -104,6 +123,11 @@ void nn_os_work_for_vector(struct nn_graph *nn, void (*f)(struct nn_graph *, voi
 
 void nn_os_worklist_for_vector(struct nn_graph *nn, nn_os_workitem_t *items, int n_items)
 {
+	int i;
+	if (unlikely(nn->batchpar_worker != NULL)) {
+		for (i = 0; i < n_items; i++) items[i].f(nn,items[i].arg);
+		return;
+	}
 	nn_pipe_send_multi(nn->vec_work,&items[0].raw,n_items);
 }
 
@@ -111,6 +135,10 @@ void nn_os_worklist_for_vector(struct nn_graph *nn, nn_os_workitem_t *items, int
 void nn_os_work_for_scalar(struct nn_graph *nn, void (*f)(struct nn_graph *, void *),void *arg)
 {
 	nn_os_workitem_t msg;
+	if (unlikely(nn->batchpar_worker != NULL)) {
+		f(nn,arg);
+		return;
+	}
 	msg.f = f;
 	msg.arg = arg;
 	nn_pipe_send(nn->nonvec_work, msg.raw);
@@ -323,6 +351,7 @@ int nn_os_workers_spawn(struct nn_graph *nn)
 		nn_thread_attr_setstack(&attrs,worker_info[i].stack,Stack_Size);
 		if (i < Num_Vector_Threads) info.pipe = nn->vec_work;
 		else info.pipe = nn->nonvec_work;
+		info.idx = i;
 		if (nn_thread_create(nn,&worker_info[i].tid,&attrs,nn_os_worker,&info) != 0) {
 			nn_os_join_n_threads(nn,i);
 			return nn_os_careful_free(nn,errlog(nn,"thread create fail"));
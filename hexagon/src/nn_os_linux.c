@@ -38,6 +38,112 @@
 #include <nn_graph.h>
 #include <pmu_control_linux.h>
 
+#if !defined(__hexagon__)
+/*
+ * Host builds: the perf events map onto perf_event_open counters.
+ * There is one counter per thread of the process (found in /proc/self/task when
+ * the event is selected), and nn_os_get_perfcount returns their sum, so work
+ * done in the worker threads is charged to the node that issued it.
+ * Threads created after the event is selected are not counted.
+ * Like the hexagon PMU, this is process-wide state: the last event selected
+ * by any graph wins.
+ */
+#include <string.h>
+#include <dirent.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+
+#define HOST_PERF_MAX_THREADS 64
+
+static struct {
+	uint32_t event;
+	int n_fds;
+	int fds[HOST_PERF_MAX_THREADS];
+} host_perf;
+
+static int host_perf_attr(uint32_t event, struct perf_event_attr *attr)
+{
+	memset(attr,0,sizeof(*attr));
+	attr->size = sizeof(*attr);
+	attr->type = PERF_TYPE_HARDWARE;
+	attr->exclude_kernel = 1;
+	attr->exclude_hv = 1;
+	switch (event) {
+	case NN_GRAPH_PERFEVENT_CYCLES: attr->config = PERF_COUNT_HW_CPU_CYCLES; break;
+	case NN_GRAPH_PERFEVENT_HOST_INSTRUCTIONS: attr->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+	case NN_GRAPH_PERFEVENT_HOST_CACHE_REFERENCES: attr->config = PERF_COUNT_HW_CACHE_REFERENCES; break;
+	case NN_GRAPH_PERFEVENT_HOST_CACHE_MISSES: attr->config = PERF_COUNT_HW_CACHE_MISSES; break;
+	case NN_GRAPH_PERFEVENT_HOST_BRANCH_MISSES: attr->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+	case NN_GRAPH_PERFEVENT_HOST_L1D_READ_MISSES:
+		attr->type = PERF_TYPE_HW_CACHE;
+		attr->config = PERF_COUNT_HW_CACHE_L1D
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	default: return -1;
+	}
+	return 0;
+}
+
+static void host_perf_close()
+{
+	int i;
+	for (i = 0; i < host_perf.n_fds; i++) close(host_perf.fds[i]);
+	host_perf.n_fds = 0;
+}
+
+int nn_os_perf_event_select(struct nn_graph *nn, uint32_t event)
+{
+	struct perf_event_attr attr;
+	struct dirent *ent;
+	DIR *dir;
+	int fd;
+
+	host_perf_close();
+	host_perf.event = event;
+	if (event == NN_GRAPH_PERFEVENT_UTIME
+	 || event == NN_GRAPH_PERFEVENT_USER0
+	 || event == NN_GRAPH_PERFEVENT_USER1) return 0;
+	if (host_perf_attr(event,&attr) != 0) {
+		return errlog(nn,"perf event 0x%x has no host equivalent",event);
+	}
+	if ((dir = opendir("/proc/self/task")) == NULL) {
+		return errlog(nn,"can't list threads");
+	}
+	while ((ent = readdir(dir)) != NULL && host_perf.n_fds < HOST_PERF_MAX_THREADS) {
+		pid_t tid = atoi(ent->d_name);
+		if (tid <= 0) continue;
+		if ((fd = syscall(__NR_perf_event_open,&attr,tid,-1,-1,0)) < 0) {
+			logmsg(nn,1,"perf_event_open(0x%x) failed on thread %d",event,(int)tid);
+			continue;
+		}
+		host_perf.fds[host_perf.n_fds++] = fd;
+	}
+	closedir(dir);
+	if (host_perf.n_fds == 0) {
+		return errlog(nn,"perf event 0x%x: perf_event_open failed (check perf_event_paranoid)",event);
+	}
+	return 0;
+}
+
+unsigned long long int nn_os_get_perfcount(struct nn_graph *nn)
+{
+	uint64_t ret = 0;
+	uint64_t val;
+	int i;
+
+	if (nn->perf_event == NN_GRAPH_PERFEVENT_UTIME) return nn_os_get_usecs(nn);
+	if (host_perf.n_fds == 0 || host_perf.event != nn->perf_event) {
+		// nothing selected (yet): nsecs for the default event
+		return (nn->perf_event == NN_GRAPH_PERFEVENT_CYCLES) ? nn_os_get_cycles(nn) : 0;
+	}
+	for (i = 0; i < host_perf.n_fds; i++) {
+		if (read(host_perf.fds[i],&val,sizeof(val)) == sizeof(val)) ret += val;
+	}
+	return ret;
+}
+
+#else
 unsigned long long int nn_os_get_perfcount(struct nn_graph *nn)
 {
 	uint32_t lo;
@@ -63,4 +169,6 @@ unsigned long long int nn_os_get_perfcount(struct nn_graph *nn)
 
 }
 
+#endif // __hexagon__
+
 #endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ *
+ * Now that that's out of the way, let's get to the good stuff.
+ *
+ * This contains the shared top-k selection; see nn_topk.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "nn_topk.h"
+
+// output order: by value descending, then by index descending
+static inline int elem_before(const struct nn_topk_elem *a, const struct nn_topk_elem *b)
+{
+	return a->value > b->value || (a->value == b->value && a->idx > b->idx);
+}
+
+static int compare_elems(const void *va, const void *vb)
+{
+	const struct nn_topk_elem *a = va;
+	const struct nn_topk_elem *b = vb;
+	if (elem_before(a, b)) return -1;
+	if (elem_before(b, a)) return 1;
+	return 0;
+}
+
+static inline void swap_elems(struct nn_topk_elem *a, struct nn_topk_elem *b)
+{
+	struct nn_topk_elem t = *a;
+	*a = *b;
+	*b = t;
+}
+
+// quickselect with median-of-3 pivots: leaves the k'th best at e[k-1], with the better ones before it.
+// 1 <= k <= n
+static void select_elems(struct nn_topk_elem *e, int n, int k)
+{
+	int target = k - 1;
+	int lo = 0;
+	int hi = n - 1;
+	while (hi > lo) {
+		int mid = lo + (hi - lo) / 2;
+		if (elem_before(&e[mid], &e[lo])) swap_elems(&e[mid], &e[lo]);
+		if (elem_before(&e[hi], &e[lo])) swap_elems(&e[hi], &e[lo]);
+		if (elem_before(&e[hi], &e[mid])) swap_elems(&e[hi], &e[mid]);
+		swap_elems(&e[mid], &e[hi]);
+		struct nn_topk_elem pivot = e[hi];
+		int store = lo;
+		for (int i = lo; i < hi; i++) {
+			if (elem_before(&e[i], &pivot)) {
+				swap_elems(&e[i], &e[store]);
+				store++;
+			}
+		}
+		swap_elems(&e[store], &e[hi]);
+		if (store == target) break;
+		if (store < target) lo = store + 1;
+		else hi = store - 1;
+	}
+}
+
+// Elements are scanned in increasing index order, so a new element equal to the
+// current k'th best ranks above it; hence '>=' against the threshold.
+static void topk_f_filter(const float *in, int n, int k, struct nn_topk_elem *work)
+{
+	int cap = nn_topk_f_filter_cap(k);
+	int m, i;
+	// the first 'cap' elements all go in
+	for (i = 0; i < cap; i++) {
+		work[i].value = in[i];
+		work[i].idx = i;
+	}
+	m = cap;
+	select_elems(work, m, k);
+	float thresh = work[k - 1].value;
+	m = k;
+	for (; i < n; i++) {
+		float v = in[i];
+		if (v >= thresh) {
+			work[m].value = v;
+			work[m].idx = i;
+			if (++m == cap) {
+				select_elems(work, m, k);
+				thresh = work[k - 1].value;
+				m = k;
+			}
+		}
+	}
+	select_elems(work, m, k);
+}
+
+void nn_topk_f_row(const float *in, int n, int k, float *out_val, int32_t *out_idx, struct nn_topk_elem *work)
+{
+	if (nn_topk_f_use_filter(n, k)) {
+		topk_f_filter(in, n, k, work);
+	} else {
+		for (int i = 0; i < n; i++) {
+			work[i].value = in[i];
+			work[i].idx = i;
+		}
+		select_elems(work, n, k);
+	}
+	qsort(work, k, sizeof(struct nn_topk_elem), compare_elems);
+	for (int i = 0; i < k; i++) {
+		out_val[i] = work[i].value;
+		out_idx[i] = work[i].idx;
+	}
+}
+
+void nn_topk_u8_row(const uint8_t *in, int n, int k, const uint16_t *hist, uint8_t *out_val, int32_t *out_idx)
+{
+	int32_t counts[256];
+	int32_t pos[256];
+	if (k <= 0) return;
+	if (hist != NULL) {
+		for (int v = 0; v < 256; v++) counts[v] = hist[v];
+	} else {
+		memset(counts, 0, sizeof(counts));
+		for (int i = 0; i < n; i++) counts[in[i]]++;
+	}
+	// find the cut value t: all values > t are in, and (k - #above) of the t's.
+	// pos[v] is where the first (largest index) element of value v goes.
+	int above = 0;
+	int t;
+	for (t = 255; t > 0; t--) {
+		pos[t] = above;
+		if (above + counts[t] >= k) break;
+		above += counts[t];
+	}
+	pos[t] = above;
+	int t_left = k - above;
+	int remaining = k;
+	for (int i = n - 1; i >= 0 && remaining > 0; i--) {
+		int v = in[i];
+		if (v < t) continue;
+		if (v == t) {
+			if (t_left == 0) continue;
+			t_left--;
+		}
+		int p = pos[v]++;
+		out_val[p] = v;
+		out_idx[p] = i;
+		remaining--;
+	}
+}
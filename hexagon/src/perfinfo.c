@@ -105,10 +105,16 @@ int do_perfinfo_reset(struct nn_graph *nn, uint32_t event)
 	for (node = nn->head; node != NULL; node = node->next) {
 		node->perfcounter = 0;
 	}
+#if defined(USE_OS_LINUX) && !defined(__hexagon__)
+	// host build: events map onto perf_event_open counters (see nn_os_linux.c)
+	if (nn_os_perf_event_select(nn,event) != 0) return -1;
+	nn->perf_event = event;
+#else
 	nn->perf_event = event;
 #ifndef NO_PMU_CONFIG
 	if (event != 0) config_event_hw(nn,event);
 #endif // NO_PMU_CONFIG
+#endif
 	return 0;
 }
 
@@ -128,3 +134,93 @@ int do_perfinfo_get(struct nn_graph *nn, struct perfinfo *info, uint32_t info_le
 	return i;
 }
 
+
+//
+// Estimate of the memory traffic and MACs of one execution of a node, from the
+// shapes its tensors had in the last execution.
+// Bytes are the compulsory traffic: every input (incl. weights) read once, and
+// every output written once, with d32 padding. MACs are only counted for
+// conv/matmul-like ops (out_elements * filt_height * filt_width * filt_depth)
+// and depthwise ops (out_elements * filt_height * filt_width); everything else is 0.
+//
+static void perfinfo_traffic_estimate(struct nn_node *node, struct perfinfo_traffic *t)
+{
+	uint64_t bytes_read = 0;
+	uint64_t bytes_written = 0;
+	uint64_t macs = 0;
+	uint64_t out_elements;
+	const struct tensor *filt;
+	int i;
+
+	for (i = 0; i < node->n_inputs; i++) {
+		if (node->inputs[i] != NULL) bytes_read += node->inputs[i]->data_size;
+	}
+	for (i = 0; i < node->n_outputs; i++) {
+		if (node->outputs[i] != NULL) bytes_written += node->outputs[i]->data_size;
+	}
+	if (node->n_inputs >= 2 && node->n_outputs >= 1
+	  && (filt = node->inputs[1]) != NULL && node->outputs[0] != NULL) {
+		const struct shape *os = &node->outputs[0]->shape;
+		out_elements = (uint64_t)os->batches * os->height * os->width * os->depth;
+		switch (node->node_type) {
+		case OP_QuantizedConv2d_8x8to32:
+		case OP_QuantizedConv2d_16x16to32:
+		case OP_QuantizedDilatedConv2d_8x8p32to8:
+		case OP_QuantizedGroupedConv2d_8x8p32to8:
+		case OP_Conv2d_f:
+		case OP_Supernode_8x8p8to8:
+		case OP_Supernode_8x8p8to8_d32:
+		case OP_Supernode_8x8p32to8:
+		case OP_Supernode_8x8p32to8_d32:
+		case OP_Supernode_8x8p32to8_ref:
+		case OP_Supernode3322_8x8p8to8:
+		case OP_Supernode3322_8x8p32to8:
+		case OP_InputSupernode_8x8p8to8_outd32:
+		case OP_InputSupernode_8x8p32to8_outd32:
+		case OP_Supernode_16x16p16to16:
+		case OP_Supernode_16x16p32to16:
+		case OP_Supernode_u16x16p16to16_d32:
+		case OP_Supernode_u16x16p32to16_d32:
+		case OP_InputSupernode_16x16p16to16_outd32:
+		case OP_InputSupernode_16x16p32to16_outd32:
+		case OP_QuantizedMatMul_8x8to32:
+		case OP_QuantizedMatMul_8x8p32to16:
+		case OP_MatMul_f:
+			macs = out_elements * filt->shape.filt_height * filt->shape.filt_width * filt->shape.filt_depth;
+			break;
+		case OP_QuantizedDepthwiseConv2d_8x8to32:
+		case OP_DepthwiseConv2d_f:
+		case OP_DepthwiseSupernode_8x8p8to8:
+		case OP_DepthwiseSupernode_8x8p8to8_d32:
+		case OP_DepthwiseSupernode_8x8p32to8:
+		case OP_DepthwiseSupernode_8x8p32to8_d32:
+		case OP_DepthwiseSupernode_16x16p16to16:
+		case OP_DepthwiseSupernode_16x16p16to16_d32:
+		case OP_DepthwiseSupernode_16x16p32to16:
+		case OP_DepthwiseSupernode_16x16p32to16_d32:
+			macs = out_elements * filt->shape.filt_height * filt->shape.filt_width;
+			break;
+		default:
+			break;
+		}
+	}
+	t->bytes_read = bytes_read;
+	t->bytes_written = bytes_written;
+	t->macs = macs;
+}
+
+int do_perfinfo_traffic_get(struct nn_graph *nn, struct perfinfo_traffic *info, uint32_t info_len)
+{
+	struct nn_node *node;
+	uint32_t i = 0;
+	for (node = nn->head; node != NULL; node = node->next) {
+		if (i >= info_len) return -1;
+		if( node->node_type != OP_Const){
+			info[i].node_id = node->node_id;
+			info[i].executions = node->executions;
+			perfinfo_traffic_estimate(node,&info[i]);
+			i++;
+		}
+	}
+	return i;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the look-ahead prefetch planning (see nn_graph_earlywork.h).
+ */
+#include <nn_graph.h>
+#include "quantize.h"
+
+static inline uint32_t prefetch_tensor_bytes(const struct tensor *t)
+{
+	if (t == NULL) return 0;
+	return (t->data_size != 0) ? t->data_size : t->max_size;
+}
+
+// bytes read and written by the node
+static uint32_t prefetch_footprint(const struct nn_node *node)
+{
+	uint32_t total = 0;
+	uint32_t i;
+	for (i = 0; i < node->n_inputs; i++) total += prefetch_tensor_bytes(node->inputs[i]);
+	for (i = 0; i < node->n_outputs; i++) total += prefetch_tensor_bytes(node->outputs[i]);
+	return total;
+}
+
+static int prefetch_node_touches(const struct nn_node *node, const struct tensor *t)
+{
+	uint32_t i;
+	for (i = 0; i < node->n_inputs; i++) if (node->inputs[i] == t) return 1;
+	for (i = 0; i < node->n_outputs; i++) if (node->outputs[i] == t) return 1;
+	return 0;
+}
+
+//
+// is t likely to be in L2 when nodes[idx+1] starts? This is the case if
+// nodes[idx] touches it, or an earlier node does and the footprints since then
+// add up to less than NN_PREFETCH_L2_BYTES.
+//
+static int prefetch_is_resident(struct nn_node **nodes, int idx, const struct tensor *t)
+{
+	uint32_t since = 0;
+	int k;
+	for (k = idx; k >= 0 && since < NN_PREFETCH_L2_BYTES; k--) {
+		if (prefetch_node_touches(nodes[k],t)) return 1;
+		since += prefetch_footprint(nodes[k]);
+	}
+	return 0;
+}
+
+static void prefetch_plan_node(struct nn_graph *nn, struct nn_node **nodes, int idx, uint32_t limit)
+{
+	struct nn_node *node = nodes[idx];
+	struct nn_node *next = node->next;
+	uint32_t footprint = prefetch_footprint(node);
+	uint32_t budget;
+	uint32_t best_bytes = 0;
+	const struct tensor *best = NULL;
+	uint32_t i;
+
+	// these two already do their own early work
+	if (next->ops->earlywork_note_pred != NULL && node->ops->earlywork_register != NULL) return;
+	if (footprint >= NN_PREFETCH_L2_BYTES) return;
+	budget = min_u32(NN_PREFETCH_L2_BYTES - footprint, limit);
+	if (budget < NN_PREFETCH_MIN_BYTES) return;
+	for (i = 0; i < next->n_inputs; i++) {
+		const struct tensor *t = next->inputs[i];
+		uint32_t bytes = prefetch_tensor_bytes(t);
+		if (bytes < NN_PREFETCH_MIN_BYTES || bytes <= best_bytes) continue;
+		if (prefetch_is_resident(nodes,idx,t)) continue;
+		best = t;
+		best_bytes = bytes;
+	}
+	if (best == NULL) return;
+	node->prefetch.tensor = best;
+	node->prefetch.bytes = min_u32(best_bytes,budget);
+	logmsg(nn,3,"prefetch %d bytes of %p for node %x during node %x",
+		node->prefetch.bytes,best,next->node_id,node->node_id);
+}
+
+int nn_prefetch_plan_graph(struct nn_graph *nn)
+{
+	struct nn_node *node;
+	struct nn_node **nodes;
+	int n_nodes = 0;
+	int limit_kb = nn_option_get(nn,prefetch_limit_kb);
+	uint32_t limit = (limit_kb < 0) ? NN_PREFETCH_L2_BYTES : (uint32_t)limit_kb * 1024;
+	int i;
+
+	for (node = nn->head; node != NULL; node = node->next) {
+		node->prefetch.tensor = NULL;
+		node->prefetch.bytes = 0;
+		n_nodes++;
+	}
+	if (limit == 0 || n_nodes < 2) return 0;
+	if ((nodes = nn_malloc(n_nodes * sizeof(*nodes))) == NULL) {
+		return errlog(nn,"can't alloc prefetch plan");
+	}
+	for (i = 0, node = nn->head; node != NULL; node = node->next) nodes[i++] = node;
+	for (i = 0; i < n_nodes-1; i++) prefetch_plan_node(nn,nodes,i,limit);
+	nn_free(nodes);
+	return 0;
+}
+
+void nn_prefetch_issue(struct nn_graph *nn, struct nn_node *node)
+{
+	const struct tensor *t = node->prefetch.tensor;
+	uint32_t bytes = min_u32(node->prefetch.bytes,t->data_size);
+	if (t->data == NULL || bytes == 0) return;
+	l2fetch(t->data,128,128,(bytes+127)>>7);
+}
@@ -54,6 +54,7 @@
 #include "expand_nodes.h"
 #include "nn_gentranspose.h"
 #include "udo_impl_dsp_hexnn_internal_v2.h"
+#include "nn_graph_mincut.h"
 
 // int hexagon_nn_prepare(nn_id id);
 
@@ -1607,12 +1608,20 @@ static int get_blocksize_values( struct nn_graph *nn, struct input inref,  int *
 //      D32REPL_16 | new_op   (if it's ok to convert to new_op as a 16-bit op)
 //      -1                    (if it should not be replaced).
 // The value "D32REPL_TWOIN" will be or'd in if the op has 2 inputs that need conversion.
+// Some ops are only converted when their input is already d32 (i.e. comes from a Convert_from_d32);
+// if 'assume_d32_in' is set, that is taken to be true (this is used by assign_d32_layout, before
+// anything has been converted).
 //
 #define D32REPL_16 (1<<24)
 #define D32REPL_TWOIN (1<<25)
 #define D32REPL_FLAGS  (D32REPL_16|D32REPL_TWOIN)
 
-static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode )
+static inline int is_from_d32_or_assumed( struct nn_node const * src, int convop, int assume_d32_in)
+{
+	return assume_d32_in || (src != NULL && src->node_type == convop);
+}
+
+static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode, int assume_d32_in )
 {
 	int try_op = srcnode->node_type;
 	if( (srcnode->flags &NN_NODE_FLAG_NO_CONVERT_D32) !=0)
@@ -1679,7 +1688,7 @@ static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode
 		  op_type converted_op = OP_QuantizedSoftmax_8_d32;
 		  struct nn_node * src = find_node(nn,srcnode->input_refs[0].src_id);
 		  if( src != NULL ){
-			  if(src->node_type == OP_Convert_from_d32 )
+			  if(is_from_d32_or_assumed(src,OP_Convert_from_d32,assume_d32_in))
 				  return converted_op;
 			  if(src->node_type == OP_SuperFC_8x8p32to8)
 				  return -1;
@@ -1720,7 +1729,7 @@ static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode
 		// Also supports broadcasting from A onto B with the same restrictions.
 		//
 		// Convert only if input 0 or 1 is convert_from_d32 (i.e. input already in d32) and no broadcast
-		if (    (!((src0->node_type == OP_Convert_from_d32) || (src1->node_type == OP_Convert_from_d32))) 
+		if (    (!(is_from_d32_or_assumed(src0,OP_Convert_from_d32,assume_d32_in) || (src1->node_type == OP_Convert_from_d32))) 
 			&& (check_dims_equal(&src0->output_defs[src0_idx],&src1->output_defs[src1_idx]) == 0)) {
 #if 0
 			logmsg(nn,2,"src0.od[0]: %d,%d,%d,%d src1.od[0]: %d,%d,%d,%d",
@@ -1747,7 +1756,7 @@ static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode
 		if( srcnode->n_inputs < 4) return -1;
 		struct nn_node * src = find_node(nn,srcnode->input_refs[0].src_id);
 		if (src == NULL) return errlog(nn,"Oops, can't find src of pad op");
-		if (src->node_type != (is_u16? OP_Convert_from_d32_16b: OP_Convert_from_d32)) return -1;		// Only use pad d32 if input is d32 format
+		if (!is_from_d32_or_assumed(src,is_u16? OP_Convert_from_d32_16b: OP_Convert_from_d32,assume_d32_in)) return -1;		// Only use pad d32 if input is d32 format
 		struct nn_node * dims_node = find_node_must_be_Const(nn,srcnode->input_refs[3].src_id);
 		if( dims_node == NULL || srcnode->input_refs[3].output_idx != 0 ){
 			 return -1;
@@ -1768,7 +1777,7 @@ static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode
 		if( srcnode->n_inputs < 4) return -1;
 		struct nn_node * src = find_node(nn,srcnode->input_refs[0].src_id);
 		if (src == NULL) return errlog(nn,"Oops, can't find src of pad op");
-		if (src->node_type != OP_Convert_from_d32) return -1;		// Only use pad d32 if input is d32 format
+		if (!is_from_d32_or_assumed(src,OP_Convert_from_d32,assume_d32_in)) return -1;		// Only use pad d32 if input is d32 format
 		struct nn_node * dims_node = find_node_must_be_Const(nn,srcnode->input_refs[3].src_id);
 		if( dims_node == NULL || srcnode->input_refs[3].output_idx != 0 ){
 			 return -1;
@@ -1791,7 +1800,7 @@ static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode
          struct nn_node *src = find_node(nn, srcnode->input_refs[0].src_id);
          if(src == NULL)
              return errlog(nn, "Can't find src node of Requant_8to8 op");
-         if(src->node_type != OP_Convert_from_d32)
+         if(!is_from_d32_or_assumed(src,OP_Convert_from_d32,assume_d32_in))
             return -1; //Only use d32 version if input is d32
          return OP_Requantize_8to8_d32;
      }
@@ -1938,7 +1947,7 @@ static int depth32_replacement_op(struct nn_graph * nn, struct nn_node * srcnode
 	// but only if input0 currently comes from a Convert_from_d32 node.
 	// otherwise, leave it as is. This is for ops which are not really
 	// any more efficient in d32 mode.
-	if( new_op > 0){
+	if( new_op > 0 && !assume_d32_in){
 		struct nn_node * inp0_node = NULL;
 		if( srcnode->n_inputs >=1 ){
 			int convop = (new_op & D32REPL_16)? OP_Convert_from_d32_16b: OP_Convert_from_d32;
@@ -2540,7 +2549,7 @@ static int do_convert_to_depth32(struct nn_graph *nn, struct nn_node **nodeptr)
 	unsigned output_type = NN_TYPE_QUINT8;
 
 	// Does this operation have a d32 version?
-	if ((new_operation = depth32_replacement_op(nn, srcnode)) < 0){
+	if ((new_operation = depth32_replacement_op(nn, srcnode, 0)) < 0){
         // no, but check if it's an oversize d32 supernode
 #ifdef OVERSIZE_CHECK_ALL
 		// is it Supernode_XX_d32 with oversize filter (and not VALID)?
@@ -2669,6 +2678,291 @@ static int do_convert_to_depth32(struct nn_graph *nn, struct nn_node **nodeptr)
 	return 0;
 }
 
+//
+// assign_d32_layout: decide, for the whole graph, which nodes should be converted to d32
+// (before convert_to_depth32 does the conversion).
+//
+// convert_to_depth32 works one node at a time: anything with a d32 version is converted,
+// with a Convert_to_d32 in front of it and a Convert_from_d32 after it, and
+// remove_unnecessary_d32_converts later takes out the back-to-back from/to pairs. So an op with a
+// d32 version, sitting among ops which are flat-only, costs two conversions to run in d32, even
+// when the d32 version is not much faster than the flat one.
+//
+// Here each node is labelled 'd32' or 'flat', and the cost of a labelling is
+//  - for each node left flat, the time it would have saved in d32 (see d32_layout_gain);
+//  - for each producer output in d32 with any flat consumer: one Convert_from_d32 of the tensor;
+//  - for each producer output in flat with any d32 consumer: one Convert_to_d32 of the tensor.
+// (conversions are shared among consumers, in the same way need_convert_to_d32 shares them).
+// The cheapest labelling is an s-t min cut (source side = d32). Each producer output gets two
+// extra vertices, so that a conversion is counted once no matter how many consumers need it.
+// Some nodes are pinned to d32 (convolutions, and ops whose d32 version is the only usable one);
+// ops with no d32 version are pinned to flat.
+// Ops which are only converted when their input is already d32 (e.g. Tanh) may only be labelled
+// d32 if that input's producer is.
+//
+// Nodes which end up labelled flat get NN_NODE_FLAG_NO_CONVERT_D32, and that's all this does;
+// convert_to_depth32 handles the rest. If no labelling can be found (allocation, edge table or
+// min cut failure), nothing is flagged, and every node with a d32 version is converted.
+// Costs are in units of 'bytes converted', i.e. a conversion of a tensor costs its size in bytes.
+//
+
+// estimated time saved by running the d32 op instead of the flat one, in 1/16 of a
+// conversion of its output; or -1 if the op is always converted.
+static int d32_layout_gain(int new_op)
+{
+	switch (new_op) {
+	case OP_Supernode_8x8p8to8_d32:
+	case OP_Supernode_8x8p32to8_d32:
+	case OP_Supernode_u16x16p32to16_d32:
+	case OP_InputSupernode_8x8p8to8_outd32:
+	case OP_DepthwiseSupernode_8x8p8to8_d32:
+	case OP_DepthwiseSupernode_8x8p32to8_d32:
+	case OP_DepthwiseSupernode_16x16p32to16_d32:
+	case OP_QuantizedBatchNorm_8x8p8to8_d32:
+	case OP_QuantizedBatchNorm_8x8p32to8_d32:
+	case OP_QuantizedInstanceNorm_8_d32:
+	case OP_QuantizedInstanceNormBG_8_d32:
+	case OP_QuantizedInstanceNormBG_8_d32_ref:
+	case OP_QuantizedLRN_8_d32:
+	case OP_QuantizedSub_8p8to8_d32:	// (no flat version)
+	case OP_QuantizedConcat_8_d32:
+	case OP_QuantizedConcat_u16_d32:
+	case OP_QuantizedSplit_8_d32:
+	case OP_QuantizedChannelShuffle_8_d32:
+	case OP_Convert_from_aix_d32:
+	case OP_Convert_to_aix_d32_d32:
+		return -1;
+	case OP_QuantizedMaxPool_8_d32:
+	case OP_QuantizedAvgPool_8_d32:
+	case OP_QuantizedResizeBilinear_8_d32:
+		return 32;
+	case OP_QuantizedAdd_8p8to8_d32:
+	case OP_QuantizedAdd_u16_d32:
+	case OP_QuantizedSub_u16_d32:
+	case OP_DepthToSpace_8_d32:
+	case OP_DepthToSpace_16_d32:
+	case OP_BatchToSpaceND_8_d32:
+	case OP_SpaceToBatchND_8_d32:
+	case OP_QuantizedTanh_8_d32:
+	case OP_QuantizedSigmoid_8_d32:
+	case OP_QuantizedNeg_8_d32:
+		return 8;
+	case OP_QuantizedPad_8_d32:
+	case OP_QuantizedPad_u16_d32:
+	case OP_MirrorPad_8_d32:
+	case OP_Requantize_8to8_d32:
+		return 4;
+	default:
+		return 16;
+	}
+}
+
+// which inputs [*in_lo, *in_hi) and outputs [0, *out_hi) are in d32 format, when the node is
+// converted to new_op (this follows what do_convert_to_depth32 does).
+static void d32_layout_ports(struct nn_node const *node, int new_op, int twoin, int *in_lo, int *in_hi, int *out_hi)
+{
+	*in_lo = 0;
+	*in_hi = twoin ? 2 : 1;
+	*out_hi = 1;
+	switch (new_op) {
+	case OP_Convert_from_aix_d32:
+	case OP_InputSupernode_8x8p8to8_outd32:
+		*in_hi = 0;
+		break;
+	case OP_Convert_to_aix_d32_d32:
+	case OP_ArgMax_8_d32:
+	case OP_ArgMin_8_d32:
+		*out_hi = 0;
+		break;
+	case OP_QuantizedChannelShuffle_8_d32:
+		if (node->n_inputs <= 4 && node->n_outputs <= 3) {
+			*in_lo = 1;
+			*in_hi = 2;
+			break;
+		}
+		// else handled as concat
+	case OP_QuantizedConcat_8_d32:
+	case OP_QuantizedConcat_u16_d32:
+	case OP_QuantizedSplit_8_d32:
+		*in_lo = 1;
+		*in_hi = 1 + (node->n_inputs - 1) / 3;
+		*out_hi = node->n_outputs - 2;
+		break;
+	default:
+		break;
+	}
+	if (*in_hi > node->n_inputs) *in_hi = node->n_inputs;
+	if (*out_hi < 0) *out_hi = 0;
+}
+
+static int64_t d32_layout_bytes(struct output const *od)
+{
+	int64_t n = od->elementsize;
+	for (int i = 0; i < 4; i++) n *= od->max_sizes[i];
+	return n;
+}
+
+struct d32_layout_node {
+	struct nn_node *node;
+	int32_t vert;			// NN_MINCUT_SOURCE (pinned d32), NN_MINCUT_SINK (flat), or variable
+	int32_t port_base;		// index of its first output, among all outputs
+	int16_t in_lo, in_hi, out_hi;
+	int16_t follower;		// only d32 if input 0 is
+	int32_t gain;
+};
+struct d32_layout_idmap {
+	uint32_t node_id;
+	int32_t idx;
+};
+
+static int d32_layout_idcmp(const void *a, const void *b)
+{
+	uint32_t ia = ((struct d32_layout_idmap const *)a)->node_id;
+	uint32_t ib = ((struct d32_layout_idmap const *)b)->node_id;
+	return (ia > ib) - (ia < ib);
+}
+
+static int d32_layout_find(struct d32_layout_idmap const *map, int n, uint32_t node_id)
+{
+	struct d32_layout_idmap key = { .node_id = node_id };
+	struct d32_layout_idmap const *p = bsearch(&key, map, n, sizeof(key), d32_layout_idcmp);
+	return (p == NULL) ? -1 : p->idx;
+}
+
+// vertex for output 'idx' of node: its own vertex if that output is d32 when the node is.
+static inline int d32_layout_outvert(struct d32_layout_node const *ln, int idx)
+{
+	return (idx < ln->out_hi) ? ln->vert : NN_MINCUT_SINK;
+}
+
+static int assign_d32_layout(struct nn_graph *nn)
+{
+	struct nn_node *node;
+	int nnodes = 0, nports = 0, ninputs = 0, nvar = 0, nflat = 0;
+	int i, j, res = -1;
+	for (node = nn->head; node != NULL; node = node->next) {
+		nnodes++;
+		nports += node->n_outputs;
+		ninputs += node->n_inputs;
+	}
+	if (nnodes == 0) return 0;
+
+	struct d32_layout_node *lnodes = nn_calloc(nnodes, sizeof(struct d32_layout_node));
+	struct d32_layout_idmap *idmap = nn_calloc(nnodes, sizeof(struct d32_layout_idmap));
+	struct nn_mincut mc;
+	memset(&mc, 0, sizeof(mc));
+	if (lnodes == NULL || idmap == NULL) {
+		logmsg(nn, 1, "d32 layout: can't alloc for %d nodes", nnodes);
+		goto fallback;
+	}
+	// classify the nodes
+	int port_base = 0;
+	for (node = nn->head, i = 0; node != NULL; node = node->next, i++) {
+		struct d32_layout_node *ln = &lnodes[i];
+		ln->node = node;
+		ln->vert = NN_MINCUT_SINK;
+		ln->port_base = port_base;
+		port_base += node->n_outputs;
+		idmap[i].node_id = node->node_id;
+		idmap[i].idx = i;
+
+		int new_op = depth32_replacement_op(nn, node, 0);
+		if (new_op < 0) {
+			new_op = depth32_replacement_op(nn, node, 1);
+			if (new_op < 0) continue;
+			ln->follower = 1;
+		}
+		int lo, hi, ohi;
+		d32_layout_ports(node, new_op & ~D32REPL_FLAGS, (new_op & D32REPL_TWOIN) != 0, &lo, &hi, &ohi);
+		ln->in_lo = lo;
+		ln->in_hi = hi;
+		ln->out_hi = ohi;
+		int gain = d32_layout_gain(new_op & ~D32REPL_FLAGS);
+		if (gain < 0 && !ln->follower) {
+			ln->vert = NN_MINCUT_SOURCE;
+		} else {
+			ln->vert = 2 + nvar++;
+			ln->gain = (gain < 0) ? 16 : gain;
+		}
+	}
+	if (nvar == 0) {
+		res = 0;
+		goto done;
+	}
+	qsort(idmap, nnodes, sizeof(idmap[0]), d32_layout_idcmp);
+
+	// vertices: terminals; variables; then 2 per output (to_d32 and from_d32 for that tensor)
+	int aux_base = 2 + nvar;
+	if (nn_mincut_init(nn, &mc, aux_base + 2 * nports, 2 * ninputs + 2 * nports + 2 * nvar) != 0) goto fallback;
+
+	for (i = 0; i < nnodes; i++) {
+		struct d32_layout_node const *ln = &lnodes[i];
+		struct nn_node const *cons = ln->node;
+		// unary cost: time lost if left flat
+		if (ln->vert >= 2) {
+			int64_t w = (cons->n_outputs > 0) ? d32_layout_bytes(&cons->output_defs[0]) : 0;
+			if (nn_mincut_add_edge(&mc, NN_MINCUT_SOURCE, ln->vert, (w * ln->gain + 15) / 16) != 0) goto overflow;
+		}
+		for (j = 0; j < cons->n_inputs; j++) {
+			struct input const *inp = &cons->input_refs[j];
+			int k = d32_layout_find(idmap, nnodes, inp->src_id);
+			if (k < 0) continue;
+			struct d32_layout_node const *lp = &lnodes[k];
+			if (inp->output_idx >= lp->node->n_outputs) continue;
+			int port = lp->port_base + inp->output_idx;
+			int pvert = d32_layout_outvert(lp, inp->output_idx);
+			int cvert = (j >= ln->in_lo && j < ln->in_hi) ? ln->vert : NN_MINCUT_SINK;
+			int aux_to = aux_base + 2 * port;
+			// if the consumer is d32, to_d32 is needed (when the producer is flat).
+			// if the consumer is flat, from_d32 is needed (when the producer is d32).
+			if (nn_mincut_add_edge(&mc, cvert, aux_to, NN_MINCUT_INF) != 0) goto overflow;
+			if (nn_mincut_add_edge(&mc, aux_to + 1, cvert, NN_MINCUT_INF) != 0) goto overflow;
+			// a follower can only be d32 when its input 0 is.
+			if (j == 0 && ln->follower && ln->vert >= 2) {
+				if (nn_mincut_add_edge(&mc, ln->vert, pvert, NN_MINCUT_INF) != 0) goto overflow;
+			}
+		}
+	}
+	for (i = 0; i < nnodes; i++) {
+		struct d32_layout_node const *ln = &lnodes[i];
+		for (j = 0; j < ln->out_hi; j++) {
+			int aux_to = aux_base + 2 * (ln->port_base + j);
+			int64_t w = d32_layout_bytes(&ln->node->output_defs[j]);
+			if (nn_mincut_add_edge(&mc, aux_to, ln->vert, w) != 0) goto overflow;
+			if (nn_mincut_add_edge(&mc, ln->vert, aux_to + 1, w) != 0) goto overflow;
+		}
+		// outputs which are never d32 only need a to_d32, which is a fixed cost (with an edge
+		// to the sink, for when the consumer is d32).
+		for (; j < ln->node->n_outputs; j++) {
+			int aux_to = aux_base + 2 * (ln->port_base + j);
+			int64_t w = d32_layout_bytes(&ln->node->output_defs[j]);
+			if (nn_mincut_add_edge(&mc, aux_to, NN_MINCUT_SINK, w) != 0) goto overflow;
+		}
+	}
+	if (nn_mincut_solve(nn, &mc) != 0) goto fallback;
+
+	for (i = 0; i < nnodes; i++) {
+		struct d32_layout_node const *ln = &lnodes[i];
+		if (ln->vert < 2 || mc.source_side[ln->vert]) continue;
+		ln->node->flags |= NN_NODE_FLAG_NO_CONVERT_D32;
+		nflat++;
+		logmsg(nn, 3, "d32 layout: leaving %s node 0x%X flat", hexagon_nn_op_names[ln->node->node_type], (unsigned)ln->node->node_id);
+	}
+	logmsg(nn, 2, "d32 layout: %d of %d optional d32 nodes left flat; est. cost %lld", nflat, nvar, (long long)mc.cut_value);
+	res = 0;
+	goto done;
+overflow:
+	logmsg(nn, 1, "d32 layout: too many edges");
+fallback:
+	logmsg(nn, 1, "d32 layout: no layout found; converting each node with a d32 version");
+	res = 0;
+done:
+	nn_mincut_free(&mc);
+	if (lnodes) nn_free(lnodes);
+	if (idmap) nn_free(idmap);
+	return res;
+}
+
 static int convert_to_depth32(struct nn_graph *nn)
 {
 	return graph_iterator(nn,do_convert_to_depth32);
@@ -3360,6 +3654,16 @@ static int create_dilated_conv(struct nn_graph* nn)
 	return graph_iterator(nn, expand_dilated_conv_nodes);
 }
 
+static int fuse_elementwise_chains(struct nn_graph* nn)
+{
+	return graph_iterator(nn, fuse_elementwise_chain_nodes);
+}
+
+static int fuse_image_preprocess(struct nn_graph* nn)
+{
+	return graph_iterator(nn, fuse_image_preprocess_nodes);
+}
+
 // helper for try_combine_chanshuffle
 // Finds an eligible upstream QuantizedConcat_8, or returns NULL if there isn't one.
 // The concat must be
@@ -4904,6 +5208,9 @@ static int optimize(struct nn_graph *nn)
 	CHECK(GRAPHCHECK_DEADNODES|GRAPHCHECK_HASH)
 	if ((err = make_reluX_nodes(nn)) != 0) return err;
 	PREPARE_TIME();
+	if ((err = fuse_image_preprocess(nn)) != 0) return err;		// before the Sub_f/Mul_f can become ElementwiseChain_f
+	if ((err = fuse_elementwise_chains(nn)) != 0) return err;
+	PREPARE_TIME();
 	if ((err = mark_biasadd_nodes(nn)) != 0) return err;
 	PREPARE_TIME();
 	if ((err = gather_const_nodes(nn)) != 0) return err;
@@ -4921,8 +5228,11 @@ static int optimize(struct nn_graph *nn)
 	PREPARE_TIME();
 	if(0) if ((err = pad_bad_supernodes(nn)) != 0) return err;
 	if ((err = move_relus(nn)) != 0) return err;
-	if( ! nn_option_get(nn,test_no_d32conv))
+	if( ! nn_option_get(nn,test_no_d32conv)){
+		if( ! nn_option_get(nn,test_no_d32_layout))
+			if ((err = assign_d32_layout(nn)) != 0) return err;
 		if ((err = convert_to_depth32(nn)) != 0) return err;
+	}
 	PREPARE_TIME();
 	if ((err = remove_dead_nodes(nn)) != 0) return err;
 	PREPARE_TIME();
@@ -5180,6 +5490,9 @@ static int do_prepare_inner(struct nn_graph *nn)
 	if ((err = allocate_graph_storage(nn)) != 0) return err;
 	if ((err = run_op_check(nn)) != 0) return err;
 	if ((err = note_predecessors(nn)) != 0) return err;
+	if ((err = nn_prefetch_plan_graph(nn)) != 0) return err;
+	if ((err = nn_scratch_plan_graph(nn)) != 0) return err;
+	if ((err = nn_batchpar_plan_graph(nn)) != 0) return err;
         if ((err = udo_create_operations(nn)) != 0) return err;
 	nn_os_hvx_power_off(nn); // MUST BE BEFORE THE UNLOCK MUTEX
 	nn_mutex_unlock(&graph_mutex);
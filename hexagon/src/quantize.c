@@ -37,6 +37,7 @@
 
 #include <nn_graph.h>
 #include <quantize.h>
+#include <nn_quantize_vec.h>
 #include "hvx_inlines.h"
 
 #define CLOSE_ENUF(X, Y) (fabsf(X - Y) < 6.1035156e-05f)
@@ -384,25 +385,19 @@ nn_requantize_i32_to_qu8( uint8_t *outp, int32_t const * inp, int n, float in_le
 	int offseto = (int)offset_f;
 	scalar_requantize_i32_to_qu8( inp, offseto, gaini, outp, n);
 }
+// out[i] = saturate_u8( add_sat( (inp[i]*gaini + (1<<30))>>31, offseto) )
+// (vectorized on host builds; see nn_quantize_vec.h)
 static void
 scalar_requantize_i32_to_qu8(int32_t const * inp, int offseto, int gaini, uint8_t *outp, int n)
 {
-	for( int i =0; i < n; i++){
-		int64_t p =(int64_t)inp[i]*gaini;
-		int32_t scaled = Q6_P_asrrnd_PI(p,31);
-		scaled = Q6_R_add_RR_sat(scaled,offseto);
-		outp[i] = saturate_u8(scaled);
-	}
+	nn_qvec_i32_to_u8_q31( outp, inp, n, gaini, offseto);
 }
 // when the i32->u8 conversion requires a gain > 1.0, this is used.
 // Note that 'offset' is presumed to contain a +0.5 rounding bias.
 //
 static void fallback_requantize_i32_to_qu8(int32_t const * inp, float offset, float gain, uint8_t *outp, int n)
 {
-	for( int i= 0; i < n; i++){
-		float x = inp[i] * gain + offset;
-		outp[i] = saturate_u8( (int)x);
-	}
+	nn_qvec_i32_to_u8_flt( outp, inp, n, gain, offset);
 }
 
 
@@ -473,6 +468,10 @@ hvx_quantize_32_to_8(
 // output = (gain) * (input - in_offset) + out_offset
 void nn_requantize_qu8_to_qu8_hvx(uint8_t *outp, uint8_t const* inp, unsigned n, float gain, int32_t in_offset, int32_t out_offset)
 {
+#ifndef __hexagon__
+    // same result, elementwise, with host simd.
+    nn_qvec_u8_to_u8(outp, inp, n, gain, in_offset, out_offset);
+#else
     int nloop = n / 128u;
     int nextra = n % 128;
 
@@ -533,10 +532,14 @@ void nn_requantize_qu8_to_qu8_hvx(uint8_t *outp, uint8_t const* inp, unsigned n,
             q6op_vstu_variable_ARV(outp, nextra, hvx_requantize_vector_8to8(vinp, gaini, vvin_off_i16, vout_off_i16));
         }
     } //if gain > 1.0f
+#endif
 }
 
 void nn_requantize_qu8_to_qu8_hvx_d32(uint8_t *outp_b, uint8_t const *inp_b, int h_count, int nd32, int widvecs, int height_stride, int d32_stride, float gain, int32_t in_offset, int32_t out_offset)
 {
+#ifndef __hexagon__
+    nn_qvec_u8_to_u8_d32(outp_b, inp_b, h_count, nd32, widvecs * 128, height_stride, d32_stride, gain, in_offset, out_offset);
+#else
     HVX_Vector vin_off_i16 = q6op_Vh_vsplat_R(saturate_i16(in_offset));
     HVX_VectorPair vvin_off_i16 = Q6_W_vcombine_VV(vin_off_i16, vin_off_i16);
     HVX_Vector vout_off_i16 = q6op_Vh_vsplat_R(saturate_i16(out_offset));
@@ -618,6 +621,7 @@ void nn_requantize_qu8_to_qu8_hvx_d32(uint8_t *outp_b, uint8_t const *inp_b, int
             }
         }
     } // if gain > 1.0f ... 
+#endif
 }
 
 // handles cases where gain <= 1.0f
@@ -0,0 +1,897 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the 'qvec' quantize/dequantize/requantize loops (see nn_quantize_vec.h).
+ *
+ * Every function has a plain C version, which is the reference, and which is all that's
+ * built for hexagon. On host builds there are also:
+ *     x86:     SSE4.1 and AVX2 versions; these are compiled with 'target' attributes
+ *              and picked at first use with __builtin_cpu_supports, so the rest of the
+ *              host build doesn't need -mavx2.
+ *     aarch64: NEON versions.
+ * (define NN_QVEC_NO_SIMD to build only the C versions).
+ *
+ * The vector versions are bit-exact with the C versions:
+ *   - fixed-point ops are done in the same widths, with the same rounding and saturation
+ *     (e.g. the q31 multiply is pmuldq + shift or vqrdmulh, the u8 'lo gain' multiply is
+ *      pmulhrsw or vqrdmulh, which are both exactly the hvx vmpy:<<1:rnd:sat for gain >= 0).
+ *   - float ops are done in the same order, mul and add separately rounded (the C code
+ *     must not be built with fp contraction to fma).
+ *   - float->int conversions are clipped first to a range which doesn't change the result,
+ *     so out-of-range values saturate, as they would on hexagon (in C, they would be undefined).
+ * Each vector loop does whole blocks; a partial block at the end is done by copying it
+ * through a small buffer, so the vector code does all of the outputs.
+ */
+#include <nn_graph.h>
+#include <string.h>
+#include <math.h>
+#include <quantize.h>
+#include <nn_quantize_vec.h>
+
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+#if !defined(__hexagon__) && !defined(NN_QVEC_NO_SIMD) && defined(__GNUC__)
+#if defined(__x86_64__) || defined(__i386__)
+#define QVEC_X86 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define QVEC_NEON 1
+#endif
+#endif
+
+// parameters for all of the loops; each uses some of these.
+struct qvec_parms {
+	int32_t gain;			// q31 gain (i32->u8, i32->i16)
+	int32_t offset;			// i32->u8: added after scaling; f32->x16: added after rounding
+	int32_t lo, hi;			// i32->u8 q31: clip limits, before adding offset
+	int32_t clip;			// i32->i16: input clipped to [~clip, clip] ...
+	int lsh;			// ... and then << lsh
+	int sh;				// i32->i16, u8->u8 hi gain: rounding >> amount
+	float fgain, foffset;		// float gain, offset (f32->u8: recip_stepsize, minval)
+	int mode;			// u8->u8: QVEC_U8_xxx
+	int16_t in_off, out_off, tot_off, g16;	// u8->u8
+	int zero, xorval;		// u8->f32, x16<->f32
+};
+
+enum {
+	QVEC_U8_UNIFORM,		// gain ~= 1: out = in + (out_off - in_off)
+	QVEC_U8_LO_GAIN,		// gain < 1:  16x16 fractional multiply
+	QVEC_U8_HI_GAIN			// gain > 1:  16x16->32 multiply, >> sh
+};
+
+typedef void (*qvec_i32_u8_fp)(uint8_t *, int32_t const *, int, struct qvec_parms const *);
+typedef void (*qvec_i32_i16_fp)(int16_t *, int32_t const *, int, struct qvec_parms const *);
+typedef void (*qvec_u8_u8_fp)(uint8_t *, uint8_t const *, int, struct qvec_parms const *);
+typedef void (*qvec_f32_u8_fp)(uint8_t *, float const *, int, struct qvec_parms const *);
+typedef void (*qvec_u8_f32_fp)(float *, uint8_t const *, int, struct qvec_parms const *);
+typedef void (*qvec_f32_x16_fp)(int16_t *, float const *, int, struct qvec_parms const *);
+typedef void (*qvec_x16_f32_fp)(float *, uint16_t const *, int, struct qvec_parms const *);
+
+struct qvec_funcs {
+	char const *name;
+	qvec_i32_u8_fp i32_to_u8_q31;
+	qvec_i32_u8_fp i32_to_u8_flt;
+	qvec_i32_i16_fp i32_to_i16_q31;
+	qvec_u8_u8_fp u8_to_u8;
+	qvec_f32_u8_fp f32_to_u8;
+	qvec_u8_f32_fp u8_to_f32;
+	qvec_f32_x16_fp f32_to_x16;
+	qvec_x16_f32_fp x16_to_f32;
+};
+
+//////////////////////////////////////////////////////////////////
+// C versions (the reference)
+//////////////////////////////////////////////////////////////////
+
+// (x*gain + 2^30) >> 31, saturated to i32 (only matters when both are -2^31)
+static inline int32_t qvec_q31_mul(int32_t x, int32_t gain)
+{
+	int64_t p = ((int64_t)x * gain + (1 << 30)) >> 31;
+	return (p > INT32_MAX) ? INT32_MAX : (int32_t)p;
+}
+static inline int32_t qvec_add_sat(int32_t a, int32_t b)
+{
+	int64_t s = (int64_t)a + b;
+	return (s > INT32_MAX) ? INT32_MAX : ((s < INT32_MIN) ? INT32_MIN : (int32_t)s);
+}
+
+static void c_i32_to_u8_q31(uint8_t *outp, int32_t const *inp, int n, struct qvec_parms const *pp)
+{
+	for (int i = 0; i < n; i++) {
+		outp[i] = saturate_u8(qvec_add_sat(qvec_q31_mul(inp[i], pp->gain), pp->offset));
+	}
+}
+static void c_i32_to_u8_flt(uint8_t *outp, int32_t const *inp, int n, struct qvec_parms const *pp)
+{
+	for (int i = 0; i < n; i++) {
+		float x = inp[i] * pp->fgain + pp->foffset;
+		x = fmaxf(fminf(x, 256.0f), -1.0f);
+		outp[i] = saturate_u8((int)x);
+	}
+}
+static void c_i32_to_i16_q31(int16_t *outp, int32_t const *inp, int n, struct qvec_parms const *pp)
+{
+	int sh = pp->sh;
+	int64_t rnd = (sh == 0) ? 0 : ((int64_t)1 << (sh - 1));
+	for (int i = 0; i < n; i++) {
+		int32_t x = max_i32(min_i32(inp[i], pp->clip), ~pp->clip);
+		int64_t v = qvec_q31_mul((int32_t)((uint32_t)x << pp->lsh), pp->gain);
+		outp[i] = saturate_i16((v + rnd) >> sh);
+	}
+}
+static void c_u8_to_u8(uint8_t *outp, uint8_t const *inp, int n, struct qvec_parms const *pp)
+{
+	int sh = pp->sh;
+	int32_t rnd = (sh == 0) ? 0 : (1 << (sh - 1));
+	for (int i = 0; i < n; i++) {
+		int32_t d = (int16_t)(inp[i] - pp->in_off);
+		int32_t p;
+		if (pp->mode == QVEC_U8_UNIFORM) {
+			outp[i] = saturate_u8(saturate_i16(inp[i] + pp->tot_off));
+			continue;
+		} else if (pp->mode == QVEC_U8_LO_GAIN) {
+			p = saturate_i16(((int64_t)d * pp->g16 * 2 + 0x8000) >> 16);
+		} else {
+			p = saturate_i16((d * pp->g16 + rnd) >> sh);
+		}
+		outp[i] = saturate_u8(saturate_i16(p + pp->out_off));
+	}
+}
+static void c_f32_to_u8(uint8_t *outp, float const *inp, int n, struct qvec_parms const *pp)
+{
+	for (int i = 0; i < n; i++) {
+		float v = (inp[i] - pp->foffset) * pp->fgain;
+		v = fmaxf(fminf(v, 257.0f), -2.0f);
+		outp[i] = saturate_u8(roundf_i32(v));
+	}
+}
+static void c_u8_to_f32(float *outp, uint8_t const *inp, int n, struct qvec_parms const *pp)
+{
+	for (int i = 0; i < n; i++) {
+		outp[i] = (float)(inp[i] - pp->zero) * pp->fgain;
+	}
+}
+static void c_f32_to_x16(int16_t *outp, float const *inp, int n, struct qvec_parms const *pp)
+{
+	for (int i = 0; i < n; i++) {
+		float v = fmaxf(fminf(inp[i] * pp->fgain, 131072.0f), -131072.0f);
+		outp[i] = saturate_i16(roundf_i32(v) + pp->offset) ^ pp->xorval;
+	}
+}
+static void c_x16_to_f32(float *outp, uint16_t const *inp, int n, struct qvec_parms const *pp)
+{
+	for (int i = 0; i < n; i++) {
+		outp[i] = pp->fgain * (float)((uint16_t)(inp[i] ^ pp->xorval) - pp->zero);
+	}
+}
+
+static struct qvec_funcs const qvec_funcs_c = {
+	.name = "c",
+	.i32_to_u8_q31 = c_i32_to_u8_q31,
+	.i32_to_u8_flt = c_i32_to_u8_flt,
+	.i32_to_i16_q31 = c_i32_to_i16_q31,
+	.u8_to_u8 = c_u8_to_u8,
+	.f32_to_u8 = c_f32_to_u8,
+	.u8_to_f32 = c_u8_to_f32,
+	.f32_to_x16 = c_f32_to_x16,
+	.x16_to_f32 = c_x16_to_f32,
+};
+
+#if defined(QVEC_X86) || defined(QVEC_NEON)
+// nn_graph_builtin.h defines __attribute__ away for host builds; the SIMD code needs it.
+#pragma push_macro("__attribute__")
+#undef __attribute__
+#if defined(QVEC_X86)
+#include <immintrin.h>
+#else
+#include <arm_neon.h>
+#endif
+
+// make a loop function FNAME from a function BLKFN which does BLK elements.
+#define QVEC_LOOP(FNAME, ATTR, BLK, TOUT, TIN, BLKFN) \
+static ATTR void FNAME(TOUT *outp, TIN const *inp, int n, struct qvec_parms const *pp) \
+{ \
+	for (; n >= BLK; n -= BLK, inp += BLK, outp += BLK) BLKFN(outp, inp, pp); \
+	if (n > 0) { \
+		TIN tin[BLK]; \
+		TOUT tout[BLK]; \
+		memset(tin, 0, sizeof(tin)); \
+		memcpy(tin, inp, n * sizeof(TIN)); \
+		BLKFN(tout, tin, pp); \
+		memcpy(outp, tout, n * sizeof(TOUT)); \
+	} \
+}
+#endif
+
+#if defined(QVEC_X86)
+//////////////////////////////////////////////////////////////////
+// SSE4.1
+//////////////////////////////////////////////////////////////////
+#define QVEC_SSE41 __attribute__((target("sse4.1")))
+
+// q31 multiply of 4 lanes, by gain >= 0 in all lanes (so no saturation is needed).
+// The products are done as even/odd 64-bit pairs; the result is bits 31..62 of each.
+static inline QVEC_SSE41 __m128i sse_q31_mul(__m128i x, __m128i vgain)
+{
+	__m128i rnd = _mm_set1_epi64x(1 << 30);
+	__m128i pe = _mm_add_epi64(_mm_mul_epi32(x, vgain), rnd);
+	__m128i po = _mm_add_epi64(_mm_mul_epi32(_mm_srli_epi64(x, 32), vgain), rnd);
+	return _mm_blend_epi16(_mm_srli_epi64(pe, 31), _mm_slli_epi64(po, 1), 0xCC);
+}
+// i32->u8 q31, 16 at once. Instead of add_sat( x, offset) then saturate to u8, x is clipped
+// to [lo,hi] = [-offset, 255-offset] (clipped to i32) and the offset is added.
+static inline QVEC_SSE41 void sse_blk_i32_to_u8_q31(uint8_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	__m128i vgain = _mm_set1_epi32(pp->gain);
+	__m128i vlo = _mm_set1_epi32(pp->lo);
+	__m128i vhi = _mm_set1_epi32(pp->hi);
+	__m128i voff = _mm_set1_epi32(pp->offset);
+	__m128i r[4];
+	for (int k = 0; k < 4; k++) {
+		__m128i x = sse_q31_mul(_mm_loadu_si128((__m128i const *)(inp + 4 * k)), vgain);
+		r[k] = _mm_add_epi32(_mm_max_epi32(_mm_min_epi32(x, vhi), vlo), voff);
+	}
+	_mm_storeu_si128((__m128i *)outp,
+		_mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3])));
+}
+static inline QVEC_SSE41 void sse_blk_i32_to_u8_flt(uint8_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	__m128 vgain = _mm_set1_ps(pp->fgain);
+	__m128 voff = _mm_set1_ps(pp->foffset);
+	__m128 vmax = _mm_set1_ps(256.0f);
+	__m128 vmin = _mm_set1_ps(-1.0f);
+	__m128i r[4];
+	for (int k = 0; k < 4; k++) {
+		__m128 x = _mm_cvtepi32_ps(_mm_loadu_si128((__m128i const *)(inp + 4 * k)));
+		x = _mm_add_ps(_mm_mul_ps(x, vgain), voff);
+		r[k] = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(x, vmax), vmin));
+	}
+	_mm_storeu_si128((__m128i *)outp,
+		_mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3])));
+}
+// i32->i16, 8 at once. The q31 result is clipped to +/-2^30 so the rounding add can't
+// overflow; that doesn't change the saturated result, since sh <= 15.
+static inline QVEC_SSE41 void sse_blk_i32_to_i16_q31(int16_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	__m128i vgain = _mm_set1_epi32(pp->gain);
+	__m128i vclip = _mm_set1_epi32(pp->clip);
+	__m128i vnclip = _mm_set1_epi32(~pp->clip);
+	__m128i vlim = _mm_set1_epi32(1 << 30);
+	__m128i vnlim = _mm_set1_epi32(-(1 << 30));
+	__m128i vrnd = _mm_set1_epi32((pp->sh == 0) ? 0 : (1 << (pp->sh - 1)));
+	__m128i lsh = _mm_cvtsi32_si128(pp->lsh);
+	__m128i sh = _mm_cvtsi32_si128(pp->sh);
+	__m128i r[2];
+	for (int k = 0; k < 2; k++) {
+		__m128i x = _mm_loadu_si128((__m128i const *)(inp + 4 * k));
+		x = _mm_sll_epi32(_mm_max_epi32(_mm_min_epi32(x, vclip), vnclip), lsh);
+		x = _mm_max_epi32(_mm_min_epi32(sse_q31_mul(x, vgain), vlim), vnlim);
+		r[k] = _mm_sra_epi32(_mm_add_epi32(x, vrnd), sh);
+	}
+	_mm_storeu_si128((__m128i *)outp, _mm_packs_epi32(r[0], r[1]));
+}
+// u8->u8 on 8 values in i16 lanes
+static inline QVEC_SSE41 __m128i sse_u8_to_u8_h(__m128i x, struct qvec_parms const *pp)
+{
+	if (pp->mode == QVEC_U8_UNIFORM) return _mm_adds_epi16(x, _mm_set1_epi16(pp->tot_off));
+	__m128i d = _mm_sub_epi16(x, _mm_set1_epi16(pp->in_off));
+	__m128i vg = _mm_set1_epi16(pp->g16);
+	__m128i p;
+	if (pp->mode == QVEC_U8_LO_GAIN) {
+		p = _mm_mulhrs_epi16(d, vg);
+	} else {
+		__m128i plo = _mm_mullo_epi16(d, vg);
+		__m128i phi = _mm_mulhi_epi16(d, vg);
+		__m128i vrnd = _mm_set1_epi32((pp->sh == 0) ? 0 : (1 << (pp->sh - 1)));
+		__m128i sh = _mm_cvtsi32_si128(pp->sh);
+		__m128i p0 = _mm_sra_epi32(_mm_add_epi32(_mm_unpacklo_epi16(plo, phi), vrnd), sh);
+		__m128i p1 = _mm_sra_epi32(_mm_add_epi32(_mm_unpackhi_epi16(plo, phi), vrnd), sh);
+		p = _mm_packs_epi32(p0, p1);
+	}
+	return _mm_adds_epi16(p, _mm_set1_epi16(pp->out_off));
+}
+static inline QVEC_SSE41 void sse_blk_u8_to_u8(uint8_t *outp, uint8_t const *inp, struct qvec_parms const *pp)
+{
+	__m128i x = _mm_loadu_si128((__m128i const *)inp);
+	__m128i zero = _mm_setzero_si128();
+	__m128i r0 = sse_u8_to_u8_h(_mm_unpacklo_epi8(x, zero), pp);
+	__m128i r1 = sse_u8_to_u8_h(_mm_unpackhi_epi8(x, zero), pp);
+	_mm_storeu_si128((__m128i *)outp, _mm_packus_epi16(r0, r1));
+}
+// roundf_i32 of 4 floats, which have been clipped to a range that fits
+static inline QVEC_SSE41 __m128i sse_roundf_i32(__m128 v)
+{
+	__m128 half = _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.0f)), _mm_set1_ps(0.5f));
+	return _mm_cvttps_epi32(_mm_add_ps(v, half));
+}
+static inline QVEC_SSE41 void sse_blk_f32_to_u8(uint8_t *outp, float const *inp, struct qvec_parms const *pp)
+{
+	__m128 vscl = _mm_set1_ps(pp->fgain);
+	__m128 vmin = _mm_set1_ps(pp->foffset);
+	__m128 vhi = _mm_set1_ps(257.0f);
+	__m128 vlo = _mm_set1_ps(-2.0f);
+	__m128i r[4];
+	for (int k = 0; k < 4; k++) {
+		__m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(inp + 4 * k), vmin), vscl);
+		r[k] = sse_roundf_i32(_mm_max_ps(_mm_min_ps(v, vhi), vlo));
+	}
+	_mm_storeu_si128((__m128i *)outp,
+		_mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3])));
+}
+static inline QVEC_SSE41 void sse_blk_u8_to_f32(float *outp, uint8_t const *inp, struct qvec_parms const *pp)
+{
+	__m128i x = _mm_loadu_si128((__m128i const *)inp);
+	__m128i vzero = _mm_set1_epi32(pp->zero);
+	__m128 vstep = _mm_set1_ps(pp->fgain);
+	for (int k = 0; k < 4; k++) {
+		__m128i xk = _mm_sub_epi32(_mm_cvtepu8_epi32(x), vzero);
+		_mm_storeu_ps(outp + 4 * k, _mm_mul_ps(_mm_cvtepi32_ps(xk), vstep));
+		x = _mm_srli_si128(x, 4);
+	}
+}
+static inline QVEC_SSE41 void sse_blk_f32_to_x16(int16_t *outp, float const *inp, struct qvec_parms const *pp)
+{
+	__m128 vscl = _mm_set1_ps(pp->fgain);
+	__m128 vhi = _mm_set1_ps(131072.0f);
+	__m128 vlo = _mm_set1_ps(-131072.0f);
+	__m128i voff = _mm_set1_epi32(pp->offset);
+	__m128i r[2];
+	for (int k = 0; k < 2; k++) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(inp + 4 * k), vscl);
+		r[k] = _mm_add_epi32(sse_roundf_i32(_mm_max_ps(_mm_min_ps(v, vhi), vlo)), voff);
+	}
+	_mm_storeu_si128((__m128i *)outp,
+		_mm_xor_si128(_mm_packs_epi32(r[0], r[1]), _mm_set1_epi16(pp->xorval)));
+}
+static inline QVEC_SSE41 void sse_blk_x16_to_f32(float *outp, uint16_t const *inp, struct qvec_parms const *pp)
+{
+	__m128i x = _mm_xor_si128(_mm_loadu_si128((__m128i const *)inp), _mm_set1_epi16(pp->xorval));
+	__m128i vzero = _mm_set1_epi32(pp->zero);
+	__m128 vscl = _mm_set1_ps(pp->fgain);
+	__m128i x0 = _mm_sub_epi32(_mm_cvtepu16_epi32(x), vzero);
+	__m128i x1 = _mm_sub_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(x, 8)), vzero);
+	_mm_storeu_ps(outp, _mm_mul_ps(vscl, _mm_cvtepi32_ps(x0)));
+	_mm_storeu_ps(outp + 4, _mm_mul_ps(vscl, _mm_cvtepi32_ps(x1)));
+}
+
+QVEC_LOOP(sse_i32_to_u8_q31, QVEC_SSE41, 16, uint8_t, int32_t, sse_blk_i32_to_u8_q31)
+QVEC_LOOP(sse_i32_to_u8_flt, QVEC_SSE41, 16, uint8_t, int32_t, sse_blk_i32_to_u8_flt)
+QVEC_LOOP(sse_i32_to_i16_q31, QVEC_SSE41, 8, int16_t, int32_t, sse_blk_i32_to_i16_q31)
+QVEC_LOOP(sse_u8_to_u8, QVEC_SSE41, 16, uint8_t, uint8_t, sse_blk_u8_to_u8)
+QVEC_LOOP(sse_f32_to_u8, QVEC_SSE41, 16, uint8_t, float, sse_blk_f32_to_u8)
+QVEC_LOOP(sse_u8_to_f32, QVEC_SSE41, 16, float, uint8_t, sse_blk_u8_to_f32)
+QVEC_LOOP(sse_f32_to_x16, QVEC_SSE41, 8, int16_t, float, sse_blk_f32_to_x16)
+QVEC_LOOP(sse_x16_to_f32, QVEC_SSE41, 8, float, uint16_t, sse_blk_x16_to_f32)
+
+static struct qvec_funcs const qvec_funcs_sse41 = {
+	.name = "sse4.1",
+	.i32_to_u8_q31 = sse_i32_to_u8_q31,
+	.i32_to_u8_flt = sse_i32_to_u8_flt,
+	.i32_to_i16_q31 = sse_i32_to_i16_q31,
+	.u8_to_u8 = sse_u8_to_u8,
+	.f32_to_u8 = sse_f32_to_u8,
+	.u8_to_f32 = sse_u8_to_f32,
+	.f32_to_x16 = sse_f32_to_x16,
+	.x16_to_f32 = sse_x16_to_f32,
+};
+
+//////////////////////////////////////////////////////////////////
+// AVX2: the same as SSE4.1 at twice the width. The 16->8 and 32->16 packs work within
+// 128-bit lanes, so the results are put back in order with a permute.
+// The 16-bit conversions, which are not used much, are left as SSE4.1.
+//////////////////////////////////////////////////////////////////
+#define QVEC_AVX2 __attribute__((target("avx2")))
+
+static inline QVEC_AVX2 __m256i avx_q31_mul(__m256i x, __m256i vgain)
+{
+	__m256i rnd = _mm256_set1_epi64x(1 << 30);
+	__m256i pe = _mm256_add_epi64(_mm256_mul_epi32(x, vgain), rnd);
+	__m256i po = _mm256_add_epi64(_mm256_mul_epi32(_mm256_srli_epi64(x, 32), vgain), rnd);
+	return _mm256_blend_epi16(_mm256_srli_epi64(pe, 31), _mm256_slli_epi64(po, 1), 0xCC);
+}
+// pack 4 x 8 i32 to 32 u8, with saturation, in order
+static inline QVEC_AVX2 void avx_store_w_to_ub(uint8_t *outp, __m256i const r[4])
+{
+	__m256i p = _mm256_packus_epi16(_mm256_packs_epi32(r[0], r[1]), _mm256_packs_epi32(r[2], r[3]));
+	p = _mm256_permutevar8x32_epi32(p, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+	_mm256_storeu_si256((__m256i *)outp, p);
+}
+static inline QVEC_AVX2 void avx_blk_i32_to_u8_q31(uint8_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	__m256i vgain = _mm256_set1_epi32(pp->gain);
+	__m256i vlo = _mm256_set1_epi32(pp->lo);
+	__m256i vhi = _mm256_set1_epi32(pp->hi);
+	__m256i voff = _mm256_set1_epi32(pp->offset);
+	__m256i r[4];
+	for (int k = 0; k < 4; k++) {
+		__m256i x = avx_q31_mul(_mm256_loadu_si256((__m256i const *)(inp + 8 * k)), vgain);
+		r[k] = _mm256_add_epi32(_mm256_max_epi32(_mm256_min_epi32(x, vhi), vlo), voff);
+	}
+	avx_store_w_to_ub(outp, r);
+}
+static inline QVEC_AVX2 void avx_blk_i32_to_u8_flt(uint8_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	__m256 vgain = _mm256_set1_ps(pp->fgain);
+	__m256 voff = _mm256_set1_ps(pp->foffset);
+	__m256 vmax = _mm256_set1_ps(256.0f);
+	__m256 vmin = _mm256_set1_ps(-1.0f);
+	__m256i r[4];
+	for (int k = 0; k < 4; k++) {
+		__m256 x = _mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i const *)(inp + 8 * k)));
+		x = _mm256_add_ps(_mm256_mul_ps(x, vgain), voff);
+		r[k] = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(x, vmax), vmin));
+	}
+	avx_store_w_to_ub(outp, r);
+}
+static inline QVEC_AVX2 void avx_blk_i32_to_i16_q31(int16_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	__m256i vgain = _mm256_set1_epi32(pp->gain);
+	__m256i vclip = _mm256_set1_epi32(pp->clip);
+	__m256i vnclip = _mm256_set1_epi32(~pp->clip);
+	__m256i vlim = _mm256_set1_epi32(1 << 30);
+	__m256i vnlim = _mm256_set1_epi32(-(1 << 30));
+	__m256i vrnd = _mm256_set1_epi32((pp->sh == 0) ? 0 : (1 << (pp->sh - 1)));
+	__m128i lsh = _mm_cvtsi32_si128(pp->lsh);
+	__m128i sh = _mm_cvtsi32_si128(pp->sh);
+	__m256i r[2];
+	for (int k = 0; k < 2; k++) {
+		__m256i x = _mm256_loadu_si256((__m256i const *)(inp + 8 * k));
+		x = _mm256_sll_epi32(_mm256_max_epi32(_mm256_min_epi32(x, vclip), vnclip), lsh);
+		x = _mm256_max_epi32(_mm256_min_epi32(avx_q31_mul(x, vgain), vlim), vnlim);
+		r[k] = _mm256_sra_epi32(_mm256_add_epi32(x, vrnd), sh);
+	}
+	__m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(r[0], r[1]), 0xD8);
+	_mm256_storeu_si256((__m256i *)outp, p);
+}
+static inline QVEC_AVX2 __m256i avx_u8_to_u8_h(__m256i x, struct qvec_parms const *pp)
+{
+	if (pp->mode == QVEC_U8_UNIFORM) return _mm256_adds_epi16(x, _mm256_set1_epi16(pp->tot_off));
+	__m256i d = _mm256_sub_epi16(x, _mm256_set1_epi16(pp->in_off));
+	__m256i vg = _mm256_set1_epi16(pp->g16);
+	__m256i p;
+	if (pp->mode == QVEC_U8_LO_GAIN) {
+		p = _mm256_mulhrs_epi16(d, vg);
+	} else {
+		// unpack lo/hi and packs are all within 128-bit lanes, so these cancel out.
+		__m256i plo = _mm256_mullo_epi16(d, vg);
+		__m256i phi = _mm256_mulhi_epi16(d, vg);
+		__m256i vrnd = _mm256_set1_epi32((pp->sh == 0) ? 0 : (1 << (pp->sh - 1)));
+		__m128i sh = _mm_cvtsi32_si128(pp->sh);
+		__m256i p0 = _mm256_sra_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(plo, phi), vrnd), sh);
+		__m256i p1 = _mm256_sra_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(plo, phi), vrnd), sh);
+		p = _mm256_packs_epi32(p0, p1);
+	}
+	return _mm256_adds_epi16(p, _mm256_set1_epi16(pp->out_off));
+}
+static inline QVEC_AVX2 void avx_blk_u8_to_u8(uint8_t *outp, uint8_t const *inp, struct qvec_parms const *pp)
+{
+	__m256i r0 = avx_u8_to_u8_h(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const *)inp)), pp);
+	__m256i r1 = avx_u8_to_u8_h(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const *)(inp + 16))), pp);
+	__m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), 0xD8);
+	_mm256_storeu_si256((__m256i *)outp, p);
+}
+static inline QVEC_AVX2 void avx_blk_f32_to_u8(uint8_t *outp, float const *inp, struct qvec_parms const *pp)
+{
+	__m256 vscl = _mm256_set1_ps(pp->fgain);
+	__m256 vmin = _mm256_set1_ps(pp->foffset);
+	__m256 vhi = _mm256_set1_ps(257.0f);
+	__m256 vlo = _mm256_set1_ps(-2.0f);
+	__m256 vsgn = _mm256_set1_ps(-0.0f);
+	__m256 vhalf = _mm256_set1_ps(0.5f);
+	__m256i r[4];
+	for (int k = 0; k < 4; k++) {
+		__m256 v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(inp + 8 * k), vmin), vscl);
+		v = _mm256_max_ps(_mm256_min_ps(v, vhi), vlo);
+		v = _mm256_add_ps(v, _mm256_or_ps(_mm256_and_ps(v, vsgn), vhalf));
+		r[k] = _mm256_cvttps_epi32(v);
+	}
+	avx_store_w_to_ub(outp, r);
+}
+static inline QVEC_AVX2 void avx_blk_u8_to_f32(float *outp, uint8_t const *inp, struct qvec_parms const *pp)
+{
+	__m256i vzero = _mm256_set1_epi32(pp->zero);
+	__m256 vstep = _mm256_set1_ps(pp->fgain);
+	for (int k = 0; k < 4; k++) {
+		__m256i xk = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const *)(inp + 8 * k)));
+		xk = _mm256_sub_epi32(xk, vzero);
+		_mm256_storeu_ps(outp + 8 * k, _mm256_mul_ps(_mm256_cvtepi32_ps(xk), vstep));
+	}
+}
+
+QVEC_LOOP(avx_i32_to_u8_q31, QVEC_AVX2, 32, uint8_t, int32_t, avx_blk_i32_to_u8_q31)
+QVEC_LOOP(avx_i32_to_u8_flt, QVEC_AVX2, 32, uint8_t, int32_t, avx_blk_i32_to_u8_flt)
+QVEC_LOOP(avx_i32_to_i16_q31, QVEC_AVX2, 16, int16_t, int32_t, avx_blk_i32_to_i16_q31)
+QVEC_LOOP(avx_u8_to_u8, QVEC_AVX2, 32, uint8_t, uint8_t, avx_blk_u8_to_u8)
+QVEC_LOOP(avx_f32_to_u8, QVEC_AVX2, 32, uint8_t, float, avx_blk_f32_to_u8)
+QVEC_LOOP(avx_u8_to_f32, QVEC_AVX2, 32, float, uint8_t, avx_blk_u8_to_f32)
+
+static struct qvec_funcs const qvec_funcs_avx2 = {
+	.name = "avx2",
+	.i32_to_u8_q31 = avx_i32_to_u8_q31,
+	.i32_to_u8_flt = avx_i32_to_u8_flt,
+	.i32_to_i16_q31 = avx_i32_to_i16_q31,
+	.u8_to_u8 = avx_u8_to_u8,
+	.f32_to_u8 = avx_f32_to_u8,
+	.u8_to_f32 = avx_u8_to_f32,
+	.f32_to_x16 = sse_f32_to_x16,
+	.x16_to_f32 = sse_x16_to_f32,
+};
+#endif // QVEC_X86
+
+#if defined(QVEC_NEON)
+//////////////////////////////////////////////////////////////////
+// NEON
+// vqrdmulh is exactly the hvx fractional multiply (<<1, round, saturate), in 16 and 32 bits;
+// vrshl by -sh is the rounding right shift (without overflow in the rounding add).
+// vminnm/vmaxnm are used for the float clipping since they return the non-NaN operand,
+// as fminf/fmaxf do.
+//////////////////////////////////////////////////////////////////
+#define QVEC_NEON_ATTR
+
+// 4 x 4 i32 -> 16 u8 with saturation
+static inline void neon_store_w_to_ub(uint8_t *outp, int32x4_t const r[4])
+{
+	int16x8_t p01 = vcombine_s16(vqmovn_s32(r[0]), vqmovn_s32(r[1]));
+	int16x8_t p23 = vcombine_s16(vqmovn_s32(r[2]), vqmovn_s32(r[3]));
+	vst1q_u8(outp, vcombine_u8(vqmovun_s16(p01), vqmovun_s16(p23)));
+}
+static inline void neon_blk_i32_to_u8_q31(uint8_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	int32x4_t voff = vdupq_n_s32(pp->offset);
+	int32x4_t r[4];
+	for (int k = 0; k < 4; k++) {
+		int32x4_t x = vqrdmulhq_n_s32(vld1q_s32(inp + 4 * k), pp->gain);
+		r[k] = vqaddq_s32(x, voff);
+	}
+	neon_store_w_to_ub(outp, r);
+}
+static inline void neon_blk_i32_to_u8_flt(uint8_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	float32x4_t vgain = vdupq_n_f32(pp->fgain);
+	float32x4_t voff = vdupq_n_f32(pp->foffset);
+	float32x4_t vmax = vdupq_n_f32(256.0f);
+	float32x4_t vmin = vdupq_n_f32(-1.0f);
+	int32x4_t r[4];
+	for (int k = 0; k < 4; k++) {
+		float32x4_t x = vcvtq_f32_s32(vld1q_s32(inp + 4 * k));
+		x = vaddq_f32(vmulq_f32(x, vgain), voff);
+		r[k] = vcvtq_s32_f32(vmaxnmq_f32(vminnmq_f32(x, vmax), vmin));
+	}
+	neon_store_w_to_ub(outp, r);
+}
+static inline void neon_blk_i32_to_i16_q31(int16_t *outp, int32_t const *inp, struct qvec_parms const *pp)
+{
+	int32x4_t vclip = vdupq_n_s32(pp->clip);
+	int32x4_t vnclip = vdupq_n_s32(~pp->clip);
+	int32x4_t vlsh = vdupq_n_s32(pp->lsh);
+	int32x4_t vrsh = vdupq_n_s32(-pp->sh);
+	int16x4_t r[2];
+	for (int k = 0; k < 2; k++) {
+		int32x4_t x = vld1q_s32(inp + 4 * k);
+		x = vshlq_s32(vmaxq_s32(vminq_s32(x, vclip), vnclip), vlsh);
+		x = vrshlq_s32(vqrdmulhq_n_s32(x, pp->gain), vrsh);
+		r[k] = vqmovn_s32(x);
+	}
+	vst1q_s16(outp, vcombine_s16(r[0], r[1]));
+}
+static inline int16x8_t neon_u8_to_u8_h(int16x8_t x, struct qvec_parms const *pp)
+{
+	if (pp->mode == QVEC_U8_UNIFORM) return vqaddq_s16(x, vdupq_n_s16(pp->tot_off));
+	int16x8_t d = vsubq_s16(x, vdupq_n_s16(pp->in_off));
+	int16x8_t p;
+	if (pp->mode == QVEC_U8_LO_GAIN) {
+		p = vqrdmulhq_n_s16(d, pp->g16);
+	} else {
+		int32x4_t vrsh = vdupq_n_s32(-pp->sh);
+		int32x4_t p0 = vrshlq_s32(vmull_n_s16(vget_low_s16(d), pp->g16), vrsh);
+		int32x4_t p1 = vrshlq_s32(vmull_n_s16(vget_high_s16(d), pp->g16), vrsh);
+		p = vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1));
+	}
+	return vqaddq_s16(p, vdupq_n_s16(pp->out_off));
+}
+static inline void neon_blk_u8_to_u8(uint8_t *outp, uint8_t const *inp, struct qvec_parms const *pp)
+{
+	uint8x16_t x = vld1q_u8(inp);
+	int16x8_t r0 = neon_u8_to_u8_h(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(x))), pp);
+	int16x8_t r1 = neon_u8_to_u8_h(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(x))), pp);
+	vst1q_u8(outp, vcombine_u8(vqmovun_s16(r0), vqmovun_s16(r1)));
+}
+// roundf_i32 of 4 floats, which have been clipped to a range that fits
+static inline int32x4_t neon_roundf_i32(float32x4_t v)
+{
+	uint32x4_t sgn = vdupq_n_u32(0x80000000u);
+	float32x4_t half = vbslq_f32(sgn, v, vdupq_n_f32(0.5f));
+	return vcvtq_s32_f32(vaddq_f32(v, half));
+}
+static inline void neon_blk_f32_to_u8(uint8_t *outp, float const *inp, struct qvec_parms const *pp)
+{
+	float32x4_t vscl = vdupq_n_f32(pp->fgain);
+	float32x4_t vmin = vdupq_n_f32(pp->foffset);
+	float32x4_t vhi = vdupq_n_f32(257.0f);
+	float32x4_t vlo = vdupq_n_f32(-2.0f);
+	int32x4_t r[4];
+	for (int k = 0; k < 4; k++) {
+		float32x4_t v = vmulq_f32(vsubq_f32(vld1q_f32(inp + 4 * k), vmin), vscl);
+		r[k] = neon_roundf_i32(vmaxnmq_f32(vminnmq_f32(v, vhi), vlo));
+	}
+	neon_store_w_to_ub(outp, r);
+}
+static inline void neon_blk_u8_to_f32(float *outp, uint8_t const *inp, struct qvec_parms const *pp)
+{
+	uint8x16_t x = vld1q_u8(inp);
+	int32x4_t vzero = vdupq_n_s32(pp->zero);
+	float32x4_t vstep = vdupq_n_f32(pp->fgain);
+	uint16x8_t h[2] = { vmovl_u8(vget_low_u8(x)), vmovl_u8(vget_high_u8(x)) };
+	for (int k = 0; k < 4; k++) {
+		uint16x4_t hk = (k & 1) ? vget_high_u16(h[k >> 1]) : vget_low_u16(h[k >> 1]);
+		int32x4_t xk = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(hk)), vzero);
+		vst1q_f32(outp + 4 * k, vmulq_f32(vcvtq_f32_s32(xk), vstep));
+	}
+}
+static inline void neon_blk_f32_to_x16(int16_t *outp, float const *inp, struct qvec_parms const *pp)
+{
+	float32x4_t vscl = vdupq_n_f32(pp->fgain);
+	float32x4_t vhi = vdupq_n_f32(131072.0f);
+	float32x4_t vlo = vdupq_n_f32(-131072.0f);
+	int32x4_t voff = vdupq_n_s32(pp->offset);
+	int16x4_t r[2];
+	for (int k = 0; k < 2; k++) {
+		float32x4_t v = vmulq_f32(vld1q_f32(inp + 4 * k), vscl);
+		r[k] = vqmovn_s32(vaddq_s32(neon_roundf_i32(vmaxnmq_f32(vminnmq_f32(v, vhi), vlo)), voff));
+	}
+	vst1q_s16(outp, veorq_s16(vcombine_s16(r[0], r[1]), vdupq_n_s16(pp->xorval)));
+}
+static inline void neon_blk_x16_to_f32(float *outp, uint16_t const *inp, struct qvec_parms const *pp)
+{
+	uint16x8_t x = veorq_u16(vld1q_u16(inp), vdupq_n_u16(pp->xorval));
+	int32x4_t vzero = vdupq_n_s32(pp->zero);
+	float32x4_t vscl = vdupq_n_f32(pp->fgain);
+	int32x4_t x0 = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(x))), vzero);
+	int32x4_t x1 = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(x))), vzero);
+	vst1q_f32(outp, vmulq_f32(vscl, vcvtq_f32_s32(x0)));
+	vst1q_f32(outp + 4, vmulq_f32(vscl, vcvtq_f32_s32(x1)));
+}
+
+QVEC_LOOP(neon_i32_to_u8_q31, QVEC_NEON_ATTR, 16, uint8_t, int32_t, neon_blk_i32_to_u8_q31)
+QVEC_LOOP(neon_i32_to_u8_flt, QVEC_NEON_ATTR, 16, uint8_t, int32_t, neon_blk_i32_to_u8_flt)
+QVEC_LOOP(neon_i32_to_i16_q31, QVEC_NEON_ATTR, 8, int16_t, int32_t, neon_blk_i32_to_i16_q31)
+QVEC_LOOP(neon_u8_to_u8, QVEC_NEON_ATTR, 16, uint8_t, uint8_t, neon_blk_u8_to_u8)
+QVEC_LOOP(neon_f32_to_u8, QVEC_NEON_ATTR, 16, uint8_t, float, neon_blk_f32_to_u8)
+QVEC_LOOP(neon_u8_to_f32, QVEC_NEON_ATTR, 16, float, uint8_t, neon_blk_u8_to_f32)
+QVEC_LOOP(neon_f32_to_x16, QVEC_NEON_ATTR, 8, int16_t, float, neon_blk_f32_to_x16)
+QVEC_LOOP(neon_x16_to_f32, QVEC_NEON_ATTR, 8, float, uint16_t, neon_blk_x16_to_f32)
+
+static struct qvec_funcs const qvec_funcs_neon = {
+	.name = "neon",
+	.i32_to_u8_q31 = neon_i32_to_u8_q31,
+	.i32_to_u8_flt = neon_i32_to_u8_flt,
+	.i32_to_i16_q31 = neon_i32_to_i16_q31,
+	.u8_to_u8 = neon_u8_to_u8,
+	.f32_to_u8 = neon_f32_to_u8,
+	.u8_to_f32 = neon_u8_to_f32,
+	.f32_to_x16 = neon_f32_to_x16,
+	.x16_to_f32 = neon_x16_to_f32,
+};
+#endif // QVEC_NEON
+
+#if defined(QVEC_X86) || defined(QVEC_NEON)
+#pragma pop_macro("__attribute__")
+#endif
+
+//////////////////////////////////////////////////////////////////
+// dispatch
+//////////////////////////////////////////////////////////////////
+
+static struct qvec_funcs const *qvec_funcs_p = NULL;
+
+// all of the backends built, best first
+static struct qvec_funcs const *const qvec_all_funcs[] = {
+#if defined(QVEC_X86)
+	&qvec_funcs_avx2,
+	&qvec_funcs_sse41,
+#elif defined(QVEC_NEON)
+	&qvec_funcs_neon,
+#endif
+	&qvec_funcs_c,
+};
+#define QVEC_N_FUNCS ((int)(sizeof(qvec_all_funcs)/sizeof(qvec_all_funcs[0])))
+
+static int qvec_supported(struct qvec_funcs const *fp)
+{
+#if defined(QVEC_X86)
+	__builtin_cpu_init();
+	if (fp == &qvec_funcs_avx2) return __builtin_cpu_supports("avx2");
+	if (fp == &qvec_funcs_sse41) return __builtin_cpu_supports("sse4.1");
+#endif
+	return 1;
+}
+
+static struct qvec_funcs const *qvec_select(void)
+{
+	int i;
+	for (i = 0; i < QVEC_N_FUNCS - 1; i++) {
+		if (qvec_supported(qvec_all_funcs[i])) return qvec_all_funcs[i];
+	}
+	return &qvec_funcs_c;
+}
+
+// (if several threads get here at once, they all store the same pointer)
+static inline struct qvec_funcs const *qvec_get(void)
+{
+	struct qvec_funcs const *fp = qvec_funcs_p;
+	if (fp == NULL) {
+		fp = qvec_select();
+		qvec_funcs_p = fp;
+	}
+	return fp;
+}
+
+char const *nn_qvec_backend_name(void)
+{
+	return qvec_get()->name;
+}
+
+int nn_qvec_set_backend(char const *name)
+{
+	int i;
+	if (name == NULL) {
+		qvec_funcs_p = qvec_select();
+		return 0;
+	}
+	for (i = 0; i < QVEC_N_FUNCS; i++) {
+		if (strcmp(qvec_all_funcs[i]->name, name) == 0) {
+			if (!qvec_supported(qvec_all_funcs[i])) return -1;
+			qvec_funcs_p = qvec_all_funcs[i];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void nn_qvec_i32_to_u8_q31(uint8_t *outp, int32_t const *inp, int n, int32_t gain, int32_t offset)
+{
+	struct qvec_parms parms;
+	parms.gain = gain;
+	parms.offset = offset;
+	// clip range for the vector code; see sse_blk_i32_to_u8_q31
+	parms.lo = (int32_t)min_i64(-(int64_t)offset, INT32_MAX);
+	parms.hi = (int32_t)min_i64(255 - (int64_t)offset, INT32_MAX);
+	if (n > 0) qvec_get()->i32_to_u8_q31(outp, inp, n, &parms);
+}
+
+void nn_qvec_i32_to_u8_flt(uint8_t *outp, int32_t const *inp, int n, float gain, float offset)
+{
+	struct qvec_parms parms;
+	parms.fgain = gain;
+	parms.foffset = offset;
+	if (n > 0) qvec_get()->i32_to_u8_flt(outp, inp, n, &parms);
+}
+
+void nn_qvec_i32_to_i16_q31(int16_t *outp, int32_t const *inp, int n, int32_t gain, int rsh)
+{
+	struct qvec_parms parms;
+	parms.gain = gain;
+	if (rsh >= 0) {
+		parms.clip = INT32_MAX;
+		parms.lsh = 0;
+		parms.sh = rsh & 15;
+	} else {
+		parms.lsh = 4 - rsh;		// 5..28
+		parms.clip = (int32_t)(((uint32_t)0x80000000 >> parms.lsh) - 1);
+		parms.sh = 4;
+	}
+	if (n > 0) qvec_get()->i32_to_i16_q31(outp, inp, n, &parms);
+}
+
+// parameters for u8->u8; these are found the same way as in nn_requantize_qu8_to_qu8_hvx
+static void qvec_u8_to_u8_parms(struct qvec_parms *pp, float gain, int32_t in_offset, int32_t out_offset)
+{
+	pp->in_off = saturate_i16(in_offset);
+	pp->out_off = saturate_i16(out_offset);
+	pp->tot_off = saturate_i16(pp->out_off - pp->in_off);
+	pp->g16 = 0;
+	pp->sh = 0;
+	if (fabsf(gain - 1.0f) < 6.1035156e-05f) {	// (CLOSE_ENUF in quantize.c)
+		pp->mode = QVEC_U8_UNIFORM;
+	} else if (gain > 1.0f) {
+		pp->mode = QVEC_U8_HI_GAIN;
+		pp->g16 = saturate_i16(roundf_i32(flt_getfrac(gain) * (float)(1u << 15)));
+		pp->sh = (15 - flt_getexp(gain)) & 15;
+	} else {
+		pp->mode = QVEC_U8_LO_GAIN;
+		pp->g16 = saturate_i16(roundf_i32(gain * (float)(1u << 15)));
+	}
+}
+
+void nn_qvec_u8_to_u8(uint8_t *outp, uint8_t const *inp, int n, float gain, int32_t in_offset, int32_t out_offset)
+{
+	struct qvec_parms parms;
+	qvec_u8_to_u8_parms(&parms, gain, in_offset, out_offset);
+	if (n > 0) qvec_get()->u8_to_u8(outp, inp, n, &parms);
+}
+
+void nn_qvec_u8_to_u8_d32(uint8_t *outp, uint8_t const *inp, int h_count, int nd32, int rowbytes,
+		int height_stride, int d32_stride, float gain, int32_t in_offset, int32_t out_offset)
+{
+	struct qvec_parms parms;
+	qvec_u8_to_u8_parms(&parms, gain, in_offset, out_offset);
+	qvec_u8_u8_fp fp = qvec_get()->u8_to_u8;
+	if (rowbytes <= 0) return;
+	for (int h = 0; h < h_count; h++) {
+		for (int id32 = 0; id32 < nd32; id32++) {
+			int offs = h * height_stride + id32 * d32_stride;
+			(*fp)(outp + offs, inp + offs, rowbytes, &parms);
+		}
+	}
+}
+
+void nn_qvec_f32_to_u8(uint8_t *outp, float const *inp, int n, float minval, float recip_stepsize)
+{
+	struct qvec_parms parms;
+	parms.fgain = recip_stepsize;
+	parms.foffset = minval;
+	if (n > 0) qvec_get()->f32_to_u8(outp, inp, n, &parms);
+}
+
+void nn_qvec_u8_to_f32(float *outp, uint8_t const *inp, int n, int qzero, float qstep)
+{
+	struct qvec_parms parms;
+	parms.zero = qzero;
+	parms.fgain = qstep;
+	if (n > 0) qvec_get()->u8_to_f32(outp, inp, n, &parms);
+}
+
+void nn_qvec_f32_to_x16(int16_t *outp, float const *inp, int n, float scale, int offset, int xorval)
+{
+	struct qvec_parms parms;
+	parms.fgain = scale;
+	parms.offset = offset;
+	parms.xorval = xorval;
+	if (n > 0) qvec_get()->f32_to_x16(outp, inp, n, &parms);
+}
+
+void nn_qvec_x16_to_f32(float *outp, uint16_t const *inp, int n, int xorval, int zero, float scale)
+{
+	struct qvec_parms parms;
+	parms.xorval = xorval;
+	parms.zero = zero;
+	parms.fgain = scale;
+	if (n > 0) qvec_get()->x16_to_f32(outp, inp, n, &parms);
+}
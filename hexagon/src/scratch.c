@@ -46,11 +46,21 @@ int nn_scratch_grow(struct nn_graph *nn, size_t bytes)
 {
 	void *newscratch;
 	bytes = (bytes + 127) & ~127;
+	if (nn->state == NN_GRAPH_PREPARED && nn->scratch_size < bytes) {
+		// arenas are sized at prepare (see nn_scratch_plan_graph)
+		if (nn->batchpar_worker != NULL || (nn->scratch_planned && nn_option_get(nn,scratch_strict))) {
+			return errlog(nn,"scratch: %d bytes needed at execute, only %d planned",(int)bytes,(int)nn->scratch_size);
+		}
+		logmsg(nn,1,"scratch: growing from %d to %d bytes at execute (not planned)",(int)nn->scratch_size,(int)bytes);
+	}
 	nn_mutex_lock(&nn->scratch_mutex);
 
 	if (nn->scratch_size < bytes) {
 		newscratch = nn_memalign(128,bytes);
-		if (newscratch == NULL) return errlog(nn,"can't alloc scretch (req: %d)",bytes);
+		if (newscratch == NULL) {
+			nn_mutex_unlock(&nn->scratch_mutex);
+			return errlog(nn,"can't alloc scretch (req: %d)",bytes);
+		}
 		nn_free(nn->scratch);
 		nn->scratch = newscratch;
 		nn->scratch_size = bytes;
@@ -60,4 +70,44 @@ int nn_scratch_grow(struct nn_graph *nn, size_t bytes)
 	return 0;
 }
 
+int nn_scratch_hint_none(struct nn_node *self, struct nn_graph *nn, uint32_t *bytes)
+{
+	*bytes = 0;
+	return 0;
+}
 
+// the node's scratch_hint; -1 if it has none, or it can't tell.
+int nn_scratch_node_needs(struct nn_graph *nn, struct nn_node *node, uint32_t *bytes)
+{
+	*bytes = 0;
+	if (node->ops->scratch_hint == NULL) return -1;
+	if ((*node->ops->scratch_hint)(node,nn,bytes) != 0) return -1;
+	*bytes = (*bytes + 127) & ~127u;
+	return 0;
+}
+
+int nn_scratch_plan_graph(struct nn_graph *nn)
+{
+	struct nn_node *node;
+	uint32_t need = 0;
+	uint32_t bytes;
+	int n_hinted = 0;
+	int n_nodes = 0;
+
+	for (node = nn->head; node != NULL; node = node->next) {
+		n_nodes++;
+		node->flags &= ~NN_NODE_FLAG_SCRATCH_PLANNED;
+		if (nn_scratch_node_needs(nn,node,&bytes) != 0) continue;
+		node->flags |= NN_NODE_FLAG_SCRATCH_PLANNED;
+		n_hinted++;
+		if (bytes > need) {
+			logmsg(nn,3,"scratch: node %x needs %d bytes",node->node_id,(int)bytes);
+			need = bytes;
+		}
+	}
+	logmsg(nn,2,"scratch: %d of %d nodes hinted, needing at most %d bytes; arena is %d",
+		n_hinted,n_nodes,(int)need,(int)nn->scratch_size);
+	// (nodes without a hint may still rely on the default size, so never shrink it)
+	if (need > nn->scratch_size) return nn_scratch_grow(nn,need);
+	return 0;
+}
@@ -48,92 +48,13 @@ int nn_tensor_copy(struct tensor *dst, const struct tensor *src)
 
 //
 // thread-parallel memcpy manager
+// (a front end to the graph's copy engine; see nn_graph_copyeng.h)
 //
 
 void nn_mcmanager_init(struct nn_graph *nn, struct nn_memcpy_manager *mcm)
 {
-	nn_sem_init(&mcm->done_sem, 0);
-	mcm->pending = 0;
-	mcm->avglen = 32768;
-	mcm->avail_set = (1 << NN_MEMCPY_MANAGER_SLOTS) - 1;
-	mcm->ready_set = 0;
+	mcm->fence = 0;
 }
-static void mcmanager_work_func(struct nn_graph *nn, void *mcmv);
-
-// some common code for the mc_manager task buffer protocol
-// returns a bit mask for the slot, and a pointer to the
-// slot buffer to be filled in. If this fails, pointer is
-// null, slot_bit = 0; this should never happen.
-//
-typedef struct
-{
-	unsigned slot_bit;
-	struct nn_memcpy_manager_op *slotp;
-} mcmanager_avail_slot;
-
-static inline mcmanager_avail_slot
-	__attribute__((always_inline))
-	mcmanager_get_available_slot(struct nn_graph *nn, struct nn_memcpy_manager *mcm, int defer_flag)
-{
-	// find a slot to use: remove a '1' from avail_set.
-	// pick the first available slot if defer_flag =0; last if defer_flag != 0
-	int slotno;
-	unsigned slot_bit;
-	unsigned set_old0;
-	unsigned set_old = mcm->avail_set;
-	mcmanager_avail_slot result;
-	do
-	{
-		unsigned set = set_old & (1 << NN_MEMCPY_MANAGER_SLOTS) - 1;
-		if (!defer_flag)
-		{
-			slotno = Q6_R_ct0_R(set);
-		}
-		else
-		{
-			slotno = 31 - Q6_R_cl0_R(set);
-		}
-		if ((unsigned)slotno >= NN_MEMCPY_MANAGER_SLOTS)
-		{
-			errlog(nn, "??? invalid avail slot in mcmanager ");
-			result.slotp = NULL;
-			result.slot_bit = 0;
-			return result;
-		}
-		slot_bit = 1 << slotno;
-		unsigned set_new = set & ~slot_bit;
-		set_old0 = set_old;
-		set_old = __sync_val_compare_and_swap(&mcm->avail_set, set_old, set_new);
-	} while (set_old != set_old0);
-	result.slot_bit = slot_bit;
-	result.slotp = &mcm->ops[slotno];
-	return result;
-}
-// protocol to make the slot ready once it's been filled in.
-// it's marked ready immediately, before we even check for "back-pressure".
-// it may get picked up by an already-launched thread but
-// that's OK; the thread we launch will then process an older slot.
-static inline void
-	__attribute__((always_inline))
-	mcmanager_make_ready_slot(struct nn_graph *nn, struct nn_memcpy_manager *mcm, mcmanager_avail_slot slotinfo)
-{
-	// set the bit in 'ready_set', atomically
-	__sync_or_and_fetch(&mcm->ready_set, slotinfo.slot_bit);
-
-	// if too many pending, wait.
-	while (mcm->pending >= NN_MEMCPY_MANAGER_MAX_THREADS)
-	{
-		nn_sem_wait(&mcm->done_sem);
-		mcm->pending--;
-	}
-	mcm->pending++;
-	nn_os_work_for_vector(nn, mcmanager_work_func, mcm);
-}
-
-// This is the # of l2fetch we do on vmemcpy in the
-// 'launch' thread. The rest (if any) is done in the run thread.
-//
-#define NN_MCMANAGER_VMEMCPY_L2FETCH0 1024
 
 // this executes memcpy or memset requests.
 // This is *not* safe to call in multiple threads on the same nn_memcpy_manager
@@ -175,33 +96,11 @@ void nn_mcmanager_vmemcpy_or_set(struct nn_graph *nn, struct nn_memcpy_manager *
 			unsigned extra = (size_t)dend & 255;
 			copynow -= extra;
 		}
-		// if memcpy, issue l2fetch for  at most NN_MCMANAGER_VMEMCPY_L2FETCH0
-		// (the rest is done in the work thread)
-		if (src != NULL)
-		{
-			l2fetch(srcp, 128, 128,
-					min_i32((copynow + 127) >> 7, NN_MCMANAGER_VMEMCPY_L2FETCH0 / 128u));
-		}
+		// (nn_copyeng_submit prefetches the start of the source; the work thread the rest)
 		//printf("!! %p <- %p of %u (%u left)\n", dstp, srcp, copynow, copy_remain);
-		// find a slot to use:
-		// pick the first available slot if the current
-		// copy is large; and the last if it's small.
-		unsigned avglen = mcm->avglen;
-		mcm->avglen = (copynow + avglen) >> 1;
-		mcmanager_avail_slot slot = mcmanager_get_available_slot(nn, mcm, copynow <= avglen);
-		// we have allocated a slot. Fill it in and mark it ready.
-
-		struct nn_memcpy_manager_op *opp = slot.slotp;
-		if (opp == NULL) // failed to get slot
-			return;
-		opp->dst = dstp;
-		opp->src = srcp;
-		opp->len = copynow;
-		opp->val = fillval;
-		opp->rows = 0; // select '1-d' operation.
-
-		// - protocol to make slot ready and launch work thread.
-		mcmanager_make_ready_slot(nn, mcm, slot);
+		struct nn_copy_desc desc = {
+			.dst = dstp, .src = srcp, .width = copynow, .fillval = fillval};
+		mcm->fence = nn_copyeng_submit(nn, &desc);
 
 		dstp += copynow;
 		if (src != NULL)
@@ -216,26 +115,48 @@ void nn_mcmanager_vmemcpy_or_set(struct nn_graph *nn, struct nn_memcpy_manager *
 void nn_manager_vmemcpy_or_set_2d(int width, int height, void *dst, void const *src,
 								  unsigned dst_stride, unsigned src_stride_or_fillval, struct nn_graph *nn, struct nn_memcpy_manager *mcm)
 {
-	if (src != NULL && height < 2)
-	{ // it's a 1-row 2d memcpy ?
-		if (height <= 0)
-			return; // it's no-row memcpy.
-		height = 0; // this will get executed as a 1d memcpy.
-		// do the early prefetch (work thread assumes this is done for 1d memcpy)
-		l2fetch(src, 128, 128,
-				min_i32((width + 127) >> 7, NN_MCMANAGER_VMEMCPY_L2FETCH0 / 128u));
-	}
-	mcmanager_avail_slot slot = mcmanager_get_available_slot(nn, mcm, 0);
-	struct nn_memcpy_manager_op *opp = slot.slotp;
-	if (opp == NULL) // failed to get slot
+	if (height <= 0 || width <= 0)
 		return;
-	opp->dst = dst;
-	opp->src = src;
-	opp->len = width;
-	opp->val = src_stride_or_fillval;
-	opp->rows = height;
-	opp->dst_stride = dst_stride;
-	mcmanager_make_ready_slot(nn, mcm, slot);
+	struct nn_copy_desc desc = {
+		.dst = dst, .src = src, .width = width, .height = height, .dst_row_stride = dst_stride};
+	if (src != NULL)
+		desc.src_row_stride = src_stride_or_fillval;
+	else
+		desc.fillval = src_stride_or_fillval;
+	mcm->fence = nn_copyeng_submit(nn, &desc);
+}
+// 3d version: 'depth' planes of the 2d operation.
+// The planes are split over up to NN_MCMANAGER_3D_MAXSPLIT descriptors (so they can run
+// in parallel), but not below NN_MCMANAGER_3D_MINCHUNK bytes per descriptor.
+#define NN_MCMANAGER_3D_MAXSPLIT 4
+#define NN_MCMANAGER_3D_MINCHUNK (32 * 1024)
+void nn_manager_vmemcpy_or_set_3d(int width, int height, int depth, void *dst, void const *src,
+								  unsigned dst_stride, unsigned src_stride_or_fillval, int dst_plane_stride, int src_plane_stride,
+								  struct nn_graph *nn, struct nn_memcpy_manager *mcm)
+{
+	if (height <= 0 || width <= 0 || depth <= 0)
+		return;
+	unsigned plane_bytes = width * height;
+	int planes_per = max_i32(1, (NN_MCMANAGER_3D_MINCHUNK + plane_bytes - 1) / plane_bytes);
+	planes_per = max_i32(planes_per, (depth + NN_MCMANAGER_3D_MAXSPLIT - 1) / NN_MCMANAGER_3D_MAXSPLIT);
+	struct nn_copy_desc desc = {
+		.dst = dst, .src = src, .width = width, .height = height,
+		.dst_row_stride = dst_stride, .dst_plane_stride = dst_plane_stride};
+	if (src != NULL)
+	{
+		desc.src_row_stride = src_stride_or_fillval;
+		desc.src_plane_stride = src_plane_stride;
+	}
+	else
+		desc.fillval = src_stride_or_fillval;
+	for (int p = 0; p < depth; p += planes_per)
+	{
+		desc.depth = min_i32(planes_per, depth - p);
+		mcm->fence = nn_copyeng_submit(nn, &desc);
+		desc.dst = (uint8_t *)desc.dst + dst_plane_stride * desc.depth;
+		if (src != NULL)
+			desc.src = (uint8_t const *)desc.src + src_plane_stride * desc.depth;
+	}
 }
 //
 // this is wrapper for nn_mcmanager_vmemcpy, to handle tensors
@@ -258,72 +179,16 @@ int nn_mcmanager_tensor_copy(struct nn_graph *nn, struct nn_memcpy_manager *mcm,
 
 void nn_mcmanager_wait(struct nn_graph *nn, struct nn_memcpy_manager *mcm)
 {
-	while (mcm->pending > 0)
-	{
-		nn_sem_wait(&mcm->done_sem);
-		--mcm->pending;
-	}
+	nn_copyeng_wait(nn, mcm->fence);
+	mcm->fence = 0;
 }
 
-static void
-mcmanager_work_func(struct nn_graph *nn, void *mcmv)
+void nn_mcmanager_defer(struct nn_graph *nn, struct nn_memcpy_manager *mcm, struct nn_node *self)
 {
-	struct nn_memcpy_manager *mcm = (struct nn_memcpy_manager *)mcmv;
-	//
-	// grab one bit from 'ready_set' using compare_and_swap.
-	// get the smallest bit # if more than one.
-	unsigned set_old = mcm->ready_set;
-	int slotno;
-	unsigned set_old0;
-	unsigned slot_bit = 0;
-	do
-	{
-		slotno = Q6_R_ct0_R(set_old);
-		if (slotno >= NN_MEMCPY_MANAGER_SLOTS)
-			goto quit; // should not happen
-		slot_bit = 1 << slotno;
-		unsigned set_new = set_old & ~slot_bit;
-		set_old0 = set_old;
-		set_old = __sync_val_compare_and_swap(&mcm->ready_set, set_old, set_new);
-	} while (set_old != set_old0);
-	// remove data (and ownership) from the op slot before
-	// starting the copy.
-	struct nn_memcpy_manager_op const *opp = &mcm->ops[slotno];
-	void *d = opp->dst;
-	void const *s = opp->src;
-	unsigned n = opp->len;
-	unsigned fillval = opp->val;
-	unsigned rows = opp->rows;
-	unsigned dst_stride = opp->dst_stride;
-	__sync_or_and_fetch(&mcm->avail_set, slot_bit);
-	if (s != NULL)
-	{
-		if (rows == 0)
-		{ // normal memcpy
-			if (n > NN_MCMANAGER_VMEMCPY_L2FETCH0)
-			{
-				l2fetch((uint8_t const *)s + NN_MCMANAGER_VMEMCPY_L2FETCH0,
-						128, 128, (n - NN_MCMANAGER_VMEMCPY_L2FETCH0 + 127) >> 7);
-			}
-			vmemcpy_asm(d, s, n);
-		}
-		else
-		{
-			// 2d memcpy of rows x n, with 'fillval' as src stride
-			// use a variant with built-in prefetch strategy.
-			vmemcpy_2d_general_with_prefetch(n, rows, d, dst_stride, s, fillval);
-		}
-	}
-	else
-	{
-		if (rows == 0)
-			vmemset_32_2d_asm(d, fillval, n, 1, 0);
-		else
-			vmemset_32_2d_general_asm(d, fillval, n, rows, dst_stride);
-	}
-quit:
-	nn_sem_post(&mcm->done_sem);
+	nn_copyeng_defer(nn, self, mcm->fence);
+	mcm->fence = 0;
 }
+
 // this is like memcpy_2d_general_asm except
 // it does prefetch before each pass as needed, or once before
 //     the whole thing.
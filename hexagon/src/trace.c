@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the allocation and readout of the execution trace rings
+ * (see nn_graph_trace.h).
+ */
+#include <nn_graph.h>
+#include <string.h>
+
+extern int Total_Threads;
+
+void nn_trace_free(struct nn_graph *nn)
+{
+	struct nn_trace *tr = nn->trace;
+	int i;
+	if (tr == NULL) return;
+	nn->trace = NULL;
+	for (i = 0; i < tr->n_rings; i++) {
+		if (tr->rings[i].events) nn_free(tr->rings[i].events);
+	}
+	nn_free(tr);
+}
+
+int nn_trace_setup(struct nn_graph *nn)
+{
+	struct nn_trace *tr = nn->trace;
+	int n_events = nn_option_get(nn,trace_events);
+	uint32_t ring_size;
+	uint32_t n_rings = Total_Threads + 1;
+	int i;
+
+	if (n_events <= 0) {
+		nn_trace_free(nn);
+		return 0;
+	}
+	for (ring_size = 16; ring_size < n_events && ring_size < (1u<<24); ring_size *= 2);
+	if (tr != NULL && tr->ring_mask == ring_size-1 && tr->n_rings == n_rings) return 0;
+	nn_trace_free(nn);
+	if ((tr = nn_calloc(1,sizeof(*tr) + n_rings * sizeof(tr->rings[0]))) == NULL) {
+		return errlog(nn,"can't alloc trace");
+	}
+	tr->ring_mask = ring_size-1;
+	tr->n_rings = n_rings;
+	for (i = 0; i < n_rings; i++) {
+		if ((tr->rings[i].events = nn_malloc(ring_size * sizeof(struct trace_event))) == NULL) {
+			nn->trace = tr;
+			nn_trace_free(nn);
+			return errlog(nn,"can't alloc %d trace events",(int)ring_size);
+		}
+	}
+	logmsg(nn,2,"trace: %d threads x %d events",(int)n_rings,(int)ring_size);
+	nn->trace = tr;
+	return 0;
+}
+
+uint32_t do_trace_get(struct nn_graph *nn, struct trace_event *events, uint32_t max_events)
+{
+	struct nn_trace *tr = nn->trace;
+	uint32_t n = 0;
+	int i;
+	if (tr == NULL) return 0;
+	for (i = 0; i < tr->n_rings; i++) {
+		struct nn_trace_ring *ring = &tr->rings[i];
+		uint32_t head = ring->head;
+		uint32_t count = (head > tr->ring_mask) ? tr->ring_mask + 1 : head;
+		uint32_t pos = head - count;
+		if (count > max_events - n) count = max_events - n;
+		for (; count > 0; count--, pos++) {
+			events[n++] = ring->events[pos & tr->ring_mask];
+		}
+		ring->head = 0;
+	}
+	return n;
+}
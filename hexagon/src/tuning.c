@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * 
+ * Now that that's out of the way, let's get to the good stuff.
+ * 
+ * This contains the tuning database (see nn_graph_tuning.h).
+ * It's small (one record per distinct conv shape), so it's just an array
+ * searched linearly.
+ */
+#include <nn_graph.h>
+#include <string.h>
+
+void nn_tuning_free(struct nn_graph *nn)
+{
+	struct nn_tuning_db *db = nn->tuning;
+	if (db == NULL) return;
+	nn->tuning = NULL;
+	if (db->records) nn_free(db->records);
+	nn_free(db);
+}
+
+static int tuning_reserve(struct nn_graph *nn, uint32_t n_records)
+{
+	struct nn_tuning_db *db = nn->tuning;
+	struct tuning_record *newrecs;
+	uint32_t newmax;
+	if (db == NULL) {
+		if ((db = nn_calloc(1,sizeof(*db))) == NULL) return errlog(nn,"can't alloc tuning db");
+		nn->tuning = db;
+	}
+	if (n_records <= db->max_records) return 0;
+	for (newmax = (db->max_records > 0) ? db->max_records : 16; newmax < n_records; newmax *= 2);
+	if ((newrecs = nn_realloc(db->records,newmax*sizeof(*newrecs))) == NULL) {
+		return errlog(nn,"can't grow tuning db to %d records",(int)newmax);
+	}
+	db->records = newrecs;
+	db->max_records = newmax;
+	return 0;
+}
+
+const struct tuning_record *nn_tuning_lookup(struct nn_graph *nn, const struct tuning_record *key)
+{
+	struct nn_tuning_db *db = nn->tuning;
+	uint32_t i;
+	if (db == NULL) return NULL;
+	for (i = 0; i < db->n_records; i++) {
+		if (memcmp(&db->records[i],key,NN_TUNING_KEY_SIZE) == 0) return &db->records[i];
+	}
+	return NULL;
+}
+
+int nn_tuning_store(struct nn_graph *nn, const struct tuning_record *rec)
+{
+	struct tuning_record *old = (struct tuning_record *)nn_tuning_lookup(nn,rec);
+	if (old != NULL) {
+		*old = *rec;
+		return 0;
+	}
+	if (tuning_reserve(nn,(nn->tuning ? nn->tuning->n_records : 0) + 1) != 0) return -1;
+	nn->tuning->records[nn->tuning->n_records++] = *rec;
+	return 0;
+}
+
+uint32_t do_tuning_db_get(struct nn_graph *nn, struct tuning_record *records, uint32_t max_records)
+{
+	struct nn_tuning_db *db = nn->tuning;
+	uint32_t n;
+	if (db == NULL) return 0;
+	n = (db->n_records < max_records) ? db->n_records : max_records;
+	memcpy(records,db->records,n*sizeof(*records));
+	return n;
+}
+
+int do_tuning_db_set(struct nn_graph *nn, const struct tuning_record *records, uint32_t n_records)
+{
+	uint32_t i;
+	if (nn->tuning) nn->tuning->n_records = 0;
+	for (i = 0; i < n_records; i++) {
+		if (nn_tuning_store(nn,&records[i]) != 0) return -1;
+	}
+	logmsg(nn,2,"tuning db: %d records",(int)n_records);
+	return 0;
+}
@@ -22,6 +22,7 @@ graph_app_C_SRCS += \
     test/options \
     test/imagenet_info \
     test/append_const_node_large_array \
+    hexagon/host/hexnn_capture \
     $(COMPILE_GRAPHINIT) \
 
 ifeq ($(GRAPH_WRAPPER), 1)
@@ -52,9 +53,33 @@ else
 	graph_app_DLLS += libadsprpc
 endif
 graph_app_LD_FLAGS += -llog
-CC_FLAGS += -Iinterface
+CC_FLAGS += -Iinterface -Ihexagon/host
 graph_app_DEFINES += VERIFY_PRINT_ERROR
 
+# per-op microbenchmark
+BUILD_EXES+=op_bench
+op_bench_QAICIDLS += interface/hexagon_nn
+op_bench_C_SRCS += test/op_bench $V/hexagon_nn_stub
+op_bench_LIBS += rpcmem
+ifeq ($(CDSP_FLAG), 1)
+	op_bench_DLLS += libcdsprpc
+else
+	op_bench_DLLS += libadsprpc
+endif
+op_bench_LD_FLAGS += -llog
+
+# batch-parallel segments against the sequential run
+BUILD_EXES+=batchpar_check
+batchpar_check_QAICIDLS += interface/hexagon_nn
+batchpar_check_C_SRCS += test/batchpar_check $V/hexagon_nn_stub
+batchpar_check_LIBS += rpcmem
+ifeq ($(CDSP_FLAG), 1)
+	batchpar_check_DLLS += libcdsprpc
+else
+	batchpar_check_DLLS += libadsprpc
+endif
+batchpar_check_LD_FLAGS += -llog
+
 # copy final build products to the ship directory
 BUILD_COPIES = \
     interface/hexagon_nn.idl \
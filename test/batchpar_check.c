@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * batchpar_check: batch-parallel execution against the usual sequential run.
+ *
+ * For each shape (batches > 1), build
+ *
+ *	INPUT (f:BxHxWxD) ; Add_f (bias) ; Relu_f ; MaxPool_f 3x3/2 ; Mul_f (scale) ; Tanh_f ; OUTPUT
+ *
+ * which prepare turns into one batch-parallel segment when 'batch_parallel' is
+ * set, and run it on the same random input with
+ *
+ *	batch_parallel=0			(the reference)
+ *	batch_parallel=2, batch_parallel=4
+ *	batch_parallel=2, trace_events=1024	(segments are ignored while tracing)
+ *
+ * The output must be bit-exact against the reference, and every node must report
+ * one execution per run in the perf info (the nodes of a segment share its cycles).
+ * Returns nonzero if anything is off.
+ *
+ *   batchpar_check [--shapes BxHxWxD[,BxHxWxD...]] [--iters N] [--debug N]
+ */
+
+#include "hexagon_nn.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifdef ANDROID
+#include "rpcmem.h"
+#define ION_HEAP_ID_SYSTEM 25
+#else
+#define rpcmem_init() /* NOTHING */
+#define rpcmem_deinit() /* NOTHING */
+#define rpcmem_free(a) free((a))
+#define rpcmem_alloc(a, b, c) malloc(c)
+#endif
+
+#define MAX_SHAPES 16
+#define MAX_PERF_NODES 64
+#define CHECK_LOG_SIZE (64*1024)
+
+#define PERFEVENT_CYCLES 0		// NN_GRAPH_PERFEVENT_CYCLES
+
+#define INPUT_NODE_ID 0x100
+#define BIAS_NODE_ID 0x1000
+#define SCALE_NODE_ID 0x1001
+#define WINDOW_NODE_ID 0x1002
+#define STRIDE_NODE_ID 0x1003
+#define ADD_NODE_ID 0x2000
+#define RELU_NODE_ID 0x2001
+#define POOL_NODE_ID 0x2002
+#define MUL_NODE_ID 0x2003
+#define TANH_NODE_ID 0x2004
+#define OUTPUT_NODE_ID 0x3000
+
+struct check_shape {
+	uint32_t b, h, w, d;
+};
+
+struct check_config {
+	const char *name;
+	int batch_parallel;
+	int trace_events;
+};
+
+static const struct check_config configs[] = {
+	{ "sequential", 0, 0 },
+	{ "batch_parallel=2", 2, 0 },
+	{ "batch_parallel=4", 4, 0 },
+	{ "batch_parallel=2 +trace", 2, 1024 },
+};
+
+#define N_CONFIGS (sizeof(configs)/sizeof(configs[0]))
+
+struct check_ops {
+	uint32_t input, output;
+	uint32_t add, relu, pool, mul, tanh;
+};
+
+static uint32_t rand_state = 0x2468ace1;
+
+static inline uint32_t check_rand()
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
+
+static inline float check_rand_float()
+{
+	return (float)((int32_t)(check_rand() & 0xFFFF) - 0x8000) / 8192.0f;
+}
+
+static void print_log(hexagon_nn_nn_id id)
+{
+	unsigned char *buf;
+	if ((buf = malloc(CHECK_LOG_SIZE)) == NULL) return;
+	buf[0] = 0;
+	hexagon_nn_getlog(id,buf,CHECK_LOG_SIZE);
+	buf[CHECK_LOG_SIZE-1] = 0;
+	if (buf[0]) printf("%s",(char *)buf);
+	free(buf);
+}
+
+static void set_output_def(hexagon_nn_output *o, uint32_t b, uint32_t h, uint32_t w, uint32_t d)
+{
+	memset(o,0,sizeof(*o));
+	o->rank = 4;
+	o->max_sizes[0] = b;
+	o->max_sizes[1] = h;
+	o->max_sizes[2] = w;
+	o->max_sizes[3] = d;
+	o->elementsize = sizeof(float);
+}
+
+static void set_input(hexagon_nn_input *in, uint32_t src_id)
+{
+	in->src_id = src_id;
+	in->output_idx = 0;
+}
+
+/*
+ * Build the graph for shape s under config c, run it 'iters' times, and leave the
+ * last output in out. Returns 0 on success.
+ */
+static int run_one(const struct check_ops *ops, const struct check_config *c, const struct check_shape *s,
+	const float *in_data, const float *bias, const float *scale,
+	hexagon_nn_tensordef *out, int iters, int debug_level)
+{
+	static const uint32_t window[4] = { 1, 3, 3, 1 };
+	static const uint32_t stride[4] = { 1, 2, 2, 1 };
+	uint32_t oh = (s->h + 1) / 2;
+	uint32_t ow = (s->w + 1) / 2;
+	hexagon_nn_input inputs[2];
+	hexagon_nn_output outdef;
+	hexagon_nn_tensordef in;
+	hexagon_nn_perfinfo info[MAX_PERF_NODES];
+	hexagon_nn_nn_id id;
+	unsigned int n_info = 0;
+	int i;
+	int ret = -1;
+
+	if (hexagon_nn_init(&id) != 0) {
+		printf("can't init graph\n");
+		return -1;
+	}
+	hexagon_nn_set_debug_level(id,debug_level);
+	if (hexagon_nn_set_graph_option(id,"batch_parallel",c->batch_parallel) != 0
+	 || hexagon_nn_set_graph_option(id,"trace_events",c->trace_events) != 0) {
+		printf("can't set options\n");
+		goto err_graph;
+	}
+
+	set_output_def(&outdef,s->b,s->h,s->w,s->d);
+	if (hexagon_nn_append_node(id,INPUT_NODE_ID,ops->input,NN_PAD_NA,NULL,0,&outdef,1) != 0) goto err_graph;
+	if (hexagon_nn_append_const_node(id,BIAS_NODE_ID,1,1,1,s->d,(const uint8_t *)bias,s->d*sizeof(float)) != 0
+	 || hexagon_nn_append_const_node(id,SCALE_NODE_ID,1,1,1,s->d,(const uint8_t *)scale,s->d*sizeof(float)) != 0
+	 || hexagon_nn_append_const_node(id,WINDOW_NODE_ID,window[0],window[1],window[2],window[3],NULL,0) != 0
+	 || hexagon_nn_append_const_node(id,STRIDE_NODE_ID,stride[0],stride[1],stride[2],stride[3],NULL,0) != 0) {
+		goto err_graph;
+	}
+
+	set_input(&inputs[0],INPUT_NODE_ID);
+	set_input(&inputs[1],BIAS_NODE_ID);
+	if (hexagon_nn_append_node(id,ADD_NODE_ID,ops->add,NN_PAD_NA,inputs,2,&outdef,1) != 0) goto err_graph;
+	set_input(&inputs[0],ADD_NODE_ID);
+	if (hexagon_nn_append_node(id,RELU_NODE_ID,ops->relu,NN_PAD_NA,inputs,1,&outdef,1) != 0) goto err_graph;
+
+	set_output_def(&outdef,s->b,oh,ow,s->d);
+	set_input(&inputs[0],RELU_NODE_ID);
+	set_input(&inputs[1],WINDOW_NODE_ID);
+	{
+		hexagon_nn_input pool_inputs[3];
+		pool_inputs[0] = inputs[0];
+		pool_inputs[1] = inputs[1];
+		set_input(&pool_inputs[2],STRIDE_NODE_ID);
+		if (hexagon_nn_append_node(id,POOL_NODE_ID,ops->pool,NN_PAD_SAME,pool_inputs,3,&outdef,1) != 0) goto err_graph;
+	}
+	set_input(&inputs[0],POOL_NODE_ID);
+	set_input(&inputs[1],SCALE_NODE_ID);
+	if (hexagon_nn_append_node(id,MUL_NODE_ID,ops->mul,NN_PAD_NA,inputs,2,&outdef,1) != 0) goto err_graph;
+	set_input(&inputs[0],MUL_NODE_ID);
+	if (hexagon_nn_append_node(id,TANH_NODE_ID,ops->tanh,NN_PAD_NA,inputs,1,&outdef,1) != 0) goto err_graph;
+	set_input(&inputs[0],TANH_NODE_ID);
+	if (hexagon_nn_append_node(id,OUTPUT_NODE_ID,ops->output,NN_PAD_NA,inputs,1,NULL,0) != 0) goto err_graph;
+	if (hexagon_nn_prepare(id) != 0) {
+		printf("prepare failed\n");
+		goto err_graph;
+	}
+
+	memset(&in,0,sizeof(in));
+	in.batches = s->b;
+	in.height = s->h;
+	in.width = s->w;
+	in.depth = s->d;
+	in.data = (unsigned char *)in_data;
+	in.dataLen = s->b * s->h * s->w * s->d * sizeof(float);
+	in.data_valid_len = in.dataLen;
+
+	hexagon_nn_reset_perfinfo(id,PERFEVENT_CYCLES);
+	for (i = 0; i < iters; i++) {
+		if (hexagon_nn_execute_new(id,&in,1,out,1) != 0) {
+			printf("execute failed\n");
+			goto err_graph;
+		}
+	}
+	if (out->batches != s->b || out->height != oh || out->width != ow || out->depth != s->d) {
+		printf("%s: output is %ux%ux%ux%u, expected %ux%ux%ux%u\n",c->name,
+			out->batches,out->height,out->width,out->depth,s->b,oh,ow,s->d);
+		goto err_graph;
+	}
+	if (hexagon_nn_get_perfinfo(id,info,MAX_PERF_NODES,&n_info) != 0) {
+		printf("can't get perf info\n");
+		goto err_graph;
+	}
+	for (i = 0; i < n_info; i++) {
+		if (info[i].executions != iters) {
+			printf("%s: node %x ran %u times, expected %d\n",c->name,info[i].node_id,info[i].executions,iters);
+			goto err_graph;
+		}
+	}
+	ret = 0;
+err_graph:
+	if (ret != 0) print_log(id);
+	hexagon_nn_teardown(id);
+	return ret;
+}
+
+static int check_shape(const struct check_ops *ops, const struct check_shape *s, int iters, int debug_level)
+{
+	uint32_t n_in = s->b * s->h * s->w * s->d;
+	uint32_t out_len = s->b * ((s->h + 1) / 2) * ((s->w + 1) / 2) * s->d * sizeof(float);
+	hexagon_nn_tensordef outs[N_CONFIGS];
+	float *in_data = NULL;
+	float *bias = NULL;
+	float *scale = NULL;
+	int i;
+	int ret = -1;
+
+	memset(outs,0,sizeof(outs));
+	if ((in_data = rpcmem_alloc(ION_HEAP_ID_SYSTEM,RPCMEM_DEFAULT_FLAGS,n_in * sizeof(float))) == NULL
+	 || (bias = malloc(s->d * sizeof(float))) == NULL
+	 || (scale = malloc(s->d * sizeof(float))) == NULL) goto done;
+	for (i = 0; i < n_in; i++) in_data[i] = check_rand_float();
+	for (i = 0; i < s->d; i++) {
+		bias[i] = check_rand_float() * 0.25f;
+		scale[i] = 0.5f + fabsf(check_rand_float()) * 0.25f;
+	}
+	for (i = 0; i < N_CONFIGS; i++) {
+		outs[i].dataLen = out_len;
+		if ((outs[i].data = rpcmem_alloc(ION_HEAP_ID_SYSTEM,RPCMEM_DEFAULT_FLAGS,out_len)) == NULL) goto done;
+		memset(outs[i].data,0xAB,out_len);
+		if (run_one(ops,&configs[i],s,in_data,bias,scale,&outs[i],iters,debug_level) != 0) goto done;
+	}
+	ret = 0;
+	for (i = 1; i < N_CONFIGS; i++) {
+		const float *ref = (const float *)outs[0].data;
+		const float *got = (const float *)outs[i].data;
+		uint32_t n = out_len / sizeof(float);
+		uint32_t j;
+		if (outs[i].data_valid_len != outs[0].data_valid_len) {
+			printf("%ux%ux%ux%u %s: %u valid bytes, sequential had %u\n",s->b,s->h,s->w,s->d,
+				configs[i].name,outs[i].data_valid_len,outs[0].data_valid_len);
+			ret = -1;
+			continue;
+		}
+		if (memcmp(ref,got,out_len) == 0) continue;
+		for (j = 0; j < n; j++) {
+			if (memcmp(&ref[j],&got[j],sizeof(float)) != 0) break;
+		}
+		printf("%ux%ux%ux%u %s: differs from sequential at element %u (batch %u): %g vs %g\n",
+			s->b,s->h,s->w,s->d,configs[i].name,j,j / (n / s->b),got[j],ref[j]);
+		ret = -1;
+	}
+	printf("%ux%ux%ux%u: %s\n",s->b,s->h,s->w,s->d,ret == 0 ? "ok" : "FAILED");
+done:
+	for (i = 0; i < N_CONFIGS; i++) if (outs[i].data) rpcmem_free(outs[i].data);
+	if (in_data) rpcmem_free(in_data);
+	free(bias);
+	free(scale);
+	return ret;
+}
+
+static int parse_shapes(const char *str, struct check_shape *shapes, int max)
+{
+	const char *s = str;
+	int n = 0;
+	while (*s) {
+		struct check_shape *p;
+		if (n >= max) return -1;
+		p = &shapes[n++];
+		if (sscanf(s,"%ux%ux%ux%u",&p->b,&p->h,&p->w,&p->d) != 4) return -1;
+		if (p->b == 0 || p->h == 0 || p->w == 0 || p->d == 0) return -1;
+		if ((s = strchr(s,',')) == NULL) break;
+		s++;
+	}
+	return n;
+}
+
+static void usage(const char *prog)
+{
+	printf("usage: %s [options]\n",prog);
+	printf("  --shapes BxHxWxD[,BxHxWxD...]  shapes to check (default 4x16x16x32,3x9x7x40,8x2x2x128)\n");
+	printf("  --iters N                      executions per graph (default 2)\n");
+	printf("  --debug N                      graph debug level\n");
+}
+
+int main(int argc, char **argv)
+{
+	static struct check_shape shapes[MAX_SHAPES];
+	const char *shape_str = "4x16x16x32,3x9x7x40,8x2x2x128";
+	struct check_ops ops;
+	int iters = 2;
+	int debug_level = 0;
+	int n_shapes;
+	int n_failed = 0;
+	int i;
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		const char *v = (i+1 < argc) ? argv[i+1] : NULL;
+		if (strcmp(a,"--help") == 0) { usage(argv[0]); return 0; }
+		if (v == NULL) { usage(argv[0]); return 1; }
+		i++;
+		if (strcmp(a,"--shapes") == 0) shape_str = v;
+		else if (strcmp(a,"--iters") == 0) iters = atoi(v);
+		else if (strcmp(a,"--debug") == 0) debug_level = atoi(v);
+		else { usage(argv[0]); return 1; }
+	}
+	if (iters < 1 || (n_shapes = parse_shapes(shape_str,shapes,MAX_SHAPES)) <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (hexagon_nn_op_name_to_id("INPUT",&ops.input) != 0
+	 || hexagon_nn_op_name_to_id("OUTPUT",&ops.output) != 0
+	 || hexagon_nn_op_name_to_id("Add_f",&ops.add) != 0
+	 || hexagon_nn_op_name_to_id("Relu_f",&ops.relu) != 0
+	 || hexagon_nn_op_name_to_id("MaxPool_f",&ops.pool) != 0
+	 || hexagon_nn_op_name_to_id("Mul_f",&ops.mul) != 0
+	 || hexagon_nn_op_name_to_id("Tanh_f",&ops.tanh) != 0) {
+		printf("can't look up ops\n");
+		return 1;
+	}
+	rpcmem_init();
+	for (i = 0; i < n_shapes; i++) {
+		if (check_shape(&ops,&shapes[i],iters,debug_level) != 0) n_failed++;
+	}
+	rpcmem_deinit();
+	if (n_failed) printf("%d of %d shapes FAILED\n",n_failed,n_shapes);
+	return n_failed ? 1 : 0;
+}
@@ -45,7 +45,9 @@
 #include <math.h>
 #include <stdint.h>
 #include "graph_app.h"
+#include "hexnn_capture.h"
 #include <assert.h>
+#include <time.h>
 
 //#define RUN_UNIT_TEST_OP
 
@@ -144,6 +146,8 @@ struct basicperf {
 	unsigned int executions;
 	double total_msecs;
 	unsigned long long int total_pcycles;
+	float last_msecs;
+	unsigned long long int last_pcycles;
 };
 
 
@@ -188,6 +192,8 @@ static int run(uint32_t id, void *input, int elementsize, int width, int height,
 	basicperf->executions++;
 	basicperf->total_msecs += msecs;
 	basicperf->total_pcycles += pcycles;
+	basicperf->last_msecs = msecs;
+	basicperf->last_pcycles = pcycles;
 #ifdef __hexagon__
 	if (options->node_perf && !ret) print_node_perf(id);
 #endif
@@ -254,7 +260,7 @@ float *uint8_to_float(uint8_t *data, size_t length, float zero, float max) {
 	return float_data;
 }
 
-static int load_and_run(uint32_t id, const char *filename, struct options *options, struct options *assumed, struct basicperf *basicperf, unsigned long long int *appreported)
+static int load_and_run(uint32_t id, const char *filename, struct options *options, struct options *assumed, struct basicperf *basicperf, unsigned long long int *appreported, struct bench_stats *stats)
 {
 	FILE *f;
 	int elementsize = options->elementsize;
@@ -327,11 +333,24 @@ static int load_and_run(uint32_t id, const char *filename, struct options *optio
 		elementsize = sizeof(float);
 	}
 
+	/* warmup runs are left out of basicperf / appreported */
+	for (i = 0; i < options->warmup; i++) {
+		struct basicperf warmperf;
+		memset(&warmperf,0,sizeof(warmperf));
+		if ((ret = run(id,data,elementsize,width,height,options,&warmperf,output,0)) != 0) {
+			printf("run failed: %d\n",ret);
+			return ret;
+		}
+		if (stats) bench_stats_add(stats,(stats->n == 0) ? BENCH_COLD : BENCH_WARMUP,
+			warmperf.last_msecs,warmperf.last_pcycles);
+	}
 	for (i = 0; i < iters; i++) {
 		if ((ret = run(id,data,elementsize,width,height,options,basicperf,output,(i==iters-1))) != 0) {
 			printf("run failed: %d\n",ret);
 			break;
 		}
+		if (stats) bench_stats_add(stats,(stats->n == 0) ? BENCH_COLD : BENCH_STEADY,
+			basicperf->last_msecs,basicperf->last_pcycles);
 		*appreported = basicperf->total_pcycles - lastreport; // only care about last ones
 		if (i < iters - report_iters) {
 			// Stop chopping last report_iters number of iterations from appreported
@@ -346,6 +365,131 @@ static int load_and_run(uint32_t id, const char *filename, struct options *optio
 	return ret;
 }
 
+static double replay_now_usecs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return ts.tv_sec * 1.0e6 + ts.tv_nsec * 1.0e-3;
+}
+
+/*
+ * Stream a capture (see hexagon/host/hexnn_capture.h) through hexagon_nn_execute_new
+ * on graph 'id', either as fast as possible or at the recorded rate, and report
+ * throughput plus per-request latency statistics.
+ * Graph options in the capture are applied as they are reached; the graph ids
+ * recorded in the capture are ignored.
+ */
+static int graph_replay(uint32_t id, const struct options *options)
+{
+	struct hexnn_capture_record rec;
+	struct bench_stats stats;
+	hexagon_nn_tensordef inputs[HEXNN_CAPTURE_MAX_TENSORS];
+	hexagon_nn_tensordef outputs[HEXNN_CAPTURE_MAX_TENSORS];
+	unsigned char *bufs[2*HEXNN_CAPTURE_MAX_TENSORS];
+	int buflens[2*HEXNN_CAPTURE_MAX_TENSORS];
+	unsigned int n_requests = 0;
+	unsigned int n_failed = 0;
+	uint64_t first_t = 0;
+	double start, t0, t1;
+	int ret;
+	int i;
+	FILE *f;
+
+	if ((f = hexnn_capture_reader_open(options->replay)) == NULL) {
+		printf("can't read capture %s\n",options->replay);
+		return -1;
+	}
+	memset(&rec,0,sizeof(rec));
+	memset(bufs,0,sizeof(bufs));
+	memset(buflens,0,sizeof(buflens));
+	while ((ret = hexnn_capture_read(f,&rec)) > 0) {
+		if (rec.type == HEXNN_CAPTURE_EXECUTE) n_requests++;
+	}
+	if (ret < 0 || bench_stats_init(&stats,n_requests) != 0) {
+		printf("bad capture %s\n",options->replay);
+		fclose(f);
+		hexnn_capture_record_free(&rec);
+		return -1;
+	}
+	fclose(f);
+	if ((f = hexnn_capture_reader_open(options->replay)) == NULL) {
+		bench_stats_free(&stats);
+		hexnn_capture_record_free(&rec);
+		return -1;
+	}
+	printf("replaying %u requests from %s%s\n",n_requests,options->replay,
+		options->replay_rate ? " at the recorded rate" : "");
+
+	n_requests = 0;
+	start = replay_now_usecs();
+	while ((ret = hexnn_capture_read(f,&rec)) > 0) {
+		if (rec.type == HEXNN_CAPTURE_OPTION) {
+			hexagon_nn_set_graph_option(id,rec.option_name,rec.option_value);
+			continue;
+		}
+		if (rec.type != HEXNN_CAPTURE_EXECUTE) continue;
+		if (n_requests == 0) first_t = rec.t_usec;
+		if (options->replay_rate) {
+			double due = start + (double)(rec.t_usec - first_t);
+			double wait = due - replay_now_usecs();
+			if (wait > 0) {
+				struct timespec ts;
+				ts.tv_sec = (time_t)(wait / 1.0e6);
+				ts.tv_nsec = (long)((wait - ts.tv_sec * 1.0e6) * 1.0e3);
+				nanosleep(&ts,NULL);
+			}
+		}
+		/* Inputs and outputs in rpcmem buffers, reused (and grown) across requests */
+		for (i = 0; i < rec.n_inputs + rec.n_outputs; i++) {
+			int is_in = (i < rec.n_inputs);
+			int len = is_in ? rec.inputs[i].dataLen : rec.outputs[i-rec.n_inputs].dataLen;
+			if (len > buflens[i]) {
+				if (bufs[i]) rpcmem_free(bufs[i]);
+				if ((bufs[i] = rpcmem_alloc(ION_HEAP_ID_SYSTEM, RPCMEM_DEFAULT_FLAGS, len)) == NULL) {
+					printf("malloc failed\n");
+					buflens[i] = 0;
+					ret = -1;
+					goto done;
+				}
+				buflens[i] = len;
+			}
+			if (is_in) {
+				inputs[i] = rec.inputs[i];
+				memcpy(bufs[i],rec.inputs[i].data,len);
+				inputs[i].data = bufs[i];
+			} else {
+				outputs[i-rec.n_inputs] = rec.outputs[i-rec.n_inputs];
+				outputs[i-rec.n_inputs].data = bufs[i];
+			}
+		}
+		t0 = replay_now_usecs();
+		ret = hexagon_nn_execute_new(id,inputs,rec.n_inputs,outputs,rec.n_outputs);
+		t1 = replay_now_usecs();
+		if (ret != 0) {
+			n_failed++;
+		} else {
+			unsigned int cycleslo, cycleshi;
+			hexagon_nn_last_execution_cycles(id,&cycleslo,&cycleshi);
+			bench_stats_add(&stats,(n_requests == 0) ? BENCH_COLD : BENCH_STEADY,
+				(t1-t0)/1000.0,((unsigned long long)cycleshi << 32) | cycleslo);
+		}
+		n_requests++;
+	}
+	t1 = replay_now_usecs();
+	printf("replayed %u requests (%u failed) in %.3f secs: %.2f requests/sec\n",
+		n_requests,n_failed,(t1-start)/1.0e6,n_requests/((t1-start)/1.0e6));
+	bench_stats_report(&stats,options->stats_csv,options->stats_json);
+	if (ret == 0 && n_failed) ret = -1;
+  done:
+	for (i = 0; i < 2*HEXNN_CAPTURE_MAX_TENSORS; i++) {
+		if (bufs[i]) rpcmem_free(bufs[i]);
+	}
+	bench_stats_free(&stats);
+	hexnn_capture_record_free(&rec);
+	fclose(f);
+	return ret;
+}
+
 int main(int argc, const char **argv)
 {
 #ifdef __hexagon__
@@ -382,6 +526,8 @@ int main(int argc, const char **argv)
 	struct options assumed;
 	struct basicperf basicperf;
 	unsigned long long int appreported = 0;
+	struct bench_stats stats;
+	struct bench_stats *statsp = NULL;
 
 	memset(&basicperf,0,sizeof(basicperf));
 	option_init(&options);
@@ -421,6 +567,17 @@ int main(int argc, const char **argv)
 		}
 	}
 
+	if (options.pin_cpu >= 0) bench_pin_cpu(options.pin_cpu);
+	if (options.stats) {
+		int n_inputs = 0;
+		for (i = 1; i < argc; i++) {
+			if (is_option_flag(argv[i])) i++;
+			else n_inputs++;
+		}
+		if (bench_stats_init(&stats,n_inputs*(options.warmup+options.iters)) != 0) return -1;
+		statsp = &stats;
+	}
+
 	/* Set up environment */
 	fastrpc_setup(options.MCPS, options.MBPS, options.DCVS_DISABLE);
 	hexagon_nn_config();
@@ -438,6 +595,23 @@ int main(int argc, const char **argv)
 		}
 	}
 
+	if (options.trace) {
+		hexagon_nn_set_graph_option(graph_id,"trace_events",options.trace_events);
+	}
+	if (options.autotune) {
+		hexagon_nn_set_graph_option(graph_id,"autotune",options.autotune);
+	}
+	if (options.tuning_db) {
+		if (graph_tuning_db_load(graph_id,options.tuning_db) != 0) return -1;
+	}
+
+	if (options.replay) {
+		int ret = graph_replay(graph_id,&options);
+		graph_teardown(graph_id);
+		fastrpc_teardown();
+		return ret;
+	}
+
 	for (i = 1; i < argc; ) {
 		/* Skip flags */
 		if (is_option_flag(argv[i])) {
@@ -446,12 +620,24 @@ int main(int argc, const char **argv)
 		}
 		/* Process each test */
 		printf("Using <%s>\n",argv[i]);
-		if (load_and_run(graph_id,argv[i],&options,&assumed,&basicperf, &appreported) != 0) {
+		if (load_and_run(graph_id,argv[i],&options,&assumed,&basicperf, &appreported, statsp) != 0) {
 			return -1;
 		}
 		i++;
 	}
 
+	if (statsp) {
+		bench_stats_report(statsp,options.stats_csv,options.stats_json);
+		bench_stats_free(statsp);
+	}
+
+	if (options.trace) {
+		graph_trace_dump(graph_id,options.trace,options.trace_events,options.trace_mhz);
+	}
+	if (options.tuning_db) {
+		graph_tuning_db_save(graph_id,options.tuning_db);
+	}
+
 	/* Free memory allocated to labels, if specified */
 	if (options.labels_filename) free_labels();
 	if (!options.benchmark) {
@@ -493,7 +679,7 @@ int main(int argc, const char **argv)
 		printf("%f msecs for %d iterations (%f / iter)\n",
 			basicperf.total_msecs,basicperf.executions,
 			basicperf.total_msecs/basicperf.executions);
-		graph_perfdump(graph_id);
+		graph_perfdump(graph_id,options.peak_macs,options.peak_bytes);
 	}
 
 	if (options.pmu) {
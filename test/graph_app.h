@@ -57,7 +57,30 @@ void info_for_debug(unsigned int id, const char *name, const char *opname);
 const char *info_id2name(unsigned int id);
 const char *info_id2opname(unsigned int id);
 uint32_t graph_setup(int debug_level);
-void graph_perfdump(uint32_t nn_id);
+void graph_perfdump(uint32_t nn_id, float peak_macs, float peak_bytes);
+enum bench_phase {
+	BENCH_COLD,		// first execution of the graph
+	BENCH_WARMUP,		// --warmup runs
+	BENCH_STEADY,
+};
+struct bench_sample {
+	int phase;
+	float msecs;
+	unsigned long long int pcycles;
+};
+struct bench_stats {
+	unsigned int n;
+	unsigned int max_n;
+	struct bench_sample *samples;
+};
+int bench_stats_init(struct bench_stats *s, unsigned int max_n);
+void bench_stats_add(struct bench_stats *s, int phase, float msecs, unsigned long long int pcycles);
+void bench_stats_report(const struct bench_stats *s, const char *csv_filename, const char *json_filename);
+void bench_stats_free(struct bench_stats *s);
+int bench_pin_cpu(int cpu);
+int graph_trace_dump(uint32_t nn_id, const char *filename, int events_per_thread, float mhz);
+int graph_tuning_db_load(uint32_t nn_id, const char *filename);
+int graph_tuning_db_save(uint32_t nn_id, const char *filename);
 void graph_teardown(uint32_t nn_id);
 int graph_get_all_perf(
 	uint32_t id,
@@ -36,6 +36,10 @@
 /*
  */
 #define DONT_REDEF_ALLOC 1
+#if defined(__linux__) && !defined(__hexagon__)
+#define _GNU_SOURCE	// for sched_setaffinity
+#include <sched.h>
+#endif
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -46,6 +50,7 @@
 #include <nn_graph.h>
 #endif // DEBUG_TEST_NEW_EXECUTE
 #include <time.h>
+#include <math.h>
 #include "graph_app.h"
 
 #define OUTPUT_ELEMENTS 1024
@@ -185,7 +190,8 @@ int graph_execute(
 	int err;
 	uint32_t output_size = *output_size_ptr;
 	int benchmark = options->benchmark;
-	if (!benchmark) clock_gettime(CLOCK_REALTIME,&start);
+	int timed = !benchmark || options->stats;
+	if (timed) clock_gettime(CLOCK_REALTIME,&start);
 	if ((err = hexagon_nn_execute(id,
 		1,
 		height,
@@ -205,10 +211,10 @@ int graph_execute(
 		print_log(id);
 		return err;
 	} else {
-		if (!benchmark) clock_gettime(CLOCK_REALTIME,&end);
+		if (timed) clock_gettime(CLOCK_REALTIME,&end);
 	}
-	if (!benchmark) {
-		print_log(id);
+	if (timed) {
+		if (!benchmark) print_log(id);
 		secs = end.tv_sec - start.tv_sec;
 		if (end.tv_nsec < start.tv_nsec) {
 			secs -= 1;
@@ -386,8 +392,98 @@ int cycle_sorter(const void *va, const void *vb)
 	return 0;
 }
 
+static inline unsigned long long int u64_from_parts(unsigned int lo, unsigned int hi)
+{
+	return ((unsigned long long int)hi << 32) | lo;
+}
+
+static int traffic_id_sorter(const void *va, const void *vb)
+{
+	const hexagon_nn_perfinfo_traffic *a = va;
+	const hexagon_nn_perfinfo_traffic *b = vb;
+	if (a->node_id < b->node_id) return -1;
+	if (a->node_id > b->node_id) return 1;
+	return 0;
+}
+
+/*
+ * Roofline summary: per node, the estimated bytes and MACs per execution
+ * (from hexagon_nn_get_perfinfo_traffic), against the cycles per execution.
+ * A node whose MACs/byte is below peak_macs/peak_bytes (the ridge point) is
+ * bandwidth-bound; 'eff' is the achieved fraction of what the roofline allows.
+ * info[] must hold cycle counts.
+ */
+static void graph_perfdump_roofline(uint32_t id, const hexagon_nn_perfinfo *info, unsigned int n_nodes,
+	float peak_macs, float peak_bytes)
+{
+	hexagon_nn_perfinfo_traffic *traffic;
+	hexagon_nn_perfinfo_traffic key;
+	unsigned int n_traffic;
+	unsigned long long int tot_bytes = 0, tot_macs = 0;
+	double tot_cycles = 0.0;
+	double ridge = peak_macs / peak_bytes;
+	int i;
+
+	if ((traffic = malloc(MAX_NODES*sizeof(*traffic))) == NULL) {
+		printf("malloc fail\n");
+		return;
+	}
+	if (hexagon_nn_get_perfinfo_traffic(id,traffic,MAX_NODES,&n_traffic) != 0) {
+		printf("perf traffic info failure\n");
+		free(traffic);
+		return;
+	}
+	qsort(traffic,n_traffic,sizeof(traffic[0]),traffic_id_sorter);
+	printf("Roofline (peak %.1f MACs/cycle, %.1f bytes/cycle, ridge %.1f MACs/byte):\n",
+		peak_macs,peak_bytes,ridge);
+	for (i = 0; i < n_nodes; i++) {
+		const hexagon_nn_perfinfo_traffic *t;
+		unsigned long long int bytes, macs;
+		double cycles, intensity, attainable, achieved;
+		if (info[i].executions == 0) continue;
+		key.node_id = info[i].node_id;
+		t = bsearch(&key,traffic,n_traffic,sizeof(traffic[0]),traffic_id_sorter);
+		if (t == NULL) continue;
+		bytes = u64_from_parts(t->bytes_read_lo,t->bytes_read_hi)
+		      + u64_from_parts(t->bytes_written_lo,t->bytes_written_hi);
+		macs = u64_from_parts(t->macs_lo,t->macs_hi);
+		cycles = (double)get_counter(info[i]) / info[i].executions;
+		tot_bytes += bytes;
+		tot_macs += macs;
+		tot_cycles += cycles;
+		if (cycles <= 0.0) continue;
+		if (macs != 0 && bytes != 0) {
+			intensity = (double)macs / bytes;
+			attainable = (intensity < ridge) ? intensity * peak_bytes : peak_macs;
+			achieved = macs / cycles;
+		} else {
+			intensity = 0.0;
+			attainable = peak_bytes;
+			achieved = bytes / cycles;
+		}
+		printf("roofline,0x%x,%s,%s,bytes,%llu,macs,%llu,cycles,%.0f,bytes/cycle,%.2f,macs/cycle,%.2f,macs/byte,%.2f,%s,eff,%.1f %%\n",
+			(int)info[i].node_id,
+			info_id2name(info[i].node_id),
+			info_id2opname(info[i].node_id),
+			bytes,
+			macs,
+			cycles,
+			bytes/cycles,
+			macs/cycles,
+			intensity,
+			(intensity < ridge) ? "mem" : "mac",
+			100.0*achieved/attainable);
+	}
+	if (tot_cycles > 0.0) {
+		printf("Total per execution: %llu bytes, %llu MACs, %.0f cycles, %.2f bytes/cycle, %.2f MACs/cycle\n",
+			tot_bytes,tot_macs,tot_cycles,
+			tot_bytes/tot_cycles,tot_macs/tot_cycles);
+	}
+	free(traffic);
+}
+
 //void graph_perfdump(uint32_t id, const char *(*id2name)(uint32_t node_id))
-void graph_perfdump(uint32_t id)
+void graph_perfdump(uint32_t id, float peak_macs, float peak_bytes)
 {
 	hexagon_nn_perfinfo info[MAX_NODES];
 	unsigned long long int total_cycles = 0;
@@ -419,9 +515,337 @@ void graph_perfdump(uint32_t id)
 			cum_cycles,
 			100*((double)cum_cycles)/total_cycles);
 	}
+	if (peak_macs > 0.0f && peak_bytes > 0.0f) {
+		graph_perfdump_roofline(id,info,n_nodes,peak_macs,peak_bytes);
+	}
 	//graph_get_all_perf(id);
 }
 
+/*
+ * Benchmark statistics (--stats): every execution is recorded with its phase;
+ * the summary covers the steady-state runs, with the cold (first) run shown
+ * separately. Percentiles are nearest-rank.
+ */
+int bench_stats_init(struct bench_stats *s, unsigned int max_n)
+{
+	s->n = 0;
+	s->max_n = max_n;
+	if ((s->samples = malloc(max_n * sizeof(s->samples[0]))) == NULL) {
+		printf("malloc fail\n");
+		return -1;
+	}
+	return 0;
+}
+
+void bench_stats_free(struct bench_stats *s)
+{
+	free(s->samples);
+	s->samples = NULL;
+	s->n = s->max_n = 0;
+}
+
+void bench_stats_add(struct bench_stats *s, int phase, float msecs, unsigned long long int pcycles)
+{
+	if (s->n >= s->max_n) return;
+	s->samples[s->n].phase = phase;
+	s->samples[s->n].msecs = msecs;
+	s->samples[s->n].pcycles = pcycles;
+	s->n++;
+}
+
+struct bench_summary {
+	unsigned int n;
+	double min, median, p90, p99, max, mean, stddev;
+};
+
+static int double_sorter(const void *va, const void *vb)
+{
+	double a = *(const double *)va;
+	double b = *(const double *)vb;
+	if (a < b) return -1;
+	if (a > b) return 1;
+	return 0;
+}
+
+static double percentile(const double *sorted, unsigned int n, double p)
+{
+	unsigned int idx = (unsigned int)ceil(p/100.0*n);
+	if (idx > 0) idx--;
+	if (idx >= n) idx = n-1;
+	return sorted[idx];
+}
+
+// values: n entries, sorted in place
+static void bench_summarize(double *values, unsigned int n, struct bench_summary *sum)
+{
+	double total = 0.0;
+	double sq = 0.0;
+	unsigned int i;
+	memset(sum,0,sizeof(*sum));
+	if ((sum->n = n) == 0) return;
+	qsort(values,n,sizeof(values[0]),double_sorter);
+	for (i = 0; i < n; i++) total += values[i];
+	sum->mean = total / n;
+	for (i = 0; i < n; i++) sq += (values[i]-sum->mean)*(values[i]-sum->mean);
+	sum->stddev = (n > 1) ? sqrt(sq / (n-1)) : 0.0;
+	sum->min = values[0];
+	sum->max = values[n-1];
+	sum->median = percentile(values,n,50.0);
+	sum->p90 = percentile(values,n,90.0);
+	sum->p99 = percentile(values,n,99.0);
+}
+
+static void bench_summary_print(const char *what, const struct bench_summary *sum)
+{
+	printf("%s: n=%u min=%.4f median=%.4f p90=%.4f p99=%.4f max=%.4f mean=%.4f stddev=%.4f\n",
+		what,sum->n,sum->min,sum->median,sum->p90,sum->p99,sum->max,sum->mean,sum->stddev);
+}
+
+static void bench_summary_json(FILE *f, const char *what, const struct bench_summary *sum)
+{
+	fprintf(f,"\"%s\":{\"min\":%.4f,\"median\":%.4f,\"p90\":%.4f,\"p99\":%.4f,\"max\":%.4f,\"mean\":%.4f,\"stddev\":%.4f}",
+		what,sum->min,sum->median,sum->p90,sum->p99,sum->max,sum->mean,sum->stddev);
+}
+
+void bench_stats_report(const struct bench_stats *s, const char *csv_filename, const char *json_filename)
+{
+	static const char *phase_names[] = { "cold", "warmup", "steady" };
+	struct bench_summary msecs_sum;
+	struct bench_summary pcycles_sum;
+	const struct bench_sample *cold = NULL;
+	double *values;
+	unsigned int n = 0;
+	unsigned int i;
+	FILE *f;
+
+	if ((values = malloc((s->n+1) * sizeof(values[0]))) == NULL) {
+		printf("malloc fail\n");
+		return;
+	}
+	for (i = 0; i < s->n; i++) {
+		if (s->samples[i].phase == BENCH_COLD && cold == NULL) cold = &s->samples[i];
+		if (s->samples[i].phase == BENCH_STEADY) values[n++] = s->samples[i].msecs;
+	}
+	bench_summarize(values,n,&msecs_sum);
+	for (i = 0, n = 0; i < s->n; i++) {
+		if (s->samples[i].phase == BENCH_STEADY) values[n++] = s->samples[i].pcycles;
+	}
+	bench_summarize(values,n,&pcycles_sum);
+	free(values);
+
+	if (cold) printf("cold run: msecs=%.4f pcycles=%llu\n",cold->msecs,cold->pcycles);
+	bench_summary_print("steady msecs",&msecs_sum);
+	bench_summary_print("steady pcycles",&pcycles_sum);
+
+	if (csv_filename) {
+		if ((f = fopen(csv_filename,"w")) == NULL) {
+			printf("can't open %s\n",csv_filename);
+		} else {
+			fprintf(f,"iter,phase,msecs,pcycles\n");
+			for (i = 0; i < s->n; i++) {
+				fprintf(f,"%u,%s,%.4f,%llu\n",i,phase_names[s->samples[i].phase],
+					s->samples[i].msecs,s->samples[i].pcycles);
+			}
+			fclose(f);
+		}
+	}
+	if (json_filename) {
+		if ((f = fopen(json_filename,"w")) == NULL) {
+			printf("can't open %s\n",json_filename);
+		} else {
+			fprintf(f,"{");
+			if (cold) fprintf(f,"\"cold\":{\"msecs\":%.4f,\"pcycles\":%llu},",cold->msecs,cold->pcycles);
+			fprintf(f,"\"steady\":{\"n\":%u,",msecs_sum.n);
+			bench_summary_json(f,"msecs",&msecs_sum);
+			fprintf(f,",");
+			bench_summary_json(f,"pcycles",&pcycles_sum);
+			fprintf(f,"}}\n");
+			fclose(f);
+		}
+	}
+}
+
+int bench_pin_cpu(int cpu)
+{
+#if defined(__linux__) && !defined(__hexagon__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu,&set);
+	if (sched_setaffinity(0,sizeof(set),&set) != 0) {
+		printf("can't pin to cpu %d\n",cpu);
+		return -1;
+	}
+	return 0;
+#else
+	printf("pin_cpu not supported here\n");
+	return -1;
+#endif
+}
+
+/*
+ * Fetch the execution trace and write it as Chrome trace JSON
+ * (load in chrome://tracing or ui.perfetto.dev).
+ * Thread 0 is the thread running execute; 1..N are the worker threads.
+ */
+#define TRACE_MAX_THREADS 8
+#define TRACE_EXEC_BEGIN 1	// enum nn_trace_kind in nn_graph_trace.h
+#define TRACE_NODE_BEGIN 3
+int graph_trace_dump(uint32_t id, const char *filename, int events_per_thread, float mhz)
+{
+	hexagon_nn_trace_event *events;
+	unsigned int ring_size = 16;
+	unsigned int n_events = 0;
+	unsigned int max_events;
+	unsigned int i;
+	unsigned int threads_seen = 0;
+	unsigned long long t0 = ~0ULL;
+	FILE *f;
+
+	while (ring_size < events_per_thread) ring_size *= 2;
+	max_events = ring_size * TRACE_MAX_THREADS;
+	if ((events = malloc(max_events * sizeof(*events))) == NULL) {
+		printf("malloc fail\n");
+		return -1;
+	}
+	if (hexagon_nn_get_trace(id,events,max_events,&n_events) != 0) {
+		printf("trace info failure\n");
+		free(events);
+		return -1;
+	}
+	if ((f = fopen(filename,"w")) == NULL) {
+		printf("can't open %s\n",filename);
+		free(events);
+		return -1;
+	}
+	for (i = 0; i < n_events; i++) {
+		unsigned long long ts = events[i].ts_lo | ((unsigned long long)events[i].ts_hi << 32);
+		if (ts < t0) t0 = ts;
+		if (events[i].thread < 32) threads_seen |= 1u << events[i].thread;
+	}
+	fprintf(f,"{\"traceEvents\":[\n");
+	for (i = 0; i < 32; i++) {
+		if ((threads_seen & (1u << i)) == 0) continue;
+		if (i == 0) fprintf(f,"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"main\"}},\n");
+		else fprintf(f,"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}},\n",i,i-1);
+	}
+	for (i = 0; i < n_events; i++) {
+		const hexagon_nn_trace_event *ev = &events[i];
+		unsigned long long ts = ev->ts_lo | ((unsigned long long)ev->ts_hi << 32);
+		int is_begin = (ev->kind & 1);
+		unsigned int kind = is_begin ? ev->kind : ev->kind - 1;
+		fprintf(f,"%s{\"ph\":\"%s\",\"pid\":0,\"tid\":%d,\"ts\":%.3f",
+			(i == 0) ? "" : ",\n", is_begin ? "B" : "E", (int)ev->thread, (ts - t0) / mhz);
+		if (!is_begin) {
+			fprintf(f,"}");
+		} else if (kind == TRACE_EXEC_BEGIN) {
+			fprintf(f,",\"name\":\"execute\",\"args\":{\"graph\":\"0x%x\"}}",(int)ev->id);
+		} else if (kind == TRACE_NODE_BEGIN) {
+			fprintf(f,",\"name\":\"%s\",\"args\":{\"node\":\"0x%x\",\"op\":\"%s\"}}",
+				info_id2name(ev->id),(int)ev->id,info_id2opname(ev->id));
+		} else {
+			fprintf(f,",\"name\":\"work\",\"args\":{\"fn\":\"0x%x\",\"node\":\"0x%x\"}}",
+				(int)ev->id,(int)ev->aux);
+		}
+	}
+	fprintf(f,"\n]}\n");
+	fclose(f);
+	printf("Wrote %d trace events to %s\n",n_events,filename);
+	free(events);
+	return 0;
+}
+
+/*
+ * The tuning db file is text: a header line, then one record per line,
+ * with the fields of hexagon_nn_tuning_record in order.
+ */
+#define TUNING_DB_MAX_RECORDS 4096
+#define TUNING_DB_HEADER "# kind batches height width depth filt_height filt_width out_depth stride_height stride_width padding inner_batches inner_rows inner_weight_chunks cycles"
+
+int graph_tuning_db_load(uint32_t id, const char *filename)
+{
+	hexagon_nn_tuning_record *recs;
+	unsigned int v[15];
+	unsigned int n = 0;
+	char line[512];
+	FILE *f;
+	int ret;
+
+	if ((f = fopen(filename,"r")) == NULL) {
+		printf("no tuning db %s yet\n",filename);
+		return 0;
+	}
+	if ((recs = malloc(TUNING_DB_MAX_RECORDS * sizeof(*recs))) == NULL) {
+		printf("malloc fail\n");
+		fclose(f);
+		return -1;
+	}
+	while ((n < TUNING_DB_MAX_RECORDS) && (fgets(line,sizeof(line),f) != NULL)) {
+		if (line[0] == '#') continue;
+		if (sscanf(line,"%x %u %u %u %u %u %u %u %u %u %u %u %u %u %u",
+			&v[0],&v[1],&v[2],&v[3],&v[4],&v[5],&v[6],&v[7],
+			&v[8],&v[9],&v[10],&v[11],&v[12],&v[13],&v[14]) != 15) continue;
+		recs[n].kind = v[0];
+		recs[n].batches = v[1];
+		recs[n].height = v[2];
+		recs[n].width = v[3];
+		recs[n].depth = v[4];
+		recs[n].filt_height = v[5];
+		recs[n].filt_width = v[6];
+		recs[n].out_depth = v[7];
+		recs[n].stride_height = v[8];
+		recs[n].stride_width = v[9];
+		recs[n].padding = v[10];
+		recs[n].inner_batches = v[11];
+		recs[n].inner_rows = v[12];
+		recs[n].inner_weight_chunks = v[13];
+		recs[n].cycles = v[14];
+		n++;
+	}
+	fclose(f);
+	ret = hexagon_nn_set_tuning_db(id,recs,n);
+	if (ret != 0) printf("set tuning db failed\n");
+	else printf("Loaded %d tuning records from %s\n",n,filename);
+	free(recs);
+	return ret;
+}
+
+int graph_tuning_db_save(uint32_t id, const char *filename)
+{
+	hexagon_nn_tuning_record *recs;
+	hexagon_nn_tuning_record *r;
+	unsigned int n = 0;
+	unsigned int i;
+	FILE *f;
+
+	if ((recs = malloc(TUNING_DB_MAX_RECORDS * sizeof(*recs))) == NULL) {
+		printf("malloc fail\n");
+		return -1;
+	}
+	if (hexagon_nn_get_tuning_db(id,recs,TUNING_DB_MAX_RECORDS,&n) != 0) {
+		printf("get tuning db failed\n");
+		free(recs);
+		return -1;
+	}
+	if ((f = fopen(filename,"w")) == NULL) {
+		printf("can't open %s\n",filename);
+		free(recs);
+		return -1;
+	}
+	fprintf(f,"%s\n",TUNING_DB_HEADER);
+	for (i = 0; i < n; i++) {
+		r = &recs[i];
+		fprintf(f,"%x %u %u %u %u %u %u %u %u %u %u %u %u %u %u\n",
+			(unsigned)r->kind,(unsigned)r->batches,(unsigned)r->height,(unsigned)r->width,(unsigned)r->depth,
+			(unsigned)r->filt_height,(unsigned)r->filt_width,(unsigned)r->out_depth,
+			(unsigned)r->stride_height,(unsigned)r->stride_width,(unsigned)r->padding,
+			(unsigned)r->inner_batches,(unsigned)r->inner_rows,(unsigned)r->inner_weight_chunks,(unsigned)r->cycles);
+	}
+	fclose(f);
+	printf("Wrote %d tuning records to %s\n",n,filename);
+	free(recs);
+	return 0;
+}
+
 #define PMU_EVENT_NAMES pmu_events_v66
 #include "pmu_v66.h"
 #undef PMU_EVENT_NAMES
@@ -20,6 +20,7 @@ test/graphinfo \
 test/options \
 test/imagenet_info \
 test/append_const_node_large_array \
+hexagon/host/hexnn_capture \
 $(COMPILE_GRAPHINIT) \
 
 graph_app_q_C_SRCS += $(TESTDATA:.c=)
@@ -28,7 +29,7 @@ graph_app_q_LIBS += $(QURT_INIT_LIBS) $(QURT_LINK_LIBS)
 graph_app_q_LIBS += apps_mem_heap_stub rpcmem test_util atomic libdspCV_skel libhexagon_nn_skel
 graph_app_q_LIBS += $(QURT_FINI_LIBS)
 
-CC_FLAGS += -Iinterface
+CC_FLAGS += -Iinterface -Ihexagon/host
 graph_app_q_DEFINES += VERIFY_PRINT_ERROR
 
 # defining ahb address is a temporary workaround for 8.1.04 tools, to be fixed in 8.1.05. See HEXSUPPORT 1854.
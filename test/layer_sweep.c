@@ -0,0 +1,586 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * layer_sweep: layer-by-layer accuracy and cost of a quantized graph against
+ * its float reference.
+ *
+ * Both graphs are linked in (the 'test' graph as init_graph(), the reference as
+ * init_graph_ref(); see the %.sweep.elf rule in hexagon/nonfastrpc.mak), prepared,
+ * and run on the same input. A node observer (nn_graph.node_observer) records
+ * output 0 of every node of the reference run, dequantized to float, by node id.
+ * During the test run each node whose id also exists in the reference (i.e. the
+ * node that still carries the original node id after prepare has fused or
+ * converted it) is compared with the same err_stats measures used by the Close
+ * nodes: mean/rms error and excess error in units of the test quantization step,
+ * and the position of the largest error.
+ *
+ * Cycles come from node->iter_cycles over --iters timed runs of the test graph.
+ * Nodes that don't match a reference node (converts, requantizes and other nodes
+ * added by prepare) are charged to the next matching node in the 'attr_cycles'
+ * column, so that each row shows what the layer costs as it was lowered.
+ * Comparing that against the error columns shows where a 16-bit layer
+ * (op_supernode_16b.c) would be worth its cost.
+ *
+ * This needs direct access to the graphs, so it only builds in non-RPC
+ * (simulator / linux) configurations.
+ */
+
+#include "hexagon_nn.h"
+#include "nn_graph.h"
+#include "nn_string_map.h"
+#include "errstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+void init_graph(int nn_id);
+void init_graph_ref(int nn_id);
+const char *info_id2name(unsigned int id);
+
+#define SWEEP_LOG_SIZE (1024*1024)
+
+// output 0 of a reference node, as plain float
+struct ref_tensor {
+	uint32_t node_id;
+	uint32_t dims[4];
+	float *data;
+};
+
+// one node of the test graph
+struct layer_stat {
+	uint32_t node_id;
+	uint32_t node_type;
+	int matched;			// 1: has a reference tensor; -1: shape mismatch; 0: none
+	int qbits;				// 8 or 16 for quantized outputs, 32 for float
+	uint64_t cycles;		// own cycles, summed over timed runs
+	uint64_t attr_cycles;	// own + preceding unmatched nodes
+	float out_min, out_max;
+	uint32_t dims[4];
+	struct err_stats es;
+};
+
+struct sweep_state {
+	int mode;				// SWEEP_REF, SWEEP_COMPARE, SWEEP_TIME
+	struct ref_tensor *refs;
+	int n_refs;
+	int max_refs;
+	struct layer_stat *layers;
+	int n_layers;
+	int max_layers;
+	int cursor;
+	uint64_t pending_cycles;
+};
+
+enum {
+	SWEEP_REF,
+	SWEEP_COMPARE,
+	SWEEP_TIME,
+};
+
+struct sweep_options {
+	const char *filename;
+	int width, height, depth;
+	int elementsize;
+	int test_elementsize;
+	int ref_elementsize;
+	int iters;
+	int all;
+	int debug;
+	const char *csv;
+};
+
+static void print_log(nn_id_t id)
+{
+	unsigned char *buf;
+	if ((buf = malloc(SWEEP_LOG_SIZE)) == NULL) return;
+	buf[0] = 0;
+	hexagon_nn_getlog(id,buf,SWEEP_LOG_SIZE);
+	buf[SWEEP_LOG_SIZE-1] = 0;
+	if (buf[0]) printf("%s",(char *)buf);
+	free(buf);
+}
+
+//
+// Find the quantization of output 0 of a node: element bits, and the
+// scale/offset such that q = (x - offset) * qscale (as in the Close nodes).
+// Returns 0 if the output is quantized with min/max in outputs 1,2; 1 if float; -1 otherwise.
+//
+static int node_output_quant(struct nn_node const *node, int *qbits, int *is_signed, float *qscale, float *offset)
+{
+	struct tensor const *t = node->outputs[0];
+	uint32_t elements = t->shape.batches * t->shape.height * t->shape.width * t->shape.depth;
+	int elsize;
+	float minval, maxval;
+
+	if (elements == 0 || t->data_size == 0) return -1;
+	if (tensor_is_d32(t)) {
+		elsize = (t->format.type == NN_TYPE_QINT16 || t->format.type == NN_TYPE_QUINT16) ? 2 : 1;
+	} else {
+		elsize = t->data_size / elements;
+	}
+	*is_signed = (t->format.type == NN_TYPE_QINT16);
+	if (elsize == 4 && !tensor_is_d32(t) && t->format.type != NN_TYPE_INT32) {
+		*qbits = 32;
+		return (node->n_outputs < 3) ? 1 : -1;
+	}
+	if (elsize != 1 && elsize != 2) return -1;
+	if (node->n_outputs < 3 || node->outputs[1]->data_size < 4 || node->outputs[2]->data_size < 4) return -1;
+	minval = tensor_get_float(node->outputs[1],0);
+	maxval = tensor_get_float(node->outputs[2],0);
+	if (!(maxval > minval)) return -1;
+	*qbits = elsize * 8;
+	if (elsize == 1) {
+		*qscale = 255.0f / (maxval - minval);
+		*offset = minval;
+	} else if (*is_signed) {
+		*qscale = 32768.0f / fmaxf(maxval,-minval);
+		*offset = 0.0f;
+	} else {
+		*qscale = 65536.0f / (maxval - minval);
+		*offset = minval;
+	}
+	return 0;
+}
+
+// read element i (in plain bhwd order) of output 0 as its raw quantized value
+static inline int32_t node_output_q(struct tensor const *t, int qbits, int is_signed, int b, int h, int w, int d)
+{
+	if (tensor_is_d32(t)) {
+		if (qbits == 8) return *tensor_location_d32(t,b,h,w,d);
+		if (is_signed) return *tensor_location_16b_d32(t,b,h,w,d);
+		return (uint16_t)*tensor_location_16b_d32(t,b,h,w,d);
+	} else {
+		int idx = ((b * t->shape.height + h) * t->shape.width + w) * t->shape.depth + d;
+		if (qbits == 8) return ((uint8_t const *)t->data)[idx];
+		if (is_signed) return ((int16_t const *)t->data)[idx];
+		return ((uint16_t const *)t->data)[idx];
+	}
+}
+
+static struct ref_tensor *find_ref(struct sweep_state *st, uint32_t node_id)
+{
+	int lo = 0, hi = st->n_refs;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (st->refs[mid].node_id < node_id) lo = mid + 1;
+		else hi = mid;
+	}
+	if (lo < st->n_refs && st->refs[lo].node_id == node_id) return &st->refs[lo];
+	return NULL;
+}
+
+static int cmp_ref(const void *va, const void *vb)
+{
+	const struct ref_tensor *a = va;
+	const struct ref_tensor *b = vb;
+	return (a->node_id > b->node_id) - (a->node_id < b->node_id);
+}
+
+static void observe_ref(struct nn_graph *nn, struct nn_node *node, struct sweep_state *st)
+{
+	struct tensor const *t;
+	struct ref_tensor *r;
+	int qbits, is_signed, kind;
+	float qscale = 1.0f, offset = 0.0f;
+	int b, h, w, d, i;
+
+	if (node->n_outputs < 1 || node->outputs[0] == NULL) return;
+	t = node->outputs[0];
+	if ((kind = node_output_quant(node,&qbits,&is_signed,&qscale,&offset)) < 0) return;
+	if (st->n_refs == st->max_refs) {
+		int newmax = st->max_refs ? 2 * st->max_refs : 256;
+		struct ref_tensor *newrefs = realloc(st->refs,newmax * sizeof(*newrefs));
+		if (newrefs == NULL) return;
+		st->refs = newrefs;
+		st->max_refs = newmax;
+	}
+	r = &st->refs[st->n_refs];
+	for (i = 0; i < 4; i++) r->dims[i] = t->shape.dimension[i];
+	if ((r->data = malloc(sizeof(float) * r->dims[0] * r->dims[1] * r->dims[2] * r->dims[3])) == NULL) return;
+	r->node_id = node->node_id;
+	i = 0;
+	for (b = 0; b < r->dims[0]; b++)
+		for (h = 0; h < r->dims[1]; h++)
+			for (w = 0; w < r->dims[2]; w++)
+				for (d = 0; d < r->dims[3]; d++, i++) {
+					if (kind == 1) r->data[i] = ((float const *)t->data)[i];
+					else r->data[i] = node_output_q(t,qbits,is_signed,b,h,w,d) / qscale + offset;
+				}
+	st->n_refs++;
+}
+
+static struct layer_stat *find_layer(struct sweep_state *st, struct nn_node *node)
+{
+	struct layer_stat *ls;
+	int i;
+	// nodes execute in the same order every run, so this is normally the next one
+	if (st->cursor < st->n_layers && st->layers[st->cursor].node_id == node->node_id) {
+		return &st->layers[st->cursor++];
+	}
+	for (i = 0; i < st->n_layers; i++) {
+		if (st->layers[i].node_id == node->node_id) {
+			st->cursor = i + 1;
+			return &st->layers[i];
+		}
+	}
+	if (st->n_layers == st->max_layers) {
+		int newmax = st->max_layers ? 2 * st->max_layers : 256;
+		struct layer_stat *newlayers = realloc(st->layers,newmax * sizeof(*newlayers));
+		if (newlayers == NULL) return NULL;
+		st->layers = newlayers;
+		st->max_layers = newmax;
+	}
+	ls = &st->layers[st->n_layers++];
+	memset(ls,0,sizeof(*ls));
+	ls->node_id = node->node_id;
+	ls->node_type = node->node_type;
+	errstats_clear(&ls->es);
+	st->cursor = st->n_layers;
+	return ls;
+}
+
+static void compare_layer(struct nn_node *node, struct layer_stat *ls, struct ref_tensor const *r)
+{
+	struct tensor const *t = node->outputs[0];
+	struct err_stats errstatA, errstatB;
+	int qbits, is_signed, kind;
+	float qscale = 1.0f, offset = 0.0f;
+	int b, h, w, d, i;
+
+	for (i = 0; i < 4; i++) ls->dims[i] = t->shape.dimension[i];
+	for (i = 0; i < 4; i++) {
+		if (t->shape.dimension[i] != r->dims[i]) {
+			ls->matched = -1;
+			return;
+		}
+	}
+	if ((kind = node_output_quant(node,&qbits,&is_signed,&qscale,&offset)) < 0) {
+		ls->matched = -1;
+		return;
+	}
+	if (kind == 1) {
+		// float output: measure in steps of an 8-bit quantization of the reference range
+		float rmin = 0.0f, rmax = 1e-6f;
+		uint32_t n = r->dims[0] * r->dims[1] * r->dims[2] * r->dims[3];
+		for (i = 0; i < n; i++) {
+			rmin = fminf(rmin,r->data[i]);
+			rmax = fmaxf(rmax,r->data[i]);
+		}
+		qscale = 255.0f / (rmax - rmin);
+		offset = rmin;
+		ls->out_min = rmin;
+		ls->out_max = rmax;
+	} else {
+		ls->out_min = tensor_get_float(node->outputs[1],0);
+		ls->out_max = tensor_get_float(node->outputs[2],0);
+	}
+	ls->qbits = qbits;
+	ls->matched = 1;
+	// two levels to reduce precision loss in the accumulation, as in the Close nodes
+	errstats_clear(&errstatA);
+	errstats_clear(&errstatB);
+	errstats_clear(&ls->es);
+	i = 0;
+	for (b = 0; b < r->dims[0]; b++)
+		for (h = 0; h < r->dims[1]; h++)
+			for (w = 0; w < r->dims[2]; w++)
+				for (d = 0; d < r->dims[3]; d++, i++) {
+					float refdata = (r->data[i] - offset) * qscale;
+					int32_t tdata;
+					int is_clip;
+					if (kind == 1) {
+						float x = (((float const *)t->data)[i] - offset) * qscale;
+						tdata = (int32_t)roundf(x);
+						is_clip = 0;
+					} else {
+						tdata = node_output_q(t,qbits,is_signed,b,h,w,d);
+						if (qbits == 8) is_clip = tdata == 0 || tdata == 255;
+						else if (is_signed) is_clip = tdata == -32768 || tdata == 32767;
+						else is_clip = tdata == 0 || tdata == 65535;
+					}
+					errstats_add_point(&errstatA,tdata,refdata,i,is_clip);
+					if (errstatA.ncount >= 100) {
+						errstats_dump_and_clear(&errstatB,&errstatA);
+						if (errstatB.ncount >= 10000) errstats_dump_and_clear(&ls->es,&errstatB);
+					}
+				}
+	errstats_dump_and_clear(&errstatB,&errstatA);
+	errstats_dump_and_clear(&ls->es,&errstatB);
+}
+
+static void sweep_observer(struct nn_graph *nn, struct nn_node *node, void *opaque)
+{
+	struct sweep_state *st = opaque;
+	struct layer_stat *ls;
+	struct ref_tensor *r;
+
+	if (st->mode == SWEEP_REF) {
+		observe_ref(nn,node,st);
+		return;
+	}
+	if ((ls = find_layer(st,node)) == NULL) return;
+	r = find_ref(st,node->node_id);
+	if (st->mode == SWEEP_COMPARE) {
+		if (r != NULL && node->n_outputs >= 1) compare_layer(node,ls,r);
+		return;
+	}
+	ls->cycles += node->iter_cycles;
+	st->pending_cycles += node->iter_cycles;
+	if (r != NULL) {
+		ls->attr_cycles += st->pending_cycles;
+		st->pending_cycles = 0;
+	}
+}
+
+static void *convert_input(const void *data, int n, int from_size, int to_size)
+{
+	void *out;
+	int i;
+	if ((out = malloc(n * to_size)) == NULL) return NULL;
+	if (from_size == to_size) {
+		memcpy(out,data,n * to_size);
+	} else if (from_size == 1) {
+		for (i = 0; i < n; i++) ((float *)out)[i] = ((const uint8_t *)data)[i];
+	} else {
+		for (i = 0; i < n; i++) {
+			float x = ((const float *)data)[i];
+			((uint8_t *)out)[i] = (x <= 0.0f) ? 0 : (x >= 255.0f) ? 255 : (uint8_t)(x + 0.5f);
+		}
+	}
+	return out;
+}
+
+static nn_id_t setup_graph(void (*init)(int), const char *what, int debug)
+{
+	hexagon_nn_nn_id id;
+	if (hexagon_nn_init(&id) != 0) {
+		printf("can't init %s graph\n",what);
+		return 0;
+	}
+	hexagon_nn_set_debug_level(id,debug);
+	(*init)(id);
+	if (hexagon_nn_prepare(id) != 0) {
+		printf("prepare of %s graph failed\n",what);
+		print_log(id);
+		hexagon_nn_teardown(id);
+		return 0;
+	}
+	return id;
+}
+
+static int run_graph(nn_id_t id, const struct sweep_options *opt, const void *input, int elementsize, uint8_t *output, uint32_t output_max)
+{
+	uint32_t ob, oh, ow, od, osize;
+	if (hexagon_nn_execute(id,1,opt->height,opt->width,opt->depth,
+			input,opt->height * opt->width * opt->depth * elementsize,
+			&ob,&oh,&ow,&od,output,output_max,&osize) != 0) {
+		printf("execute failed\n");
+		print_log(id);
+		return -1;
+	}
+	return 0;
+}
+
+static void report(struct sweep_state *st, const struct sweep_options *opt)
+{
+	uint64_t total = 0;
+	FILE *csv = NULL;
+	int i;
+
+	for (i = 0; i < st->n_layers; i++) total += st->layers[i].cycles;
+	if (total == 0) total = 1;
+	if (opt->csv && (csv = fopen(opt->csv,"w")) == NULL) printf("can't open %s\n",opt->csv);
+	if (csv) fprintf(csv,"node_id,name,op,bits,batches,height,width,depth,cycles,attr_cycles,points,mean_err,rms_err,max_excess_err,excess_frac,largest_err_pos\n");
+	printf("%-10s %-32s %-28s %4s %12s %12s %6s %8s %8s %8s %7s %s\n",
+		"node","name","op","bits","cycles","attr_cycles","%","mean","rms","max_exc","exc%","largest err at");
+	for (i = 0; i < st->n_layers; i++) {
+		struct layer_stat const *ls = &st->layers[i];
+		char const *opname = op_type_to_string_alt(ls->node_type,"?");
+		uint64_t cyc = ls->cycles / opt->iters;
+		uint64_t attr = ls->attr_cycles / opt->iters;
+		if (ls->matched == 0 && !opt->all) continue;
+		printf("%-10x %-32.32s %-28.28s",(unsigned)ls->node_id,info_id2name(ls->node_id),opname);
+		if (ls->matched > 0 && ls->es.ncount > 0) {
+			float mean, rms;
+			char pos[48] = "-";
+			errstats_find_mean_rms(&ls->es,&mean,&rms);
+			if (ls->es.pos_largerr >= 0) {
+				uint32_t p = ls->es.pos_largerr;
+				uint32_t dd = p % ls->dims[3]; p /= ls->dims[3];
+				uint32_t ww = p % ls->dims[2]; p /= ls->dims[2];
+				uint32_t hh = p % ls->dims[1]; p /= ls->dims[1];
+				snprintf(pos,sizeof(pos),"[%u,%u,%u,%u]",(unsigned)p,(unsigned)hh,(unsigned)ww,(unsigned)dd);
+			}
+			printf(" %4d %12llu %12llu %5.1f%% %8.3f %8.3f %8.3f %6.2f%% %s\n",
+				ls->qbits,(unsigned long long)cyc,(unsigned long long)attr,100.0 * ls->cycles / total,
+				mean,rms,ls->es.max_excerr,100.0 * ls->es.ncount_excerr / ls->es.ncount,pos);
+			if (csv) {
+				fprintf(csv,"0x%x,%s,%s,%d,%u,%u,%u,%u,%llu,%llu,%d,%.6f,%.6f,%.6f,%.6f,%d\n",
+					(unsigned)ls->node_id,info_id2name(ls->node_id),opname,ls->qbits,
+					ls->dims[0],ls->dims[1],ls->dims[2],ls->dims[3],
+					(unsigned long long)cyc,(unsigned long long)attr,ls->es.ncount,mean,rms,
+					ls->es.max_excerr,(double)ls->es.ncount_excerr / ls->es.ncount,ls->es.pos_largerr);
+			}
+		} else {
+			printf(" %4s %12llu %12llu %5.1f%% %8s %8s %8s %7s %s\n",
+				"-",(unsigned long long)cyc,(unsigned long long)attr,100.0 * ls->cycles / total,
+				"-","-","-","-",(ls->matched < 0) ? "(not comparable)" : "");
+		}
+	}
+	if (st->pending_cycles) {
+		printf("%-10s %-32s %-28s %4s %12s %12llu\n","-","(after last matched node)","","","",
+			(unsigned long long)(st->pending_cycles / opt->iters));
+	}
+	printf("total cycles/run: %llu\n",(unsigned long long)(total / opt->iters));
+	if (csv) fclose(csv);
+}
+
+static void usage(const char *prog)
+{
+	printf("usage: %s [options] input_file\n",prog);
+	printf("  --width N --height N --depth N   input shape\n");
+	printf("  --elementsize N                  element size of the input file (1: u8, 4: float)\n");
+	printf("  --test_elementsize N             input element size for the quantized graph (default: file)\n");
+	printf("  --ref_elementsize N              input element size for the reference graph (default: file)\n");
+	printf("  --iters N                        timed runs of the quantized graph (default 2)\n");
+	printf("  --all 1                          also list nodes with no reference\n");
+	printf("  --csv FILE                       write the table as csv\n");
+	printf("  --debug N                        graph debug level\n");
+}
+
+int main(int argc, char **argv)
+{
+	static struct sweep_state st;
+	struct sweep_options opt = { NULL, 299, 299, 3, 1, 0, 0, 2, 0, 0, NULL };
+	struct nn_graph *nn;
+	nn_id_t test_id, ref_id;
+	uint32_t output_max = 64 * 1024 * 1024;
+	uint8_t *output = NULL;
+	void *filedata = NULL;
+	void *test_in = NULL;
+	void *ref_in = NULL;
+	FILE *f;
+	int n_elements;
+	int i;
+	int ret = 1;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (strncmp(a,"--",2) != 0) {
+			opt.filename = a;
+			continue;
+		}
+		if (i + 1 >= argc) { usage(argv[0]); return 1; }
+		i++;
+		if (strcmp(a,"--width") == 0) opt.width = atoi(argv[i]);
+		else if (strcmp(a,"--height") == 0) opt.height = atoi(argv[i]);
+		else if (strcmp(a,"--depth") == 0) opt.depth = atoi(argv[i]);
+		else if (strcmp(a,"--elementsize") == 0) opt.elementsize = atoi(argv[i]);
+		else if (strcmp(a,"--test_elementsize") == 0) opt.test_elementsize = atoi(argv[i]);
+		else if (strcmp(a,"--ref_elementsize") == 0) opt.ref_elementsize = atoi(argv[i]);
+		else if (strcmp(a,"--iters") == 0) opt.iters = atoi(argv[i]);
+		else if (strcmp(a,"--all") == 0) opt.all = atoi(argv[i]);
+		else if (strcmp(a,"--csv") == 0) opt.csv = argv[i];
+		else if (strcmp(a,"--debug") == 0) opt.debug = atoi(argv[i]);
+		else { usage(argv[0]); return 1; }
+	}
+	if (opt.test_elementsize == 0) opt.test_elementsize = opt.elementsize;
+	if (opt.ref_elementsize == 0) opt.ref_elementsize = opt.elementsize;
+	if (opt.filename == NULL || opt.iters < 1
+	 || (opt.elementsize != 1 && opt.elementsize != 4)
+	 || (opt.test_elementsize != 1 && opt.test_elementsize != 4)
+	 || (opt.ref_elementsize != 1 && opt.ref_elementsize != 4)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	n_elements = opt.width * opt.height * opt.depth;
+	if ((filedata = malloc(n_elements * opt.elementsize)) == NULL) goto done;
+	if ((f = fopen(opt.filename,"rb")) == NULL) {
+		printf("can't open %s\n",opt.filename);
+		goto done;
+	}
+	if (fread(filedata,opt.elementsize,n_elements,f) != n_elements) {
+		printf("%s: short read\n",opt.filename);
+		fclose(f);
+		goto done;
+	}
+	fclose(f);
+	test_in = convert_input(filedata,n_elements,opt.elementsize,opt.test_elementsize);
+	ref_in = convert_input(filedata,n_elements,opt.elementsize,opt.ref_elementsize);
+	if ((output = malloc(output_max)) == NULL || test_in == NULL || ref_in == NULL) goto done;
+
+	// reference run: record all node outputs
+	if ((ref_id = setup_graph(init_graph_ref,"reference",opt.debug)) == 0) goto done;
+	nn = nn_id_to_graph(ref_id);
+	nn->node_observer = sweep_observer;
+	nn->node_observer_opaque = &st;
+	st.mode = SWEEP_REF;
+	i = run_graph(ref_id,&opt,ref_in,opt.ref_elementsize,output,output_max);
+	hexagon_nn_teardown(ref_id);
+	if (i != 0) goto done;
+	qsort(st.refs,st.n_refs,sizeof(*st.refs),cmp_ref);
+	printf("reference graph: %d node outputs recorded\n",st.n_refs);
+
+	// test run: compare, then time
+	if ((test_id = setup_graph(init_graph,"test",opt.debug)) == 0) goto done;
+	nn = nn_id_to_graph(test_id);
+	nn->node_observer = sweep_observer;
+	nn->node_observer_opaque = &st;
+	st.mode = SWEEP_COMPARE;
+	st.cursor = 0;
+	if (run_graph(test_id,&opt,test_in,opt.test_elementsize,output,output_max) != 0) goto done_test;
+	st.mode = SWEEP_TIME;
+	for (i = 0; i < opt.iters; i++) {
+		st.cursor = 0;
+		if (run_graph(test_id,&opt,test_in,opt.test_elementsize,output,output_max) != 0) goto done_test;
+	}
+	report(&st,&opt);
+	ret = 0;
+done_test:
+	hexagon_nn_teardown(test_id);
+done:
+	for (i = 0; i < st.n_refs; i++) free(st.refs[i].data);
+	free(st.refs);
+	free(st.layers);
+	free(output);
+	free(test_in);
+	free(ref_in);
+	free(filedata);
+	return ret;
+}
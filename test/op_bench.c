@@ -0,0 +1,819 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * op_bench: per-op microbenchmark.
+ *
+ * For one op (by name, looked up with hexagon_nn_op_name_to_id), build a minimal
+ * graph of
+ *
+ *	INPUT (dummy 1x1x1x1) ; const inputs ; the op ; OUTPUT (all op outputs)
+ *
+ * for each shape in a sweep, prepare it, run warm-up and timed iterations, and report
+ * ns/iter, bytes/iter, ops/iter and the position against a roofline. Results can
+ * also be written as JSON for tracking over time.
+ *
+ * Inputs and outputs are described with a small spec language, so any op can be
+ * driven from the command line; a table of recipes covers the common ones.
+ *
+ *   spec list:   spec;spec;...
+ *   spec:        TYPE            1x1x1x1 (outputs only; e.g. the min/max outputs)
+ *                TYPE=VAL        1x1x1x1 filled with VAL      e.g. f=-1.0, i32=K
+ *                TYPE:DIMS       random data                  e.g. u8:BxHxWxD
+ *                TYPE:DIMS=VAL   filled with VAL              e.g. i32:1x1x1xK=0
+ *                shape:DIMS      shape-only const (no data)   e.g. shape:1xSxSx1
+ *                box:DIMS[=VAL]  float boxes, 4 values each (lo,lo,hi,hi), within
+ *                                [0,VAL) (default 1), sides up to VAL/10; e.g. box:1x1xWx4
+ *   TYPE:        u8 | i32 | f
+ *   VAL:         a number, or one of the shape symbols below
+ *   DIMS:        four terms separated by 'x'. A term is a number or one of
+ *                B,H,W,D (the sweep shape), K (output depth), F (filter/window size),
+ *                S (stride), optionally followed by one of *, / (rounding up), + or -
+ *                and another number or symbol.
+ *
+ * ops/iter is computed from the shape of output 0 after execution:
+ *   elem:   ops_per_elem per output element
+ *   conv:   2*F*F*D MACs-as-ops per output element
+ *   dwconv: 2*F*F per output element
+ *   pool:   F*F per output element
+ * bytes/iter is the size of all const inputs plus the valid size of all outputs,
+ * i.e. the minimum traffic if nothing stays in cache between iterations.
+ *
+ * Example:
+ *   op_bench --op Supernode_8x8p32to8 --shapes 1x56x56x64,1x28x28x128 --k 128 --f 3 \
+ *       --iters 50 --peak_gops 1000 --peak_gbps 12 --json sn.json
+ *
+ * Some recipes are variants of an op, named OP/VARIANT; e.g. softmax throughput against
+ * depth, full and top-k:
+ *   op_bench --op Softmax_f --shapes 64x1x1x1000,16x1x1x10000,2x1x1x100000,1x1x1x1000000
+ *   op_bench --op Softmax_f/topk --k 5 --shapes 64x1x1x1000,16x1x1x10000,2x1x1x100000,1x1x1x1000000
+ *
+ * TopK against (n,k), n being the depth. TopK_f takes the threshold filter when k is
+ * small against n, and selects over the whole row when k is close to n. TopK_8 is a
+ * histogram (on HVX up to n = 65535) and a scatter of the k, for any k. A shape can
+ * carry its own k, as BxHxWxD:K:
+ *   op_bench --op TopK_f --shapes 64x1x1x1000:5,16x1x1x10000:5,2x1x1x100000:5,1x1x1x1000000:5,64x1x1x1000:500,64x1x1x1000:990,16x1x1x10000:9990
+ *   op_bench --op TopK_8 --shapes 64x1x1x1000:5,16x1x1x10000:5,2x1x1x100000:5,64x1x1x1000:990,16x1x1x10000:9990
+ *
+ * NMS against the number of candidates (1k, 10k, 100k). For MultiClassNms_f and
+ * BoxWithNmsLimit_f that's boxes (W) x classes (D; BoxWithNmsLimit's class 0 is the
+ * background); for Proposal_f, anchors (D) at each of HxW cells. K is the output limit:
+ *   op_bench --op MultiClassNms_f --k 100 --shapes 1x1x1000x1,1x1x10000x1,1x1x100000x1,1x1x1000x100
+ *   op_bench --op BoxWithNmsLimit_f --k 100 --shapes 1x1x1000x2,1x1x10000x2,1x1x100000x2,1x1x1000x101
+ *   op_bench --op Proposal_f --k 300 --shapes 1x25x40x1,1x50x50x4,1x100x100x10
+ */
+
+#include "hexagon_nn.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef ANDROID
+#include "rpcmem.h"
+#define ION_HEAP_ID_SYSTEM 25
+#else
+#define rpcmem_init() /* NOTHING */
+#define rpcmem_deinit() /* NOTHING */
+#define rpcmem_free(a) free((a))
+#define rpcmem_alloc(a, b, c) malloc(c)
+#endif
+
+#define MAX_SPECS 16
+#define MAX_SHAPES 32
+#define MAX_PERF_NODES 64
+#define BENCH_LOG_SIZE (64*1024)
+
+#define PERFEVENT_CYCLES 0		// NN_GRAPH_PERFEVENT_CYCLES
+
+#define INPUT_NODE_ID 0x100
+#define CONST_NODE_ID_BASE 0x1000
+#define OP_NODE_ID 0x2000
+#define OUTPUT_NODE_ID 0x3000
+
+enum ops_kind {
+	OPS_ELEM,
+	OPS_CONV,
+	OPS_DWCONV,
+	OPS_POOL,
+};
+
+static const char *ops_kind_names[] = { "elem", "conv", "dwconv", "pool" };
+
+struct op_recipe {
+	const char *name;
+	const char *op;		// the op to run, if it's not 'name' (for variants)
+	const char *ins;
+	const char *outs;
+	enum ops_kind ops_kind;
+	hexagon_nn_padding_type padding;
+};
+
+#define QMINMAX "f=-1.0;f=1.0"
+
+static const struct op_recipe recipes[] = {
+	{ "QuantizedAdd_8p8to8", NULL,
+		"u8:BxHxWxD;u8:BxHxWxD;" QMINMAX ";" QMINMAX,
+		"u8:BxHxWxD;f;f", OPS_ELEM, NN_PAD_NA },
+	{ "QuantizedRelu_8", NULL,
+		"u8:BxHxWxD;" QMINMAX,
+		"u8:BxHxWxD;f;f", OPS_ELEM, NN_PAD_NA },
+	{ "QuantizedSoftmax_8", NULL,
+		"u8:BxHxWxD;" QMINMAX,
+		"u8:BxHxWxD;f;f", OPS_ELEM, NN_PAD_NA },
+	{ "Softmax_f", NULL,
+		"f:BxHxWxD",
+		"f:BxHxWxD", OPS_ELEM, NN_PAD_NA },
+	{ "Softmax_f/topk", "Softmax_f",
+		"f:BxHxWxD;f=1.0;i32=K",
+		"f:BxHxWxK;i32:BxHxWxK", OPS_ELEM, NN_PAD_NA },
+	{ "LogSoftmax_f", NULL,
+		"f:BxHxWxD",
+		"f:BxHxWxD", OPS_ELEM, NN_PAD_NA },
+	{ "TopK_f", NULL,
+		"f:BxHxWxD;i32=K",
+		"f:BxHxWxK;i32:BxHxWxK", OPS_ELEM, NN_PAD_NA },
+	{ "TopK_8", NULL,
+		"u8:BxHxWxD;i32=K;" QMINMAX,
+		"u8:BxHxWxK;i32:BxHxWxK;f;f", OPS_ELEM, NN_PAD_NA },
+	{ "QuantizedMaxPool_8", NULL,
+		"u8:BxHxWxD;" QMINMAX ";shape:1xFxFx1;shape:1xSxSx1",
+		"u8:BxH/SxW/SxD;f;f", OPS_POOL, NN_PAD_SAME },
+	{ "QuantizedAvgPool_8", NULL,
+		"u8:BxHxWxD;" QMINMAX ";shape:1xFxFx1;shape:1xSxSx1",
+		"u8:BxH/SxW/SxD;f;f", OPS_POOL, NN_PAD_SAME },
+	{ "Supernode_8x8p32to8", NULL,
+		"u8:BxHxWxD;u8:FxFxDxK;" QMINMAX ";" QMINMAX ";shape:1xSxSx1;i32:1x1x1xK;f=-256.0;f=256.0;f=-8.0;f=8.0",
+		"u8:BxH/SxW/SxK;f;f", OPS_CONV, NN_PAD_SAME },
+	{ "DepthwiseSupernode_8x8p32to8", NULL,
+		"u8:BxHxWxD;u8:FxFxDx1;" QMINMAX ";" QMINMAX ";shape:1xSxSx1;i32:1x1x1xD;f=-256.0;f=256.0;f=-8.0;f=8.0",
+		"u8:BxH/SxW/SxD;f;f", OPS_DWCONV, NN_PAD_SAME },
+	// boxes, scores; score and iou thresholds, max per class, max total
+	{ "MultiClassNms_f", NULL,
+		"box:Bx1xWx4;f:Bx1xWxD;f=0.0;f=0.5;i32=K;i32=K",
+		"f:Bx1xKx4;f:Bx1x1xK;f:Bx1x1xK", OPS_ELEM, NN_PAD_NA },
+	// scores, boxes (per class), batch splits; thresholds, detections per image,
+	// soft nms (off), method, sigma, min score, rotated (no). Up to W x (D-1) kept.
+	{ "BoxWithNmsLimit_f", NULL,
+		"f:1x1xWxD;box:1x1xWxD*4=1000.0;f=W;f=0.0;f=0.5;i32=K;i32=0;i32=0;f=0.5;f=0.001;i32=0",
+		"f:1x1xWxD;f:1xWxDx4;f:1x1xWxD;f", OPS_ELEM, NN_PAD_NA },
+	// scores and deltas for D anchors per cell, im_info, anchors, feature stride,
+	// max rois, max proposals before nms (6000, as Faster R-CNN), iou threshold, min box size
+	{ "Proposal_f", NULL,
+		"f:1xHxWxD;f:1xHxWxD*4;f:1x1x1x3=1600.0;box:1x1xDx4=256.0;f=16.0;i32=K;i32=6000;f=0.7;f=0.0",
+		"f:1x1xKx5;f:1x1x1xK", OPS_ELEM, NN_PAD_NA },
+};
+
+struct bench_params {
+	uint32_t b, h, w, d;
+	uint32_t k, f, s;
+};
+
+enum tspec_kind {
+	TS_RAND,
+	TS_FILL,
+	TS_SHAPE,
+};
+
+struct tspec {
+	enum tspec_kind kind;
+	char type[8];
+	uint32_t elsize;
+	uint32_t dims[4];
+	double val;
+};
+
+struct bench_result {
+	struct bench_params p;
+	double ns_min;
+	double ns_median;
+	double ns_mean;
+	double pcycles;
+	double node_cycles;
+	uint64_t bytes;
+	uint64_t ops;
+	uint32_t out_dims[4];
+};
+
+struct bench_options {
+	const char *op_name;
+	const char *ins;
+	const char *outs;
+	enum ops_kind ops_kind;
+	hexagon_nn_padding_type padding;
+	double ops_per_elem;
+	int warmup;
+	int iters;
+	double peak_gops;
+	double peak_gbps;
+	const char *json_file;
+	int debug_level;
+	uint32_t input_op_id;
+	uint32_t output_op_id;
+	int n_shapes;
+	struct bench_params shapes[MAX_SHAPES];
+};
+
+static uint32_t rand_state = 0x12345678;
+
+static inline uint32_t bench_rand()
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
+
+static inline double now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static inline unsigned long long int get_counter(hexagon_nn_perfinfo s)
+{
+	unsigned long long int ret;
+	ret = s.counter_hi;
+	ret <<= 32;
+	ret |= s.counter_lo;
+	return ret;
+}
+
+static void print_log(hexagon_nn_nn_id id)
+{
+	unsigned char *buf;
+	if ((buf = malloc(BENCH_LOG_SIZE)) == NULL) return;
+	buf[0] = 0;
+	hexagon_nn_getlog(id,buf,BENCH_LOG_SIZE);
+	buf[BENCH_LOG_SIZE-1] = 0;
+	if (buf[0]) printf("%s",(char *)buf);
+	free(buf);
+}
+
+/*
+ * Parse a number or a shape symbol. Returns pointer past it, or NULL on error.
+ */
+static const char *parse_dim_value(const char *s, const struct bench_params *p, uint32_t *out)
+{
+	char *end;
+	switch (*s) {
+	case 'B': *out = p->b; return s+1;
+	case 'H': *out = p->h; return s+1;
+	case 'W': *out = p->w; return s+1;
+	case 'D': *out = p->d; return s+1;
+	case 'K': *out = p->k; return s+1;
+	case 'F': *out = p->f; return s+1;
+	case 'S': *out = p->s; return s+1;
+	}
+	*out = strtoul(s,&end,10);
+	return (end == s) ? NULL : end;
+}
+
+/*
+ * Parse one dimension term: value, optionally followed by [*\/+-]value.
+ * Returns pointer past the term, or NULL on error.
+ */
+static const char *parse_dim(const char *s, const struct bench_params *p, uint32_t *out)
+{
+	uint32_t v, n;
+	if ((s = parse_dim_value(s,p,&v)) == NULL) return NULL;
+	if (*s == '*' || *s == '/' || *s == '+' || *s == '-') {
+		char op = *s++;
+		if ((s = parse_dim_value(s,p,&n)) == NULL) return NULL;
+		switch (op) {
+		case '*': v *= n; break;
+		case '/': if (n == 0) return NULL; v = (v + n - 1) / n; break;
+		case '+': v += n; break;
+		case '-': v = (v > n) ? v - n : 0; break;
+		}
+	}
+	*out = v;
+	return s;
+}
+
+/*
+ * Parse a ';'-separated spec list, with symbols bound to the shape in p.
+ * Returns the number of specs, or -1 on error.
+ */
+static int parse_specs(const char *str, const struct bench_params *p, struct tspec *specs, int max_specs)
+{
+	int n = 0;
+	const char *s = str;
+	while (*s) {
+		struct tspec *t;
+		int i;
+		if (n >= max_specs) {
+			printf("too many specs in '%s'\n",str);
+			return -1;
+		}
+		t = &specs[n++];
+		memset(t,0,sizeof(*t));
+		t->kind = TS_RAND;
+		for (i = 0; i < 4; i++) t->dims[i] = 1;
+		for (i = 0; *s && *s != ':' && *s != '=' && *s != ';'; s++) {
+			if (i < sizeof(t->type)-1) t->type[i++] = *s;
+		}
+		if (strcmp(t->type,"u8") == 0) t->elsize = 1;
+		else if (strcmp(t->type,"i32") == 0) t->elsize = 4;
+		else if (strcmp(t->type,"f") == 0) t->elsize = 4;
+		else if (strcmp(t->type,"box") == 0) t->elsize = 4;
+		else if (strcmp(t->type,"shape") == 0) t->kind = TS_SHAPE;
+		else {
+			printf("bad type '%s' in '%s'\n",t->type,str);
+			return -1;
+		}
+		if (*s == ':') {
+			s++;
+			for (i = 0; i < 4; i++) {
+				if (i > 0) {
+					if (*s++ != 'x') goto bad;
+				}
+				if ((s = parse_dim(s,p,&t->dims[i])) == NULL) goto bad;
+			}
+		}
+		if (*s == '=') {
+			char *end;
+			if (t->kind == TS_SHAPE) goto bad;
+			t->val = strtod(++s,&end);
+			if (end == s) {
+				uint32_t v;
+				if ((end = (char *)parse_dim_value(s,p,&v)) == NULL) goto bad;
+				t->val = v;
+			}
+			s = end;
+			t->kind = TS_FILL;
+		}
+		if (*s == ';') s++;
+		else if (*s) goto bad;
+	}
+	return n;
+bad:
+	printf("can't parse spec list '%s'\n",str);
+	return -1;
+}
+
+static inline uint64_t spec_elements(const struct tspec *t)
+{
+	return (uint64_t)t->dims[0] * t->dims[1] * t->dims[2] * t->dims[3];
+}
+
+static inline float bench_rand_unit()
+{
+	return (float)(bench_rand() & 0xFFFF) / 65536.0f;
+}
+
+static void fill_spec_data(const struct tspec *t, void *data)
+{
+	uint64_t i;
+	uint64_t n = spec_elements(t);
+	if (strcmp(t->type,"box") == 0) {
+		float *d = data;
+		float range = (t->kind == TS_FILL) ? (float)t->val : 1.0f;
+		for (i = 0; i + 4 <= n; i += 4) {
+			float side0 = range * (0.01f + 0.09f * bench_rand_unit());
+			float side1 = range * (0.01f + 0.09f * bench_rand_unit());
+			d[i] = (range - side0) * bench_rand_unit();
+			d[i+1] = (range - side1) * bench_rand_unit();
+			d[i+2] = d[i] + side0;
+			d[i+3] = d[i+1] + side1;
+		}
+		for (; i < n; i++) d[i] = range * bench_rand_unit();
+	} else if (t->elsize == 1) {
+		uint8_t *d = data;
+		for (i = 0; i < n; i++) d[i] = (t->kind == TS_FILL) ? (uint8_t)t->val : (uint8_t)bench_rand();
+	} else if (strcmp(t->type,"f") == 0) {
+		float *d = data;
+		for (i = 0; i < n; i++) {
+			d[i] = (t->kind == TS_FILL) ? (float)t->val : (float)((int32_t)(bench_rand() & 0xFFFF) - 0x8000) / 32768.0f;
+		}
+	} else {
+		int32_t *d = data;
+		for (i = 0; i < n; i++) {
+			d[i] = (t->kind == TS_FILL) ? (int32_t)t->val : (int32_t)(bench_rand() & 0x1FF) - 0x100;
+		}
+	}
+}
+
+static uint64_t count_ops(const struct bench_options *opt, const struct bench_params *p, const uint32_t out_dims[4])
+{
+	uint64_t out_elements = (uint64_t)out_dims[0] * out_dims[1] * out_dims[2] * out_dims[3];
+	uint64_t window = (uint64_t)p->f * p->f;
+	switch (opt->ops_kind) {
+	case OPS_CONV: return out_elements * window * p->d * 2;
+	case OPS_DWCONV: return out_elements * window * 2;
+	case OPS_POOL: return out_elements * window;
+	default: return (uint64_t)(out_elements * opt->ops_per_elem);
+	}
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+/*
+ * Build, prepare and time one graph for shape p. Returns 0 on success.
+ */
+static int bench_one(const struct bench_options *opt, uint32_t op_id, const struct bench_params *p, struct bench_result *res)
+{
+	struct tspec in_specs[MAX_SPECS];
+	struct tspec out_specs[MAX_SPECS];
+	hexagon_nn_input op_inputs[MAX_SPECS];
+	hexagon_nn_input output_inputs[MAX_SPECS];
+	hexagon_nn_output op_outputs[MAX_SPECS];
+	hexagon_nn_output dummy_output;
+	hexagon_nn_tensordef dummy_in;
+	hexagon_nn_tensordef outs[MAX_SPECS];
+	hexagon_nn_perfinfo info[MAX_PERF_NODES];
+	uint8_t dummy_data[4] = { 0 };
+	double *times = NULL;
+	hexagon_nn_nn_id id;
+	unsigned int n_info = 0;
+	unsigned int cycleslo, cycleshi;
+	double pcycles = 0;
+	uint64_t in_bytes = 0;
+	uint64_t out_bytes;
+	int n_in, n_out;
+	int i, j;
+	int ret = -1;
+
+	memset(outs,0,sizeof(outs));
+	memset(res,0,sizeof(*res));
+	res->p = *p;
+	if ((n_in = parse_specs(opt->ins,p,in_specs,MAX_SPECS)) < 0) return -1;
+	if ((n_out = parse_specs(opt->outs,p,out_specs,MAX_SPECS)) < 0) return -1;
+	if (n_out == 0) {
+		printf("op needs at least one output spec\n");
+		return -1;
+	}
+	if ((times = malloc(sizeof(*times)*opt->iters)) == NULL) return -1;
+
+	if (hexagon_nn_init(&id) != 0) {
+		printf("can't init graph\n");
+		free(times);
+		return -1;
+	}
+	hexagon_nn_set_debug_level(id,opt->debug_level);
+
+	memset(&dummy_output,0,sizeof(dummy_output));
+	dummy_output.rank = 4;
+	for (i = 0; i < 4; i++) dummy_output.max_sizes[i] = 1;
+	dummy_output.elementsize = 1;
+	if (hexagon_nn_append_node(id,INPUT_NODE_ID,opt->input_op_id,NN_PAD_NA,NULL,0,&dummy_output,1) != 0) goto err_graph;
+
+	for (i = 0; i < n_in; i++) {
+		const struct tspec *t = &in_specs[i];
+		uint32_t node_id = CONST_NODE_ID_BASE + i;
+		uint32_t len = (t->kind == TS_SHAPE) ? 0 : spec_elements(t) * t->elsize;
+		uint8_t *data = NULL;
+		int err;
+		if (len > 0) {
+			if ((data = malloc(len)) == NULL) goto err_graph;
+			fill_spec_data(t,data);
+		}
+		err = hexagon_nn_append_const_node(id,node_id,t->dims[0],t->dims[1],t->dims[2],t->dims[3],data,len);
+		free(data);
+		if (err != 0) {
+			printf("append const %d (%s) failed\n",i,t->type);
+			goto err_graph;
+		}
+		op_inputs[i].src_id = node_id;
+		op_inputs[i].output_idx = 0;
+		in_bytes += len;
+	}
+
+	for (i = 0; i < n_out; i++) {
+		const struct tspec *t = &out_specs[i];
+		memset(&op_outputs[i],0,sizeof(op_outputs[i]));
+		op_outputs[i].rank = 4;
+		for (j = 0; j < 4; j++) op_outputs[i].max_sizes[j] = t->dims[j];
+		op_outputs[i].elementsize = t->elsize;
+		output_inputs[i].src_id = OP_NODE_ID;
+		output_inputs[i].output_idx = i;
+		outs[i].dataLen = spec_elements(t) * t->elsize;
+		if ((outs[i].data = rpcmem_alloc(ION_HEAP_ID_SYSTEM,RPCMEM_DEFAULT_FLAGS,outs[i].dataLen)) == NULL) goto err_graph;
+	}
+	if (hexagon_nn_append_node(id,OP_NODE_ID,op_id,opt->padding,op_inputs,n_in,op_outputs,n_out) != 0) {
+		printf("append %s failed\n",opt->op_name);
+		goto err_graph;
+	}
+	if (hexagon_nn_append_node(id,OUTPUT_NODE_ID,opt->output_op_id,NN_PAD_NA,output_inputs,n_out,NULL,0) != 0) goto err_graph;
+	if (hexagon_nn_prepare(id) != 0) {
+		printf("prepare failed\n");
+		goto err_graph;
+	}
+
+	memset(&dummy_in,0,sizeof(dummy_in));
+	dummy_in.batches = dummy_in.height = dummy_in.width = dummy_in.depth = 1;
+	dummy_in.data = dummy_data;
+	dummy_in.dataLen = sizeof(dummy_data);
+	dummy_in.data_valid_len = 1;
+
+	for (i = 0; i < opt->warmup; i++) {
+		if (hexagon_nn_execute_new(id,&dummy_in,1,outs,n_out) != 0) {
+			printf("execute failed\n");
+			goto err_graph;
+		}
+	}
+	hexagon_nn_reset_perfinfo(id,PERFEVENT_CYCLES);
+	for (i = 0; i < opt->iters; i++) {
+		double t0 = now_ns();
+		if (hexagon_nn_execute_new(id,&dummy_in,1,outs,n_out) != 0) {
+			printf("execute failed\n");
+			goto err_graph;
+		}
+		times[i] = now_ns() - t0;
+		hexagon_nn_last_execution_cycles(id,&cycleslo,&cycleshi);
+		pcycles += (double)(((unsigned long long int)cycleshi << 32) | cycleslo);
+	}
+	/* Node cycles exclude the INPUT and OUTPUT copies, but include any nodes prepare added around the op */
+	if (hexagon_nn_get_perfinfo(id,info,MAX_PERF_NODES,&n_info) == 0) {
+		for (i = 0; i < n_info; i++) {
+			if (info[i].node_id == INPUT_NODE_ID || info[i].node_id == OUTPUT_NODE_ID) continue;
+			if (info[i].executions == 0) continue;
+			res->node_cycles += (double)get_counter(info[i]) / info[i].executions;
+		}
+	}
+
+	qsort(times,opt->iters,sizeof(*times),cmp_double);
+	res->ns_min = times[0];
+	res->ns_median = times[opt->iters/2];
+	for (i = 0; i < opt->iters; i++) res->ns_mean += times[i];
+	res->ns_mean /= opt->iters;
+	res->pcycles = pcycles / opt->iters;
+	res->out_dims[0] = outs[0].batches;
+	res->out_dims[1] = outs[0].height;
+	res->out_dims[2] = outs[0].width;
+	res->out_dims[3] = outs[0].depth;
+	out_bytes = 0;
+	for (i = 0; i < n_out; i++) out_bytes += outs[i].data_valid_len;
+	res->bytes = in_bytes + out_bytes;
+	res->ops = count_ops(opt,p,res->out_dims);
+	ret = 0;
+err_graph:
+	if (ret != 0) print_log(id);
+	hexagon_nn_teardown(id);
+	for (i = 0; i < n_out; i++) if (outs[i].data) rpcmem_free(outs[i].data);
+	free(times);
+	return ret;
+}
+
+/*
+ * Roofline position. Returns achieved Gop/s; *attainable and *bound are filled in
+ * when both peaks are known (attainable = 0 otherwise).
+ */
+static double roofline(const struct bench_options *opt, const struct bench_result *r, double *attainable, const char **bound)
+{
+	double gops = r->ops / r->ns_median;
+	double ai = r->bytes ? (double)r->ops / r->bytes : 0.0;
+	*attainable = 0.0;
+	*bound = "";
+	if (opt->peak_gops > 0.0 && opt->peak_gbps > 0.0) {
+		double mem_roof = ai * opt->peak_gbps;
+		if (mem_roof < opt->peak_gops) {
+			*attainable = mem_roof;
+			*bound = "memory";
+		} else {
+			*attainable = opt->peak_gops;
+			*bound = "compute";
+		}
+	}
+	return gops;
+}
+
+static void print_results(const struct bench_options *opt, const struct bench_result *res, int n)
+{
+	int i;
+	printf("%-20s %-14s %12s %12s %12s %12s %8s %9s %9s %8s\n",
+		"shape","out","ns/iter","pcycles","node_cyc","bytes","ops/B","Gop/s","GB/s","roof%");
+	for (i = 0; i < n; i++) {
+		const struct bench_result *r = &res[i];
+		char shape[32], out[32];
+		double attainable;
+		const char *bound;
+		double gops = roofline(opt,r,&attainable,&bound);
+		snprintf(shape,sizeof(shape),"%ux%ux%ux%u",r->p.b,r->p.h,r->p.w,r->p.d);
+		snprintf(out,sizeof(out),"%ux%ux%ux%u",r->out_dims[0],r->out_dims[1],r->out_dims[2],r->out_dims[3]);
+		printf("%-20s %-14s %12.0f %12.0f %12.0f %12llu %8.2f %9.2f %9.2f",
+			shape,out,r->ns_median,r->pcycles,r->node_cycles,(unsigned long long)r->bytes,
+			r->bytes ? (double)r->ops / r->bytes : 0.0,gops,r->bytes / r->ns_median);
+		if (attainable > 0.0) printf(" %7.1f%% %s\n",100.0 * gops / attainable,bound);
+		else printf(" %8s\n","-");
+	}
+}
+
+static int write_json(const struct bench_options *opt, const struct bench_result *res, int n)
+{
+	FILE *f;
+	int i;
+	if ((f = fopen(opt->json_file,"w")) == NULL) {
+		printf("can't open %s\n",opt->json_file);
+		return -1;
+	}
+	fprintf(f,"{\n  \"op\": \"%s\",\n  \"ops_kind\": \"%s\",\n",opt->op_name,ops_kind_names[opt->ops_kind]);
+	fprintf(f,"  \"warmup\": %d,\n  \"iters\": %d,\n",opt->warmup,opt->iters);
+	fprintf(f,"  \"peak_gops\": %g,\n  \"peak_gbps\": %g,\n",opt->peak_gops,opt->peak_gbps);
+	fprintf(f,"  \"results\": [\n");
+	for (i = 0; i < n; i++) {
+		const struct bench_result *r = &res[i];
+		double attainable;
+		const char *bound;
+		double gops = roofline(opt,r,&attainable,&bound);
+		fprintf(f,"    { \"shape\": [%u, %u, %u, %u], \"k\": %u, \"f\": %u, \"s\": %u,\n",
+			r->p.b,r->p.h,r->p.w,r->p.d,r->p.k,r->p.f,r->p.s);
+		fprintf(f,"      \"out_shape\": [%u, %u, %u, %u],\n",
+			r->out_dims[0],r->out_dims[1],r->out_dims[2],r->out_dims[3]);
+		fprintf(f,"      \"ns_per_iter\": %.1f, \"ns_min\": %.1f, \"ns_mean\": %.1f,\n",
+			r->ns_median,r->ns_min,r->ns_mean);
+		fprintf(f,"      \"pcycles_per_iter\": %.0f, \"node_cycles_per_iter\": %.0f,\n",r->pcycles,r->node_cycles);
+		fprintf(f,"      \"bytes_per_iter\": %llu, \"ops_per_iter\": %llu, \"ops_per_byte\": %.4f,\n",
+			(unsigned long long)r->bytes,(unsigned long long)r->ops,r->bytes ? (double)r->ops / r->bytes : 0.0);
+		fprintf(f,"      \"gops\": %.4f, \"gbps\": %.4f",gops,r->bytes / r->ns_median);
+		if (attainable > 0.0) {
+			fprintf(f,", \"attainable_gops\": %.4f, \"roof_fraction\": %.4f, \"bound\": \"%s\"",
+				attainable,gops / attainable,bound);
+		}
+		fprintf(f," }%s\n",(i == n-1) ? "" : ",");
+	}
+	fprintf(f,"  ]\n}\n");
+	fclose(f);
+	return 0;
+}
+
+static int parse_shapes(const char *str, struct bench_options *opt, const struct bench_params *defaults)
+{
+	const char *s = str;
+	opt->n_shapes = 0;
+	while (*s) {
+		struct bench_params *p;
+		int n = 0;
+		if (opt->n_shapes >= MAX_SHAPES) return -1;
+		p = &opt->shapes[opt->n_shapes++];
+		*p = *defaults;
+		if (sscanf(s,"%ux%ux%ux%u%n",&p->b,&p->h,&p->w,&p->d,&n) != 4) return -1;
+		if (s[n] == ':' && sscanf(s+n+1,"%u",&p->k) != 1) return -1;
+		if ((s = strchr(s,',')) == NULL) break;
+		s++;
+	}
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	int i;
+	printf("usage: %s --op NAME [options]\n",prog);
+	printf("  --shapes BxHxWxD[:K][,...]     shape sweep, each with its own K if given (default 1x32x32x32)\n");
+	printf("  --k N --f N --s N              output depth, filter/window size, stride\n");
+	printf("  --in SPECS --out SPECS         input/output specs (required if the op has no recipe)\n");
+	printf("  --ops elem|conv|dwconv|pool    how ops/iter is counted (default elem)\n");
+	printf("  --ops_per_elem X               ops per output element for 'elem' (default 1)\n");
+	printf("  --pad na|same|valid            padding type\n");
+	printf("  --warmup N --iters N           iterations (default 5, 20)\n");
+	printf("  --peak_gops X --peak_gbps X    roofline peaks\n");
+	printf("  --json FILE                    write results as JSON\n");
+	printf("  --debug N                      graph debug level\n");
+	printf("recipes:\n");
+	for (i = 0; i < sizeof(recipes)/sizeof(recipes[0]); i++) printf("  %s\n",recipes[i].name);
+}
+
+int main(int argc, char **argv)
+{
+	static struct bench_options opt;
+	static struct bench_result res[MAX_SHAPES];
+	struct bench_params defaults = { 1, 32, 32, 32, 32, 3, 1 };
+	const char *shapes = "1x32x32x32";
+	const char *ops_kind = NULL;
+	const char *pad = NULL;
+	uint32_t op_id;
+	int n_done = 0;
+	int i;
+
+	memset(&opt,0,sizeof(opt));
+	opt.ops_per_elem = 1.0;
+	opt.warmup = 5;
+	opt.iters = 20;
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		const char *v = (i+1 < argc) ? argv[i+1] : NULL;
+		if (strcmp(a,"--help") == 0) { usage(argv[0]); return 0; }
+		if (v == NULL) { usage(argv[0]); return 1; }
+		i++;
+		if (strcmp(a,"--op") == 0) opt.op_name = v;
+		else if (strcmp(a,"--in") == 0) opt.ins = v;
+		else if (strcmp(a,"--out") == 0) opt.outs = v;
+		else if (strcmp(a,"--shapes") == 0) shapes = v;
+		else if (strcmp(a,"--k") == 0) defaults.k = atoi(v);
+		else if (strcmp(a,"--f") == 0) defaults.f = atoi(v);
+		else if (strcmp(a,"--s") == 0) defaults.s = atoi(v);
+		else if (strcmp(a,"--ops") == 0) ops_kind = v;
+		else if (strcmp(a,"--ops_per_elem") == 0) opt.ops_per_elem = atof(v);
+		else if (strcmp(a,"--pad") == 0) pad = v;
+		else if (strcmp(a,"--warmup") == 0) opt.warmup = atoi(v);
+		else if (strcmp(a,"--iters") == 0) opt.iters = atoi(v);
+		else if (strcmp(a,"--peak_gops") == 0) opt.peak_gops = atof(v);
+		else if (strcmp(a,"--peak_gbps") == 0) opt.peak_gbps = atof(v);
+		else if (strcmp(a,"--json") == 0) opt.json_file = v;
+		else if (strcmp(a,"--debug") == 0) opt.debug_level = atoi(v);
+		else { usage(argv[0]); return 1; }
+	}
+	if (opt.op_name == NULL || opt.iters < 1 || opt.warmup < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	opt.ops_kind = OPS_ELEM;
+	opt.padding = NN_PAD_NA;
+	for (i = 0; i < sizeof(recipes)/sizeof(recipes[0]); i++) {
+		if (strcmp(recipes[i].name,opt.op_name) != 0) continue;
+		if (recipes[i].op != NULL) opt.op_name = recipes[i].op;
+		if (opt.ins == NULL) opt.ins = recipes[i].ins;
+		if (opt.outs == NULL) opt.outs = recipes[i].outs;
+		opt.ops_kind = recipes[i].ops_kind;
+		opt.padding = recipes[i].padding;
+		break;
+	}
+	if (opt.ins == NULL || opt.outs == NULL) {
+		printf("no recipe for %s: --in and --out are required\n",opt.op_name);
+		return 1;
+	}
+	if (ops_kind) {
+		for (i = 0; i < sizeof(ops_kind_names)/sizeof(ops_kind_names[0]); i++) {
+			if (strcmp(ops_kind,ops_kind_names[i]) == 0) break;
+		}
+		if (i == sizeof(ops_kind_names)/sizeof(ops_kind_names[0])) {
+			printf("bad --ops %s\n",ops_kind);
+			return 1;
+		}
+		opt.ops_kind = i;
+	}
+	if (pad) {
+		if (strcmp(pad,"na") == 0) opt.padding = NN_PAD_NA;
+		else if (strcmp(pad,"same") == 0) opt.padding = NN_PAD_SAME;
+		else if (strcmp(pad,"valid") == 0) opt.padding = NN_PAD_VALID;
+		else {
+			printf("bad --pad %s\n",pad);
+			return 1;
+		}
+	}
+	if (defaults.s == 0 || parse_shapes(shapes,&opt,&defaults) != 0) {
+		printf("bad --shapes %s\n",shapes);
+		return 1;
+	}
+
+	rpcmem_init();
+	if (hexagon_nn_op_name_to_id("INPUT",&opt.input_op_id) != 0
+	 || hexagon_nn_op_name_to_id("OUTPUT",&opt.output_op_id) != 0
+	 || hexagon_nn_op_name_to_id(opt.op_name,&op_id) != 0) {
+		printf("unknown op %s\n",opt.op_name);
+		rpcmem_deinit();
+		return 1;
+	}
+	printf("op %s (id %u), %d warmup + %d timed iterations\n",opt.op_name,op_id,opt.warmup,opt.iters);
+	for (i = 0; i < opt.n_shapes; i++) {
+		if (bench_one(&opt,op_id,&opt.shapes[i],&res[n_done]) != 0) {
+			printf("shape %ux%ux%ux%u failed, skipped\n",
+				opt.shapes[i].b,opt.shapes[i].h,opt.shapes[i].w,opt.shapes[i].d);
+			continue;
+		}
+		n_done++;
+	}
+	print_results(&opt,res,n_done);
+	if (opt.json_file) write_json(&opt,res,n_done);
+	rpcmem_deinit();
+	return (n_done == opt.n_shapes) ? 0 : 1;
+}
@@ -0,0 +1,542 @@
+/*
+ * Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * qvec_check: the qvec SIMD backends against the C reference, bit for bit
+ *
+ * Every nn_qvec_* entry point (nn_quantize_vec.h) is run on random cases, once with the
+ * "c" backend and once with each SIMD backend that is built and supported by the cpu
+ * ("sse4.1", "avx2", "neon"), selected with nn_qvec_set_backend. The whole output
+ * buffers -- including the slack after the last output, which is pre-filled with a fill
+ * pattern -- must be identical; float outputs are compared as bits.
+ *
+ * Case i has an odd length from qvec_lengths[] (so every block size has a partial last
+ * block), input and output pointers offset by 0..3 elements, and one of three kinds of
+ * input and parameters:
+ *	random		values and gains in the ranges the ops use
+ *	saturating	edge values (INT32_MIN/MAX, 0/255, offsets far out of range,
+ *			exact .5 ties for the float->int rounding)
+ *	huge		float inputs, gains and scales of +/-1e30; full-range ints
+ * The first difference for each backend/entry point is reported with its case number,
+ * which can be repeated with -c.
+ *
+ *   gcc -O2 -DUSE_OS_LINUX -Ihexagon/hvx_emul -Ihexagon/include -Iinterface \
+ *       test/qvec_check.c hexagon/src/quantize_vec.c -lm -o qvec_check
+ * (on aarch64, the same line checks "neon").
+ *
+ * Usage: qvec_check [-n cases] [-s seed] [-c case] [-k entry-point-prefix]
+ * Returns nonzero if anything differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "nn_quantize_vec.h"
+
+#define ALIGN_UP(X,A) (((X)+(A)-1) & ~(size_t)((A)-1))
+#define FILL_BYTE 0xA5
+#define SLACK 256
+
+enum { QC_RANDOM, QC_SATURATE, QC_HUGE, QC_NKINDS };
+static const char *const qc_kind_names[QC_NKINDS] = { "random", "saturating", "huge" };
+
+static const int qvec_lengths[] = { 1, 3, 5, 7, 9, 15, 17, 31, 33, 63, 65, 127, 129, 255, 1023, 4097 };
+#define QVEC_N_LENGTHS ((int)(sizeof(qvec_lengths)/sizeof(qvec_lengths[0])))
+
+static const char *const simd_backends[] = { "sse4.1", "avx2", "neon" };
+
+struct qcase {
+	int n;				// elements (u8_to_u8_d32: bytes per row)
+	int kind;			// QC_xxx
+	uint8_t *in_base, *in;		// in is in_base + 0..3 elements
+	size_t out_offs;		// output starts this many bytes into the buffer
+	size_t out_bytes;		// out_offs + outputs
+	int32_t gain, offset;		// q31 gain, int offset
+	int rsh;
+	float fgain, foffset;		// float gain/scale, float offset or minval
+	int zero, xorval;
+	int h_count, nd32, height_stride, d32_stride;	// u8_to_u8_d32
+	char desc[112];
+};
+
+struct qvec_check {
+	const char *name;
+	int (*make)(struct qcase *c, uint32_t *seed);	// parms and input for c->n, c->kind
+	void (*run)(struct qcase const *c, void *outp);
+};
+
+static uint32_t rand_u32(uint32_t *seed)
+{
+	uint32_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return (*seed = x);
+}
+
+static int rand_range(uint32_t *seed, int lo, int hi)
+{
+	return lo + (int)(rand_u32(seed) % (uint32_t)(hi - lo + 1));
+}
+
+// uniform in [lo,hi)
+static float rand_flt(uint32_t *seed, float lo, float hi)
+{
+	return lo + (hi - lo) * (float)(rand_u32(seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+static float rand_sign(uint32_t *seed, float x)
+{
+	return (rand_u32(seed) & 0x100) ? -x : x;
+}
+
+static int32_t rand_pick(uint32_t *seed, int32_t const *vals, int n)
+{
+	return vals[rand_u32(seed) % (uint32_t)n];
+}
+#define RAND_PICK(SEED, ARR) rand_pick(SEED, ARR, (int)(sizeof(ARR)/sizeof(ARR[0])))
+
+static int32_t rand_i32(uint32_t *seed, int kind)
+{
+	static const int32_t edges[] = { INT32_MIN, INT32_MIN + 1, -65536, -32769, -32768, -256, -1,
+		0, 1, 255, 256, 32767, 32768, 65536, INT32_MAX - 1, INT32_MAX };
+	uint32_t r = rand_u32(seed);
+	switch (kind) {
+	case QC_RANDOM:
+		return (int32_t)r >> (rand_u32(seed) % 32);	// all magnitudes
+	case QC_SATURATE:
+		return (r & 1) ? RAND_PICK(seed, edges) : (int32_t)r;
+	default:
+		return ((r & 3) == 0) ? ((r & 4) ? INT32_MAX : INT32_MIN) : (int32_t)r;
+	}
+}
+
+static uint8_t rand_u8(uint32_t *seed, int kind)
+{
+	uint32_t r = rand_u32(seed);
+	if (kind == QC_SATURATE && (r & 1)) return (r & 2) ? 255 : 0;
+	return r >> 24;
+}
+
+// float input: random in [lo,hi); saturating: some at 'far' outside; huge: some +/-1e30
+static float rand_fin(uint32_t *seed, int kind, float lo, float hi, float far)
+{
+	uint32_t r = rand_u32(seed);
+	if (kind == QC_SATURATE && (r & 3) == 0) return (r & 4) ? far : -far;
+	if (kind == QC_HUGE && (r & 3) == 0) return (r & 4) ? 1e30f : -1e30f;
+	return rand_flt(seed, lo, hi);
+}
+
+// allocates c->in for in_bytes (+0..3 elements of in_align) and sets the output placement
+static int case_alloc(struct qcase *c, uint32_t *seed, size_t in_bytes, size_t in_align,
+		size_t out_bytes, size_t out_align)
+{
+	size_t in_offs = in_align * rand_range(seed, 0, 3);
+	void *p = NULL;
+	if (posix_memalign(&p, 128, ALIGN_UP(in_offs + in_bytes + SLACK, 128)) != 0) return -1;
+	c->in_base = p;
+	c->in = c->in_base + in_offs;
+	c->out_offs = out_align * rand_range(seed, 0, 3);
+	c->out_bytes = c->out_offs + out_bytes;
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////
+// i32 -> u8, q31 gain
+//////////////////////////////////////////////////////////////////
+
+static int i32_to_u8_q31_make(struct qcase *c, uint32_t *seed)
+{
+	static const int32_t gains[] = { 0, 1, 1 << 30, INT32_MAX - 1, INT32_MAX };
+	static const int32_t offsets[] = { INT32_MIN, -65536, -256, -1, 0, 255, 256, INT32_MAX };
+	if (case_alloc(c, seed, c->n * sizeof(int32_t), sizeof(int32_t), c->n, 1) != 0) return -1;
+	if (c->kind == QC_RANDOM) {
+		c->gain = (int32_t)((rand_u32(seed) >> 1) >> rand_range(seed, 0, 30));
+		c->offset = rand_range(seed, -300, 300);
+	} else if (c->kind == QC_SATURATE) {
+		c->gain = RAND_PICK(seed, gains);
+		c->offset = RAND_PICK(seed, offsets);
+	} else {
+		c->gain = (rand_u32(seed) & 1) ? INT32_MAX : (int32_t)(rand_u32(seed) >> 1);
+		c->offset = (int32_t)rand_u32(seed);
+	}
+	for (int i = 0; i < c->n; i++) ((int32_t *)c->in)[i] = rand_i32(seed, c->kind);
+	snprintf(c->desc, sizeof(c->desc), "gain=%ld offset=%ld", (long)c->gain, (long)c->offset);
+	return 0;
+}
+
+static void i32_to_u8_q31_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_i32_to_u8_q31(outp, (int32_t const *)c->in, c->n, c->gain, c->offset);
+}
+
+//////////////////////////////////////////////////////////////////
+// i32 -> u8, float gain
+//////////////////////////////////////////////////////////////////
+
+static int i32_to_u8_flt_make(struct qcase *c, uint32_t *seed)
+{
+	if (case_alloc(c, seed, c->n * sizeof(int32_t), sizeof(int32_t), c->n, 1) != 0) return -1;
+	c->fgain = rand_sign(seed, ldexpf(rand_flt(seed, 0.5f, 1.0f), -rand_range(seed, 0, 31)));
+	c->foffset = rand_flt(seed, -50.0f, 300.0f) + 0.5f;
+	if (c->kind == QC_SATURATE) {
+		c->fgain *= 256.0f;
+		if (rand_u32(seed) & 1) c->foffset = rand_sign(seed, 1e5f);
+	} else if (c->kind == QC_HUGE) {
+		c->fgain = rand_sign(seed, (rand_u32(seed) & 1) ? 1e30f : 1e-30f);
+		if (rand_u32(seed) & 1) c->foffset = rand_sign(seed, 1e30f);
+	}
+	for (int i = 0; i < c->n; i++) ((int32_t *)c->in)[i] = rand_i32(seed, c->kind);
+	snprintf(c->desc, sizeof(c->desc), "gain=%.8g offset=%.8g", c->fgain, c->foffset);
+	return 0;
+}
+
+static void i32_to_u8_flt_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_i32_to_u8_flt(outp, (int32_t const *)c->in, c->n, c->fgain, c->foffset);
+}
+
+//////////////////////////////////////////////////////////////////
+// i32 -> i16, q31 gain and shift
+//////////////////////////////////////////////////////////////////
+
+static int i32_to_i16_q31_make(struct qcase *c, uint32_t *seed)
+{
+	static const int32_t gains[] = { 1, 2, 1 << 30, INT32_MAX };
+	if (case_alloc(c, seed, c->n * sizeof(int32_t), sizeof(int32_t), c->n * sizeof(int16_t), sizeof(int16_t)) != 0) return -1;
+	if (c->kind == QC_RANDOM) {
+		c->gain = (int32_t)(rand_u32(seed) >> 1) | 1;
+	} else if (c->kind == QC_SATURATE) {
+		c->gain = RAND_PICK(seed, gains);
+	} else {
+		c->gain = INT32_MAX;
+	}
+	c->rsh = rand_range(seed, -24, 15);
+	for (int i = 0; i < c->n; i++) ((int32_t *)c->in)[i] = rand_i32(seed, c->kind);
+	snprintf(c->desc, sizeof(c->desc), "gain=%ld rsh=%d", (long)c->gain, c->rsh);
+	return 0;
+}
+
+static void i32_to_i16_q31_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_i32_to_i16_q31(outp, (int32_t const *)c->in, c->n, c->gain, c->rsh);
+}
+
+//////////////////////////////////////////////////////////////////
+// u8 -> u8 requantize (flat and d32)
+//////////////////////////////////////////////////////////////////
+
+// gain and offsets; the gain picks the uniform / lo-gain / hi-gain path
+static void u8_to_u8_parms(struct qcase *c, uint32_t *seed)
+{
+	static const int32_t offsets[] = { -100000, -32769, -256, -1, 0, 128, 255, 256, 32768, 100000 };
+	static const float gains[] = { 0.0f, 1e-5f, 0.5f, 0.99993f, 1.0f, 1.00003f, 1.0001f, 2.0f,
+		255.0f, 16383.0f, 32767.0f };
+	switch (rand_range(seed, 0, 2)) {
+	case 0: c->fgain = rand_flt(seed, 0.0f, 1.0f); break;
+	case 1: c->fgain = (rand_u32(seed) & 1) ? 1.0f : 1.0f + rand_flt(seed, -6e-5f, 6e-5f); break;
+	default: c->fgain = rand_flt(seed, 1.0f, 16.0f); break;
+	}
+	c->gain = rand_range(seed, 0, 255);		// in_offset
+	c->offset = rand_range(seed, 0, 255);		// out_offset
+	if (c->kind == QC_SATURATE) {
+		c->fgain = gains[rand_u32(seed) % (sizeof(gains) / sizeof(gains[0]))];
+		c->gain = RAND_PICK(seed, offsets);
+		c->offset = RAND_PICK(seed, offsets);
+	} else if (c->kind == QC_HUGE) {
+		c->fgain = (rand_u32(seed) & 1) ? 1e30f : 1e-30f;
+		c->gain = rand_i32(seed, QC_HUGE);
+		c->offset = rand_i32(seed, QC_HUGE);
+	}
+}
+
+static int u8_to_u8_make(struct qcase *c, uint32_t *seed)
+{
+	if (case_alloc(c, seed, c->n, 1, c->n, 1) != 0) return -1;
+	u8_to_u8_parms(c, seed);
+	for (int i = 0; i < c->n; i++) c->in[i] = rand_u8(seed, c->kind);
+	snprintf(c->desc, sizeof(c->desc), "gain=%.8g in_offset=%ld out_offset=%ld",
+		c->fgain, (long)c->gain, (long)c->offset);
+	return 0;
+}
+
+static void u8_to_u8_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_u8_to_u8(outp, c->in, c->n, c->fgain, c->gain, c->offset);
+}
+
+static int u8_to_u8_d32_make(struct qcase *c, uint32_t *seed)
+{
+	c->h_count = rand_range(seed, 1, 3);
+	c->nd32 = rand_range(seed, 1, 3);
+	c->d32_stride = ALIGN_UP(c->n, 32) + 32 * rand_range(seed, 0, 1);
+	c->height_stride = c->nd32 * c->d32_stride + 32 * rand_range(seed, 0, 1);
+	size_t bytes = (c->h_count - 1) * c->height_stride + (c->nd32 - 1) * c->d32_stride + c->n;
+	if (case_alloc(c, seed, bytes, 1, bytes, 1) != 0) return -1;
+	u8_to_u8_parms(c, seed);
+	for (size_t i = 0; i < bytes; i++) c->in[i] = rand_u8(seed, c->kind);
+	snprintf(c->desc, sizeof(c->desc), "%dx%d rows, gain=%.8g in_offset=%ld out_offset=%ld",
+		c->h_count, c->nd32, c->fgain, (long)c->gain, (long)c->offset);
+	return 0;
+}
+
+static void u8_to_u8_d32_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_u8_to_u8_d32(outp, c->in, c->h_count, c->nd32, c->n, c->height_stride, c->d32_stride,
+		c->fgain, c->gain, c->offset);
+}
+
+//////////////////////////////////////////////////////////////////
+// f32 <-> u8
+//////////////////////////////////////////////////////////////////
+
+static int f32_to_u8_make(struct qcase *c, uint32_t *seed)
+{
+	float *in;
+	if (case_alloc(c, seed, c->n * sizeof(float), sizeof(float), c->n, 1) != 0) return -1;
+	in = (float *)c->in;
+	c->foffset = rand_flt(seed, -10.0f, 0.0f);
+	float range = rand_flt(seed, 0.01f, 20.0f);
+	c->fgain = 255.0f / range;
+	if (c->kind == QC_SATURATE) {
+		// recip_stepsize = 1, integer minval: (in-minval) lands exactly on .5 ties
+		c->foffset = (float)rand_range(seed, -100, 0);
+		c->fgain = 1.0f;
+		for (int i = 0; i < c->n; i++) {
+			in[i] = (rand_u32(seed) & 7) == 0 ? rand_sign(seed, 1e5f)
+				: c->foffset + (float)rand_range(seed, -20, 280) + 0.5f;
+		}
+	} else {
+		if (c->kind == QC_HUGE && (rand_u32(seed) & 1)) c->fgain = 1e30f;
+		for (int i = 0; i < c->n; i++) {
+			in[i] = rand_fin(seed, c->kind, c->foffset - 0.1f * range, c->foffset + 1.1f * range, 0.0f);
+		}
+	}
+	snprintf(c->desc, sizeof(c->desc), "minval=%.8g recip_stepsize=%.8g", c->foffset, c->fgain);
+	return 0;
+}
+
+static void f32_to_u8_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_f32_to_u8(outp, (float const *)c->in, c->n, c->foffset, c->fgain);
+}
+
+static int u8_to_f32_make(struct qcase *c, uint32_t *seed)
+{
+	static const int32_t zeros[] = { -100000, -1, 0, 128, 255, 256, 100000 };
+	if (case_alloc(c, seed, c->n, 1, c->n * sizeof(float), sizeof(float)) != 0) return -1;
+	c->zero = rand_range(seed, 0, 255);
+	c->fgain = rand_flt(seed, 1e-4f, 1.0f);
+	if (c->kind == QC_SATURATE) {
+		c->zero = RAND_PICK(seed, zeros);
+	} else if (c->kind == QC_HUGE) {
+		c->fgain = rand_sign(seed, 1e30f);
+	}
+	for (int i = 0; i < c->n; i++) c->in[i] = rand_u8(seed, c->kind);
+	snprintf(c->desc, sizeof(c->desc), "qzero=%d qstep=%.8g", c->zero, c->fgain);
+	return 0;
+}
+
+static void u8_to_f32_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_u8_to_f32(outp, c->in, c->n, c->zero, c->fgain);
+}
+
+//////////////////////////////////////////////////////////////////
+// f32 <-> 16 bits
+//////////////////////////////////////////////////////////////////
+
+static int f32_to_x16_make(struct qcase *c, uint32_t *seed)
+{
+	static const int32_t offsets[] = { -1000000, -70000, -32768, -1, 0, 1, 32767, 32768, 70000, 1000000 };
+	float *in;
+	if (case_alloc(c, seed, c->n * sizeof(float), sizeof(float), c->n * sizeof(int16_t), sizeof(int16_t)) != 0) return -1;
+	in = (float *)c->in;
+	c->fgain = rand_flt(seed, 1.0f, 40000.0f);
+	c->offset = (rand_u32(seed) & 1) ? 0 : rand_range(seed, -100, 100);
+	c->xorval = (rand_u32(seed) & 1) ? 0 : 0x8000;
+	if (c->kind == QC_SATURATE) {
+		// scale 1: the inputs are exact .5 ties
+		c->fgain = 1.0f;
+		c->offset = RAND_PICK(seed, offsets);
+		for (int i = 0; i < c->n; i++) {
+			in[i] = (rand_u32(seed) & 7) == 0 ? rand_sign(seed, 1e6f)
+				: (float)rand_range(seed, -70000, 70000) + 0.5f;
+		}
+	} else {
+		if (c->kind == QC_HUGE && (rand_u32(seed) & 1)) c->fgain = rand_sign(seed, 1e30f);
+		for (int i = 0; i < c->n; i++) in[i] = rand_fin(seed, c->kind, -1.2f, 1.2f, 0.0f);
+	}
+	snprintf(c->desc, sizeof(c->desc), "scale=%.8g offset=%ld xorval=0x%x", c->fgain, (long)c->offset, c->xorval);
+	return 0;
+}
+
+static void f32_to_x16_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_f32_to_x16(outp, (float const *)c->in, c->n, c->fgain, c->offset, c->xorval);
+}
+
+static int x16_to_f32_make(struct qcase *c, uint32_t *seed)
+{
+	static const int32_t zeros[] = { -1000000, -1, 0, 32768, 65535, 65536, 1000000 };
+	uint16_t *in;
+	if (case_alloc(c, seed, c->n * sizeof(uint16_t), sizeof(uint16_t), c->n * sizeof(float), sizeof(float)) != 0) return -1;
+	in = (uint16_t *)c->in;
+	c->xorval = (rand_u32(seed) & 1) ? 0 : ((rand_u32(seed) & 1) ? 0x8000 : (int)(rand_u32(seed) >> 16));
+	c->zero = rand_range(seed, 0, 65535);
+	c->fgain = rand_sign(seed, rand_flt(seed, 1e-6f, 1.0f));
+	if (c->kind == QC_SATURATE) {
+		c->zero = RAND_PICK(seed, zeros);
+	} else if (c->kind == QC_HUGE) {
+		c->fgain = rand_sign(seed, 1e30f);
+	}
+	for (int i = 0; i < c->n; i++) {
+		uint32_t r = rand_u32(seed);
+		in[i] = (c->kind == QC_SATURATE && (r & 1)) ? ((r & 2) ? 0xFFFF : 0) : (uint16_t)(r >> 16);
+	}
+	snprintf(c->desc, sizeof(c->desc), "xorval=0x%x zero=%d scale=%.8g", c->xorval, c->zero, c->fgain);
+	return 0;
+}
+
+static void x16_to_f32_run(struct qcase const *c, void *outp)
+{
+	nn_qvec_x16_to_f32(outp, (uint16_t const *)c->in, c->n, c->xorval, c->zero, c->fgain);
+}
+
+static const struct qvec_check qvec_checks[] = {
+	{ "nn_qvec_i32_to_u8_q31", i32_to_u8_q31_make, i32_to_u8_q31_run },
+	{ "nn_qvec_i32_to_u8_flt", i32_to_u8_flt_make, i32_to_u8_flt_run },
+	{ "nn_qvec_i32_to_i16_q31", i32_to_i16_q31_make, i32_to_i16_q31_run },
+	{ "nn_qvec_u8_to_u8", u8_to_u8_make, u8_to_u8_run },
+	{ "nn_qvec_u8_to_u8_d32", u8_to_u8_d32_make, u8_to_u8_d32_run },
+	{ "nn_qvec_f32_to_u8", f32_to_u8_make, f32_to_u8_run },
+	{ "nn_qvec_u8_to_f32", u8_to_f32_make, u8_to_f32_run },
+	{ "nn_qvec_f32_to_x16", f32_to_x16_make, f32_to_x16_run },
+	{ "nn_qvec_x16_to_f32", x16_to_f32_make, x16_to_f32_run },
+};
+
+static uint32_t case_seed(uint32_t seed, int icase)
+{
+	return (seed ^ 0x9E3779B9u) * 2654435761u + (uint32_t)icase * 40503u + 1;
+}
+
+// run case 'icase' of qc with "c" and with 'backend'; returns 1 if they differ, -1 on error
+static int run_case(struct qvec_check const *qc, char const *backend, int icase, uint32_t seed, int verbose)
+{
+	struct qcase c;
+	uint8_t *out[2] = { NULL, NULL };
+	uint32_t s = case_seed(seed, icase);
+	int res = -1;
+
+	memset(&c, 0, sizeof(c));
+	c.n = qvec_lengths[icase % QVEC_N_LENGTHS];
+	c.kind = (icase / QVEC_N_LENGTHS) % QC_NKINDS;
+	if (qc->make(&c, &s) != 0) goto done;
+	for (int i = 0; i < 2; i++) {
+		void *p = NULL;
+		if (posix_memalign(&p, 128, ALIGN_UP(c.out_bytes + SLACK, 128)) != 0) goto done;
+		out[i] = p;
+		memset(out[i], FILL_BYTE, c.out_bytes + SLACK);
+	}
+	if (nn_qvec_set_backend("c") != 0) goto done;
+	qc->run(&c, out[0] + c.out_offs);
+	if (nn_qvec_set_backend(backend) != 0) goto done;
+	qc->run(&c, out[1] + c.out_offs);
+	res = 0;
+	if (memcmp(out[0], out[1], c.out_bytes + SLACK) != 0) {
+		res = 1;
+		if (verbose) {
+			size_t at = 0;
+			while (out[0][at] == out[1][at]) at++;
+			printf("%s/%s: case %d (n=%d %s, %s): first difference at byte %zu: c 0x%02x %s 0x%02x\n",
+				qc->name, backend, icase, c.n, qc_kind_names[c.kind], c.desc,
+				at - c.out_offs, out[0][at], backend, out[1][at]);
+		}
+	}
+done:
+	if (res < 0) printf("%s/%s: case %d: out of memory\n", qc->name, backend, icase);
+	free(out[0]);
+	free(out[1]);
+	free(c.in_base);
+	return res;
+}
+
+int main(int argc, char **argv)
+{
+	int ncases = 3 * QC_NKINDS * QVEC_N_LENGTHS;
+	int only_case = -1;
+	uint32_t seed = 1;
+	const char *only_func = NULL;
+	int total_bad = 0, nbackends = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 < argc && strcmp(argv[i], "-n") == 0) ncases = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) seed = strtoul(argv[++i], NULL, 0);
+		else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) only_case = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-k") == 0) only_func = argv[++i];
+		else {
+			fprintf(stderr, "usage: %s [-n cases] [-s seed] [-c case] [-k entry-point]\n", argv[0]);
+			return 2;
+		}
+	}
+	printf("default backend: %s\n", nn_qvec_backend_name());
+	printf("%-8s %-24s %6s %6s\n", "backend", "entry point", "cases", "bad");
+	for (size_t b = 0; b < sizeof(simd_backends) / sizeof(simd_backends[0]); b++) {
+		char const *backend = simd_backends[b];
+		if (nn_qvec_set_backend(backend) != 0) {
+			printf("%-8s (not built, or not supported by this cpu)\n", backend);
+			continue;
+		}
+		nbackends++;
+		for (size_t k = 0; k < sizeof(qvec_checks) / sizeof(qvec_checks[0]); k++) {
+			struct qvec_check const *qc = &qvec_checks[k];
+			int ran = 0, bad = 0;
+			if (only_func != NULL && strncmp(qc->name, only_func, strlen(only_func)) != 0) continue;
+			for (int icase = 0; icase < ncases; icase++) {
+				if (only_case >= 0 && icase != only_case) continue;
+				int r = run_case(qc, backend, icase, seed, bad == 0 || only_case >= 0);
+				if (r >= 0) ran++;
+				if (r != 0) bad++;
+			}
+			printf("%-8s %-24s %6d %6d\n", backend, qc->name, ran, bad);
+			total_bad += bad;
+		}
+	}
+	nn_qvec_set_backend(NULL);
+	if (nbackends == 0) printf("no SIMD backends to check\n");
+	return total_bad != 0;
+}